@@ -50,6 +50,32 @@ sNAR CAligner::m_NARdesc[] = {{eNARUnaligned,(char *)"NA",(char *)"Not processed
 	{eNARPEUnalign,(char *)"NP",(char *)"PE alignment not accepted"},
 {eNARLociConstrained,(char *)"LC",(char *)"Alignment violated loci base constraints"}};
 
+CSfxArrayV3 *CAligner::m_pResidentSfx = NULL;
+char CAligner::m_szResidentSfxFile[_MAX_PATH] = "";
+bool CAligner::m_bResidentBisulfite = false;
+bool CAligner::m_bResidentSOLiD = false;
+int CAligner::m_ResidentMaxThreads = 0;
+
+// full path of a suffix array file so that server and job specified files can be compared
+static void
+SfxFullPath(char *pszSfxFile,char *pszFullPath)
+{
+#ifdef _WIN32
+if(_fullpath(pszFullPath,pszSfxFile,_MAX_PATH) == NULL)
+	{
+	strncpy(pszFullPath,pszSfxFile,_MAX_PATH);
+	pszFullPath[_MAX_PATH-1] = '\0';
+	}
+#else
+char szResolved[PATH_MAX];
+if(realpath(pszSfxFile,szResolved) == NULL)
+	strncpy(pszFullPath,pszSfxFile,_MAX_PATH);
+else
+	strncpy(pszFullPath,szResolved,_MAX_PATH);
+pszFullPath[_MAX_PATH-1] = '\0';
+#endif
+}
+
 CAligner::CAligner(void)
 {
 Init();
@@ -61,6 +87,23 @@ CAligner::~CAligner(void)
 Reset(false);
 }
 
+void
+CAligner::SetResidentSfx(CSfxArrayV3 *pSfxArray,	// align server loaded this suffix array which subsequent Align() calls will use instead of loading their own
+				char *pszSfxFile,				// if Align() requests this suffix array file (compared as full paths)
+				bool bBisulfite,				// loaded for bisulfite processing
+				bool bSOLiD,					// loaded for colorspace processing
+				int MaxThreads)					// limit each Align() to at most this many threads (0 if no limit)
+{
+m_pResidentSfx = pSfxArray;
+if(pSfxArray != NULL && pszSfxFile != NULL)
+	SfxFullPath(pszSfxFile,m_szResidentSfxFile);
+else
+	m_szResidentSfxFile[0] = '\0';
+m_bResidentBisulfite = bBisulfite;
+m_bResidentSOLiD = bSOLiD;
+m_ResidentMaxThreads = MaxThreads;
+}
+
 
 int
 CAligner::Align(etPMode PMode,			// processing mode
@@ -115,6 +158,8 @@ CAligner::Align(etPMode PMode,			// processing mode
 		char *pszMarkerFile,			// Output markers to this file
 		char *pszSNPCentroidFile,		// Output SNP centroids (CSV format) to this file (default is for no centroid processing)
 		char *pszSfxFile,				// target as suffix array
+		etSfxLoadMode SfxLoadMode,		// how the suffix array is to be loaded, private copy or memory mapped shared with other processes
+		UINT32 StreamBatchReads,		// if > 0 then SE reads are streamed through in batches of this many reads with alignments written out as each block completes
 		char *pszStatsFile,				// aligner induced substitutions stats file
 		char *pszMultiAlignFile,		// file to contain reads which are aligned to multiple locations
 		char *pszNoneAlignFile,			// file to contain reads which were non-alignable
@@ -198,6 +243,11 @@ m_FMode = FMode;
 m_SAMFormat = SAMFormat;
 m_PEproc = PEproc;
 m_QMethod = Quality;
+if(m_ResidentMaxThreads > 0 && NumThreads > m_ResidentMaxThreads)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Align server thread budget limits this job to %d threads",m_ResidentMaxThreads);
+	NumThreads = m_ResidentMaxThreads;
+	}
 m_NumThreads = NumThreads;
 m_bBisulfite = bBisulfite;
 m_MaxMLmatches = MaxMLmatches;
@@ -240,6 +290,28 @@ m_NumExcludeChroms = NumExcludeChroms;
 
 m_MaxRptSAMSeqsThres = MaxRptSAMSeqsThres;
 
+// streaming reads through in batches is only possible if each read's alignment can be written out as soon as that read has been aligned
+// so no PE processing, no multiloci clustering, no PCR dedupe, no orphan removal or filtering, and no reporting requiring all reads 
+m_StreamBatchReads = 0;
+if(StreamBatchReads > 0)
+	{
+	if(PEproc == ePEdefault && MLMode <= eMLrand && PCRartefactWinLen < 0 && microInDelLen == 0 && SpliceJunctLen == 0 &&
+		MinFlankExacts == 0 && PCRPrimerCorrect == 0 && !m_bReportChimerics && FMode == eFMsam && SAMFormat == etSAMFformat &&
+		NumIncludeChroms == 0 && NumExcludeChroms == 0 && (MinSNPreads == 0 || pszSNPFile == NULL || pszSNPFile[0] == '\0') &&
+		(pszPriorityRegionFile == NULL || pszPriorityRegionFile[0] == '\0') &&
+		(pszLociConstraintsFile == NULL || pszLociConstraintsFile[0] == '\0') &&
+		(pszStatsFile == NULL || pszStatsFile[0] == '\0') &&
+		(pszMultiAlignFile == NULL || pszMultiAlignFile[0] == '\0') &&
+		(pszNoneAlignFile == NULL || pszNoneAlignFile[0] == '\0') &&
+		(pszSitePrefsFile == NULL || pszSitePrefsFile[0] == '\0'))
+		{
+		m_StreamBatchReads = StreamBatchReads;
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streaming SE reads through in batches of %u reads, alignments will be written out unsorted as reads are aligned",m_StreamBatchReads);
+		}
+	else
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Streaming of reads requested but only supported for SE alignments to SAM with no post-alignment processing, all reads will be loaded");
+	}
+
 if(CreateMutexes()!=eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Failed to create thread synchronisation mutexes");
@@ -248,6 +320,8 @@ if(CreateMutexes()!=eBSFSuccess)
 	}
 
 m_mtqsort.SetMaxThreads(NumThreads);
+m_mtRadixSort.SetMaxThreads(NumThreads);
+m_WorkPool.SetMaxWorkers(NumThreads);
 
 // load contaminants if user has specified a contaminant sequence file
 if(pszContamFile != NULL && pszContamFile[0] != '\0')
@@ -299,15 +373,30 @@ if(pszPriorityRegionFile != NULL && pszPriorityRegionFile[0] != '\0')
 	}
 
 
+// if running under the align server and it holds the requested suffix array resident then use it, otherwise
 // open bioseq file containing suffix array for targeted assembly to align reads against
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loading suffix array file '%s'", pszSfxFile);
-if((m_pSfxArray = new CSfxArrayV3()) == NULL)
+char szSfxFullPath[_MAX_PATH];
+if(m_pResidentSfx != NULL)
+	SfxFullPath(pszSfxFile,szSfxFullPath);
+if(m_pResidentSfx != NULL && !strcmp(szSfxFullPath,m_szResidentSfxFile) &&
+	bBisulfite == m_bResidentBisulfite && bSOLiD == m_bResidentSOLiD)
 	{
-	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to instantiate CSfxArrayV3");
-	Reset(false);
-	return(eBSFerrObj);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Using align server resident suffix array file '%s'", m_szResidentSfxFile);
+	m_pSfxArray = m_pResidentSfx;
+	m_bResidentSfx = true;
 	}
-if((Rslt=m_pSfxArray->Open(pszSfxFile,false,bBisulfite,bSOLiD))!=eBSFSuccess)
+else
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loading suffix array file '%s'", pszSfxFile);
+	if((m_pSfxArray = new CSfxArrayV3()) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to instantiate CSfxArrayV3");
+		Reset(false);
+		return(eBSFerrObj);
+		}
+	m_bResidentSfx = false;
+	}
+if(!m_bResidentSfx && (Rslt=m_pSfxArray->Open(pszSfxFile,false,bBisulfite,bSOLiD,SfxLoadMode))!=eBSFSuccess)
 	{
 	while(m_pSfxArray->NumErrMsgs())
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,m_pSfxArray->GetErrMsg());
@@ -324,6 +413,9 @@ m_pSfxArray->GetSfxHeader(&SfxHeader);
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Genome Assembly Name: '%s' Descr: '%s' Title: '%s' Version: %d",
 					 m_szTargSpecies,SfxHeader.szDescription,SfxHeader.szTitle,SfxHeader.Version);
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Assembly has blocks: %d, max block size: %llu",SfxHeader.NumSfxBlocks,SfxHeader.SfxBlockSize);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Probe vs target compare kernels: %s, mismatch scan accelerator: %s",CSfxArrayV3::GetCmpKernelName(),m_pSfxArray->IsMMScanAccel() ? "loaded" : "none");
+if(m_pSfxArray->GetSfxSampleRate() > 1)
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"Suffix array retains only every %d loci, cores are located at every sample phase but microInDel and splice junction discovery will have reduced sensitivity",m_pSfxArray->GetSfxSampleRate());
 
 // if user has specified that there are constraints on loci bases then need to load the loci constraints file
 if(pszLociConstraintsFile != NULL && pszLociConstraintsFile[0] != '\0')
@@ -475,6 +567,14 @@ if(Rslt < eBSFSuccess)
 	return(Rslt);
 	}
 
+// if streaming then alignments have already been written out as each block of reads was aligned
+if(m_StreamBatchReads > 0)
+	{
+	Rslt = CompleteStreamedReads();
+	Reset(Rslt >= eBSFSuccess ? true : false);
+	return(Rslt);
+	}
+
 if(m_bReportChimerics)
 	{
 	char szChimericsFile[_MAX_PATH];
@@ -808,13 +908,19 @@ m_ppReadHitsIdx = NULL;
 m_ppReadHitsIdx = NULL;
 m_pMultiHits = NULL;
 m_pMultiAll = NULL;
-m_pLociPValues = NULL;
 m_pSfxArray = NULL;
+m_bResidentSfx = false;
 m_pPriorityRegionBED = NULL;
 m_pAllocsIdentNodes = NULL;
 m_pAllocsMultiHitLoci = NULL;
 m_pAllocsMultiHitBuff = NULL;
-m_pChromSNPs = NULL;
+m_pCoredApproxPars = NULL;
+m_AllocdCoredApproxReads = 0;
+m_ppCoredApproxReads = NULL;
+m_NumSNPWorkers = 0;
+m_pSNPWorkers = NULL;
+m_AllocdSNPChroms = 0;
+m_pSNPChroms = NULL;
 m_pszLineBuff = NULL;
 m_pLenDist = NULL;
 m_pSNPCentroids = NULL;
@@ -860,8 +966,6 @@ m_AlignStrand = eALSnone;
 m_MinChimericLen = 0;
 m_microInDelLen = 0;
 m_SpliceJunctLen = 0;
-m_AllocLociPValuesMem = 0;
-m_NumLociPValues = 0;
 m_QValue = 0.0;
 m_MinSNPreads = 0;
 m_SNPNonRefPcnt = 0.0; 
@@ -872,6 +976,19 @@ m_Marker3Len = 0;
 m_MarkerPolyThres = 0;
 m_NumReadsProc = 0;
 m_NxtReadProcOfs = 0;
+m_StreamBatchReads = 0;
+m_bStreamLoadStalled = false;
+m_NumReadsRetired = 0;
+m_RetiredReadsOfs = 0;
+m_StreamBlockHead = 0;
+m_NumStreamBlocks = 0;
+m_pStreamSAMfile = NULL;
+m_pStreamBAMalign = NULL;
+m_NumStreamedAligned = 0;
+m_NumStreamCompacts = 0;
+m_StreamTotReadsLen = 0;
+m_StreamMinReadLen = -1;
+m_StreamMaxReadLen = 0;
 m_ElimPlusTrimed = 0;
 m_ElimMinusTrimed = 0;
 m_PEproc = ePEdefault;
@@ -896,7 +1013,6 @@ m_MinReadsLen = 0;
 m_AvReadsLen = 0;
 m_NARAccepted = 0;
 m_TermBackgoundThreads = 0;
-m_CurClusterFrom = 0;
 m_bFiltPriorityRegions = false;
 m_SAMFormat = etSAMFformat;
 m_CurReadsSortMode = eRSMunsorted;
@@ -916,6 +1032,7 @@ void
 CAligner::Reset(bool bSync)			// if bSync true then fsync before closing output file handles
 {
 m_TermBackgoundThreads = 0x01;	// need to require any background threads to self-terminate
+m_WorkPool.Stop();
 if(m_hInFile != -1)
 	{
 	close(m_hInFile);
@@ -1157,6 +1274,18 @@ if(m_pAllocsMultiHitBuff != NULL)
 	m_pAllocsMultiHitBuff = NULL;
 	}
 
+if(m_ppCoredApproxReads != NULL)
+	{
+	delete m_ppCoredApproxReads;
+	m_ppCoredApproxReads = NULL;
+	}
+m_AllocdCoredApproxReads = 0;
+if(m_pCoredApproxPars != NULL)
+	{
+	delete m_pCoredApproxPars;
+	m_pCoredApproxPars = NULL;
+	}
+
 if(m_pAllocsMultiHitLoci != NULL)
 	{
 	delete m_pAllocsMultiHitLoci;
@@ -1164,9 +1293,11 @@ if(m_pAllocsMultiHitLoci != NULL)
 	}
 if(m_pSfxArray != NULL)
 	{
-	delete m_pSfxArray;
+	if(!m_bResidentSfx)
+		delete m_pSfxArray;
 	m_pSfxArray = NULL;
 	}
+m_bResidentSfx = false;
 if(m_pPriorityRegionBED != NULL)
 	{
 	delete m_pPriorityRegionBED;
@@ -1211,22 +1342,7 @@ if(m_pMultiHits != NULL)
 	m_pMultiHits = NULL;
 	}
 
-if(m_pLociPValues != NULL)
-	{
-#ifdef _WIN32
-	free(m_pLociPValues);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
-#else
-	if(m_pLociPValues != MAP_FAILED)
-		munmap(m_pLociPValues,m_AllocLociPValuesMem);
-#endif
-	m_pLociPValues = NULL;
-	}
-
-if(m_pChromSNPs != NULL)
-	{
-	delete m_pChromSNPs;
-	m_pChromSNPs = NULL;
-	}
+FreeSNPsMem();
 
 if(m_pLenDist != NULL)
 	{
@@ -1240,6 +1356,18 @@ if(m_pContaminants != NULL)
 	m_pContaminants = NULL;
 	}
 
+if(m_pStreamSAMfile != NULL)
+	{
+	delete m_pStreamSAMfile;
+	m_pStreamSAMfile = NULL;
+	}
+
+if(m_pStreamBAMalign != NULL)
+	{
+	delete m_pStreamBAMalign;
+	m_pStreamBAMalign = NULL;
+	}
+
 DeleteMutexes();
 
 Init();
@@ -4729,6 +4857,10 @@ if(m_pszPEInsertDistFile != NULL && m_pszPEInsertDistFile[0] != '\0')
 else
 	m_hInsertLensFile = -1;
 
+// if streaming reads then SAM file needs to be created now as alignments will be written out whilst reads are still being aligned
+if(m_StreamBatchReads > 0)
+	return(CreateStreamSAMfile());
+
 return(eBSFSuccess);
 }
 
@@ -4861,108 +4993,26 @@ return(eBSFSuccess);
 }
 
 
-#ifdef _WIN32
-unsigned __stdcall AssignMultiMatchesThread(void * pThreadPars)
-#else
-void *AssignMultiMatchesThread(void * pThreadPars)
-#endif
-{
-int Rslt;
-tsClusterThreadPars *pPars = (tsClusterThreadPars *)pThreadPars; // makes it easier not having to deal with casts!
-CAligner *pThis = (CAligner *)pPars->pThis;
-Rslt = pThis->ProcAssignMultiMatches(pPars);
-pPars->Rslt = Rslt;
-#ifdef _WIN32
-_endthreadex(0);
-return(eBSFSuccess);
-#else
-pthread_exit(NULL);
-#endif
-}
-
+// AssignMultiMatchesTask
+// Work pool function clustering multihits [From,Until) in m_pMultiHits[]
 int
-CAligner::RunClusteringThreads(int NumThreads)
+CAligner::AssignMultiMatchesTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until)
 {
-int ThreadIdx;
-UINT32 ClusterStartIdx;
-tsClusterThreadPars ClusterThreads[cMaxWorkerThreads];
-
-ClusterStartIdx = 0;
-memset(ClusterThreads,0,sizeof(ClusterThreads));
-for(ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++)
-	{
-	ClusterThreads[ThreadIdx].ThreadIdx = ThreadIdx + 1;
-	ClusterThreads[ThreadIdx].pThis = this;
-#ifdef _WIN32
-	ClusterThreads[ThreadIdx].threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,AssignMultiMatchesThread,&ClusterThreads[ThreadIdx],0,&ClusterThreads[ThreadIdx].threadID);
-#else
-	ClusterThreads[ThreadIdx].threadRslt =	pthread_create (&ClusterThreads[ThreadIdx].threadID , NULL , AssignMultiMatchesThread , &ClusterThreads[ThreadIdx] );
-#endif
-	}
-
-for(ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++)
-	{
-#ifdef _WIN32
-	while(WAIT_TIMEOUT == WaitForSingleObject( ClusterThreads[ThreadIdx].threadHandle, 60000))
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Progress: Still clustering ...");
-		}
-	CloseHandle( ClusterThreads[ThreadIdx].threadHandle);
-#else
-	struct timespec ts;
-	int JoinRlt;
-	clock_gettime(CLOCK_REALTIME, &ts);
-	ts.tv_sec += 60;
-	while((JoinRlt = pthread_timedjoin_np(ClusterThreads[ThreadIdx].threadID, NULL, &ts)) != 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Progress: Still clustering ...");
-		ts.tv_sec += 60;
-		}
-#endif
-	}
-return(eBSFSuccess);
+return(((CAligner *)pCtx)->ProcAssignMultiMatches((UINT32)From,(UINT32)Until));
 }
 
-// GetClusterStartEnd
-// Clustering threads call this function to obtain the next from, until inclusive indexes into m_pMultiHits[] to be clustered
-// Returns number of
-int												// returns 0 if finished clustering or cnt of multihits to be processed by this thread
-CAligner::GetClusterStartEnd(UINT32 *pMatchFrom,			// cluster from this inclusive index
-					UINT32 *pMatchUntil)		// until this inclusive index
+// AssignMultiMatchesProgress
+// Work pool progress whilst clustering multihits
+void
+CAligner::AssignMultiMatchesProgress(void *pCtx,INT64 NumItemsDone,INT64 NumItems)
 {
-int Rslt;
-UINT32 NumLeft2Cluster;
-UINT32 Num4Thread;
-AcquireSerialise();
-NumLeft2Cluster = m_NumMultiHits - m_CurClusterFrom;
-if(NumLeft2Cluster > 0)
-	{
-	if(NumLeft2Cluster < 100)	// if < 100 yet to be processed then give it all to the one thread
-		Num4Thread = NumLeft2Cluster;
-	else
-		{
-		Num4Thread = min(2000,m_NumThreads + (NumLeft2Cluster / (UINT32)m_NumThreads));
-		Num4Thread = min(Num4Thread,NumLeft2Cluster);
-		}
-
-	*pMatchFrom = m_CurClusterFrom;
-	*pMatchUntil = m_CurClusterFrom + Num4Thread - 1;
-	m_CurClusterFrom = min(1 + *pMatchUntil,m_NumMultiHits);
-	Rslt = Num4Thread;
-	}
-else
-	Rslt = 0;
-ReleaseSerialise();
-return(Rslt);
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "Progress: Still clustering ...");
 }
 
-
 int
-CAligner::ProcAssignMultiMatches(tsClusterThreadPars *pPars)
+CAligner::ProcAssignMultiMatches(UINT32 MatchFrom,		// cluster multihits in m_pMultiHits[] from this inclusive index
+						UINT32 MatchUntil)		// until this exclusive index
 {
-int Rslt;
-UINT32 MatchFrom;
-UINT32 MatchUntil;
 UINT32 HitIdx;
 UINT32 Score;
 UINT32 ClustHitIdx;
@@ -4972,134 +5022,125 @@ tsReadHit *pPrevProcCurHit;
 int Overlap;
 UINT32 ClustEndLoci;
 
-while((Rslt = GetClusterStartEnd(&MatchFrom,&MatchUntil)) > 0)
+pCurHit = &m_pMultiHits[MatchFrom];
+pPrevProcCurHit = NULL;
+for(HitIdx=MatchFrom;HitIdx < MatchUntil; HitIdx++,pCurHit++)
 	{
-	pCurHit = &m_pMultiHits[MatchFrom];
-	pPrevProcCurHit = NULL;
-	for(HitIdx=MatchFrom;HitIdx <= MatchUntil; HitIdx++,pCurHit++)
-		{
-		if(!pCurHit->HitLoci.FlagMH)			// only interested in assigning reads which align to multiple hit loci
-			continue;							// reads which map to a single hit loci do not require processing
+	if(!pCurHit->HitLoci.FlagMH)			// only interested in assigning reads which align to multiple hit loci
+		continue;							// reads which map to a single hit loci do not require processing
 
-		if(pPrevProcCurHit != NULL &&
-					AdjStartLoci(&pPrevProcCurHit->HitLoci.Hit.Seg[0]) == AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]) &&
-					AdjHitLen(&pPrevProcCurHit->HitLoci.Hit.Seg[0]) == AdjHitLen(&pCurHit->HitLoci.Hit.Seg[0]) &&
-					pPrevProcCurHit->HitLoci.Hit.Seg[0].Strand == pCurHit->HitLoci.Hit.Seg[0].Strand &&
-					pPrevProcCurHit->HitLoci.Hit.Seg[0].ChromID == pCurHit->HitLoci.Hit.Seg[0].ChromID)
-			{
-			pCurHit->HitLoci.Hit.Score = pPrevProcCurHit->HitLoci.Hit.Score;
-			continue;
-			}
+	if(pPrevProcCurHit != NULL &&
+				AdjStartLoci(&pPrevProcCurHit->HitLoci.Hit.Seg[0]) == AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]) &&
+				AdjHitLen(&pPrevProcCurHit->HitLoci.Hit.Seg[0]) == AdjHitLen(&pCurHit->HitLoci.Hit.Seg[0]) &&
+				pPrevProcCurHit->HitLoci.Hit.Seg[0].Strand == pCurHit->HitLoci.Hit.Seg[0].Strand &&
+				pPrevProcCurHit->HitLoci.Hit.Seg[0].ChromID == pCurHit->HitLoci.Hit.Seg[0].ChromID)
+		{
+		pCurHit->HitLoci.Hit.Score = pPrevProcCurHit->HitLoci.Hit.Score;
+		continue;
+		}
 
-		pPrevProcCurHit = NULL;
-		pCurHit->HitLoci.Hit.Score = 0;
-		pClustHit = pCurHit;
-		ClustHitIdx = HitIdx;
-		while(ClustHitIdx-- > 0)				// checking for clustering upstream of current hit loci
-			{
-			pClustHit -= 1;
+	pPrevProcCurHit = NULL;
+	pCurHit->HitLoci.Hit.Score = 0;
+	pClustHit = pCurHit;
+	ClustHitIdx = HitIdx;
+	while(ClustHitIdx-- > 0)				// checking for clustering upstream of current hit loci
+		{
+		pClustHit -= 1;
 
-			// can't cluster with reads on a different chrom!
-			if(pClustHit->HitLoci.Hit.Seg[0].ChromID != pCurHit->HitLoci.Hit.Seg[0].ChromID)
-				break;
+		// can't cluster with reads on a different chrom!
+		if(pClustHit->HitLoci.Hit.Seg[0].ChromID != pCurHit->HitLoci.Hit.Seg[0].ChromID)
+			break;
 
-			// can't cluster if much too far away
-			if((AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]) - AdjStartLoci(&pClustHit->HitLoci.Hit.Seg[0])) >= (int)m_MaxReadsLen)
-				break;
-			// only cluster if >= cClustMultiOverLap
-			ClustEndLoci = AdjEndLoci(&pClustHit->HitLoci.Hit.Seg[0]);
-			if((int)ClustEndLoci < (AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]) + cClustMultiOverLap))
-				continue;
-			Overlap = min(AdjHitLen(&pCurHit->HitLoci.Hit.Seg[0]),(int)ClustEndLoci - AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]));
+		// can't cluster if much too far away
+		if((AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]) - AdjStartLoci(&pClustHit->HitLoci.Hit.Seg[0])) >= (int)m_MaxReadsLen)
+			break;
+		// only cluster if >= cClustMultiOverLap
+		ClustEndLoci = AdjEndLoci(&pClustHit->HitLoci.Hit.Seg[0]);
+		if((int)ClustEndLoci < (AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]) + cClustMultiOverLap))
+			continue;
+		Overlap = min(AdjHitLen(&pCurHit->HitLoci.Hit.Seg[0]),(int)ClustEndLoci - AdjStartLoci(&pCurHit->HitLoci.Hit.Seg[0]));
 
-			if((m_MLMode == eMLuniq && pClustHit->HitLoci.FlagMH) ||
-				(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg && (pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg) >= 0x01fff))
-				continue;
+		if((m_MLMode == eMLuniq && pClustHit->HitLoci.FlagMH) ||
+			(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg && (pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg) >= 0x01fff))
+			continue;
 
-			if(pClustHit->HitLoci.Hit.Seg[0].Strand == pCurHit->HitLoci.Hit.Seg[0].Strand && pClustHit->ReadID != pCurHit->ReadID)
+		if(pClustHit->HitLoci.Hit.Seg[0].Strand == pCurHit->HitLoci.Hit.Seg[0].Strand && pClustHit->ReadID != pCurHit->ReadID)
+			{
+			if(!pClustHit->HitLoci.FlagMH)	// clustering to a unique aligned reads has much higher priority than to other multialigned reads
+				{
+				Score = 1 + (Overlap * cClustUniqueScore)/cClustScaleFact;
+				if(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg)
+					Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
+				if(Score > 0x01fff)			// clamp upstream scores to be no more than 0x01fff so still room for dnstream scores
+					Score = 0x01fff;
+				pCurHit->HitLoci.Hit.Score = (UINT16)(Score | cUniqueClustFlg);	// flag that this score is because now clustering to uniquely aligned reads
+				if(Score == 0x01fff)
+					break;					// this is a good candidate loci
+				}
+			else							// never seen a uniquely aligned so still clustering to other non-unique aligned reads
 				{
-				if(!pClustHit->HitLoci.FlagMH)	// clustering to a unique aligned reads has much higher priority than to other multialigned reads
+				if(!(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg))
 					{
-					Score = 1 + (Overlap * cClustUniqueScore)/cClustScaleFact;
-					if(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg)
-						Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
+					Score = 1 + (Overlap * cClustMultiScore)/cClustScaleFact;
+					Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
 					if(Score > 0x01fff)			// clamp upstream scores to be no more than 0x01fff so still room for dnstream scores
 						Score = 0x01fff;
-					pCurHit->HitLoci.Hit.Score = (UINT16)(Score | cUniqueClustFlg);	// flag that this score is because now clustering to uniquely aligned reads
-					if(Score == 0x01fff)
-						break;					// this is a good candidate loci
-					}
-				else							// never seen a uniquely aligned so still clustering to other non-unique aligned reads
-					{
-					if(!(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg))
-						{
-						Score = 1 + (Overlap * cClustMultiScore)/cClustScaleFact;
-						Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
-						if(Score > 0x01fff)			// clamp upstream scores to be no more than 0x01fff so still room for dnstream scores
-							Score = 0x01fff;
-						pCurHit->HitLoci.Hit.Score = Score;
-						}
+					pCurHit->HitLoci.Hit.Score = Score;
 					}
 				}
 			}
+		}
 
-		// now cluster downstream
-		pClustHit = pCurHit;
-		ClustHitIdx = HitIdx;
-		while(++ClustHitIdx < m_NumMultiHits)				// checking for clustering downstream of current hit loci
-			{
-			pClustHit += 1;
-			// can't cluster with reads on a different chrom!
-			if(pClustHit->HitLoci.Hit.Seg[0].ChromID != pCurHit->HitLoci.Hit.Seg[0].ChromID)
-				break;
+	// now cluster downstream
+	pClustHit = pCurHit;
+	ClustHitIdx = HitIdx;
+	while(++ClustHitIdx < m_NumMultiHits)				// checking for clustering downstream of current hit loci
+		{
+		pClustHit += 1;
+		// can't cluster with reads on a different chrom!
+		if(pClustHit->HitLoci.Hit.Seg[0].ChromID != pCurHit->HitLoci.Hit.Seg[0].ChromID)
+			break;
 
-			// can't score if no overlap of at least cClustMultiOverLap
-			ClustEndLoci = AdjEndLoci(&pCurHit->HitLoci.Hit.Seg[0]);
-			if(AdjStartLoci(&pClustHit->HitLoci.Hit.Seg[0]) > (ClustEndLoci - (UINT32)cClustMultiOverLap))
-				break;
+		// can't score if no overlap of at least cClustMultiOverLap
+		ClustEndLoci = AdjEndLoci(&pCurHit->HitLoci.Hit.Seg[0]);
+		if(AdjStartLoci(&pClustHit->HitLoci.Hit.Seg[0]) > (ClustEndLoci - (UINT32)cClustMultiOverLap))
+			break;
 
-			Overlap = min(AdjHitLen(&pClustHit->HitLoci.Hit.Seg[0]),(int)ClustEndLoci - AdjStartLoci(&pClustHit->HitLoci.Hit.Seg[0]));
+		Overlap = min(AdjHitLen(&pClustHit->HitLoci.Hit.Seg[0]),(int)ClustEndLoci - AdjStartLoci(&pClustHit->HitLoci.Hit.Seg[0]));
 
-			if((m_MLMode == eMLuniq && pClustHit->HitLoci.FlagMH) ||
-				(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg && (pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg) >= 0x03fff))
-				continue;
+		if((m_MLMode == eMLuniq && pClustHit->HitLoci.FlagMH) ||
+			(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg && (pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg) >= 0x03fff))
+			continue;
 
-			if(pClustHit->HitLoci.Hit.Seg[0].Strand == pCurHit->HitLoci.Hit.Seg[0].Strand && pClustHit->ReadID != pCurHit->ReadID)
+		if(pClustHit->HitLoci.Hit.Seg[0].Strand == pCurHit->HitLoci.Hit.Seg[0].Strand && pClustHit->ReadID != pCurHit->ReadID)
+			{
+			if(!pClustHit->HitLoci.FlagMH)	// clustering to a unique aligned reads has much higher priority than to other multialigned reads
+				{
+				Score = 1 + (Overlap * cClustUniqueScore)/cClustScaleFact;
+				if(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg)
+					Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
+				if(Score > 0x3fff)
+					Score = 0x3fff;
+				pCurHit->HitLoci.Hit.Score = (UINT16)(Score | cUniqueClustFlg);
+				if(Score == 0x3fff)
+					break;
+				}
+			else
 				{
-				if(!pClustHit->HitLoci.FlagMH)	// clustering to a unique aligned reads has much higher priority than to other multialigned reads
+				if(!(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg))
 					{
-					Score = 1 + (Overlap * cClustUniqueScore)/cClustScaleFact;
-					if(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg)
-						Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
+					Score = 1 + (Overlap * cClustMultiScore)/cClustScaleFact;
+					Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
 					if(Score > 0x3fff)
 						Score = 0x3fff;
-					pCurHit->HitLoci.Hit.Score = (UINT16)(Score | cUniqueClustFlg);
-					if(Score == 0x3fff)
-						break;
-					}
-				else
-					{
-					if(!(pCurHit->HitLoci.Hit.Score & cUniqueClustFlg))
-						{
-						Score = 1 + (Overlap * cClustMultiScore)/cClustScaleFact;
-						Score += pCurHit->HitLoci.Hit.Score & ~cUniqueClustFlg;
-						if(Score > 0x3fff)
-							Score = 0x3fff;
-						pCurHit->HitLoci.Hit.Score = (UINT16)Score;
-						}
+					pCurHit->HitLoci.Hit.Score = (UINT16)Score;
 					}
 				}
 			}
-		pPrevProcCurHit = pCurHit;
 		}
+	pPrevProcCurHit = pCurHit;
 	}
-pPars->Rslt = 1;
-#ifdef _WIN32
-_endthreadex(0);
 return(eBSFSuccess);
-#else
-pthread_exit(NULL);
-#endif
 }
 
 // AssignMultiMatches
@@ -5128,7 +5169,7 @@ SortReadHits(eRSMReadID,false);
 m_mtqsort.qsort(m_pMultiHits,m_NumMultiHits,sizeof(tsReadHit),SortMultiHits);
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Sorting completed, now clustering...");
 
-RunClusteringThreads(m_NumThreads);
+m_WorkPool.Run(AssignMultiMatchesTask,this,m_NumMultiHits,cClusterMultiHitsGrain,60,AssignMultiMatchesProgress);
 
 // sort now by ascending ReadID and descending scores
 // and assign the read match with the highest score to that read
@@ -5583,7 +5624,7 @@ switch(SAMFormat) {
 		break;
 	}
 
-if((Rslt = pSAMfile->Create(FileType,m_pszOutFile,ComprLev,(char *)cpszProgVer)) < eBSFSuccess)
+if((Rslt = pSAMfile->Create(FileType,m_pszOutFile,ComprLev,(char *)cpszProgVer,true,m_NumThreads)) < eBSFSuccess)
 	{
 	delete pSAMfile;
 	return(Rslt);
@@ -5724,6 +5765,148 @@ gDiagnostics.DiagOut(eDLInfo,gszProcName,"Completed reporting %s %u read alignme
 return(0);
 }
 
+// Create SAM file into which streamed alignments will be written as blocks of reads are aligned
+// Which target sequences will be aligned to is unknown when the header is written so all are referenced, and
+// as alignments are written in read order the header is flagged as unsorted
+int
+CAligner::CreateStreamSAMfile(void)
+{
+int Rslt;
+int ChromID;
+int NumChroms;
+char szChromName[128];
+
+if((m_pStreamSAMfile = new CSAMfile) == NULL || (m_pStreamBAMalign = new tsBAMalign) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"CreateStreamSAMfile: Unable to instantiate class CSAMfile");
+	return(eBSFerrObj);
+	}
+
+if((Rslt = m_pStreamSAMfile->Create(m_bgzOutFile ? eSFTSAMgz : eSFTSAM,m_pszOutFile,cDfltComprLev,(char *)cpszProgVer,false)) < eBSFSuccess)
+	return(Rslt);
+
+NumChroms = m_pSfxArray->GetNumEntries();
+for(ChromID = 1; ChromID <= NumChroms; ChromID++)
+	{
+	m_pSfxArray->GetIdentName(ChromID,sizeof(szChromName),szChromName);
+	if((Rslt = m_pStreamSAMfile->AddRefSeq(m_szTargSpecies,szChromName,m_pSfxArray->GetSeqLen(ChromID))) < 1)
+		return(Rslt < 0 ? Rslt : eBSFerrInternal);
+	}
+m_pStreamSAMfile->StartAlignments();
+m_PrevSAMTargEntry = 0;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streamed SAM header written with references to %d sequences",NumChroms);
+return(eBSFSuccess);
+}
+
+// RetireStreamedReads
+// Flags block of reads as having been aligned, then writes out alignments for all leading blocks which have been aligned
+// Blocks are written out strictly in the order in which they were handed out so alignments are in the same order as the reads were loaded
+// Caller must have serialised through AcquireSerialise()
+int
+CAligner::RetireStreamedReads(int StreamBlkIdx)
+{
+int Rslt;
+UINT32 ReadIdx;
+tsStreamBlock *pBlock;
+tsReadHit *pReadHit;
+
+m_StreamBlocks[StreamBlkIdx].bDone = true;
+while(m_NumStreamBlocks > 0 && m_StreamBlocks[m_StreamBlockHead].bDone)
+	{
+	pBlock = &m_StreamBlocks[m_StreamBlockHead];
+	pReadHit = (tsReadHit *)((UINT8 *)m_pReadHits + pBlock->StartOfs);
+	for(ReadIdx = 0; ReadIdx < pBlock->NumReads; ReadIdx++)
+		{
+		m_StreamTotReadsLen += pReadHit->ReadLen;
+		if(m_StreamMinReadLen > pReadHit->ReadLen || m_StreamMinReadLen == -1)
+			m_StreamMinReadLen = pReadHit->ReadLen;
+		if(m_StreamMaxReadLen < pReadHit->ReadLen)
+			m_StreamMaxReadLen = pReadHit->ReadLen;
+
+		if(pReadHit->NAR == eNARAccepted)
+			{
+			if(pReadHit->HitLoci.Hit.Seg[0].ChromID != (UINT32)m_PrevSAMTargEntry)
+				{
+				m_pSfxArray->GetIdentName(pReadHit->HitLoci.Hit.Seg[0].ChromID,sizeof(m_szSAMTargChromName),m_szSAMTargChromName);
+				m_PrevSAMTargEntry = pReadHit->HitLoci.Hit.Seg[0].ChromID;
+				}
+			if((Rslt = ReportBAMread(pReadHit,0,0,m_pStreamBAMalign)) < eBSFSuccess)
+				{
+				m_ThreadCoredApproxRslt = Rslt;
+				return(Rslt);
+				}
+			strcpy(m_pStreamBAMalign->szRefSeqName,m_szSAMTargChromName);
+			if((Rslt = m_pStreamSAMfile->AddAlignment(m_pStreamBAMalign)) < eBSFSuccess)
+				{
+				m_ThreadCoredApproxRslt = Rslt;
+				return(Rslt);
+				}
+			m_NumStreamedAligned += 1;
+			}
+		pReadHit = (tsReadHit *)((UINT8 *)pReadHit + sizeof(tsReadHit) + pReadHit->ReadLen + pReadHit->DescrLen);
+		}
+	m_NumReadsRetired += pBlock->NumReads;
+	m_RetiredReadsOfs = (size_t)((UINT8 *)pReadHit - (UINT8 *)m_pReadHits);
+	m_StreamBlockHead = (m_StreamBlockHead + 1) % cMaxStreamBlocks;
+	m_NumStreamBlocks -= 1;
+	}
+return(m_pStreamSAMfile->Flush());
+}
+
+// CompactStreamedReads
+// Moves reads not yet written out down to the start of m_pReadHits so the memory which was holding reads already written out can be reused
+// Caller must have serialised through AcquireSerialise() and also hold an exclusive lock through AcquireLock(true)
+void
+CAligner::CompactStreamedReads(void)
+{
+size_t ShiftOfs;
+int BlkIdx;
+int Idx;
+
+if((ShiftOfs = m_RetiredReadsOfs) == 0)
+	return;
+memmove(m_pReadHits,(UINT8 *)m_pReadHits + ShiftOfs,m_DataBuffOfs - ShiftOfs);
+m_DataBuffOfs -= ShiftOfs;
+m_NxtReadProcOfs -= ShiftOfs;
+for(Idx = 0, BlkIdx = m_StreamBlockHead; Idx < m_NumStreamBlocks; Idx++, BlkIdx = (BlkIdx + 1) % cMaxStreamBlocks)
+	m_StreamBlocks[BlkIdx].StartOfs -= ShiftOfs;
+m_RetiredReadsOfs = 0;
+m_NumStreamCompacts += 1;
+}
+
+// CompleteStreamedReads
+// All reads have been aligned and written out so close the SAM file and report on the streamed reads
+int
+CAligner::CompleteStreamedReads(void)
+{
+int Rslt;
+int AvReadsLen;
+
+Rslt = eBSFSuccess;
+if(m_pStreamSAMfile != NULL)
+	{
+	Rslt = m_pStreamSAMfile->Close();
+	delete m_pStreamSAMfile;
+	m_pStreamSAMfile = NULL;
+	}
+if(Rslt < eBSFSuccess)
+	return(Rslt);
+
+AvReadsLen = m_NumReadsRetired > 0 ? (int)(m_StreamTotReadsLen/m_NumReadsRetired) : 0;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Average length of all reads was: %d (min: %d, max: %d)",AvReadsLen,m_StreamMinReadLen,m_StreamMaxReadLen);
+if(gProcessingID > 0)
+	{
+	gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(AvReadsLen),"MeanLen",&AvReadsLen);
+	gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(m_StreamMinReadLen),"MinLen",&m_StreamMinReadLen);
+	gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(m_StreamMaxReadLen),"MaxLen",&m_StreamMaxReadLen);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Accepted %u aligned reads (%u uniquely, %u aligning to multiloci), %u were not aligned and %u were sloughed because of excessive Ns",
+					 m_TotAcceptedAsAligned,m_TotAcceptedAsUniqueAligned,m_TotAcceptedAsMultiAligned,m_TotNonAligned,m_NumSloughedNs);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streamed %u reads in batches of %u reads, %u SAM alignments written, memory holding written out reads was reused %u times",
+					 m_NumReadsRetired,m_StreamBatchReads,m_NumStreamedAligned,m_NumStreamCompacts);
+return(eBSFSuccess);
+}
+
 // BAM index
 // UINT8 magic[4];    // "BAI\1"
 // UINT32 n_rf;       // number of reference sequences following
@@ -6790,144 +6973,218 @@ return(NumHits);
 }
 
 
-// OutputSNPs
-// Currently can't process for SNPs in InDels or splice junctions
-// FDR: BenjaminiHochberg
-// QValue == acceptable FDR e.g. 0.05% or 0.01%
-// PValue == 1.0 - Stats.Binomial(TotBasesInColumn,NumBasesInColMismatching+1,GlobalSeqErrRate);
-// PValueIdx == sorted index of PValue and locus pairs, 1..k
-// Generate PValues for all alignment columns meeting minimum constraints into an array of structures containing column loci and associated PValues
-// Sort array of structures ascending on PValues
-// Iterate array 1 to k and accept as SNPs those elements with PValues < (PValueIdx/k) * QValue
-int
-CAligner::OutputSNPs(void)
+// ReallocSNPsMem
+// Grows memory used when identifying putative SNPs on a chromosome so as to hold at least ReqMem bytes
+// Returns ptr to the, possibly relocated, memory or NULL if unable to allocate in which case the original memory is still allocated
+void *
+CAligner::ReallocSNPsMem(void *pMem,			// currently allocated memory, NULL if none yet allocated
+						size_t *pAllocdMem,		// currently allocated size, updated with the new allocation size
+						size_t ReqMem)			// needing to hold at least this many bytes
 {
-double PValue;
-double GlobalSeqErrRate;
-double LocalSeqErrRate;
-tsSNPcnts *pSNP;
-UINT32 Loci;
-int Idx;
-int NumSNPs;
-int TotBases;
-char szChromName[cMaxDatasetSpeciesChrom+1];
-int LineLen;
-double Proportion;
-double AdjPValue;
-int RelRank;
-tsLociPValues *pLociPValues;
+void *pNewMem;
 size_t memreq;
+
+if(pMem != NULL && *pAllocdMem >= ReqMem)
+	return(pMem);
+memreq = pMem == NULL ? 0 : *pAllocdMem + (*pAllocdMem / 2);
+if(memreq < ReqMem)
+	memreq = ReqMem;
+memreq = ((memreq + cAllocChromSNPsMem - 1) / cAllocChromSNPsMem) * cAllocChromSNPsMem;
+#ifdef _WIN32
+pNewMem = realloc(pMem,memreq);
+if(pNewMem == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ReallocSNPsMem: Memory reallocation to %lld bytes failed",(INT64)memreq);
+	return(NULL);
+	}
+#else
+// gnu malloc is still in the 32bit world and can't handle more than 2GB allocations
+if(pMem == NULL)
+	pNewMem = mmap(NULL,memreq, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+else
+	pNewMem = mremap(pMem,*pAllocdMem,memreq,MREMAP_MAYMOVE);
+if(pNewMem == MAP_FAILED)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ReallocSNPsMem: Memory reallocation to %lld bytes failed - %s",(INT64)memreq,strerror(errno));
+	return(NULL);
+	}
+#endif
+*pAllocdMem = memreq;
+return(pNewMem);
+}
+
+// FreeSNPsMem
+// Free per chromosome and per worker resources used when identifying putative SNPs
+void
+CAligner::FreeSNPsMem(void)
+{
+int Idx;
+tsChromSNPs *pChromSNPs;
+tsSNPWorker *pWorker;
+
+if(m_pSNPChroms != NULL)
+	{
+	pChromSNPs = m_pSNPChroms;
+	for(Idx = 0; Idx < m_AllocdSNPChroms; Idx++,pChromSNPs++)
+		{
+		if(pChromSNPs->pWinCnts != NULL)
+			delete []pChromSNPs->pWinCnts;
+#ifdef _WIN32
+		if(pChromSNPs->pLociPValues != NULL)
+			free(pChromSNPs->pLociPValues);		// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
+		if(pChromSNPs->pMarkers != NULL)
+			free(pChromSNPs->pMarkers);
+		if(pChromSNPs->pHaplotypes != NULL)
+			free(pChromSNPs->pHaplotypes);
+#else
+		if(pChromSNPs->pLociPValues != NULL)
+			munmap(pChromSNPs->pLociPValues,pChromSNPs->AllocLociPValuesMem);
+		if(pChromSNPs->pMarkers != NULL)
+			munmap(pChromSNPs->pMarkers,pChromSNPs->AllocMarkersMem);
+		if(pChromSNPs->pHaplotypes != NULL)
+			munmap(pChromSNPs->pHaplotypes,pChromSNPs->AllocHaplotypesMem);
+#endif
+		}
+	delete []m_pSNPChroms;
+	m_pSNPChroms = NULL;
+	}
+m_AllocdSNPChroms = 0;
+
+if(m_pSNPWorkers != NULL)
+	{
+	pWorker = m_pSNPWorkers;
+	for(Idx = 0; Idx < m_NumSNPWorkers; Idx++,pWorker++)
+		{
+		if(pWorker->pReadSeq != NULL)
+			delete []pWorker->pReadSeq;
+		if(pWorker->pAssembSeq != NULL)
+			delete []pWorker->pAssembSeq;
+		if(pWorker->pCentroidInsts != NULL)
+			delete []pWorker->pCentroidInsts;
+		}
+	delete []m_pSNPWorkers;
+	m_pSNPWorkers = NULL;
+	}
+m_NumSNPWorkers = 0;
+}
+
+// ClearSNPsWin
+// Clear pileup window base cnts for all loci, not already cleared, up to UntilLoci exclusive
+void
+CAligner::ClearSNPsWin(tsChromSNPs *pChromSNPs,	// pileup window on this chromosome
+				UINT32 UntilLoci)				// clear loci up to this loci exclusive
+{
+UINT32 WinMsk;
+if(UntilLoci > pChromSNPs->ChromLen)
+	UntilLoci = pChromSNPs->ChromLen;
+WinMsk = pChromSNPs->WinLen - 1;
+while(pChromSNPs->ClearedLoci < UntilLoci)
+	{
+	memset(&pChromSNPs->pWinCnts[pChromSNPs->ClearedLoci & WinMsk],0,sizeof(tsSNPcnts));
+	pChromSNPs->ClearedLoci += 1;
+	}
+}
+
+// ScanSNPsWin
+// Scan loci, from pChromSNPs->ScanLoci up to UntilLoci exclusive, for putative SNPs
+// Caller must have accumulated base cnts from all reads which could overlap these loci or their flanks into the pileup window
+// Putative SNPs are only filtered on background noise, and PValues generated, after all loci have been scanned as the chromosome global sequencing
+// error rate is required. Markers are similarly identified by their index into pChromSNPs->pMarkers until then.
+int
+CAligner::ScanSNPsWin(tsSNPWorker *pWorker,		// worker specific resources
+				tsChromSNPs *pChromSNPs,		// scanning pileup window on this chromosome
+				UINT32 UntilLoci)				// scan loci up to this loci exclusive
+{
+tsSNPcnts *pSNP;
+UINT32 Loci;
+UINT32 WinMsk;
+UINT32 RightFlank;
+int TotBases;
+double Proportion;
+tsLociPValues *pLociPValues;
 tsSNPcnts *pSNPWinL;
 tsSNPcnts *pSNPWinR;
 UINT32 LocalBkgndRateWindow;
 UINT32 LocalBkgndRateWinFlank;
-UINT32 LocalTotMismatches;
-UINT32 LocalTotMatches;
 UINT32 LocTMM;
 UINT32 LocTM;
-CStats Stats;
-
-tsMonoSNP sMonoSNP;
-tsDiSNP sDiSNP;
-tsTriSNP sTriSNP;
-
-tsSNPcnts PrevSNPs[3]; // to hold counts for prev 2 plus currrent SNP - used when reporting Di/TriSNPs
-
-int CurDiSNPLoci;
-int PrevDiSNPLoci;
-int DiSNPBuffIdx;
-char szDiSNPs[4000];
-
-int CurTriSNPLoci;
-int PrevTriSNPLoci;
-int FirstTriSNPLoci;
-int TriSNPBuffIdx;
-char szTriSNPs[4000];
-int TotNumDiSNPs;
-int TotNumTriSNPs;
 
 UINT8 SNPFlanks[9];
 UINT8 *pSNPFlank;
 int SNPFlankIdx;
 int SNPCentroidIdx;
 UINT8 Base;
-tsSNPCentroid *pCentroid;
-
-if(m_pLociPValues == NULL)					// will be NULL first time in
-	{
-	memreq = cAllocLociPValues * sizeof(tsLociPValues);
-#ifdef _WIN32
-	m_pLociPValues = (tsLociPValues *) malloc((size_t)memreq);
-	if(m_pLociPValues == NULL)
-		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"OutputSNPs: Memory allocation of %lld bytes failed",(INT64)memreq);
-		return(eBSFerrMem);
-		}
-#else
-	// gnu malloc is still in the 32bit world and can't handle more than 2GB allocations
-	m_pLociPValues = (tsLociPValues *)mmap(NULL,(size_t)memreq, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
-	if(m_pLociPValues == MAP_FAILED)
-		{
-		m_pLociPValues = NULL;
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"OutputSNPs: Memory allocation of %lld bytes through mmap()  failed",(INT64)memreq,strerror(errno));
-		return(eBSFerrMem);
-		}
-#endif
-	m_AllocLociPValuesMem = memreq;
-	m_NumLociPValues = 0;
-	}
 
-// NOTE: set a floor on the global (whole chromosome) sequencing error rate
-GlobalSeqErrRate = max(cMinSeqErrRate,(double)m_pChromSNPs->TotMismatch / (double)(1 + m_pChromSNPs->TotMatch + m_pChromSNPs->TotMismatch));
-
-m_pSfxArray->GetIdentName(m_pChromSNPs->ChromID,sizeof(szChromName),szChromName);
+int MarkerStartLoci;
+int MarkerSeqIdx;
+int AllelicIdx;
+tsSNPcnts *pMarkerBase;
+etSeqBase MarkerSequence[2000];
+etSeqBase *pMarkerSeq;
+int TotMarkerLociBases;
+double MarkerLociBaseProportion;
+int MarkerLen;
+size_t MarkerSize;
+int NumPolymorphicSites;
+tsSNPMarker *pMarker;
+void *pMem;
+
+if(UntilLoci > pChromSNPs->ChromLen)
+	UntilLoci = pChromSNPs->ChromLen;
+if(UntilLoci <= pChromSNPs->ScanLoci)
+	return(eBSFSuccess);
 
-pSNPWinR = &m_pChromSNPs->Cnts[0];
+WinMsk = pChromSNPs->WinLen - 1;
 LocalBkgndRateWinFlank = cSNPBkgndRateWindow / 2;
 LocalBkgndRateWindow = (LocalBkgndRateWinFlank * 2) + 1;
-LocalTotMismatches = 0;
-LocalTotMatches = 0;
+RightFlank = LocalBkgndRateWindow - 1;
+if(m_hMarkerFile != -1 && m_Marker3Len > (int)RightFlank)
+	RightFlank = m_Marker3Len;
+MarkerLen = 1 + m_Marker5Len + m_Marker3Len;
+MarkerSize = sizeof(tsSNPMarker) + MarkerLen;
 
-
-for(Loci = 0; Loci < min(LocalBkgndRateWindow,m_pChromSNPs->ChromLen); Loci++,pSNPWinR++)
+if(pChromSNPs->ScanLoci == 0)		// starting scan so initialise the background window
 	{
-	LocalTotMismatches += pSNPWinR->NumNonRefBases;
-	LocalTotMatches += pSNPWinR->NumRefBases;
+	ClearSNPsWin(pChromSNPs,LocalBkgndRateWindow);
+	pChromSNPs->LocalTotMismatches = 0;
+	pChromSNPs->LocalTotMatches = 0;
+	for(Loci = 0; Loci < min(LocalBkgndRateWindow,pChromSNPs->ChromLen); Loci++)
+		{
+		pSNPWinR = &pChromSNPs->pWinCnts[Loci & WinMsk];
+		pChromSNPs->LocalTotMismatches += pSNPWinR->NumNonRefBases;
+		pChromSNPs->LocalTotMatches += pSNPWinR->NumRefBases;
+		}
 	}
 
-pLociPValues = m_pLociPValues;
-m_NumLociPValues = 0;
-pSNP = &m_pChromSNPs->Cnts[0];
-pSNPWinL = pSNP;
-LineLen = 0;
-
-
-m_MaxDiSNPSep = m_pChromSNPs->MeanReadLen;
-for(Loci = 0; Loci < m_pChromSNPs->ChromLen;Loci++, pSNP++)
+for(Loci = pChromSNPs->ScanLoci; Loci < UntilLoci; Loci++)
 	{
+	// loci beyond the last accumulated read are not covered and their cnts need to be cleared before being used for background and markers
+	ClearSNPsWin(pChromSNPs,Loci + RightFlank + 1);
+	pSNP = &pChromSNPs->pWinCnts[Loci & WinMsk];
+
 	// determine background expected error rate from window surrounding the current loci
-	if(Loci > LocalBkgndRateWinFlank && (Loci + LocalBkgndRateWinFlank) < m_pChromSNPs->ChromLen)
+	if(Loci > LocalBkgndRateWinFlank && (Loci + LocalBkgndRateWinFlank) < pChromSNPs->ChromLen)
 		{
+		pSNPWinL = &pChromSNPs->pWinCnts[(Loci - LocalBkgndRateWinFlank - 1) & WinMsk];
+		pSNPWinR = &pChromSNPs->pWinCnts[(Loci + LocalBkgndRateWinFlank) & WinMsk];
 		// need to ensure that LocalTotMismatches and LocalTotMismatches will never underflow
-		if(LocalTotMismatches >= pSNPWinL->NumNonRefBases)
-			LocalTotMismatches -= pSNPWinL->NumNonRefBases;
+		if(pChromSNPs->LocalTotMismatches >= pSNPWinL->NumNonRefBases)
+			pChromSNPs->LocalTotMismatches -= pSNPWinL->NumNonRefBases;
 		else
-			LocalTotMismatches = 0;
-		if(LocalTotMatches >= pSNPWinL->NumRefBases)
-			LocalTotMatches -= pSNPWinL->NumRefBases;
+			pChromSNPs->LocalTotMismatches = 0;
+		if(pChromSNPs->LocalTotMatches >= pSNPWinL->NumRefBases)
+			pChromSNPs->LocalTotMatches -= pSNPWinL->NumRefBases;
 		else
-			LocalTotMatches = 0;
-		LocalTotMismatches += pSNPWinR->NumNonRefBases;
-		LocalTotMatches += pSNPWinR->NumRefBases;
-		pSNPWinL += 1;
-		pSNPWinR += 1;
+			pChromSNPs->LocalTotMatches = 0;
+		pChromSNPs->LocalTotMismatches += pSNPWinR->NumNonRefBases;
+		pChromSNPs->LocalTotMatches += pSNPWinR->NumRefBases;
 		}
 
 	TotBases = pSNP->NumNonRefBases + pSNP->NumRefBases;
 	if(TotBases > 0)
 		{
-		m_LociBasesCovered += 1;
-		m_LociBasesCoverage += TotBases;
+		pChromSNPs->LociBasesCovered += 1;
+		pChromSNPs->LociBasesCoverage += TotBases;
 		}
 
 	if(TotBases < m_MinSNPreads)
@@ -6936,9 +7193,9 @@ for(Loci = 0; Loci < m_pChromSNPs->ChromLen;Loci++, pSNP++)
 	if(m_hSNPCentsfile != -1)
 		{
 		// get 4bases up/dn stream from loci with SNP and use these to inc centroid counts of from/to counts
-		if(Loci >= cSNPCentfFlankLen && Loci < (m_pChromSNPs->ChromLen - cSNPCentfFlankLen))
+		if(Loci >= cSNPCentfFlankLen && Loci < (pChromSNPs->ChromLen - cSNPCentfFlankLen))
 			{
-			m_pSfxArray->GetSeq(m_pChromSNPs->ChromID,Loci-(UINT32)cSNPCentfFlankLen,SNPFlanks,cSNPCentroidLen);
+			m_pSfxArray->GetSeq(pChromSNPs->ChromID,Loci-(UINT32)cSNPCentfFlankLen,SNPFlanks,cSNPCentroidLen);
 			pSNPFlank = &SNPFlanks[cSNPCentroidLen-1];
 			SNPCentroidIdx = 0;
 			for(SNPFlankIdx = 0; SNPFlankIdx < cSNPCentroidLen; SNPFlankIdx++,pSNPFlank--)
@@ -6949,95 +7206,47 @@ for(Loci = 0; Loci < m_pChromSNPs->ChromLen;Loci++, pSNP++)
 				SNPCentroidIdx |= (Base << (SNPFlankIdx * 2));
 				}
 			if(SNPFlankIdx == cSNPCentroidLen)
-				m_pSNPCentroids[SNPCentroidIdx].NumInsts += 1;
+				pWorker->pCentroidInsts[SNPCentroidIdx] += 1;
 			}
 		}
 
-
 	if(pSNP->NumNonRefBases < cMinSNPreads)
-		continue; 
+		continue;
 	Proportion = (double)pSNP->NumNonRefBases/TotBases;
 	if(Proportion < m_SNPNonRefPcnt)	// needs to be at least this proportion of non-ref bases to be worth exploring as being SNP
 		continue;
 
-	// needing to allocate more memory? NOTE: allowing small safety margin of 10 tsLociPValues
-	if(m_AllocLociPValuesMem  < (sizeof(tsLociPValues) * (m_NumLociPValues + 10)))
-		{
-		size_t memreq = m_AllocLociPValuesMem + (cAllocLociPValues * sizeof(tsLociPValues));
-#ifdef _WIN32
-		pLociPValues = (tsLociPValues *) realloc(m_pLociPValues,memreq);
-		if(pLociPValues == NULL)
-			{
-#else
-		pLociPValues = (tsLociPValues *)mremap(m_pLociPValues,m_AllocLociPValuesMem,memreq,MREMAP_MAYMOVE);
-		if(pLociPValues == MAP_FAILED)
-			{
-#endif
-			gDiagnostics.DiagOut(eDLFatal,gszProcName,"OutputSNPs: Memory reallocation to %lld bytes failed - %s",memreq,strerror(errno));
-			return(eBSFerrMem);
-			}
-		m_pLociPValues = pLociPValues;
-		m_AllocLociPValuesMem = memreq;
-		pLociPValues = &m_pLociPValues[m_NumLociPValues];
-		}
-
-
-
-	if(pSNP->NumNonRefBases <= LocalTotMismatches)
-		LocTMM = LocalTotMismatches - pSNP->NumNonRefBases;
+	if(pSNP->NumNonRefBases <= pChromSNPs->LocalTotMismatches)
+		LocTMM = pChromSNPs->LocalTotMismatches - pSNP->NumNonRefBases;
 	else
 		LocTMM = 0;
 
-	if(pSNP->NumRefBases < LocalTotMatches)
-		LocTM = LocalTotMatches - pSNP->NumRefBases;
+	if(pSNP->NumRefBases < pChromSNPs->LocalTotMatches)
+		LocTM = pChromSNPs->LocalTotMatches - pSNP->NumRefBases;
 	else
 		LocTM = 0;
 
-
-	if((LocTMM + LocTM) == 0)
-		LocalSeqErrRate = GlobalSeqErrRate;
-	else
-		{
-		LocalSeqErrRate = (double)LocTMM / (double)(LocTMM + LocTM);
-		if(LocalSeqErrRate < GlobalSeqErrRate)
-			LocalSeqErrRate = GlobalSeqErrRate;
-		}
-	if(LocalSeqErrRate > cMaxBkgdNoiseThres)	// don't bother attempting to call if the background is too noisy
-		continue;
-
-	// accepting as being a putative SNP
-	// if outputting as marker sequence then get SNP up/dnstream sequence and report
-	int MarkerStartLoci;
-	int MarkerSeqIdx;
-	int AllelicIdx;
-	tsSNPcnts *pMarkerBase;
-	etSeqBase MarkerSequence[2000];
-	etSeqBase *pMarkerSeq;
-	int TotMarkerLociBases;
-	double MarkerLociBaseProportion;
-	int MarkerLen;
-	int NumPolymorphicSites;
-	if(m_hMarkerFile != -1)			// output marker sequences? 
+	// if outputting as marker sequence then get SNP up/dnstream sequence
+	NumPolymorphicSites = 0;
+	if(m_hMarkerFile != -1)			// output marker sequences?
 		{
 		// ensure putative marker sequence would be completely contained within the chromosome
 		if(Loci < (UINT32)m_Marker5Len)
 			continue;
-		if((Loci + m_Marker3Len) >= m_pChromSNPs->ChromLen)
+		if((Loci + m_Marker3Len) >= pChromSNPs->ChromLen)
 			continue;
 		TotMarkerLociBases = pSNP->NumNonRefBases + pSNP->NumRefBases;
 		MarkerLociBaseProportion = (double)pSNP->NumNonRefBases/TotMarkerLociBases;
 		if(MarkerLociBaseProportion < 0.5)
 			continue;
 
-		NumPolymorphicSites = 0;
-		MarkerLen = 1 + m_Marker5Len + m_Marker3Len;
 		MarkerStartLoci = Loci - m_Marker5Len;
 		pMarkerSeq = MarkerSequence;
-		pMarkerBase = &m_pChromSNPs->Cnts[MarkerStartLoci];
 		// check there are alignments covering the complete putative marker sequence
 		// and that at any loci covered by the marker has a significant allelic base
-		for(MarkerSeqIdx = 0; MarkerSeqIdx < MarkerLen; MarkerSeqIdx++,pMarkerBase++,pMarkerSeq++)
+		for(MarkerSeqIdx = 0; MarkerSeqIdx < MarkerLen; MarkerSeqIdx++,pMarkerSeq++)
 			{
+			pMarkerBase = &pChromSNPs->pWinCnts[(MarkerStartLoci + MarkerSeqIdx) & WinMsk];
 			if((TotMarkerLociBases = pMarkerBase->NumNonRefBases + pMarkerBase->NumRefBases) < m_MinSNPreads)	// must be at least enough reads covering to have confidence in base call
 				break;
 			MarkerLociBaseProportion = (double)pMarkerBase->NumNonRefBases/TotMarkerLociBases;
@@ -7045,7 +7254,7 @@ for(Loci = 0; Loci < m_pChromSNPs->ChromLen;Loci++, pSNP++)
 				{
 				if(MarkerLociBaseProportion > 0.1)
 					NumPolymorphicSites += 1;
-				*pMarkerSeq = CSeqTrans::MapBase2Ascii(pMarkerBase->RefBase); 
+				*pMarkerSeq = CSeqTrans::MapBase2Ascii(pMarkerBase->RefBase);
 				continue;
 				}
 			// need to find a major allelic base - base must account for very high proportion of counts
@@ -7054,7 +7263,7 @@ for(Loci = 0; Loci < m_pChromSNPs->ChromLen;Loci++, pSNP++)
 					{
 					if(MarkerLociBaseProportion < 0.9)
 						NumPolymorphicSites += 1;
-					*pMarkerSeq = CSeqTrans::MapBase2Ascii(AllelicIdx); 
+					*pMarkerSeq = CSeqTrans::MapBase2Ascii(AllelicIdx);
 					break;
 					}
 			if(AllelicIdx == 5)
@@ -7070,13 +7279,638 @@ for(Loci = 0; Loci < m_pChromSNPs->ChromLen;Loci++, pSNP++)
 			continue;
 		MarkerSequence[MarkerLen] = '\0';
 
-		// accepted marker sequence
+		// accepted marker sequence, marker identifiers are assigned when reported
+		if((pMem = ReallocSNPsMem(pChromSNPs->pMarkers,&pChromSNPs->AllocMarkersMem,MarkerSize * (pChromSNPs->NumMarkers + 1)))==NULL)
+			return(eBSFerrMem);
+		pChromSNPs->pMarkers = (UINT8 *)pMem;
+		pMarker = (tsSNPMarker *)&pChromSNPs->pMarkers[MarkerSize * pChromSNPs->NumMarkers];
+		pMarker->Loci = Loci;
+		pMarker->NumPolymorphicSites = NumPolymorphicSites;
+		pMarker->SNPBase = SNPbase;
+		pMarker->RefBase = RefBase;
+		memcpy(pMarker->szMarkerSeq,MarkerSequence,MarkerLen + 1);
+		pChromSNPs->NumMarkers += 1;
+		}
+
+	if((pMem = ReallocSNPsMem(pChromSNPs->pLociPValues,&pChromSNPs->AllocLociPValuesMem,sizeof(tsLociPValues) * (pChromSNPs->NumLociPValues + 1)))==NULL)
+		return(eBSFerrMem);
+	pChromSNPs->pLociPValues = (tsLociPValues *)pMem;
+	pLociPValues = &pChromSNPs->pLociPValues[pChromSNPs->NumLociPValues++];
+	pLociPValues->MarkerID = m_hMarkerFile == -1 ? 0 : pChromSNPs->NumMarkers;
+	pLociPValues->NumPolymorphicSites = NumPolymorphicSites;
+	pLociPValues->PValue = 1.0;
+	pLociPValues->Loci = Loci;
+	pLociPValues->Rank = 0;
+	pLociPValues->LocalBkGndSubRate = 0.0;
+	pLociPValues->LocalReads = LocTMM + LocTM;
+	pLociPValues->LocalSubs = LocTMM;
+	pLociPValues->NumReads = TotBases;
+	pLociPValues->SNPcnts = *pSNP;
+	pLociPValues->NumSubs = pSNP->NumNonRefBases;
+	}
+pChromSNPs->ScanLoci = UntilLoci;
+return(eBSFSuccess);
+}
+
+// IdentifyChromSNPs
+// Identify putative SNPs, and Di/TriSNP haplotypes, on a single chromosome
+// Currently can't process for SNPs in InDels or splice junctions
+// FDR: BenjaminiHochberg
+// QValue == acceptable FDR e.g. 0.05% or 0.01%
+// PValue == 1.0 - Stats.Binomial(TotBasesInColumn,NumBasesInColMismatching+1,GlobalSeqErrRate);
+// PValueIdx == sorted index of PValue and locus pairs, 1..k
+// Generate PValues for all alignment columns meeting minimum constraints into an array of structures containing column loci and associated PValues
+// Sort array of structures ascending on PValues
+// Iterate array 1 to k and accept as SNPs those elements with PValues < (PValueIdx/k) * QValue
+// Base cnts are accumulated into a pileup window which is only large enough to hold the longest read plus the flanks used for background
+// rates and markers, loci are scanned for putative SNPs as soon as no subsequent read can overlap them.
+int
+CAligner::IdentifyChromSNPs(tsSNPWorker *pWorker,	// worker specific resources
+						tsChromSNPs *pChromSNPs)	// identify putative SNPs on this chromosome
+{
+int Rslt;
+UINT32 SeqIdx;
+etSeqBase TargBases[3];
+etSeqBase ReadBase;
+tsSNPcnts *pSNP;
+UINT8 *pSeqVal;
+etSeqBase *pReadSeq;
+etSeqBase *pAssembSeq;
+tsSegLoci *pSeg;
+tsReadHit *pReadHit;
+UINT32 ChromLen;
+UINT32 HitLoci;
+UINT32 PrevHitLoci;
+UINT32 MatchLen;
+UINT32 MaxMatchLen;
+UINT32 PrevMMChromID;
+UINT32 PrevMMLoci;
+UINT32 WinLen;
+UINT32 WinMsk;
+UINT32 LeftFlank;
+UINT32 RightFlank;
+bool bLociOrdered;
+
+double GlobalSeqErrRate;
+double LocalSeqErrRate;
+double AdjPValue;
+int Idx;
+int NumSNPs;
+UINT32 NumLociPValues;
+UINT32 NumMarkers;
+size_t MarkerSize;
+tsLociPValues *pLociPValues;
+tsLociPValues *pAcceptLociPValues;
+CStats Stats;
+
+ChromLen = pChromSNPs->ChromLen;
+pChromSNPs->TotMatch = 0;
+pChromSNPs->TotMismatch = 0;
+pChromSNPs->MeanReadLen = 0;
+pChromSNPs->NumReads = 0;
+pChromSNPs->TotReadLen = 0;
+pChromSNPs->LociBasesCovered = 0;
+pChromSNPs->LociBasesCoverage = 0;
+memset(pChromSNPs->AdjacentSNPs,0,sizeof(pChromSNPs->AdjacentSNPs));
+pChromSNPs->pFirstReadHit = NULL;
+pChromSNPs->pLastReadHit = NULL;
+pChromSNPs->ClearedLoci = 0;
+pChromSNPs->ScanLoci = 0;
+pChromSNPs->NumLociPValues = 0;
+pChromSNPs->NumMarkers = 0;
+pChromSNPs->NumHaplotypes = 0;
+
+// pileup window needs to hold the longest read plus flanks sufficent for background rate and marker processing
+// if reads are not ordered by loci then the window must hold the complete chromosome and is only scanned after all reads accumulated
+MaxMatchLen = 0;
+PrevHitLoci = 0;
+bLociOrdered = true;
+pReadHit = pChromSNPs->pStartReadHit;
+do {
+	if(pReadHit->NAR != eNARAccepted || pReadHit->HitLoci.Hit.FlgInDel || pReadHit->HitLoci.Hit.FlgSplice)
+		continue;
+	pSeg = &pReadHit->HitLoci.Hit.Seg[0];
+	HitLoci = AdjStartLoci(pSeg);
+	if(HitLoci < PrevHitLoci)
+		bLociOrdered = false;
+	PrevHitLoci = HitLoci;
+	if((MatchLen = AdjHitLen(pSeg)) > MaxMatchLen)
+		MaxMatchLen = MatchLen;
+	}
+while(pReadHit != pChromSNPs->pEndReadHit && (pReadHit = IterSortedReads(pReadHit)) != NULL);
+
+LeftFlank = (cSNPBkgndRateWindow / 2) + 1;
+RightFlank = (cSNPBkgndRateWindow / 2) * 2;
+if(m_hMarkerFile != -1)
+	{
+	if(m_Marker5Len > (int)LeftFlank)
+		LeftFlank = m_Marker5Len;
+	if(m_Marker3Len > (int)RightFlank)
+		RightFlank = m_Marker3Len;
+	}
+WinLen = 0x0400;
+while(WinLen <= ChromLen && WinLen < 0x080000000 && (!bLociOrdered || WinLen < (MaxMatchLen + LeftFlank + RightFlank + 2)))
+	WinLen <<= 1;
+if(pChromSNPs->pWinCnts == NULL || WinLen > pChromSNPs->AllocWinLen)
+	{
+	if(pChromSNPs->pWinCnts != NULL)
+		{
+		delete []pChromSNPs->pWinCnts;
+		pChromSNPs->pWinCnts = NULL;
+		pChromSNPs->AllocWinLen = 0;
+		}
+	if((pChromSNPs->pWinCnts = new tsSNPcnts[WinLen])==NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"IdentifyChromSNPs: Memory allocation of %lld bytes - %s",(INT64)WinLen * sizeof(tsSNPcnts),strerror(errno));
+		return(eBSFerrMem);
+		}
+	pChromSNPs->AllocWinLen = WinLen;
+	}
+pChromSNPs->WinLen = WinLen;
+WinMsk = WinLen - 1;
+
+PrevMMChromID = 0;
+PrevMMLoci = -1;
+pReadHit = pChromSNPs->pStartReadHit;
+do {
+	if(pReadHit->NAR != eNARAccepted || pReadHit->HitLoci.Hit.FlgInDel || pReadHit->HitLoci.Hit.FlgSplice)
+		continue;
+
+	pSeg = &pReadHit->HitLoci.Hit.Seg[0];
+
+	// get target genome sequence
+	if(m_bIsSOLiD)
+		{
+		MatchLen = AdjHitLen(pSeg);
+		HitLoci = AdjStartLoci(pSeg);
+		HitLoci += 1;
+		MatchLen -= 1;
+		m_pSfxArray->GetColorspaceSeq(pSeg->ChromID,
+								HitLoci,
+								pWorker->pAssembSeq,MatchLen);	// get colorspace sequence
+		}
+	else
+		{
+		// get target assembly sequence for entry starting at offset and of length len
+		MatchLen = AdjHitLen(pSeg);
+		HitLoci = AdjStartLoci(pSeg);
+		m_pSfxArray->GetSeq(pSeg->ChromID,HitLoci,pWorker->pAssembSeq,MatchLen);
+		pAssembSeq = pWorker->pAssembSeq;
+		for(SeqIdx = 0; SeqIdx < MatchLen; SeqIdx++,pAssembSeq++)
+			*pAssembSeq = *pAssembSeq & 0x07;
+		}
+
+		// get accepted aligned read sequence
+	pSeqVal = &pReadHit->Read[pReadHit->DescrLen+1];
+	pSeqVal += pSeg->ReadOfs + pSeg->TrimLeft;
+	pReadSeq = pWorker->pReadSeq;
+
+	if(m_bIsSOLiD)
+		{
+		// convert read sequence into colorspace
+		UINT8 PrvBase = *pSeqVal & 0x07;
+		for(SeqIdx = 1; SeqIdx <= MatchLen; SeqIdx++,pReadSeq++,pSeqVal++)
+			{
+			*pReadSeq = SOLiDmap[PrvBase][pSeqVal[1] & 0x07];
+			PrvBase = pSeqVal[1] & 0x07;
+			}
+		// reverse, not complement, sequence if hit was onto '-' strand
+		if(pSeg->Strand == '-')
+			CSeqTrans::ReverseSeq(MatchLen,pWorker->pReadSeq);
+		}
+	else
+		{
+		for(SeqIdx = 0; SeqIdx < MatchLen; SeqIdx++,pReadSeq++,pSeqVal++)
+			*pReadSeq = *pSeqVal & 0x07;
+		if(pSeg->Strand == '-')
+			CSeqTrans::ReverseComplement(MatchLen,pWorker->pReadSeq);
+		}
+
+	// double check not about to update snp counts past the expected chrom length
+	if((HitLoci + MatchLen) > ChromLen)
+		{
+		if((MatchLen = (int)ChromLen - HitLoci) < 10)
+			continue;
+		}
+
+	// all loci which can't be overlapped by this, or any subsequent, read can now be scanned for putative SNPs
+	if(bLociOrdered && HitLoci > RightFlank)
+		{
+		if((Rslt = ScanSNPsWin(pWorker,pChromSNPs,HitLoci - RightFlank)) < eBSFSuccess)
+			return(Rslt);
+		}
+	ClearSNPsWin(pChromSNPs,HitLoci + MatchLen);
+
+	if(pChromSNPs->pFirstReadHit == NULL)
+		pChromSNPs->pFirstReadHit = pReadHit;
+	pChromSNPs->pLastReadHit = pReadHit;
+	pChromSNPs->TotReadLen += MatchLen;
+	pChromSNPs->NumReads += 1;
+
+	// now iterate read bases and if mismatch then update appropriate counts
+	pAssembSeq = pWorker->pAssembSeq;
+	pReadSeq = pWorker->pReadSeq;
+	UINT32 Loci = HitLoci;
+	bool bPairMM = false;
+	int SeqMM = 0;
+	for(SeqIdx = 0; SeqIdx < MatchLen; SeqIdx++, Loci++,pReadSeq++, pAssembSeq++)
+		{
+		pSNP = &pChromSNPs->pWinCnts[Loci & WinMsk];
+		if(*pAssembSeq >= eBaseN || (m_bIsSOLiD && *pReadSeq >= eBaseN) || *pReadSeq > eBaseN)
+			{
+			SeqMM += 1;
+			continue;
+			}
+
+		if(m_bIsSOLiD)		// in colorspace, unpaired mismatches assumed to be sequencer errors and simply sloughed when identifying SNPs
+			{
+			if(Loci == 0)	// too problematic with SNPs in colorspace at the start of the target sequence, simply slough
+				continue;
+
+			if(!bPairMM && *pAssembSeq != *pReadSeq)
+				{
+				if(SeqIdx < (1+MatchLen))
+					{
+					if(pReadSeq[1] == pAssembSeq[1])
+						{
+						pSNP->NumRefBases += 1;
+						pChromSNPs->TotMatch += 1;
+						SeqMM += 1;
+						continue;
+						}
+					}
+
+				// get the previous target sequence base and use this + read colorspace space to derive the mismatch in basespace
+				if(pSeg->ChromID != PrevMMChromID || Loci != PrevMMLoci)
+					{
+					PrevMMChromID = pSeg->ChromID;
+					PrevMMLoci = Loci;
+					m_pSfxArray->GetSeq(pSeg->ChromID,Loci-1,&TargBases[0],2);
+					if(TargBases[0] > eBaseN)
+						TargBases[0] = eBaseN;
+					if(TargBases[1] > eBaseN)
+						TargBases[1] = eBaseN;
+					pSNP->RefBase = TargBases[1];
+					}
+
+				ReadBase = *pReadSeq;
+				if(ReadBase > eBaseT)
+					ReadBase = eBaseN;
+
+				if(SeqMM == 0)
+					ReadBase = SOLiDmap[TargBases[0]][ReadBase];
+				else
+					ReadBase = eBaseN;
+
+				// sometimes it seems that a colorspace read may have had a sequencing error earlier in the read
+				// or some mismatch such that the current loci mismatches in colorspace but matches in basespace
+				// these strange bases are treated as though they are undefined and accrue counts as being eBaseN's
+				if(ReadBase == pSNP->RefBase)
+					ReadBase = eBaseN;
+				pSNP->NonRefBaseCnts[ReadBase] += 1;
+				pSNP->NumNonRefBases += 1;
+				pChromSNPs->TotMismatch += 1;
+				bPairMM = true;
+				SeqMM += 1;
+				}
+			else
+				{
+				pSNP->NumRefBases += 1;
+				pChromSNPs->TotMatch += 1;
+				bPairMM = false;
+				SeqMM = 0;
+				}
+			}
+		else				// in basespace any mismatch is counted as a NonRefCnt
+			{
+			ReadBase = *pReadSeq & 0x07;
+			TargBases[0] = *pAssembSeq & 0x07;
+
+			pSNP->RefBase = TargBases[0];
+			if(TargBases[0] == ReadBase)
+				{
+				pSNP->NumRefBases += 1;
+				pChromSNPs->TotMatch += 1;
+				}
+			else
+				{
+				if(ReadBase > eBaseT)
+					ReadBase = eBaseN;
+				pSNP->NonRefBaseCnts[ReadBase] += 1;
+				pSNP->NumNonRefBases += 1;
+				pChromSNPs->TotMismatch += 1;
+				}
+			}
+		}
+	}
+while(pReadHit != pChromSNPs->pEndReadHit && (pReadHit = IterSortedReads(pReadHit)) != NULL);
+
+// scan all remaining loci
+if((Rslt = ScanSNPsWin(pWorker,pChromSNPs,ChromLen)) < eBSFSuccess)
+	return(Rslt);
+if(pChromSNPs->NumReads > 0)
+	pChromSNPs->MeanReadLen = (UINT32)(((pChromSNPs->TotReadLen + pChromSNPs->NumReads - 1) / pChromSNPs->NumReads));
+
+// NOTE: set a floor on the global (whole chromosome) sequencing error rate
+GlobalSeqErrRate = max(cMinSeqErrRate,(double)pChromSNPs->TotMismatch / (double)(1 + pChromSNPs->TotMatch + pChromSNPs->TotMismatch));
+
+// now that the global sequencing error rate is known can filter out putative SNPs with noisy backgrounds and generate PValues
+MarkerSize = sizeof(tsSNPMarker) + 1 + m_Marker5Len + m_Marker3Len;
+NumLociPValues = 0;
+NumMarkers = 0;
+pLociPValues = pChromSNPs->pLociPValues;
+pAcceptLociPValues = pLociPValues;
+for(Idx = 0; Idx < (int)pChromSNPs->NumLociPValues; Idx++,pLociPValues++)
+	{
+	if(pLociPValues->LocalReads == 0)
+		LocalSeqErrRate = GlobalSeqErrRate;
+	else
+		{
+		LocalSeqErrRate = (double)pLociPValues->LocalSubs / (double)pLociPValues->LocalReads;
+		if(LocalSeqErrRate < GlobalSeqErrRate)
+			LocalSeqErrRate = GlobalSeqErrRate;
+		}
+	if(LocalSeqErrRate > cMaxBkgdNoiseThres)	// don't bother attempting to call if the background is too noisy
+		continue;
+
+	if(pLociPValues->MarkerID != 0)			// markers are retained, and identified, only if the SNP is retained
+		{
+		if(pLociPValues->MarkerID != NumMarkers + 1)
+			memmove(&pChromSNPs->pMarkers[MarkerSize * NumMarkers],&pChromSNPs->pMarkers[MarkerSize * (pLociPValues->MarkerID - 1)],MarkerSize);
+		NumMarkers += 1;
+		pLociPValues->MarkerID = NumMarkers;
+		}
+	pLociPValues->PValue = 1.0 - Stats.Binomial(pLociPValues->NumReads,pLociPValues->NumSubs,LocalSeqErrRate);
+	pLociPValues->LocalBkGndSubRate = LocalSeqErrRate;
+	if(pAcceptLociPValues != pLociPValues)
+		*pAcceptLociPValues = *pLociPValues;
+	pAcceptLociPValues += 1;
+	NumLociPValues += 1;
+	}
+pChromSNPs->NumLociPValues = NumLociPValues;
+pChromSNPs->NumMarkers = NumMarkers;
+
+if(NumLociPValues == 0)
+	return(eBSFSuccess);
+if(NumLociPValues > 1)
+	qsort(pChromSNPs->pLociPValues,NumLociPValues,sizeof(tsLociPValues),SortLociPValues);
+pLociPValues = pChromSNPs->pLociPValues;
+NumSNPs = 0;
+for(Idx = 0; Idx < (int)NumLociPValues; Idx++,pLociPValues++)
+	{
+	AdjPValue = ((Idx+1)/(double)NumLociPValues) * m_QValue;
+	if(pLociPValues->PValue >= AdjPValue)
+		break;
+	NumSNPs += 1;
+	pLociPValues->Rank = Idx + 1;
+	}
+pChromSNPs->NumLociPValues = NumSNPs;
+if(NumSNPs > 1)
+	qsort(pChromSNPs->pLociPValues,NumSNPs,sizeof(tsLociPValues),SortPValuesLoci);
+
+#ifdef _DISNPS_
+if (!m_bIsSOLiD && m_hDiSNPfile != -1)
+	{
+	// try to find all reads which are overlapping each SNP plus the prev, or prev two, SNPs within the mean read length
+	tsReadHit *pCurOverlappingRead;
+	tsSNPHaplotypes *pHaplotypes;
+	tsSNPcnts PrevSNPs[3]; // to hold counts for prev 2 plus currrent SNP
+	UINT8 PrevDiSNPBase;
+	UINT8 CurDiSNPBase;
+	UINT8 FirstTriSNPBase;
+	UINT8 PrevTriSNPBase;
+	UINT8 CurTriSNPBase;
+	int CurDiSNPLoci;
+	int PrevDiSNPLoci;
+	int CurTriSNPLoci;
+	int PrevTriSNPLoci;
+	int FirstTriSNPLoci;
+	int MaxDiSNPSep;
+	int NumHaplotypes;
+	int HaplotypeCntThres;
+	int NumReadsOverlapping;
+	int NumReadsAntisense;
+	int DiSNPIdx;
+	int DiSNPCnts[64];
+	void *pMem;
+
+	MaxDiSNPSep = pChromSNPs->MeanReadLen;
+	PrevDiSNPLoci = -1;
+	PrevTriSNPLoci = -1;
+	FirstTriSNPLoci = -1;
+	pLociPValues = pChromSNPs->pLociPValues;
+	for(Idx = 0; Idx < NumSNPs; Idx++,pLociPValues++)
+		{
+		CurDiSNPLoci = pLociPValues->Loci;
+		if (PrevDiSNPLoci != -1 && CurDiSNPLoci > 0 && ((CurDiSNPLoci - PrevDiSNPLoci) <= MaxDiSNPSep))
+			{
+			NumReadsOverlapping = 0;
+			NumReadsAntisense = 0;
+			memset(DiSNPCnts, 0, sizeof(DiSNPCnts));
+			memset(PrevSNPs, 0, sizeof(PrevSNPs));
+			PrevSNPs[0].RefBase = pLociPValues->SNPcnts.RefBase;
+			PrevSNPs[1].RefBase = pLociPValues[-1].SNPcnts.RefBase;
+
+			while ((pCurOverlappingRead = IterateReadsOverlapping(false, pChromSNPs, PrevDiSNPLoci, CurDiSNPLoci)) != NULL)
+				{
+				// get bases at both SNP loci for current overlapping read
+				PrevDiSNPBase = AdjAlignSNPBase(pCurOverlappingRead, pChromSNPs->ChromID, PrevDiSNPLoci);
+				if (PrevDiSNPBase > eBaseT)
+					continue;
+				CurDiSNPBase = AdjAlignSNPBase(pCurOverlappingRead, pChromSNPs->ChromID, CurDiSNPLoci);
+				if (CurDiSNPBase > eBaseT)
+					continue;
+				PrevSNPs[1].NonRefBaseCnts[PrevDiSNPBase] += 1;
+				PrevSNPs[0].NonRefBaseCnts[CurDiSNPBase] += 1;
+				if (PrevDiSNPBase == PrevSNPs[1].RefBase)
+					PrevSNPs[1].NumRefBases += 1;
+				else
+					PrevSNPs[1].NumNonRefBases += 1;
+				if (CurDiSNPBase == PrevSNPs[0].RefBase)
+					PrevSNPs[0].NumRefBases += 1;
+				else
+					PrevSNPs[0].NumNonRefBases += 1;
+				NumReadsOverlapping += 1;
+				if (pCurOverlappingRead->HitLoci.Hit.Seg[0].Strand == '-')
+					NumReadsAntisense += 1;
+				DiSNPIdx = ((PrevDiSNPBase & 0x03) << 2) | (CurDiSNPBase & 0x03);
+				DiSNPCnts[DiSNPIdx] += 1;
+				}
+			if (NumReadsOverlapping >= m_MinSNPreads)
+				{
+				NumHaplotypes = 0;       // very simplistic - calling haplotype if at least 3 for any putative DiSNP and more than 5% of read depth
+				HaplotypeCntThres = max(3, NumReadsOverlapping / 20);
+				for (DiSNPIdx = 0; DiSNPIdx < 16; DiSNPIdx++)
+					if (DiSNPCnts[DiSNPIdx] >= HaplotypeCntThres)
+						NumHaplotypes += 1;
+
+				if((pMem = ReallocSNPsMem(pChromSNPs->pHaplotypes,&pChromSNPs->AllocHaplotypesMem,sizeof(tsSNPHaplotypes) * (pChromSNPs->NumHaplotypes + 1)))==NULL)
+					return(eBSFerrMem);
+				pChromSNPs->pHaplotypes = (tsSNPHaplotypes *)pMem;
+				pHaplotypes = &pChromSNPs->pHaplotypes[pChromSNPs->NumHaplotypes++];
+				pHaplotypes->SNPIdx = Idx;
+				pHaplotypes->NumSNPs = 2;
+				pHaplotypes->SNPLoci[0] = PrevDiSNPLoci;
+				pHaplotypes->SNPLoci[1] = CurDiSNPLoci;
+				pHaplotypes->SNPcnts[0] = PrevSNPs[0];
+				pHaplotypes->SNPcnts[1] = PrevSNPs[1];
+				pHaplotypes->NumReadsOverlapping = NumReadsOverlapping;
+				pHaplotypes->NumReadsAntisense = NumReadsAntisense;
+				pHaplotypes->NumHaplotypes = NumHaplotypes;
+				memcpy(pHaplotypes->HaplotypeCnts,DiSNPCnts,sizeof(DiSNPCnts));
+				}
+			}
+
+		CurTriSNPLoci = CurDiSNPLoci;
+		if (FirstTriSNPLoci != -1 && PrevTriSNPLoci > 0 && CurTriSNPLoci > 0 && ((CurTriSNPLoci - FirstTriSNPLoci) <= MaxDiSNPSep))
+			{
+			NumReadsOverlapping = 0;
+			NumReadsAntisense = 0;
+			memset(DiSNPCnts, 0, sizeof(DiSNPCnts));
+
+			memset(PrevSNPs, 0, sizeof(PrevSNPs));
+			PrevSNPs[0].RefBase = pLociPValues->SNPcnts.RefBase;
+			PrevSNPs[1].RefBase = pLociPValues[-1].SNPcnts.RefBase;
+			PrevSNPs[2].RefBase = pLociPValues[-2].SNPcnts.RefBase;
+
+			while ((pCurOverlappingRead = IterateReadsOverlapping(true, pChromSNPs, FirstTriSNPLoci, CurTriSNPLoci)) != NULL)
+				{
+				// get bases at all three SNP loci
+				FirstTriSNPBase = AdjAlignSNPBase(pCurOverlappingRead, pChromSNPs->ChromID, FirstTriSNPLoci);
+				if (FirstTriSNPBase > eBaseT)
+					continue;
+				PrevTriSNPBase = AdjAlignSNPBase(pCurOverlappingRead, pChromSNPs->ChromID, PrevTriSNPLoci);
+				if (PrevTriSNPBase > eBaseT)
+					continue;
+				CurTriSNPBase = AdjAlignSNPBase(pCurOverlappingRead, pChromSNPs->ChromID, CurTriSNPLoci);
+				if (CurTriSNPBase > eBaseT)
+					continue;
+
+				PrevSNPs[2].NonRefBaseCnts[FirstTriSNPBase] += 1;
+				PrevSNPs[1].NonRefBaseCnts[PrevTriSNPBase] += 1;
+				PrevSNPs[0].NonRefBaseCnts[CurTriSNPBase] += 1;
+				if (FirstTriSNPBase == PrevSNPs[2].RefBase)
+					PrevSNPs[2].NumRefBases += 1;
+				else
+					PrevSNPs[2].NumNonRefBases += 1;
+				if (PrevTriSNPBase == PrevSNPs[1].RefBase)
+					PrevSNPs[1].NumRefBases += 1;
+				else
+					PrevSNPs[1].NumNonRefBases += 1;
+				if (CurTriSNPBase == PrevSNPs[0].RefBase)
+					PrevSNPs[0].NumRefBases += 1;
+				else
+					PrevSNPs[0].NumNonRefBases += 1;
+
+				NumReadsOverlapping += 1;
+				if (pCurOverlappingRead->HitLoci.Hit.Seg[0].Strand == '-')
+					NumReadsAntisense += 1;
+				DiSNPIdx = ((FirstTriSNPBase & 0x03) << 4) | ((PrevTriSNPBase & 0x03) << 2) | (CurTriSNPBase & 0x03);
+				DiSNPCnts[DiSNPIdx] += 1;
+				}
+			if (NumReadsOverlapping >= m_MinSNPreads)
+				{
+				NumHaplotypes = 0;       // very simplistic - calling haplotype if at least 3 for any putative DiSNP and more than 5% of read depth
+				HaplotypeCntThres = max(3, NumReadsOverlapping / 20);
+				for (DiSNPIdx = 0; DiSNPIdx < 64; DiSNPIdx++)
+					if (DiSNPCnts[DiSNPIdx] >= HaplotypeCntThres)
+						NumHaplotypes += 1;
+
+				if((pMem = ReallocSNPsMem(pChromSNPs->pHaplotypes,&pChromSNPs->AllocHaplotypesMem,sizeof(tsSNPHaplotypes) * (pChromSNPs->NumHaplotypes + 1)))==NULL)
+					return(eBSFerrMem);
+				pChromSNPs->pHaplotypes = (tsSNPHaplotypes *)pMem;
+				pHaplotypes = &pChromSNPs->pHaplotypes[pChromSNPs->NumHaplotypes++];
+				pHaplotypes->SNPIdx = Idx;
+				pHaplotypes->NumSNPs = 3;
+				pHaplotypes->SNPLoci[0] = FirstTriSNPLoci;
+				pHaplotypes->SNPLoci[1] = PrevTriSNPLoci;
+				pHaplotypes->SNPLoci[2] = CurTriSNPLoci;
+				pHaplotypes->SNPcnts[0] = PrevSNPs[0];
+				pHaplotypes->SNPcnts[1] = PrevSNPs[1];
+				pHaplotypes->SNPcnts[2] = PrevSNPs[2];
+				pHaplotypes->NumReadsOverlapping = NumReadsOverlapping;
+				pHaplotypes->NumReadsAntisense = NumReadsAntisense;
+				pHaplotypes->NumHaplotypes = NumHaplotypes;
+				memcpy(pHaplotypes->HaplotypeCnts,DiSNPCnts,sizeof(DiSNPCnts));
+				}
+			}
+		PrevDiSNPLoci = CurDiSNPLoci;
+		FirstTriSNPLoci = PrevTriSNPLoci;
+		PrevTriSNPLoci = CurTriSNPLoci;
+		}
+	}
+#endif
+return(eBSFSuccess);
+}
+
+// IdentifySNPsTask
+// Work pool function identifying putative SNPs on chromosomes [From,Until) in m_pSNPChroms[] using the resources specific to WorkerIdx
+int
+CAligner::IdentifySNPsTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until)
+{
+int Rslt;
+CAligner *pThis = (CAligner *)pCtx;
+for(Rslt = eBSFSuccess; From < Until && Rslt >= eBSFSuccess; From++)
+	Rslt = pThis->IdentifyChromSNPs(&pThis->m_pSNPWorkers[WorkerIdx],&pThis->m_pSNPChroms[From]);
+return(Rslt);
+}
+
+// OutputSNPs
+// Report putative SNPs, their marker sequences and Di/TriSNPs, as identified by IdentifyChromSNPs() on a single chromosome
+// Chromosomes are reported in the same order as the sorted reads so SNP and marker identifiers are independent of the number of threads
+int
+CAligner::OutputSNPs(tsChromSNPs *pChromSNPs)	// report SNPs identified on this chromosome
+{
+UINT32 Loci;
+int Idx;
+char szChromName[cMaxDatasetSpeciesChrom+1];
+int LineLen;
+int RelRank;
+tsLociPValues *pLociPValues;
+tsSNPcnts SNPcnts;
+tsSNPMarker *pMarker;
+tsSNPHaplotypes *pHaplotypes;
+tsSNPHaplotypes *pEndHaplotypes;
+int MarkerLen;
+size_t MarkerSize;
+int MarkerIDBase;
+
+tsMonoSNP sMonoSNP;
+tsDiSNP sDiSNP;
+tsTriSNP sTriSNP;
+
+int DiSNPBuffIdx;
+char szDiSNPs[4000];
+int TriSNPBuffIdx;
+char szTriSNPs[4000];
+int TotNumDiSNPs;
+int TotNumTriSNPs;
+
+UINT8 SNPFlanks[9];
+UINT8 *pSNPFlank;
+int SNPFlankIdx;
+int SNPCentroidIdx;
+UINT8 Base;
+tsSNPCentroid *pCentroid;
+
+m_pSfxArray->GetIdentName(pChromSNPs->ChromID,sizeof(szChromName),szChromName);
+m_MaxDiSNPSep = pChromSNPs->MeanReadLen;
+m_LociBasesCovered += pChromSNPs->LociBasesCovered;
+m_LociBasesCoverage += pChromSNPs->LociBasesCoverage;
+
+MarkerIDBase = m_MarkerID;
+LineLen = 0;
+if(m_hMarkerFile != -1 && pChromSNPs->NumMarkers)
+	{
+	MarkerLen = 1 + m_Marker5Len + m_Marker3Len;
+	MarkerSize = sizeof(tsSNPMarker) + MarkerLen;
+	for(Idx = 0; Idx < (int)pChromSNPs->NumMarkers; Idx++)
+		{
+		pMarker = (tsSNPMarker *)&pChromSNPs->pMarkers[MarkerSize * Idx];
 		m_MarkerID += 1;
-		pLociPValues->MarkerID = m_MarkerID;
-		pLociPValues->NumPolymorphicSites = NumPolymorphicSites;
 		// >MarkerNNN  Chrom StartLoci|MarkerLen|SNPLoci|Marker5Len,SNPbase|RefBase|NumPolymorphicSites
 		LineLen+=sprintf(&m_pszLineBuff[LineLen],">Marker%d %s %d|%d|%d|%d|%c|%c|%d\n%s\n",
-										m_MarkerID,szChromName,MarkerStartLoci,MarkerLen,Loci,m_Marker5Len,SNPbase,RefBase,NumPolymorphicSites,MarkerSequence);
+										m_MarkerID,szChromName,pMarker->Loci - m_Marker5Len,MarkerLen,pMarker->Loci,m_Marker5Len,pMarker->SNPBase,pMarker->RefBase,pMarker->NumPolymorphicSites,pMarker->szMarkerSeq);
 
 		if((LineLen + cMaxSeqLen) > cAllocLineBuffSize)
 			{
@@ -7084,66 +7918,31 @@ for(Loci = 0; Loci < m_pChromSNPs->ChromLen;Loci++, pSNP++)
 			LineLen = 0;
 			}
 		}
-
-	if(m_hMarkerFile == -1)
+	if(LineLen)
 		{
-		pLociPValues->MarkerID = 0;
-		pLociPValues->NumPolymorphicSites = 0;
+		CUtility::SafeWrite(m_hMarkerFile,m_pszLineBuff,LineLen);
+		LineLen = 0;
 		}
-	PValue = 1.0 - Stats.Binomial(TotBases,pSNP->NumNonRefBases,LocalSeqErrRate);
-	pLociPValues->PValue = PValue;
-	pLociPValues->Loci = Loci;
-	pLociPValues->Rank = 0;
-	pLociPValues->LocalBkGndSubRate = LocalSeqErrRate;
-	pLociPValues->LocalReads = LocTMM + LocTM;
-	pLociPValues->LocalSubs = LocTMM;
-	pLociPValues->NumReads = TotBases;
-	pLociPValues->SNPcnts = *pSNP;
-	pLociPValues->NumSubs = pSNP->NumNonRefBases;
-	pLociPValues += 1;
-	m_NumLociPValues += 1;
-	}
-
-if(m_hMarkerFile != -1 && LineLen)
-	{
-	CUtility::SafeWrite(m_hMarkerFile,m_pszLineBuff,LineLen);
-	LineLen = 0;
 	}
 
-
-if(m_NumLociPValues == 0)
+if(pChromSNPs->NumLociPValues == 0)
 	return(eBSFSuccess);
-if(m_NumLociPValues > 1)
-	m_mtqsort.qsort(m_pLociPValues,m_NumLociPValues,sizeof(tsLociPValues),SortLociPValues);
-pLociPValues = m_pLociPValues;
-NumSNPs = 0;
-for(Idx = 0; Idx < (int)m_NumLociPValues; Idx++,pLociPValues++)
-	{
-	AdjPValue = ((Idx+1)/(double)m_NumLociPValues) * m_QValue;
-	if(pLociPValues->PValue >= AdjPValue)
-		break;
-	NumSNPs += 1;
-	pLociPValues->Rank = Idx + 1;
-	}
-m_NumLociPValues = NumSNPs;
-if(m_NumLociPValues > 1)
-	m_mtqsort.qsort(m_pLociPValues,m_NumLociPValues,sizeof(tsLociPValues),SortPValuesLoci);
 
 DiSNPBuffIdx = 0;
 TriSNPBuffIdx = 0;
-CurDiSNPLoci = 0;
-PrevDiSNPLoci = -1;
-CurTriSNPLoci = 0;
-PrevTriSNPLoci = -1;
-FirstTriSNPLoci = -1;
 TotNumDiSNPs = 0;
 TotNumTriSNPs = 0;
 LineLen = 0;
-pLociPValues = m_pLociPValues;
-for(Idx = 0; Idx < (int)m_NumLociPValues; Idx++,pLociPValues++)
-	{
+pHaplotypes = pChromSNPs->pHaplotypes;
+pEndHaplotypes = pHaplotypes == NULL ? NULL : &pHaplotypes[pChromSNPs->NumHaplotypes];
+pLociPValues = pChromSNPs->pLociPValues;
+for(Idx = 0; Idx < (int)pChromSNPs->NumLociPValues; Idx++,pLociPValues++)
+	{
+	SNPcnts = pLociPValues->SNPcnts;		// CSV reporting updates the ref base counts, centroids require the original counts
+	if(pLociPValues->MarkerID != 0)
+		pLociPValues->MarkerID += MarkerIDBase;
 	m_TotNumSNPs += 1;
-	RelRank = max(1,999 - ((999 * pLociPValues->Rank) / m_NumLociPValues));
+	RelRank = max(1,999 - ((999 * pLociPValues->Rank) / pChromSNPs->NumLociPValues));
 	if(m_FMode == eFMbed)
 		{
 		LineLen+=sprintf(&m_pszLineBuff[LineLen],"%s\t%d\t%d\tSNP_%d\t%d\t+\n",
@@ -7159,8 +7958,8 @@ for(Idx = 0; Idx < (int)m_NumLociPValues; Idx++,pLociPValues++)
 			int SNPPhred;
 			int AltFreqOfs;
 			int AltIdx;
-			UINT32 CntsThres;		// only reporting cnts which are at least 10% of the highest non-ref base counts. 
-									// otherwise too many noise cnt bases are reported 
+			UINT32 CntsThres;		// only reporting cnts which are at least 10% of the highest non-ref base counts.
+									// otherwise too many noise cnt bases are reported
 
 			CntsThres = 0;
 			for (AltIdx = 0; AltIdx < eBaseN; AltIdx++)
@@ -7219,7 +8018,7 @@ for(Idx = 0; Idx < (int)m_NumLociPValues; Idx++,pLociPValues++)
 		{
 		sMonoSNP.MonoSnpPID = m_TotNumSNPs;						// SNP instance, processing instance unique
 		strcpy(sMonoSNP.szElType, "SNP");						// SNP type
-		strcpy(sMonoSNP.szSpecies, m_szTargSpecies);			// SNP located for alignments againts this target/species assembly	
+		strcpy(sMonoSNP.szSpecies, m_szTargSpecies);			// SNP located for alignments againts this target/species assembly
 		strcpy(sMonoSNP.szChrom, szChromName);					// SNP is on this chrom
 		sMonoSNP.StartLoci = pLociPValues->Loci;				// offset (0..N) at which SNP located
 		sMonoSNP.EndLoci = pLociPValues->Loci;					// offset (0..N) at which SNP located - allowing for future polymorphic varation covering multiple bases
@@ -7243,325 +8042,139 @@ for(Idx = 0; Idx < (int)m_NumLociPValues; Idx++,pLociPValues++)
 		gSQLiteSummaries.AddMonoSNP(gExperimentID, gProcessingID,&sMonoSNP);
 		}
 
-#ifdef _DISNPS_
-	if (!m_bIsSOLiD && m_hDiSNPfile != -1)
-		{
-		// try to find all reads which are overlapping this SNP plus the prev within 300bp SNP
-		tsReadHit *pCurOverlappingRead;
-		UINT8 PrevDiSNPBase;
-		UINT8 CurDiSNPBase;
-		UINT8 FirstTriSNPBase;
-		UINT8 PrevTriSNPBase;
-		UINT8 CurTriSNPBase;
-
-		int NumHaplotypes;
-		int HaplotypeCntThres;
-		int NumReadsOverlapping;
-		int NumReadsAntisense;
+	// report any DiSNPs or TriSNPs which were counted for this SNP
+	for(; pHaplotypes != pEndHaplotypes && pHaplotypes->SNPIdx == (UINT32)Idx; pHaplotypes++)
+		{
+		char SNPrefBases[3];
+		int RefBasesIdx;
 		int DiSNPIdx;
-		int DiSNPCnts[64];
+		for (RefBasesIdx = 0; RefBasesIdx < pHaplotypes->NumSNPs; RefBasesIdx++)
+			{
+			switch (pHaplotypes->SNPcnts[RefBasesIdx].RefBase) {
+				case eBaseA:
+					SNPrefBases[RefBasesIdx] = 'a';
+					break;
+				case eBaseC:
+					SNPrefBases[RefBasesIdx] = 'c';
+					break;
+				case eBaseG:
+					SNPrefBases[RefBasesIdx] = 'g';
+					break;
+				case eBaseT:
+					SNPrefBases[RefBasesIdx] = 't';
+					break;
+				case eBaseN:
+					SNPrefBases[RefBasesIdx] = 'n';
+					break;
+				};
+			}
 
-		Loci = pLociPValues->Loci;
-		CurDiSNPLoci = Loci;
-		pSNP = &m_pChromSNPs->Cnts[Loci];
-		if (PrevDiSNPLoci != -1 && CurDiSNPLoci > 0 && ((CurDiSNPLoci - PrevDiSNPLoci) <= m_MaxDiSNPSep))
+		if(pHaplotypes->NumSNPs == 2)
 			{
-			NumReadsOverlapping = 0;
-			NumReadsAntisense = 0;
-			memset(DiSNPCnts, 0, sizeof(DiSNPCnts));
-			memset(PrevSNPs, 0, sizeof(PrevSNPs));
-			PrevSNPs[0].RefBase = pSNP->RefBase;
-			PrevSNPs[1].RefBase = (&m_pChromSNPs->Cnts[PrevDiSNPLoci])->RefBase;
+			TotNumDiSNPs += 1;
+			DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "%d,\"DiSNPs\",\"%s\",\"%s\",", TotNumDiSNPs, m_szTargSpecies, szChromName);
+			for (RefBasesIdx = 0; RefBasesIdx < 2; RefBasesIdx++)
+				DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "%d,\"%c\",%d,%d,%d,%d,0,", pHaplotypes->SNPLoci[RefBasesIdx], SNPrefBases[RefBasesIdx], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[0], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[1], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[2], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[3]);
+			DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "%d,%d,%d", pHaplotypes->NumReadsOverlapping, pHaplotypes->NumReadsAntisense, pHaplotypes->NumHaplotypes);
+			for (DiSNPIdx = 0; DiSNPIdx < 16; DiSNPIdx++)
+				DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], ",%d", pHaplotypes->HaplotypeCnts[DiSNPIdx]);
+			DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "\n");
 
-			while ((pCurOverlappingRead = IterateReadsOverlapping(false, m_pChromSNPs, PrevDiSNPLoci, CurDiSNPLoci)) != NULL)
-				{
-				// get bases at both SNP loci for current overlapping read
-				PrevDiSNPBase = AdjAlignSNPBase(pCurOverlappingRead, m_pChromSNPs->ChromID, PrevDiSNPLoci);
-				if (PrevDiSNPBase > eBaseT)
-					continue;
-				CurDiSNPBase = AdjAlignSNPBase(pCurOverlappingRead, m_pChromSNPs->ChromID, CurDiSNPLoci);
-				if (CurDiSNPBase > eBaseT)
-					continue;
-				PrevSNPs[1].NonRefBaseCnts[PrevDiSNPBase] += 1;
-				PrevSNPs[0].NonRefBaseCnts[CurDiSNPBase] += 1;
-				if (PrevDiSNPBase == PrevSNPs[1].RefBase)
-					PrevSNPs[1].NumRefBases += 1;
-				else
-					PrevSNPs[1].NumNonRefBases += 1;
-				if (CurDiSNPBase == PrevSNPs[0].RefBase)
-					PrevSNPs[0].NumRefBases += 1;
-				else
-					PrevSNPs[0].NumNonRefBases += 1;
-				NumReadsOverlapping += 1;
-				if (pCurOverlappingRead->HitLoci.Hit.Seg[0].Strand == '-')
-					NumReadsAntisense += 1;
-				DiSNPIdx = ((PrevDiSNPBase & 0x03) << 2) | (CurDiSNPBase & 0x03);
-				DiSNPCnts[DiSNPIdx] += 1;
-				}
-			if (NumReadsOverlapping >= m_MinSNPreads)
+			if (gProcessingID > 0)
 				{
-				NumHaplotypes = 0;       // very simplistic - calling haplotype if at least 3 for any putative DiSNP and more than 5% of read depth
-				HaplotypeCntThres = max(3, NumReadsOverlapping / 20);
-				for (DiSNPIdx = 0; DiSNPIdx < 16; DiSNPIdx++)
-					if (DiSNPCnts[DiSNPIdx] >= HaplotypeCntThres)
-						NumHaplotypes += 1;
-				TotNumDiSNPs += 1;
-				DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "%d,\"DiSNPs\",\"%s\",\"%s\",", TotNumDiSNPs, m_szTargSpecies, szChromName);
-
-				if (gProcessingID > 0)
-					{
-					sDiSNP.DiSnpPID = TotNumDiSNPs;		// SNP instance, processing instance unique
-					strcpy(sDiSNP.szElType, "DiSNPs");		// SNP type
-					strcpy(sDiSNP.szSpecies, m_szTargSpecies);		// SNP located for alignments againts this target/species assembly	
-					strcpy(sDiSNP.szChrom, szChromName);		// SNP is on this chrom
-					}
-
-				char SNPrefBases[2];
-				int RefBasesIdx;
-				for (RefBasesIdx = 0; RefBasesIdx < 2; RefBasesIdx++)
-					{
-					switch (PrevSNPs[RefBasesIdx].RefBase) {
-						case eBaseA:
-							SNPrefBases[RefBasesIdx] = 'a';
-							break;
-						case eBaseC:
-							SNPrefBases[RefBasesIdx] = 'c';
-							break;
-						case eBaseG:
-							SNPrefBases[RefBasesIdx] = 'g';
-							break;
-						case eBaseT:
-							SNPrefBases[RefBasesIdx] = 't';
-							break;
-						case eBaseN:
-							SNPrefBases[RefBasesIdx] = 'n';
-							break;
-						};
-					switch (RefBasesIdx) {
-						case 0:
-							DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "%d,", PrevDiSNPLoci);
-							if (gProcessingID > 0)
-							{
-								sDiSNP.SNP1Loci = PrevDiSNPLoci;
-								sDiSNP.szSNP1RefBase[0] = SNPrefBases[RefBasesIdx]; sDiSNP.szSNP1RefBase[1] = '\0';
-								sDiSNP.SNP1BaseAcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[0];
-								sDiSNP.SNP1BaseCcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[1];
-								sDiSNP.SNP1BaseGcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[2];
-								sDiSNP.SNP1BaseTcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[3];
-								sDiSNP.SNP1BaseNcnt = 0;
-							}
-							break;
-						case 1:
-							DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "%d,", CurDiSNPLoci);
-							if (gProcessingID > 0)
-								{
-								sDiSNP.SNP2Loci = CurDiSNPLoci;
-								sDiSNP.szSNP2RefBase[0] = SNPrefBases[RefBasesIdx]; sDiSNP.szSNP2RefBase[1] = '\0';
-								sDiSNP.SNP2BaseAcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[0];
-								sDiSNP.SNP2BaseCcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[1];
-								sDiSNP.SNP2BaseGcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[2];
-								sDiSNP.SNP2BaseTcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[3];
-								sDiSNP.SNP2BaseNcnt = 0;
-								}
-							break;
-						}
-
-					DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "\"%c\",%d,%d,%d,%d,0,", SNPrefBases[RefBasesIdx], PrevSNPs[RefBasesIdx].NonRefBaseCnts[0], PrevSNPs[RefBasesIdx].NonRefBaseCnts[1], PrevSNPs[RefBasesIdx].NonRefBaseCnts[2], PrevSNPs[RefBasesIdx].NonRefBaseCnts[3]);
-					}
-
-				DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "%d,%d,%d", NumReadsOverlapping, NumReadsAntisense, NumHaplotypes);
-				if (gProcessingID > 0)
-					{
-					sDiSNP.Depth = NumReadsOverlapping;
-					sDiSNP.Antisense = NumReadsAntisense;
-					sDiSNP.Haplotypes = NumHaplotypes;
-					}
-
-
+				sDiSNP.DiSnpPID = TotNumDiSNPs;		// SNP instance, processing instance unique
+				strcpy(sDiSNP.szElType, "DiSNPs");		// SNP type
+				strcpy(sDiSNP.szSpecies, m_szTargSpecies);		// SNP located for alignments againts this target/species assembly
+				strcpy(sDiSNP.szChrom, szChromName);		// SNP is on this chrom
+				sDiSNP.SNP1Loci = pHaplotypes->SNPLoci[0];
+				sDiSNP.szSNP1RefBase[0] = SNPrefBases[0]; sDiSNP.szSNP1RefBase[1] = '\0';
+				sDiSNP.SNP1BaseAcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[0];
+				sDiSNP.SNP1BaseCcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[1];
+				sDiSNP.SNP1BaseGcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[2];
+				sDiSNP.SNP1BaseTcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[3];
+				sDiSNP.SNP1BaseNcnt = 0;
+				sDiSNP.SNP2Loci = pHaplotypes->SNPLoci[1];
+				sDiSNP.szSNP2RefBase[0] = SNPrefBases[1]; sDiSNP.szSNP2RefBase[1] = '\0';
+				sDiSNP.SNP2BaseAcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[0];
+				sDiSNP.SNP2BaseCcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[1];
+				sDiSNP.SNP2BaseGcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[2];
+				sDiSNP.SNP2BaseTcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[3];
+				sDiSNP.SNP2BaseNcnt = 0;
+				sDiSNP.Depth = pHaplotypes->NumReadsOverlapping;
+				sDiSNP.Antisense = pHaplotypes->NumReadsAntisense;
+				sDiSNP.Haplotypes = pHaplotypes->NumHaplotypes;
 				for (DiSNPIdx = 0; DiSNPIdx < 16; DiSNPIdx++)
-					{
-					DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], ",%d", DiSNPCnts[DiSNPIdx]);
-					if (gProcessingID > 0)
-						sDiSNP.HaplotypeCnts[DiSNPIdx] = DiSNPCnts[DiSNPIdx];
-					}
-				DiSNPBuffIdx += sprintf(&szDiSNPs[DiSNPBuffIdx], "\n");
-				if (gProcessingID > 0)
-					gSQLiteSummaries.AddDiSNP(gExperimentID, gProcessingID, &sDiSNP);
+					sDiSNP.HaplotypeCnts[DiSNPIdx] = pHaplotypes->HaplotypeCnts[DiSNPIdx];
+				gSQLiteSummaries.AddDiSNP(gExperimentID, gProcessingID, &sDiSNP);
+				}
 
-				if ((DiSNPBuffIdx + 200) > sizeof(szDiSNPs))
-					{
-					CUtility::SafeWrite(m_hDiSNPfile, szDiSNPs, DiSNPBuffIdx);
-					DiSNPBuffIdx = 0;
-					}
+			if ((DiSNPBuffIdx + 200) > sizeof(szDiSNPs))
+				{
+				CUtility::SafeWrite(m_hDiSNPfile, szDiSNPs, DiSNPBuffIdx);
+				DiSNPBuffIdx = 0;
 				}
 			}
-
-		CurTriSNPLoci = Loci;
-		if (FirstTriSNPLoci != -1 && PrevTriSNPLoci > 0 && CurTriSNPLoci > 0 && ((CurTriSNPLoci - FirstTriSNPLoci) <= m_MaxDiSNPSep))
+		else
 			{
-			NumReadsOverlapping = 0;
-			NumReadsAntisense = 0;
-			memset(DiSNPCnts, 0, sizeof(DiSNPCnts));
-
-			memset(PrevSNPs, 0, sizeof(PrevSNPs));
-			PrevSNPs[0].RefBase = pSNP->RefBase;
-			PrevSNPs[1].RefBase = (&m_pChromSNPs->Cnts[PrevTriSNPLoci])->RefBase;
-			PrevSNPs[2].RefBase = (&m_pChromSNPs->Cnts[FirstTriSNPLoci])->RefBase;
-
-			while ((pCurOverlappingRead = IterateReadsOverlapping(true, m_pChromSNPs, FirstTriSNPLoci, CurTriSNPLoci)) != NULL)
-				{
-				// get bases at all three SNP loci
-				FirstTriSNPBase = AdjAlignSNPBase(pCurOverlappingRead, m_pChromSNPs->ChromID, FirstTriSNPLoci);
-				if (FirstTriSNPBase > eBaseT)
-					continue;
-				PrevTriSNPBase = AdjAlignSNPBase(pCurOverlappingRead, m_pChromSNPs->ChromID, PrevTriSNPLoci);
-				if (PrevTriSNPBase > eBaseT)
-					continue;
-				CurTriSNPBase = AdjAlignSNPBase(pCurOverlappingRead, m_pChromSNPs->ChromID, CurTriSNPLoci);
-				if (CurTriSNPBase > eBaseT)
-					continue;
-
-				PrevSNPs[2].NonRefBaseCnts[FirstTriSNPBase] += 1;
-				PrevSNPs[1].NonRefBaseCnts[PrevTriSNPBase] += 1;
-				PrevSNPs[0].NonRefBaseCnts[CurTriSNPBase] += 1;
-				if (FirstTriSNPBase == PrevSNPs[2].RefBase)
-					PrevSNPs[2].NumRefBases += 1;
-				else
-					PrevSNPs[2].NumNonRefBases += 1;
-				if (PrevTriSNPBase == PrevSNPs[1].RefBase)
-					PrevSNPs[1].NumRefBases += 1;
-				else
-					PrevSNPs[1].NumNonRefBases += 1;
-				if (CurTriSNPBase == PrevSNPs[0].RefBase)
-					PrevSNPs[0].NumRefBases += 1;
-				else
-					PrevSNPs[0].NumNonRefBases += 1;
+			TotNumTriSNPs += 1;
+			TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,\"TriSNPs\",\"%s\",\"%s\",", TotNumTriSNPs, m_szTargSpecies, szChromName);
+			for (RefBasesIdx = 0; RefBasesIdx < 3; RefBasesIdx++)
+				TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,\"%c\",%d,%d,%d,%d,0,", pHaplotypes->SNPLoci[RefBasesIdx], SNPrefBases[RefBasesIdx], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[0], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[1], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[2], pHaplotypes->SNPcnts[RefBasesIdx].NonRefBaseCnts[3]);
+			TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,%d,%d", pHaplotypes->NumReadsOverlapping, pHaplotypes->NumReadsAntisense, pHaplotypes->NumHaplotypes);
+			for (DiSNPIdx = 0; DiSNPIdx < 64; DiSNPIdx++)
+				TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], ",%d", pHaplotypes->HaplotypeCnts[DiSNPIdx]);
+			TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "\n");
 
-				NumReadsOverlapping += 1;
-				if (pCurOverlappingRead->HitLoci.Hit.Seg[0].Strand == '-')
-					NumReadsAntisense += 1;
-				DiSNPIdx = ((FirstTriSNPBase & 0x03) << 4) | ((PrevTriSNPBase & 0x03) << 2) | (CurTriSNPBase & 0x03);
-				DiSNPCnts[DiSNPIdx] += 1;
-				}
-			if (NumReadsOverlapping >= m_MinSNPreads)
+			if (gProcessingID > 0)
 				{
-				NumHaplotypes = 0;       // very simplistic - calling haplotype if at least 3 for any putative DiSNP and more than 5% of read depth
-				HaplotypeCntThres = max(3, NumReadsOverlapping / 20);
+				sTriSNP.TriSnpPID = TotNumTriSNPs;		// SNP instance, processing instance unique
+				strcpy(sTriSNP.szElType, "TriSNPs");		// SNP type
+				strcpy(sTriSNP.szSpecies, m_szTargSpecies);		// SNP located for alignments againts this target/species assembly
+				strcpy(sTriSNP.szChrom, szChromName);		// SNP is on this chrom
+				sTriSNP.SNP1Loci = pHaplotypes->SNPLoci[0];
+				sTriSNP.szSNP1RefBase[0] = SNPrefBases[0]; sTriSNP.szSNP1RefBase[1] = '\0';
+				sTriSNP.SNP1BaseAcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[0];
+				sTriSNP.SNP1BaseCcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[1];
+				sTriSNP.SNP1BaseGcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[2];
+				sTriSNP.SNP1BaseTcnt = pHaplotypes->SNPcnts[0].NonRefBaseCnts[3];
+				sTriSNP.SNP1BaseNcnt = 0;
+				sTriSNP.SNP2Loci = pHaplotypes->SNPLoci[1];
+				sTriSNP.szSNP2RefBase[0] = SNPrefBases[1]; sTriSNP.szSNP2RefBase[1] = '\0';
+				sTriSNP.SNP2BaseAcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[0];
+				sTriSNP.SNP2BaseCcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[1];
+				sTriSNP.SNP2BaseGcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[2];
+				sTriSNP.SNP2BaseTcnt = pHaplotypes->SNPcnts[1].NonRefBaseCnts[3];
+				sTriSNP.SNP2BaseNcnt = 0;
+				sTriSNP.SNP3Loci = pHaplotypes->SNPLoci[2];
+				sTriSNP.szSNP3RefBase[0] = SNPrefBases[2]; sTriSNP.szSNP3RefBase[1] = '\0';
+				sTriSNP.SNP3BaseAcnt = pHaplotypes->SNPcnts[2].NonRefBaseCnts[0];
+				sTriSNP.SNP3BaseCcnt = pHaplotypes->SNPcnts[2].NonRefBaseCnts[1];
+				sTriSNP.SNP3BaseGcnt = pHaplotypes->SNPcnts[2].NonRefBaseCnts[2];
+				sTriSNP.SNP3BaseTcnt = pHaplotypes->SNPcnts[2].NonRefBaseCnts[3];
+				sTriSNP.SNP3BaseNcnt = 0;
+				sTriSNP.Depth = pHaplotypes->NumReadsOverlapping;
+				sTriSNP.Antisense = pHaplotypes->NumReadsAntisense;
+				sTriSNP.Haplotypes = pHaplotypes->NumHaplotypes;
 				for (DiSNPIdx = 0; DiSNPIdx < 64; DiSNPIdx++)
-					if (DiSNPCnts[DiSNPIdx] >= HaplotypeCntThres)
-						NumHaplotypes += 1;
-				TotNumTriSNPs += 1;
-
-				TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,\"TriSNPs\",\"%s\",\"%s\",", TotNumTriSNPs, m_szTargSpecies, szChromName);
-				if (gProcessingID > 0)
-					{
-					sTriSNP.TriSnpPID = TotNumTriSNPs;		// SNP instance, processing instance unique
-					strcpy(sTriSNP.szElType, "TriSNPs");		// SNP type
-					strcpy(sTriSNP.szSpecies, m_szTargSpecies);		// SNP located for alignments againts this target/species assembly	
-					strcpy(sTriSNP.szChrom, szChromName);		// SNP is on this chrom
-					}
-				char SNPrefBases[3];
-				int RefBasesIdx;
-
-				for (RefBasesIdx = 0; RefBasesIdx < 3; RefBasesIdx++)
-					{
-					switch (PrevSNPs[RefBasesIdx].RefBase) {
-						case eBaseA:
-							SNPrefBases[RefBasesIdx] = 'a';
-							break;
-						case eBaseC:
-							SNPrefBases[RefBasesIdx] = 'c';
-							break;
-						case eBaseG:
-							SNPrefBases[RefBasesIdx] = 'g';
-							break;
-						case eBaseT:
-							SNPrefBases[RefBasesIdx] = 't';
-							break;
-						case eBaseN:
-							SNPrefBases[RefBasesIdx] = 'n';
-							break;
-						};
-					switch (RefBasesIdx) {
-						case 0:
-							TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,", FirstTriSNPLoci);
-							if (gProcessingID > 0)
-							{
-								sTriSNP.SNP1Loci = FirstTriSNPLoci;
-								sTriSNP.szSNP1RefBase[0] = SNPrefBases[RefBasesIdx]; sTriSNP.szSNP1RefBase[1] = '\0';
-								sTriSNP.SNP1BaseAcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[0];
-								sTriSNP.SNP1BaseCcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[1];
-								sTriSNP.SNP1BaseGcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[2];
-								sTriSNP.SNP1BaseTcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[3];
-								sTriSNP.SNP1BaseNcnt = 0;
-							}
-							break;
-						case 1:
-							TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,", PrevTriSNPLoci);
-							if (gProcessingID > 0)
-							{
-								sTriSNP.SNP2Loci = PrevTriSNPLoci;
-								sTriSNP.szSNP2RefBase[0] = SNPrefBases[RefBasesIdx]; sTriSNP.szSNP2RefBase[1] = '\0';
-								sTriSNP.SNP2BaseAcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[0];
-								sTriSNP.SNP2BaseCcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[1];
-								sTriSNP.SNP2BaseGcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[2];
-								sTriSNP.SNP2BaseTcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[3];
-								sTriSNP.SNP2BaseNcnt = 0;
-							}
-							break;
-						case 2:
-							TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,", CurTriSNPLoci);
-							if (gProcessingID > 0)
-							{
-								sTriSNP.SNP3Loci = CurTriSNPLoci;
-								sTriSNP.szSNP3RefBase[0] = SNPrefBases[RefBasesIdx]; sTriSNP.szSNP3RefBase[1] = '\0';
-								sTriSNP.SNP3BaseAcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[0];
-								sTriSNP.SNP3BaseCcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[1];
-								sTriSNP.SNP3BaseGcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[2];
-								sTriSNP.SNP3BaseTcnt = PrevSNPs[RefBasesIdx].NonRefBaseCnts[3];
-								sTriSNP.SNP3BaseNcnt = 0;
-							}
-							break;
-						}
-
-					TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "\"%c\",%d,%d,%d,%d,0,", SNPrefBases[RefBasesIdx], PrevSNPs[RefBasesIdx].NonRefBaseCnts[0], PrevSNPs[RefBasesIdx].NonRefBaseCnts[1], PrevSNPs[RefBasesIdx].NonRefBaseCnts[2], PrevSNPs[RefBasesIdx].NonRefBaseCnts[3]);
-					}
+					sTriSNP.HaplotypeCnts[DiSNPIdx] = pHaplotypes->HaplotypeCnts[DiSNPIdx];
+				gSQLiteSummaries.AddTriSNP(gExperimentID, gProcessingID, &sTriSNP);
+				}
 
-				TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "%d,%d,%d", NumReadsOverlapping, NumReadsAntisense, NumHaplotypes);
-				if (gProcessingID > 0)
-					{
-					sTriSNP.Depth = NumReadsOverlapping;
-					sTriSNP.Antisense = NumReadsAntisense;
-					sTriSNP.Haplotypes = NumHaplotypes;
-					}
-				for (DiSNPIdx = 0; DiSNPIdx < 64; DiSNPIdx++)
-					{
-					TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], ",%d", DiSNPCnts[DiSNPIdx]);
-					if (gProcessingID > 0)
-						sTriSNP.HaplotypeCnts[DiSNPIdx] = DiSNPCnts[DiSNPIdx];
-					}
-				TriSNPBuffIdx += sprintf(&szTriSNPs[TriSNPBuffIdx], "\n");
-				if (gProcessingID > 0)
-					gSQLiteSummaries.AddTriSNP(gExperimentID, gProcessingID, &sTriSNP);
-				if ((TriSNPBuffIdx + 500) > sizeof(szTriSNPs))
-					{
-					CUtility::SafeWrite(m_hTriSNPfile, szTriSNPs, TriSNPBuffIdx);
-					TriSNPBuffIdx = 0;
-					}
+			if ((TriSNPBuffIdx + 500) > sizeof(szTriSNPs))
+				{
+				CUtility::SafeWrite(m_hTriSNPfile, szTriSNPs, TriSNPBuffIdx);
+				TriSNPBuffIdx = 0;
 				}
 			}
-		PrevDiSNPLoci = CurDiSNPLoci;
-		FirstTriSNPLoci = PrevTriSNPLoci;
-		PrevTriSNPLoci = CurTriSNPLoci;
 		}
-#endif
 
 	if(m_hSNPCentsfile != -1)
 		{
 		// get 4bases up/dn stream from loci with SNP and use these to inc centroid counts of from/to counts
-		if(pLociPValues->Loci >= cSNPCentfFlankLen && pLociPValues->Loci < (m_pChromSNPs->ChromLen - cSNPCentfFlankLen))
+		Loci = pLociPValues->Loci;
+		if(Loci >= cSNPCentfFlankLen && Loci < (pChromSNPs->ChromLen - cSNPCentfFlankLen))
 			{
-			m_pSfxArray->GetSeq(m_pChromSNPs->ChromID,pLociPValues->Loci-(UINT32)cSNPCentfFlankLen,SNPFlanks,cSNPCentroidLen);
+			m_pSfxArray->GetSeq(pChromSNPs->ChromID,Loci-(UINT32)cSNPCentfFlankLen,SNPFlanks,cSNPCentroidLen);
 			pSNPFlank = &SNPFlanks[cSNPCentroidLen-1];
 			SNPCentroidIdx = 0;
 			for(SNPFlankIdx = 0; SNPFlankIdx < cSNPCentroidLen; SNPFlankIdx++,pSNPFlank--)
@@ -7571,22 +8184,20 @@ for(Idx = 0; Idx < (int)m_NumLociPValues; Idx++,pLociPValues++)
 					break;
 				SNPCentroidIdx |= (Base << (SNPFlankIdx * 2));
 				}
-			if(SNPFlankIdx != cSNPCentroidLen)
-				continue;
-
-			pSNP = &m_pChromSNPs->Cnts[pLociPValues->Loci];
-			pCentroid = &m_pSNPCentroids[SNPCentroidIdx];
-			pCentroid->CentroidID = SNPCentroidIdx;
-			pCentroid->RefBaseCnt += pSNP->NumRefBases;
-			pCentroid->NonRefBaseCnts[0] += pSNP->NonRefBaseCnts[0];
-			pCentroid->NonRefBaseCnts[1] += pSNP->NonRefBaseCnts[1];
-			pCentroid->NonRefBaseCnts[2] += pSNP->NonRefBaseCnts[2];
-			pCentroid->NonRefBaseCnts[3] += pSNP->NonRefBaseCnts[3];
-			pCentroid->NonRefBaseCnts[4] += pSNP->NonRefBaseCnts[4];
-			pCentroid->NumSNPs += 1;
+			if(SNPFlankIdx == cSNPCentroidLen)
+				{
+				pCentroid = &m_pSNPCentroids[SNPCentroidIdx];
+				pCentroid->CentroidID = SNPCentroidIdx;
+				pCentroid->RefBaseCnt += SNPcnts.NumRefBases;
+				pCentroid->NonRefBaseCnts[0] += SNPcnts.NonRefBaseCnts[0];
+				pCentroid->NonRefBaseCnts[1] += SNPcnts.NonRefBaseCnts[1];
+				pCentroid->NonRefBaseCnts[2] += SNPcnts.NonRefBaseCnts[2];
+				pCentroid->NonRefBaseCnts[3] += SNPcnts.NonRefBaseCnts[3];
+				pCentroid->NonRefBaseCnts[4] += SNPcnts.NonRefBaseCnts[4];
+				pCentroid->NumSNPs += 1;
+				}
 			}
 		}
-
 	}
 if (m_hDiSNPfile != -1 && DiSNPBuffIdx > 0)
 	{
@@ -7596,7 +8207,7 @@ if (m_hDiSNPfile != -1 && DiSNPBuffIdx > 0)
 if (m_hTriSNPfile != -1 && TriSNPBuffIdx > 0)
 	{
 	CUtility::SafeWrite(m_hTriSNPfile, szTriSNPs, TriSNPBuffIdx);
-	DiSNPBuffIdx = 0;
+	TriSNPBuffIdx = 0;
 	}
 
 if(LineLen)
@@ -7604,31 +8215,18 @@ if(LineLen)
 return(eBSFSuccess);
 }
 
-
 int
 CAligner::ProcessSNPs(void)
 {
 int Rslt;
 int LineLen;
-
-UINT32 SeqIdx;
-etSeqBase ReadSeq[cMaxFastQSeqLen+1];	// to hold sequence (sans quality scores) for current read
-etSeqBase AssembSeq[cMaxFastQSeqLen+1];	// to hold targeted genome assembly sequence
-
-etSeqBase TargBases[3];
-etSeqBase ReadBase;
-tsSNPcnts *pSNP;
-UINT8 *pSeqVal;
-etSeqBase *pReadSeq;
-etSeqBase *pAssembSeq;
+int WorkerIdx;
+int ChromIdx;
+int NumBatchChroms;
+tsSNPWorker *pWorker;
+tsChromSNPs *pChromSNPs;
 tsSegLoci *pSeg;
 tsReadHit *pReadHit;
-tBSFEntryID PrevTargEntry;
-UINT32 ChromLen;
-UINT32 HitLoci;
-UINT32 MatchLen;
-UINT32 PrevMMChromID;
-UINT32 PrevMMLoci;
 
 if(m_FMode == eFMbed)
 	{
@@ -7730,243 +8328,97 @@ if(m_hSNPCentsfile != -1)
 		}
 	}
 
-pReadHit = NULL;
-LineLen = 0;
-PrevTargEntry = 0;
-
-m_TotNumSNPs = 0;
-while((pReadHit = IterSortedReads(pReadHit))!=NULL)
+// identify putative SNPs on batches of chromosomes with each chromosome processed by a single work pool worker into a windowed pileup
+// batches are then reported in sorted reads order so that the reported SNPs are independent of the number of workers
+FreeSNPsMem();
+m_NumSNPWorkers = m_WorkPool.GetNumWorkers();
+if((m_pSNPWorkers = new tsSNPWorker[m_NumSNPWorkers])==NULL)
 	{
-	if(pReadHit->NAR == eNARAccepted)
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessSNPs: Memory allocation for %d SNP workers failed",m_NumSNPWorkers);
+	Reset(false);
+	return(eBSFerrMem);
+	}
+memset(m_pSNPWorkers,0,sizeof(tsSNPWorker) * m_NumSNPWorkers);
+pWorker = m_pSNPWorkers;
+for(WorkerIdx = 0; WorkerIdx < m_NumSNPWorkers; WorkerIdx++,pWorker++)
+	{
+	if((pWorker->pReadSeq = new etSeqBase[cMaxFastQSeqLen+1])==NULL ||
+		(pWorker->pAssembSeq = new etSeqBase[cMaxFastQSeqLen+1])==NULL ||
+		(m_hSNPCentsfile != -1 && (pWorker->pCentroidInsts = new UINT32[cSNPCentroidEls])==NULL))
 		{
-		if(pReadHit->HitLoci.Hit.FlgInDel || pReadHit->HitLoci.Hit.FlgSplice)
-			continue;
-
-		pSeg = &pReadHit->HitLoci.Hit.Seg[0];
-		if(pSeg->ChromID != (UINT32)PrevTargEntry)
-			{
-			if(m_pChromSNPs != NULL)
-				{
-				// this is where the SNPs for the previously processed chrom need to saved off as new chrom is about to be processed
-				m_pChromSNPs->MeanReadLen = (UINT32)(((m_pChromSNPs->TotReadLen + m_pChromSNPs->NumReads - 1) / m_pChromSNPs->NumReads));
-				if((Rslt=OutputSNPs())!=eBSFSuccess)
-					{
-					Reset(false);
-					return(Rslt);
-					}
-				}
-
-    		PrevTargEntry = pSeg->ChromID;
-			ChromLen = m_pSfxArray->GetSeqLen(PrevTargEntry);
-			if(m_pChromSNPs == NULL || (m_pChromSNPs != NULL && (ChromLen + 16) > m_pChromSNPs->AllocChromLen))
-				{
-				if(m_pChromSNPs != NULL)
-					{
-					delete m_pChromSNPs;
-					m_pChromSNPs = NULL;
-					}
-				size_t AllocSize = sizeof(tsChromSNPs) + ((ChromLen + 16) * sizeof(tsSNPcnts));
-				if((m_pChromSNPs = (tsChromSNPs *)new UINT8[AllocSize])==NULL)
-					{
-					gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessSNPs: Memory allocation of %lld bytes - %s",(INT64)AllocSize,strerror(errno));
-					Reset(false);
-					return(eBSFerrMem);
-					}
-				m_pChromSNPs->AllocChromLen = ChromLen + 16;
-				}
-			memset(&m_pChromSNPs->Cnts,0,((ChromLen + 16) * sizeof(tsSNPcnts)));
-			m_pChromSNPs->ChromLen = (UINT32)ChromLen;
-			m_pChromSNPs->ChromID = pSeg->ChromID;
-			m_pChromSNPs->TotMatch = 0;
-			m_pChromSNPs->TotMismatch = 0;
-			m_pChromSNPs->MeanReadLen = 0;
-			m_pChromSNPs->NumReads = 0;
-			m_pChromSNPs->TotReadLen = 0;
-			m_pChromSNPs->AdjacentSNPs[0].StartLoci = 0;
-			m_pChromSNPs->AdjacentSNPs[0].EndLoci = 0;
-			m_pChromSNPs->AdjacentSNPs[0].pFirstIterReadHit = NULL;
-			m_pChromSNPs->AdjacentSNPs[0].pPrevIterReadHit = 0;
-			m_pChromSNPs->AdjacentSNPs[1].StartLoci = 0;
-			m_pChromSNPs->AdjacentSNPs[1].EndLoci = 0;
-			m_pChromSNPs->AdjacentSNPs[1].pFirstIterReadHit = NULL;
-			m_pChromSNPs->AdjacentSNPs[1].pPrevIterReadHit = 0;
-			m_pChromSNPs->pFirstReadHit = NULL;
-			m_pChromSNPs->pLastReadHit = NULL;
-			PrevTargEntry = m_pChromSNPs->ChromID;
-			PrevMMChromID = 0;
-			PrevMMLoci = -1;
-			}
-
-		// get target genome sequence
-		if(m_bIsSOLiD)
-			{
-			MatchLen = AdjHitLen(pSeg);
-			HitLoci = AdjStartLoci(pSeg);
-			HitLoci += 1;
-			MatchLen -= 1;
-			m_pSfxArray->GetColorspaceSeq(pSeg->ChromID,
-									HitLoci,
-									AssembSeq,MatchLen);	// get colorspace sequence
-
-
-			}
-		else
-			{
-			// get target assembly sequence for entry starting at offset and of length len
-			MatchLen = AdjHitLen(pSeg);
-			HitLoci = AdjStartLoci(pSeg);
-			m_pSfxArray->GetSeq(pSeg->ChromID,HitLoci,AssembSeq,MatchLen);
-			pAssembSeq = AssembSeq;
-			for(SeqIdx = 0; SeqIdx < MatchLen; SeqIdx++,pAssembSeq++)
-				*pAssembSeq = *pAssembSeq & 0x07;
-			}
-
-			// get accepted aligned read sequence
-		pSeqVal = &pReadHit->Read[pReadHit->DescrLen+1];
-		pSeqVal += pSeg->ReadOfs + pSeg->TrimLeft;
-		pReadSeq = ReadSeq;
-
-		if(m_bIsSOLiD)
-			{
-			// convert read sequence into colorspace
-			UINT8 PrvBase = *pSeqVal & 0x07;
-			for(SeqIdx = 1; SeqIdx <= MatchLen; SeqIdx++,pReadSeq++,pSeqVal++)
-				{
-				*pReadSeq = SOLiDmap[PrvBase][pSeqVal[1] & 0x07];
-				PrvBase = pSeqVal[1] & 0x07;
-				}
-			// reverse, not complement, sequence if hit was onto '-' strand
-			if(pSeg->Strand == '-')
-				CSeqTrans::ReverseSeq(MatchLen,ReadSeq);
-			}
-		else
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessSNPs: Memory allocation for SNP worker resources failed");
+		Reset(false);
+		return(eBSFerrMem);
+		}
+	if(pWorker->pCentroidInsts != NULL)
+		memset(pWorker->pCentroidInsts,0,sizeof(UINT32) * cSNPCentroidEls);
+	}
+if((m_pSNPChroms = new tsChromSNPs[m_NumSNPWorkers * cSNPChromsPerWorker])==NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessSNPs: Memory allocation for %d SNP chromosomes failed",m_NumSNPWorkers * cSNPChromsPerWorker);
+	Reset(false);
+	return(eBSFerrMem);
+	}
+m_AllocdSNPChroms = m_NumSNPWorkers * cSNPChromsPerWorker;
+memset(m_pSNPChroms,0,sizeof(tsChromSNPs) * m_AllocdSNPChroms);
+
+pReadHit = NULL;
+pChromSNPs = NULL;
+NumBatchChroms = 0;
+m_TotNumSNPs = 0;
+do {
+	if((pReadHit = IterSortedReads(pReadHit))!=NULL)
+		{
+		if(pReadHit->NAR != eNARAccepted || pReadHit->HitLoci.Hit.FlgInDel || pReadHit->HitLoci.Hit.FlgSplice)
+			continue;
+		pSeg = &pReadHit->HitLoci.Hit.Seg[0];
+		if(pChromSNPs != NULL && pSeg->ChromID == pChromSNPs->ChromID)	// extending the run of reads on current chromosome
 			{
-			for(SeqIdx = 0; SeqIdx < MatchLen; SeqIdx++,pReadSeq++,pSeqVal++)
-				*pReadSeq = *pSeqVal & 0x07;
-			if(pSeg->Strand == '-')
-				CSeqTrans::ReverseComplement(MatchLen,ReadSeq);
+			pChromSNPs->pEndReadHit = pReadHit;
+			continue;
 			}
+		}
 
-		// double check not about to update snp counts past the expected chrom length
-		if((HitLoci + MatchLen) > ChromLen)
+	// either no more reads or starting a new chromosome, if batch is full or no more reads then identify and report putative SNPs on batch chromosomes
+	if(NumBatchChroms > 0 && (pReadHit == NULL || NumBatchChroms == m_AllocdSNPChroms))
+		{
+		if((Rslt = m_WorkPool.Run(IdentifySNPsTask,this,NumBatchChroms,1)) < eBSFSuccess)
 			{
-			if((MatchLen = (int)ChromLen - HitLoci) < 10)
-				continue;
+			Reset(false);
+			return(Rslt);
 			}
-
-		if(m_pChromSNPs->pFirstReadHit == NULL)
-			m_pChromSNPs->pFirstReadHit = pReadHit;
-		m_pChromSNPs->pLastReadHit = pReadHit;
-		m_pChromSNPs->TotReadLen += MatchLen;
-		m_pChromSNPs->NumReads += 1;
-
-		// now iterate read bases and if mismatch then update appropriate counts
-		pSNP = &m_pChromSNPs->Cnts[HitLoci];
-		pAssembSeq = &AssembSeq[0];
-		pReadSeq = &ReadSeq[0];
-		UINT32 Loci = HitLoci;
-		bool bPairMM = false;
-		int SeqMM = 0;
-		for(SeqIdx = 0; SeqIdx < MatchLen; SeqIdx++, Loci++,pReadSeq++, pAssembSeq++,pSNP++)
+		for(ChromIdx = 0; ChromIdx < NumBatchChroms; ChromIdx++)
 			{
-			if(*pAssembSeq >= eBaseN || (m_bIsSOLiD && *pReadSeq >= eBaseN) || *pReadSeq > eBaseN)
-				{
-				SeqMM += 1;
-				continue;
-				}
-
-			if(m_bIsSOLiD)		// in colorspace, unpaired mismatches assumed to be sequencer errors and simply sloughed when identifying SNPs
-				{
-				if(Loci == 0)	// too problematic with SNPs in colorspace at the start of the target sequence, simply slough
-					continue;
-
-				if(!bPairMM && *pAssembSeq != *pReadSeq)
-					{
-					if(SeqIdx < (1+MatchLen))
-						{
-						if(pReadSeq[1] == pAssembSeq[1])
-							{
-							pSNP->NumRefBases += 1;
-							m_pChromSNPs->TotMatch += 1;
-							SeqMM += 1;
-							continue;
-							}
-						}
-
-					// get the previous target sequence base and use this + read colorspace space to derive the mismatch in basespace
-					if(pSeg->ChromID != PrevMMChromID || Loci != PrevMMLoci)
-						{
-						PrevMMChromID = pSeg->ChromID;
-						PrevMMLoci = Loci;
-						m_pSfxArray->GetSeq(pSeg->ChromID,Loci-1,&TargBases[0],2);
-						if(TargBases[0] > eBaseN)
-							TargBases[0] = eBaseN;
-						if(TargBases[1] > eBaseN)
-							TargBases[1] = eBaseN;
-						pSNP->RefBase = TargBases[1];
-						}
-
-					ReadBase = *pReadSeq;
-					if(ReadBase > eBaseT)
-						ReadBase = eBaseN;
-
-					if(SeqMM == 0)
-						ReadBase = SOLiDmap[TargBases[0]][ReadBase];
-					else
-						ReadBase = eBaseN;
-
-					// sometimes it seems that a colorspace read may have had a sequencing error earlier in the read
-					// or some mismatch such that the current loci mismatches in colorspace but matches in basespace
-					// these strange bases are treated as though they are undefined and accrue counts as being eBaseN's
-					if(ReadBase == pSNP->RefBase)
-						ReadBase = eBaseN;
-					pSNP->NonRefBaseCnts[ReadBase] += 1;
-					pSNP->NumNonRefBases += 1;
-					m_pChromSNPs->TotMismatch += 1;
-					bPairMM = true;
-					SeqMM += 1;
-					}
-				else
-					{
-					pSNP->NumRefBases += 1;
-					m_pChromSNPs->TotMatch += 1;
-					bPairMM = false;
-					SeqMM = 0;
-					}
-				}
-			else				// in basespace any mismatch is counted as a NonRefCnt
+			if((Rslt=OutputSNPs(&m_pSNPChroms[ChromIdx]))!=eBSFSuccess)
 				{
-				ReadBase = *pReadSeq & 0x07;
-				TargBases[0] = *pAssembSeq & 0x07;
-
-				pSNP->RefBase = TargBases[0];
-				if(TargBases[0] == ReadBase)
-					{
-					pSNP->NumRefBases += 1;
-					m_pChromSNPs->TotMatch += 1;
-					}
-				else
-					{
-					if(ReadBase > eBaseT)
-						ReadBase = eBaseN;
-					pSNP->NonRefBaseCnts[ReadBase] += 1;
-					pSNP->NumNonRefBases += 1;
-					m_pChromSNPs->TotMismatch += 1;
-					}
+				Reset(false);
+				return(Rslt);
 				}
 			}
+		NumBatchChroms = 0;
 		}
-	}
 
-if(m_pChromSNPs != NULL)
-	{
-	m_pChromSNPs->MeanReadLen = (UINT32)(((m_pChromSNPs->TotReadLen + m_pChromSNPs->NumReads - 1) / m_pChromSNPs->NumReads));
-	if((Rslt=OutputSNPs())!=eBSFSuccess)
+	if(pReadHit != NULL)
 		{
-		Reset(false);
-		return(Rslt);
+		pChromSNPs = &m_pSNPChroms[NumBatchChroms++];
+		pChromSNPs->ChromID = pSeg->ChromID;
+		pChromSNPs->ChromLen = m_pSfxArray->GetSeqLen(pSeg->ChromID);
+		pChromSNPs->pStartReadHit = pReadHit;
+		pChromSNPs->pEndReadHit = pReadHit;
 		}
 	}
+while(pReadHit != NULL);
+
+if(m_hSNPCentsfile != -1)
+	{
+	// sum the centroid instances counted by each worker
+	pWorker = m_pSNPWorkers;
+	for(WorkerIdx = 0; WorkerIdx < m_NumSNPWorkers; WorkerIdx++,pWorker++)
+		for(ChromIdx = 0; ChromIdx < cSNPCentroidEls; ChromIdx++)
+			m_pSNPCentroids[ChromIdx].NumInsts += pWorker->pCentroidInsts[ChromIdx];
+	}
+FreeSNPsMem();
+
 if(m_hSNPfile != -1)
 	{
 #ifdef _WIN32
@@ -8058,12 +8510,6 @@ if(m_hMarkerFile != -1)
 	close(m_hMarkerFile);
 	m_hMarkerFile = -1;
 	}
-
-if(m_pChromSNPs != NULL)
-	{
-	delete m_pChromSNPs;
-	m_pChromSNPs = NULL;
-	}
 return(eBSFSuccess);
 }
 
@@ -8626,25 +9072,6 @@ if(m_MLMode != eMLdefault)
 m_bMutexesCreated = false;
 }
 
-#ifdef _WIN32
-unsigned __stdcall CoredApproxThread(void * pThreadPars)
-#else
-void *CoredApproxThread(void * pThreadPars)
-#endif
-{
-int Rslt;
-tsThreadMatchPars *pPars = (tsThreadMatchPars *)pThreadPars; // makes it easier not having to deal with casts!
-CAligner *pAligner = (CAligner *)pPars->pThis;
-Rslt = pAligner->ProcCoredApprox(pPars);
-pPars->Rslt = Rslt;
-#ifdef _WIN32
-_endthreadex(Rslt < 0 ? 1 : 0);
-return(Rslt < 0 ? 1 : 0);
-#else
-pthread_exit(NULL);
-#endif
-}
-
 // LocateCoredApprox
 // Locates all cored approximates
 int
@@ -8666,7 +9093,7 @@ UINT32 PrevReadsLoaded;
 int MaxNumSlides;
 
 int ThreadIdx;
-tsThreadMatchPars WorkerThreads[cMaxWorkerThreads];
+tsThreadMatchPars *WorkerThreads;
 
 m_PerThreadAllocdIdentNodes = cMaxNumIdentNodes;
 m_TotAllocdIdentNodes = m_PerThreadAllocdIdentNodes * m_NumThreads;
@@ -8696,8 +9123,22 @@ if(m_MLMode == eMLall)
 else
 	m_pAllocsMultiHitBuff = NULL;
 
+// reads are aligned in rounds, each round at most cMaxReadsPerBlock reads per thread, allow a few blocks per thread so workers can balance load within rounds
+m_AllocdCoredApproxReads = m_NumThreads * cMaxReadsPerBlock * 4;
+if((m_ppCoredApproxReads = new tsReadHit * [m_AllocdCoredApproxReads])==NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Fatal: unable to allocate memory for %u read ptrs",m_AllocdCoredApproxReads);
+	Reset(false);
+	return(eBSFerrMem);
+	}
 
-
+if((m_pCoredApproxPars = new tsThreadMatchPars [m_NumThreads])==NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Fatal: unable to allocate memory for %d worker parameters",m_NumThreads);
+	Reset(false);
+	return(eBSFerrMem);
+	}
+WorkerThreads = m_pCoredApproxPars;
 
 // load single SfxBlock, expected to contain all chromosomes, and process all reads against that block
 PlusHits = 0;
@@ -8763,7 +9204,7 @@ m_MaxNumSlides = MaxNumSlides;
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Now aligning with minimum core size of %dbp...\n",m_MinCoreLen);
 m_ThreadCoredApproxRslt = 0;
 ResetThreadedIterReads();
-memset(WorkerThreads,0,sizeof(WorkerThreads));
+memset(WorkerThreads,0,sizeof(tsThreadMatchPars) * m_NumThreads);
 for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++)
 	{
 	WorkerThreads[ThreadIdx].ThreadIdx = ThreadIdx + 1;
@@ -8785,20 +9226,8 @@ for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++)
 	else
 		WorkerThreads[ThreadIdx].pszOutBuff = NULL;
 	WorkerThreads[ThreadIdx].OutBuffIdx = 0;
-#ifdef _WIN32
-	WorkerThreads[ThreadIdx].threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,CoredApproxThread,&WorkerThreads[ThreadIdx],0,&WorkerThreads[ThreadIdx].threadID);
-#else
-	WorkerThreads[ThreadIdx].threadRslt =	pthread_create (&WorkerThreads[ThreadIdx].threadID , NULL , CoredApproxThread , &WorkerThreads[ThreadIdx] );
-#endif
 	}
 
-// allow threads a few seconds to startup
-#ifdef _WIN32
-	Sleep(5000);
-#else
-	sleep(5);
-#endif
-
 UINT32 ReportProgressSecs;
 ReportProgressSecs = 60;
 if(m_SampleNthRawRead > 1)
@@ -8808,39 +9237,30 @@ if(m_SampleNthRawRead > 1)
 ApproxNumReadsProcessed(&PrevReadsProcessed,&PrevReadsLoaded);
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: %u reads aligned from %u loaded",PrevReadsProcessed,PrevReadsLoaded);
 
-// wait for all threads to have completed
+// reads are aligned by the work pool workers, round by round, until all reads loaded have been aligned
+RunCoredApproxRounds(ReportProgressSecs);
+
+// accumulate the per worker totals
 for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++)
 	{
-#ifdef _WIN32
-	while(WAIT_TIMEOUT == WaitForSingleObject( WorkerThreads[ThreadIdx].threadHandle, (DWORD)ReportProgressSecs * 1000))
-		{
-		ApproxNumReadsProcessed(&CurReadsProcessed,&CurReadsLoaded);
-		if(CurReadsProcessed > PrevReadsProcessed || CurReadsLoaded > PrevReadsLoaded)
-			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: %u reads aligned from %u loaded",CurReadsProcessed,CurReadsLoaded);
-		PrevReadsProcessed = CurReadsProcessed;
-		PrevReadsLoaded = CurReadsLoaded;
-		}
-	CloseHandle( WorkerThreads[ThreadIdx].threadHandle);
-#else
-	struct timespec ts;
-	int JoinRlt;
-	clock_gettime(CLOCK_REALTIME, &ts);
-	ts.tv_sec += ReportProgressSecs;
-	while((JoinRlt = pthread_timedjoin_np(WorkerThreads[ThreadIdx].threadID, NULL, &ts)) != 0)
-		{
-		ApproxNumReadsProcessed(&CurReadsProcessed,&CurReadsLoaded);
-		if(CurReadsProcessed > PrevReadsProcessed || CurReadsLoaded > PrevReadsLoaded)
-			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: %u reads aligned from %u loaded",CurReadsProcessed,CurReadsLoaded);
-		PrevReadsProcessed = CurReadsProcessed;
-		PrevReadsLoaded = CurReadsLoaded;
-		ts.tv_sec += ReportProgressSecs;
-		}
-
-#endif
 	PlusHits += WorkerThreads[ThreadIdx].PlusHits;
 	MinusHits += WorkerThreads[ThreadIdx].MinusHits;
 	ChimericHits += WorkerThreads[ThreadIdx].ChimericHits;
 	TotNumReadsProc += WorkerThreads[ThreadIdx].NumReadsProc;
+	m_NumSloughedNs += WorkerThreads[ThreadIdx].NumSloughedNs;
+	m_TotNonAligned += WorkerThreads[ThreadIdx].NumNonAligned;
+	m_TotAcceptedAsUniqueAligned += WorkerThreads[ThreadIdx].TotAcceptedAsUniqueAligned;
+	m_TotAcceptedAsMultiAligned += WorkerThreads[ThreadIdx].TotAcceptedAsMultiAligned;
+	m_TotAcceptedAsAligned += WorkerThreads[ThreadIdx].NumAcceptedAsAligned;
+	m_TotLociAligned += WorkerThreads[ThreadIdx].NumLociAligned;
+	m_TotNotAcceptedDelta += WorkerThreads[ThreadIdx].NumNotAcceptedDelta;
+	m_TotAcceptedHitInsts += WorkerThreads[ThreadIdx].NumAcceptedHitInsts;
+	if(m_MLMode != eMLall)
+		{
+		int Idx;
+		for(Idx = 0; Idx < m_MaxMLmatches; Idx++)
+			m_MultiHitDist[Idx] += WorkerThreads[ThreadIdx].MultiHitDist[Idx];
+		}
 
 	if(WorkerThreads[ThreadIdx].OutBuffIdx != 0)
 		{
@@ -8903,6 +9323,20 @@ if(m_ThreadLoadReadsRslt < 0 || m_ThreadCoredApproxRslt < 0)
 ApproxNumReadsProcessed(&CurReadsProcessed,&CurReadsLoaded);
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Alignment of %u from %u loaded completed",CurReadsProcessed,CurReadsLoaded);
 
+if(m_pSfxArray != NULL)
+	{
+	UINT64 KMerIdxLookups;
+	UINT64 KMerIdxHits;
+	int KMerIdxLen;
+	if((KMerIdxLen = m_pSfxArray->GetKMerIdxStats(&KMerIdxLookups,&KMerIdxHits)) > 0 && KMerIdxLookups == 0)	// lookups are only counted in debug builds
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"K-mer prefix index (%d-mers) was used to narrow exact match lookups",KMerIdxLen);
+	else if(KMerIdxLen > 0)
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"K-mer prefix index (%d-mers) narrowed %llu (%1.2f%%) of %llu exact match lookups",
+							KMerIdxLen,KMerIdxHits,KMerIdxLookups > 0 ? (100.0 * KMerIdxHits) / KMerIdxLookups : 0.0,KMerIdxLookups);
+	else
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"No k-mer prefix index in suffix array, exact match lookups were over the full suffix array");
+	}
+
 m_PerThreadAllocdIdentNodes = 0;
 m_TotAllocdIdentNodes = 0;
 if(m_pAllocsIdentNodes != NULL)
@@ -8922,6 +9356,18 @@ if(m_pAllocsMultiHitBuff != NULL)
 	m_pAllocsMultiHitBuff = NULL;
 	}
 
+if(m_ppCoredApproxReads != NULL)
+	{
+	delete m_ppCoredApproxReads;
+	m_ppCoredApproxReads = NULL;
+	}
+m_AllocdCoredApproxReads = 0;
+if(m_pCoredApproxPars != NULL)
+	{
+	delete m_pCoredApproxPars;
+	m_pCoredApproxPars = NULL;
+	}
+
 if((m_FMode == eFMsam || m_FMode == eFMsamAll) && m_MLMode == eMLall)
 	m_pszLineBuff[m_szLineBuffIdx] = '\0';
 
@@ -8939,8 +9385,13 @@ return(eBSFSuccess);
 
 
 
+// ProcCoredApprox
+// Align a range of reads, called by work pool workers with each worker having it's own pPars
+// Caller must hold a read lock through AcquireLock(false) for the duration so m_pReadHits can't be relocated
 int
-CAligner::ProcCoredApprox(tsThreadMatchPars *pPars)
+CAligner::ProcCoredApprox(tsThreadMatchPars *pPars,	// worker specific parameters and resources
+						tsReadHit **ppReadHits,		// reads to be aligned
+						int NumReads)				// number of reads in ppReadHits
 {
 etSeqBase Sequence[cMaxFastQSeqLen+1];	// to hold sequence (sans quality scores) for current read
 etSeqBase PrevSequence[cMaxFastQSeqLen+1];	// to hold sequence (sans quality scores) for previous read
@@ -8956,8 +9407,7 @@ int NumNs;
 UINT8 *pSeqVal;
 etSeqBase *pSeq;
 
-tsReadsHitBlock ReadsHitBlock;			// block of reads for this thread to process
-int ReadsHitIdx;						// index of current read in ReadsHitBlock.pReadsHits[]
+int ReadsHitIdx;						// index of current read in ppReadHits[]
 tsReadHit *pReadHit;					// current read being processed
 tsReadHit *pPrevReadHit;				// previous to current read
 
@@ -9000,16 +9450,10 @@ int MultiHitDist[cMaxMultiHits];		// used to record the multihit distribution
 
 // iterate each read sequence starting from the first
 // assumes that reads will have been sorted by ReadID
-pPars->PlusHits = 0;
-pPars->MinusHits = 0;
-pPars->ChimericHits = 0;
-pPars->NumReadsProc = 0;
 pReadHit = NULL;
 pPrevReadHit = NULL;
 PrevMatchLen = 0;
 NumSloughedNs = 0;
-ReadsHitBlock.MaxReads = cMaxReadsPerBlock;
-ReadsHitBlock.NumReads = 0;
 Rslt = 0;
 memset(MultiHitDist,0,sizeof(MultiHitDist));
 ExtdProcFlags = 0;
@@ -9018,512 +9462,498 @@ PrevMatchLen = 0;
 MaxIter = m_pSfxArray->GetMaxIter();
 
 
-// m_hRwLock will be released and regained within ThreadedIterReads so need to always have acquired a read lock before calling ThreadedIterReads
-AcquireLock(false);
 bForceNewAlignment = true;			
-while(ThreadedIterReads(&ReadsHitBlock))
-	{
-	Rslt = 0;
-	for(ReadsHitIdx = 0; ReadsHitIdx < ReadsHitBlock.NumReads; ReadsHitIdx++)
-		{
-		pReadHit = ReadsHitBlock.pReadHits[ReadsHitIdx];
-		pReadHit->NAR = eNARNoHit;			// assume unable to align read
-		pReadHit->FlgPEAligned = 0;
-		pReadHit->LowHitInstances = 0;
-		pReadHit->LowMMCnt = 0;
-		pReadHit->NumHits = 0;
-		pPars->NumReadsProc+=1;
-
-		// get sequence for read and remove any packed quality values
-		pSeqVal = &pReadHit->Read[pReadHit->DescrLen+1];
-		pSeq = Sequence;
-		NumNs = 0;
-		int MaxNsSeq = 0;		// maximum allowed for this sequence
-		if(m_MaxNs)
-			MaxNsSeq = max(((pReadHit->ReadLen * m_MaxNs) / 100),m_MaxNs);
-
-		for(SeqIdx = 0; SeqIdx < pReadHit->ReadLen; SeqIdx++,pSeq++,pSeqVal++)
+Rslt = 0;
+for(ReadsHitIdx = 0; ReadsHitIdx < NumReads; ReadsHitIdx++)
+	{
+	pReadHit = ppReadHits[ReadsHitIdx];
+	pReadHit->NAR = eNARNoHit;			// assume unable to align read
+	pReadHit->FlgPEAligned = 0;
+	pReadHit->LowHitInstances = 0;
+	pReadHit->LowMMCnt = 0;
+	pReadHit->NumHits = 0;
+	pPars->NumReadsProc+=1;
+
+	// get sequence for read and remove any packed quality values
+	pSeqVal = &pReadHit->Read[pReadHit->DescrLen+1];
+	pSeq = Sequence;
+	NumNs = 0;
+	int MaxNsSeq = 0;		// maximum allowed for this sequence
+	if(m_MaxNs)
+		MaxNsSeq = max(((pReadHit->ReadLen * m_MaxNs) / 100),m_MaxNs);
+
+	for(SeqIdx = 0; SeqIdx < pReadHit->ReadLen; SeqIdx++,pSeq++,pSeqVal++)
+		{
+		if((*pSeq = (*pSeqVal & 0x07)) > eBaseN)
+			break;
+		*pSeq &= ~cRptMskFlg;
+		if(*pSeq == eBaseN)
 			{
-			if((*pSeq = (*pSeqVal & 0x07)) > eBaseN)
+			if(++NumNs > MaxNsSeq)
 				break;
-			*pSeq &= ~cRptMskFlg;
-			if(*pSeq == eBaseN)
-				{
-				if(++NumNs > MaxNsSeq)
-					break;
-				}
-			}
-		if(SeqIdx != pReadHit->ReadLen) // if too many 'N's...
-			{
-			pPrevReadHit = NULL;
-			pReadHit->NAR = eNARNs;
-			PrevMatchLen = 0;
-			NumSloughedNs += 1;
-			continue;
 			}
+		}
+	if(SeqIdx != pReadHit->ReadLen) // if too many 'N's...
+		{
+		pPrevReadHit = NULL;
+		pReadHit->NAR = eNARNs;
+		PrevMatchLen = 0;
+		NumSloughedNs += 1;
+		continue;
+		}
 
-		if(m_bIsSOLiD)	// if SOLiD colorspace then need to convert read back into colorspace before attempting to locate
-			{
-			pSeq = Sequence;
-			UINT8 PrvBase = *pSeq;
-			for(SeqIdx = 1; SeqIdx < pReadHit->ReadLen; SeqIdx++,pSeq++)
-				{
-				*pSeq = SOLiDmap[PrvBase][pSeq[1]];
-				PrvBase = pSeq[1];
-				}
-			ProbeLen = pReadHit->ReadLen;
-			MatchLen = ProbeLen-1;
-			}
-		else
+	if(m_bIsSOLiD)	// if SOLiD colorspace then need to convert read back into colorspace before attempting to locate
+		{
+		pSeq = Sequence;
+		UINT8 PrvBase = *pSeq;
+		for(SeqIdx = 1; SeqIdx < pReadHit->ReadLen; SeqIdx++,pSeq++)
 			{
-			ProbeLen = pReadHit->ReadLen;
-			MatchLen = ProbeLen;
+			*pSeq = SOLiDmap[PrvBase][pSeq[1]];
+			PrvBase = pSeq[1];
 			}
+		ProbeLen = pReadHit->ReadLen;
+		MatchLen = ProbeLen-1;
+		}
+	else
+		{
+		ProbeLen = pReadHit->ReadLen;
+		MatchLen = ProbeLen;
+		}
 
-		// note: MaxSubs is specified by user as being per 100bp of read length, e.g. if user specified '-s5' and a read is 200bp then 
-		// 10 mismatches will be allowed for that specific read
-		MaxTotMM = pPars->MaxSubs == 0 ? 0 : max(1,(int)(0.5 + (MatchLen * pPars->MaxSubs)/100.0)); 
+	// note: MaxSubs is specified by user as being per 100bp of read length, e.g. if user specified '-s5' and a read is 200bp then 
+	// 10 mismatches will be allowed for that specific read
+	MaxTotMM = pPars->MaxSubs == 0 ? 0 : max(1,(int)(0.5 + (MatchLen * pPars->MaxSubs)/100.0)); 
 
-		if(MaxTotMM > cMaxTotAllowedSubs)		// irrespective of length allow at most this many subs
-			MaxTotMM = cMaxTotAllowedSubs;
+	if(MaxTotMM > cMaxTotAllowedSubs)		// irrespective of length allow at most this many subs
+		MaxTotMM = cMaxTotAllowedSubs;
 
-		// The window core length is set to be read length / (subs+1) for minimum Hamming difference of 1, and
-		// to be read length / (subs+2) for minimum Hamming difference of 2
-		// The window core length is clamped to be at least m_MinCoreLen
-		CoreLen = max(m_MinCoreLen,MatchLen/(pPars->MinEditDist == 1 ? MaxTotMM+1 : MaxTotMM+2));
-		MaxNumSlides = max(1,((pPars->MaxNumSlides * ProbeLen) + 99) / 100);
-		CoreDelta = max(ProbeLen/MaxNumSlides-1,CoreLen);
+	// The window core length is set to be read length / (subs+1) for minimum Hamming difference of 1, and
+	// to be read length / (subs+2) for minimum Hamming difference of 2
+	// The window core length is clamped to be at least m_MinCoreLen
+	CoreLen = max(m_MinCoreLen,MatchLen/(pPars->MinEditDist == 1 ? MaxTotMM+1 : MaxTotMM+2));
+	MaxNumSlides = max(1,((pPars->MaxNumSlides * ProbeLen) + 99) / 100);
+	CoreDelta = max(ProbeLen/MaxNumSlides-1,CoreLen);
 
-		LowHitInstances = pReadHit->LowHitInstances;
-		LowMMCnt = pReadHit->LowMMCnt;
-		NxtLowMMCnt = pReadHit->NxtLowMMCnt;
+	LowHitInstances = pReadHit->LowHitInstances;
+	LowMMCnt = pReadHit->LowMMCnt;
+	NxtLowMMCnt = pReadHit->NxtLowMMCnt;
 
-		ExtdProcFlags &= ~0x0001;			// no trace
+	ExtdProcFlags &= ~0x0001;			// no trace
 
-		// for priority alignments to known reference sequences (example would be cDNA transcripts assembled with a de Novo assembly) then
-		// a) align for exact matches allowing say 10 multiloci hits
-		// b) iterate these multiloci hits and discard any not aligning to a ref sequence
-		// c) process those aligning to reference as if these were uniquely aligning
-		int RefExacts = cPriorityExacts;
-		bool bProcNorm;
+	// for priority alignments to known reference sequences (example would be cDNA transcripts assembled with a de Novo assembly) then
+	// a) align for exact matches allowing say 10 multiloci hits
+	// b) iterate these multiloci hits and discard any not aligning to a ref sequence
+	// c) process those aligning to reference as if these were uniquely aligning
+	int RefExacts = cPriorityExacts;
+	bool bProcNorm;
 
-		if(m_pPriorityRegionBED != NULL)
-			RefExacts = cPriorityExacts;
-		else
-			RefExacts = 0;
-			
-		// Heuristic is that if read sequence is identical to previously processed sequence then
-		// simply reuse previously AlignReads() hit results - saves a lot of processing time
-		if(pPrevReadHit == NULL || bForceNewAlignment || MatchLen != PrevMatchLen || memcmp(Sequence,PrevSequence,MatchLen))
-			{
-			memset(pPars->pMultiHits,0,sizeof(tsHitLoci));
-			bProcNorm = true;
-			if(RefExacts > 0)
+	if(m_pPriorityRegionBED != NULL)
+		RefExacts = cPriorityExacts;
+	else
+		RefExacts = 0;
+		
+	// Heuristic is that if read sequence is identical to previously processed sequence then
+	// simply reuse previously AlignReads() hit results - saves a lot of processing time
+	if(pPrevReadHit == NULL || bForceNewAlignment || MatchLen != PrevMatchLen || memcmp(Sequence,PrevSequence,MatchLen))
+		{
+		memset(pPars->pMultiHits,0,sizeof(tsHitLoci));
+		bProcNorm = true;
+		if(RefExacts > 0)
+			{
+			HitRslt = m_pSfxArray->AlignReads(ExtdProcFlags,						// flags indicating if lower levels need to do any form of extended processing with this specific read...
+													pReadHit->ReadID,				// identifies this read
+													pPars->MinChimericLen,			// minimum chimeric length as a percentage (0 to disable, otherwise 50..99) of probe sequence
+													MaxTotMM,						// max number of mismatches allowed
+													CoreLen,						// core window length
+													CoreDelta,						// core window offset increment (1..n)
+													MaxNumSlides,					// limit on number of times core window can be moved or slide to right over read per 100bp of read length
+													pPars->MinCoreLen,				// minimum core length allowed
+													pPars->MinEditDist,				// minimum (1..n) mismatch difference between the best and next best core alignment
+													pPars->AlignStrand,				// watson, crick or both?
+													0,								// microInDel length maximum
+													0,								// maximum splice junction length when aligning RNAseq reads
+													&LowHitInstances,				// Out number of match instances for lowest number of mismatches thus far for this read
+													&LowMMCnt,						// Out lowest number of mismatches thus far for this read
+													&NxtLowMMCnt,					// Out next to lowest number of mismatches thus far for this read
+													Sequence,						// probe
+													MatchLen,						// probe length
+													m_MaxMLmatches+RefExacts,		// (IN) process for at most this number of hits
+													pPars->pMultiHits,				// where to return the loci for each hit by current read
+													pPars->NumIdentNodes,			// memory has been allocated by caller for holding up to this many tsIdentNodes
+													pPars->pIdentNodes);			// memory allocated by caller for holding tsIdentNodes
+
+			if(HitRslt == eHRhits && m_pPriorityRegionBED != NULL)
 				{
-				HitRslt = m_pSfxArray->AlignReads(ExtdProcFlags,						// flags indicating if lower levels need to do any form of extended processing with this specific read...
-														pReadHit->ReadID,				// identifies this read
-														pPars->MinChimericLen,			// minimum chimeric length as a percentage (0 to disable, otherwise 50..99) of probe sequence
-														MaxTotMM,						// max number of mismatches allowed
-														CoreLen,						// core window length
-														CoreDelta,						// core window offset increment (1..n)
-														MaxNumSlides,					// limit on number of times core window can be moved or slide to right over read per 100bp of read length
-														pPars->MinCoreLen,				// minimum core length allowed
-														pPars->MinEditDist,				// minimum (1..n) mismatch difference between the best and next best core alignment
-														pPars->AlignStrand,				// watson, crick or both?
-														0,								// microInDel length maximum
-														0,								// maximum splice junction length when aligning RNAseq reads
-														&LowHitInstances,				// Out number of match instances for lowest number of mismatches thus far for this read
-														&LowMMCnt,						// Out lowest number of mismatches thus far for this read
-														&NxtLowMMCnt,					// Out next to lowest number of mismatches thus far for this read
-														Sequence,						// probe
-														MatchLen,						// probe length
-														m_MaxMLmatches+RefExacts,		// (IN) process for at most this number of hits
-														pPars->pMultiHits,				// where to return the loci for each hit by current read
-														pPars->NumIdentNodes,			// memory has been allocated by caller for holding up to this many tsIdentNodes
-														pPars->pIdentNodes);			// memory allocated by caller for holding tsIdentNodes
-
-				if(HitRslt == eHRhits && m_pPriorityRegionBED != NULL)
+				int NumInPriorityRegions;
+				int NumInNonPriorityRegions;
+				tsHitLoci *pPriorityHits;
+
+				NumInPriorityRegions = 0;
+				NumInNonPriorityRegions = 0;
+				pHit = pPars->pMultiHits;
+				pPriorityHits = pHit;
+				for(HitIdx=0; HitIdx < min(LowHitInstances,m_MaxMLmatches+RefExacts); HitIdx++,pHit++)
 					{
-					int NumInPriorityRegions;
-					int NumInNonPriorityRegions;
-					tsHitLoci *pPriorityHits;
-
-					NumInPriorityRegions = 0;
-					NumInNonPriorityRegions = 0;
-					pHit = pPars->pMultiHits;
-					pPriorityHits = pHit;
-					for(HitIdx=0; HitIdx < min(LowHitInstances,m_MaxMLmatches+RefExacts); HitIdx++,pHit++)
+					// check if hit loci within region designated as being a priority exact matching region
+					if(m_pSfxArray->GetIdentName(pHit->Seg->ChromID,sizeof(szPriorityChromName),szPriorityChromName)!=eBSFSuccess)
 						{
-						// check if hit loci within region designated as being a priority exact matching region
-						if(m_pSfxArray->GetIdentName(pHit->Seg->ChromID,sizeof(szPriorityChromName),szPriorityChromName)!=eBSFSuccess)
-							{
-							NumInNonPriorityRegions += 1;
-							continue;
-							}
-						if((PriorityChromID = m_pPriorityRegionBED->LocateChromIDbyName(szPriorityChromName)) < 1)
-							{
-							NumInNonPriorityRegions += 1;
-							continue;
-							}
-						if(!m_pPriorityRegionBED->InAnyFeature(PriorityChromID,(int)pHit->Seg->MatchLoci,(int)(pHit->Seg->MatchLoci+pHit->Seg->MatchLen-1)))
-							{
-							NumInNonPriorityRegions += 1;
-							continue;
-							}
-						if(NumInNonPriorityRegions > 0)
-							*pPriorityHits++ = *pHit;
-						NumInPriorityRegions += 1;
+						NumInNonPriorityRegions += 1;
+						continue;
+						}
+					if((PriorityChromID = m_pPriorityRegionBED->LocateChromIDbyName(szPriorityChromName)) < 1)
+						{
+						NumInNonPriorityRegions += 1;
+						continue;
 						}
-					if(NumInPriorityRegions > 0 && (m_bClampMaxMLmatches || NumInPriorityRegions <= m_MaxMLmatches))
+					if(!m_pPriorityRegionBED->InAnyFeature(PriorityChromID,(int)pHit->Seg->MatchLoci,(int)(pHit->Seg->MatchLoci+pHit->Seg->MatchLen-1)))
 						{
-						if(NumInPriorityRegions > m_MaxMLmatches)
-							NumInPriorityRegions = m_MaxMLmatches;
-						LowHitInstances = NumInPriorityRegions;
-						bProcNorm = false;
+						NumInNonPriorityRegions += 1;
+						continue;
 						}
+					if(NumInNonPriorityRegions > 0)
+						*pPriorityHits++ = *pHit;
+					NumInPriorityRegions += 1;
 					}
-				if(bProcNorm)
+				if(NumInPriorityRegions > 0 && (m_bClampMaxMLmatches || NumInPriorityRegions <= m_MaxMLmatches))
 					{
-					LowHitInstances = pReadHit->LowHitInstances;
-					LowMMCnt = pReadHit->LowMMCnt;
-					NxtLowMMCnt = pReadHit->NxtLowMMCnt;
+					if(NumInPriorityRegions > m_MaxMLmatches)
+						NumInPriorityRegions = m_MaxMLmatches;
+					LowHitInstances = NumInPriorityRegions;
+					bProcNorm = false;
 					}
 				}
-			else
-				bProcNorm = true;
-
 			if(bProcNorm)
 				{
-				if(m_bLocateBestMatches)
-					{
-					HitRslt =						// < 0 if errors, 0 if no matches, 1..MaxHits, or MaxHits+1 if additional matches have been sloughed
-						m_pSfxArray->LocateBestMatches(pReadHit->ReadID,			// identifies this read
-											MaxTotMM,			        // return matches having at most this number of mismatches
-											CoreLen,					// core window length
-											CoreDelta,					// core window offset increment (1..n)
-											MaxNumSlides,				// max number of times to slide core on each strand
-											pPars->AlignStrand,			// watson, crick or both?
- 											Sequence,MatchLen,
-											m_MaxMLmatches,				// process for at most this many hits by current read
-											&LowHitInstances,			// returned number of match instances in pHits
-											pPars->pMultiHits,			// where to return the loci for each hit by current read
-											 MaxIter,					// max allowed iterations per subsegmented sequence when matching that subsegment
-											 pPars->NumIdentNodes,		// memory has been allocated by caller for holding up to this many tsIdentNodes
-											 pPars->pIdentNodes);		// memory allocated by caller for holding tsIdentNodes
-					if(HitRslt == 0)
-						HitRslt = eHRnone;
-					else
-						if(HitRslt >= 1)
-							HitRslt = eHRhits;
-					}
-				else
-					HitRslt = m_pSfxArray->AlignReads(ExtdProcFlags,					// flags indicating if lower levels need to do any form of extended processing with this specific read...
-														pReadHit->ReadID,				// identifies this read
-														pPars->MinChimericLen,			// minimum chimeric length as a percentage (0 to disable, otherwise 50..99) of probe sequence
-														MaxTotMM,CoreLen,CoreDelta,
-														MaxNumSlides,					// limit on number of times core window can be moved or slide to right over read per 100bp of read length
-														pPars->MinCoreLen,				// minimum core length allowed
-														pPars->MinEditDist,
-														pPars->AlignStrand,				// watson, crick or both?
-														pPars->microInDelLen,			// microInDel length maximum
-														pPars->SpliceJunctLen,			// maximum splice junction length when aligning RNAseq reads
-														&LowHitInstances,
-														&LowMMCnt,
-														&NxtLowMMCnt,
-														Sequence,MatchLen,
-														m_MaxMLmatches,					// process for at most this many hits by current read
-														pPars->pMultiHits,				// where to return the loci for each hit by current read
-														pPars->NumIdentNodes,
-														pPars->pIdentNodes);
+				LowHitInstances = pReadHit->LowHitInstances;
+				LowMMCnt = pReadHit->LowMMCnt;
+				NxtLowMMCnt = pReadHit->NxtLowMMCnt;
 				}
+			}
+		else
+			bProcNorm = true;
 
-			// user may be interested in multihits upto m_MaxMLmatches limit even if there were actually many more so in this case remap the hit result
-			if(LowHitInstances > m_MaxMLmatches)
-				LowHitInstances = m_MaxMLmatches + 1;
-			if(m_bClampMaxMLmatches && HitRslt == eHRHitInsts)
+		if(bProcNorm)
+			{
+			if(m_bLocateBestMatches)
 				{
-				LowHitInstances=m_MaxMLmatches;
-				HitRslt = eHRhits;
-				bForceNewAlignment = true;
+				HitRslt =						// < 0 if errors, 0 if no matches, 1..MaxHits, or MaxHits+1 if additional matches have been sloughed
+					m_pSfxArray->LocateBestMatches(pReadHit->ReadID,			// identifies this read
+										MaxTotMM,			        // return matches having at most this number of mismatches
+										CoreLen,					// core window length
+										CoreDelta,					// core window offset increment (1..n)
+										MaxNumSlides,				// max number of times to slide core on each strand
+										pPars->AlignStrand,			// watson, crick or both?
+ 											Sequence,MatchLen,
+										m_MaxMLmatches,				// process for at most this many hits by current read
+										&LowHitInstances,			// returned number of match instances in pHits
+										pPars->pMultiHits,			// where to return the loci for each hit by current read
+										 MaxIter,					// max allowed iterations per subsegmented sequence when matching that subsegment
+										 pPars->NumIdentNodes,		// memory has been allocated by caller for holding up to this many tsIdentNodes
+										 pPars->pIdentNodes);		// memory allocated by caller for holding tsIdentNodes
+				if(HitRslt == 0)
+					HitRslt = eHRnone;
+				else
+					if(HitRslt >= 1)
+						HitRslt = eHRhits;
 				}
-			PrevHitRslt = HitRslt;
-			PrevLowHitInstances = LowHitInstances;
-			PrevLowMMCnt = LowMMCnt;
-			PrevNxtLowMMCnt = NxtLowMMCnt;
-			PrevMatchLen = MatchLen;
-			pPrevReadHit = pReadHit;
-			memmove(PrevSequence,Sequence,MatchLen);
-			}
-		else		// else, identical sequence, reuse previous hit results from AlignReads
-			{
-			HitRslt = PrevHitRslt;
-			LowHitInstances = PrevLowHitInstances;
-			LowMMCnt = PrevLowMMCnt;
-			NxtLowMMCnt = PrevNxtLowMMCnt;
+			else
+				HitRslt = m_pSfxArray->AlignReads(ExtdProcFlags,					// flags indicating if lower levels need to do any form of extended processing with this specific read...
+													pReadHit->ReadID,				// identifies this read
+													pPars->MinChimericLen,			// minimum chimeric length as a percentage (0 to disable, otherwise 50..99) of probe sequence
+													MaxTotMM,CoreLen,CoreDelta,
+													MaxNumSlides,					// limit on number of times core window can be moved or slide to right over read per 100bp of read length
+													pPars->MinCoreLen,				// minimum core length allowed
+													pPars->MinEditDist,
+													pPars->AlignStrand,				// watson, crick or both?
+													pPars->microInDelLen,			// microInDel length maximum
+													pPars->SpliceJunctLen,			// maximum splice junction length when aligning RNAseq reads
+													&LowHitInstances,
+													&LowMMCnt,
+													&NxtLowMMCnt,
+													Sequence,MatchLen,
+													m_MaxMLmatches,					// process for at most this many hits by current read
+													pPars->pMultiHits,				// where to return the loci for each hit by current read
+													pPars->NumIdentNodes,
+													pPars->pIdentNodes);
+			}
+
+		// user may be interested in multihits upto m_MaxMLmatches limit even if there were actually many more so in this case remap the hit result
+		if(LowHitInstances > m_MaxMLmatches)
+			LowHitInstances = m_MaxMLmatches + 1;
+		if(m_bClampMaxMLmatches && HitRslt == eHRHitInsts)
+			{
+			LowHitInstances=m_MaxMLmatches;
+			HitRslt = eHRhits;
+			bForceNewAlignment = true;
+			}
+		PrevHitRslt = HitRslt;
+		PrevLowHitInstances = LowHitInstances;
+		PrevLowMMCnt = LowMMCnt;
+		PrevNxtLowMMCnt = NxtLowMMCnt;
+		PrevMatchLen = MatchLen;
+		pPrevReadHit = pReadHit;
+		memmove(PrevSequence,Sequence,MatchLen);
+		}
+	else		// else, identical sequence, reuse previous hit results from AlignReads
+		{
+		HitRslt = PrevHitRslt;
+		LowHitInstances = PrevLowHitInstances;
+		LowMMCnt = PrevLowMMCnt;
+		NxtLowMMCnt = PrevNxtLowMMCnt;
+		}
+
+	// if SOLiD colorspace then need to normalise the hits back to as if aligned in basespace
+	if(m_bIsSOLiD)
+		{
+		switch(HitRslt) {
+			case eHRHitInsts:
+				if(m_MLMode != eMLall)
+					break;
+			case eHRhits:
+				pHit = pPars->pMultiHits;
+				for(HitIdx=0; HitIdx <  min(LowHitInstances,m_MaxMLmatches); HitIdx++,pHit++)
+					{
+					pHit->Seg[0].MatchLoci -= 1;
+					pHit->Seg[0].MatchLen += 1;
+					if(pHit->FlgInDel == 1 || pHit->FlgSplice == 1)
+						pHit->Seg[1].ReadOfs += 1;
+					}
+				break;
+			default:
+				break;
 			}
+		}
 
-		// if SOLiD colorspace then need to normalise the hits back to as if aligned in basespace
-		if(m_bIsSOLiD)
+	// ensure that TrimLeft/Right/Mismatches are consistent with the fact that trimming is a post alignment phase
+	// if alignment was the result of a chimeric alignment then accept the flank trimming
+	if(HitRslt == eHRHitInsts ||  HitRslt == eHRhits)
+		{
+		pHit = pPars->pMultiHits;
+		for(HitIdx=0; HitIdx < min(LowHitInstances,m_MaxMLmatches); HitIdx++,pHit++)
 			{
-			switch(HitRslt) {
-				case eHRHitInsts:
-					if(m_MLMode != eMLall)
-						break;
-				case eHRhits:
-					pHit = pPars->pMultiHits;
-					for(HitIdx=0; HitIdx <  min(LowHitInstances,m_MaxMLmatches); HitIdx++,pHit++)
-						{
-						pHit->Seg[0].MatchLoci -= 1;
-						pHit->Seg[0].MatchLen += 1;
-						if(pHit->FlgInDel == 1 || pHit->FlgSplice == 1)
-							pHit->Seg[1].ReadOfs += 1;
-						}
-					break;
-				default:
-					break;
+			if(pHit->FlgChimeric != 1)
+				{
+				pHit->Seg[0].TrimLeft = 0;
+				pHit->Seg[0].TrimRight = 0;
+				}
+			pHit->Seg[0].TrimMismatches = pHit->Seg[0].Mismatches;
+			if(pHit->FlgInDel == 1 || pHit->FlgSplice == 1)
+				{
+				pHit->FlgChimeric = 0;
+				pHit->Seg[1].TrimLeft = 0;
+				pHit->Seg[1].TrimRight = 0;
+				pHit->Seg[1].TrimMismatches = pHit->Seg[1].Mismatches;
 				}
 			}
+		}
 
-		// ensure that TrimLeft/Right/Mismatches are consistent with the fact that trimming is a post alignment phase
-		// if alignment was the result of a chimeric alignment then accept the flank trimming
-		if(HitRslt == eHRHitInsts ||  HitRslt == eHRhits)
-			{
-			pHit = pPars->pMultiHits;
-			for(HitIdx=0; HitIdx < min(LowHitInstances,m_MaxMLmatches); HitIdx++,pHit++)
+	Rslt = 0;
+	switch(HitRslt) {
+		case eHRnone:			// no change or no hits
+			pReadHit->NAR = eNARNoHit;
+			pReadHit->LowMMCnt = 0;
+			pReadHit->NumHits = 0;
+			pReadHit->LowHitInstances = 0;
+			pReadHit->HitLoci.Hit.FlgChimeric = 0;
+			if(m_FMode == eFMsamAll)
 				{
-				if(pHit->FlgChimeric != 1)
-					{
-					pHit->Seg[0].TrimLeft = 0;
-					pHit->Seg[0].TrimRight = 0;
-					}
-				pHit->Seg[0].TrimMismatches = pHit->Seg[0].Mismatches;
-				if(pHit->FlgInDel == 1 || pHit->FlgSplice == 1)
-					{
-					pHit->FlgChimeric = 0;
-					pHit->Seg[1].TrimLeft = 0;
-					pHit->Seg[1].TrimRight = 0;
-					pHit->Seg[1].TrimMismatches = pHit->Seg[1].Mismatches;
-					}
+				pReadHit->LowMMCnt = (INT8)0;
+				if((Rslt = WriteHitLoci(pPars,pReadHit,0,pPars->pMultiHits)) < 0)
+					break;
 				}
-			}
+			NumNonAligned += 1;
+			bForceNewAlignment = false;
+			break;
 
-		Rslt = 0;
-		switch(HitRslt) {
-			case eHRnone:			// no change or no hits
-				pReadHit->NAR = eNARNoHit;
-				pReadHit->LowMMCnt = 0;
-				pReadHit->NumHits = 0;
-				pReadHit->LowHitInstances = 0;
-				pReadHit->HitLoci.Hit.FlgChimeric = 0;
-				if(m_FMode == eFMsamAll)
-					{
-					pReadHit->LowMMCnt = (INT8)0;
-					if((Rslt = WriteHitLoci(pPars,pReadHit,0,pPars->pMultiHits)) < 0)
-						break;
-					}
-				NumNonAligned += 1;
+		case eHRhits:			// MMDelta criteria met and within the max allowed number of hits
+			if(LowHitInstances > 1)
+				bForceNewAlignment = true;
+			else
 				bForceNewAlignment = false;
-				break;
 
-			case eHRhits:			// MMDelta criteria met and within the max allowed number of hits
-				if(LowHitInstances > 1)
-					bForceNewAlignment = true;
-				else
-					bForceNewAlignment = false;
-
-				pReadHit->NAR = eNARAccepted;
-				if(m_MLMode == eMLall)
-					{
-					int NumWriteHitLoci;
-					// report each hit here...
-					pReadHit->LowMMCnt = (INT8)LowMMCnt;
-					if((Rslt = NumWriteHitLoci = WriteHitLoci(pPars,pReadHit,LowHitInstances,pPars->pMultiHits)) < 0)
-						break;
-					if(NumWriteHitLoci)
-						{
-						NumAcceptedAsAligned += 1;
-						NumLociAligned += NumWriteHitLoci;
-						if(NumWriteHitLoci == 1)
-							TotAcceptedAsUniqueAligned += 1;
-						else
-							TotAcceptedAsMultiAligned += 1;
-						}
-					HitRslt = eHRHitInsts;
+			pReadHit->NAR = eNARAccepted;
+			if(m_MLMode == eMLall)
+				{
+				int NumWriteHitLoci;
+				// report each hit here...
+				pReadHit->LowMMCnt = (INT8)LowMMCnt;
+				if((Rslt = NumWriteHitLoci = WriteHitLoci(pPars,pReadHit,LowHitInstances,pPars->pMultiHits)) < 0)
 					break;
+				if(NumWriteHitLoci)
+					{
+					NumAcceptedAsAligned += 1;
+					NumLociAligned += NumWriteHitLoci;
+					if(NumWriteHitLoci == 1)
+						TotAcceptedAsUniqueAligned += 1;
+					else
+						TotAcceptedAsMultiAligned += 1;
 					}
+				HitRslt = eHRHitInsts;
+				break;
+				}
 
-				NumAcceptedAsAligned += 1;
-				NumLociAligned += LowHitInstances;
+			NumAcceptedAsAligned += 1;
+			NumLociAligned += LowHitInstances;
 
-				if(LowHitInstances == 1)
-					TotAcceptedAsUniqueAligned += 1;
-				else
-					TotAcceptedAsMultiAligned += 1;
+			if(LowHitInstances == 1)
+				TotAcceptedAsUniqueAligned += 1;
+			else
+				TotAcceptedAsMultiAligned += 1;
 
 
-				MultiHitDist[LowHitInstances-1] += 1;
-				if(m_MLMode == eMLrand)
-					RandIdx = m_MaxMLmatches == 1 ? 0 : (rand() % LowHitInstances);
-				else
-					RandIdx = 0;
-				if(m_MLMode <= eMLrand || LowHitInstances == 1)
+			MultiHitDist[LowHitInstances-1] += 1;
+			if(m_MLMode == eMLrand)
+				RandIdx = m_MaxMLmatches == 1 ? 0 : (rand() % LowHitInstances);
+			else
+				RandIdx = 0;
+			if(m_MLMode <= eMLrand || LowHitInstances == 1)
+				{
+				if((m_MLMode == eMLdist && LowHitInstances == 1) || m_MLMode != eMLdist)
 					{
-					if((m_MLMode == eMLdist && LowHitInstances == 1) || m_MLMode != eMLdist)
-						{
-						if(LowHitInstances == 1)	// was this a unique hit?
-							pReadHit->HitLoci.FlagHL = (int)eHLunique;
-						else
-							pReadHit->HitLoci.FlagHL = (int)eHLrandom;
-						LowHitInstances = 1;			// currently just accepting one
-						pReadHit->NumHits = 1;
-						pReadHit->HitLoci.Hit = pPars->pMultiHits[RandIdx];
-						pReadHit->HitLoci.FlagSegs = (pReadHit->HitLoci.Hit.FlgInDel == 1 || pReadHit->HitLoci.Hit.FlgSplice == 1) ? 1 : 0;
-						}
+					if(LowHitInstances == 1)	// was this a unique hit?
+						pReadHit->HitLoci.FlagHL = (int)eHLunique;
 					else
-						{
-						pReadHit->NAR = eNARMultiAlign;
-						pReadHit->NumHits = 0;
-						}
+						pReadHit->HitLoci.FlagHL = (int)eHLrandom;
+					LowHitInstances = 1;			// currently just accepting one
+					pReadHit->NumHits = 1;
+					pReadHit->HitLoci.Hit = pPars->pMultiHits[RandIdx];
+					pReadHit->HitLoci.FlagSegs = (pReadHit->HitLoci.Hit.FlgInDel == 1 || pReadHit->HitLoci.Hit.FlgSplice == 1) ? 1 : 0;
+					}
+				else
+					{
+					pReadHit->NAR = eNARMultiAlign;
+					pReadHit->NumHits = 0;
+					}
+				}
+			else
+				if(LowHitInstances == 1)
+					{
+					pReadHit->NAR = eNARAccepted;
+					pReadHit->NumHits = 1;
 					}
 				else
-					if(LowHitInstances == 1)
-						{
-						pReadHit->NAR = eNARAccepted;
-						pReadHit->NumHits = 1;
-						}
-					else
-						{
-						pReadHit->NAR = eNARMultiAlign;
-						pReadHit->NumHits = 0;
-						}
-
-				pReadHit->LowHitInstances = (INT16)LowHitInstances;
-				pReadHit->LowMMCnt = (INT8)LowMMCnt;
-				pReadHit->NxtLowMMCnt = (INT8)NxtLowMMCnt;
-// handling multiply aligned reads
-				if(m_MLMode > eMLrand)
 					{
-					int HitIdx;
-					tsHitLoci *pHit;
-					tsReadHit *pMHit;
-					pHit = pPars->pMultiHits;
-					pMHit = &HitReads[0];
-					for(HitIdx=0; HitIdx < LowHitInstances; HitIdx++,pMHit++,pHit++)
-						{
-						memcpy(pMHit,pReadHit,sizeof(tsReadHit));
-						pMHit->FlgPEAligned = false;
-						pMHit->HitLoci.Hit = *pHit;
-						pMHit->HitLoci.FlagSegs = (pMHit->HitLoci.Hit.FlgInDel == 1 || pMHit->HitLoci.Hit.FlgSplice == 1) ? 1 : 0;
-						pMHit->HitLoci.FlagMH = LowHitInstances > 1 ? 1 : 0;
-						pMHit->HitLoci.FlagMHA = 0;
-						}
-					if((Rslt=AddMHitReads(LowHitInstances,&HitReads[0])) < 0)		// pts to array of hit loci
-						break;
+					pReadHit->NAR = eNARMultiAlign;
+					pReadHit->NumHits = 0;
 					}
-// finish handling multiply aligned reads
-				break;
-
-			case eHRMMDelta:			// same or a new LowMMCnt unique hit but MMDelta criteria not met
-				NumNotAcceptedDelta += 1;
-				memset(&pReadHit->HitLoci.Hit.Seg[0],0,sizeof(tsSegLoci));
-				pReadHit->NAR = eNARMMDelta;
-				pReadHit->NumHits = 0;
-				pReadHit->HitLoci.Hit.Seg[0].Strand = '?';
-				pReadHit->HitLoci.Hit.BisBase = eBaseN;
-				pReadHit->HitLoci.Hit.Seg[0].MatchLen = (UINT16)ProbeLen;
-				pReadHit->LowHitInstances = (INT16)LowHitInstances;
-				pReadHit->LowMMCnt = (INT8)LowMMCnt;
-				pReadHit->NxtLowMMCnt = (INT8)NxtLowMMCnt;
-				bForceNewAlignment = false;
-				break;
 
-			case eHRHitInsts:			// same or new LowMMCnt but now simply too many multiple hit instances, treat as none-aligned
-				pReadHit->NAR = eNARMultiAlign;
-				if(m_MLMode == eMLall && m_FMode == eFMsamAll)
+			pReadHit->LowHitInstances = (INT16)LowHitInstances;
+			pReadHit->LowMMCnt = (INT8)LowMMCnt;
+			pReadHit->NxtLowMMCnt = (INT8)NxtLowMMCnt;
+// handling multiply aligned reads
+			if(m_MLMode > eMLrand)
+				{
+				int HitIdx;
+				tsHitLoci *pHit;
+				tsReadHit *pMHit;
+				pHit = pPars->pMultiHits;
+				pMHit = &HitReads[0];
+				for(HitIdx=0; HitIdx < LowHitInstances; HitIdx++,pMHit++,pHit++)
 					{
-					pReadHit->LowMMCnt = (INT8)0;
-					if((Rslt = WriteHitLoci(pPars,pReadHit,0,pPars->pMultiHits)) < 0)
-						break;
+					memcpy(pMHit,pReadHit,sizeof(tsReadHit));
+					pMHit->FlgPEAligned = false;
+					pMHit->HitLoci.Hit = *pHit;
+					pMHit->HitLoci.FlagSegs = (pMHit->HitLoci.Hit.FlgInDel == 1 || pMHit->HitLoci.Hit.FlgSplice == 1) ? 1 : 0;
+					pMHit->HitLoci.FlagMH = LowHitInstances > 1 ? 1 : 0;
+					pMHit->HitLoci.FlagMHA = 0;
 					}
-				NumNonAligned += 1;
-				bForceNewAlignment = false;
-				break;
-
-			case eHRRMMDelta:			// reduced NxtLowMMCnt only
-				pReadHit->NxtLowMMCnt = (INT8)NxtLowMMCnt;
-				bForceNewAlignment = false;
-				break;
-			}
-
-		if(Rslt < 0)
-			{
-			ReleaseLock(false);
-			AcquireSerialise();
-			m_ThreadCoredApproxRslt = Rslt;
-			ReleaseSerialise(); 
-			return(-1);
-			}
-			
+				if((Rslt=AddMHitReads(LowHitInstances,&HitReads[0])) < 0)		// pts to array of hit loci
+					break;
+				}
+// finish handling multiply aligned reads
+			break;
 
-		if(HitRslt == eHRHitInsts)
-			{
-			pReadHit->NumHits = 0;
-			pReadHit->NAR = eNARMultiAlign;
+		case eHRMMDelta:			// same or a new LowMMCnt unique hit but MMDelta criteria not met
+			NumNotAcceptedDelta += 1;
 			memset(&pReadHit->HitLoci.Hit.Seg[0],0,sizeof(tsSegLoci));
+			pReadHit->NAR = eNARMMDelta;
+			pReadHit->NumHits = 0;
 			pReadHit->HitLoci.Hit.Seg[0].Strand = '?';
 			pReadHit->HitLoci.Hit.BisBase = eBaseN;
 			pReadHit->HitLoci.Hit.Seg[0].MatchLen = (UINT16)ProbeLen;
 			pReadHit->LowHitInstances = (INT16)LowHitInstances;
 			pReadHit->LowMMCnt = (INT8)LowMMCnt;
 			pReadHit->NxtLowMMCnt = (INT8)NxtLowMMCnt;
-			}
+			bForceNewAlignment = false;
+			break;
 
-		// if SOLiD colorspace then need to restore any hits to what they were immediately following return from AlignReads
-		// as when SOLiD processing MatchLoci/MatchLen and ReadOfs would have all been normalised as if basespace processing and if
-		// a duplicate of this read sequence follows then hits will be simply reused w/o the overhead of a call to AlignReads
-		if(m_bIsSOLiD)
-			{
-			switch(HitRslt) {
-				case eHRHitInsts:
-					if(m_MLMode != eMLall)
-						break;
-				case eHRhits:
-					pHit = pPars->pMultiHits;
-					for(HitIdx=0; HitIdx <  min(LowHitInstances,m_MaxMLmatches); HitIdx++,pHit++)
-						{
-						pHit->Seg[0].MatchLoci += 1;
-						pHit->Seg[0].MatchLen -= 1;
-						if(pHit->FlgInDel == 1 || pHit->FlgSplice == 1)
-							pHit->Seg[1].ReadOfs -= 1;
-						}
-					break;
-				default:
+		case eHRHitInsts:			// same or new LowMMCnt but now simply too many multiple hit instances, treat as none-aligned
+			pReadHit->NAR = eNARMultiAlign;
+			if(m_MLMode == eMLall && m_FMode == eFMsamAll)
+				{
+				pReadHit->LowMMCnt = (INT8)0;
+				if((Rslt = WriteHitLoci(pPars,pReadHit,0,pPars->pMultiHits)) < 0)
 					break;
 				}
+			NumNonAligned += 1;
+			bForceNewAlignment = false;
+			break;
+
+		case eHRRMMDelta:			// reduced NxtLowMMCnt only
+			pReadHit->NxtLowMMCnt = (INT8)NxtLowMMCnt;
+			bForceNewAlignment = false;
+			break;
+		}
+
+	if(Rslt < 0)
+		return(Rslt);			// work pool will hand out no further reads and the master sets m_ThreadCoredApproxRslt
+		
+
+	if(HitRslt == eHRHitInsts)
+		{
+		pReadHit->NumHits = 0;
+		pReadHit->NAR = eNARMultiAlign;
+		memset(&pReadHit->HitLoci.Hit.Seg[0],0,sizeof(tsSegLoci));
+		pReadHit->HitLoci.Hit.Seg[0].Strand = '?';
+		pReadHit->HitLoci.Hit.BisBase = eBaseN;
+		pReadHit->HitLoci.Hit.Seg[0].MatchLen = (UINT16)ProbeLen;
+		pReadHit->LowHitInstances = (INT16)LowHitInstances;
+		pReadHit->LowMMCnt = (INT8)LowMMCnt;
+		pReadHit->NxtLowMMCnt = (INT8)NxtLowMMCnt;
+		}
+
+	// if SOLiD colorspace then need to restore any hits to what they were immediately following return from AlignReads
+	// as when SOLiD processing MatchLoci/MatchLen and ReadOfs would have all been normalised as if basespace processing and if
+	// a duplicate of this read sequence follows then hits will be simply reused w/o the overhead of a call to AlignReads
+	if(m_bIsSOLiD)
+		{
+		switch(HitRslt) {
+			case eHRHitInsts:
+				if(m_MLMode != eMLall)
+					break;
+			case eHRhits:
+				pHit = pPars->pMultiHits;
+				for(HitIdx=0; HitIdx <  min(LowHitInstances,m_MaxMLmatches); HitIdx++,pHit++)
+					{
+					pHit->Seg[0].MatchLoci += 1;
+					pHit->Seg[0].MatchLen -= 1;
+					if(pHit->FlgInDel == 1 || pHit->FlgSplice == 1)
+						pHit->Seg[1].ReadOfs -= 1;
+					}
+				break;
+			default:
+				break;
 			}
 		}
 	}
 
-ReleaseLock(false);
-AcquireSerialise();
-m_NumSloughedNs += NumSloughedNs;
-m_TotNonAligned += NumNonAligned;
-m_TotAcceptedAsUniqueAligned += TotAcceptedAsUniqueAligned;
-m_TotAcceptedAsMultiAligned += TotAcceptedAsMultiAligned;
-m_TotAcceptedAsAligned += NumAcceptedAsAligned;
-m_TotLociAligned += NumLociAligned;
-m_TotNotAcceptedDelta += NumNotAcceptedDelta;
-m_TotAcceptedHitInsts += NumAcceptedHitInsts;
+// accumulate into this worker's totals, master will update class instance totals once all reads aligned
+pPars->NumSloughedNs += NumSloughedNs;
+pPars->NumNonAligned += NumNonAligned;
+pPars->TotAcceptedAsUniqueAligned += TotAcceptedAsUniqueAligned;
+pPars->TotAcceptedAsMultiAligned += TotAcceptedAsMultiAligned;
+pPars->NumAcceptedAsAligned += NumAcceptedAsAligned;
+pPars->NumLociAligned += NumLociAligned;
+pPars->NumNotAcceptedDelta += NumNotAcceptedDelta;
+pPars->NumAcceptedHitInsts += NumAcceptedHitInsts;
 
 if(m_MLMode != eMLall)
 	{
 	int Idx;
 	for(Idx = 0; Idx < m_MaxMLmatches; Idx++)
-		m_MultiHitDist[Idx] += MultiHitDist[Idx];
+		pPars->MultiHitDist[Idx] += MultiHitDist[Idx];
 	}
-
-ReleaseSerialise();
-return(1);
+return(eBSFSuccess);
 }
 
 // LocateRead
@@ -9603,11 +10033,10 @@ return((int)NumHits);
 }
 
 
-// ThreadedIterReads
-// use to return a block of reads reserved for processing by calling thread instance
-// Returns false if no more reads available for processing
+// ResetThreadedIterReads
+// reset reads processing state prior to aligning reads
 void
-CAligner::ResetThreadedIterReads(void) // must be called by master thread prior to worker threads calling ThreadedIterReads()
+CAligner::ResetThreadedIterReads(void) // must be called by master thread prior to aligning reads
 {
 m_NumReadsProc = 0;
 m_NxtReadProcOfs = 0;
@@ -9629,78 +10058,119 @@ ReleaseSerialise();
 return(NumReadsProc);
 }
 
-// ThreadedIterReads
-// Iterates over all reads
-// The body of this function is serialised
-bool	// returns false if no more reads availing for processing by calling thread
-CAligner::ThreadedIterReads(tsReadsHitBlock *pRetBlock)
+// CoredApproxTask
+// Work pool function aligning reads [From,Until) in m_ppCoredApproxReads[] using the parameters and resources specific to WorkerIdx
+int
+CAligner::CoredApproxTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until)
+{
+CAligner *pThis = (CAligner *)pCtx;
+return(pThis->ProcCoredApprox(&pThis->m_pCoredApproxPars[WorkerIdx],&pThis->m_ppCoredApproxReads[From],(int)(Until - From)));
+}
+
+// RunCoredApproxRounds
+// Aligns all reads as they are loaded, in rounds. Each round takes the reads loaded but not yet aligned, up to m_AllocdCoredApproxReads,
+// which are then aligned by the work pool workers with workers stealing reads from each other so a few slow reads don't hold up the round.
+// A read lock is held for the duration of each round so m_pReadHits can't be relocated by the reads loader, workers themselves never serialise.
+int		// returns eBSFSuccess or the first error result
+CAligner::RunCoredApproxRounds(UINT32 ReportProgressSecs)	// report progress at this interval
 {
+int Rslt;
 UINT32 NumReadsLeft;
-UINT32 MaxReads2Proc;
+UINT32 MinRoundReads;
+UINT32 NumRoundReads;
 UINT32 AdjReadsPerBlock;
 tsReadHit *pCurReadHit;
-pRetBlock->NumReads = 0;
+size_t BlockStartOfs;
+int StreamBlkIdx;
+unsigned long PrevReportSecs;
+unsigned long CurSecs;
+UINT32 CurReadsProcessed;
+UINT32 CurReadsLoaded;
 
 AdjReadsPerBlock = cMaxReadsPerBlock;
 if(m_SampleNthRawRead > 1)
 	AdjReadsPerBlock = min(100,AdjReadsPerBlock/m_SampleNthRawRead);
-
-ReleaseLock(false);
+// start a round as soon as there are sufficient reads for each worker to have a block
+MinRoundReads = min(AdjReadsPerBlock * (UINT32)m_NumThreads,m_AllocdCoredApproxReads);
+PrevReportSecs = gStopWatch.ReadUSecs();
+Rslt = eBSFSuccess;
 while(1) {
-	AcquireSerialise();
-	AcquireLock(false);
-	if(m_bAllReadsLoaded || ((m_NumReadsLoaded - m_NumReadsProc) >= (UINT32)min(AdjReadsPerBlock,(UINT32)pRetBlock->MaxReads)) || m_ThreadCoredApproxRslt < 0)
-    	break;
+	while(1) {
+		AcquireSerialise();
+		AcquireLock(false);
+		if(m_ThreadCoredApproxRslt < 0)
+			break;
+		// when streaming, and the reads loader is stalled waiting for reads to be written out, then accept whatever reads remain to be aligned
+		if((m_StreamBatchReads == 0 || m_NumStreamBlocks < cMaxStreamBlocks) &&
+			(m_bAllReadsLoaded || ((m_NumReadsLoaded - m_NumReadsProc) >= MinRoundReads) ||
+				(m_bStreamLoadStalled && m_NumReadsLoaded > m_NumReadsProc)))
+    		break;
 
-	ReleaseLock(false);
-	ReleaseSerialise();
+		ReleaseLock(false);
+		ReleaseSerialise();
 #ifdef _WIN32
-	Sleep(2000);			// must have caught up to the reads loader, allow it some breathing space to parse and load some more reads...
+		Sleep(2000);			// must have caught up to the reads loader, allow it some breathing space to parse and load some more reads...
 #else
-	sleep(2);
+		sleep(2);
 #endif
-	}
+		}
 
-if(m_pReadHits == NULL ||
-	m_ThreadCoredApproxRslt < 0 ||
-	(m_bAllReadsLoaded && (m_LoadReadsRslt != eBSFSuccess)) ||
-	m_bAllReadsLoaded && (m_NumReadsLoaded == 0 || m_NumReadsProc == m_NumReadsLoaded)) // if all reads have been loaded and all processed then time to move onto next processing phase
-	{
-	pRetBlock->NumReads = 0;
-	pRetBlock->pReadHits[0] = NULL;
-	ReleaseSerialise();
-	return(false);
-	}
+	if(m_pReadHits == NULL ||
+		m_ThreadCoredApproxRslt < 0 ||
+		(m_bAllReadsLoaded && (m_LoadReadsRslt != eBSFSuccess)) ||
+		m_bAllReadsLoaded && (m_NumReadsLoaded == 0 || m_NumReadsProc == m_NumReadsLoaded)) // if all reads have been loaded and all processed then time to move onto next processing phase
+		{
+		Rslt = m_ThreadCoredApproxRslt < 0 ? m_ThreadCoredApproxRslt : eBSFSuccess;
+		ReleaseLock(false);
+		ReleaseSerialise();
+		break;
+		}
 
-// adjust pRetBlock->MaxReads according to the number of reads remaining and threads still processing these reads
-// idea is to maximise the number of threads still processing when most reads have been processed so that
-// the last thread processing doesn't end up with a large block of reads needing lengthly processing
-NumReadsLeft = m_NumReadsLoaded - m_NumReadsProc;
-if(NumReadsLeft < AdjReadsPerBlock/4)	// if < cMaxReadsPerBlock/4 yet to be processed then give it all to the one thread
-	MaxReads2Proc = NumReadsLeft;
-else
-	{
-	MaxReads2Proc = min((UINT32)pRetBlock->MaxReads,10 + (NumReadsLeft / (UINT32)m_NumThreads));
-	// assume PE processing so ensure MaxReads2Proc is a multiple of 2
- 	MaxReads2Proc &= ~0x01;
-	}
-MaxReads2Proc = min(MaxReads2Proc,NumReadsLeft);
-if(!m_NumReadsProc)
-	m_NxtReadProcOfs = 0;
-pCurReadHit = (tsReadHit *)((UINT8 *)m_pReadHits + m_NxtReadProcOfs);
+	NumReadsLeft = m_NumReadsLoaded - m_NumReadsProc;
+	NumRoundReads = min(NumReadsLeft,m_AllocdCoredApproxReads);	// m_AllocdCoredApproxReads is a multiple of 2 so PE reads stay in the same round
+	if(!m_NumReadsProc)
+		m_NxtReadProcOfs = 0;
+	BlockStartOfs = m_NxtReadProcOfs;
+	pCurReadHit = (tsReadHit *)((UINT8 *)m_pReadHits + m_NxtReadProcOfs);
+	for(UINT32 ReadIdx = 0; ReadIdx < NumRoundReads; ReadIdx++)
+		{
+		m_ppCoredApproxReads[ReadIdx] = pCurReadHit;
+		pCurReadHit = (tsReadHit *)((UINT8 *)pCurReadHit + sizeof(tsReadHit) + pCurReadHit->ReadLen + pCurReadHit->DescrLen);
+		}
+	m_NumReadsProc += NumRoundReads;
+	m_NxtReadProcOfs = (size_t)((UINT8 *)pCurReadHit - (UINT8 *)m_pReadHits);
 
-while(MaxReads2Proc)
-	{
-	pRetBlock->pReadHits[pRetBlock->NumReads++] = pCurReadHit;
-	pCurReadHit = (tsReadHit *)((UINT8 *)pCurReadHit + sizeof(tsReadHit) + pCurReadHit->ReadLen + pCurReadHit->DescrLen);
-	MaxReads2Proc -= 1;
-	}
+	// if streaming then record the round as a block so alignments can be written out in the same order as the reads were loaded
+	StreamBlkIdx = -1;
+	if(m_StreamBatchReads > 0)
+		{
+		StreamBlkIdx = (m_StreamBlockHead + m_NumStreamBlocks) % cMaxStreamBlocks;
+		m_StreamBlocks[StreamBlkIdx].StartOfs = BlockStartOfs;
+		m_StreamBlocks[StreamBlkIdx].NumReads = NumRoundReads;
+		m_StreamBlocks[StreamBlkIdx].bDone = false;
+		m_NumStreamBlocks += 1;
+		}
+	ReleaseSerialise();
 
-m_NumReadsProc += pRetBlock->NumReads;
-m_NxtReadProcOfs = (size_t)((UINT8 *)pCurReadHit - (UINT8 *)m_pReadHits);
+	Rslt = m_WorkPool.Run(CoredApproxTask,this,NumRoundReads,cCoredApproxGrain);
+	ReleaseLock(false);
 
-ReleaseSerialise();
-return(true);
+	AcquireSerialise();
+	if(Rslt < eBSFSuccess && m_ThreadCoredApproxRslt >= 0)
+		m_ThreadCoredApproxRslt = Rslt;
+	if(StreamBlkIdx >= 0)
+		RetireStreamedReads(StreamBlkIdx);
+	ReleaseSerialise();
+
+	CurSecs = gStopWatch.ReadUSecs();
+	if((CurSecs - PrevReportSecs) >= ReportProgressSecs)
+		{
+		ApproxNumReadsProcessed(&CurReadsProcessed,&CurReadsLoaded);
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: %u reads aligned from %u loaded",CurReadsProcessed,CurReadsLoaded);
+		PrevReportSecs = CurSecs;
+		}
+	}
+return(Rslt);
 }
 
 
@@ -9959,27 +10429,31 @@ else
 		}
 	}
 
-switch(SortMode) {
-	case eRSMReadID:
-		m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortReadIDs);
-		break;
-	case eRSMPairReadID:
-		m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortPairReadIDs);
-		break;
-	case eRSMHitMatch:
-		m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortHitMatch);
-		break;
+// sort modes with fixed width keys are radix sorted, falling back to qsort if too few reads or unable to alloc memory for the keys
+if(SortMode == eRSMSeq || m_NumReadsLoaded < cMinRadixSortEls || RadixSortReadHits(SortMode) != eBSFSuccess)
+	{
+	switch(SortMode) {
+		case eRSMReadID:
+			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortReadIDs);
+			break;
+		case eRSMPairReadID:
+			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortPairReadIDs);
+			break;
+		case eRSMHitMatch:
+			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortHitMatch);
+			break;
 
-	case eRSMPEHitMatch:
-		m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortPEHitMatch);
-		break;		
+		case eRSMPEHitMatch:
+			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortPEHitMatch);
+			break;		
 
-	case eRSMSeq:
-		if(!bSeqSorted)
-			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortReadSeqs);
-		break;
-	default:
-		break;
+		case eRSMSeq:
+			if(!bSeqSorted)
+				m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortReadSeqs);
+			break;
+		default:
+			break;
+		}
 	}
 
 // m_ppReadHitsIdx now in requested order, assign sequentially incrementing ReadHitIdx to the reads
@@ -9990,6 +10464,98 @@ m_CurReadsSortMode = SortMode;
 return(eBSFSuccess);
 }
 
+// RadixSortReadHits
+// Radix sort m_ppReadHitsIdx, already populated with all loaded reads, on compact fixed width keys derived for the requested sort mode
+// Key ordering is that of the corresponding SortReadIDs, SortPairReadIDs, SortHitMatch or SortPEHitMatch comparators with reads having
+// identical keys retaining their m_ppReadHitsIdx relative ordering
+int
+CAligner::RadixSortReadHits(etReadsSortMode SortMode)		// sort mode required
+{
+UINT32 Idx;
+size_t memreq;
+tsRadixEl *pEls;
+tsRadixEl *pEl;
+tsRadixEl *pSorted;
+tsReadHit *pReadHit;
+tsSegLoci *pSeg;
+
+if(SortMode != eRSMReadID && SortMode != eRSMPairReadID && SortMode != eRSMHitMatch && SortMode != eRSMPEHitMatch)
+	return(eBSFerrParams);
+
+// elements to be sorted plus same number as the scatter target
+memreq = (size_t)m_NumReadsLoaded * 2 * sizeof(tsRadixEl);
+#ifdef _WIN32
+pEls = (tsRadixEl *) malloc(memreq);
+if(pEls == NULL)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"RadixSortReadHits: Memory allocation of %lld bytes failed, sorting with qsort",(INT64)memreq);
+	return(eBSFerrMem);
+	}
+#else
+pEls = (tsRadixEl *)mmap(NULL,memreq, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+if(pEls == MAP_FAILED)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"RadixSortReadHits: Memory allocation of %lld bytes through mmap() failed, sorting with qsort",(INT64)memreq);
+	return(eBSFerrMem);
+	}
+#endif
+
+pEl = pEls;
+for(Idx = 0; Idx < m_NumReadsLoaded; Idx++,pEl++)
+	{
+	pReadHit = m_ppReadHitsIdx[Idx];
+	pEl->pValue = pReadHit;
+	pEl->KeyHi = 0;
+	pEl->KeyLo = 0;
+	switch(SortMode) {
+		case eRSMReadID:
+			pEl->KeyLo = pReadHit->ReadID;
+			break;
+
+		case eRSMPairReadID:		// 5' read ordered before the 3' read of same pair
+			pEl->KeyLo = ((UINT64)(pReadHit->PairReadID & 0x7fffffff) << 1) | (pReadHit->PairReadID >> 31);
+			break;
+
+		case eRSMHitMatch:			// NAR, NumHits (1,0,2,3..), then if a unique hit: chrom, loci, len, strand, LowMMCnt
+			pEl->KeyHi = (UINT64)pReadHit->NAR << 56;
+			if(pReadHit->NumHits != 1)
+				{
+				pEl->KeyHi |= ((UINT64)(UINT16)pReadHit->NumHits + 1) << 32;
+				break;
+				}
+			pSeg = &pReadHit->HitLoci.Hit.Seg[0];
+			pEl->KeyHi |= pSeg->ChromID;
+			pEl->KeyLo = ((UINT64)AdjStartLoci(pSeg) << 32) | ((UINT64)(AdjHitLen(pSeg) & 0x0ffff) << 16) | ((UINT64)pSeg->Strand << 8) | (UINT8)(pReadHit->LowMMCnt ^ 0x80);
+			break;
+
+		case eRSMPEHitMatch:		// accepted PE aligned, then if accepted: chrom, PairReadID, 5' before 3'
+			if(!(pReadHit->NAR == eNARAccepted && pReadHit->FlgPEAligned))
+				{
+				pEl->KeyHi = (UINT64)1 << 32;
+				break;
+				}
+			pEl->KeyHi = pReadHit->HitLoci.Hit.Seg[0].ChromID;
+			pEl->KeyLo = ((UINT64)(pReadHit->PairReadID & 0x7fffffff) << 1) | (pReadHit->PairReadID >> 31);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+pSorted = m_mtRadixSort.Sort(m_NumReadsLoaded,pEls,&pEls[m_NumReadsLoaded]);
+pEl = pSorted;
+for(Idx = 0; Idx < m_NumReadsLoaded; Idx++,pEl++)
+	m_ppReadHitsIdx[Idx] = (tsReadHit *)pEl->pValue;
+
+#ifdef _WIN32
+free(pEls);
+#else
+munmap(pEls,memreq);
+#endif
+return(eBSFSuccess);
+}
+
 
 // SortReadIDs
 // Sort reads by ascending read identifiers
@@ -10258,6 +10824,10 @@ if(pEl1->PValue < pEl2->PValue)
 		return(-1);
 if(pEl1->PValue > pEl2->PValue)
 	return(1);
+if(pEl1->Loci < pEl2->Loci)				// ensuring ranks are deterministic when PValues are equal
+	return(-1);
+if(pEl1->Loci > pEl2->Loci)
+	return(1);
 return(0);
 }
 
@@ -10580,6 +11150,38 @@ CAligner::AddEntry(bool bIsPairRead,	// false if SE or PE1, true if this is the
 UINT8 *pTmpAlloc;
 tsReadHit *pReadHit;
 size_t memreq;
+bool bTerm;
+
+// if streaming and already loaded at least two batches of reads not yet written out then hold off loading until less than one batch remains
+if(m_StreamBatchReads > 0 && (m_NumDescrReads - m_NumReadsRetired) >= (2 * m_StreamBatchReads))
+	{
+	AcquireSerialise();
+	m_FinalReadID = m_NumDescrReads;
+	m_NumReadsLoaded = m_NumDescrReads;
+	m_bStreamLoadStalled = true;
+	while((m_NumDescrReads - m_NumReadsRetired) >= m_StreamBatchReads && m_ThreadCoredApproxRslt >= 0 && m_TermBackgoundThreads == 0)
+		{
+		ReleaseSerialise();
+#ifdef _WIN32
+		Sleep(1000);
+#else
+		sleep(1);
+#endif
+		AcquireSerialise();
+		}
+	m_bStreamLoadStalled = false;
+	bTerm = m_ThreadCoredApproxRslt < 0 || m_TermBackgoundThreads != 0;
+	// reuse memory holding written out reads once that memory is at least twice that of reads yet to be written out
+	if(!bTerm && m_RetiredReadsOfs >= (2 * (m_DataBuffOfs - m_RetiredReadsOfs)))
+		{
+		AcquireLock(true);
+		CompactStreamedReads();
+		ReleaseLock(true);
+		}
+	ReleaseSerialise();
+	if(bTerm)
+		return(eBSErrSession);
+	}
 
 if(m_pReadHits == NULL)
 	{
@@ -10613,6 +11215,17 @@ if(m_pReadHits == NULL)
 	ReleaseSerialise();
 	}
 
+// if streaming then first try reusing the memory holding reads which have been written out
+if(m_StreamBatchReads > 0 && (m_AllocdReadHitsMem - m_DataBuffOfs) < (sizeof(tsReadHit) +  ReadLen + DescrLen + 0x03ff))
+	{
+	AcquireSerialise();
+	AcquireLock(true);
+	if(m_RetiredReadsOfs >= (m_DataBuffOfs / 4))
+		CompactStreamedReads();
+	ReleaseLock(true);
+	ReleaseSerialise();
+	}
+
 // need to allocate more memory? NOTE: allowing margin of 1K
 if((m_AllocdReadHitsMem - m_DataBuffOfs) < (sizeof(tsReadHit) +  ReadLen + DescrLen + 0x03ff))
 	{
@@ -10720,6 +11333,74 @@ else
 return(ProbNoReadErr);
 }
 
+// PackQScores
+// Normalise the quality scores into range 0..15 (needs to fit into 4 bits!) and pack these into bits 4..7 of the read bases
+// Sanger and Illumina 1.3+ scores are decoded and packed using the SIMD kernels in CSeqTrans
+// Returns number of quality values which were outside of the range expected for the scoring method
+int
+CAligner::PackQScores(int ReadLen,				// number of bases in read
+				UINT8 *pQScores,				// ascii quality scores for the read, overwritten with Phred scores
+				UINT8 *pReadBuff,				// read bases into which the quality bands are to be packed
+				int PrevNumInvalValues,			// number of unexpected quality values previously reported for file containing this read
+				char *pszDescr,					// read descriptor
+				char *pszFile)					// file containing read
+{
+int Idx;
+int Qphred;
+int NumInvalValues;
+char FirstInvalValue;
+UINT8 *pQualBuff;
+
+NumInvalValues = 0;
+switch(m_QMethod) {
+	case eFQIgnore:		// simply treat as the minimum phred
+		return(0);
+
+	case eFQSanger:		// Qphred = -10 log10(P), where Qphred is in range 0..93; Illumina 1.8+ is essentially the same as Sanger
+						// Sanger encodes into ascii starting from decimal 33 '!', clamp at phred equiv to 0.0001
+		CSeqTrans::PhredDecode(pQScores,ReadLen,pQScores,33,40,NULL,&NumInvalValues,&FirstInvalValue);
+		if(NumInvalValues && !PrevNumInvalValues)
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Sanger",FirstInvalValue,pszDescr,pszFile);
+		break;
+
+	case eFQIllumia:	//Qphred = -10 log10(P), where Qphred is in range 0..63
+						//Illumia encodes into ascii starting from decimal 64, clamp at phred equiv to 0.0001
+		CSeqTrans::PhredDecode(pQScores,ReadLen,pQScores,64,40,NULL,&NumInvalValues,&FirstInvalValue);
+		if(NumInvalValues && !PrevNumInvalValues)
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Illumina 1.3+",FirstInvalValue,pszDescr,pszFile);
+		break;
+
+	case eFQSolexa:		// SolexaQ = -10 log10(P/(1-P)), where SolexaQ is in range -5 to 62, note the negative value
+						// negative values will result if P > 0.5
+						// $Q = 10 * log(1 + 10 ** (ord(SolexaQphred) - 64) / 10.0)) / log(10);
+						// once Qphred is over about 15 then essentially same as Sanger and Illumina 1.3+ so
+						// is it worth doing the full conversion????
+		pQualBuff = pQScores;
+		for(Idx = 0; Idx < ReadLen; Idx++,pQualBuff++)
+			{
+			if(*pQualBuff < 59 || *pQualBuff >= 126)
+				{
+				if(!NumInvalValues++ && !PrevNumInvalValues)
+					gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Solexa/Illumina pre 1.3",*(char *)pQualBuff,pszDescr,pszFile);
+				if(*pQualBuff < 64)
+					*pQualBuff = 64;
+				else
+					*pQualBuff = 125;
+				}
+			Qphred = *pQualBuff - 59;	// Solexa/Illumina encodes into ascii starting from decimal 59
+			Qphred = (UINT8)(10 * log(1 + pow(10.0,((double)Qphred/10.0) / log(10.0))));	//
+			if(Qphred > 40)				// clamp at phred equiv to 0.0001
+				Qphred = 40;
+			*pQualBuff = (UINT8)Qphred;
+			}
+		break;
+	}
+
+// pack the read and quality, read into the low order bits 0..3, quality into bits 4..7
+CSeqTrans::PackPhredBands(pReadBuff,pQScores,ReadLen);
+return(NumInvalValues);
+}
+
 teBSFrsltCodes
 CAligner::LoadRawReads(bool bIsPairReads,	// true if paired end processing - PE1 reads in pszPE1File and PE2 reads in pszPE2File
 		  int FileID,						// uniquely identifies source file for PE1, FileID + 1 uniquely identifies PE2 file
@@ -10731,9 +11412,6 @@ teBSFrsltCodes Rslt;
 int Idx;
 bool bIsFastq;
 
-UINT8 *pReadBuff;
-UINT8 *pQualBuff;
-UINT8 Qphred;
 
 bool bPE1SimReads;
 int PE1NumDescrReads;
@@ -10804,7 +11482,7 @@ if(bIsPairReads)
 UINT32 PairReadID;
 
 PairReadID = (m_NumDescrReads/2) + 1;				// if bIsPairReads then start paired reads identifiers from this value and increment after each read processed
-if((Rslt=(teBSFrsltCodes)PE1Fasta.Open(pszPE1File,true))!=eBSFSuccess)
+if((Rslt=(teBSFrsltCodes)PE1Fasta.Open(pszPE1File,true,cDfltStageBuffSize,CFasta::DecodeThreadsInBudget(m_NumThreads,bIsPairReads ? 2 : 1)))!=eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Load: Unable to open '%s' [%s] %s",pszPE1File,PE1Fasta.ErrText((teBSFrsltCodes)Rslt),PE1Fasta.GetErrMsg());
 	return(Rslt);
@@ -10830,7 +11508,7 @@ bIsFastq = PE1Fasta.IsFastq();
 
 if(bIsPairReads)	
 	{
-	if((Rslt=(teBSFrsltCodes)PE2Fasta.Open(pszPE2File,true))!=eBSFSuccess)
+	if((Rslt=(teBSFrsltCodes)PE2Fasta.Open(pszPE2File,true,cDfltStageBuffSize,CFasta::DecodeThreadsInBudget(m_NumThreads,bIsPairReads ? 2 : 1)))!=eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Load: Unable to open '%s' [%s] %s",pszPE2File,PE2Fasta.ErrText((teBSFrsltCodes)Rslt),PE2Fasta.GetErrMsg());
 		PE1Fasta.Close();
@@ -11129,74 +11807,8 @@ while((Rslt = (teBSFrsltCodes)(PE1ReadLen = PE1Fasta.ReadSequence(szPE1ReadBuff,
 					PE2Fasta.Close();
 				return(eBSFerrParse);
 				}
-			// normalise the quality score to be in range 0..15 (needs to fit into 4 bits!)
-			pQualBuff = szPE1QualBuff;
-			for(Idx = 0; Idx < PE1ReadLen; Idx++,pQualBuff++)
-				{
-				switch(m_QMethod) {
-					case eFQIgnore:		// simply treat as the minimum phred
-						Qphred = 0;
-						break;
-
-					case eFQSanger:		// Qphred = -10 log10(P), where Qphred is in range 0..93; Illumina 1.8+ is essentially the same as Sanger
-						if(*pQualBuff < 33 || *pQualBuff >= 126)
-							{
-							if(!PE1NumInvalValues++)
-								gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Sanger",*(char *)pQualBuff,szPE1DescrBuff,pszPE1File);
-							if(*pQualBuff < 33)
-								*pQualBuff = 33;
-							else
-								*pQualBuff = 125;
-							}
-						Qphred = *pQualBuff - 33;	// Sanger encodes into ascii starting from decimal 33 '!'
-						if(Qphred > 40)				// clamp at phred equiv to 0.0001
-							Qphred = 40;
-						break;
-
-					case eFQIllumia:	//Qphred = -10 log10(P), where Qphred is in range 0..63
-						if(*pQualBuff < 64 || *pQualBuff >= 126)
-							{
-							if(!PE1NumInvalValues++)
-								gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Illumina 1.3+",*(char *)pQualBuff,szPE1DescrBuff,pszPE1File);
-							if(*pQualBuff < 64)
-								*pQualBuff = 64;
-							else
-								*pQualBuff = 125;
-							}
-
-						Qphred = *pQualBuff - 64;	//Illumia encodes into ascii starting from decimal 64
-						if(Qphred > 40)				// clamp at phred equiv to 0.0001
-							Qphred = 40;
-						break;
-
-					case eFQSolexa:		// SolexaQ = -10 log10(P/(1-P)), where SolexaQ is in range -5 to 62, note the negative value
-										// negative values will result if P > 0.5
-										// $Q = 10 * log(1 + 10 ** (ord(SolexaQphred) - 64) / 10.0)) / log(10);
-										// once Qphred is over about 15 then essentially same as Sanger and Illumina 1.3+ so
-										// is it worth doing the full conversion????
-						if(*pQualBuff < 59 || *pQualBuff >= 126)
-							{
-							if(!PE1NumInvalValues++)
-								gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Solexa/Illumina pre 1.3",*(char *)pQualBuff,szPE1DescrBuff,pszPE1File);
-							if(*pQualBuff < 64)
-								*pQualBuff = 64;
-							else
-								*pQualBuff = 125;
-							}
-						Qphred = *pQualBuff - 59;	// Solexa/Illumina encodes into ascii starting from decimal 59
-						Qphred = (UINT8)(10 * log(1 + pow(10.0,((double)Qphred/10.0) / log(10.0))));	//
-						if(Qphred > 40)				// clamp at phred equiv to 0.0001
-							Qphred = 40;
-						break;
-					}
-				*pQualBuff = (UINT8)((((UINT32)Qphred+2)*15)/40);
-				}
-
-			// pack the read and quality, read into the low order bits 0..3, quality into bits 4..7
-			pQualBuff = szPE1QualBuff;
-			pReadBuff = szPE1ReadBuff;
-			for(Idx = 0; Idx < PE1ReadLen; Idx++,pQualBuff++,pReadBuff++)
-				szPE1ReadBuff[Idx] |= *pQualBuff << 4;
+			// normalise the quality scores into range 0..15 (needs to fit into 4 bits!) and pack into bits 4..7 of the read bases
+			PE1NumInvalValues += PackQScores(PE1ReadLen,szPE1QualBuff,szPE1ReadBuff,PE1NumInvalValues,(char *)szPE1DescrBuff,pszPE1File);
 
 			if(bIsPairReads)
 				{
@@ -11208,74 +11820,8 @@ while((Rslt = (teBSFrsltCodes)(PE1ReadLen = PE1Fasta.ReadSequence(szPE1ReadBuff,
 					PE2Fasta.Close();
 					return(eBSFerrParse);
 					}
-				// normalise the quality score to be in range 0..15 (needs to fit into 4 bits!)
-				pQualBuff = szPE2QualBuff;
-				for(Idx = 0; Idx < PE2ReadLen; Idx++,pQualBuff++)
-					{
-					switch(m_QMethod) {
-						case eFQIgnore:		// simply treat as the minimum phred
-							Qphred = 0;
-							break;
-
-						case eFQSanger:		// Qphred = -10 log10(P), where Qphred is in range 0..93
-							if(*pQualBuff < 33 || *pQualBuff >= 126)
-								{
-								if(!PE2NumInvalValues++)
-									gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Sanger",*(char *)pQualBuff,szPE2DescrBuff,pszPE2File);
-								if(*pQualBuff < 33)
-									*pQualBuff = 33;
-								else
-									*pQualBuff = 125;
-								}
-							Qphred = *pQualBuff - 33;	// Sanger encodes into ascii starting from decimal 33 '!'
-							if(Qphred > 40)				// clamp at phred equiv to 0.0001
-								Qphred = 40;
-							break;
-
-						case eFQIllumia:	//Qphred = -10 log10(P), where Qphred is in range 0..63
-							if(*pQualBuff < 64 || *pQualBuff >= 126)
-								{
-								if(!PE2NumInvalValues++)
-									gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Illumina 1.3+",*(char *)pQualBuff,szPE2DescrBuff,pszPE2File);
-								if(*pQualBuff < 64)
-									*pQualBuff = 64;
-								else
-									*pQualBuff = 125;
-								}
-
-							Qphred = *pQualBuff - 64;	//Illumia encodes into ascii starting from decimal 64
-							if(Qphred > 40)				// clamp at phred equiv to 0.0001
-								Qphred = 40;
-							break;
-
-						case eFQSolexa:		// SolexaQ = -10 log10(P/(1-P)), where SolexaQ is in range -5 to 62, note the negative value
-											// negative values will result if P > 0.5
-											// $Q = 10 * log(1 + 10 ** (ord(SolexaQphred) - 64) / 10.0)) / log(10);
-											// once Qphred is over about 15 then essentially same as Sanger and Illumina 1.3+ so
-											// is it worth doing the full conversion????
-							if(*pQualBuff < 59 || *pQualBuff >= 126)
-								{
-								if(!PE2NumInvalValues++)
-									gDiagnostics.DiagOut(eDLWarn,gszProcName,"Load: quality value of '%c' outside range expected in read '%s' from file '%s' for Solexa/Illumina pre 1.3",*(char *)pQualBuff,szPE2DescrBuff,pszPE2File);
-								if(*pQualBuff < 64)
-									*pQualBuff = 64;
-								else
-									*pQualBuff = 125;
-								}
-							Qphred = *pQualBuff - 59;	// Solexa/Illumina encodes into ascii starting from decimal 59
-							Qphred = (UINT8)(10 * log(1 + pow(10.0,((double)Qphred/10.0) / log(10.0))));	//
-							if(Qphred > 40)				// clamp at phred equiv to 0.0001
-								Qphred = 40;
-							break;
-						}
-					*pQualBuff = (UINT8)((((UINT32)Qphred+2)*15)/40);
-					}
-
-					// pack the read and quality, read into the low order bits 0..3, quality into bits 4..7
-				pQualBuff = szPE2QualBuff;
-				pReadBuff = szPE2ReadBuff;
-				for(Idx = 0; Idx < PE2ReadLen; Idx++,pQualBuff++,pReadBuff++)
-					szPE2ReadBuff[Idx] |= *pQualBuff << 4;
+				// normalise the quality scores into range 0..15 (needs to fit into 4 bits!) and pack into bits 4..7 of the read bases
+				PE2NumInvalValues += PackQScores(PE2ReadLen,szPE2QualBuff,szPE2ReadBuff,PE2NumInvalValues,(char *)szPE2DescrBuff,pszPE2File);
 				}
 			}
 
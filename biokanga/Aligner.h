@@ -14,6 +14,11 @@ const unsigned int cMaxInFileSpecs = 100;	// allow user to specify upto this man
 
 const int cMaxWorkerThreads = 128;			// limiting max number of threads to this many
 const int cMaxReadsPerBlock = 4096;		// max number of reads allocated for processing per thread as a block (could increase but may end up with 1 thread doing more than fair share of workload)
+const int cCoredApproxGrain = 256;		// work pool workers take at most this many reads at a time when aligning
+const int cClusterMultiHitsGrain = 1000; // work pool workers take at most this many multihits at a time when clustering
+const int cMinStreamBatchReads = 100000;	// if streaming SE reads then batches must be at least this many reads
+const int cMaxStreamBatchReads = 100000000;	// if streaming SE reads then batches can be at most this many reads
+const int cMaxStreamBlocks = 4096;		// if streaming SE reads then at most this many blocks can have been handed out for alignment but not yet written out
 
 const int cMaxIncludeChroms = 20;		// max number of include chromosomes regular expressions
 const int cMaxExcludeChroms = 20;		// max number of exclude chromosomes regular expressions
@@ -54,7 +59,8 @@ const int cMaxSNPreads = 100;           // user can specify a max of at least th
 const double cMinSeqErrRate = 0.01;		// sets a floor on minimum sequencing error rate per base - is used in binominal calculation
 const double cDfltMinMarkerSNPProp = (1.0/3.0);	// polymorphic bases within marker sequences must be at no more than this proportion of total bases covering the marker loci to be accepted
 
-const int cAllocLociPValues = 100000;   // allocate for putative SNP loci in this many increments
+const int cAllocChromSNPsMem = 0x040000; // per chromosome putative SNP loci, marker and haplotype buffers are allocated in increments of this many bytes
+const int cSNPChromsPerWorker = 4;		// SNP processing identifies putative SNPs on batches of at most this many chromosomes per worker thread
 
 const int cAllocLineBuffSize = 0x01fffffff; // 512MB buffer - when writing to results file then allow for buffering up to this many chars so as to reduce write frequency
 
@@ -291,21 +297,78 @@ typedef struct TAG_sAdjacentSNPs {
 	tsReadHit *pPrevIterReadHit; // this read was the previously iterated returned read overlapping StartLoci and EndLoci
 	} tsAdjacentSNPs;
 
+typedef struct TAG_sLociPValues {
+	UINT32 Loci;		// putative SNP at this loci
+	double PValue;      // having this PValue
+	UINT32 Rank;		// and this ordered rank
+	double LocalBkGndSubRate; // local background substitution rate
+	UINT32 LocalReads;  // total number of aligned bases within the local background
+	UINT32 LocalSubs;	// total number local aligner induced substitutions within the local background
+	tsSNPcnts SNPcnts;	// counts of each base a,c,g,t,n at this loci
+	UINT32 NumReads;	// number of reads aligned at this loci
+	UINT32 NumSubs;		// number of aligner induced substitutions at this loci
+	UINT32 MarkerID;	// generated marker sequence will have this identifier as '>Marker<MarkerID>'
+	UINT32 NumPolymorphicSites; // number of polymorthic sites within the marker sequence
+} tsLociPValues;
+
+typedef struct TAG_sSNPMarker {
+	UINT32 Loci;		// marker sequence is centered on the putative SNP at this loci
+	UINT32 NumPolymorphicSites; // number of polymorphic sites within the marker sequence
+	char SNPBase;		// marker base at the SNP loci
+	char RefBase;		// reference base at the SNP loci
+	char szMarkerSeq[1]; // will be allocated to hold the '\0' terminated marker sequence
+	} tsSNPMarker;
+
+typedef struct TAG_sSNPHaplotypes {
+	UINT32 SNPIdx;		// haplotypes were counted when reporting the SNP at this index into the chromosome's loci ordered SNPs
+	int NumSNPs;		// 2 if DiSNPs, 3 if TriSNPs
+	int SNPLoci[3];		// loci of each SNP in the order reported
+	tsSNPcnts SNPcnts[3]; // base counts in reads overlapping all SNPs, in the order reported
+	int NumReadsOverlapping; // number of reads overlapping all SNPs
+	int NumReadsAntisense;	// of which this many were antisense to the chromosome
+	int NumHaplotypes;	// number of haplotypes having counts above the haplotype threshold
+	int HaplotypeCnts[64]; // counts for each DiSNP (16) or TriSNP (64) haplotype
+	} tsSNPHaplotypes;
+
 typedef struct TAG_sChromSNPs {
 	UINT32 ChromID;		// uniquely identifies this chromosome
 	UINT32 ChromLen;	// this chromosome length
 	tsAdjacentSNPs AdjacentSNPs[2]; // allowing for both DiSNPs and TriSNPs
  	tsReadHit *pFirstReadHit; // 1st read on chromosome which was accepted for SNP processing
 	tsReadHit *pLastReadHit; // last read on chromosome which was accepted for SNP processing
-	UINT32 AllocChromLen; // cnts can be for a chromosome of at most this length
+	tsReadHit *pStartReadHit; // sorted reads to be processed for SNPs on this chromosome start with this read
+	tsReadHit *pEndReadHit;	// and end with this read inclusive
 	INT64 TotMatch;	// total number of aligned read bases which exactly matched corresponding chrom sequence bases
 	INT64 TotMismatch;	// total number of aligned read bases which mismatched corresponding chrom sequence base
 	UINT32 MeanReadLen;  // mean length of all reads used for identifying putative SNPs, determines max separation used for Di/TriSNP counts
 	UINT32 NumReads;     // number of reads used for identifying putative SNPs from which MeanReadLen was calculated 
 	UINT64 TotReadLen;	 // total length, in bp, of all reads used for identifying putative SNPs from which MeanReadLen was calculated
-	tsSNPcnts Cnts[1]; // will be allocated to hold base cnts at each loci in this chromosome
+	INT64 LociBasesCovered;	// number of loci covered by at least one aligned read base
+	INT64 LociBasesCoverage; // number of aligned read bases covering these loci
+	UINT32 WinLen;		// pileup window length, a power of 2, base cnts for loci are at pWinCnts[Loci & (WinLen - 1)]
+	UINT32 AllocWinLen;	// pWinCnts allocated to hold at most this many loci
+	UINT32 ClearedLoci;	// pileup window base cnts have been cleared for all loci up to this loci exclusive
+	UINT32 ScanLoci;	// next loci to be scanned for putative SNPs
+	UINT32 LocalTotMismatches; // mismatches within the background window for ScanLoci
+	UINT32 LocalTotMatches;	// matches within the background window for ScanLoci
+	tsSNPcnts *pWinCnts; // pileup window holding base cnts for the loci currently being scanned plus flanks
+	UINT32 NumLociPValues; // number of putative SNP loci in pLociPValues
+	size_t AllocLociPValuesMem; // memory allocated to pLociPValues
+	tsLociPValues *pLociPValues; // putative SNP loci, ordered by loci
+	UINT32 NumMarkers;	// number of marker sequences in pMarkers
+	size_t AllocMarkersMem; // memory allocated to pMarkers
+	UINT8 *pMarkers;	// marker sequences (tsSNPMarker), ordered by loci
+	UINT32 NumHaplotypes; // number of Di/TriSNP haplotype counts in pHaplotypes
+	size_t AllocHaplotypesMem; // memory allocated to pHaplotypes
+	tsSNPHaplotypes *pHaplotypes; // Di/TriSNP haplotype counts, ordered as reported
 	} tsChromSNPs;
 
+typedef struct TAG_sSNPWorker {
+	etSeqBase *pReadSeq;	// to hold sequence (sans quality scores) for current read
+	etSeqBase *pAssembSeq;	// to hold targeted genome assembly sequence
+	UINT32 *pCentroidInsts; // SNP centroid instance counts accumulated by this worker
+	} tsSNPWorker;
+
 typedef struct TAG_sSegJuncts {
 	tsReadHit *pRead;	// read containing this RNA-seq splice or microInDel junction
 	UINT32 Cnt;			// number of reads sharing this splice junction or microInDel junction
@@ -315,19 +378,6 @@ typedef struct TAG_sSegJuncts {
 	} tsSegJuncts;
 
 
-typedef struct TAG_sLociPValues {
-	UINT32 Loci;		// putative SNP at this loci
-	double PValue;      // having this PValue
-	UINT32 Rank;		// and this ordered rank
-	double LocalBkGndSubRate; // local background substitution rate
-	UINT32 LocalReads;  // total number of aligned bases within the local background
-	UINT32 LocalSubs;	// total number local aligner induced substitutions within the local background
-	tsSNPcnts SNPcnts;	// counts of each base a,c,g,t,n at this loci
-	UINT32 NumReads;	// number of reads aligned at this loci
-	UINT32 NumSubs;		// number of aligner induced substitutions at this loci
-	UINT32 MarkerID;	// generated marker sequence will have this identifier as '>Marker<MarkerID>'
-	UINT32 NumPolymorphicSites; // number of polymorthic sites within the marker sequence
-} tsLociPValues;
 
 typedef struct TAG_sSNPCentroid {
 	UINT32 CentroidID;		// uniquely identifies this centroid sequence
@@ -345,14 +395,6 @@ typedef struct TAG_sThreadMatchPars {
 	void *pThis;					// will be initialised to pt to CAligner instance
 	int NumIdentNodes;				// number of ident nodes allocd for use by this thread
 	tsIdentNode *pIdentNodes;		// thread to use these nodes
-
-#ifdef _WIN32
-	HANDLE threadHandle;			// handle as returned by _beginthreadex()
-	unsigned int threadID;			// identifier as set by _beginthreadex()
-#else
-	int threadRslt;					// result as returned by pthread_create ()
-	pthread_t threadID;				// identifier as set by pthread_create ()
-#endif
 	int CurBlockID;					// current suffix block identifier
 	int ChromID;					// hit chrom identifier
 	int MinChimericLen;				// if checking for chimerics then minimim percentage of read length required, set to 0 if not checking for chimerics
@@ -372,25 +414,20 @@ typedef struct TAG_sThreadMatchPars {
 	int MinusHits;					// returned number of hits on to minus strand
 	int ChimericHits;				// returned number of hits which were chimeric
 	int NumReadsProc;				// returned number of reads processed by this thread instance
+	UINT32 NumSloughedNs;			// returned number of reads sloughed because of excessive indeterminate bases
+	UINT32 NumNonAligned;			// returned number of reads not aligned
+	UINT32 NumAcceptedAsAligned;	// returned number of reads accepted as aligned
+	UINT32 NumLociAligned;			// returned number of loci aligned to
+	UINT32 NumNotAcceptedDelta;		// returned number of reads not accepted because of insufficient edit distance to next best alignment
+	UINT32 NumAcceptedHitInsts;		// returned number of reads not accepted because of excessive multihit instances
+	UINT32 TotAcceptedAsUniqueAligned; // returned number of reads accepted as uniquely aligned
+	UINT32 TotAcceptedAsMultiAligned; // returned number of reads accepted as multialigned
+	int MultiHitDist[cMaxMultiHits];	// returned accepted as aligned multihit distribution
 	int OutBuffIdx;					// index at which to write next formated hit into szOutBuff
 	UINT8 *pszOutBuff;				// used to buffer multiple hit formated output records prior to writing to disk
 	tsHitLoci *pMultiHits;			// allocated to hold read multihit loci
 } tsThreadMatchPars;
 
-typedef struct TAG_sClusterThreadPars {
-	int ThreadIdx;						// uniquely identifies this thread
-	void *pThis;					// will be initialised to pt to CAligner instance
-
-#ifdef _WIN32
-	HANDLE threadHandle;			// handle as returned by _beginthreadex()
-	unsigned int threadID;			// identifier as set by _beginthreadex()
-#else
-	int threadRslt;					// result as returned by pthread_create ()
-	pthread_t threadID;				// identifier as set by pthread_create ()
-#endif
-	int Rslt;						// returned result code
-} tsClusterThreadPars;
-
 typedef struct TAG_sLoadReadsThreadPars {
 	int ThreadIdx;					// uniquely identifies this thread
 	void *pThis;					// will be initialised to pt to CAligner instance
@@ -408,11 +445,11 @@ typedef struct TAG_sLoadReadsThreadPars {
 } tsLoadReadsThreadPars;
 
 
-typedef struct TAG_sReadsHitBlock {
-	int NumReads;			// number of reads for processing in this block
-	int MaxReads;			// block can hold at most this number of reads
-	tsReadHit *pReadHits[cMaxReadsPerBlock]; // reads for processing
-} tsReadsHitBlock;
+typedef struct TAG_sStreamBlock {
+	size_t StartOfs;		// byte offset into m_pReadHits of first read in this block
+	UINT32 NumReads;		// number of reads in this block
+	bool bDone;				// set true when all reads in this block have been aligned
+} tsStreamBlock;
 
 typedef struct TAG_sPEThreadPars {
 	int ThreadIdx;					// uniquely identifies this thread
@@ -471,6 +508,8 @@ class CAligner
 {
 
 	CMTqsort m_mtqsort;				// muti-threaded qsort
+	CMTRadixSort m_mtRadixSort;		// muti-threaded radix sort for fixed width keys
+	CWorkPool m_WorkPool;			// work stealing pool of worker threads used for core matching and multihit clustering
 
 	CContaminants *m_pContaminants; // for use when trimming reads containing contaminants
 
@@ -496,9 +535,6 @@ class CAligner
 	UINT32 m_AllocdReadHitsIdx;		// how many elements for m_pReadHitsIdx have been allocated
 	etReadsSortMode	m_CurReadsSortMode;	// sort mode last used on m_ppReadHitsIdx
 
-	size_t m_AllocLociPValuesMem;   // total memory currently allocated to m_pLociPValues
-	UINT32 m_NumLociPValues;		// current number of LociPValues
-	tsLociPValues *m_pLociPValues; // allocated to hold putative SNP loci and their associated PValues
 	double m_QValue;				// QValue used in
 
 	etMLMode m_MLMode;				// how to process multiloci matching reads
@@ -635,7 +671,10 @@ class CAligner
 
 
 
-	tsChromSNPs *m_pChromSNPs;		// allocated for use in SNP processing
+	int m_NumSNPWorkers;			// number of workers in m_pSNPWorkers
+	tsSNPWorker *m_pSNPWorkers;		// per worker resources used when identifying putative SNPs
+	int m_AllocdSNPChroms;			// m_pSNPChroms allocated to hold at most this many chromosomes
+	tsChromSNPs *m_pSNPChroms;		// batch of chromosomes on which putative SNPs are being identified
 	int m_TotNumSNPs;				// total number of SNPs discovered
 	
 	INT64 m_LociBasesCovered;		// total number of targeted loci (bases) covered by aligned reads when SNP processing - could be used for to determine fold coverage
@@ -645,6 +684,13 @@ class CAligner
 	char *m_pszLineBuff;			// allocated to hold output line buffering
 
 	CSfxArrayV3 *m_pSfxArray;		// suffix array holds genome of interest
+	bool m_bResidentSfx;			// true if m_pSfxArray is the align server's resident suffix array and must not be deleted
+
+	static CSfxArrayV3 *m_pResidentSfx;		// align server: suffix array loaded once and inherited by each forked align job
+	static char m_szResidentSfxFile[_MAX_PATH];	// resident suffix array was loaded from this file (full path)
+	static bool m_bResidentBisulfite;		// resident suffix array was loaded for bisulfite processing
+	static bool m_bResidentSOLiD;			// resident suffix array was loaded for colorspace processing
+	static int m_ResidentMaxThreads;		// if > 0 then align jobs are limited to at most this many threads (share of server thread budget)
 	char m_szTargSpecies[cMaxDatasetSpeciesChrom+1]; // suffix array was generated over this targeted species
 
 	CBEDfile *m_pPriorityRegionBED;	// to hold exact match priority regions
@@ -682,6 +728,9 @@ class CAligner
 	tsHitLoci *m_pAllocsMultiHitLoci; // allocated to hold all multihit loci for all threads
 	char *m_pszTrackTitle;			// track title if output format is UCSC BED
 	UINT8 *m_pAllocsMultiHitBuff;	  // allocated to hold per thread buffered output when processing all multihit loci
+	tsThreadMatchPars *m_pCoredApproxPars; // per worker parameters and resources whilst aligning
+	UINT32 m_AllocdCoredApproxReads;	// m_ppCoredApproxReads allocated to hold at most this many reads
+	tsReadHit **m_ppCoredApproxReads;	// reads in current round being aligned by work pool workers
 
 	int m_NumIncludeChroms;				// number of RE include chroms
 	int m_NumExcludeChroms;				// number of RE exclude chroms
@@ -698,6 +747,21 @@ class CAligner
 								// and should be treated as a guide only
 	size_t m_NxtReadProcOfs;	// byte offset into m_pReadHits of next read to be processed
 
+	UINT32 m_StreamBatchReads;	// if > 0 then SE reads are streamed through in batches of this many reads, alignments written out as blocks complete
+	bool m_bStreamLoadStalled;	// set true whilst the reads loader is waiting for streamed reads to be written out
+	UINT32 m_NumReadsRetired;	// number of streamed reads aligned and written out
+	size_t m_RetiredReadsOfs;	// byte offset into m_pReadHits immediately following the last streamed read written out
+	int m_StreamBlockHead;		// index into m_StreamBlocks[] of the oldest block not yet written out
+	int m_NumStreamBlocks;		// number of blocks handed out for alignment but not yet written out
+	tsStreamBlock m_StreamBlocks[cMaxStreamBlocks]; // ring of blocks in the order in which they were handed out for alignment
+	CSAMfile *m_pStreamSAMfile;	// streamed alignments are written into this SAM file
+	tsBAMalign *m_pStreamBAMalign; // used to construct each streamed alignment before writing into m_pStreamSAMfile
+	UINT32 m_NumStreamedAligned; // number of streamed alignments written out
+	UINT32 m_NumStreamCompacts;	// number of times memory holding retired streamed reads was reused
+	size_t m_StreamTotReadsLen;	// total length of all streamed reads
+	int m_StreamMinReadLen;		// minimum streamed read length
+	int m_StreamMaxReadLen;		// maximum streamed read length
+
 	bool m_bBisulfite;			// true if bisulfite methylation patterning processing
 	bool m_bIsSOLiD;			// true if SOLiD or colorspace processing
 	etFQMethod m_QMethod;		// fastq quality value method
@@ -712,8 +776,6 @@ class CAligner
 
 	int m_ThreadLoadReadsRslt;
 
-	UINT32 m_CurClusterFrom;
-
 	static sNAR m_NARdesc[eNARundefined];	// NAR deescriptive text
 
 #ifdef _WIN32
@@ -867,8 +929,14 @@ class CAligner
 
 	char *Octamer2Txt(int Octamer);		 // Report on site octamer site preferencing distribution
 
-	int OutputSNPs(void);
+	void *ReallocSNPsMem(void *pMem,size_t *pAllocdMem,size_t ReqMem); // grow SNP processing memory, returns NULL if unable to allocate
+	void ClearSNPsWin(tsChromSNPs *pChromSNPs,UINT32 UntilLoci);	// clear pileup window base cnts for loci up to UntilLoci exclusive
+	int ScanSNPsWin(tsSNPWorker *pWorker,tsChromSNPs *pChromSNPs,UINT32 UntilLoci); // scan pileup window for putative SNPs up to UntilLoci exclusive
+	int IdentifyChromSNPs(tsSNPWorker *pWorker,tsChromSNPs *pChromSNPs); // identify putative SNPs and Di/TriSNP haplotypes on this chromosome
+	static int IdentifySNPsTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until); // work pool function identifying putative SNPs on chromosomes in current batch
+	int OutputSNPs(tsChromSNPs *pChromSNPs);
 	int ProcessSNPs(void);
+	void FreeSNPsMem(void);		// free per chromosome and per worker SNP processing resources
 
 	int ProcessSiteProbabilites(int RelSiteStartOfs); // offset the site octamer by this relative start offset (read start base == 0)
 	int WriteSitePrefs(void);
@@ -887,6 +955,11 @@ class CAligner
 		FileReqWriteCompr(char *pszFile); // If last 3 chars of file name is ".gz" then this file is assumed to require compression
 	int CreateOrTruncResultFiles(void);	// Create, or if file already exists then truncate, the multitude of results files which user may have requested
 
+	int CreateStreamSAMfile(void);		// create SAM file, header referencing all target sequences, into which streamed alignments will be written
+	int RetireStreamedReads(int StreamBlkIdx);	// flag block as aligned then write out alignments for all leading aligned blocks in the order handed out
+	void CompactStreamedReads(void);	// move reads not yet written out down to start of m_pReadHits so memory holding retired reads can be reused
+	int CompleteStreamedReads(void);	// close SAM file and report on streamed reads once all have been aligned and written out
+
 	int CompileChromRegExprs(int	NumIncludeChroms,	// number of chromosome regular expressions to include
 		char **ppszIncludeChroms,		// array of include chromosome regular expressions
 		int	NumExcludeChroms,			// number of chromosome expressions to exclude
@@ -913,6 +986,14 @@ class CAligner
 				   UINT8 *pQScores);			// Phred quality scores over the read
 
 
+	int											// returned number of quality values outside of range expected
+		PackQScores(int ReadLen,				// number of bases in read
+				UINT8 *pQScores,				// ascii quality scores for the read, overwritten with Phred scores
+				UINT8 *pReadBuff,				// read bases into which the quality bands are to be packed
+				int PrevNumInvalValues,			// number of unexpected quality values previously reported for file containing this read
+				char *pszDescr,					// read descriptor
+				char *pszFile);					// file containing read
+
 	teBSFrsltCodes LoadRawReads(bool bIsPairReads,				// true if paired end processing - PE1 reads in pszPE1File and PE2 reads in pszPE2File
 		  int FileID,						// uniquely identifies source file for PE1, FileID + 1 uniquely identifies PE2 file
 		  char *pszPE1File,					// process PE1 reads from this file
@@ -939,7 +1020,9 @@ class CAligner
 				bool bSeqSorted = false,			// used to optimise eRSMSeq processing, if it is known that reads are already sorted in sequence order (loaded from pre-processed .rds file)
 				bool bForce = false);				// if true then force sort
 
-	void ResetThreadedIterReads(void);		 // must be called by master thread prior to worker threads calling ThreadedIterReads()
+	int RadixSortReadHits(etReadsSortMode SortMode);	// radix sort m_ppReadHitsIdx on fixed width keys derived for SortMode, returns eBSFerrParams if SortMode has no fixed width key
+
+	void ResetThreadedIterReads(void);		 // must be called by master thread prior to aligning reads
 
 	UINT32		// Returns the number of reads thus far loaded and processed for alignment
 		ApproxNumReadsProcessed(UINT32 *pNumProcessed,UINT32 *pNumLoaded);
@@ -952,8 +1035,8 @@ class CAligner
 						int StartLoci,				// returned reads are required to overlap both this starting and
 						int EndLoci);				// this ending loci
 
-	bool	// returns false if no more reads availing for processing by calling thread
-		ThreadedIterReads(tsReadsHitBlock *pRetBlock);
+	int RunCoredApproxRounds(UINT32 ReportProgressSecs);	// align all loaded reads in rounds, reads in each round aligned by work pool workers
+	static int CoredApproxTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until);	// work pool function aligning reads in current round
 
 	int											// returned number of unique reads
 		NumDnUniques(tsReadHit *pCurReadHit,		// current read
@@ -965,10 +1048,8 @@ class CAligner
 				int WinLen,					// only interested in unique reads starting within this window
 				bool bStrandDep);			// if true then unique loci reads must be on current read stand
 
-	int RunClusteringThreads(int NumThreads);
-	int										// returns 0 if finished clustering or cnt of multihits to be processed by this thread
-		GetClusterStartEnd(UINT32 *pMatchFrom,			// cluster from this inclusive index
-					UINT32 *pMatchUntil);		// until this inclusive index
+	static int AssignMultiMatchesTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until);	// work pool function clustering multihits
+	static void AssignMultiMatchesProgress(void *pCtx,INT64 NumItemsDone,INT64 NumItems);	// work pool progress whilst clustering
 
 
 	static int SortReadIDs(const void *arg1, const void *arg2);
@@ -1004,6 +1085,12 @@ public:
 	CAligner(void);
 	~CAligner(void);
 
+	static void SetResidentSfx(CSfxArrayV3 *pSfxArray,	// align server loaded this suffix array which subsequent Align() calls will use instead of loading their own
+				char *pszSfxFile,				// if Align() requests this suffix array file (compared as full paths)
+				bool bBisulfite,				// loaded for bisulfite processing
+				bool bSOLiD,					// loaded for colorspace processing
+				int MaxThreads);				// limit each Align() to at most this many threads (0 if no limit)
+
 	int
 		Align(etPMode PMode,					// processing mode
 				UINT32 SampleNthRawRead,		// sample every Nth raw read for processing (1..N)
@@ -1057,6 +1144,8 @@ public:
 				char *pszMarkerFile,			// Output markers to this file
 				char *pszSNPCentroidFile,		// Output SNP centorids (CSV format) to this file (default is for no centroid processing)
 				char *pszSfxFile,				// target as suffix array
+				etSfxLoadMode SfxLoadMode,		// how the suffix array is to be loaded, private copy or memory mapped shared with other processes
+				UINT32 StreamBatchReads,		// if > 0 then SE reads are streamed through in batches of this many reads with alignments written out as each block completes
 				char *pszStatsFile,				// aligner induced substitutions stats file
 				char *pszMultiAlignFile,		// file to contain reads which are aligned to multiple locations
 				char *pszNoneAlignFile,			// file to contain reads which were non-alignable
@@ -1068,8 +1157,11 @@ public:
 				int	NumExcludeChroms,			// number of chromosome expressions to exclude
 				char **ppszExcludeChroms);		// array of exclude chromosome regular expressions
 
-		int ProcAssignMultiMatches(tsClusterThreadPars *pPars);
-		int ProcCoredApprox(tsThreadMatchPars *pPars);
+		int ProcAssignMultiMatches(UINT32 MatchFrom,		// cluster multihits in m_pMultiHits[] from this inclusive index
+						UINT32 MatchUntil);				// until this exclusive index
+		int ProcCoredApprox(tsThreadMatchPars *pPars,	// worker specific parameters and resources
+						tsReadHit **ppReadHits,			// reads to be aligned
+						int NumReads);					// number of reads in ppReadHits
 		int ProcLoadReadFiles(tsLoadReadsThreadPars *pPars);
 		int	ProcessPairedEnds(tsPEThreadPars *pPars);
 
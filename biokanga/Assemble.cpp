@@ -45,6 +45,7 @@ deNovoAssemble(etdeNovoPMode PMode,		// processing mode, currently either eAMEAs
 		int MinPE2SEOvlp,				// minimal overlap of PE1 onto PE2 required to merge as SE
 		int PE2SESteps,					// when less than this many steps remaining then treat PE1 and PE2 as individual SE sequences if excessive lengths (defaults to 2, set 0 to disable)");
 		int OrientatePE,				// PE end orientations 0: sense/antisense, 1: sense/sense, 2: antisense/sense, 3: antisense/antisense 
+		int SfxIndexMode,				// read suffix index between passes 0: incrementally maintained, 1: fully regenerated, 2: incrementally maintained and verified against full regeneration
 		int NumThreads,					// number of worker threads to use
 		bool bAffinity,					// thread to core affinity
 		char *pszPE1File,				// optional input high confidence seed PE1 sequences file
@@ -104,6 +105,8 @@ int PE2SESteps;				// when less than this many steps remaining then treat PE1 an
 
 int OrientatePE;		    // PE end orientations 0: sense/antisense, 1: sense/sense, 2: antisense/sense, 3: antisense/antisense 
 
+int SfxIndexMode;			// read suffix index between passes 0: incrementally maintained, 1: fully regenerated, 2: incrementally maintained and verified against full regeneration
+
 char szInArtReducfile[_MAX_PATH];	// preprocessed artefact reduced packed reads from this file
 char szOutFile[_MAX_PATH];			// assemblies to this prefix file
 
@@ -151,6 +154,8 @@ struct arg_lit  *allowse2pe = arg_lit0("Z","allowse2pe",         "if SE overlaps
 
 struct arg_int *orientatepe = arg_int0("M","orientatepe","<int>",    "read pair end orientations, 0: sense/antisense (PE short insert), 1: sense/sense (MP Roche 454), 2: antisense/sense (MP Illumina circularized), 3: antisense/antisense (MP SOLiD)");
 
+struct arg_int *sfxindex = arg_int0("I","sfxindex","<int>",     "read suffix index between passes, 0: incrementally maintained, 1: fully regenerated, 2: incrementally maintained and verified against full regeneration (default 0)");
+
 struct arg_file *inpe1file = arg_file0("a","inpe1","<file>","optionally Load 5' paired end previously assembled fragments or filtered PE1 reads from fasta file");
 struct arg_file *inpe2file = arg_file0("A","inpe2","<file>","optionally Load 3' paired end previously assembled fragments or filtered PE2 reads from fasta file");
 
@@ -171,7 +176,7 @@ struct arg_end *end = arg_end(200);
 void *argtable[] = {help,version,FileLogLevel,LogFile,
 	                pmode,noautoovlp,trimends,minseqlen,trimpe2se,allowse2pe,sensestrandonly,singleended,maxpasses,reducethressteps,passthres,subs100bp,end12subs,
 					initseovlp,finseovlp,initpeovlp,finpeovlp,minpe2seovlp,pe2sesteps,
-					orientatepe,inpe1file,inpe2file,seedcontigsfile,inartreducfile,outfile,
+					orientatepe,sfxindex,inpe1file,inpe2file,seedcontigsfile,inartreducfile,outfile,
 					summrslts,experimentname,experimentdescr,
 					threads,
 					end};
@@ -516,6 +521,13 @@ if (!argerrors)
 		return(1);
 		}
 
+	SfxIndexMode = sfxindex->count ? sfxindex->ival[0] : 0;
+	if(SfxIndexMode < 0 || SfxIndexMode > 2)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Read suffix index between passes '-I%d' must be in range 0..2",SfxIndexMode);
+		return(1);
+		}
+
 	MaxPasses = maxpasses->count ? maxpasses->ival[0] : 0;
 	if((MaxPasses != 0) && (MaxPasses < 20 || MaxPasses > 1000))
 		{
@@ -746,6 +758,7 @@ if (!argerrors)
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Threhold reduction steps: %d",NReduceThresSteps);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Remaining steps before excessive PE end length checking: %d",PE2SESteps);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Read suffix index between passes: '%s'",SfxIndexMode == 0 ? "incrementally maintained" : SfxIndexMode == 1 ? "fully regenerated" : "incrementally maintained and verified");
 
 	if(szInArtReducfile[0] != '\0')
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Input artefact reduced packed reads file : '%s'",szInArtReducfile);
@@ -811,6 +824,7 @@ if (!argerrors)
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(MinPE2SEOvlp),"minpe2seovlp",&MinPE2SEOvlp);
 
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(PE2SESteps),"pe2sesteps",&PE2SESteps);
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(SfxIndexMode),"sfxindex",&SfxIndexMode);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(AllowSE2PE),"allowse2pe",&AllowSE2PE);
 
 		if(szSeedContigsFile[0] != '\0')
@@ -839,7 +853,7 @@ if (!argerrors)
 #endif
 	gStopWatch.Start();
 	Rslt = deNovoAssemble((etdeNovoPMode)PMode,TrimEnds,MinSeqLen,TrimPE2SE,AllowSE2PE == 0 ? false : true,SenseStrandOnly ? true : false,SingleEnded ? true : false,MaxPasses,PassThres,NReduceThresSteps,Subs100bp,End12Subs,
-							InitSEOvlp,FinSEOvlp,InitPEOvlp,FinPEOvlp,MinPE2SEOvlp,PE2SESteps,OrientatePE,NumThreads,bAffinity,szPE1File,szPE2File,szSeedContigsFile,szInArtReducfile,szOutFile);
+							InitSEOvlp,FinSEOvlp,InitPEOvlp,FinPEOvlp,MinPE2SEOvlp,PE2SESteps,OrientatePE,SfxIndexMode,NumThreads,bAffinity,szPE1File,szPE2File,szSeedContigsFile,szInArtReducfile,szOutFile);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -880,6 +894,7 @@ deNovoAssemble(etdeNovoPMode PMode,			// processing mode, currently either eAMEA
 		int MinPE2SEOvlp,					// minimal overlap of PE1 onto PE2 required to merge as SE
 		int PE2SESteps,						// when less than this many steps remaining then treat PE1 and PE2 as individual SE sequences if excessive lengths (defaults to 2, set 0 to disable)");
 		int OrientatePE,					// PE end orientations 0: sense/antisense, 1: sense/sense, 2: antisense/sense, 3: antisense/antisense 
+		int SfxIndexMode,					// read suffix index between passes 0: incrementally maintained, 1: fully regenerated, 2: incrementally maintained and verified against full regeneration
 		int NumThreads,						// number of worker threads to use
 		bool bAffinity,						// thread to core affinity
 		char *pszPE1File,					// optional input high confidence seed PE1 sequences file
@@ -899,6 +914,7 @@ pAssemble->Reset(false);
 pAssemble->SetPMode(PMode);
 pAssemble->SetNumThreads(NumThreads,bAffinity);
 pAssemble->SetSfxSparsity(eSSparsity15);
+pAssemble->SetSfxIndexMode((etSfxIndexMode)SfxIndexMode);
 SeqWrdBytes = pAssemble->GetSeqWrdBytes();
 
 // if not loading artefact reduced reads then need to preallocate memory 
@@ -1407,9 +1407,10 @@ CKangadna::MeetsMinPhredScoreThres(int QSSchema,	// quality scoring schema - gue
 			int MinMeanPhredScore,			// minimum allowed mean (over all read bases) Phred score
 			char *pszPhredScores)			// read ascii Phred scores
 {
-char Phred;
-char Phred0;
-int Score;
+int Phred0;
+int NumScores;
+int SumScores;
+int MinPhred;
 
 if(QSSchema == 0 || MinMeanPhredScore < 20 || pszPhredScores == NULL || pszPhredScores[0] == '\0')
 	return(true);
@@ -1426,18 +1427,10 @@ switch(QSSchema) {						// quality scoring schema - guestimated scoring schema -
 		break;
 	}
 
-int SumScores;
-int NumScores;
-
-NumScores = 0;
-SumScores = 1;
-while(Phred = *pszPhredScores++)
-	{
-	if((Score = (int)(Phred - Phred0)) < 10)	// if less than Phred 10 then this read is of dubious quality ...
-		return(false);
-	SumScores += Score;
-	NumScores += 1;
-	}
+NumScores = (int)strlen(pszPhredScores);
+SumScores = 1 + CSeqTrans::PhredDecode((UINT8 *)pszPhredScores,NumScores,NULL,Phred0,255,&MinPhred);
+if(MinPhred < 10)		// if less than Phred 10 then this read is of dubious quality ...
+	return(false);
 return( SumScores/NumScores >= MinMeanPhredScore ? true : false);
 }
 
@@ -2053,7 +2046,7 @@ if((Rslt=(teBSFrsltCodes)FastaPE1.FastaEstSizes(pszPE1File,NULL,NULL,NULL,NULL,N
 	return(Rslt);
 	}
 
-if((Rslt=(teBSFrsltCodes)FastaPE1.Open(pszPE1File,true,cMaxStageBuffSize))!=eBSFSuccess)
+if((Rslt=(teBSFrsltCodes)FastaPE1.Open(pszPE1File,true,cMaxStageBuffSize,CFasta::DecodeThreadsInBudget(m_NumThreads,m_Sequences.bPESeqs ? 2 : 1)))!=eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"LoadRawReads: Unable to open '%s' [%s] %s",pszPE1File,FastaPE1.ErrText((teBSFrsltCodes)Rslt),FastaPE1.GetErrMsg());
 	delete pFiltReadsPars;
@@ -2082,7 +2075,7 @@ if(m_Sequences.bPESeqs)
 		return(Rslt);
 		}
 
-	if((Rslt=(teBSFrsltCodes)FastaPE2.Open(pszPE2File,true,cMaxStageBuffSize))!=eBSFSuccess)
+	if((Rslt=(teBSFrsltCodes)FastaPE2.Open(pszPE2File,true,cMaxStageBuffSize,CFasta::DecodeThreadsInBudget(m_NumThreads,m_Sequences.bPESeqs ? 2 : 1)))!=eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"LoadRawReads: Unable to open '%s' [%s] %s",pszPE2File,FastaPE2.ErrText((teBSFrsltCodes)Rslt),FastaPE2.GetErrMsg());
 		delete pFiltReadsPars;
@@ -2530,7 +2523,7 @@ if((Rslt=(teBSFrsltCodes)FastaPE1.FastaEstSizes(pszPE1File,NULL,NULL,NULL,NULL,N
 	return(Rslt);
 	}
 
-if((Rslt=(teBSFrsltCodes)FastaPE1.Open(pszPE1File,true,cMaxStageBuffSize))!=eBSFSuccess)
+if((Rslt=(teBSFrsltCodes)FastaPE1.Open(pszPE1File,true,cMaxStageBuffSize,CFasta::DecodeThreadsInBudget(m_NumThreads,m_Sequences.bPESeqs ? 2 : 1)))!=eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"LoadRawReads: Unable to open '%s' [%s] %s",pszPE1File,FastaPE1.ErrText((teBSFrsltCodes)Rslt),FastaPE1.GetErrMsg());
 	delete pPE1RawReadsBuff;
@@ -2570,7 +2563,7 @@ if(m_Sequences.bPESeqs)
 		return(Rslt);
 		}
 
-	if((Rslt=(teBSFrsltCodes)FastaPE2.Open(pszPE2File,true,cMaxStageBuffSize))!=eBSFSuccess)
+	if((Rslt=(teBSFrsltCodes)FastaPE2.Open(pszPE2File,true,cMaxStageBuffSize,CFasta::DecodeThreadsInBudget(m_NumThreads,m_Sequences.bPESeqs ? 2 : 1)))!=eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"LoadRawReads: Unable to open '%s' [%s] %s",pszPE2File,FastaPE2.ErrText((teBSFrsltCodes)Rslt),FastaPE2.GetErrMsg());
 		FastaPE1.Close();
@@ -6383,6 +6376,75 @@ return(eBSFSuccess);
 
 
 
+// AllocSfxMem
+// alloc/realloc suffix array memory to hold at least ReqAllocMem bytes, existing allocation retained if within 20% of ReqAllocMem
+teBSFrsltCodes
+CKangadna::AllocSfxMem(UINT64 ReqAllocMem)	// alloc/realloc to at least ReqAllocMem (bytes)
+{
+if(m_Sequences.pSuffixArray != NULL && (m_Sequences.AllocMemSfx < ReqAllocMem || ((m_Sequences.AllocMemSfx * 10 ) > (ReqAllocMem * 12))))
+	{
+#ifdef _WIN32
+	free(m_Sequences.pSuffixArray);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
+#else
+	if(m_Sequences.pSuffixArray != MAP_FAILED)
+		munmap(m_Sequences.pSuffixArray,m_Sequences.AllocMemSfx);
+#endif	
+	m_Sequences.pSuffixArray = NULL;
+	m_Sequences.AllocMemSfx = 0;
+	}
+
+if(m_Sequences.pSuffixArray == NULL || m_Sequences.AllocMemSfx == 0)
+	{
+	m_Sequences.AllocMemSfx = ReqAllocMem; 
+#ifdef _WIN32
+	m_Sequences.pSuffixArray = (void *) malloc((size_t)m_Sequences.AllocMemSfx);	
+	if(m_Sequences.pSuffixArray == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"GenRdsSfx: Suffix array memory allocation of %llu bytes - %s",m_Sequences.AllocMemSfx,strerror(errno));
+		m_Sequences.AllocMemSfx = 0;
+		Reset(false);
+		return(eBSFerrMem);
+		}
+#else
+	if((m_Sequences.pSuffixArray = (void *)mmap(NULL,m_Sequences.AllocMemSfx, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0)) == MAP_FAILED)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"GenRdsSfx: Suffix array memory allocation of %llu bytes through mmap()  failed - %s",m_Sequences.AllocMemSfx,strerror(errno));
+		m_Sequences.pSuffixArray = NULL;
+		m_Sequences.AllocMemSfx = 0;
+		Reset(false);
+		return(eBSFerrMem);
+		}
+#endif
+	memset(m_Sequences.pSuffixArray,0,(size_t)m_Sequences.AllocMemSfx); // commits the memory!
+
+	UINT64 CurWorkSetSize = 0;
+	CurWorkSetSize = m_Sequences.AllocMemSeqs2Assemb + m_Sequences.AllocMemSeqStarts + m_Sequences.AllocMemSfx + m_Sequences.AllocMemSeqFlags;
+	if(CurWorkSetSize != m_CurMaxMemWorkSetBytes)
+		{
+		SetMaxMemWorkSetSize((size_t)CurWorkSetSize);
+		}
+	}
+return(eBSFSuccess);
+}
+
+
+// SortSfxEls
+// sort a run of suffix elements, of size ElSize, which are offsets into the current concatenated packed sequences
+void
+CKangadna::SortSfxEls(void *pSfxEls,		// suffix elements to be sorted
+				UINT64 NumEls,				// number of suffix elements
+				int ElSize)					// each suffix element is this size, 4 or 5 bytes
+{
+m_xpConcatSeqs = (UINT8 *)m_Sequences.pSeqs2Assemb;
+if(NumEls < 2)
+	return;
+if(ElSize == 5)
+	m_MTqsort.qsort(pSfxEls,NumEls,5,Sfx5SortSeqWrd4Func);
+else
+	m_MTqsort.qsort(pSfxEls,NumEls,sizeof(UINT32),SfxSortSeqWrd4Func);
+}
+
+
 // generate sfx over current concatenated packed sequences
 // sparse suffix so generated will be at complete (any partial < 15bp tSeqWrds will not be indexed) tSeqWrd4 boundaries
 // NOTE: sparse indexing (FirstNSeqWrds and ExcludeLastNSeqWrds only implemented for tSeqWrd4)
@@ -6469,52 +6531,9 @@ if(MaxSuffixEls > cMaxSfxBlkEls ||			// but if number of sfx elements > ~4G
 	LastSeqs2AssembOfs > cMaxSfxBlkEls)		// or tBaseWrds range is ~ 32bits 
 	ElSize += 1;							// then need to use 5 byte elements
 
-UINT64 ReqAllocMem;
-ReqAllocMem = (MaxSuffixEls * (UINT64)ElSize);
-
-if(m_Sequences.pSuffixArray != NULL && (m_Sequences.AllocMemSfx < ReqAllocMem || ((m_Sequences.AllocMemSfx * 10 ) > (ReqAllocMem * 12))))
-	{
-#ifdef _WIN32
-	free(m_Sequences.pSuffixArray);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
-#else
-	if(m_Sequences.pSuffixArray != MAP_FAILED)
-		munmap(m_Sequences.pSuffixArray,m_Sequences.AllocMemSfx);
-#endif	
-	m_Sequences.pSuffixArray = NULL;
-	m_Sequences.AllocMemSfx = 0;
-	}
-
-if(m_Sequences.pSuffixArray == NULL || m_Sequences.AllocMemSfx == 0)
-	{
-	m_Sequences.AllocMemSfx = ReqAllocMem; 
-#ifdef _WIN32
-	m_Sequences.pSuffixArray = (void *) malloc((size_t)m_Sequences.AllocMemSfx);	
-	if(m_Sequences.pSuffixArray == NULL)
-		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"GenRdsSfx: Suffix array memory allocation of %llu bytes - %s",m_Sequences.AllocMemSfx,strerror(errno));
-		m_Sequences.AllocMemSfx = 0;
-		Reset(false);
-		return(eBSFerrMem);
-		}
-#else
-	if((m_Sequences.pSuffixArray = (void *)mmap(NULL,m_Sequences.AllocMemSfx, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0)) == MAP_FAILED)
-		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"GenRdsSfx: Suffix array memory allocation of %llu bytes through mmap()  failed - %s",m_Sequences.AllocMemSfx,strerror(errno));
-		m_Sequences.pSuffixArray = NULL;
-		m_Sequences.AllocMemSfx = 0;
-		Reset(false);
-		return(eBSFerrMem);
-		}
-#endif
-	memset(m_Sequences.pSuffixArray,0,(size_t)m_Sequences.AllocMemSfx); // commits the memory!
-
-	UINT64 CurWorkSetSize = 0;
-	CurWorkSetSize = m_Sequences.AllocMemSeqs2Assemb + m_Sequences.AllocMemSeqStarts + m_Sequences.AllocMemSfx + m_Sequences.AllocMemSeqFlags;
-	if(CurWorkSetSize != m_CurMaxMemWorkSetBytes)
-		{
-		SetMaxMemWorkSetSize((size_t)CurWorkSetSize);
-		}
-	}
+teBSFrsltCodes Rslt;
+if((Rslt = AllocSfxMem(MaxSuffixEls * (UINT64)ElSize)) != eBSFSuccess)
+	return(Rslt);
 
 // allocation completed now into the real business of sorting
 m_Sequences.SfxElSize = ElSize;
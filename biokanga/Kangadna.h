@@ -1156,6 +1156,12 @@ static const int cLevenshteinPacBioMismatch = 2;  // PacBio has very low rates o
 
 	teBSFrsltCodes AllocSeqs2AssembMem(UINT64 ReqAllocSize);	// alloc/realloc to at least ReqAllocSize (bytes)
 
+	teBSFrsltCodes AllocSfxMem(UINT64 ReqAllocMem);		// alloc/realloc suffix array to at least ReqAllocMem (bytes)
+
+	void SortSfxEls(void *pSfxEls,		// suffix elements to be sorted
+				UINT64 NumEls,				// number of suffix elements
+				int ElSize);				// each suffix element is this size, 4 or 5 bytes
+
 	teBSFrsltCodes AllocBlockNsLoci(UINT32 ReqAllocBlocks);		// alloc/realloc to at least ReqAllocSize (tsBlockNsLoci)
 
 	
@@ -1346,7 +1346,7 @@ int FeatEnd;
 char FeatStrand;
 char szFeatChrom[cMaxDatasetSpeciesChrom+1];
 char szFeatName[cMaxGeneNameLen+1];
-int Nth;
+tsBEDOverlapCursor OverlapCursor;
 
 // assume unable to locate a nearby feature
 if(pROI->USFeatDist < 0)
@@ -1367,8 +1367,8 @@ if(m_pDistBEDFile == NULL || ROIChromID < 1)
 	return(false);
 
 // check if contained or even partially overlapping a feature
-Nth = 0;
-while((FeatID = m_pDistBEDFile->LocateFeatureIDinRangeOnChrom(ROIChromID,pROI->StartOfRegion,pROI->EndOfRegion,++Nth)) > 0)
+m_pDistBEDFile->InitOverlapCursor(&OverlapCursor,ROIChromID,pROI->StartOfRegion,pROI->EndOfRegion);
+while((FeatID = m_pDistBEDFile->NextOverlapFeatureID(&OverlapCursor)) > 0)
 	{
 	Rslt = m_pDistBEDFile->GetFeature(FeatID,szFeatName,szFeatChrom,&FeatStart,&FeatEnd,NULL,&FeatStrand);
 	if(FiltStrand != '*' && FeatStrand != FiltStrand)
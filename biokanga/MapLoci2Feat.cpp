@@ -114,6 +114,7 @@ CMapLoci2Feat::MapLoci2Features(char *pszRsltsFile)
 	int Features;
 	int AccumFeatures;
 	int NumFeatsOverlap;
+	tsBEDOverlapCursor OverlapCursor;
 	int FeatMsk;
 	int FeatIdx;
 	UINT32 ElID;
@@ -383,12 +384,12 @@ CMapLoci2Feat::MapLoci2Features(char *pszRsltsFile)
 				// see if overlapping any features
 				AccumFeatures = 0;
 				NumFeatsOverlap = 0;
+				m_pBiobed->InitOverlapCursor(&OverlapCursor,ChromID,	// feature is on which chromosome
+															CoreStartLoci,		// feature must end on or after Start
+															CoreEndLoci);		// and start on or before End
 				do
 				{
-					FeatID = m_pBiobed->LocateFeatureIDinRangeOnChrom(ChromID,	// feature is on which chromosome
-																	  CoreStartLoci,						// feature must end on or after Start
-																	  CoreEndLoci,						// and start on or before End 
-																	  NumFeatsOverlap + 1);				// Ith instance to return (1..n)
+					FeatID = m_pBiobed->NextOverlapFeatureID(&OverlapCursor);
 
 					if (FeatID > 0 && m_pFeatCntDists != NULL)
 					{
@@ -899,6 +899,8 @@ m_hQScoreDistRptFile = -1;
 m_hErrFreeReadDistRptFile = -1;
 m_hDuplicatesDistRptFile = -1;
 m_hReadLenDistRptFile = -1;
+for(int Phred = 0; Phred < 42; Phred++)
+	m_ProbNoBaseErr[Phred] = 1.0 - (1.0 / pow(10.0,(double)Phred/10.0));
 Init();
 }
 
@@ -2622,7 +2624,7 @@ if(bIsSAMfile)
 	}
 else
 	{
-	if ((Rslt = (teBSFrsltCodes)FastaPE1.Open(pPE1File->szFileName, true, cDfltStageBuffSize)) != eBSFSuccess)
+	if ((Rslt = (teBSFrsltCodes)FastaPE1.Open(pPE1File->szFileName, true, cDfltStageBuffSize, CFasta::DecodeThreadsInBudget(m_NumThreads,m_bPEProc ? 2 : 1))) != eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "(Instance %d) Thread %d: Unable to open '%s' [%s] %s", pThread->ProcessingID, pThread->ThreadIdx, pPE1File->szFileName, FastaPE1.ErrText((teBSFrsltCodes)Rslt), FastaPE1.GetErrMsg());
 		return(Rslt);
@@ -2637,7 +2639,7 @@ else
 
 	if (m_bPEProc)
 		{
-		if ((Rslt = (teBSFrsltCodes)FastaPE2.Open(pPE2File->szFileName, true, cDfltStageBuffSize)) != eBSFSuccess)
+		if ((Rslt = (teBSFrsltCodes)FastaPE2.Open(pPE2File->szFileName, true, cDfltStageBuffSize, CFasta::DecodeThreadsInBudget(m_NumThreads,m_bPEProc ? 2 : 1))) != eBSFSuccess)
 			{
 			gDiagnostics.DiagOut(eDLFatal, gszProcName, "(Instance %d) Thread %d: Unable to open '%s' [%s] %s", pThread->ProcessingID, pThread->ThreadIdx, pPE2File->szFileName, FastaPE2.ErrText((teBSFrsltCodes)Rslt), FastaPE2.GetErrMsg());
 			FastaPE1.Close();
@@ -3293,11 +3295,10 @@ CReadStats::AccumQScores(tsThreadNGSQCPars *pThread, // thread specific processi
 {
 int MinScore;
 int SeqOfs;
-int Score;
 int SumBaseScores;
 int MeanReadScore;
-double ProbErr;
 double ProbNoReadErr;
+UINT8 Phreds[cMaxRSSeqLen];
 UINT32 Scores[cMaxRSSeqLen];
 UINT32 Ns[cMaxRSSeqLen];
 UINT32 *pScores;
@@ -3317,54 +3318,27 @@ else
 	bTrunc = false;
 
 // scores are parsed into a local copy then when sequence completely parsed then the local copy is updated into the global scores within a single serialisation lock
-MinScore = 0;
+// scores are forced to always be in the range 0..41 --- shouldn't be outside 0..41 but some qscores have been observed to be outside the expected range!
+if(QSSchema == 0 || pQScores == NULL)	// no scoring
+	{
+	memset(Phreds,cDfltPhredScore,ReadLen);
+	SumBaseScores = cDfltPhredScore * ReadLen;
+	MinScore = cDfltPhredScore;
+	}
+else									// Solexa ';' (-5), Illumina 1.3+ '@' (0) and Illumina 1.5+ 'B' (2) to 'h' (40) are decoded relative to '@', Illumina 1.8+ '#' (2) or Sanger '!' (0) to 'J' (41) relative to '!'
+	SumBaseScores = CSeqTrans::PhredDecode(pQScores,ReadLen,Phreds,QSSchema == 4 ? '!' : '@',41,&MinScore);
+
 ProbNoReadErr = 1.0;
-SumBaseScores = 0;
 pScore = Scores;
 pNs = Ns;
-for (SeqOfs = 0; SeqOfs < ReadLen; SeqOfs++, pSeq++, pNs++, pScore++,pQScores++)
+for (SeqOfs = 0; SeqOfs < ReadLen; SeqOfs++, pSeq++, pNs++, pScore++)
 	{
 	if(*pSeq > eBaseT)
 		*pNs = 1;
 	else
 		*pNs = 0;
-	
-	switch(QSSchema) { // quality scoring schema - guestimated scoring schema - 0: no scoring, 1: Solexa, 2: Illumina 1.3+, 3: Illumina 1.5+, 4: Illumina 1.8+ or Sanger 
-		case 1:	// Solexa  ';' (-5) to 'h' (40)
-			if(*pQScores <= '@')
-				Score = 0;
-			else
-				Score = (int)(*pQScores - (UINT8)'@');
-			break;
-
-		case 2: // Illumina 1.3+ '@' (0) to 'h' (40)
-			Score = (int)(*pQScores - (UINT8)'@');
-			break;
-
-		case 3: // Illumina 1.5+ 'B' (2) to 'h' (40)
-			Score = (int)(*pQScores - (UINT8)'@');
-			break;
-
-		case 4: // Illumina 1.8+ or Sanger. Sanger is '!' (0) to 'J' (41) and Illumina is '#' (2) to 'J' (41)
-			Score = (int)(*pQScores - (UINT8)'!');
-			break;
-			
-		case 0:	// no scoring
-			Score = cDfltPhredScore;
-			break;
-			}
-	if(Score < 0)			// force scores to always be in the range 0..41 --- shouldn't be outside 0..41 but some qscores have been observed to be outside the expected range!
-		Score = 0;
-	else
-		if(Score > 41)
-			Score = 41;
-	*pScore = (UINT32)Score;
-
-	ProbErr = 1.0 / pow(10.0,(double)Score/10.0);
-	ProbNoReadErr *= (1.0 - ProbErr); 
-	SumBaseScores += Score;
-	if(MinScore == 0 || MinScore > Score)
-		MinScore = Score;
+	*pScore = (UINT32)Phreds[SeqOfs];
+	ProbNoReadErr *= m_ProbNoBaseErr[Phreds[SeqOfs]]; 
 	}
 MeanReadScore = SumBaseScores /  ReadLen;
 
@@ -166,6 +166,7 @@ class CReadStats
 	int m_MaxReadLen;			// maximum length read processed
 	UINT32 m_ReadLenDist[cMaxRSSeqLen+2]; // read length distributions, includes count m_ReadLenDist[cMaxRSSeqLen+1] of reads which were truncated to cMaxRSSeqLen
 	UINT64 m_ProbNoReadErrDist[100];	// probabilities of read being error free distributions 
+	double m_ProbNoBaseErr[42];		// probability of base being error free indexed by Phred score 0..41
 
 	int m_hReadLenDistRptFile;		// file handle for read length distributions report file
 	char m_szReadLenDistRptFile[_MAX_PATH];	//  read length distributions report file
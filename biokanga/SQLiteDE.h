@@ -17,6 +17,9 @@ const int cMaxTransIdntDescrLen = 200;	// allow experiment conditions, and other
 
 const int cMaxMRATrans = 100;		// cache the last 100 transcript identifiers
 
+const int cDERowsPerInsert = 32;	// bulk loaded rows are inserted using multirow inserts of this many rows (SQLite defaults to limiting bound values to 999)
+const int cDEMaxBulkVals = 27;		// bulk loaded rows have at most this many values, including the explicitly assigned row identifier
+
 typedef struct TAG_sDEStmsSQL {
 	char *pTblName;					// table name
 	char *pszCreateTbl;				// SQL statement used to create the table
@@ -28,6 +31,24 @@ typedef struct TAG_sDEStmsSQL {
 	char *pszDropIndexes;			// SQL statement used to drop indexes on this table
 } tsDEStmSQL;
 
+typedef enum TAG_eDEBulkTbl {
+	eDEBTExpres = 0,				// bulk loading TblExpres
+	eDEBTBins,						// bulk loading TblBins
+	eDEBTNumTbls					// placeholder for number of bulk loaded tables
+} etDEBulkTbl;
+
+typedef struct TAG_sDEBulkIns {
+	int TblIdx;						// rows are inserted into this m_StmSQL[] table
+	char *pszRowIDName;				// row identifier column, identifiers are explicitly assigned when bulk loading
+	int NumVals;					// number of values in each row, including the row identifier
+	int RealVals;					// bitmap of values, bit 0 being the row identifier, which are REAL; all other values are INTEGER
+	int LastRowID;					// last row identifier assigned
+	int NumRows;					// number of rows currently buffered
+	sqlite3_stmt *pPrepInsert;		// prepared single row insert of an explicitly identified row
+	sqlite3_stmt *pPrepInserts;		// prepared multirow insert of cDERowsPerInsert explicitly identified rows
+	double Rows[cDERowsPerInsert][cDEMaxBulkVals];	// buffered row values
+} tsDEBulkIns;
+
 typedef struct TAG_sMRATrans {
 	char szTransName[cMaxTransNameLen+1];	// transcript name
 	int TransID;						// SQLite allocated transcript identifier
@@ -40,6 +61,7 @@ class CSQLiteDE
 	sqlite3 *m_pDB;						// pts to instance of SQLite
 	int m_NumTransMRA;					// number of entries in MRA transcript table
 	static tsDEStmSQL m_StmSQL[4];		// SQLite table and index statements
+	static tsDEBulkIns m_BulkIns[eDEBTNumTbls];	// bulk loaded tables, only used when not m_bSafe
 	tsMRATrans m_MRATrans[cMaxMRATrans];	// MRA transcripts
 
 	bool m_bSafe;						// true if safe select required rather than simply getting last assigned ROWID
@@ -53,6 +75,19 @@ class CSQLiteDE
 	int
 		CloseDatabase(bool bNoIndexes = false);
 
+	int PrepBulkInserts(void);			// prepare bulk load insert statements
+	void FinalizeBulkInserts(void);		// finalize bulk load insert statements
+
+	int									// returned explicitly assigned row identifier
+		BulkInsertRow(etDEBulkTbl BulkTbl,	// buffer row for bulk loading into this table
+				double *pVals);			// row values, excluding the row identifier
+
+	int
+		FlushBulkRows(tsDEBulkIns *pBulkIns);	// insert all rows currently buffered for this table
+
+	int
+		FlushBulkInserts(void);			// insert all rows currently buffered for all bulk loaded tables
+
 	int												// errors if < eBSFSuccess, if positive then the ExprID
 		CreateExperiment(int CSVtype,				// 0 if short form, 1 if including individual bin counts
 					char *pszInFile,				// CSV file containing expression analysis results
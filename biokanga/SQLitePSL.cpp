@@ -95,9 +95,9 @@ tsStmSQL CSQLitePSL::m_StmSQL[4] = {   // 4 tables; TblExprs, TblAlignments, Tbl
 		(char *)"INSERT INTO TblAlignments (ExprID,Score,Identity,Matches,Mismatches,RepMatches,NCount,QNumInDels,QBasesInDels,TNumInDels,TBasesInDels,Strand,QName,QSize,QStart,QEnd,TName,TSize,TStart,TEnd,NumBlocks) VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)",
 		NULL,
 		(char *)"CREATE INDEX IF NOT EXISTS 'TblAlignments_ExprID' ON 'TblAlignments' ('ExprID' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_QName' ON 'TblAlignments' ('QName' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_TName' ON 'TblAlignments' ('TName' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Score' ON 'TblAlignments' ('Score' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Identity' ON 'TblAlignments' ('Identity' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Matches' ON 'TblAlignments' ('Matches' ASC)",
-		(char *)"CREATE INDEX IF NOT EXISTS 'TblAlignments_ExprID' ON 'TblAlignments' ('ExprID' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_QName' ON 'TblAlignments' ('QName' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_TName' ON 'TblAlignments' ('TName' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Score' ON 'TblAlignments' ('Score' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Identity' ON 'TblAlignments' ('Identity' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Matches' ON 'TblAlignments' ('Matches' ASC)",
+		NULL,
 		(char *)"DROP INDEX IF EXISTS 'TblAlignments_ExprID';DROP INDEX IF EXISTS 'TblAlignments_QName';DROP INDEX IF EXISTS 'TblAlignments_TName';DROP INDEX IF EXISTS 'TblAlignments_Score';DROP INDEX IF EXISTS 'TblAlignments_Identity';DROP INDEX IF EXISTS 'TblAlignments_Matches';CREATE INDEX IF NOT EXISTS 'TblAlignments_ExprID' ON 'TblAlignments' ('ExprID' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_QName' ON 'TblAlignments' ('QName' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_TName' ON 'TblAlignments' ('TName' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Score' ON 'TblAlignments' ('Score' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Identity' ON 'TblAlignments' ('Identity' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignments_Matches' ON 'TblAlignments' ('Matches' ASC)",
-		NULL },
+		(char *)"DROP INDEX IF EXISTS 'TblAlignments_ExprID';DROP INDEX IF EXISTS 'TblAlignments_QName';DROP INDEX IF EXISTS 'TblAlignments_TName';DROP INDEX IF EXISTS 'TblAlignments_Score';DROP INDEX IF EXISTS 'TblAlignments_Identity';DROP INDEX IF EXISTS 'TblAlignments_Matches'" },
 	{(char *)"TblAlignmentBlocks",
 		(char *)"CREATE TABLE TblAlignmentBlocks (BlockID INTEGER PRIMARY KEY ASC,ExprID INTEGER,AlignmentID INTEGER,BlockSize INTEGER,QStart INTEGER,TStart INTEGER, FOREIGN KEY (AlignmentID) REFERENCES TblAlignments(AlignmentID))",
 		(char *)"INSERT INTO TblAlignmentBlocks (ExprID,AlignmentID,BlockSize,QStart,TStart) VALUES(?,?,?,?,?)",
@@ -112,9 +112,9 @@ tsStmSQL CSQLitePSL::m_StmSQL[4] = {   // 4 tables; TblExprs, TblAlignments, Tbl
 		(char *)"INSERT INTO TblAlignSummaries (ExprID,IsQuery,SeqName,SeqLen,NumAlignments) VALUES(?,?,?,?,?)",
 		NULL,
 		(char *)"CREATE INDEX IF NOT EXISTS 'TblAlignSummaries_ExprID' ON 'TblAlignSummaries' ('ExprID' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignSummaries_SeqName' ON 'TblAlignSummaries' ('SeqName' ASC)",
-		(char *)"CREATE INDEX IF NOT EXISTS 'TblAlignSummaries_ExprID' ON 'TblAlignSummaries' ('ExprID' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignSummaries_SeqName' ON 'TblAlignSummaries' ('SeqName' ASC)",
+		NULL,
 		(char *)"DROP INDEX IF EXISTS 'TblAlignSummaries_ExprID';DROP INDEX IF EXISTS 'TblAlignSummaries_SeqName'; CREATE INDEX IF NOT EXISTS 'TblAlignSummaries_ExprID' ON 'TblAlignSummaries' ('ExprID' ASC);CREATE INDEX IF NOT EXISTS 'TblAlignSummaries_SeqName' ON 'TblAlignSummaries' ('SeqName' ASC)",
-		NULL
+		(char *)"DROP INDEX IF EXISTS 'TblAlignSummaries_ExprID';DROP INDEX IF EXISTS 'TblAlignSummaries_SeqName'"
 		 }
 	};
 
@@ -122,8 +122,21 @@ tsStmSQL CSQLitePSL::m_StmSQL[4] = {   // 4 tables; TblExprs, TblAlignments, Tbl
 CSQLitePSL::CSQLitePSL(void)
 {
 m_pDB = NULL;
-m_pInBuffer = NULL;		
-m_pszPSLLineBuff = NULL;
+m_pCarryChrs = NULL;
+m_NumCarryChrs = 0;
+m_NumParseThreads = 0;
+m_NumPSLBatches = 0;
+m_pPSLBatches = NULL;
+m_NxtReadBatchSeq = 0;
+m_NxtWriteBatchSeq = 0;
+m_bPSLEOF = false;
+m_PipelineRslt = eBSFSuccess;
+m_LastAlignmentID = 0;
+m_NumSortThreads = 0;
+m_ValidatedExprID = 0;
+m_pPrepInsertAligns = NULL;
+m_pPrepInsertAlign = NULL;
+m_pPrepInsertBlocks = NULL;
 m_hPSLinFile = -1;
 
 m_NumAlignSummaries = 0;
@@ -135,27 +148,35 @@ m_NumAlignments = 0;
 m_NumBlatHitsParsed = 0;
 m_NumBlatHitsAccepted = 0;
 m_NumBlocks = 0;
-m_NumInBuffer = 0;	
-m_InBuffIdx = 0;	
-m_PushedBack = 0;	
-m_CurLineLen = 0;
-m_AllocdInBuffer = 0;
-m_AllocdPSLLineBuffer = 0;
+#ifdef _WIN32
+InitializeCriticalSection(&m_hBatchMtx);
+InitializeConditionVariable(&m_hBatchFreeCond);
+InitializeConditionVariable(&m_hBatchParsedCond);
+#else
+pthread_mutex_init(&m_hBatchMtx,NULL);
+pthread_cond_init(&m_hBatchFreeCond,NULL);
+pthread_cond_init(&m_hBatchParsedCond,NULL);
+#endif
 }
 
 
 CSQLitePSL::~CSQLitePSL(void)
 {
+FinalizeBulkInserts();
 if(m_pDB != NULL)
 	{
 	sqlite3_close_v2(m_pDB);
 	sqlite3_shutdown();
 	m_pDB = NULL;
 	}
-if(m_pInBuffer != NULL)
-	delete m_pInBuffer;
-if(m_pszPSLLineBuff != NULL)
-	delete m_pszPSLLineBuff;
+FreePSLBatches();
+#ifdef _WIN32
+DeleteCriticalSection(&m_hBatchMtx);
+#else
+pthread_cond_destroy(&m_hBatchParsedCond);
+pthread_cond_destroy(&m_hBatchFreeCond);
+pthread_mutex_destroy(&m_hBatchMtx);
+#endif
 if(m_pAlignmentSummaries != NULL)
 	{
 #ifdef _WIN32
@@ -341,6 +362,8 @@ int TblIdx;
 int Rslt = 0;
 tsStmSQL *pStms;
 pStms = m_StmSQL;
+FinalizeBulkInserts();
+m_ValidatedExprID = 0;
 if(m_pDB != NULL)
 	{
 	if(!bNoIndexes)
@@ -700,16 +723,19 @@ char szSeqTarg[200];
 if(m_pDB == NULL)
 	return(eBSFerrInternal);
 
-ChkExprID = -1;
-
-	// not a recently accessed experiment so need to check if already known to SQLite
-sprintf(szSeqTarg,"select ExprID from TblExprs where ExprID = %d",ExprID);
-sqlite3_exec(m_pDB,szSeqTarg,ExecCallbackID,&ChkExprID,NULL);
-
-if(ChkExprID == -1)	// will be -1 if not already in database, treat as error
+if(ExprID != m_ValidatedExprID)
 	{
-	CloseDatabase(true);
-	return(eBSFerrInternal);
+	// not the last validated experiment so need to check if already known to SQLite
+	ChkExprID = -1;
+	sprintf(szSeqTarg,"select ExprID from TblExprs where ExprID = %d",ExprID);
+	sqlite3_exec(m_pDB,szSeqTarg,ExecCallbackID,&ChkExprID,NULL);
+
+	if(ChkExprID == -1)	// will be -1 if not already in database, treat as error
+		{
+		CloseDatabase(true);
+		return(eBSFerrInternal);
+		}
+	m_ValidatedExprID = ExprID;
 	}
 
 // validated that the experiment instance identifier is already known to SQLite so can add this alignment instance
@@ -911,6 +937,8 @@ char *pszBeginTransaction = (char *)"BEGIN TRANSACTION";
 char *pszPragmaSyncOff = (char *)"PRAGMA synchronous = OFF";
 
 char *pszPragmaJournMem = (char *)"PRAGMA journal_mode = MEMORY";
+tsStmSQL *pStms;
+int TblIdx;
 
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"sqlite - populating tables");
 
@@ -922,6 +950,28 @@ if((sqlite_error = sqlite3_exec(m_pDB,pszPragmaSyncOff,NULL,NULL,NULL))!=SQLITE_
 	return(eBSFerrInternal);
 	}
 
+// when appending the on disk rollback journal is retained so alignments from earlier experiments can be recovered should loading fail
+if(m_PMode == 0 && (sqlite_error = sqlite3_exec(m_pDB,pszPragmaJournMem,NULL,NULL,NULL))!=SQLITE_OK)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't keep rollback journal in memory: %s", sqlite3_errmsg(m_pDB)); 
+	CloseDatabase(true);
+	return(eBSFerrInternal);
+	}
+
+// indexes on the bulk loaded tables are deferred until all rows have been inserted
+pStms = m_StmSQL;
+for(TblIdx = 0; TblIdx < 4; TblIdx++,pStms++)
+	{
+	if(pStms->pszDropIndexes == NULL)
+		continue;
+	if((sqlite_error = sqlite3_exec(m_pDB,pStms->pszDropIndexes,0,0,0))!=SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't drop indexes on table %s : %s", pStms->pTblName,sqlite3_errmsg(m_pDB));
+		CloseDatabase(true);
+		return(eBSFerrInternal);
+		}
+	}
+
 // bracket inserts as a single transaction
 if((sqlite_error = sqlite3_exec(m_pDB,pszBeginTransaction,NULL,NULL,NULL))!=SQLITE_OK)
 	{
@@ -939,6 +989,7 @@ CSQLitePSL::EndPopulatingTables(void)
 int sqlite_error;
 char *pszEndTransaction = (char *)"END TRANSACTION";
 char *pszPragmaSyncOn = (char *)"PRAGMA synchronous = ON";
+char szPragmaThreads[100];
 AddSummaryInstances2SQLite();
 
 	// end transaction
@@ -952,6 +1003,13 @@ gDiagnostics.DiagOut(eDLInfo,gszProcName,"Completed populating the sqlite databa
 
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Generating indexes ...");
 
+// if there are cores to spare then allow SQLite to use worker threads when sorting index keys
+if(m_NumSortThreads > 0)
+	{
+	sprintf(szPragmaThreads,"PRAGMA threads = %d",m_NumSortThreads);
+	sqlite3_exec(m_pDB,szPragmaThreads,NULL,NULL,NULL);
+	}
+
 tsStmSQL *pStms;
 pStms = m_StmSQL;
 int TblIdx;
@@ -994,7 +1052,8 @@ CSQLitePSL::ProcessPSL2SQLite(int PMode,		// processing mode, 0 to delete any ex
 					char *pszTargetFile,		// against targeted sequences in this file
 					char *pszExprDescr,			// describes experiment
 					char *pszBlatParams,		// Blat parameters used
-					int ExprType)				// experiment type, currently just a place holder and defaults to 0
+					int ExprType,				// experiment type, currently just a place holder and defaults to 0
+					int NumThreads)				// number of parser threads feeding the SQLite writer
 
 {
 int Rslt;
@@ -1003,6 +1062,7 @@ int ExprID;
 sqlite3_stmt *prepstatement = NULL;
 
 m_PMode = PMode;
+m_NumSortThreads = min(NumThreads - 1,cSQLitePSLSortThreads);
 m_MinIdentity = MinIdentity;
 m_MinScore = MinScore;
 m_MinMatches = MinMatches;
@@ -1026,7 +1086,7 @@ if((Rslt=BeginPopulatingTables())!=eBSFSuccess)
 	return(Rslt);
 
 
-if((Rslt = ProcessPSLFile(pszPSLFile,ExprID)) < eBSFSuccess)
+if((Rslt = ProcessPSLFile(pszPSLFile,ExprID,NumThreads)) < eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile failed: %s",pszPSLFile); 
 	CloseDatabase(true);
@@ -1041,191 +1101,743 @@ return(eBSFSuccess);
 }
 
 
+// ParsePSLInt
+// skips any leading whitespace then parses optionally signed decimal integer, returns false if no integer could be parsed
+static inline bool
+ParsePSLInt(char **ppChr,	// parse starting from this char, updated to char immediately following parsed integer
+			int *pVal)		// returned integer value
+{
+char *pEnd;
+long Val;
+Val = strtol(*ppChr,&pEnd,10);
+if(pEnd == *ppChr)
+	return(false);
+*pVal = (int)Val;
+*ppChr = pEnd;
+return(true);
+}
+
+// ParsePSLToken
+// skips any leading whitespace then returns ptr to, and length of, next whitespace delimited token, returns false if no token
+static inline bool
+ParsePSLToken(char **ppChr,	// parse starting from this char, updated to char immediately following token
+			char **ppToken,	// returned ptr to start of token
+			int *pLen)		// returned token length
+{
+char *pChr = *ppChr;
+while(*pChr != '\0' && isspace(*pChr))
+	pChr++;
+if(*pChr == '\0')
+	return(false);
+*ppToken = pChr;
+while(*pChr != '\0' && !isspace(*pChr))
+	pChr++;
+*pLen = (int)(pChr - *ppToken);
+*ppChr = pChr;
+return(true);
+}
+
+// ParsePSLBlockVals
+// parses NumBlocks comma separated block values, as in "10,20,30," with the trailing comma optional
+static bool
+ParsePSLBlockVals(char **ppChr,		// parse starting from this char, updated to char immediately following values
+			int NumBlocks,			// number of values to parse
+			int *pVals)				// returned values
+{
+int BlockIdx;
+char *pChr = *ppChr;
+for(BlockIdx = 0; BlockIdx < NumBlocks; BlockIdx++)
+	{
+	if(!ParsePSLInt(&pChr,pVals++))
+		return(false);
+	while(*pChr != '\0' && isspace(*pChr))
+		pChr++;
+	if(*pChr == ',')
+		pChr++;
+	}
+*ppChr = pChr;
+return(true);
+}
+
 //
-// ProcessPSLline
-// 
+// ParsePSLline
+// Parse PSL line, if alignment is accepted then the alignment is appended to pBatch
+// Returns 0 if header or alignment not accepted, 1 if accepted, < 0 if errors
+// Called by parser threads so must only access batch owned or read only instance state
 int
-CSQLitePSL::ProcessPSLline(int ExprID)		// parse alignment PSL line which is in this experiment
+CSQLitePSL::ParsePSLline(char *pszLine,			// parse this '\0' terminated PSL line
+					tsPSLBatch *pBatch)			// and if accepted then append alignment to this batch
 {
-int AlignmentID;
-int Cnt;
-int Psn;
-int BlockIdx;
 char *pChr;
-
-int Score;
-int Identity;
-
-int Matches;			// number of matches which aren't repeats
-int Mismatches;			// number of bases which do not match
-int RepMatches;			// number of bases which match but are also repeats
-int NCount;				// number of N bases
-int QNumInDels;			// number of InDel seqs in query
-int QBasesInDels;		// number of bases total in all InDels in query
-int TNumInDels;			// number of InDel seqs in target
-int TBasesInDels;		// number of bases total in all InDels in target
-char szStrand[10];		// '+' or '-' for query strand, optionally followed by '+' or '-' for target genomic strand when using translated alignments
-char szQName[cMaxSeqNameLen+1];			// query sequence name
-int  QSize;				// query sequence size
-int  QStart;			// alignment start psn in query
-int  QEnd;				// alignment end psn in query
-char szTName[cMaxSeqNameLen+1];			// target sequence name
-int  TSize;				// target sequence size
-int  TStart;			// alignment start psn in target
-int  TEnd;				// alignment end psn in target
-int  NumBlocks;			// number of blocks in the alignment
-int  BlockSizes[cMaxNumPSLblocks];		// array of sizes of each block
-int  QStarts[cMaxNumPSLblocks];			// starting psn of each block in query
-int  TStarts[cMaxNumPSLblocks];			// starting psn of each block in target
-
-m_pszPSLLineBuff[m_CurLineLen] = '\0';	
-pChr = (char *)m_pszPSLLineBuff;
+char *pszStrand;
+char *pszQName;
+char *pszTName;
+int StrandLen;
+int QNameLen;
+int TNameLen;
+int *pBlockSizes;
+int *pQStarts;
+int *pTStarts;
+tsPSLAlign *pAlign;
+tsPSLAlign Align;
+
+pChr = pszLine;
 while(isspace(*pChr))
 	pChr++;
 if(!isdigit(*pChr))	// assume header line if not a digit	
 	return(0);
 
-Cnt = sscanf(pChr,"%d %d %d %d %d %d %d %d %n",
-				&Matches,&Mismatches,&RepMatches,&NCount,&QNumInDels,
-				&QBasesInDels,&TNumInDels,&TBasesInDels,&Psn);
-if(Cnt != 8)
-	{
-	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLline: Unable to parse line '%s' from input PSL file - %s", m_pszPSLLineBuff,m_szPSLinFile);
+if(!(ParsePSLInt(&pChr,&Align.Matches) && ParsePSLInt(&pChr,&Align.Mismatches) && ParsePSLInt(&pChr,&Align.RepMatches) &&
+	 ParsePSLInt(&pChr,&Align.NCount) && ParsePSLInt(&pChr,&Align.QNumInDels) && ParsePSLInt(&pChr,&Align.QBasesInDels) &&
+	 ParsePSLInt(&pChr,&Align.TNumInDels) && ParsePSLInt(&pChr,&Align.TBasesInDels) &&
+	 ParsePSLToken(&pChr,&pszStrand,&StrandLen) && StrandLen <= 2 &&
+	 ParsePSLToken(&pChr,&pszQName,&QNameLen) && QNameLen <= cMaxSeqNameLen &&
+	 ParsePSLInt(&pChr,&Align.QSize) && ParsePSLInt(&pChr,&Align.QStart) && ParsePSLInt(&pChr,&Align.QEnd) &&
+	 ParsePSLToken(&pChr,&pszTName,&TNameLen) && TNameLen <= cMaxSeqNameLen &&
+	 ParsePSLInt(&pChr,&Align.TSize) && ParsePSLInt(&pChr,&Align.TStart) && ParsePSLInt(&pChr,&Align.TEnd) &&
+	 ParsePSLInt(&pChr,&Align.NumBlocks) && Align.NumBlocks >= 1 && Align.NumBlocks <= cMaxNumPSLblocks))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ParsePSLline: Unable to parse line '%s' from input PSL file - %s", pszLine,m_szPSLinFile);
 	return(eBSFerrParse);
 	}
 
-pChr += Psn;
-Cnt = sscanf(pChr,"%s %s %d %d %d %s %d %d %d %d %n",
-				szStrand,szQName,&QSize,&QStart,&QEnd,
-				szTName,&TSize,&TStart,&TEnd,&NumBlocks,&Psn);
-if(Cnt != 10)
+// block values are parsed directly into the batch, only retained if the alignment is accepted
+if((pBatch->NumBlockVals + (3 * Align.NumBlocks)) > pBatch->AllocdBlockVals)
 	{
-	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLline: Unable to parse line '%s' from input PSL file - %s", m_pszPSLLineBuff,m_szPSLinFile);
+	UINT32 AllocdBlockVals = (pBatch->AllocdBlockVals * 2) + (3 * cMaxNumPSLblocks);
+	int *pBlocks;
+	if((pBlocks = (int *)realloc(pBatch->pBlocks,AllocdBlockVals * sizeof(int))) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ParsePSLline: Memory reallocation to %lld bytes for alignment blocks failed",(INT64)AllocdBlockVals * sizeof(int));
+		return(eBSFerrMem);
+		}
+	pBatch->pBlocks = pBlocks;
+	pBatch->AllocdBlockVals = AllocdBlockVals;
+	}
+pBlockSizes = &pBatch->pBlocks[pBatch->NumBlockVals];
+pQStarts = &pBlockSizes[Align.NumBlocks];
+pTStarts = &pQStarts[Align.NumBlocks];
+if(!(ParsePSLBlockVals(&pChr,Align.NumBlocks,pBlockSizes) &&
+	 ParsePSLBlockVals(&pChr,Align.NumBlocks,pQStarts) &&
+	 ParsePSLBlockVals(&pChr,Align.NumBlocks,pTStarts)))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ParsePSLline: Unable to parse line '%s' from input PSL file - %s", pszLine,m_szPSLinFile);
 	return(eBSFerrParse);
 	}
 
-pChr += Psn;
-for(BlockIdx = 0; BlockIdx < NumBlocks; BlockIdx++)
+// tokens are whitespace delimited so can now be '\0' terminated in place
+pszStrand[StrandLen] = '\0';
+pszQName[QNameLen] = '\0';
+pszTName[TNameLen] = '\0';
+
+pBatch->NumParsed += 1;
+Align.Score = pslScore(Align.Matches,Align.Mismatches,Align.RepMatches,Align.QNumInDels,Align.TNumInDels,pszStrand,Align.TSize,Align.TStart,Align.TEnd,Align.NumBlocks,pBlockSizes,pQStarts,pTStarts);			
+double pslIdent = (double)pslCalcMilliBad(Align.Matches,Align.Mismatches,Align.RepMatches,Align.QNumInDels,Align.TNumInDels,Align.QSize,Align.QStart,Align.QEnd,pszStrand,Align.TSize,Align.TStart,Align.TEnd,Align.NumBlocks,pBlockSizes,pQStarts,pTStarts,true); 
+Align.Identity = (int)(100.0 - pslIdent * 0.1);
+if(Align.Score < m_MinScore ||
+   Align.Identity < m_MinIdentity ||
+   Align.Matches < m_MinMatches)
+	return(0);	
+
+if(pBatch->NumAligns == pBatch->AllocdAligns)
 	{
-	if(BlockIdx != (NumBlocks - 1))
-		Cnt = sscanf(pChr," %d , %n",&BlockSizes[BlockIdx],&Psn);
-	else
+	UINT32 AllocdAligns = pBatch->AllocdAligns + cPSLAllocBatchAligns;
+	if((pAlign = (tsPSLAlign *)realloc(pBatch->pAligns,AllocdAligns * sizeof(tsPSLAlign))) == NULL)
 		{
-		Cnt = sscanf(pChr," %d %n",&BlockSizes[BlockIdx],&Psn);
-		if(Cnt == 1 && pChr[Psn] == ',')
-			Psn += 1;
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ParsePSLline: Memory reallocation to %lld bytes for alignments failed",(INT64)AllocdAligns * sizeof(tsPSLAlign));
+		return(eBSFerrMem);
 		}
+	pBatch->pAligns = pAlign;
+	pBatch->AllocdAligns = AllocdAligns;
+	}
+Align.pszStrand = pszStrand;
+Align.pszQName = pszQName;
+Align.pszTName = pszTName;
+Align.BlocksOfs = pBatch->NumBlockVals;
+pBatch->pAligns[pBatch->NumAligns++] = Align;
+pBatch->NumBlockVals += 3 * Align.NumBlocks;
+return(1);
+}
+
+// FillPSLBatch
+// Fill batch with the next complete lines from the PSL file, any partial last line is carried over into the next batch
+// Must be called with m_hBatchMtx held so batches are filled in file order
+// Returns number of chars in batch, 0 if EOF, < 0 if errors
+int
+CSQLitePSL::FillPSLBatch(tsPSLBatch *pBatch)
+{
+int NumRead;
+UINT32 NumChrs;
+char *pChr;
+bool bEOF;
 
-	if(Cnt != 1)
+if(m_NumCarryChrs)
+	memcpy(pBatch->pChrs,m_pCarryChrs,m_NumCarryChrs);
+NumChrs = m_NumCarryChrs;
+m_NumCarryChrs = 0;
+bEOF = false;
+while(NumChrs < cPSLBatchSize)
+	{
+	if((NumRead = read(m_hPSLinFile,&pBatch->pChrs[NumChrs],cPSLBatchSize - NumChrs)) < 0)
 		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLline: Unable to parse line '%s' from input PSL file - %s", m_pszPSLLineBuff,m_szPSLinFile);
-		return(eBSFerrParse);
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"FillPSLBatch: Read error on input PSL file '%s' - %s",m_szPSLinFile,strerror(errno));
+		return(eBSFerrFileAccess);
 		}
-	pChr += Psn;
+	if(NumRead == 0)
+		{
+		bEOF = true;
+		break;
+		}
+	NumChrs += NumRead;
 	}
-for(BlockIdx = 0; BlockIdx < NumBlocks; BlockIdx++)	
+
+if(!bEOF)		// carry any partial last line over into next batch
 	{
-	if(BlockIdx != (NumBlocks - 1))
-		Cnt = sscanf(pChr," %d , %n",&QStarts[BlockIdx],&Psn);
-	else
+	pChr = &pBatch->pChrs[NumChrs-1];
+	while(pChr >= pBatch->pChrs && *pChr != '\n')
+		pChr--;
+	if(pChr < pBatch->pChrs)
 		{
-		Cnt = sscanf(pChr," %d %n",&QStarts[BlockIdx],&Psn);
-		if(Cnt == 1 && pChr[Psn] == ',')
-			Psn += 1;
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"FillPSLBatch: Overlength PSL line processed from '%s'", m_szPSLinFile);
+		return(eBSFerrParse);
 		}
-	if(Cnt != 1)
+	pChr += 1;
+	m_NumCarryChrs = (UINT32)(&pBatch->pChrs[NumChrs] - pChr);
+	if(m_NumCarryChrs)
+		memcpy(m_pCarryChrs,pChr,m_NumCarryChrs);
+	NumChrs -= m_NumCarryChrs;
+	}
+pBatch->pChrs[NumChrs] = '\0';
+pBatch->NumChrs = NumChrs;
+pBatch->NumParsed = 0;
+pBatch->NumAligns = 0;
+pBatch->NumBlockVals = 0;
+pBatch->Rslt = eBSFSuccess;
+return((int)NumChrs);
+}
+
+// ParsePSLBatch
+// Parse all lines in batch, accepted alignments are retained in the batch for the writer
+int
+CSQLitePSL::ParsePSLBatch(tsPSLBatch *pBatch)
+{
+int Rslt;
+char *pszLine;
+char *pEOL;
+char *pEnd;
+
+pszLine = pBatch->pChrs;
+pEnd = &pBatch->pChrs[pBatch->NumChrs];
+while(pszLine < pEnd)
+	{
+	if((pEOL = (char *)memchr(pszLine,'\n',pEnd - pszLine)) == NULL)
+		pEOL = pEnd;
+	*pEOL = '\0';
+	if(pEOL - pszLine >= cMaxLenPSLline)
 		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLline: Unable to parse line '%s' from input PSL file - %s", m_pszPSLLineBuff,m_szPSLinFile);
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"ParsePSLBatch: Overlength PSL line processed from '%s'", m_szPSLinFile);
 		return(eBSFerrParse);
 		}
-	pChr += Psn;
+	if((Rslt = ParsePSLline(pszLine,pBatch)) < eBSFSuccess)
+		return(Rslt);
+	pszLine = pEOL + 1;
 	}
-for(BlockIdx = 0; BlockIdx < NumBlocks; BlockIdx++)
+return(eBSFSuccess);
+}
+
+#ifdef _WIN32
+unsigned int __stdcall CSQLitePSL::_parse_start(void *args)
+{
+#else
+void * CSQLitePSL::_parse_start(void *args)
+{
+#endif
+tsPSLParseThread *pThread = (tsPSLParseThread *)args;
+pThread->pThis->ParsePSLBatches();
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
+#else
+return(NULL);
+#endif
+}
+
+// ParsePSLBatches
+// Parser threads loop claiming the next free batch in sequence, filling it from the PSL file and then parsing it
+// Number of batches bounds the number of parsed batches which can be queued waiting for the writer
+void
+CSQLitePSL::ParsePSLBatches(void)
+{
+int Rslt;
+tsPSLBatch *pBatch;
+
+#ifdef _WIN32
+EnterCriticalSection(&m_hBatchMtx);
+#else
+pthread_mutex_lock(&m_hBatchMtx);
+#endif
+while(1)
 	{
-	if(BlockIdx != (NumBlocks - 1))
-		Cnt = sscanf(pChr," %d , %n",&TStarts[BlockIdx],&Psn);
-	else
-		Cnt = sscanf(pChr," %d",&TStarts[BlockIdx]);
-	if(Cnt != 1)
+	pBatch = &m_pPSLBatches[m_NxtReadBatchSeq % m_NumPSLBatches];
+	while(m_PipelineRslt >= eBSFSuccess && !m_bPSLEOF && pBatch->State != ePSLBFree)
 		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLline: Unable to parse line '%s' from input PSL file - %s", m_pszPSLLineBuff,m_szPSLinFile);
-		return(eBSFerrParse);
+#ifdef _WIN32
+		SleepConditionVariableCS(&m_hBatchFreeCond,&m_hBatchMtx,INFINITE);
+#else
+		pthread_cond_wait(&m_hBatchFreeCond,&m_hBatchMtx);
+#endif
+		pBatch = &m_pPSLBatches[m_NxtReadBatchSeq % m_NumPSLBatches];
 		}
-	pChr += Psn;
+	if(m_PipelineRslt < eBSFSuccess || m_bPSLEOF)
+		break;
+
+	if((Rslt = FillPSLBatch(pBatch)) <= 0)
+		{
+		if(Rslt < 0)
+			m_PipelineRslt = Rslt;
+		else
+			m_bPSLEOF = true;
+#ifdef _WIN32
+		WakeAllConditionVariable(&m_hBatchFreeCond);
+		WakeAllConditionVariable(&m_hBatchParsedCond);
+#else
+		pthread_cond_broadcast(&m_hBatchFreeCond);
+		pthread_cond_broadcast(&m_hBatchParsedCond);
+#endif
+		break;
+		}
+	pBatch->BatchSeq = m_NxtReadBatchSeq++;
+	pBatch->State = ePSLBParsing;
+#ifdef _WIN32
+	LeaveCriticalSection(&m_hBatchMtx);
+#else
+	pthread_mutex_unlock(&m_hBatchMtx);
+#endif
+
+	Rslt = ParsePSLBatch(pBatch);
+
+#ifdef _WIN32
+	EnterCriticalSection(&m_hBatchMtx);
+#else
+	pthread_mutex_lock(&m_hBatchMtx);
+#endif
+	pBatch->Rslt = Rslt;
+	pBatch->State = ePSLBParsed;
+	if(Rslt < eBSFSuccess && m_PipelineRslt >= eBSFSuccess)
+		{
+		m_PipelineRslt = Rslt;
+#ifdef _WIN32
+		WakeAllConditionVariable(&m_hBatchFreeCond);
+#else
+		pthread_cond_broadcast(&m_hBatchFreeCond);
+#endif
+		}
+#ifdef _WIN32
+	WakeAllConditionVariable(&m_hBatchParsedCond);
+#else
+	pthread_cond_broadcast(&m_hBatchParsedCond);
+#endif
 	}
+#ifdef _WIN32
+LeaveCriticalSection(&m_hBatchMtx);
+#else
+pthread_mutex_unlock(&m_hBatchMtx);
+#endif
+}
 
-Score = pslScore(Matches,Mismatches,RepMatches,QNumInDels,TNumInDels,szStrand,TSize,TStart,TEnd,NumBlocks,BlockSizes,QStarts,TStarts);			
-double pslIdent = (double)pslCalcMilliBad(Matches,Mismatches,RepMatches,QNumInDels,TNumInDels,QSize,QStart,QEnd,szStrand,TSize,TStart,TEnd,NumBlocks,BlockSizes,QStarts,TStarts,true); 
-Identity = (int)(100.0 - pslIdent * 0.1);
-m_NumBlatHitsParsed += 1;
-if(Score < m_MinScore ||
-   Identity < m_MinIdentity ||
-   Matches < m_MinMatches)
-	return(0);	
+// GenMultiRowInsert
+// Generates multirow insert statement by replicating the values row of a single row insert statement
+static char *
+GenMultiRowInsert(const char *pszInsert,	// single row insert statement, ending with "VALUES(?,...,?)"
+				int NumRows)				// generate for this many rows
+{
+const char *pszValues;
+char *pszMultiInsert;
+char *pDst;
+size_t PrefixLen;
+size_t ValuesLen;
+int RowIdx;
+
+if((pszValues = strstr(pszInsert,"VALUES(")) == NULL)
+	return(NULL);
+pszValues += 6;
+PrefixLen = pszValues - pszInsert;
+ValuesLen = strlen(pszValues);
+if((pszMultiInsert = new char [PrefixLen + (NumRows * (ValuesLen + 1)) + 1]) == NULL)
+	return(NULL);
+memcpy(pszMultiInsert,pszInsert,PrefixLen);
+pDst = &pszMultiInsert[PrefixLen];
+for(RowIdx = 0; RowIdx < NumRows; RowIdx++)
+	{
+	if(RowIdx > 0)
+		*pDst++ = ',';
+	memcpy(pDst,pszValues,ValuesLen);
+	pDst += ValuesLen;
+	}
+*pDst = '\0';
+return(pszMultiInsert);
+}
 
-AlignmentID = AddAlignment(ExprID,Score,Identity,Matches,Mismatches,RepMatches,NCount,QNumInDels,QBasesInDels,TNumInDels,TBasesInDels,szStrand,szQName,QSize,QStart,QEnd,szTName,TSize,TStart,TEnd,NumBlocks,BlockSizes, QStarts,TStarts);
-if(AlignmentID > 0)
-	m_NumBlatHitsAccepted += 1;
-return(AlignmentID);
+// PrepBulkInserts
+// Prepare the bulk load insert statements; alignments are explicitly identified so alignment blocks can reference their alignments without
+// requiring each alignment to be individually inserted
+int
+CSQLitePSL::PrepBulkInserts(void)
+{
+int sqlite_error;
+int LastAlignmentID;
+char *pszInsert;
+const char *pszInsertAlign = "INSERT INTO TblAlignments (AlignmentID,ExprID,Score,Identity,Matches,Mismatches,RepMatches,NCount,QNumInDels,QBasesInDels,TNumInDels,TBasesInDels,Strand,QName,QSize,QStart,QEnd,TName,TSize,TStart,TEnd,NumBlocks) VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)";
+
+FinalizeBulkInserts();
+
+if((sqlite_error = sqlite3_prepare_v2(m_pDB,pszInsertAlign,-1,&m_pPrepInsertAlign,NULL))!=SQLITE_OK)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't prepare insert statement on table %s: %s", "TblAlignments", sqlite3_errmsg(m_pDB));
+	return(eBSFerrInternal);
+	}
+
+if((pszInsert = GenMultiRowInsert(pszInsertAlign,cPSLAlignsPerInsert)) == NULL)
+	return(eBSFerrMem);
+sqlite_error = sqlite3_prepare_v2(m_pDB,pszInsert,-1,&m_pPrepInsertAligns,NULL);
+delete []pszInsert;
+if(sqlite_error != SQLITE_OK)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't prepare multirow insert statement on table %s: %s", "TblAlignments", sqlite3_errmsg(m_pDB));
+	return(eBSFerrInternal);
+	}
+
+if((pszInsert = GenMultiRowInsert(m_StmSQL[2].pszInsert,cPSLBlocksPerInsert)) == NULL)
+	return(eBSFerrMem);
+sqlite_error = sqlite3_prepare_v2(m_pDB,pszInsert,-1,&m_pPrepInsertBlocks,NULL);
+delete []pszInsert;
+if(sqlite_error != SQLITE_OK)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't prepare multirow insert statement on table %s: %s", m_StmSQL[2].pTblName, sqlite3_errmsg(m_pDB));
+	return(eBSFerrInternal);
+	}
+
+// alignment identifiers continue on from any alignments already in the database
+LastAlignmentID = 0;
+sqlite3_exec(m_pDB,"SELECT max(AlignmentID) FROM TblAlignments",ExecCallbackID,&LastAlignmentID,NULL);
+m_LastAlignmentID = LastAlignmentID;
+return(eBSFSuccess);
 }
 
-int		// 0: EOF -1: error >0 chr
-CSQLitePSL::GetNxtPSLChr(void)	// returns buffered PSL file char
+void
+CSQLitePSL::FinalizeBulkInserts(void)
 {
-int Chr;
-if((Chr = m_PushedBack) > 0)
+if(m_pPrepInsertAligns != NULL)
 	{
-	m_PushedBack = 0;
-	return(Chr);
+	sqlite3_finalize(m_pPrepInsertAligns);
+	m_pPrepInsertAligns = NULL;
 	}
-if(m_InBuffIdx == -1 || m_InBuffIdx >= m_NumInBuffer)
+if(m_pPrepInsertAlign != NULL)
 	{
-	m_NumInBuffer = read(m_hPSLinFile,m_pInBuffer,cMaxInBuffSize);
-	if(m_NumInBuffer <= 0)
+	sqlite3_finalize(m_pPrepInsertAlign);
+	m_pPrepInsertAlign = NULL;
+	}
+if(m_pPrepInsertBlocks != NULL)
+	{
+	sqlite3_finalize(m_pPrepInsertBlocks);
+	m_pPrepInsertBlocks = NULL;
+	}
+}
+
+// BindPSLAlign
+// Bind alignment row values, any bind errors are OR'd into the returned result so only SQLITE_OK (0) if all values were bound
+int
+CSQLitePSL::BindPSLAlign(sqlite3_stmt *pStm,	// bind alignment values into this prepared insert statement
+						int ColOfs,			// alignment row values start at this column offset (0 for 1st row)
+						INT64 AlignmentID,	// alignment identifier
+						int ExprID,			// alignment was in this experiment
+						tsPSLAlign *pAlign)	// alignment
+{
+int sqlite_error;
+sqlite_error = sqlite3_bind_int64(pStm, ColOfs + 1, AlignmentID);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 2, ExprID);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 3, pAlign->Score);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 4, pAlign->Identity);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 5, pAlign->Matches);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 6, pAlign->Mismatches);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 7, pAlign->RepMatches);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 8, pAlign->NCount);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 9, pAlign->QNumInDels);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 10, pAlign->QBasesInDels);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 11, pAlign->TNumInDels);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 12, pAlign->TBasesInDels);
+sqlite_error |= sqlite3_bind_text(pStm, ColOfs + 13, pAlign->pszStrand,(int)strlen(pAlign->pszStrand)+1,SQLITE_STATIC);
+sqlite_error |= sqlite3_bind_text(pStm, ColOfs + 14, pAlign->pszQName,(int)strlen(pAlign->pszQName)+1,SQLITE_STATIC);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 15, pAlign->QSize);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 16, pAlign->QStart);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 17, pAlign->QEnd);
+sqlite_error |= sqlite3_bind_text(pStm, ColOfs + 18, pAlign->pszTName,(int)strlen(pAlign->pszTName)+1,SQLITE_STATIC);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 19, pAlign->TSize);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 20, pAlign->TStart);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 21, pAlign->TEnd);
+sqlite_error |= sqlite3_bind_int(pStm, ColOfs + 22, pAlign->NumBlocks);
+return(sqlite_error);
+}
+
+// WritePSLBatch
+// Insert all accepted alignments, and their blocks, from batch using multirow inserts with any remainder rows inserted individually
+// Bound text values are static ptrs into the batch so all rows are inserted before returning
+int
+CSQLitePSL::WritePSLBatch(int ExprID,			// insert accepted alignments in this experiment
+						tsPSLBatch *pBatch)		// from this batch
+{
+int sqlite_error;
+int Rslt;
+int RowIdx;
+int BlockIdx;
+UINT32 AlignIdx;
+UINT32 NumMultiRows;
+UINT32 BlockNum;
+INT64 FirstAlignmentID;
+tsPSLAlign *pAlign;
+sqlite3_stmt *pStm;
+int *pBlockSizes;
+int *pQStarts;
+int *pTStarts;
+
+m_NumBlatHitsParsed += pBatch->NumParsed;
+if(pBatch->NumAligns == 0)
+	return(eBSFSuccess);
+
+pAlign = pBatch->pAligns;
+for(AlignIdx = 0; AlignIdx < pBatch->NumAligns; AlignIdx++, pAlign++)
+	if((Rslt = AddAlignSummary(ExprID,pAlign->pszQName,pAlign->QSize,pAlign->pszTName,pAlign->TSize)) < eBSFSuccess)
+		return(Rslt);
+
+FirstAlignmentID = m_LastAlignmentID + 1;
+NumMultiRows = (pBatch->NumAligns / cPSLAlignsPerInsert) * cPSLAlignsPerInsert;
+pAlign = pBatch->pAligns;
+for(AlignIdx = 0; AlignIdx < pBatch->NumAligns; AlignIdx++, pAlign++)
+	{
+	if(AlignIdx < NumMultiRows)
 		{
-		m_InBuffIdx = -1;
-		return(m_NumInBuffer);
+		pStm = m_pPrepInsertAligns;
+		RowIdx = AlignIdx % cPSLAlignsPerInsert;
+		}
+	else
+		{
+		pStm = m_pPrepInsertAlign;
+		RowIdx = cPSLAlignsPerInsert - 1;
+		}
+	if((sqlite_error = BindPSLAlign(pStm,pStm == m_pPrepInsertAligns ? RowIdx * 22 : 0,FirstAlignmentID + AlignIdx,ExprID,pAlign))!=SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
+		return(eBSFerrInternal);
+		}
+	if(RowIdx == cPSLAlignsPerInsert - 1)
+		{
+		if((sqlite_error = sqlite3_step(pStm))!=SQLITE_DONE)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - step prepared statement: %s", sqlite3_errmsg(m_pDB));   
+			return(eBSFerrInternal);
+			}
+		sqlite3_reset(pStm);
 		}
-	m_InBuffIdx = 0;
 	}
-return(m_pInBuffer[m_InBuffIdx++]);
+
+NumMultiRows = ((pBatch->NumBlockVals / 3) / cPSLBlocksPerInsert) * cPSLBlocksPerInsert;
+BlockNum = 0;
+pAlign = pBatch->pAligns;
+for(AlignIdx = 0; AlignIdx < pBatch->NumAligns; AlignIdx++, pAlign++)
+	{
+	pBlockSizes = &pBatch->pBlocks[pAlign->BlocksOfs];
+	pQStarts = &pBlockSizes[pAlign->NumBlocks];
+	pTStarts = &pQStarts[pAlign->NumBlocks];
+	for(BlockIdx = 0; BlockIdx < pAlign->NumBlocks; BlockIdx++, BlockNum++)
+		{
+		if(BlockNum < NumMultiRows)
+			{
+			pStm = m_pPrepInsertBlocks;
+			RowIdx = BlockNum % cPSLBlocksPerInsert;
+			}
+		else
+			{
+			pStm = m_StmSQL[2].pPrepInsert;
+			RowIdx = 0;
+			}
+		sqlite_error = sqlite3_bind_int(pStm, (RowIdx * 5) + 1, ExprID);
+		sqlite_error |= sqlite3_bind_int64(pStm, (RowIdx * 5) + 2, FirstAlignmentID + AlignIdx);
+		sqlite_error |= sqlite3_bind_int(pStm, (RowIdx * 5) + 3, pBlockSizes[BlockIdx]);
+		sqlite_error |= sqlite3_bind_int(pStm, (RowIdx * 5) + 4, pQStarts[BlockIdx]);
+		sqlite_error |= sqlite3_bind_int(pStm, (RowIdx * 5) + 5, pTStarts[BlockIdx]);
+		if(sqlite_error != SQLITE_OK)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
+			return(eBSFerrInternal);
+			}
+		if(pStm != m_pPrepInsertBlocks || RowIdx == cPSLBlocksPerInsert - 1)
+			{
+			if((sqlite_error = sqlite3_step(pStm))!=SQLITE_DONE)
+				{
+				gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - step prepared statement: %s", sqlite3_errmsg(m_pDB));   
+				return(eBSFerrInternal);
+				}
+			sqlite3_reset(pStm);
+			}
+		}
+	}
+
+m_LastAlignmentID += pBatch->NumAligns;
+m_NumBlatHitsAccepted += pBatch->NumAligns;
+return(eBSFSuccess);
 }
 
+// ProcessPSL
+// Writer, running on the calling thread, inserting parsed batches in batch sequence order so alignment identifiers are
+// assigned in PSL file order; batches are released back to the parser threads once inserted
+int
+CSQLitePSL::ProcessPSL(int ExprID)
+{
+int Rslt;
+tsPSLBatch *pBatch;
+
+Rslt = eBSFSuccess;
+#ifdef _WIN32
+EnterCriticalSection(&m_hBatchMtx);
+#else
+pthread_mutex_lock(&m_hBatchMtx);
+#endif
+while(1)
+	{
+	pBatch = &m_pPSLBatches[m_NxtWriteBatchSeq % m_NumPSLBatches];
+	while(m_PipelineRslt >= eBSFSuccess &&
+			!(pBatch->State == ePSLBParsed && pBatch->BatchSeq == m_NxtWriteBatchSeq) &&
+			!(m_bPSLEOF && m_NxtWriteBatchSeq == m_NxtReadBatchSeq))
+#ifdef _WIN32
+		SleepConditionVariableCS(&m_hBatchParsedCond,&m_hBatchMtx,INFINITE);
+#else
+		pthread_cond_wait(&m_hBatchParsedCond,&m_hBatchMtx);
+#endif
+	if(m_PipelineRslt < eBSFSuccess)
+		{
+		Rslt = m_PipelineRslt;
+		break;
+		}
+	if(pBatch->State != ePSLBParsed || pBatch->BatchSeq != m_NxtWriteBatchSeq)	// EOF and all batches written
+		break;
+#ifdef _WIN32
+	LeaveCriticalSection(&m_hBatchMtx);
+#else
+	pthread_mutex_unlock(&m_hBatchMtx);
+#endif
+
+	Rslt = WritePSLBatch(ExprID,pBatch);
+
+#ifdef _WIN32
+	EnterCriticalSection(&m_hBatchMtx);
+#else
+	pthread_mutex_lock(&m_hBatchMtx);
+#endif
+	pBatch->State = ePSLBFree;
+	m_NxtWriteBatchSeq += 1;
+	if(Rslt < eBSFSuccess && m_PipelineRslt >= eBSFSuccess)
+		m_PipelineRslt = Rslt;
+#ifdef _WIN32
+	WakeAllConditionVariable(&m_hBatchFreeCond);
+#else
+	pthread_cond_broadcast(&m_hBatchFreeCond);
+#endif
+	if(Rslt < eBSFSuccess)
+		break;
+	}
+#ifdef _WIN32
+LeaveCriticalSection(&m_hBatchMtx);
+#else
+pthread_mutex_unlock(&m_hBatchMtx);
+#endif
+return(Rslt);
+}
+
+void
+CSQLitePSL::FreePSLBatches(void)
+{
+int BatchIdx;
+tsPSLBatch *pBatch;
+if(m_pPSLBatches != NULL)
+	{
+	pBatch = m_pPSLBatches;
+	for(BatchIdx = 0; BatchIdx < m_NumPSLBatches; BatchIdx++, pBatch++)
+		{
+		if(pBatch->pChrs != NULL)
+			delete pBatch->pChrs;
+		if(pBatch->pAligns != NULL)
+			free(pBatch->pAligns);
+		if(pBatch->pBlocks != NULL)
+			free(pBatch->pBlocks);
+		}
+	delete m_pPSLBatches;
+	m_pPSLBatches = NULL;
+	}
+m_NumPSLBatches = 0;
+if(m_pCarryChrs != NULL)
+	{
+	delete m_pCarryChrs;
+	m_pCarryChrs = NULL;
+	}
+m_NumCarryChrs = 0;
+}
 
 int
 CSQLitePSL::ProcessPSLFile(char *pszInPSL,			// parse and load the alignments in this Blat generated PSL file into SQLite
-						    int ExprID)				// the alignments are in this experiment
+						    int ExprID,				// the alignments are in this experiment
+							int NumThreads)			// using this many parser threads
 {
 int Rslt;
+int BatchIdx;
+int ThreadIdx;
+tsPSLBatch *pBatch;
+tsPSLParseThread *pThread;
 
 if(pszInPSL == NULL || pszInPSL[0] == '\0' || ExprID <= 0)
 	return(eBSFerrParams);
 
+if(NumThreads < 1)
+	NumThreads = 1;
+else
+	if(NumThreads > cMaxPSLParseThreads)
+		NumThreads = cMaxPSLParseThreads;
+
 strncpy(m_szPSLinFile,pszInPSL,_MAX_PATH);
 m_szPSLinFile[_MAX_PATH - 1] = '\0';
 
-if(m_pInBuffer == NULL)
+// bounded queue of batches, sufficient for all parser threads to be parsing whilst the writer is inserting earlier batches
+m_NumPSLBatches = (NumThreads * 2) + 1;
+if((m_pPSLBatches = new tsPSLBatch [m_NumPSLBatches]) == NULL)
 	{
-	if((m_pInBuffer = new UINT8 [cMaxInBuffSize]) == NULL)
-		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile: Unable to allocate %d chars buffering for input PSL file - %s", cMaxInBuffSize,m_szPSLinFile);
-		return(eBSFerrMem);
-		}
-	m_AllocdInBuffer = cMaxInBuffSize;
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile: Unable to allocate batches for input PSL file - %s", m_szPSLinFile);
+	m_NumPSLBatches = 0;
+	return(eBSFerrMem);
 	}
-
-if(m_pszPSLLineBuff == NULL)
+memset(m_pPSLBatches,0,sizeof(tsPSLBatch) * m_NumPSLBatches);
+pBatch = m_pPSLBatches;
+for(BatchIdx = 0; BatchIdx < m_NumPSLBatches; BatchIdx++, pBatch++)
 	{
-	if((m_pszPSLLineBuff = new UINT8 [cMaxLenPSLline]) == NULL)
+	if((pBatch->pChrs = new char [cPSLBatchSize + 1]) == NULL)
 		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile: Unable to allocate %d chars buffering for input PSL lines from file - %s", cMaxLenPSLline,m_szPSLinFile);
-		delete m_pInBuffer;
-		m_AllocdInBuffer = 0;
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile: Unable to allocate %d chars buffering for input PSL file - %s", cPSLBatchSize,m_szPSLinFile);
+		FreePSLBatches();
 		return(eBSFerrMem);
 		}
-	m_AllocdPSLLineBuffer = cMaxLenPSLline;
+	pBatch->State = ePSLBFree;
+	}
+if((m_pCarryChrs = new char [cPSLBatchSize]) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile: Unable to allocate %d chars buffering for input PSL file - %s", cPSLBatchSize,m_szPSLinFile);
+	FreePSLBatches();
+	return(eBSFerrMem);
 	}
+m_NumCarryChrs = 0;
 
+if((Rslt = PrepBulkInserts()) < eBSFSuccess)
+	{
+	FreePSLBatches();
+	return(Rslt);
+	}
 
 #ifdef _WIN32
 if((m_hPSLinFile = open(m_szPSLinFile,_O_RDWR | _O_BINARY | _O_SEQUENTIAL))==-1)
@@ -1234,21 +1846,70 @@ if((m_hPSLinFile = open(m_szPSLinFile,O_RDWR))==-1)
 #endif
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile: Unable to open input file for processing - '%s' - %s", m_szPSLinFile,strerror(errno));
-	delete m_pInBuffer;
-	m_pInBuffer = NULL;
-	m_AllocdInBuffer = 0;
-	delete m_pszPSLLineBuff;
-	m_pszPSLLineBuff = NULL;
-	m_AllocdPSLLineBuffer = 0;
+	FinalizeBulkInserts();
+	FreePSLBatches();
 	return(eBSFerrOpnFile);
 	}
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"ProcessPSLFile: Processing input file '%s'",m_szPSLinFile); 
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"ProcessPSLFile: Processing input file '%s' using %d parser threads",m_szPSLinFile,NumThreads); 
 
-m_NumInBuffer = 0;
-m_InBuffIdx = 0;
 m_NumBlatHitsParsed = 0;
 m_NumBlatHitsAccepted = 0;
-Rslt = ProcessPSL(ExprID);
+m_NxtReadBatchSeq = 0;
+m_NxtWriteBatchSeq = 0;
+m_bPSLEOF = false;
+m_PipelineRslt = eBSFSuccess;
+m_NumParseThreads = 0;
+pThread = m_ParseThreads;
+for(ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++, pThread++)
+	{
+	pThread->pThis = this;
+	pThread->ThreadIdx = ThreadIdx;
+#ifdef _WIN32
+	pThread->threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,_parse_start,pThread,0,&pThread->threadID);
+	if(pThread->threadHandle == 0)
+		break;
+#else
+	pThread->threadRslt = pthread_create(&pThread->threadID,NULL,_parse_start,pThread);
+	if(pThread->threadRslt != 0)
+		break;
+#endif
+	m_NumParseThreads += 1;
+	}
+
+if(m_NumParseThreads == 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcessPSLFile: Unable to start any parser threads");
+	Rslt = eBSFerrInternal;
+	}
+else
+	Rslt = ProcessPSL(ExprID);
+
+// ensure parser threads terminate if writer errored
+#ifdef _WIN32
+EnterCriticalSection(&m_hBatchMtx);
+if(Rslt < eBSFSuccess && m_PipelineRslt >= eBSFSuccess)
+	m_PipelineRslt = Rslt;
+WakeAllConditionVariable(&m_hBatchFreeCond);
+LeaveCriticalSection(&m_hBatchMtx);
+#else
+pthread_mutex_lock(&m_hBatchMtx);
+if(Rslt < eBSFSuccess && m_PipelineRslt >= eBSFSuccess)
+	m_PipelineRslt = Rslt;
+pthread_cond_broadcast(&m_hBatchFreeCond);
+pthread_mutex_unlock(&m_hBatchMtx);
+#endif
+pThread = m_ParseThreads;
+for(ThreadIdx = 0; ThreadIdx < m_NumParseThreads; ThreadIdx++, pThread++)
+	{
+#ifdef _WIN32
+	WaitForSingleObject(pThread->threadHandle,INFINITE);
+	CloseHandle(pThread->threadHandle);
+	pThread->threadHandle = 0;
+#else
+	pthread_join(pThread->threadID,NULL);
+#endif
+	}
+m_NumParseThreads = 0;
 
 if(Rslt >= 0)
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"ProcessPSLFile: Parsed %d alignments and accepted %d from '%s'",m_NumBlatHitsParsed,m_NumBlatHitsAccepted, m_szPSLinFile); 
@@ -1259,62 +1920,8 @@ if(m_hPSLinFile != -1)
 	close(m_hPSLinFile);
 	m_hPSLinFile = -1;
 	}
-if(m_pInBuffer != NULL)
-	{
-	delete m_pInBuffer;
-	m_pInBuffer = NULL;
-	m_AllocdInBuffer = 0;
-	}
-if(m_pszPSLLineBuff != NULL)
-	{
-	delete m_pszPSLLineBuff;
-	m_pszPSLLineBuff = NULL;
-	m_AllocdPSLLineBuffer = 0;
-	}
-return(Rslt);
-}
-
-
-int
-CSQLitePSL::ProcessPSL(int ExprID)
-{
-int Rslt;
-bool bInWhiteSpace = false;		
-
-m_CurLineLen = 0;
-Rslt = 0;
-while(Rslt >= 0 && (Rslt = GetNxtPSLChr()) > 0) {
-	switch((char)Rslt) {
-		case '\r':			// silently slough CR - must have been generated on windows/msdos machine
-			continue;
-
-		case '\n':				// accept linefeeds - both Linux and windows are happy with lines terminated by NL
-			bInWhiteSpace = false;
-			if(m_CurLineLen)
-				Rslt = ProcessPSLline(ExprID);
-			m_CurLineLen = 0;
-			continue;
-		
-		default:
-			if(isspace(Rslt))
-				{
-				if(bInWhiteSpace)	// slough multiple whitespace
-					continue;
-				bInWhiteSpace = true;
-				}
-			else
-				bInWhiteSpace = false;
-			if(m_CurLineLen >= m_AllocdPSLLineBuffer-1)
-				{
-				gDiagnostics.DiagOut(eDLWarn,gszProcName,"ProcessPSL: Overlength PSL line processed from '%s'", m_szPSLinFile);
-				return(eBSFerrParse);
-				}
-			m_pszPSLLineBuff[m_CurLineLen++] = (char)Rslt;
-			continue;
-			}
-	}
-if(!Rslt && m_CurLineLen)
-	Rslt = ProcessPSLline(ExprID);
+FinalizeBulkInserts();
+FreePSLBatches();
 return(Rslt);
 }
 
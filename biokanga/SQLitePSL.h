@@ -19,6 +19,13 @@ const int cMaxNumPSLblocks = 1000;		// max number of blocks in any PSL alignment
 
 const int cAllocAlignSummaryInsts=1000000; // allocate in increments of this number of alignment summary instances
 
+const int cMaxPSLParseThreads = 16;		// bulk loading PSL files uses at most this many parser threads feeding the single SQLite writer
+const int cPSLBatchSize = 4000000;		// parser threads take the PSL file in batches of complete lines totalling at most this many chars
+const int cPSLAllocBatchAligns = 25000;	// initially allocate for this many parsed alignments per batch, realloc'd as may be required
+const int cPSLAlignsPerInsert = 40;		// multirow inserts of this many alignments (22 bound values each, SQLite defaults to limiting bound values to 999)
+const int cPSLBlocksPerInsert = 180;	// multirow inserts of this many alignment blocks (5 bound values each)
+const int cSQLitePSLSortThreads = 4;	// SQLite can use at most this many worker threads when sorting whilst generating indexes
+
 typedef struct TAG_sStmsSQL {
 	char *pTblName;					// table name
 	char *pszCreateTbl;				// SQL statement used to create the table
@@ -46,19 +53,96 @@ typedef struct TAG_sAlignSummary {
 
 #pragma pack()
 
+// parsed and accepted alignment, name and strand ptrs are into the owning batch's PSL line chars
+typedef struct TAG_sPSLAlign {
+	int Score;				// Alignment score (using Blat pslScore() function)
+	int Identity;			// Alignment identity (using Blat 100.0 - pslCalcMilliBad(psl, TRUE) * 0.1)
+	int Matches;			// number of matches which aren't repeats
+	int Mismatches;			// number of bases which do not match
+	int RepMatches;			// number of bases which match but are also repeats
+	int NCount;				// number of N bases
+	int QNumInDels;			// number of InDel seqs in query
+	int QBasesInDels;		// number of bases total in all InDels in query
+	int TNumInDels;			// number of InDel seqs in target
+	int TBasesInDels;		// number of bases total in all InDels in target
+	char *pszStrand;		// '+' or '-' for query strand, optionally followed by '+' or '-' for target genomic strand
+	char *pszQName;			// query sequence name
+	int QSize;				// query sequence size
+	int QStart;				// alignment start psn in query
+	int QEnd;				// alignment end psn in query
+	char *pszTName;			// target sequence name
+	int TSize;				// target sequence size
+	int TStart;				// alignment start psn in target
+	int TEnd;				// alignment end psn in target
+	int NumBlocks;			// number of blocks in the alignment
+	UINT32 BlocksOfs;		// block sizes, query starts and target starts are at this offset into owning batch's pBlocks[]
+} tsPSLAlign;
+
+typedef enum TAG_ePSLBatchState {
+	ePSLBFree = 0,			// batch is available to be filled with the next PSL lines
+	ePSLBParsing,			// parser thread is parsing batch lines
+	ePSLBParsed				// batch parsed, waiting for the writer to insert the accepted alignments in batch sequence order
+} etPSLBatchState;
+
+// PSL lines are processed in batches, parser threads fill and parse batches in parallel and the single writer inserts parsed batches in file order
+typedef struct TAG_sPSLBatch {
+	INT64 BatchSeq;			// batches are read, and written, in this sequence order
+	etPSLBatchState State;	// current batch state
+	int Rslt;				// parse result, < 0 if parse errors
+	UINT32 NumChrs;			// number of chars, all complete lines, in pChrs
+	char *pChrs;			// allocated to hold cPSLBatchSize chars plus terminating '\0'
+	UINT32 NumParsed;		// number of alignment lines parsed, accepted or not
+	UINT32 NumAligns;		// number of accepted alignments in pAligns
+	UINT32 AllocdAligns;	// pAligns allocated to hold this many alignments
+	tsPSLAlign *pAligns;	// accepted alignments
+	UINT32 NumBlockVals;	// number of block values in pBlocks
+	UINT32 AllocdBlockVals;	// pBlocks allocated to hold this many block values
+	int *pBlocks;			// block sizes, query starts and target starts for all accepted alignments
+} tsPSLBatch;
+
+typedef struct TAG_sPSLParseThread {
+	class CSQLitePSL *pThis;		// parsing for this instance
+	int ThreadIdx;					// uniquely identifies this thread
+#ifdef _WIN32
+	HANDLE threadHandle;			// handle as returned by _beginthreadex()
+	unsigned int threadID;			// identifier as set by _beginthreadex()
+#else
+	int threadRslt;					// result as returned by pthread_create ()
+	pthread_t threadID;				// identifier as set by pthread_create ()
+#endif
+} tsPSLParseThread;
+
 class CSQLitePSL
 {
 	char m_szPSLinFile[_MAX_PATH];  // processing this input PSL file
 	int m_hPSLinFile;				// opened file handle for psl files
-	UINT8 *m_pInBuffer;				// mem allocd to buffer chars being read from psl
-	size_t m_AllocdInBuffer;		// m_pInBuffer allocated to hold at most this many chars
-	int m_NumInBuffer;				// num of chars currently in pInBuffer
-	int m_InBuffIdx;				// index of next char to read from pInBuffer[]
-	int m_PushedBack;				// last pushed back char (only 1 level of pushback supported!)
-
-	UINT8 *m_pszPSLLineBuff;		// allocd PSL line buffer
-	size_t m_AllocdPSLLineBuffer;	// m_pszPSLLineBuff allocated to hold at most this many chars
-	int m_CurLineLen;				// current line length in pszLineBuff
+	char *m_pCarryChrs;				// partial PSL line, as read from end of last batch, to be carried into next batch
+	UINT32 m_NumCarryChrs;			// number of chars in m_pCarryChrs
+
+	int m_NumParseThreads;			// number of parser threads
+	int m_NumPSLBatches;			// bounded queue of this many batches between parser threads and the writer
+	tsPSLBatch *m_pPSLBatches;		// allocated batches
+	tsPSLParseThread m_ParseThreads[cMaxPSLParseThreads];	// parser thread instances
+	INT64 m_NxtReadBatchSeq;		// sequence of next batch to be read from the PSL file
+	INT64 m_NxtWriteBatchSeq;		// sequence of next batch to be inserted into SQLite
+	bool m_bPSLEOF;					// set true when all PSL lines have been read into batches
+	int m_PipelineRslt;				// set < 0 if parser threads or writer errored, parsing and writing is then terminated
+#ifdef _WIN32
+	CRITICAL_SECTION m_hBatchMtx;		// serialises batch state
+	CONDITION_VARIABLE m_hBatchFreeCond;	// signalled when writer releases a batch or pipeline terminating
+	CONDITION_VARIABLE m_hBatchParsedCond;	// signalled when a batch has been parsed or EOF
+#else
+	pthread_mutex_t m_hBatchMtx;		// serialises batch state
+	pthread_cond_t m_hBatchFreeCond;	// signalled when writer releases a batch or pipeline terminating
+	pthread_cond_t m_hBatchParsedCond;	// signalled when a batch has been parsed or EOF
+#endif
+
+	int m_NumSortThreads;			// number of SQLite worker threads used when sorting whilst generating indexes, 0 if sorting on calling thread only
+	int m_ValidatedExprID;			// last experiment identifier validated as known to SQLite by AddAlignment()
+	INT64 m_LastAlignmentID;		// last alignment identifier assigned, bulk loaded alignments are explicitly identified so blocks can reference these
+	sqlite3_stmt *m_pPrepInsertAligns;		// prepared multirow insert of cPSLAlignsPerInsert alignments
+	sqlite3_stmt *m_pPrepInsertAlign;		// prepared single row insert of an explicitly identified alignment
+	sqlite3_stmt *m_pPrepInsertBlocks;		// prepared multirow insert of cPSLBlocksPerInsert alignment blocks
 
 	int m_PMode;					// processing mode, 0 to delete any existing then create new SQLite, 1 to append to existing SQLite
 	int m_MinIdentity;				// minimum required identity
@@ -82,14 +166,33 @@ class CSQLitePSL
 	int m_NumAlignments;				// number of alignments added to TblBlatAlignments
 	int m_NumBlocks;					// number of alignment blocks added to TblBlatAlignmentBlocks
 
-	int		GetNxtPSLChr(void);			// returns buffered PSL file char,  0: EOF, -1: error, >0 chr 
-
-	int ProcessPSLline(int ExprID);		// parse alignment PSL line which is in this experiment
+	int ParsePSLline(char *pszLine,		// parse this '\0' terminated PSL line
+					tsPSLBatch *pBatch);	// and if accepted then append alignment to this batch
 
 	int ProcessPSLFile(char *pszInPSL,		// parse and load the alignments in this Blat generated PSL file into SQLite
-						    int ExprID);	// the alignments are in this experiment
-
-	int ProcessPSL(int ExprID);
+						    int ExprID,		// the alignments are in this experiment
+							int NumThreads);	// using this many parser threads
+
+	int ProcessPSL(int ExprID);			// writer inserting parsed batches, in file order, into SQLite
+
+	int FillPSLBatch(tsPSLBatch *pBatch);	// fill batch with next complete PSL lines, returns number of chars in batch, 0 if EOF
+	int ParsePSLBatch(tsPSLBatch *pBatch);	// parse all lines in batch, accepted alignments are retained in batch
+	int WritePSLBatch(int ExprID,			// insert accepted alignments in this experiment
+						tsPSLBatch *pBatch);	// from this batch
+	int BindPSLAlign(sqlite3_stmt *pStm,	// bind alignment values into this prepared insert statement
+						int ColOfs,			// alignment row values start at this column offset (0 for 1st row)
+						INT64 AlignmentID,	// alignment identifier
+						int ExprID,			// alignment was in this experiment
+						tsPSLAlign *pAlign);	// alignment
+	void ParsePSLBatches(void);				// parser thread entry, loops filling and parsing batches until EOF or errors
+	void FreePSLBatches(void);				// free all batches
+	int PrepBulkInserts(void);				// prepare bulk load multirow insert statements
+	void FinalizeBulkInserts(void);			// finalize bulk load insert statements
+#ifdef _WIN32
+	static unsigned int __stdcall _parse_start(void *args);
+#else
+	static void * _parse_start(void *args);
+#endif
 
 	INT32			// 20bit instance hash over the combination of parameterisation values passed into this function; if < 0 then hashing error 
 		GenSummaryInstanceHash(INT32 ExprID,// alignment summary is for alignment in this experiment
@@ -226,7 +329,8 @@ public:
 					char *pszTargetFile,		// against targeted sequences in this file
 					char *pszExprDescr = NULL,	// describes experiment
 					char *pszBlatParams = NULL,	// Blat parameters used
-					int ExprType = 0);			// experiment type, currently just a place holder and defaults to 0
+					int ExprType = 0,			// experiment type, currently just a place holder and defaults to 0
+					int NumThreads = 1);		// number of parser threads feeding the SQLite writer
 
 };
 
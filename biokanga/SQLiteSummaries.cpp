@@ -651,6 +651,9 @@ if((sqlite_error = sqlite3_exec(m_pDB,pszPragmaSyncOff,NULL,NULL,NULL))!=SQLITE_
 	return(eBSFerrInternal);
 	}
 
+// pszPragmaJournMem is intentionally not used: summaries from many experiments accumulate in the one database and the transaction
+// spans the whole experiment, so the on disk rollback journal is needed to recover earlier summaries should this experiment fail
+
 // bracket inserts as a single transaction
 if((sqlite_error = sqlite3_exec(m_pDB,pszBeginTransaction,NULL,NULL,NULL))!=SQLITE_OK)
 	{
@@ -0,0 +1,927 @@
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+
+// alignserver.cpp : long lived align server holding a suffix array resident, plus the thin client which submits jobs to it
+//
+// Jobs are exchanged through a spool directory:
+//   <name>.job     submitted job, written by alignsubmit as '<name>.tmp' then renamed so the server never sees a partial job
+//   <name>.<pid>@<host>.run  job claimed by the server with process identifier <pid> on <host> and currently aligning
+//   <name>.out     screen output (diagnostics) of the aligning job
+//   <name>.done    job completed successfully (renamed from the claimed '.run')
+//   <name>.failed  job completed with errors (renamed from the claimed '.run')
+//   shutdown       server stops claiming jobs, waits for running jobs to complete, then exits
+//   jobseq         last job sequence number, incremented under an exclusive lock by alignsubmit so job names sort in submission order
+// A job file contains the submitter's working directory on a line 'cwd=<dir>' followed by the align
+// subprocess parameters, one parameter per line. Lines starting with '#' are comments.
+// Each claimed job is run in a forked child process which inherits the resident suffix array (copy on write)
+// so the suffix array is loaded once only, however many jobs are aligned. The server's thread budget is shared: each job
+// is started with an equal share of the threads not in use by already running jobs over the remaining job slots (at least 1),
+// these threads are returned when the job completes.
+// On startup a server resubmits only those jobs claimed by a server on the same host which is no longer running, jobs claimed
+// by servers on other hosts sharing the spool directory, or by servers still running, are left with their owners.
+
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "../libbiokanga/commhdrs.h"
+#else
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <signal.h>
+#include "../libbiokanga/commhdrs.h"
+#endif
+
+#include "biokanga.h"
+#include "Aligner.h"
+
+extern int kanga(int argc, char* argv[]);
+
+const int cMaxAlignJobs = 32;				// server can run at most this many concurrent align jobs
+const int cMaxJobArgs = 1000;				// a job can have at most this many parameters
+const int cMaxJobFileLen = 0x0fffff;		// job files are expected to be less than 1MB
+const int cJobPollSecs = 1;					// server polls the spool directory for new jobs, and clients for job completion, at this interval
+
+const char *cpszJobExtn = ".job";			// submitted jobs
+const char *cpszJobTmpExtn = ".tmp";		// jobs being written by alignsubmit
+const char *cpszJobRunExtn = ".run";		// jobs claimed by server
+const char *cpszJobOutExtn = ".out";		// job screen output
+const char *cpszJobDoneExtn = ".done";		// jobs completed successfully
+const char *cpszJobFailedExtn = ".failed";	// jobs completed with errors
+const char *cpszShutdownFile = "shutdown";	// server shuts down after running jobs complete if this file is present in the spool directory
+const char *cpszJobSeqFile = "jobseq";		// job sequence counter, job names are the zero padded sequence number
+const int cMaxClaimHostLen = 255;			// host name in a claim is truncated to at most this length
+const int cMaxClaimOwnerLen = cMaxClaimHostLen + 20;	// claim owner '<pid>@<host>' is at most this length
+
+typedef struct TAG_sAlignJob {
+#ifndef _WIN32
+	pid_t Pid;								// job is being processed by this child process
+#endif
+	int NumThreads;							// job was granted this many threads from the server thread budget
+	char szJobName[_MAX_FNAME];				// job name (file name without extension)
+	} tsAlignJob;
+
+int
+ProcessAlignServer(char *pszSfxFile,		// suffix array to hold resident
+		bool bBisulfite,					// if true then suffix array is for bisulfite methylation patterning
+		bool bSOLiD,						// if true then suffix array is for colorspace
+		etSfxLoadMode SfxLoadMode,			// how the suffix array is to be loaded
+		char *pszSpoolDir,					// spool directory from which jobs are claimed
+		int MaxJobs,						// run at most this many concurrent align jobs
+		int NumThreads);					// total thread budget shared by concurrent jobs
+
+int
+ProcessAlignSubmit(char *pszSpoolDir,		// submit to server using this spool directory
+		bool bWait,							// wait for job to complete
+		bool bShutdown,						// request server shutdown
+		int NumJobArgs,						// number of align parameters in job
+		char *pszJobArgs[]);				// align parameters
+
+#ifdef _WIN32
+int alignserver(int argc, char* argv[])
+{
+// determine my process name
+_splitpath(argv[0],NULL,NULL,gszProcName,NULL);
+#else
+int
+alignserver(int argc, char** argv)
+{
+// determine my process name
+CUtility::splitpath((char *)argv[0],NULL,gszProcName);
+#endif
+
+int iFileLogLevel;			// level of file diagnostics
+int iScreenLogLevel;		// level of file diagnostics
+char szLogFile[_MAX_PATH];	// write diagnostics to this file
+int Rslt = 0;   			// function result code >= 0 represents success, < 0 on failure
+
+int NumberOfProcessors;		// number of installed CPUs
+int NumThreads;				// total thread budget over all concurrent jobs
+int MaxJobs;				// maximum number of concurrent jobs
+bool bSOLiD;				// if true then process for colorspace (SOLiD)
+bool bBisulfite;			// if true then process for bisulfite methylation patterning
+int SfxLoadMode;			// suffix array loading: 0 private copy, 1 memory mapped shared, 2 memory mapped shared and prefaulted
+char szTargFile[_MAX_PATH];	// suffix array to hold resident
+char szSpoolDir[_MAX_PATH];	// spool directory
+
+struct arg_lit  *help    = arg_lit0("h","help",                 "print this help and exit");
+struct arg_lit  *version = arg_lit0("v","version,ver",			"print version information and exit");
+struct arg_int *FileLogLevel=arg_int0("f", "FileLogLevel",		"<int>","Level of diagnostics written to screen and logfile 0=fatal,1=errors,2=info,3=diagnostics,4=debug");
+struct arg_file *LogFile = arg_file0("F","log","<file>",		"diagnostics log file");
+
+struct arg_file *sfxfile = arg_file1("I","sfx","<file>",		"hold this suffix array (kangax generated) file resident, align jobs requesting this file use it");
+struct arg_int *sfxload = arg_int0(NULL,"sfxload","<int>",		"suffix array loading: 0 - private copy, 1 - memory mapped shared with other processes, 2 - memory mapped shared and prefaulted (default: 0)");
+struct arg_lit  *bisulfite = arg_lit0("b","bisulfite",          "suffix array is for bisulfite methylation patterning jobs");
+struct arg_lit  *solid = arg_lit0("C","colorspace",             "suffix array is for colorspace (SOLiD) jobs");
+struct arg_file *spooldir = arg_file1("s","spool","<dir>",		"claim align jobs submitted to this spool directory");
+struct arg_int *maxjobs = arg_int0("j","maxjobs","<int>",		"run at most this many align jobs concurrently 1..32 (default 1)");
+struct arg_int *threads = arg_int0("T","threads","<int>",		"total number of processing threads 0..128 shared by concurrent jobs (defaults to 0 which sets threads to number of CPU cores)");
+struct arg_end *end = arg_end(200);
+
+void *argtable[] = {help,version,FileLogLevel,LogFile,
+					sfxfile,sfxload,bisulfite,solid,spooldir,maxjobs,threads,
+					end};
+
+char **pAllArgs;
+int argerrors;
+argerrors = CUtility::arg_parsefromfile(argc,(char **)argv,&pAllArgs);
+if(argerrors >= 0)
+	argerrors = arg_parse(argerrors,pAllArgs,argtable);
+
+/* special case: '--help' takes precedence over error reporting */
+if (help->count > 0)
+        {
+		printf("\n%s %s %s, Version %s\nOptions ---\n", gszProcName,gpszSubProcess->pszName,gpszSubProcess->pszFullDescr,cpszProgVer);
+        arg_print_syntax(stdout,argtable,"\n");
+        arg_print_glossary(stdout,argtable,"  %-25s %s\n");
+		printf("\nNote: Parameters can be entered into a parameter file, one parameter per line.");
+		printf("\n      To invoke this parameter file then precede its name with '@'");
+		printf("\n      e.g. %s %s @myparams.txt\n",gszProcName,gpszSubProcess->pszName);
+		printf("\nPlease report any issues regarding usage of %s at https://github.com/csiro-crop-informatics/biokanga/issues\n\n",gszProcName);
+		return(1);
+        }
+
+    /* special case: '--version' takes precedence error reporting */
+if (version->count > 0)
+        {
+		printf("\n%s %s Version %s\n",gszProcName,gpszSubProcess->pszName,cpszProgVer);
+		return(1);
+        }
+
+if (!argerrors)
+	{
+	if(FileLogLevel->count && !LogFile->count)
+		{
+		printf("\nError: FileLogLevel '-f%d' specified but no logfile '-F<logfile>\n'",FileLogLevel->ival[0]);
+		exit(1);
+		}
+
+	iScreenLogLevel = iFileLogLevel = FileLogLevel->count ? FileLogLevel->ival[0] : eDLInfo;
+	if(iFileLogLevel < eDLNone || iFileLogLevel > eDLDebug)
+		{
+		printf("\nError: FileLogLevel '-l%d' specified outside of range %d..%d\n",iFileLogLevel,eDLNone,eDLDebug);
+		exit(1);
+		}
+
+	if(LogFile->count)
+		{
+		strncpy(szLogFile,LogFile->filename[0],_MAX_PATH);
+		szLogFile[_MAX_PATH-1] = '\0';
+		}
+	else
+		{
+		iFileLogLevel = eDLNone;
+		szLogFile[0] = '\0';
+		}
+
+	// now that log parameters have been parsed then initialise diagnostics log system
+	if(!gDiagnostics.Open(szLogFile,(etDiagLevel)iScreenLogLevel,(etDiagLevel)iFileLogLevel,true))
+		{
+		printf("\nError: Unable to start diagnostics subsystem\n");
+		if(szLogFile[0] != '\0')
+			printf(" Most likely cause is that logfile '%s' can't be opened/created\n",szLogFile);
+		exit(1);
+		}
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Subprocess %s Version %s starting",gpszSubProcess->pszName,cpszProgVer);
+	gExperimentID = 0;
+	gProcessID = 0;
+	gProcessingID = 0;
+
+	strncpy(szTargFile,sfxfile->filename[0],_MAX_PATH);
+	szTargFile[_MAX_PATH-1] = '\0';
+	CUtility::TrimQuotedWhitespcExtd(szTargFile);
+	if(szTargFile[0] == '\0')
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: After removal of whitespace, no suffix array file specified with '-I<file>' option");
+		exit(1);
+		}
+
+	strncpy(szSpoolDir,spooldir->filename[0],_MAX_PATH);
+	szSpoolDir[_MAX_PATH-1] = '\0';
+	CUtility::TrimQuotedWhitespcExtd(szSpoolDir);
+	if(szSpoolDir[0] == '\0')
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: After removal of whitespace, no spool directory specified with '-s<dir>' option");
+		exit(1);
+		}
+
+	SfxLoadMode = sfxload->count ? sfxload->ival[0] : (int)eSfxLoadCopy;
+	if(SfxLoadMode < eSfxLoadCopy || SfxLoadMode > eSfxLoadMmapPopulate)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Suffix array load mode '--sfxload=%d' specified outside of range %d..%d",SfxLoadMode,eSfxLoadCopy,eSfxLoadMmapPopulate);
+		exit(1);
+		}
+	bBisulfite = bisulfite->count ? true : false;
+	bSOLiD = solid->count ? true : false;
+
+	MaxJobs = maxjobs->count ? maxjobs->ival[0] : 1;
+	if(MaxJobs < 1 || MaxJobs > cMaxAlignJobs)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Maximum concurrent jobs '-j%d' specified outside of range 1..%d",MaxJobs,cMaxAlignJobs);
+		exit(1);
+		}
+
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	NumberOfProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+	NumberOfProcessors = sysconf(_SC_NPROCESSORS_CONF);
+#endif
+	int MaxAllowedThreads = min(cMaxWorkerThreads,NumberOfProcessors);	// limit to be at most cMaxWorkerThreads
+	if((NumThreads = threads->count ? threads->ival[0] : MaxAllowedThreads)==0)
+		NumThreads = MaxAllowedThreads;
+	if(NumThreads < 0 || NumThreads > MaxAllowedThreads)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Number of threads '-T%d' specified was outside of range %d..%d",NumThreads,1,MaxAllowedThreads);
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Defaulting number of threads to %d",MaxAllowedThreads);
+		NumThreads = MaxAllowedThreads;
+		}
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing parameters:");
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Resident suffix array file: '%s'",szTargFile);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Suffix array loading: %s",SfxLoadMode == eSfxLoadCopy ? "private copy" : (SfxLoadMode == eSfxLoadMmap ? "memory mapped shared" : "memory mapped shared and prefaulted"));
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Suffix array for: %s",bBisulfite ? "bisulfite" : (bSOLiD ? "colorspace" : "standard"));
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Spool directory: '%s'",szSpoolDir);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Maximum concurrent jobs: %d",MaxJobs);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Total thread budget: %d",NumThreads);
+
+#ifdef _WIN32
+	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
+#endif
+	gStopWatch.Start();
+	Rslt = ProcessAlignServer(szTargFile,bBisulfite,bSOLiD,(etSfxLoadMode)SfxLoadMode,szSpoolDir,MaxJobs,NumThreads);
+	Rslt = Rslt >=0 ? 0 : 1;
+	gStopWatch.Stop();
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Exit code: %d Total processing time: %s",Rslt,gStopWatch.Read());
+	exit(Rslt);
+	}
+else
+	{
+    printf("\n%s %s %s, Version %s\n", gszProcName,gpszSubProcess->pszName,gpszSubProcess->pszFullDescr,cpszProgVer);
+	arg_print_errors(stdout,end,gszProcName);
+	arg_print_syntax(stdout,argtable,"\nUse '-h' to view option and parameter usage\n");
+	exit(1);
+	}
+return 0;
+}
+
+#ifdef _WIN32
+int alignsubmit(int argc, char* argv[])
+{
+// determine my process name
+_splitpath(argv[0],NULL,NULL,gszProcName,NULL);
+#else
+int
+alignsubmit(int argc, char** argv)
+{
+// determine my process name
+CUtility::splitpath((char *)argv[0],NULL,gszProcName);
+#endif
+int Rslt;
+int Idx;
+int NumJobArgs;				// number of align parameters following the '--' separator
+char **ppszJobArgs;			// align parameters
+char szSpoolDir[_MAX_PATH];	// submit to server using this spool directory
+
+struct arg_lit  *help    = arg_lit0("h","help",                 "print this help and exit");
+struct arg_lit  *version = arg_lit0("v","version,ver",			"print version information and exit");
+struct arg_file *spooldir = arg_file1("s","spool","<dir>",		"submit align job to the server claiming jobs from this spool directory");
+struct arg_lit  *wait = arg_lit0("w","wait",					"wait for the job to complete, exit code is that of the align job");
+struct arg_lit  *shutdown = arg_lit0(NULL,"shutdown",			"request server shutdown once running jobs have completed");
+struct arg_end *end = arg_end(200);
+
+void *argtable[] = {help,version,spooldir,wait,shutdown,
+					end};
+
+// align job parameters follow the '--' separator and are not parsed here
+NumJobArgs = 0;
+ppszJobArgs = NULL;
+for(Idx = 1; Idx < argc; Idx++)
+	if(!strcmp(argv[Idx],"--"))
+		{
+		NumJobArgs = argc - Idx - 1;
+		ppszJobArgs = &argv[Idx+1];
+		argc = Idx;
+		break;
+		}
+
+char **pAllArgs;
+int argerrors;
+argerrors = CUtility::arg_parsefromfile(argc,(char **)argv,&pAllArgs);
+if(argerrors >= 0)
+	argerrors = arg_parse(argerrors,pAllArgs,argtable);
+
+/* special case: '--help' takes precedence over error reporting */
+if (help->count > 0)
+        {
+		printf("\n%s %s %s, Version %s\nOptions ---\n", gszProcName,gpszSubProcess->pszName,gpszSubProcess->pszFullDescr,cpszProgVer);
+        arg_print_syntax(stdout,argtable," -- <align parameters>\n");
+        arg_print_glossary(stdout,argtable,"  %-25s %s\n");
+		printf("\nNote: The align job parameters follow '--' and are exactly those accepted by '%s align'",gszProcName);
+		printf("\n      e.g. %s %s -s spooldir -w -- -I genome.sfx -i reads.fq -o reads.bam\n",gszProcName,gpszSubProcess->pszName);
+		printf("\n      Relative file names are relative to the directory from which the job was submitted.\n");
+		printf("\nPlease report any issues regarding usage of %s at https://github.com/csiro-crop-informatics/biokanga/issues\n\n",gszProcName);
+		return(1);
+        }
+
+    /* special case: '--version' takes precedence error reporting */
+if (version->count > 0)
+        {
+		printf("\n%s %s Version %s\n",gszProcName,gpszSubProcess->pszName,cpszProgVer);
+		return(1);
+        }
+
+if (!argerrors)
+	{
+	if(!gDiagnostics.Open(NULL,eDLInfo,eDLNone,true))
+		{
+		printf("\nError: Unable to start diagnostics subsystem\n");
+		exit(1);
+		}
+
+	strncpy(szSpoolDir,spooldir->filename[0],_MAX_PATH);
+	szSpoolDir[_MAX_PATH-1] = '\0';
+	CUtility::TrimQuotedWhitespcExtd(szSpoolDir);
+	if(szSpoolDir[0] == '\0')
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: After removal of whitespace, no spool directory specified with '-s<dir>' option");
+		exit(1);
+		}
+
+	if(!shutdown->count && NumJobArgs == 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: No align job parameters following '--' and no '--shutdown' requested");
+		exit(1);
+		}
+	if(NumJobArgs > cMaxJobArgs)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Too many align job parameters (%d), limit is %d",NumJobArgs,cMaxJobArgs);
+		exit(1);
+		}
+
+	Rslt = ProcessAlignSubmit(szSpoolDir,wait->count ? true : false,shutdown->count ? true : false,NumJobArgs,ppszJobArgs);
+	exit(Rslt);
+	}
+else
+	{
+    printf("\n%s %s %s, Version %s\n", gszProcName,gpszSubProcess->pszName,gpszSubProcess->pszFullDescr,cpszProgVer);
+	arg_print_errors(stdout,end,gszProcName);
+	arg_print_syntax(stdout,argtable," -- <align parameters>\nUse '-h' to view option and parameter usage\n");
+	exit(1);
+	}
+return 0;
+}
+
+#ifdef _WIN32
+int
+ProcessAlignServer(char *pszSfxFile,		// suffix array to hold resident
+		bool bBisulfite,					// if true then suffix array is for bisulfite methylation patterning
+		bool bSOLiD,						// if true then suffix array is for colorspace
+		etSfxLoadMode SfxLoadMode,			// how the suffix array is to be loaded
+		char *pszSpoolDir,					// spool directory from which jobs are claimed
+		int MaxJobs,						// run at most this many concurrent align jobs
+		int NumThreads)						// total thread budget shared by concurrent jobs
+{
+gDiagnostics.DiagOut(eDLFatal,gszProcName,"Align server is not supported on Windows, use '--sfxload' to share suffix arrays between align processes");
+return(eBSFerrInternal);
+}
+
+int
+ProcessAlignSubmit(char *pszSpoolDir,		// submit to server using this spool directory
+		bool bWait,							// wait for job to complete
+		bool bShutdown,						// request server shutdown
+		int NumJobArgs,						// number of align parameters in job
+		char *pszJobArgs[])					// align parameters
+{
+gDiagnostics.DiagOut(eDLFatal,gszProcName,"Align server is not supported on Windows");
+return(1);
+}
+#else
+
+static volatile sig_atomic_t m_bShutdownSignaled = 0;	// set on SIGTERM or SIGINT, server shuts down as if the shutdown file was present
+static char m_szClaimOwner[cMaxClaimOwnerLen+1];		// this server's claim owner as '<pid>@<host>'
+static char m_szClaimHost[cMaxClaimHostLen+1];		// host on which this server is running
+
+static void
+AlignServerSignal(int Signal)
+{
+m_bShutdownSignaled = 1;
+}
+
+// RunAlignJob
+// Executed in the forked child: parses the job file, redirects screen output, changes to the submitters working directory
+// and then aligns using the same code path as 'biokanga align'. Never returns.
+static void
+RunAlignJob(char *pszJobFile,				// claimed job file
+			char *pszOutFile)				// job screen output to this file
+{
+int hOut;
+int NumArgs;
+int LineLen;
+char *pszLine;
+char *pszNxtLine;
+char *pszJob;
+char *pszCwd;
+char *ppszArgs[cMaxJobArgs + 2];
+char szProcName[_MAX_FNAME];
+FILE *pJobStream;
+size_t JobLen;
+
+signal(SIGTERM,SIG_DFL);
+signal(SIGINT,SIG_DFL);
+
+if((hOut = open(pszOutFile,O_WRONLY | O_CREAT | O_TRUNC,S_IREAD | S_IWRITE | S_IRGRP | S_IROTH)) != -1)
+	{
+	dup2(hOut,STDOUT_FILENO);
+	dup2(hOut,STDERR_FILENO);
+	close(hOut);
+	}
+
+if((pszJob = (char *)malloc(cMaxJobFileLen + 1)) == NULL)
+	{
+	printf("\nError: Unable to allocate memory for job file '%s'\n",pszJobFile);
+	exit(1);
+	}
+if((pJobStream = fopen(pszJobFile,"r")) == NULL)
+	{
+	printf("\nError: Unable to open job file '%s' - %s\n",pszJobFile,strerror(errno));
+	exit(1);
+	}
+JobLen = fread(pszJob,1,cMaxJobFileLen,pJobStream);
+fclose(pJobStream);
+pszJob[JobLen] = '\0';
+
+// one parameter per line, parameters are used verbatim so may contain whitespace
+strcpy(szProcName,gszProcName);		// kanga() sets gszProcName from its argv[0]
+ppszArgs[0] = szProcName;
+NumArgs = 1;
+pszCwd = NULL;
+for(pszLine = pszJob; pszLine != NULL && *pszLine != '\0'; pszLine = pszNxtLine)
+	{
+	if((pszNxtLine = strchr(pszLine,'\n')) != NULL)
+		*pszNxtLine++ = '\0';
+	LineLen = (int)strlen(pszLine);
+	if(LineLen > 0 && pszLine[LineLen-1] == '\r')
+		pszLine[--LineLen] = '\0';
+	if(LineLen == 0 || pszLine[0] == '#')
+		continue;
+	if(pszCwd == NULL && !strncmp(pszLine,"cwd=",4))
+		{
+		pszCwd = &pszLine[4];
+		continue;
+		}
+	if(NumArgs > cMaxJobArgs)
+		{
+		printf("\nError: Job file '%s' has more than %d parameters\n",pszJobFile,cMaxJobArgs);
+		exit(1);
+		}
+	ppszArgs[NumArgs++] = pszLine;
+	}
+ppszArgs[NumArgs] = NULL;
+
+if(pszCwd != NULL && chdir(pszCwd) != 0)
+	{
+	printf("\nError: Unable to change to job working directory '%s' - %s\n",pszCwd,strerror(errno));
+	exit(1);
+	}
+
+exit(kanga(NumArgs,ppszArgs));
+}
+
+// RunJobFile
+// Returns the path of a job when claimed by this server, the claim owner is part of the file name so claiming remains a single atomic rename
+static char *
+RunJobFile(char *pszRunFile,				// returned claimed job path, _MAX_PATH in size
+		   char *pszSpoolDir,				// spool directory
+		   char *pszJobName)				// job name
+{
+sprintf(pszRunFile,"%s/%s.%s%s",pszSpoolDir,pszJobName,m_szClaimOwner,cpszJobRunExtn);
+return(pszRunFile);
+}
+
+// ResubmitOrphanedJobs
+// Jobs claimed by a previous server on this host which is no longer running are resubmitted by renaming back to '.job'
+// Claims by still running servers, or by servers on other hosts sharing the spool directory, can't be checked so are left with their owners
+static void
+ResubmitOrphanedJobs(char *pszSpoolDir)		// spool directory
+{
+DIR *pDir;
+struct dirent *pEntry;
+int NameLen;
+int OwnerLen;
+int ExtnLen;
+pid_t OwnerPid;
+char *pszOwner;
+char *pszHost;
+char szOwner[cMaxClaimOwnerLen+1];
+char szJobName[_MAX_FNAME];
+char szRunFile[_MAX_PATH];
+char szJobFile[_MAX_PATH];
+
+if((pDir = opendir(pszSpoolDir)) == NULL)
+	return;
+ExtnLen = (int)strlen(cpszJobRunExtn);
+while((pEntry = readdir(pDir)) != NULL)
+	{
+	NameLen = (int)strlen(pEntry->d_name);
+	if(NameLen <= ExtnLen || NameLen - ExtnLen >= _MAX_FNAME || strcmp(&pEntry->d_name[NameLen - ExtnLen],cpszJobRunExtn))
+		continue;
+	memcpy(szJobName,pEntry->d_name,NameLen - ExtnLen);
+	szJobName[NameLen - ExtnLen] = '\0';
+
+	// job names are sequence numbers so the owner follows the first '.'
+	if((pszOwner = strchr(szJobName,'.')) == NULL || (OwnerLen = (int)strlen(pszOwner+1)) == 0 || OwnerLen > cMaxClaimOwnerLen ||
+		(pszHost = strchr(pszOwner+1,'@')) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Job claim '%s' has no owning server recorded, not resubmitting",pEntry->d_name);
+		continue;
+		}
+	*pszOwner++ = '\0';
+	strcpy(szOwner,pszOwner);
+	*pszHost++ = '\0';
+	OwnerPid = (pid_t)atol(pszOwner);
+
+	if(strcmp(pszHost,m_szClaimHost))
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Job '%s' is claimed by a server on host '%s', leaving with that server",szJobName,pszHost);
+		continue;
+		}
+	if(OwnerPid > 0 && (kill(OwnerPid,0) == 0 || errno == EPERM))
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Job '%s' is claimed by running server process %d, leaving with that server",szJobName,(int)OwnerPid);
+		continue;
+		}
+
+	sprintf(szRunFile,"%s/%s",pszSpoolDir,pEntry->d_name);
+	sprintf(szJobFile,"%s/%s%s",pszSpoolDir,szJobName,cpszJobExtn);
+	if(rename(szRunFile,szJobFile) == 0)
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Resubmitting job '%s' left claimed by server process %d which is no longer running",szJobName,(int)OwnerPid);
+	}
+closedir(pDir);
+}
+
+// ClaimAlignJob
+// Claims the oldest submitted job, by job name order, by renaming it from '.job' to '.<pid>@<host>.run'
+// Returns false if there are no submitted jobs
+static bool
+ClaimAlignJob(char *pszSpoolDir,			// spool directory
+			  char *pszJobName)				// returned claimed job name, _MAX_FNAME in size
+{
+DIR *pDir;
+struct dirent *pEntry;
+int NameLen;
+int ExtnLen;
+char szJobFile[_MAX_PATH];
+char szRunFile[_MAX_PATH];
+
+for(;;)
+	{
+	if((pDir = opendir(pszSpoolDir)) == NULL)
+		return(false);
+	pszJobName[0] = '\0';
+	ExtnLen = (int)strlen(cpszJobExtn);
+	while((pEntry = readdir(pDir)) != NULL)
+		{
+		NameLen = (int)strlen(pEntry->d_name);
+		if(NameLen <= ExtnLen || NameLen - ExtnLen >= _MAX_FNAME || strcmp(&pEntry->d_name[NameLen - ExtnLen],cpszJobExtn))
+			continue;
+		if(pszJobName[0] != '\0' && strncmp(pEntry->d_name,pszJobName,NameLen - ExtnLen) >= 0)
+			continue;
+		memcpy(pszJobName,pEntry->d_name,NameLen - ExtnLen);
+		pszJobName[NameLen - ExtnLen] = '\0';
+		}
+	closedir(pDir);
+	if(pszJobName[0] == '\0')
+		return(false);
+
+	sprintf(szJobFile,"%s/%s%s",pszSpoolDir,pszJobName,cpszJobExtn);
+	RunJobFile(szRunFile,pszSpoolDir,pszJobName);
+	if(rename(szJobFile,szRunFile) == 0)
+		return(true);
+	// job disappeared, e.g. withdrawn by submitter, so try for next job
+	}
+}
+
+int
+ProcessAlignServer(char *pszSfxFile,		// suffix array to hold resident
+		bool bBisulfite,					// if true then suffix array is for bisulfite methylation patterning
+		bool bSOLiD,						// if true then suffix array is for colorspace
+		etSfxLoadMode SfxLoadMode,			// how the suffix array is to be loaded
+		char *pszSpoolDir,					// spool directory from which jobs are claimed
+		int MaxJobs,						// run at most this many concurrent align jobs
+		int NumThreads)						// total thread budget shared by concurrent jobs
+{
+int Rslt;
+int Idx;
+int JobStatus;
+int NumRunning;
+int ThreadsInUse;
+int JobThreads;
+UINT32 NumCompleted;
+UINT32 NumFailed;
+bool bShutdown;
+pid_t Pid;
+struct stat FileStat;
+CSfxArrayV3 *pSfxArray;
+tsAlignJob Jobs[cMaxAlignJobs];
+char szJobName[_MAX_FNAME];
+char szJobFile[_MAX_PATH];
+char szRunFile[_MAX_PATH];
+char szOutFile[_MAX_PATH];
+char szShutdownFile[_MAX_PATH];
+
+if(stat(pszSpoolDir,&FileStat) != 0 || !S_ISDIR(FileStat.st_mode))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Spool directory '%s' does not exist or is not a directory",pszSpoolDir);
+	return(eBSFerrOpnFile);
+	}
+
+// jobs are claimed in this servers name so claims can later be checked for orphaning
+if(gethostname(m_szClaimHost,sizeof(m_szClaimHost)-1) != 0 || m_szClaimHost[0] == '\0')
+	strcpy(m_szClaimHost,"localhost");
+m_szClaimHost[sizeof(m_szClaimHost)-1] = '\0';
+for(Idx = 0; m_szClaimHost[Idx] != '\0'; Idx++)		// host is part of a file name
+	if(m_szClaimHost[Idx] == '/')
+		m_szClaimHost[Idx] = '_';
+snprintf(m_szClaimOwner,sizeof(m_szClaimOwner),"%d@%s",(int)getpid(),m_szClaimHost);
+
+// any jobs left claimed by a previous server instance on this host, which is no longer running, are resubmitted
+ResubmitOrphanedJobs(pszSpoolDir);
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loading suffix array file '%s'", pszSfxFile);
+if((pSfxArray = new CSfxArrayV3()) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to instantiate CSfxArrayV3");
+	return(eBSFerrObj);
+	}
+if((Rslt=pSfxArray->Open(pszSfxFile,false,bBisulfite,bSOLiD,SfxLoadMode))!=eBSFSuccess)
+	{
+	while(pSfxArray->NumErrMsgs())
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,pSfxArray->GetErrMsg());
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to open input bioseq suffix array file '%s'",pszSfxFile);
+	delete pSfxArray;
+	return(Rslt);
+	}
+
+// jobs are forked processes which inherit only the calling thread, so the suffix block must be fully loaded and the
+// readahead thread terminated before any job is forked
+if((Rslt=pSfxArray->HoldSfxBlockResident())!=eBSFSuccess)
+	{
+	while(pSfxArray->NumErrMsgs())
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,pSfxArray->GetErrMsg());
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to load suffix array block from '%s'",pszSfxFile);
+	delete pSfxArray;
+	return(Rslt);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Suffix array for '%s' is resident, up to %d concurrent jobs sharing %d threads",
+					 pSfxArray->GetDatasetName(),MaxJobs,NumThreads);
+
+signal(SIGTERM,AlignServerSignal);
+signal(SIGINT,AlignServerSignal);
+
+sprintf(szShutdownFile,"%s/%s",pszSpoolDir,cpszShutdownFile);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Accepting align jobs submitted to spool directory '%s'",pszSpoolDir);
+NumRunning = 0;
+ThreadsInUse = 0;
+NumCompleted = 0;
+NumFailed = 0;
+bShutdown = false;
+Rslt = eBSFSuccess;
+for(;;)
+	{
+	// reap any completed jobs
+	while(NumRunning > 0 && (Pid = waitpid(-1,&JobStatus,WNOHANG)) > 0)
+		{
+		for(Idx = 0; Idx < NumRunning; Idx++)
+			if(Jobs[Idx].Pid == Pid)
+				break;
+		if(Idx == NumRunning)
+			continue;
+		bool bJobOK = WIFEXITED(JobStatus) && WEXITSTATUS(JobStatus) == 0;
+		RunJobFile(szRunFile,pszSpoolDir,Jobs[Idx].szJobName);
+		sprintf(szJobFile,"%s/%s%s",pszSpoolDir,Jobs[Idx].szJobName,bJobOK ? cpszJobDoneExtn : cpszJobFailedExtn);
+		rename(szRunFile,szJobFile);
+		if(bJobOK)
+			{
+			NumCompleted += 1;
+			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Job '%s' completed",Jobs[Idx].szJobName);
+			}
+		else
+			{
+			NumFailed += 1;
+			if(WIFEXITED(JobStatus))
+				gDiagnostics.DiagOut(eDLWarn,gszProcName,"Job '%s' failed with exit code %d",Jobs[Idx].szJobName,WEXITSTATUS(JobStatus));
+			else
+				gDiagnostics.DiagOut(eDLWarn,gszProcName,"Job '%s' failed, terminated by signal %d",Jobs[Idx].szJobName,WIFSIGNALED(JobStatus) ? WTERMSIG(JobStatus) : 0);
+			}
+		ThreadsInUse -= Jobs[Idx].NumThreads;
+		if(Idx < NumRunning - 1)
+			Jobs[Idx] = Jobs[NumRunning - 1];
+		NumRunning -= 1;
+		}
+
+	if(!bShutdown && (m_bShutdownSignaled || stat(szShutdownFile,&FileStat) == 0))
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Shutdown requested, no further jobs will be claimed, waiting on %d running jobs",NumRunning);
+		bShutdown = true;
+		}
+	if(bShutdown && NumRunning == 0)
+		break;
+
+	// claim and start new jobs while under the concurrent job limit
+	while(!bShutdown && NumRunning < MaxJobs && ClaimAlignJob(pszSpoolDir,szJobName))
+		{
+		RunJobFile(szRunFile,pszSpoolDir,szJobName);
+		sprintf(szOutFile,"%s/%s%s",pszSpoolDir,szJobName,cpszJobOutExtn);
+
+		// job is granted an equal share, over the remaining job slots, of the threads not currently in use by running jobs
+		// so later jobs are not starved by earlier jobs, forked child inherits the limit
+		JobThreads = max(1,(NumThreads - ThreadsInUse) / (MaxJobs - NumRunning));
+		CAligner::SetResidentSfx(pSfxArray,pszSfxFile,bBisulfite,bSOLiD,JobThreads);
+		fflush(stdout);
+		fflush(stderr);
+		if((Pid = fork()) == 0)
+			RunAlignJob(szRunFile,szOutFile);		// never returns
+		if(Pid < 0)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to fork process for job '%s' - %s",szJobName,strerror(errno));
+			sprintf(szJobFile,"%s/%s%s",pszSpoolDir,szJobName,cpszJobExtn);
+			rename(szRunFile,szJobFile);
+			Rslt = eBSFerrInternal;
+			bShutdown = true;
+			break;
+			}
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Job '%s' started with up to %d threads",szJobName,JobThreads);
+		Jobs[NumRunning].Pid = Pid;
+		Jobs[NumRunning].NumThreads = JobThreads;
+		ThreadsInUse += JobThreads;
+		strcpy(Jobs[NumRunning].szJobName,szJobName);
+		NumRunning += 1;
+		}
+
+	sleep(cJobPollSecs);
+	}
+
+if(stat(szShutdownFile,&FileStat) == 0)
+	remove(szShutdownFile);
+CAligner::SetResidentSfx(NULL,NULL,false,false,0);
+delete pSfxArray;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Align server completed %u jobs, %u failed",NumCompleted,NumFailed);
+return(Rslt);
+}
+
+// NxtJobSeq
+// Returns the next job sequence number, or < 0 if errors
+// Counter is held in the spool directory and updated under an exclusive lock so concurrent submitters are each given a unique
+// and increasing sequence number, job names then sort in submission order even if submitted within the same second
+static INT64
+NxtJobSeq(char *pszSpoolDir)				// spool directory containing job sequence counter
+{
+int hSeqFile;
+int NumRead;
+INT64 JobSeq;
+struct flock Lock;
+char szSeqFile[_MAX_PATH];
+char szSeq[32];
+
+sprintf(szSeqFile,"%s/%s",pszSpoolDir,cpszJobSeqFile);
+if((hSeqFile = open(szSeqFile,O_RDWR | O_CREAT,S_IREAD | S_IWRITE | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH)) == -1)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to open job sequence file '%s' - %s",szSeqFile,strerror(errno));
+	return(-1);
+	}
+memset(&Lock,0,sizeof(Lock));
+Lock.l_type = F_WRLCK;
+Lock.l_whence = SEEK_SET;
+while(fcntl(hSeqFile,F_SETLKW,&Lock) == -1)
+	{
+	if(errno == EINTR)
+		continue;
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to lock job sequence file '%s' - %s",szSeqFile,strerror(errno));
+	close(hSeqFile);
+	return(-1);
+	}
+JobSeq = 0;
+if((NumRead = (int)pread(hSeqFile,szSeq,sizeof(szSeq)-1,0)) > 0)
+	{
+	szSeq[NumRead] = '\0';
+	JobSeq = strtoll(szSeq,NULL,10);
+	}
+JobSeq += 1;
+sprintf(szSeq,"%lld\n",(long long)JobSeq);
+if(pwrite(hSeqFile,szSeq,strlen(szSeq),0) != (ssize_t)strlen(szSeq) || ftruncate(hSeqFile,strlen(szSeq)) != 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to update job sequence file '%s' - %s",szSeqFile,strerror(errno));
+	JobSeq = -1;
+	}
+close(hSeqFile);			// also releases the lock
+return(JobSeq);
+}
+
+int
+ProcessAlignSubmit(char *pszSpoolDir,		// submit to server using this spool directory
+		bool bWait,							// wait for job to complete
+		bool bShutdown,						// request server shutdown
+		int NumJobArgs,						// number of align parameters in job
+		char *pszJobArgs[])					// align parameters
+{
+int Idx;
+INT64 JobSeq;
+FILE *pJobStream;
+struct stat FileStat;
+char szCwd[_MAX_PATH];
+char szJobName[_MAX_FNAME];
+char szTmpFile[_MAX_PATH];
+char szJobFile[_MAX_PATH];
+char szDoneFile[_MAX_PATH];
+char szFailedFile[_MAX_PATH];
+
+if(stat(pszSpoolDir,&FileStat) != 0 || !S_ISDIR(FileStat.st_mode))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Spool directory '%s' does not exist or is not a directory",pszSpoolDir);
+	return(1);
+	}
+
+if(NumJobArgs > 0)
+	{
+	if(getcwd(szCwd,sizeof(szCwd)) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to determine current working directory - %s",strerror(errno));
+		return(1);
+		}
+	for(Idx = 0; Idx < NumJobArgs; Idx++)
+		if(strchr(pszJobArgs[Idx],'\n') != NULL)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Align job parameter %d contains an embedded newline",Idx+1);
+			return(1);
+			}
+
+	// job names sort in submission order, the server claims jobs oldest first
+	if((JobSeq = NxtJobSeq(pszSpoolDir)) < 0)
+		return(1);
+	sprintf(szJobName,"%012lld",(long long)JobSeq);
+	sprintf(szTmpFile,"%s/%s%s",pszSpoolDir,szJobName,cpszJobTmpExtn);
+	sprintf(szJobFile,"%s/%s%s",pszSpoolDir,szJobName,cpszJobExtn);
+	if((pJobStream = fopen(szTmpFile,"w")) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to create job file '%s' - %s",szTmpFile,strerror(errno));
+		return(1);
+		}
+	fprintf(pJobStream,"# %s align job\ncwd=%s\n",gszProcName,szCwd);
+	for(Idx = 0; Idx < NumJobArgs; Idx++)
+		fprintf(pJobStream,"%s\n",pszJobArgs[Idx]);
+	if(fclose(pJobStream) != 0 || rename(szTmpFile,szJobFile) != 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to submit job file '%s' - %s",szJobFile,strerror(errno));
+		remove(szTmpFile);
+		return(1);
+		}
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Submitted job '%s', screen output will be written to '%s/%s%s'",szJobName,pszSpoolDir,szJobName,cpszJobOutExtn);
+	}
+
+if(bShutdown)
+	{
+	sprintf(szJobFile,"%s/%s",pszSpoolDir,cpszShutdownFile);
+	if((pJobStream = fopen(szJobFile,"w")) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to create shutdown request '%s' - %s",szJobFile,strerror(errno));
+		return(1);
+		}
+	fclose(pJobStream);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Requested server shutdown");
+	}
+
+if(!bWait || NumJobArgs == 0)
+	return(0);
+
+sprintf(szDoneFile,"%s/%s%s",pszSpoolDir,szJobName,cpszJobDoneExtn);
+sprintf(szFailedFile,"%s/%s%s",pszSpoolDir,szJobName,cpszJobFailedExtn);
+for(;;)
+	{
+	if(stat(szDoneFile,&FileStat) == 0)
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Job '%s' completed",szJobName);
+		return(0);
+		}
+	if(stat(szFailedFile,&FileStat) == 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Job '%s' failed, refer to '%s/%s%s'",szJobName,pszSpoolDir,szJobName,cpszJobOutExtn);
+		return(1);
+		}
+	sleep(cJobPollSecs);
+	}
+}
+#endif
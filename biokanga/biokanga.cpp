@@ -46,6 +46,8 @@ extern int ReadsetDists(int argc, char* argv[]);
 extern int Assemble(int argc, char* argv[]);
 extern int ScaffoldContigs(int argc, char* argv[]);
 extern int kanga(int argc, char* argv[]);
+extern int alignserver(int argc, char* argv[]);
+extern int alignsubmit(int argc, char* argv[]);
 extern int kangax(int argc, char* argv[]);
 extern int kangade(int argc, char* argv[]);
 extern int maploci2features(int argc, char* argv[]);
@@ -108,6 +110,8 @@ tsSubProcess SubProcesses[] = {
 	{"prekmarkers","K-Mer Prefix Markers","NGS reads alignment-less prefix K-mer derived marker sequences generation",kmermarkers},
 	{"pseudogenome","Generate Pseudo-Genome","Concatenate sequences to create pseudo-genome assembly",genpseudogenome},
 	{"align","Align NGS reads","\tAlign NGS reads to indexed genome assembly or sequences",kanga},
+	{"alignserver","Align Server","\tHold indexed genome assembly resident and align jobs submitted to spool directory",alignserver},
+	{"alignsubmit","Align Submit","\tSubmit align job to align server spool directory",alignsubmit},
 	{"pescaffold","PE Scaffold","Scaffold assembly contigs using PE read alignments",pescaffold},
 	{"ssr","SSR Discovery","\tIdentify SSRs in multifasta sequences",SSRdiscovery},
 	{"maploci","Map Loci to Features","Map aligned reads loci to known features",maploci2features},
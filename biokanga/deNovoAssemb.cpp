@@ -37,6 +37,15 @@ m_NReduceThresSteps = 0;
 m_pAllocdThreadSeqs = NULL;
 m_AllocdThreadSeqsSize = 0;
 memset(m_ThreadSeqBlocks,0,sizeof(m_ThreadSeqBlocks));
+m_SfxLayoutGen = 1;
+m_SfxRemapLayoutGen = 0;
+m_SfxRemapNumSeqs = 0;
+m_AllocdSfxRemapSize = 0;
+m_pSfxRemapSeqIDs = NULL;
+memset(m_RetainedSfx,0,sizeof(m_RetainedSfx));
+m_SfxIndexMode = eSfxIdxIncr;
+m_NumSfxIndexGens = 0;
+m_SfxIndexSecs = 0.0;
 }
 
 
@@ -53,6 +62,7 @@ if(m_pAllocdThreadSeqs != NULL)
 #endif	
 	m_pAllocdThreadSeqs = NULL;
 	}
+ResetRetainedSfx();
 }
 
 teBSFrsltCodes
@@ -212,6 +222,7 @@ if(MaxPasses < 0)	// caller just wanted the sequences loaded?
 	}
 
 // there will be multiple passes until assembly is deemed to have completed
+ResetRetainedSfx();
 CurPass = 0;
 MergedPercentage = 100.0;			// ensure will not terminate on 1st pass without trying to merge! 
 bNewThres = false;
@@ -258,13 +269,15 @@ while(m_Sequences.NumSeqs2Assemb) {
 	// generate index - if no subs specified then index is required on just on initial SeqWrd of sequence, otherwise it is over 
 	// the 1st 4 SeqWrds as this allows subs in the first 60 bases to be discovered
 	// as an memory optimisation don't create index over the last 2 SeqWrds (could be between 16 and 30 bases in these)     
-	if((Rslt=GenRdsSfx(AllowedSubsKbp == 0 && AllowedEnd12Subs == 0 ? 1 : 4, 2)) < eBSFSuccess)
-		return((teBSFrsltCodes)Rslt);
-
+	// sequence starts are generated first as the index retained from the previous pass is remapped through these, only sequences
+	// which were merged, extended or trimmed in the previous pass need to be sorted into the index
 	// generate array of sequence starts plus array of flags from sequence headers
 	if((Rslt=GenSeqStarts(true,false)) < eBSFSuccess)
 		return((teBSFrsltCodes)Rslt);
 
+	if((Rslt=GenPassRdsSfx(false,AllowedSubsKbp == 0 && AllowedEnd12Subs == 0 ? 1 : 4, 2)) < eBSFSuccess)
+		return((teBSFrsltCodes)Rslt);
+
 #ifdef _DEBUG
 #ifdef _WIN32
 	ValidateSeqs2AssembStarts(); // only bother with validation whist debugging
@@ -394,26 +407,33 @@ while(m_Sequences.NumSeqs2Assemb) {
 	if(Rslt < eBSFSuccess)
 		return((teBSFrsltCodes)Rslt);
 
+	// retain sense index, in a sequence layout independent form, for remapping in the next pass
+	if((Rslt=RetainRdsSfx(false,AllowedSubsKbp == 0 && AllowedEnd12Subs == 0 ? 1 : 4, 2)) < eBSFSuccess)
+		return((teBSFrsltCodes)Rslt);
+
 	if(!bSenseStrandOnly)
 		{
 		gDiagnostics.DiagOut(eDLInfo,gszProcName,"AssembReads: Reverse complementing sequences ready for processing sense overlapping onto antisense ...");
 		// reverse complement all sequences including PE's
 		PackedRevCplAllIncPEs();
 
-		// regenerate the index on the reverse complemented sequences
-		if((Rslt=GenRdsSfx(AllowedSubsKbp == 0 && AllowedEnd12Subs == 0 ? 1 : 4,2)) < eBSFSuccess)
-			return((teBSFrsltCodes)Rslt);
-
 		// generate array of sequence starts but do not overwrite existing array of existing flags as these will have been updated during the overlap onto sense processing
 		if((Rslt=GenSeqStarts(false,false)) < eBSFSuccess)
 			return((teBSFrsltCodes)Rslt);
 
+		// regenerate the index on the reverse complemented sequences, remapping the antisense index retained from the previous pass
+		if((Rslt=GenPassRdsSfx(true,AllowedSubsKbp == 0 && AllowedEnd12Subs == 0 ? 1 : 4,2)) < eBSFSuccess)
+			return((teBSFrsltCodes)Rslt);
+
 		// do some real work - locate overlaps and extend sequences with current overlap thresholds
 		m_NextProcSeqID = 0;
 		Rslt = BuildOverlapExtensions(CurPass,true,bAllowSE2PE,AllowedSubsKbp,AllowedEnd12Subs,CurPE1MinLen,CurPE2MinLen,CurSEMinLen,CurMinReqPEPrimOverlap,CurMinReqPESecOverlap,CurMinReqPESumOverlap,CurMinReqSEPrimOverlap,CurMinPEMergeOverlap,MinPE2SEOvlp,m_MinReqPESepDist,m_MaxReqPESepDist,TrimPE2SE);
 		if(Rslt < eBSFSuccess)
 			return((teBSFrsltCodes)Rslt);
 
+		if((Rslt=RetainRdsSfx(true,AllowedSubsKbp == 0 && AllowedEnd12Subs == 0 ? 1 : 4, 2)) < eBSFSuccess)
+			return((teBSFrsltCodes)Rslt);
+
 		gDiagnostics.DiagOut(eDLInfo,gszProcName,"AssembReads: Reverse complementing sequences back to original sense ...");
 
 		// reverse complement all sequences including PE's back to their original sense
@@ -503,10 +523,538 @@ while(m_Sequences.NumSeqs2Assemb) {
 	MergedPercentage = 100.0;
 	bNewThres = true;
 	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"AssembReads: Read suffix index %s %u times over %d passes, total %1.3f secs generating and retaining",
+								m_SfxIndexMode == eSfxIdxFull ? "fully regenerated" : m_SfxIndexMode == eSfxIdxIncrVerify ? "incrementally generated and verified" : "incrementally generated",
+								m_NumSfxIndexGens,CurPass,m_SfxIndexSecs);
 return((teBSFrsltCodes)Rslt);
 }
 
 
+// NumSfxSeqWrds
+// returns number of SeqWrds, starting from the 1st, which GenRdsSfx would index in a sequence
+int
+CdeNovoAssemb::NumSfxSeqWrds(tSeqWrd4 *pSeqWrd,	// pts to 1st SeqWrd of sequence
+					  UINT32 SeqLen,		// sequence length
+					  int FirstNSeqWrds,	// index at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds) // excluding this many last SeqWrds
+{
+int NumSeqWrds;
+int MaxSeqWrds;
+
+MaxSeqWrds = FirstNSeqWrds;
+if(ExcludeLastNSeqWrds)
+	{
+	NumSeqWrds = (SeqLen + 14) / 15;		// number of sequence words including any partial final SeqWrd4
+	NumSeqWrds = NumSeqWrds > ExcludeLastNSeqWrds ? NumSeqWrds - ExcludeLastNSeqWrds : 1;
+	if(NumSeqWrds < MaxSeqWrds)
+		MaxSeqWrds = NumSeqWrds;
+	}
+for(NumSeqWrds = 0; NumSeqWrds < MaxSeqWrds; NumSeqWrds++)	// a partial final SeqWrd is flagged and never indexed
+	if(*pSeqWrd++ & cSeqWrd4LSWHdr)
+		break;
+return(NumSeqWrds);
+}
+
+// ResetRetainedSfx
+// release any retained suffix indexes and sequence identifier remapping
+void
+CdeNovoAssemb::ResetRetainedSfx(void)
+{
+int Idx;
+tsRetainedSfx *pRetained;
+
+pRetained = m_RetainedSfx;
+for(Idx = 0; Idx < 2; Idx++,pRetained++)
+	{
+	if(pRetained->pEls != NULL)
+		{
+#ifdef _WIN32
+		free(pRetained->pEls);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
+#else
+		if(pRetained->pEls != MAP_FAILED)
+			munmap(pRetained->pEls,pRetained->AllocdSize);
+#endif
+		}
+	memset(pRetained,0,sizeof(tsRetainedSfx));
+	}
+
+if(m_pSfxRemapSeqIDs != NULL)
+	{
+#ifdef _WIN32
+	free(m_pSfxRemapSeqIDs);
+#else
+	if(m_pSfxRemapSeqIDs != MAP_FAILED)
+		munmap(m_pSfxRemapSeqIDs,m_AllocdSfxRemapSize);
+#endif
+	m_pSfxRemapSeqIDs = NULL;
+	}
+m_AllocdSfxRemapSize = 0;
+m_SfxRemapLayoutGen = 0;
+m_SfxRemapNumSeqs = 0;
+m_SfxLayoutGen = 1;
+m_NumSfxIndexGens = 0;
+m_SfxIndexSecs = 0.0;
+}
+
+// SetSfxIndexMode
+// set how the read suffix index is generated for each assembly pass; a full regeneration for each pass, or verifying each incremental
+// generation against a full regeneration, is only intended for benchmarking and checking the incrementally maintained index
+void
+CdeNovoAssemb::SetSfxIndexMode(etSfxIndexMode SfxIndexMode)	// set how read suffix index is generated for each assembly pass
+{
+m_SfxIndexMode = SfxIndexMode;
+}
+
+// RetainRdsSfx
+// retain the current suffix index with elements recorded as sequence identifier plus SeqWrd index within that sequence
+// so that, after sequences have been repacked, the index over sequences which were not merged can be remapped instead of being resorted
+teBSFrsltCodes
+CdeNovoAssemb::RetainRdsSfx(bool bAntisense,	// retaining index over antisense (revcpl'd) sequences
+					  int FirstNSeqWrds,	// index was generated over at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds) // excluding this many last SeqWrds
+{
+tsRetainedSfx *pRetained;
+size_t ReqAllocSize;
+UINT64 ElIdx;
+UINT64 SfxOfs;
+tSeqID SeqID;
+tSeqWrd4 *pSeqWrds;
+tSeqWrd4 *pSfxWrd;
+tSeqWrd4 *pSeqStart;
+UINT8 *pSfxEl;
+UINT8 *pEl;
+unsigned long Secs;
+unsigned long USecs;
+CStopWatch RetainTimer;
+
+pRetained = &m_RetainedSfx[bAntisense ? 1 : 0];
+pRetained->LayoutGen = 0;
+pRetained->NumEls = 0;
+if(FirstNSeqWrds == 1)
+	ExcludeLastNSeqWrds = 0;
+if(m_SfxIndexMode == eSfxIdxFull ||		// nothing retained if fully regenerating the index for each pass
+	FirstNSeqWrds < 1 || FirstNSeqWrds > cMaxRetainedSfxSeqWrds || m_Sequences.pSuffixArray == NULL || m_Sequences.NumSuffixEls == 0)
+	return(eBSFSuccess);			// nothing retained, index will be fully regenerated in the next pass
+
+RetainTimer.Start();
+ReqAllocSize = (size_t)(m_Sequences.NumSuffixEls * 5);
+if(pRetained->pEls != NULL && (pRetained->AllocdSize < ReqAllocSize || ((pRetained->AllocdSize * 10) > (ReqAllocSize * 12))))
+	{
+#ifdef _WIN32
+	free(pRetained->pEls);
+#else
+	if(pRetained->pEls != MAP_FAILED)
+		munmap(pRetained->pEls,pRetained->AllocdSize);
+#endif
+	pRetained->pEls = NULL;
+	pRetained->AllocdSize = 0;
+	}
+
+if(pRetained->pEls == NULL)
+	{
+#ifdef _WIN32
+	pRetained->pEls = (UINT8 *)malloc(ReqAllocSize);
+#else
+	if((pRetained->pEls = (UINT8 *)mmap(NULL,ReqAllocSize, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0)) == MAP_FAILED)
+		pRetained->pEls = NULL;
+#endif
+	if(pRetained->pEls == NULL)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"RetainRdsSfx: Unable to allocate %llu bytes for retaining suffix index, index will be regenerated",(UINT64)ReqAllocSize);
+		return(eBSFSuccess);
+		}
+	pRetained->AllocdSize = ReqAllocSize;
+	}
+
+pSeqWrds = (tSeqWrd4 *)m_Sequences.pSeqs2Assemb;
+pSfxEl = (UINT8 *)m_Sequences.pSuffixArray;
+pEl = pRetained->pEls;
+for(ElIdx = 0; ElIdx < m_Sequences.NumSuffixEls; ElIdx++)
+	{
+	if(m_Sequences.SfxElSize == 5)
+		{
+		SfxOfs = Unpack5(pSfxEl);
+		pSfxEl += 5;
+		}
+	else
+		{
+		SfxOfs = *(UINT32 *)pSfxEl;
+		pSfxEl += sizeof(UINT32);
+		}
+	pSfxWrd = &pSeqWrds[SfxOfs];
+	pSeqStart = GetSeqHeader(pSfxWrd,&SeqID);
+	pEl = Pack5(((UINT64)SeqID << 2) | (UINT64)(pSfxWrd - pSeqStart),pEl);
+	}
+pRetained->FirstNSeqWrds = FirstNSeqWrds;
+pRetained->ExcludeLastNSeqWrds = ExcludeLastNSeqWrds;
+pRetained->NumSeqs = m_Sequences.NumSeqs2Assemb;
+pRetained->NumEls = m_Sequences.NumSuffixEls;
+pRetained->LayoutGen = m_SfxLayoutGen;
+RetainTimer.Stop();
+Secs = RetainTimer.ReadUSecs(&USecs);
+m_SfxIndexSecs += (double)Secs + (double)USecs / 1000000.0;
+return(eBSFSuccess);
+}
+
+// GenRdsSfxIncr
+// generate sparse suffix index over current sequences by remapping the index retained from the previous pass through the sequence identifier remapping
+// generated by CombinePartialsWithUnmerged; only suffixes of sequences which were merged, extended or trimmed are sorted and these are then merged
+// with the retained suffixes. Retained suffixes are still in sort order as suffixes are compared only over their own sequence content.
+// Falls back to GenRdsSfx() if there is no usable retained index or most sequences have changed
+// NOTE: requires that sequence starts have been generated for the current sequences
+teBSFrsltCodes
+CdeNovoAssemb::GenRdsSfxIncr(bool bAntisense,	// generating index over antisense (revcpl'd) sequences
+					  int FirstNSeqWrds,	// index at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds) // excluding this many last SeqWrds
+{
+teBSFrsltCodes Rslt;
+tsRetainedSfx *pRetained;
+bool bIdentity;
+bool bRemap;
+bool bRetained;
+tSeqID SeqID;
+tSeqID OldSeqID;
+UINT32 RemapIdx;
+UINT32 SeqLen;
+int NumEls;
+int ElIdx;
+int ElSize;
+UINT64 NumSurvivorEls;
+UINT64 NumDeltaEls;
+UINT64 NumDeltaSeqs;
+UINT64 TotEls;
+UINT64 MaxSuffixEls;
+UINT64 SeqStartOfs;
+UINT64 WrIdx;
+UINT64 RetIdx;
+UINT64 SurvIdx;
+UINT64 DeltaIdx;
+UINT64 SurvOfs;
+UINT64 DeltaOfs;
+UINT64 El;
+bool bHaveSurv;
+tSeqWrd4 *pSeqWrds;
+tSeqWrd4 *pSeqStart;
+UINT8 *pArr5;
+UINT32 *pArr4;
+UINT8 *pEl;
+
+pRetained = &m_RetainedSfx[bAntisense ? 1 : 0];
+if(FirstNSeqWrds == 1)
+	ExcludeLastNSeqWrds = 0;
+
+bIdentity = false;
+bRemap = false;
+if(FirstNSeqWrds >= 1 && FirstNSeqWrds <= cMaxRetainedSfxSeqWrds && pRetained->LayoutGen != 0 && pRetained->pEls != NULL &&
+	pRetained->FirstNSeqWrds == FirstNSeqWrds && pRetained->ExcludeLastNSeqWrds == ExcludeLastNSeqWrds &&
+	m_Sequences.pSeqStarts != NULL && m_Sequences.NumSeqStarts == m_Sequences.NumSeqs2Assemb)
+	{
+	if(pRetained->LayoutGen == m_SfxLayoutGen && pRetained->NumSeqs == m_Sequences.NumSeqs2Assemb)
+		bIdentity = true;				// sequences not repacked since index was retained
+	else
+		if(pRetained->LayoutGen == m_SfxRemapLayoutGen && m_pSfxRemapSeqIDs != NULL && pRetained->NumSeqs == m_SfxRemapNumSeqs)
+			bRemap = true;
+	}
+if(!bIdentity && !bRemap)
+	return(GenRdsSfx(FirstNSeqWrds,ExcludeLastNSeqWrds));
+
+gDiagnostics.DiagOut(eDLDiag,gszProcName,"GenRdsSfxIncr: Remapping retained suffix array");
+
+// determine number of retained and new suffix elements
+// remapping is monotonic, retained sequences have new identifiers in the same order as their previous identifiers
+pSeqWrds = (tSeqWrd4 *)m_Sequences.pSeqs2Assemb;
+NumSurvivorEls = 0;
+NumDeltaEls = 0;
+NumDeltaSeqs = 0;
+RemapIdx = 0;
+for(SeqID = 1; SeqID <= m_Sequences.NumSeqs2Assemb; SeqID++)
+	{
+	if((pSeqStart = GetSeqHeader(SeqID,NULL,NULL,&SeqLen,false)) == NULL)
+		return(GenRdsSfx(FirstNSeqWrds,ExcludeLastNSeqWrds));
+	NumEls = NumSfxSeqWrds(pSeqStart,SeqLen,FirstNSeqWrds,ExcludeLastNSeqWrds);
+	bRetained = bIdentity;
+	if(bRemap)
+		{
+		while(RemapIdx < m_SfxRemapNumSeqs && m_pSfxRemapSeqIDs[RemapIdx] == 0)
+			RemapIdx++;
+		if(RemapIdx < m_SfxRemapNumSeqs && m_pSfxRemapSeqIDs[RemapIdx] == SeqID)
+			{
+			bRetained = true;
+			RemapIdx++;
+			}
+		}
+	if(bRetained)
+		NumSurvivorEls += NumEls;
+	else
+		{
+		NumDeltaEls += NumEls;
+		NumDeltaSeqs += 1;
+		}
+	}
+
+// if most suffixes are new then simply regenerate
+if((NumDeltaEls * 4) > ((NumSurvivorEls + NumDeltaEls) * 3))
+	{
+	gDiagnostics.DiagOut(eDLDiag,gszProcName,"GenRdsSfxIncr: %llu of %llu suffix elements are new, regenerating",NumDeltaEls,NumSurvivorEls + NumDeltaEls);
+	return(GenRdsSfx(FirstNSeqWrds,ExcludeLastNSeqWrds));
+	}
+
+TotEls = NumSurvivorEls + NumDeltaEls;
+MaxSuffixEls = TotEls + 16;					// allow for a small safety factor
+ElSize = sizeof(UINT32);					// assume can use 4byte suffix elements
+if(MaxSuffixEls > cMaxSfxBlkEls ||			// but if number of sfx elements > ~4G 
+	m_Sequences.Seqs2AssembOfs > cMaxSfxBlkEls)	// or tBaseWrds range is ~ 32bits 
+	ElSize += 1;							// then need to use 5 byte elements
+
+if((Rslt = AllocSfxMem(MaxSuffixEls * (UINT64)ElSize)) != eBSFSuccess)
+	return(Rslt);
+m_Sequences.SfxElSize = ElSize;
+pArr5 = (UINT8 *)m_Sequences.pSuffixArray;
+pArr4 = (UINT32 *)m_Sequences.pSuffixArray;
+
+// new suffix elements are placed after where the retained elements will be merged into
+WrIdx = NumSurvivorEls;
+RemapIdx = 0;
+for(SeqID = 1; !bIdentity && SeqID <= m_Sequences.NumSeqs2Assemb; SeqID++)
+	{
+	pSeqStart = GetSeqHeader(SeqID,NULL,NULL,&SeqLen,false);
+	while(RemapIdx < m_SfxRemapNumSeqs && m_pSfxRemapSeqIDs[RemapIdx] == 0)
+		RemapIdx++;
+	if(RemapIdx < m_SfxRemapNumSeqs && m_pSfxRemapSeqIDs[RemapIdx] == SeqID)
+		{
+		RemapIdx++;
+		continue;
+		}
+	NumEls = NumSfxSeqWrds(pSeqStart,SeqLen,FirstNSeqWrds,ExcludeLastNSeqWrds);
+	SeqStartOfs = (UINT64)(pSeqStart - pSeqWrds);
+	for(ElIdx = 0; ElIdx < NumEls; ElIdx++,WrIdx++)
+		{
+		if(ElSize == 5)
+			Pack5(SeqStartOfs + ElIdx,&pArr5[WrIdx * 5]);
+		else
+			pArr4[WrIdx] = (UINT32)(SeqStartOfs + ElIdx);
+		}
+	}
+
+gDiagnostics.DiagOut(eDLDiag,gszProcName,"GenRdsSfxIncr: Now sorting %llu suffix elements from %llu new sequences...",NumDeltaEls,NumDeltaSeqs);
+SortSfxEls(&pArr5[NumSurvivorEls * ElSize],NumDeltaEls,ElSize);
+
+// merge retained with new elements, writes are always at or before the next new element to be read
+pEl = pRetained->pEls;
+RetIdx = 0;
+SurvIdx = 0;
+DeltaIdx = 0;
+SurvOfs = 0;
+DeltaOfs = 0;
+bHaveSurv = false;
+while(1)
+	{
+	while(!bHaveSurv && RetIdx < pRetained->NumEls)
+		{
+		El = Unpack5(pEl);
+		pEl += 5;
+		RetIdx++;
+		OldSeqID = (tSeqID)(El >> 2);
+		if(bIdentity)
+			SeqID = OldSeqID;
+		else
+			SeqID = (OldSeqID >= 1 && OldSeqID <= m_SfxRemapNumSeqs) ? m_pSfxRemapSeqIDs[OldSeqID - 1] : 0;
+		if(SeqID == 0)					// sequence was merged, extended or trimmed
+			continue;
+		if((pSeqStart = GetSeqHeader(SeqID)) == NULL)
+			break;
+		SurvOfs = (UINT64)(pSeqStart - pSeqWrds) + (El & 0x03);
+		bHaveSurv = true;
+		}
+	if(bHaveSurv && SurvIdx == NumSurvivorEls)	// more retained than expected, would overwrite new elements yet to be merged
+		break;
+	if(!bHaveSurv && (RetIdx < pRetained->NumEls || DeltaIdx == NumDeltaEls))
+		break;
+	if(DeltaIdx < NumDeltaEls)
+		DeltaOfs = ElSize == 5 ? Unpack5(&pArr5[(NumSurvivorEls + DeltaIdx) * 5]) : pArr4[NumSurvivorEls + DeltaIdx];
+	if(bHaveSurv && (DeltaIdx == NumDeltaEls || CmpPackedSeqs(&pSeqWrds[SurvOfs],&pSeqWrds[DeltaOfs],cMaxSortSfxLen) <= 0))
+		{
+		El = SurvOfs;
+		SurvIdx++;
+		bHaveSurv = false;
+		}
+	else
+		{
+		El = DeltaOfs;
+		DeltaIdx++;
+		}
+	WrIdx = SurvIdx + DeltaIdx - 1;
+	if(ElSize == 5)
+		Pack5(El,&pArr5[WrIdx * 5]);
+	else
+		pArr4[WrIdx] = (UINT32)El;
+	}
+
+if(bHaveSurv || RetIdx != pRetained->NumEls || SurvIdx != NumSurvivorEls || DeltaIdx != NumDeltaEls)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"GenRdsSfxIncr: Retained suffix array inconsistent with current sequences, regenerating");
+	return(GenRdsSfx(FirstNSeqWrds,ExcludeLastNSeqWrds));
+	}
+
+if(ElSize == 5)
+	Pack5(0xffffffffff,&pArr5[TotEls * 5]);
+else
+	pArr4[TotEls] = 0xffffffff;
+m_Sequences.NumSuffixEls = TotEls;
+gDiagnostics.DiagOut(eDLDiag,gszProcName,"GenRdsSfxIncr: Sparse suffix array contains %lld index elements size %d bytes, %lld retained from previous pass",m_Sequences.NumSuffixEls,ElSize,NumSurvivorEls);
+return(eBSFSuccess);
+}
+
+// GenPassRdsSfx
+// generate sparse suffix index for an assembly pass, incrementally or by full regeneration as requested by m_SfxIndexMode, accumulating the time taken
+// if verifying then the incrementally generated index is replaced by a full regeneration after checking both are identical
+teBSFrsltCodes
+CdeNovoAssemb::GenPassRdsSfx(bool bAntisense,	// generating pass index over antisense (revcpl'd) sequences
+					  int FirstNSeqWrds,	// index at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds) // excluding this many last SeqWrds
+{
+teBSFrsltCodes Rslt;
+unsigned long Secs;
+unsigned long USecs;
+double GenSecs;
+CStopWatch GenTimer;
+
+GenTimer.Start();
+if(m_SfxIndexMode == eSfxIdxFull)
+	Rslt = GenRdsSfx(FirstNSeqWrds,ExcludeLastNSeqWrds);
+else
+	Rslt = GenRdsSfxIncr(bAntisense,FirstNSeqWrds,ExcludeLastNSeqWrds);
+GenTimer.Stop();
+if(Rslt < eBSFSuccess)
+	return(Rslt);
+Secs = GenTimer.ReadUSecs(&USecs);
+GenSecs = (double)Secs + (double)USecs / 1000000.0;
+m_SfxIndexSecs += GenSecs;
+m_NumSfxIndexGens += 1;
+gDiagnostics.DiagOut(eDLDiag,gszProcName,"GenPassRdsSfx: %s index over %lld elements generated in %1.3f secs",bAntisense ? "Antisense" : "Sense",m_Sequences.NumSuffixEls,GenSecs);
+
+if(m_SfxIndexMode == eSfxIdxIncrVerify)
+	Rslt = VerifyRdsSfxIncr(FirstNSeqWrds,ExcludeLastNSeqWrds);
+return(Rslt);
+}
+
+int			// orders UINT32 suffix elements by sequence offset
+CdeNovoAssemb::SfxElOfsCmp4(const void *arg1, const void *arg2)
+{
+UINT32 Ofs1 = *(UINT32 *)arg1;
+UINT32 Ofs2 = *(UINT32 *)arg2;
+if(Ofs1 < Ofs2)
+	return(-1);
+return(Ofs1 > Ofs2 ? 1 : 0);
+}
+
+int			// orders 5byte suffix elements by sequence offset
+CdeNovoAssemb::SfxElOfsCmp5(const void *arg1, const void *arg2)
+{
+UINT64 Ofs1 = Unpack5((UINT8 *)arg1);
+UINT64 Ofs2 = Unpack5((UINT8 *)arg2);
+if(Ofs1 < Ofs2)
+	return(-1);
+return(Ofs1 > Ofs2 ? 1 : 0);
+}
+
+// VerifyRdsSfxIncr
+// verify the incrementally generated suffix index against a full regeneration over the same sequences, the full regeneration replaces the incremental index
+// suffixes comparing equal over cMaxSortSfxLen are in no defined order relative to each other with either generation, so each run of equal suffixes is
+// compared as the set of sequence offsets in that run; any other difference is an error
+teBSFrsltCodes
+CdeNovoAssemb::VerifyRdsSfxIncr(int FirstNSeqWrds,	// verify incrementally generated index, over at most this many initial SeqWrds, against a full regeneration
+					  int ExcludeLastNSeqWrds) // excluding this many last SeqWrds
+{
+teBSFrsltCodes Rslt;
+size_t ReqAllocSize;
+int IncrElSize;
+int FullElSize;
+UINT64 NumIncrEls;
+UINT64 NumRuns;
+UINT64 MaxRunLen;
+UINT64 RunStart;
+UINT64 RunEnd;
+UINT64 Idx;
+UINT64 IncrOfs;
+UINT64 FullOfs;
+UINT64 RunOfs;
+UINT8 *pIncrEls;
+UINT8 *pFullEls;
+tSeqWrd4 *pSeqWrds;
+
+IncrElSize = m_Sequences.SfxElSize;
+NumIncrEls = m_Sequences.NumSuffixEls;
+ReqAllocSize = (size_t)(NumIncrEls + 1) * IncrElSize;
+#ifdef _WIN32
+pIncrEls = (UINT8 *)malloc(ReqAllocSize);
+#else
+if((pIncrEls = (UINT8 *)mmap(NULL,ReqAllocSize, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0)) == MAP_FAILED)
+	pIncrEls = NULL;
+#endif
+if(pIncrEls == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"VerifyRdsSfxIncr: Unable to allocate %llu bytes for copy of incrementally generated suffix index",(UINT64)ReqAllocSize);
+	return(eBSFerrMem);
+	}
+memcpy(pIncrEls,m_Sequences.pSuffixArray,ReqAllocSize);
+
+Rslt = GenRdsSfx(FirstNSeqWrds,ExcludeLastNSeqWrds);
+if(Rslt >= eBSFSuccess && m_Sequences.NumSuffixEls != NumIncrEls)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"VerifyRdsSfxIncr: Incremental index contains %lld elements, full regeneration contains %lld",NumIncrEls,m_Sequences.NumSuffixEls);
+	Rslt = eBSFerrInternal;
+	}
+
+pSeqWrds = (tSeqWrd4 *)m_Sequences.pSeqs2Assemb;
+pFullEls = (UINT8 *)m_Sequences.pSuffixArray;
+FullElSize = m_Sequences.SfxElSize;
+NumRuns = 0;
+MaxRunLen = 0;
+for(RunStart = 0; Rslt >= eBSFSuccess && RunStart < NumIncrEls; RunStart = RunEnd)
+	{
+	// locate run of suffixes which compare equal to the first suffix of this run in the full regeneration
+	RunOfs = FullElSize == 5 ? Unpack5(&pFullEls[RunStart * 5]) : *(UINT32 *)&pFullEls[RunStart * 4];
+	for(RunEnd = RunStart + 1; RunEnd < NumIncrEls; RunEnd++)
+		{
+		FullOfs = FullElSize == 5 ? Unpack5(&pFullEls[RunEnd * 5]) : *(UINT32 *)&pFullEls[RunEnd * 4];
+		if(CmpPackedSeqs(&pSeqWrds[RunOfs],&pSeqWrds[FullOfs],cMaxSortSfxLen) != 0)
+			break;
+		}
+	NumRuns += 1;
+	if((RunEnd - RunStart) > MaxRunLen)
+		MaxRunLen = RunEnd - RunStart;
+
+	// order both runs by sequence offset so they can be compared as sets
+	if((RunEnd - RunStart) > 1)
+		{
+		qsort(&pFullEls[RunStart * FullElSize],(size_t)(RunEnd - RunStart),FullElSize,FullElSize == 5 ? SfxElOfsCmp5 : SfxElOfsCmp4);
+		qsort(&pIncrEls[RunStart * IncrElSize],(size_t)(RunEnd - RunStart),IncrElSize,IncrElSize == 5 ? SfxElOfsCmp5 : SfxElOfsCmp4);
+		}
+	for(Idx = RunStart; Idx < RunEnd; Idx++)
+		{
+		FullOfs = FullElSize == 5 ? Unpack5(&pFullEls[Idx * 5]) : *(UINT32 *)&pFullEls[Idx * 4];
+		IncrOfs = IncrElSize == 5 ? Unpack5(&pIncrEls[Idx * 5]) : *(UINT32 *)&pIncrEls[Idx * 4];
+		if(IncrOfs != FullOfs)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"VerifyRdsSfxIncr: Incremental index differs from full regeneration at element %lld, offset %lld instead of %lld",Idx,IncrOfs,FullOfs);
+			Rslt = eBSFerrInternal;
+			break;
+			}
+		}
+	}
+
+#ifdef _WIN32
+free(pIncrEls);
+#else
+munmap(pIncrEls,ReqAllocSize);
+#endif
+if(Rslt >= eBSFSuccess)
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"VerifyRdsSfxIncr: Incremental index over %lld elements identical to full regeneration, %lld runs of equal suffixes (longest %lld)",NumIncrEls,NumRuns,MaxRunLen);
+return(Rslt);
+}
+
+
 // PEs (PE1, PE2) can be converted to be processed as if two separate SE sequences if:
 // a) MinPETotSeqLen2SE is > 0 and
 //	a1) PE1 or PE2 length > 3/5ths of MinPETotSeqLen2SE
@@ -554,10 +1102,55 @@ tSeqWrd4 *pTrimSeqWrd;
 
 INT64 PartialSeqsLen;
 
+UINT32 NumMergedPartials;
+UINT32 NumUnmerged;
+UINT32 *pUnmergedSeqIDs;
+size_t ReqRemapSize;
+
 // if at least one partial then need to iterate over all sequences and add those which have not been flagged as (cFlgAsmbSeed | cFlgAsmbExtn | cFlgAsmbCplt) to
 // the partial sequences ready for the next merge pass
 if(m_NumPartialSeqs2Assemb)	// almost certainly there will be at least one but better check!
 	{
+	// sequences not merged are copied back unchanged with new identifiers, record the mapping so that suffix elements over these can be retained into the next pass
+	// the remap array is followed by a list of the unmerged sequence identifiers in the order in which these are added to the partials
+	m_SfxLayoutGen += 1;
+	m_SfxRemapLayoutGen = 0;
+	m_SfxRemapNumSeqs = m_Sequences.NumSeqs2Assemb;
+	ReqRemapSize = sizeof(UINT32) * 2 * ((size_t)m_Sequences.NumSeqs2Assemb + 1);
+	if(m_pSfxRemapSeqIDs != NULL && m_AllocdSfxRemapSize < ReqRemapSize)
+		{
+#ifdef _WIN32
+		free(m_pSfxRemapSeqIDs);
+#else
+		if(m_pSfxRemapSeqIDs != MAP_FAILED)
+			munmap(m_pSfxRemapSeqIDs,m_AllocdSfxRemapSize);
+#endif
+		m_pSfxRemapSeqIDs = NULL;
+		m_AllocdSfxRemapSize = 0;
+		}
+	if(m_pSfxRemapSeqIDs == NULL)
+		{
+#ifdef _WIN32
+		m_pSfxRemapSeqIDs = (UINT32 *)malloc(ReqRemapSize);
+#else
+		if((m_pSfxRemapSeqIDs = (UINT32 *)mmap(NULL,ReqRemapSize, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0)) == MAP_FAILED)
+			m_pSfxRemapSeqIDs = NULL;
+#endif
+		if(m_pSfxRemapSeqIDs != NULL)
+			m_AllocdSfxRemapSize = ReqRemapSize;
+		else
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"CombinePartialsWithUnmerged: Unable to allocate %llu bytes for remapping sequence identifiers, suffix index will be regenerated",(UINT64)ReqRemapSize);
+		}
+	if(m_pSfxRemapSeqIDs != NULL)
+		{
+		memset(m_pSfxRemapSeqIDs,0,(size_t)m_Sequences.NumSeqs2Assemb * sizeof(UINT32));
+		pUnmergedSeqIDs = &m_pSfxRemapSeqIDs[m_Sequences.NumSeqs2Assemb];
+		}
+	else
+		pUnmergedSeqIDs = NULL;
+	NumMergedPartials = m_NumPartialSeqs2Assemb;
+	NumUnmerged = 0;
+
 	// identify those sequences which were not merged and treat these as if merged so they will be retained for next pass
 	NumSEs = 0;
 	NumPEs = 0;
@@ -593,6 +1186,12 @@ if(m_NumPartialSeqs2Assemb)	// almost certainly there will be at least one but b
 		// add to partials ready for next merge pass
 		if((PartialSeqsLen = SavePartialSeqs(PE1SeqLen,pPE1SeqWrd,PE2SeqLen,pPE2SeqWrd)) < (INT64)0)
 			return((int)PartialSeqsLen);
+		if(pUnmergedSeqIDs != NULL)
+			{
+			if(pPE2SeqWrd != NULL)
+				pUnmergedSeqIDs[NumUnmerged++] = SeqID - 1;
+			pUnmergedSeqIDs[NumUnmerged++] = SeqID;
+			}
 		}
 
 	// all sequences to be retained for next pass are now in m_pPartialSeqs2Assemb, copy these back into m_Sequences.pSeqs2Assemb
@@ -695,6 +1294,10 @@ if(m_NumPartialSeqs2Assemb)	// almost certainly there will be at least one but b
 			m_Sequences.Seqs2AssembLen += TrimSeqLen;
 			m_Sequences.NumSeqs2Assemb += 1;
 
+			// if an unmerged sequence copied without any conversion or trimming then its suffix elements can be retained
+			if(pUnmergedSeqIDs != NULL && SeqID > NumMergedPartials && (SeqID - NumMergedPartials) <= NumUnmerged && CvtPEs2SE == 0 && !bTrim15bp)
+				m_pSfxRemapSeqIDs[pUnmergedSeqIDs[SeqID - NumMergedPartials - 1] - 1] = m_Sequences.NumSeqs2Assemb;
+
 			if((pPackSeq = (tSeqWrd4 *)SetSeqHeader(pPackSeq,m_Sequences.NumSeqs2Assemb,1,SeqFlags,TrimSeqLen,NULL))==NULL)
 				{
 				gDiagnostics.DiagOut(eDLFatal,gszProcName,"CombinePartialsWithUnmerged: SetSeqHeader() failed");
@@ -716,6 +1319,8 @@ if(m_NumPartialSeqs2Assemb)	// almost certainly there will be at least one but b
 		}
 	*pPackSeq = cSeqWrd4EOS;
 	// m_Sequences.pSeqs2Assemb now ready for next pass
+	if(pUnmergedSeqIDs != NULL)
+		m_SfxRemapLayoutGen = m_SfxLayoutGen - 1;
 
 	m_NumPartialSeqs2Assemb = 0;
 	m_LenPartialSeqs2Assemb = 0;
@@ -10,6 +10,7 @@
 const size_t cWorkThreadStackSize = (1024*1024*2);	// working threads (can be multiple) stack size
 const int cMaxPEExtndLen = ((cMinPETotSeqLen2SE * 3)/2);	// only allow PE extended length (sum of PE1 and PE2 lengths) to grow to this limit if no overlaps of PE1 onto PE2
 const int cMinErrSeedLen = 60;						// when allowing for substitutions then use this minimum seed length
+const int cMaxRetainedSfxSeqWrds = 4;				// suffix index retained between passes only if indexing at most this many initial SeqWrds of each sequence
 
 typedef enum TAG_edeNovoPMode {
 	eAMEAssemble,				// standard de Novo assemble
@@ -17,6 +18,12 @@ typedef enum TAG_edeNovoPMode {
 	eAMQAssemble				// quick assemble packed reads with low stringency
 } etdeNovoPMode;
 
+typedef enum TAG_eSfxIndexMode {
+	eSfxIdxIncr = 0,			// read suffix index incrementally maintained between passes (default)
+	eSfxIdxFull,				// read suffix index fully regenerated for each pass
+	eSfxIdxIncrVerify			// incrementally maintained and verified against a full regeneration for each pass
+} etSfxIndexMode;
+
 #pragma pack(1)
 
 typedef struct TAG_sSeqBlock {
@@ -26,6 +33,16 @@ typedef struct TAG_sSeqBlock {
 	tSeqID EndID;					// ending sequence identifier in this block
 	} tsSeqBlock;
 
+typedef struct TAG_sRetainedSfx {
+	int FirstNSeqWrds;				// suffix index was generated over at most this many initial SeqWrds of each sequence
+	int ExcludeLastNSeqWrds;		// and excluding this many last SeqWrds
+	UINT32 LayoutGen;				// sequence layout generation at which index was retained, 0 if nothing retained
+	UINT32 NumSeqs;					// number of sequences in that layout
+	UINT64 NumEls;					// number of retained suffix elements
+	size_t AllocdSize;				// pEls allocated to hold this many bytes
+	UINT8 *pEls;					// sorted suffix elements, each 5 bytes packed as (SeqID << 2) | SeqWrd index within that sequence
+	} tsRetainedSfx;
+
 typedef struct TAG_sThreadOverlapExtendPars {
 	int ThreadIdx;					// index of this thread (1..m_NumThreads)
 	void *pThis;					// will be initialised to pt to CKangadna instance
@@ -124,6 +141,42 @@ class CdeNovoAssemb : public CKangadna
 
 	bool m_bProcPE;						// true if assembly processing includes PE sequences, false if for SE or contigs only
 
+	UINT32 m_SfxLayoutGen;				// incremented each time sequences are repacked by CombinePartialsWithUnmerged
+	UINT32 m_SfxRemapLayoutGen;			// m_pSfxRemapSeqIDs maps sequence identifiers from this layout generation into the current layout
+	UINT32 m_SfxRemapNumSeqs;			// number of sequences in that layout generation
+	size_t m_AllocdSfxRemapSize;		// m_pSfxRemapSeqIDs was allocated to hold this many bytes
+	UINT32 *m_pSfxRemapSeqIDs;			// previous sequence identifiers mapped to current, 0 if sequence was merged, extended or trimmed; followed by scratch list of unmerged sequence identifiers
+	tsRetainedSfx m_RetainedSfx[2];		// suffix indexes retained from the previous pass over sense [0] and antisense [1] sequences
+
+	etSfxIndexMode m_SfxIndexMode;		// read suffix index incrementally maintained, fully regenerated, or incrementally maintained and verified
+	UINT32 m_NumSfxIndexGens;			// number of times read suffix index was generated by assembly passes
+	double m_SfxIndexSecs;				// total secs spent generating and retaining read suffix indexes by assembly passes
+
+	int NumSfxSeqWrds(tSeqWrd4 *pSeqWrd,	// pts to 1st SeqWrd of sequence
+					  UINT32 SeqLen,		// sequence length
+					  int FirstNSeqWrds,	// index at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds); // excluding this many last SeqWrds
+
+	void ResetRetainedSfx(void);			// release any retained suffix indexes and sequence identifier remapping
+
+	teBSFrsltCodes RetainRdsSfx(bool bAntisense,	// retaining index over antisense (revcpl'd) sequences
+					  int FirstNSeqWrds,	// index was generated over at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds); // excluding this many last SeqWrds
+
+	teBSFrsltCodes GenRdsSfxIncr(bool bAntisense,	// generating index over antisense (revcpl'd) sequences
+					  int FirstNSeqWrds,	// index at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds); // excluding this many last SeqWrds
+
+	teBSFrsltCodes GenPassRdsSfx(bool bAntisense,	// generating pass index over antisense (revcpl'd) sequences as requested by m_SfxIndexMode
+					  int FirstNSeqWrds,	// index at most this many initial SeqWrds
+					  int ExcludeLastNSeqWrds); // excluding this many last SeqWrds
+
+	teBSFrsltCodes VerifyRdsSfxIncr(int FirstNSeqWrds,	// verify incrementally generated index, over at most this many initial SeqWrds, against a full regeneration
+					  int ExcludeLastNSeqWrds); // excluding this many last SeqWrds
+
+	static int SfxElOfsCmp4(const void *arg1, const void *arg2);	// orders UINT32 suffix elements by sequence offset
+	static int SfxElOfsCmp5(const void *arg1, const void *arg2);	// orders 5byte suffix elements by sequence offset
+
 	int	// returns 0: no merges, 1: merge but no extension, 2: merge with extension
 		MergeOverlaps(tsThreadOverlapExtendPars *pPars);
 
@@ -157,6 +210,8 @@ public:
 	CdeNovoAssemb(void);
 	~CdeNovoAssemb(void);
 
+	void SetSfxIndexMode(etSfxIndexMode SfxIndexMode = eSfxIdxIncr);	// set how read suffix index is generated for each assembly pass
+
 	teBSFrsltCodes AssembReads(	etdeNovoPMode PMode,	  // processing mode, currently either eAMEAssemble (default), eAMESAssemble (stringent) or eAMQAssemble (quick)
 								int TrimInputEnds,		  // trim input sequences, both 5' and 3' ends by this many bases
 							    int MinInputSeqLen,		  // only accept for assembly sequences which are, after any trimming, of at least this length
@@ -80,6 +80,8 @@ Process(etPMode PMode,					// processing mode
 		char *pszMarkerFile,			// Output markers to this file
 		char *pszSNPCentroidFile,		// Output SNP centorids (CSV format) to this file (default is for no centroid processing)
 		char *pszSfxFile,				// target as suffix array
+		etSfxLoadMode SfxLoadMode,		// how the suffix array is to be loaded, private copy or memory mapped shared with other processes
+		UINT32 StreamBatchReads,		// if > 0 then SE reads are streamed through in batches of this many reads with alignments written out as each block completes
 		char *pszStatsFile,				// aligner induced substitutions stats file
 		char *pszMultiAlignFile,		// file to contain reads which are aligned to multiple locations
 		char *pszNoneAlignFile,			// file to contain reads which were non-alignable
@@ -149,6 +151,8 @@ bool bLocateBestMatches;			// instead of unique matches then return multiple bes
 char szTrackTitle[cMaxDatasetSpeciesChrom];		// track title if output format is UCSC BED
 char szRsltsFile[_MAX_PATH];			// results to this file
 char szTargFile[_MAX_PATH];				// align against this target suffix array genome file
+int SfxLoadMode;						// suffix array loading: 0 private copy, 1 memory mapped shared, 2 memory mapped shared and prefaulted
+int StreamBatchReads;					// if > 0 then SE reads are streamed through in batches of this many reads
 
 int NumPE1InputFiles;					// number of input PE1 or single ended file spe
 char *pszPE1InputFiles[cMaxInFileSpecs];		// names of input files (wildcards allowed unless processing paired ends) containing raw reads
@@ -223,6 +227,8 @@ struct arg_lit  *chimericrpt = arg_lit0("0","chimericrpt",     "report chimeric
 
 struct arg_int *qual = arg_int0("g","quality","<int>",		    "fastq quality scoring - 0 - Sanger or Illumina 1.8+, 1 = Illumina 1.3+, 2 = Solexa < 1.3, 3 = Ignore quality (default = 3)");
 struct arg_file *sfxfile = arg_file1("I","sfx","<file>",		"align against this suffix array (kangax generated) file");
+struct arg_int *sfxload = arg_int0(NULL,"sfxload","<int>",		"suffix array loading: 0 - private copy, 1 - memory mapped shared with other processes, 2 - memory mapped shared and prefaulted (default: 0)");
+struct arg_int *streamreads = arg_int0(NULL,"streamreads","<int>",	"stream SE reads in batches of this many reads, unsorted SAM written as reads align: 0 - load all reads, 100000 to 100000000 (default: 0)");
 struct arg_file *outfile = arg_file1("o","out","<file>",		"output alignments to this file");
 
 struct arg_int  *microindellen = arg_int0("a","microindellen","<int>", "accept microInDels inclusive of this length: 0 to 20 (default = 0 or no microIndels)");
@@ -289,7 +295,7 @@ void *argtable[] = {help,version,FileLogLevel,LogFile,
 					summrslts,experimentname,experimentdescr,
 					pmode,samplenthrawread,alignstrand,minchimericlen,chimericrpt,pecircularised,peinsertlendist,microindellen,splicejunctlen,solid,pcrartefactwinlen,qual,mlmode,trim5,trim3,minacceptreadlen,maxacceptreadlen,maxmlmatches,rptsamseqsthres,clampmaxmulti,bisulfite,
 					mineditdist,maxsubs,maxns,minflankexacts,pcrprimercorrect,minsnpreads,markerlen,markerpolythres,qvalue,snpnonrefpcnt,format,title,priorityregionfile,nofiltpriority,bestmatches,
-					pe1inputfiles,peproc,pairminlen,pairmaxlen,pairstrand,pe2inputfiles,sfxfile,snpfile,centroidfile,
+					pe1inputfiles,peproc,pairminlen,pairmaxlen,pairstrand,pe2inputfiles,sfxfile,sfxload,streamreads,snpfile,centroidfile,
 					outfile,nonealignfile,multialignfile,statsfile,siteprefsfile,siteprefsofs,lociconstraintsfile,contamsfile,ExcludeChroms,IncludeChroms,threads,
 					end};
 
@@ -840,6 +846,20 @@ if (!argerrors)
 		}
 
 	strcpy(szTargFile,sfxfile->filename[0]);
+
+	SfxLoadMode = sfxload->count ? sfxload->ival[0] : (int)eSfxLoadCopy;
+	if(SfxLoadMode < (int)eSfxLoadCopy || SfxLoadMode > (int)eSfxLoadMmapPopulate)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Suffix array loading mode '--sfxload=%d' must be in range %d..%d",SfxLoadMode,(int)eSfxLoadCopy,(int)eSfxLoadMmapPopulate);
+		exit(1);
+		}
+
+	StreamBatchReads = streamreads->count ? streamreads->ival[0] : 0;
+	if(StreamBatchReads != 0 && (StreamBatchReads < cMinStreamBatchReads || StreamBatchReads > cMaxStreamBatchReads))
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Streamed reads batch size '--streamreads=%d' must be 0 or in range %d..%d",StreamBatchReads,cMinStreamBatchReads,cMaxStreamBatchReads);
+		exit(1);
+		}
 	strcpy(szRsltsFile,outfile->filename[0]);
 
 	SAMFormat = etSAMFformat;
@@ -1256,6 +1276,21 @@ if (!argerrors)
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Output paired end sequence length distribution to file: '%s'",szStatsFile[0] == '\0' ? "none specified" : szStatsFile);
 		}
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"input target sequence(s) suffix array file: '%s'",szTargFile);
+	switch(SfxLoadMode) {
+		case eSfxLoadCopy:
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"suffix array loading: 'private copy'");
+			break;
+		case eSfxLoadMmap:
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"suffix array loading: 'memory mapped shared'");
+			break;
+		case eSfxLoadMmapPopulate:
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"suffix array loading: 'memory mapped shared and prefaulted'");
+			break;
+		}
+	if(StreamBatchReads > 0)
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"stream SE reads in batches of: %d",StreamBatchReads);
+	else
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"stream SE reads in batches of: 'No, all reads loaded'");
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"output results file: '%s'",szRsltsFile);
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Output none-aligned reads to fasta file: '%s'",szNoneAlignFile[0] == '\0' ? "none specified" : szNoneAlignFile);
@@ -1409,6 +1444,8 @@ if (!argerrors)
 
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szPriorityRegionFile),"priorityregionfile",szPriorityRegionFile);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szTargFile),"sfx",szTargFile);
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(SfxLoadMode),"sfxload",&SfxLoadMode);
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(StreamBatchReads),"streamreads",&StreamBatchReads);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szRsltsFile),"out",szRsltsFile);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szStatsFile),"stats",szStatsFile);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szNoneAlignFile),"nonealign",szNoneAlignFile);
@@ -1439,7 +1476,7 @@ if (!argerrors)
 					MaxMLmatches,bClampMaxMLmatches,bLocateBestMatches,
 					MaxNs,MinEditDist,MaxSubs,Trim5,Trim3,MinAcceptReadLen,MaxAcceptReadLen,MinFlankExacts,PCRPrimerCorrect, MaxRptSAMSeqsThres,
 					(etFMode)FMode,SAMFormat,SitePrefsOfs,NumThreads,szTrackTitle,
-					NumPE1InputFiles,pszPE1InputFiles,NumPE2InputFiles,pszPE2InputFiles,szPriorityRegionFile,bFiltPriorityRegions,szRsltsFile, szSNPFile, szMarkerFile, szSNPCentroidFile, szTargFile,
+					NumPE1InputFiles,pszPE1InputFiles,NumPE2InputFiles,pszPE2InputFiles,szPriorityRegionFile,bFiltPriorityRegions,szRsltsFile, szSNPFile, szMarkerFile, szSNPCentroidFile, szTargFile,(etSfxLoadMode)SfxLoadMode,(UINT32)StreamBatchReads,
 					szStatsFile,szMultiAlignFile,szNoneAlignFile,szSitePrefsFile,szLociConstraintsFile,szContamFile,NumIncludeChroms,pszIncludeChroms,NumExcludeChroms,pszExcludeChroms);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
@@ -1526,6 +1563,8 @@ Process(etPMode PMode,					// processing mode
 		char *pszMarkerFile,			// Output markers to this file
 		char *pszSNPCentroidFile,		// Output SNP centorids (CSV format) to this file (default is for no centroid processing)
 		char *pszSfxFile,				// target as suffix array
+		etSfxLoadMode SfxLoadMode,		// how the suffix array is to be loaded, private copy or memory mapped shared with other processes
+		UINT32 StreamBatchReads,		// if > 0 then SE reads are streamed through in batches of this many reads with alignments written out as each block completes
 		char *pszStatsFile,				// aligner induced substitutions stats file
 		char *pszMultiAlignFile,		// file to contain reads which are aligned to multiple locations
 		char *pszNoneAlignFile,			// file to contain reads which were non-alignable
@@ -1598,6 +1637,8 @@ Rslt = pAligner->Align(PMode,			// processing mode
 			pszMarkerFile,				// Output markers to this file
 			pszSNPCentroidFile,			// Output SNP centorids (CSV format) to this file (default is for no centroid processing)
 			pszSfxFile,					// target as suffix array
+			SfxLoadMode,				// how the suffix array is to be loaded, private copy or memory mapped shared with other processes
+			StreamBatchReads,			// if > 0 then SE reads are streamed through in batches of this many reads with alignments written out as each block completes
 			pszStatsFile,				// aligner induced substitutions stats file
 			pszMultiAlignFile,			// file to contain reads which are aligned to multiple locations
 			pszNoneAlignFile,			// file to contain reads which were non-alignable
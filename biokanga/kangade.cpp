@@ -63,6 +63,8 @@ const int cMaxAssumTransLen = 2000000;					// assume no transcribed region will
 const int cMaxAssumTransLoci = cMaxAssumTransLen/10;	// assume very long transcribed regions will be low abundance reads and number of unique read aligned loci will be at most 10% of cMaxAssumTransLen
 
 const int cMaxConfidenceIterations = 10000;	// max number of iterations when calculating confidence intervals and PValues
+const int cMinAdaptIterations = 500;		// if adaptive permutation stopping then always at least this many iterations, subsequent checks at doublings of this
+const double cAdaptMedianZ = 2.576;			// if adaptive permutation stopping then median confidence interval (99%) ranks are this many standard errors either side of median rank
 
 const int cMaxExclZones = 1000;			// max allowed number of exclusion zones within which reads are to be excluded
 
@@ -251,6 +253,8 @@ typedef struct TAG_ThreadInstData {
 	int NumFeatsProcessed;				// number features processed currently from Feats2Proc
 	int Feats2Proc[cMaxFeats2ProcAlloc];	// these are the feature identifiers for the features to be processed
 	CSimpleRNG *pSimpleRNG;				// random generator exclusively for use by this thread
+	UINT32 NumFeatsPermuted;			// number of features for which PValues and confidence intervals were permuted by this thread
+	UINT64 NumPerms;					// total number of permutations over all features permuted by this thread
 } tsThreadInstData;
 
 #pragma pack()
@@ -274,6 +278,7 @@ teBSFrsltCodes Process(etPMode PMode,					// processing mode
 					int ArtifactCntsThres,				// if counts at any loci are >= this threshold then process for PCR artifact reduction
 				    UINT32 LimitAligned,				// for test/evaluation can limit number of reads parsed to be no more than this number (0 for no limit)
 					bool bFiltNonaligned,				// true if only features having at least one read aligned are to be be reported
+					bool bAdaptPerms,					// true if permutations to be stopped early once feature confidence intervals are resolved
 					char AlignStrand,					// process for reads aligning to this strand only
 					char FeatStrand,					// process for genes or features on this strand only
 					etBEDRegion Region,					// process for this genomic region only
@@ -293,6 +298,8 @@ teBSFrsltCodes Process(etPMode PMode,					// processing mode
 					char *pszBinCountsFile);			// output bin counts to this file
 
 double ClampFoldChange(double Scale);
+etPearsonScore PearsonClass(double Pearson);	// characterise Pearson into 1 of 4 classes
+etCntsScore FoldChangeClass(double FoldChange);	// characterise fold change into 1 of 4 classes
 
 teBSFrsltCodes
 LoadGeneFeatures(char Strand,			// features on this strand
@@ -381,7 +388,9 @@ ChromToID(char *pszChrom, // get unique chromosome identifier for this chrom
 double	poz (double	z);						/* returns cumulative probability from -oo to z */
 
 static int SortAlignments(const void *arg1, const void *arg2);
-static int SortDoubles(const void *arg1, const void *arg2);
+static double SelectDouble(double *pValues,int Lo,int Hi,int Nth);
+static void SelectQuantiles(double *pValues,int NumValues,int NumRanks,int *pRanks,double *pQuantiles);
+static bool MediansResolved(tsThreadInstData *pThreadInst,int NumPerms);
 static int SortDEScore(const void *arg1, const void *arg2);
 static int SortFoldMedian(const void *arg1, const void *arg2);
 
@@ -410,6 +419,7 @@ int NumThreads;				// number of threads (0 defaults to number of CPUs)
 int FType;					// expected input element file type - auto, CSV, BED or SAM
 
 bool bFiltNonaligned;		// true if only features having at least one read aligned are to be be reported
+bool bAdaptPerms;			// true if permutations to be stopped early once feature confidence intervals are resolved
 int Region;			// process for this functional region only
 double NormCntsScale;		// counts normalisation scale factor
 int LimitAligned;			// for test/evaluation can limit number of reads parsed to be no more than this number (0 for no limit)
@@ -450,6 +460,7 @@ struct arg_file *LogFile = arg_file0("F","log","<file>",		"diagnostics log file"
 struct arg_int *pmode = arg_int0("m","mode","<int>",		    "processing sensitivity: 0 - standard sensitivity, 1 - more sensitive (slower), 2 - ultra sensitive (slowest), 3 - less sensitive (quicker) (default is 0)");
 struct arg_int *region = arg_int0("r","region","<int>",		    "process region: 0 - complete transcript, 1: Exons, 2: Introns, 3: CDSs, 4: UTRs, 5: 5'UTRs, 6: 3'UTRs (default 1 Exons)");
 struct arg_lit  *filtnonaligned = arg_lit0("A","nonalign",		"do not report on features which have no aligned reads");
+struct arg_lit  *adaptperms = arg_lit0("P","adaptperms",		"stop permuting a feature once its Pearson and fold change classifications are resolved (quicker)");
 
 struct arg_dbl *normcntsscale = arg_dbl0("n","normcnts","<dbl>",	"control counts normalisation scale factor 0.1 to 10.0 to scale expr counts, -0.1 to -10.0 to scale control (default is 0 for auto-library size normalisation)");
 
@@ -483,7 +494,7 @@ struct arg_end *end = arg_end(200);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
 					summrslts,experimentname,experimentdescr,
-					pmode,ftype,filtnonaligned,limitaligned,artifactcntthres,alignstrand,featstrand,region,normcntsscale,minfeatcntthres,minstartlocithres,cowinlen,
+					pmode,adaptperms,ftype,filtnonaligned,limitaligned,artifactcntthres,alignstrand,featstrand,region,normcntsscale,minfeatcntthres,minstartlocithres,cowinlen,
 					numbins,incontrolfiles,inexperfiles,outfile,bincountsfile,infeatfile,featclass,excludezones,threads,
 					end};
 
@@ -652,6 +663,7 @@ if (!argerrors)
 		}
 
 	bFiltNonaligned = filtnonaligned->count ? true : false;
+	bAdaptPerms = adaptperms->count ? true : false;
 
 	Region = (etBEDRegion)(region->count ? region->ival[0] : eMEGRExons);	// default as being exons
 	if(Region < eMEGRAny || Region > eMEG3UTR)
@@ -808,6 +820,7 @@ if (!argerrors)
 			break;
 		}
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Processing mode: '%s'",pszProcMode);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Stop permutations once feature classifications resolved: '%s'",bAdaptPerms ? "Yes" : "No");
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Report to include features to which no reads align: '%s'",bFiltNonaligned ? "No" : "Yes");
 
@@ -878,6 +891,7 @@ if (!argerrors)
 		int ParamID;
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szLogFile),"log",szLogFile);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(PMode),"mode",&PMode);
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTBool,sizeof(bAdaptPerms),"adaptperms",&bAdaptPerms);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTBool,sizeof(bFiltNonaligned),"nonalign",&bFiltNonaligned);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(LimitAligned),"limitaligned",&LimitAligned);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(AlignStrand),"alignstrand",&AlignStrand);
@@ -922,6 +936,7 @@ if (!argerrors)
 					ArtifactCntsThres,			// if counts at any loci are >= this then process for PCR artifact reduction
 					LimitAligned,				// for test/evaluation can limit number of reads parsed to be no more than this number (0 for no limit)
 					bFiltNonaligned,			// true if only features having at least one read aligned are to be be reported
+					bAdaptPerms,				// true if permutations to be stopped early once feature confidence intervals are resolved
 					ReportStrand((etStrandProc)AlignStrand),	// process for reads on this strand only
 					ReportStrand((etStrandProc)FeatStrand),	// process for genes or features on this strand only
 					(etBEDRegion)Region,						// which genomic region is to be processed
@@ -1021,6 +1036,7 @@ tsThreadInstData *m_pThreadsInstData;		// all allocated thread instance data
 etPMode m_DEPMode;					// processing mode
 etProcPhase m_ProcessingPhase;		// current processing phase
 bool m_bFiltNonaligned;				// true if only features having at least one read aligned are to be be reported
+bool m_bAdaptPerms;					// true if permutations to be stopped early once feature confidence intervals are resolved
 
 int m_NumExclZones;					// total number of read exclusion zones loaded
 int m_NumExclReads;					// total number of reads which were excluded because they overlaid an exclusion zone
@@ -1534,6 +1550,7 @@ if(m_bDEMutexesCreated)
 m_NumExclZones = 0;
 m_NumExclReads = 0;
 m_bFiltNonaligned = false;
+m_bAdaptPerms = false;
 m_NumChromsAllocd = 0;
 m_CurNumChroms = 0;
 m_MRAChromID = 0;
@@ -1827,7 +1844,14 @@ tsAlignBin *pAlignBins;
 tsAlignBin *pPoissonAlignBins;
 tsAlignLociInstStarts *pAlignLociInstStarts;
 UINT32 ThreadInst;
-
+UINT32 NumFeatsPermuted;
+UINT64 NumPerms;
+unsigned long ElapsedSecs;
+unsigned long ElapsedUSecs;
+double Elapsed;
+CStopWatch DEStopWatch;
+
+DEStopWatch.Start();
 m_NumFeatsDEd = 0;
 m_LastFeatureAllocProc = 0;
 m_NumFeaturesProcessed = 0;
@@ -1919,6 +1943,21 @@ for(ThreadInst = 1;ThreadInst <= (UINT32)m_NumDEThreads; ThreadInst++,pThreadIns
 	if(pThreadInst->Rslt != eBSFSuccess)
 		Rslt = pThreadInst->Rslt;
 	}
+DEStopWatch.Stop();
+
+// report permutation throughput
+NumFeatsPermuted = 0;
+NumPerms = 0;
+pThreadInst = m_pThreadsInstData;
+for(ThreadInst = 1;ThreadInst <= (UINT32)m_NumDEThreads; ThreadInst++,pThreadInst++)
+	{
+	NumFeatsPermuted += pThreadInst->NumFeatsPermuted;
+	NumPerms += pThreadInst->NumPerms;
+	}
+ElapsedSecs = DEStopWatch.ReadUSecs(&ElapsedUSecs);
+Elapsed = (double)ElapsedSecs + (ElapsedUSecs / 1000000.0);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Permuted %u features, mean of %1.1f permutations per feature, %1.1f features per second",
+					NumFeatsPermuted,NumFeatsPermuted ? (double)NumPerms/NumFeatsPermuted : 0.0,Elapsed > 0.0 ? NumFeatsPermuted/Elapsed : 0.0);
 
 return(Rslt);
 }
@@ -2078,6 +2117,7 @@ Process(etPMode PMode,									// processing mode
 					int ArtifactCntsThres,				// if counts at any loci are >= this threshold then process for PCR artifact reduction
 					UINT32 LimitAligned,				// for test/evaluation can limit number of reads parsed to be no more than this number (0 for no limit)
 					bool bFiltNonaligned,				// true if only features having at least one read aligned are to be be reported
+					bool bAdaptPerms,					// true if permutations to be stopped early once feature confidence intervals are resolved
 					char AlignStrand,					// process for reads on this strand only
 					char FeatStrand,					// process for genes or features on this strand only
 					etBEDRegion Region,					// process for this genomic region only
@@ -2106,6 +2146,7 @@ m_LibSizeNormExpToCtrl = NormCntsScale;
 m_NumBins = NumBins;
 m_LimitAligned = LimitAligned;
 m_bFiltNonaligned = bFiltNonaligned;
+m_bAdaptPerms = bAdaptPerms;
 m_CoWinLen = CoWinLen;
 m_MinFeatCntThres = MinFeatCntThres;
 m_MinStartLociThres = MinStartLociThres;
@@ -3719,7 +3760,7 @@ if(m_pCtrlAlignReadLoci == NULL)
 		return(eBSFerrMem);
 		}
 #endif
-	m_AllocdExprAlignReadsLoci = cAlignReadsLociInitalAlloc;
+	m_AllocdCtrlAlignReadsLoci = cAlignReadsLociInitalAlloc;
 	m_CurNumCtrlAlignReadsLoci = 0;
 	memset(m_pCtrlAlignReadLoci,0,sizeof(tsAlignReadLoci));
 	}
@@ -4305,9 +4346,69 @@ if(Scale >= cClampFoldChange)
 return(Scale);
 }
 
+// PearsonClass
+// Characterise the Pearson (-1.0 to 1.0) into 1 of 4 classes
+etPearsonScore
+PearsonClass(double Pearson)
+{
+if(Pearson >= cHiPearsonThres)
+	return(ePSHi);
+if(Pearson >= cModPearsonThes)
+	return(ePSMod);
+if(Pearson >= cLoPearsonThres)
+	return(ePSLow);
+return(ePSNone);
+}
+
+// FoldChangeClass
+// Characterise the fold change (0.0 to n.0) into 1 of 4 classes
+etCntsScore
+FoldChangeClass(double FoldChange)
+{
+double AbsFoldChange;
+if(FoldChange < 0.1)
+	return(eDEHi);
+AbsFoldChange = ClampFoldChange(FoldChange);
+if(AbsFoldChange < 1.0)
+	AbsFoldChange = 1.0 / AbsFoldChange;
+if(AbsFoldChange <= cNoFoldChange)
+	return(eDESNone);
+if(AbsFoldChange <= cLoFoldChange)
+	return(eDSElow);
+if(AbsFoldChange <= cModFoldChange)
+	return(eDESMod);
+return(eDEHi);
+}
+
+// MediansResolved
+// Returns true if confidence intervals for both the median Pearson and median fold change over the first NumPerms permutations are
+// each within a single class, so that further permutations would be most unlikely to change the feature classification
+// Confidence intervals are from the order statistic ranks either side of the median rank
+static bool
+MediansResolved(tsThreadInstData *pThreadInst,int NumPerms)
+{
+int Ranks[2];
+double Quantiles[2];
+double HalfWidth;
+
+HalfWidth = cAdaptMedianZ * sqrt((double)NumPerms) / 2.0;
+Ranks[0] = (int)(((NumPerms - 1) / 2.0) - HalfWidth);
+Ranks[1] = (int)ceil(((NumPerms - 1) / 2.0) + HalfWidth);
+if(Ranks[0] < 0)
+	Ranks[0] = 0;
+if(Ranks[1] >= NumPerms)
+	Ranks[1] = NumPerms - 1;
+
+SelectQuantiles(pThreadInst->pPearsons,NumPerms,2,Ranks,Quantiles);
+if(PearsonClass(Quantiles[0]) != PearsonClass(Quantiles[1]))
+	return(false);
+SelectQuantiles(pThreadInst->pFeatFoldChanges,NumPerms,2,Ranks,Quantiles);
+return(FoldChangeClass(Quantiles[0]) == FoldChangeClass(Quantiles[1]));
+}
 
 // Calculate a PValue for fold change through a counts permutation test
 // Independently poisson permutes counts for both control and experiment
+// If m_bAdaptPerms then permutations are stopped early once the feature classification is resolved (see MediansResolved)
 double								    // returned median PValue
 PearsonsPValue(tsThreadInstData *pThreadInst,	// thread instance
 		double Pearson,					// observed pearson
@@ -4325,6 +4426,8 @@ PearsonsPValue(tsThreadInstData *pThreadInst,	// thread instance
 int PermIter;
 int SrcIdx;
 int MaxNumPerms;
+int NumPerms;
+int NextCheckPerms;
 int Supportive;
 double *pPearson;
 double *pPValues;
@@ -4362,6 +4465,7 @@ UINT32 TotPoissonCtrlLibCnts = 0;
 UINT32 TotPoissonExprLibCnts = 0;
 
 Supportive = 0;
+NextCheckPerms = cMinAdaptIterations;
 pPearson = pThreadInst->pPearsons;
 pFeatFoldChanges = pThreadInst->pFeatFoldChanges;
 pPValues = pThreadInst->pPValues;
@@ -4418,40 +4522,52 @@ for(PermIter = 0; PermIter < MaxNumPerms; PermIter++,pPearson++,pFeatFoldChanges
 	*pPValues = pThreadInst->pStats->ChiSqr2PVal(1,ChiSqr);
 	if(*pPValues < 0.0)
 		*pPValues = 0.0;
-	}
 
-qsort(pThreadInst->pPearsons,MaxNumPerms,sizeof(double),SortDoubles);
-qsort(pThreadInst->pFeatFoldChanges,MaxNumPerms,sizeof(double),SortDoubles);
-qsort(pThreadInst->pPValues,MaxNumPerms,sizeof(double),SortDoubles);
+	if(m_bAdaptPerms && (PermIter + 1) == NextCheckPerms && NextCheckPerms < MaxNumPerms)
+		{
+		if(MediansResolved(pThreadInst,NextCheckPerms))
+			break;
+		NextCheckPerms *= 2;
+		}
+	}
+NumPerms = PermIter < MaxNumPerms ? PermIter + 1 : MaxNumPerms;
+pThreadInst->NumFeatsPermuted += 1;
+pThreadInst->NumPerms += NumPerms;
 
+// only the median and 95 percentiles are required so select these rather than sorting all permutations
+int NumRanks;
+int Ranks[4];
+double Quantiles[4];
 int LowerIdx;
 int UpperIdx;
-
-LowerIdx = (MaxNumPerms-1)/2;
-if(MaxNumPerms & 0x01)
-	*pMedian = pThreadInst->pPearsons[LowerIdx];
-else
-	*pMedian = (pThreadInst->pPearsons[LowerIdx] + pThreadInst->pPearsons[LowerIdx+1])/2.0;
-
-if(MaxNumPerms & 0x01)
-	PValue = pThreadInst->pPValues[LowerIdx];
-else
-	PValue = (pThreadInst->pPValues[LowerIdx] + pThreadInst->pPValues[LowerIdx+1])/2.0;
-
-if(MaxNumPerms & 0x01)
-	*pFeatMedian = m_pFeatFoldChanges[LowerIdx];
-else
-	*pFeatMedian = (pThreadInst->pFeatFoldChanges[LowerIdx] + pThreadInst->pFeatFoldChanges[LowerIdx+1])/2.0;
-
-LowerIdx = (MaxNumPerms * 5) / 200;
-UpperIdx = MaxNumPerms - LowerIdx;
-*pLow95 = pThreadInst->pPearsons[LowerIdx];
-*pHi95 = pThreadInst->pPearsons[UpperIdx];
-*pPValueLow95 = pThreadInst->pPValues[LowerIdx];
-*pPValueHi95 = pThreadInst->pPValues[UpperIdx];
-
-*pFeatLow95 = pThreadInst->pFeatFoldChanges[LowerIdx];
-*pFeatHi95 = pThreadInst->pFeatFoldChanges[UpperIdx];
+int MedianIdx;
+
+MedianIdx = (NumPerms-1)/2;
+LowerIdx = (NumPerms * 5) / 200;
+UpperIdx = NumPerms - LowerIdx;
+if(UpperIdx >= NumPerms)
+	UpperIdx = NumPerms - 1;
+NumRanks = 0;
+Ranks[NumRanks++] = LowerIdx;
+Ranks[NumRanks++] = MedianIdx;
+if(!(NumPerms & 0x01))
+	Ranks[NumRanks++] = MedianIdx + 1;
+Ranks[NumRanks++] = UpperIdx;
+
+SelectQuantiles(pThreadInst->pPearsons,NumPerms,NumRanks,Ranks,Quantiles);
+*pLow95 = Quantiles[0];
+*pMedian = (NumPerms & 0x01) ? Quantiles[1] : (Quantiles[1] + Quantiles[2])/2.0;
+*pHi95 = Quantiles[NumRanks-1];
+
+SelectQuantiles(pThreadInst->pPValues,NumPerms,NumRanks,Ranks,Quantiles);
+*pPValueLow95 = Quantiles[0];
+PValue = (NumPerms & 0x01) ? Quantiles[1] : (Quantiles[1] + Quantiles[2])/2.0;
+*pPValueHi95 = Quantiles[NumRanks-1];
+
+SelectQuantiles(pThreadInst->pFeatFoldChanges,NumPerms,NumRanks,Ranks,Quantiles);
+*pFeatLow95 = Quantiles[0];
+*pFeatMedian = (NumPerms & 0x01) ? Quantiles[1] : (Quantiles[1] + Quantiles[2])/2.0;
+*pFeatHi95 = Quantiles[NumRanks-1];
 
 return(PValue);
 }
@@ -4700,45 +4816,10 @@ if((pFeatDE->CtrlCnts >= m_MinFeatCntThres || pFeatDE->ExprCnts >= m_MinFeatCntT
 		pFeatDE->ObsFoldChange = (double)pFeatDE->ExprCnts * 1.0001;
 
 	// characterise the Pearson (-1.0 to 1.0) into 1 of 4 classes
-	if(pFeatDE->PearsonMedian >= cHiPearsonThres)
-		pFeatDE->PearsonScore = ePSHi;
-	else
-		{
-		if(pFeatDE->PearsonMedian >= cModPearsonThes)
-			pFeatDE->PearsonScore = ePSMod;
-		else
-			{
-			if(pFeatDE->PearsonMedian >= cLoPearsonThres)
-				pFeatDE->PearsonScore = ePSLow;
-			else
-				pFeatDE->PearsonScore = ePSNone;
-			}
-		}
+	pFeatDE->PearsonScore = PearsonClass(pFeatDE->PearsonMedian);
 
     // characterise the FoldMedian (0.0 to n.0) into 1 of 4 classes
-	double AbsFoldMedian;
-	AbsFoldMedian = ClampFoldChange(pFeatDE->FoldMedian);
-	if(pFeatDE->FoldMedian >= 0.1)
-		{
-		if(AbsFoldMedian < 1.0)
-			AbsFoldMedian = 1.0 / AbsFoldMedian;
-		if(AbsFoldMedian <= cNoFoldChange)
-			pFeatDE->CntsScore = eDESNone;
-		else
-			{
-			if(AbsFoldMedian <= cLoFoldChange)
-				pFeatDE->CntsScore = eDSElow;
-			else
-				{
-				if(AbsFoldMedian <= cModFoldChange)
-					pFeatDE->CntsScore = eDESMod;
-				else
-					pFeatDE->CntsScore = eDEHi;
-				}
-			}
-		}
-	else
-		pFeatDE->CntsScore = eDEHi;
+	pFeatDE->CntsScore = FoldChangeClass(pFeatDE->FoldMedian);
 	pFeatDE->DEscore = pFeatDE->CntsScore * pFeatDE->PearsonScore;
 	if(pFeatDE->DEscore > 4)			// 0,1,2,3,4,6,8,9,12,16
 		{
@@ -4845,19 +4926,77 @@ return(0);
 }
 
 
-// SortDoubles
-// Sort by ascending values (lower values at start of sorted array)
-static int
-SortDoubles(const void *arg1, const void *arg2)
+// SelectDouble
+// Partially reorders pValues[Lo..Hi] so that pValues[Nth] is the value which would be at Nth if pValues[Lo..Hi] were sorted ascending,
+// with all values before Nth <= and all values after Nth >= that value
+static double			// returned Nth value
+SelectDouble(double *pValues,int Lo,int Hi,int Nth)
 {
-double *pEl1 = (double *)arg1;
-double *pEl2 = (double *)arg2;
+int Left;
+int Right;
+int Mid;
+double Pivot;
+double Tmp;
+
+while(Hi > Lo)
+	{
+	// median of three pivot, also ensures there is a sentinel at each end of the partition
+	Mid = Lo + ((Hi - Lo) / 2);
+	if(pValues[Mid] < pValues[Lo])
+		{ Tmp = pValues[Mid]; pValues[Mid] = pValues[Lo]; pValues[Lo] = Tmp; }
+	if(pValues[Hi] < pValues[Lo])
+		{ Tmp = pValues[Hi]; pValues[Hi] = pValues[Lo]; pValues[Lo] = Tmp; }
+	if(pValues[Hi] < pValues[Mid])
+		{ Tmp = pValues[Hi]; pValues[Hi] = pValues[Mid]; pValues[Mid] = Tmp; }
+	Pivot = pValues[Mid];
+
+	Left = Lo;
+	Right = Hi;
+	while(Left <= Right)
+		{
+		while(pValues[Left] < Pivot)
+			Left += 1;
+		while(pValues[Right] > Pivot)
+			Right -= 1;
+		if(Left <= Right)
+			{
+			Tmp = pValues[Left]; pValues[Left] = pValues[Right]; pValues[Right] = Tmp;
+			Left += 1;
+			Right -= 1;
+			}
+		}
+	// pValues[Lo..Right] are <= Pivot, pValues[Left..Hi] are >= Pivot, and any in between are == Pivot
+	if(Nth <= Right)
+		Hi = Right;
+	else
+		{
+		if(Nth >= Left)
+			Lo = Left;
+		else
+			break;
+		}
+	}
+return(pValues[Nth]);
+}
 
-if(*pEl1 < *pEl2)
-	return(-1);
-if(*pEl1 > *pEl2)
-	return(1);
-return(0);
+// SelectQuantiles
+// Returns in pQuantiles the values at each of the ascending pRanks as if pValues were sorted ascending
+// Each rank is selected from the partition remaining above the previous rank so overall cost is linear rather than that of a full sort
+static void
+SelectQuantiles(double *pValues,	// values, will be partially reordered
+				int NumValues,		// number of values
+				int NumRanks,		// number of ranks
+				int *pRanks,		// ascending ranks (0..NumValues-1)
+				double *pQuantiles)	// returned values at each rank
+{
+int Idx;
+int Lo;
+Lo = 0;
+for(Idx = 0; Idx < NumRanks; Idx++)
+	{
+	pQuantiles[Idx] = SelectDouble(pValues,Lo,NumValues - 1,pRanks[Idx]);
+	Lo = pRanks[Idx];
+	}
 }
 
 /*HEADER
@@ -41,6 +41,10 @@ CreateBioseqSuffixFile(int Mode,
 					   int MinSeqLen,			// only accept for indexing sequences which are at least this length
 						int SimGenomeSize,		// if 1..120 then simulating indexing of a genome of this size in Gbp.
 					   int MaxThreads,			// max threads
+					   etSfxSortMode SortMode,	// suffix array construction method
+					   int KMerIdxLen,			// generate k-mer prefix index over k-mers of this length, 0 if no k-mer prefix index
+					   bool bMMScanAccel,		// true if mismatch scan accelerator (additional 2bit packed sequence) to be generated
+					   int SfxSampleRate,		// retain only suffixes starting at loci which are multiples of this rate, 1 to retain all suffixes
    					   bool bSOLiD,				// true if to process for colorspace (SOLiD)
 						int NumInputFiles,			// number of input file specs
 						char *pszInputFiles[],		// names of input files (wildcards allowed)
@@ -83,6 +87,10 @@ int iMode;									// processing mode
 bool bSOLiD;								// colorspace (SOLiD) generation
 int NumberOfProcessors;						// number of installed CPUs
 int NumThreads;								// number of threads (0 defaults to number of CPUs)
+etSfxSortMode SortMode;						// suffix array construction method
+int KMerIdxLen;								// k-mer prefix index length, 0 if no k-mer prefix index
+bool bMMScanAccel;							// also generate mismatch scan accelerator (additional 2bit packed sequence)
+int SfxSampleRate;							// retain only suffixes starting at loci which are multiples of this rate
 
 
 char szSQLiteDatabase[_MAX_PATH];	// results summaries to this SQLite file
@@ -95,9 +103,10 @@ struct arg_lit  *version = arg_lit0("v","version,ver",			"print version informat
 struct arg_int *FileLogLevel=arg_int0("f", "FileLogLevel",		"<int>","Level of diagnostics written to logfile 0=fatal,1=errors,2=info,3=diagnostics,4=debug");
 struct arg_file *LogFile = arg_file0("F","log","<file>",		"diagnostics log file");
 
-struct arg_int *Mode=arg_int0("m", "mode",	"<int>",			"Processing mode, 0=standard, 1=bisulphite index, 2=simulated genome (default 0)");
+struct arg_int *Mode=arg_int0("m", "mode",	"<int>",			"Processing mode, 0=standard, 1=bisulphite index, 2=simulated genome, 3=benchmark probe vs target compare kernels on 100..300bp reads, 4=benchmark read hit sorting (default 0)");
 struct arg_lit  *solid = arg_lit0("C","colorspace",             "Generate for colorspace (SOLiD)");
 struct arg_int *simgenomesize=arg_int0("s", "simgenomesize",	"<int>","Simulated genome size in Gbp (default 5, range 1..1000");
+struct arg_int *benchhits=arg_int0("b", "benchhits",			"<int>","Benchmark sorting this many million simulated read hits (default 100, range 1..1000)");
 
 struct arg_int *minseqlen=arg_int0("l", "minseqlen",			"<int>","Do not accept for indexing sequences less than this length (default 50, range 1..1000000)");
 
@@ -105,8 +114,12 @@ struct arg_file *infiles = arg_filen("i",NULL,"<file>",0,cMaxInFileSpecs,	"input
 struct arg_file *OutFile = arg_file0("o",NULL,"<file>",			"output suffix array file");
 struct arg_str *Descr = arg_str0("d","descr","<string>",		"full description");
 struct arg_str *Title = arg_str0("t","title","<string>",		"short title");
-struct arg_str *RefSpecies = arg_str1("r","ref","<string>",		"reference species");
+struct arg_str *RefSpecies = arg_str0("r","ref","<string>",		"reference species (required unless benchmarking)");
 struct arg_int *threads = arg_int0("T","threads","<int>",		"number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
+struct arg_int *sfxsort = arg_int0("x","sfxsort","<int>",		"suffix array construction, 0=multithreaded qsort, 1=linear time induced sorting (SA-IS) (default 0)");
+struct arg_int *kmeridxlen = arg_int0("k","kmeridx","<int>",	"k-mer prefix index length used to accelerate exact match lookups, 0 to disable, else 8..14 (default 12)");
+struct arg_lit  *mmscanaccel = arg_lit0("P","mmscanaccel",		"mismatch scan accelerator: also store a 2bit packed sequence copy, index grows by ~N/4 bytes");
+struct arg_int *sfxsample = arg_int0("S","sfxsample","<int>",	"retain only every Nth suffix to reduce index memory at the cost of slower aligning, 1..8 (default 1 retains all suffixes)");
 struct arg_file *summrslts = arg_file0("q","sumrslts","<file>",		"Output results summary to this SQLite3 database file");
 struct arg_str *experimentname = arg_str0("w","experimentname","<str>",		"experiment name SQLite3 database file");
 struct arg_str *experimentdescr = arg_str0("W","experimentdescr","<str>",	"experiment description SQLite3 database file");
@@ -114,8 +127,8 @@ struct arg_end *end = arg_end(200);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
 					summrslts,experimentname,experimentdescr,
-					Mode,minseqlen,simgenomesize,solid,infiles,OutFile,RefSpecies,Descr,Title,
-					threads,end};
+					Mode,minseqlen,simgenomesize,benchhits,solid,infiles,OutFile,RefSpecies,Descr,Title,
+					threads,sfxsort,kmeridxlen,mmscanaccel,sfxsample,end};
 
 char **pAllArgs;
 int argerrors;
@@ -248,12 +261,66 @@ if (!argerrors)
 		}
 
 	iMode = Mode->count ? Mode->ival[0] : 0;
-	if(iMode < 0 || iMode > 2)
+	if(iMode < 0 || iMode > 4)
 		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: processing mode '-m%d' must be specified in range %d..%d",iMode,0,1);
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: processing mode '-m%d' must be specified in range %d..%d",iMode,0,4);
 		exit(1);
 		}
 
+	if(iMode == 3)		// benchmarking the compare kernels used when aligning, no index is generated
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing parameters:");
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Benchmark probe vs target compare kernels on simulated 100..300bp reads");
+		gStopWatch.Start();
+		Rslt = CSfxArrayV3::BenchCmpKernels();
+		Rslt = Rslt >=0 ? 0 : 1;
+		if(gExperimentID > 0)
+			{
+			if(gProcessingID)
+				gSQLiteSummaries.EndProcessing(gExperimentID,gProcessingID,Rslt);
+			gSQLiteSummaries.EndExperiment(gExperimentID);
+			}
+		gStopWatch.Stop();
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Exit code: %d Total processing time: %s",Rslt,gStopWatch.Read());
+		exit(Rslt);
+		}
+
+	if(iMode == 4)		// benchmarking the radix sort of read hits used when aligning against the previous multithreaded qsort, no index is generated
+		{
+		int BenchHits = benchhits->count ? benchhits->ival[0] : (int)(cDfltBenchSortHits / 1000000);
+		if(BenchHits < 1 || BenchHits > 1000)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: benchmark read hits in millions '-b%d' must be specified in range 1..1000",BenchHits);
+			exit(1);
+			}
+#ifdef _WIN32
+		SYSTEM_INFO SystemInfo;
+		GetSystemInfo(&SystemInfo);
+		NumberOfProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+		NumberOfProcessors = sysconf(_SC_NPROCESSORS_CONF);
+#endif
+		int MaxAllowedThreads = min(cMaxWorkerThreads,NumberOfProcessors);	// limit to be at most cMaxWorkerThreads
+		if((NumThreads = threads->count ? threads->ival[0] : MaxAllowedThreads)<=0 || NumThreads > MaxAllowedThreads)
+			NumThreads = MaxAllowedThreads;
+
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing parameters:");
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Benchmark radix sort vs qsort on simulated read hits: %dM",BenchHits);
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
+		gStopWatch.Start();
+		Rslt = CMTRadixSort::BenchSortHits((INT64)BenchHits * 1000000,NumThreads);
+		Rslt = Rslt >=0 ? 0 : 1;
+		if(gExperimentID > 0)
+			{
+			if(gProcessingID)
+				gSQLiteSummaries.EndProcessing(gExperimentID,gProcessingID,Rslt);
+			gSQLiteSummaries.EndExperiment(gExperimentID);
+			}
+		gStopWatch.Stop();
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Exit code: %d Total processing time: %s",Rslt,gStopWatch.Read());
+		exit(Rslt);
+		}
+
 	if(iMode == 2)
 		{
 		SimGenomeSize = simgenomesize->count ? simgenomesize->ival[0] : 5;
@@ -268,6 +335,29 @@ if (!argerrors)
 
 	bSOLiD = solid->count ? true : false;
 
+	SortMode = (etSfxSortMode)(sfxsort->count ? sfxsort->ival[0] : eSfxSortQSort);
+	if(SortMode < eSfxSortQSort || SortMode > eSfxSortSAIS)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: suffix array construction '-x%d' must be specified in range %d..%d",SortMode,eSfxSortQSort,eSfxSortSAIS);
+		exit(1);
+		}
+
+	KMerIdxLen = kmeridxlen->count ? kmeridxlen->ival[0] : cDfltKMerIdxLen;
+	if(KMerIdxLen != 0 && (KMerIdxLen < cMinKMerIdxLen || KMerIdxLen > cMaxKMerIdxLen))
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: k-mer prefix index length '-k%d' must be either 0 or in range %d..%d",KMerIdxLen,cMinKMerIdxLen,cMaxKMerIdxLen);
+		exit(1);
+		}
+
+	bMMScanAccel = mmscanaccel->count ? true : false;
+
+	SfxSampleRate = sfxsample->count ? sfxsample->ival[0] : 1;
+	if(SfxSampleRate < 1 || SfxSampleRate > cMaxSfxSampleRate)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: suffix sample rate '-S%d' must be specified in range 1..%d",SfxSampleRate,cMaxSfxSampleRate);
+		exit(1);
+		}
+
 	int Idx;
 
 	if(iMode != 2)
@@ -317,6 +407,11 @@ if (!argerrors)
 		exit(1);
 		}
 
+	if(!RefSpecies->count)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: no reference species specified with '-r<string>' option)\n");
+		exit(1);
+		}
 	strncpy(szRefSpecies,RefSpecies->sval[0],cMaxDatasetSpeciesChrom);
 	szRefSpecies[cMaxDatasetSpeciesChrom-1] = '\0';
 
@@ -394,6 +489,16 @@ if (!argerrors)
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Reference species: '%s'",szRefSpecies);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Title text: '%s'",szTitle);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Descriptive text: '%s'",szDescription);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Suffix array construction: '%s'",SortMode == eSfxSortSAIS ? "induced sorting (SA-IS)" : "multithreaded qsort");
+	if(KMerIdxLen == 0 || iMode == 1)
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"K-mer prefix index: 'none'");
+	else
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"K-mer prefix index length: %d",KMerIdxLen);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Mismatch scan accelerator (additional 2bit packed sequence): '%s'",bMMScanAccel && iMode != 1 && !bSOLiD ? "yes" : "no");
+	if(SfxSampleRate == 1 || iMode == 1 || bSOLiD)
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Suffix sampling: 'none'");
+	else
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Suffix sampling: every %d loci",SfxSampleRate);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Number of threads : %d",NumThreads);
 
 	if(szExperimentName[0] != '\0')
@@ -403,7 +508,7 @@ if (!argerrors)
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
-	Rslt = CreateBioseqSuffixFile(iMode,MinSeqLen,SimGenomeSize,NumThreads,bSOLiD,NumInputFileSpecs,pszInputFileSpecs,szOutputFileSpec,szRefSpecies,szDescription,szTitle);
+	Rslt = CreateBioseqSuffixFile(iMode,MinSeqLen,SimGenomeSize,NumThreads,SortMode,KMerIdxLen,bMMScanAccel,SfxSampleRate,bSOLiD,NumInputFileSpecs,pszInputFileSpecs,szOutputFileSpec,szRefSpecies,szDescription,szTitle);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -775,6 +880,10 @@ CreateBioseqSuffixFile(int Mode,
 						int MinSeqLen,			// only accept for indexing sequences which are at least this length
 						int SimGenomeSize,		// if 1..1000 then simulating indexing of a genome of this size in Gbp.
 					   int MaxThreads,			// max threads
+					   etSfxSortMode SortMode,	// suffix array construction method
+					   int KMerIdxLen,			// generate k-mer prefix index over k-mers of this length, 0 if no k-mer prefix index
+					   bool bMMScanAccel,		// true if mismatch scan accelerator (additional 2bit packed sequence) to be generated
+					   int SfxSampleRate,		// retain only suffixes starting at loci which are multiples of this rate, 1 to retain all suffixes
    					   bool bSOLiD,				// true if to process for colorspace (SOLiD)
 						int NumInputFiles,			// number of input file specs
 						char *pszInputFiles[],		// names of input files (wildcards allowed)
@@ -839,6 +948,10 @@ if(m_pSfxFile == NULL)
 	}
 
 m_pSfxFile->SetMaxQSortThreads(MaxThreads);
+m_pSfxFile->SetSfxSortMode(SortMode);
+m_pSfxFile->SetKMerIdxLen(KMerIdxLen);
+m_pSfxFile->SetMMScanAccel(bMMScanAccel);
+m_pSfxFile->SetSfxSampleRate(SfxSampleRate);
 
 if(Mode == 2 && (pszDestSfxFile == NULL || pszDestSfxFile[0]=='\0'))
 	Rslt=m_pSfxFile->Open(false,bSOLiD);
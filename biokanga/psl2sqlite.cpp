@@ -27,7 +27,8 @@ Process(int PMode,					// processing mode, 0 to delete any existing then create
 		char *pszQueryFile,			// Blat'd query sequences in this file
 		char *pszTargetFile,		// against targeted sequences in this file
 		char *pszExprDescr,			// describes experiment
-		char *pszBlatParams);		// Blat parameters used
+		char *pszBlatParams,		// Blat parameters used
+		int NumThreads);			// number of parser threads
 
 int TrimQuotes(char *pszTxt);
 
@@ -54,6 +55,8 @@ int PMode;                              // processing mode
 int MinIdentity;						// minimum required identity
 int MinScore;							// minimum required score
 int MinMatches;							// minimum required base matches
+int NumberOfProcessors;					// number of installed CPUs
+int NumThreads;							// number of parser threads (0 defaults to number of CPUs)
 
 char szExprName[cMaxIdntNameLen];		// name of this experiment
 char szExprDescr[cMaxIdntDescrLen];		// describes experiment
@@ -85,11 +88,12 @@ struct arg_file *targetfile = arg_file1("t","targetfile","<file>",	"Blat input t
 struct arg_str *exprname = arg_str1("e","experiment","<str>",	"name of experiment");
 struct arg_str *exprdescr = arg_str0("E","description","<str>",	"describes experiment");
 struct arg_str *blatparams = arg_str0("b","parameters","<str>",	"Blat parameters used");
+struct arg_int *threads = arg_int0("T","threads","<int>",		"number of PSL parser threads 0..16 (defaults to 0 which sets threads to number of CPU cores)");
 
 struct arg_end *end = arg_end(40);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
-					pmode,minidentity,minscore,minmatches,infile,outfile,queryfile,targetfile,exprname,exprdescr,blatparams,
+					pmode,minidentity,minscore,minmatches,infile,outfile,queryfile,targetfile,exprname,exprdescr,blatparams,threads,
 					end};
 
 char **pAllArgs;
@@ -180,6 +184,23 @@ if (!argerrors)
 		exit(1);
 		}
 
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	NumberOfProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+	NumberOfProcessors = sysconf(_SC_NPROCESSORS_CONF);
+#endif
+	int MaxAllowedThreads = min(cMaxPSLParseThreads,NumberOfProcessors);	// limit to be at most cMaxPSLParseThreads
+	if((NumThreads = threads->count ? threads->ival[0] : MaxAllowedThreads)==0)
+		NumThreads = MaxAllowedThreads;
+	if(NumThreads < 0 || NumThreads > MaxAllowedThreads)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Number of threads '-T%d' specified was outside of range %d..%d",NumThreads,1,MaxAllowedThreads);
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Defaulting number of threads to %d",MaxAllowedThreads);
+		NumThreads = MaxAllowedThreads;
+		}
+
 // show user current resource limits
 #ifndef _WIN32
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Resources: %s",CUtility::ReportResourceLimits());
@@ -226,12 +247,13 @@ if (!argerrors)
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Blat target sequences file:   '%s'",szTargetFile);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Experiment descrption:   '%s'",szExprDescr);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Blat parameters used:   '%s'",szBlatParams);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
 	
 	gStopWatch.Start();
 #ifdef _WIN32
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
-	Rslt = Process(PMode,MinIdentity,MinScore,MinMatches,szOutFile,szExprName,szPSLinFile,szQueryFile,szTargetFile,szExprDescr,szBlatParams);
+	Rslt = Process(PMode,MinIdentity,MinScore,MinMatches,szOutFile,szExprName,szPSLinFile,szQueryFile,szTargetFile,szExprDescr,szBlatParams,NumThreads);
 	gStopWatch.Stop();
 	Rslt = Rslt < 0 ? 1 : 0;
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Exit Code: %d Total processing time: %s",Rslt,gStopWatch.Read());
@@ -257,7 +279,8 @@ Process(int PMode,					// processing mode, 0 to delete any existing then create
 		char *pszQueryFile,			// Blat'd query sequences in this file
 		char *pszTargetFile,		// against targeted sequences in this file
 		char *pszExprDescr,			// describes experiment
-		char *pszBlatParams)		// Blat parameters used
+		char *pszBlatParams,		// Blat parameters used
+		int NumThreads)				// number of parser threads
 {
 int Rslt;
 CSQLitePSL *pSQLitePSL;
@@ -267,7 +290,7 @@ if((pSQLitePSL = new CSQLitePSL)==NULL)
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to instantiate instance of CSQLitePSL");
 	return(eBSFerrObj);
 	}
-Rslt = pSQLitePSL->ProcessPSL2SQLite(PMode,MinIdentity,MinScore,MinMatches,pszDatabase,pszExprName,pszPSLFile,pszQueryFile,pszTargetFile,pszExprDescr,pszBlatParams,0);
+Rslt = pSQLitePSL->ProcessPSL2SQLite(PMode,MinIdentity,MinScore,MinMatches,pszDatabase,pszExprName,pszPSLFile,pszQueryFile,pszTargetFile,pszExprDescr,pszBlatParams,0,NumThreads);
 delete pSQLitePSL;
 return(Rslt);
 }
@@ -121,6 +121,39 @@ tsDEStmSQL CSQLiteDE::m_StmSQL[4] = {
 		(char *)"DROP INDEX IF EXISTS 'TblBins_ExprIDTransIDExpresIDNthBin';DROP INDEX IF EXISTS 'TblBins_TransID';DROP INDEX IF EXISTS 'TblBins_ExpresID',DROP INDEX IF EXISTS 'TblBins_NthBin'"},
 	};
 
+// When not m_bSafe then expression and bin rows are bulk loaded with explicitly assigned row identifiers, expression identifiers
+// are assigned as rows are buffered so bins can reference their expression before the expression row has actually been inserted
+tsDEBulkIns CSQLiteDE::m_BulkIns[eDEBTNumTbls] = {
+	{ 2, (char *)"ExpresID", 27, 0x00ff1e00, 0, 0, NULL, NULL },	// CtrlExprLociRatio..PValueHi95 and ObsFoldChange..PearsonHi95 are REAL
+	{ 3, (char *)"BinID", 7, 0x00, 0, 0, NULL, NULL }
+	};
+
+// GenBulkInsert
+// Generates an insert statement, for NumRows rows, with an explicitly assigned row identifier as the first column from a single row insert statement
+static char *
+GenBulkInsert(const char *pszInsert,	// single row insert statement, "INSERT INTO Tbl (Col,...) VALUES(?,...)"
+				const char *pszRowIDName,	// explicitly assigned row identifier column
+				int NumRows)				// generate for this many rows
+{
+const char *pszCols;
+const char *pszValues;
+char *pszBulkInsert;
+char *pDst;
+int RowIdx;
+
+if((pszCols = strchr(pszInsert,'(')) == NULL || (pszValues = strstr(pszCols,"VALUES(")) == NULL)
+	return(NULL);
+pszCols += 1;
+pszValues += 7;
+if((pszBulkInsert = new char [strlen(pszInsert) + strlen(pszRowIDName) + 2 + (NumRows * (strlen(pszValues) + 4)) + 1]) == NULL)
+	return(NULL);
+pDst = pszBulkInsert;
+pDst += sprintf(pDst,"%.*s%s,%.*s",(int)(pszCols - pszInsert),pszInsert,pszRowIDName,(int)(pszValues - 1 - pszCols),pszCols);
+for(RowIdx = 0; RowIdx < NumRows; RowIdx++)
+	pDst += sprintf(pDst,"%s(?,%s",RowIdx > 0 ? "," : "",pszValues);
+return(pszBulkInsert);
+}
+
 
 char *
 CSQLiteDE::RemoveQuotes(char *pszRawText)
@@ -278,9 +311,179 @@ for(TblIdx = 0; TblIdx <4; TblIdx++,pStms++)
 		return(NULL);
 		}
 	}
+
+if(!bSafe && PrepBulkInserts() != eBSFSuccess)
+	{
+	FinalizeBulkInserts();
+	pStms = m_StmSQL;
+	for(TblIdx = 0; TblIdx < 4; TblIdx++,pStms++)
+		{
+		if(pStms->pPrepInsert != NULL)
+			{
+			sqlite3_finalize(pStms->pPrepInsert);
+			pStms->pPrepInsert = NULL;
+			}
+		}
+	sqlite3_close_v2(m_pDB);
+	sqlite3_shutdown();
+	m_pDB = NULL;
+	return(NULL);
+	}
 return(m_pDB);
 }
 
+// PrepBulkInserts
+// Prepare the single and multirow insert statements, with explicitly assigned row identifiers, used when bulk loading
+int
+CSQLiteDE::PrepBulkInserts(void)
+{
+int sqlite_error;
+int BulkTbl;
+int LastRowID;
+char *pszInsert;
+char szMaxRowID[100];
+tsDEBulkIns *pBulkIns;
+
+FinalizeBulkInserts();
+pBulkIns = m_BulkIns;
+for(BulkTbl = 0; BulkTbl < eDEBTNumTbls; BulkTbl++,pBulkIns++)
+	{
+	pBulkIns->NumRows = 0;
+	if((pszInsert = GenBulkInsert(m_StmSQL[pBulkIns->TblIdx].pszInsert,pBulkIns->pszRowIDName,1)) == NULL)
+		return(eBSFerrMem);
+	sqlite_error = sqlite3_prepare_v2(m_pDB,pszInsert,-1,&pBulkIns->pPrepInsert,NULL);
+	delete []pszInsert;
+	if(sqlite_error != SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't prepare insert statement on table %s: %s", m_StmSQL[pBulkIns->TblIdx].pTblName, sqlite3_errmsg(m_pDB));
+		return(eBSFerrInternal);
+		}
+
+	if((pszInsert = GenBulkInsert(m_StmSQL[pBulkIns->TblIdx].pszInsert,pBulkIns->pszRowIDName,cDERowsPerInsert)) == NULL)
+		return(eBSFerrMem);
+	sqlite_error = sqlite3_prepare_v2(m_pDB,pszInsert,-1,&pBulkIns->pPrepInserts,NULL);
+	delete []pszInsert;
+	if(sqlite_error != SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't prepare multirow insert statement on table %s: %s", m_StmSQL[pBulkIns->TblIdx].pTblName, sqlite3_errmsg(m_pDB));
+		return(eBSFerrInternal);
+		}
+
+	// row identifiers continue on from any rows already in the table
+	LastRowID = 0;
+	sprintf(szMaxRowID,"SELECT max(%s) FROM %s",pBulkIns->pszRowIDName,m_StmSQL[pBulkIns->TblIdx].pTblName);
+	sqlite3_exec(m_pDB,szMaxRowID,ExecCallbackID,&LastRowID,NULL);
+	pBulkIns->LastRowID = LastRowID;
+	}
+return(eBSFSuccess);
+}
+
+void
+CSQLiteDE::FinalizeBulkInserts(void)
+{
+int BulkTbl;
+tsDEBulkIns *pBulkIns;
+pBulkIns = m_BulkIns;
+for(BulkTbl = 0; BulkTbl < eDEBTNumTbls; BulkTbl++,pBulkIns++)
+	{
+	if(pBulkIns->pPrepInserts != NULL)
+		{
+		sqlite3_finalize(pBulkIns->pPrepInserts);
+		pBulkIns->pPrepInserts = NULL;
+		}
+	if(pBulkIns->pPrepInsert != NULL)
+		{
+		sqlite3_finalize(pBulkIns->pPrepInsert);
+		pBulkIns->pPrepInsert = NULL;
+		}
+	pBulkIns->NumRows = 0;
+	}
+}
+
+// BulkInsertRow
+// Buffer row for bulk loading, buffered rows are inserted as a single multirow insert once cDERowsPerInsert rows have been buffered
+int										// returned explicitly assigned row identifier
+CSQLiteDE::BulkInsertRow(etDEBulkTbl BulkTbl,	// buffer row for bulk loading into this table
+				double *pVals)			// row values, excluding the row identifier
+{
+int Rslt;
+tsDEBulkIns *pBulkIns;
+
+if(m_pDB == NULL)
+	return(eBSFerrInternal);
+pBulkIns = &m_BulkIns[BulkTbl];
+if(pBulkIns->NumRows == cDERowsPerInsert && (Rslt = FlushBulkRows(pBulkIns)) < eBSFSuccess)
+	return(Rslt);
+memcpy(pBulkIns->Rows[pBulkIns->NumRows++],pVals,sizeof(double) * (pBulkIns->NumVals - 1));
+pBulkIns->LastRowID += 1;
+return(pBulkIns->LastRowID);
+}
+
+// FlushBulkRows
+// Insert rows currently buffered for a bulk loaded table, a full buffer is inserted with the multirow insert otherwise rows are individually inserted
+int
+CSQLiteDE::FlushBulkRows(tsDEBulkIns *pBulkIns)
+{
+int sqlite_error;
+int RowIdx;
+int ValIdx;
+int ColOfs;
+int RowID;
+double *pVal;
+sqlite3_stmt *pStm;
+
+if(m_pDB == NULL)
+	return(eBSFerrInternal);
+RowID = pBulkIns->LastRowID - pBulkIns->NumRows;
+pStm = pBulkIns->NumRows == cDERowsPerInsert ? pBulkIns->pPrepInserts : pBulkIns->pPrepInsert;
+ColOfs = 0;
+for(RowIdx = 0; RowIdx < pBulkIns->NumRows; RowIdx++)
+	{
+	pVal = pBulkIns->Rows[RowIdx];
+	sqlite_error = sqlite3_bind_int(pStm, ColOfs + 1, ++RowID);
+	for(ValIdx = 1; ValIdx < pBulkIns->NumVals; ValIdx++,pVal++)
+		{
+		if(pBulkIns->RealVals & (0x01 << ValIdx))
+			sqlite_error |= sqlite3_bind_double(pStm, ColOfs + ValIdx + 1, *pVal);
+		else
+			sqlite_error |= sqlite3_bind_int(pStm, ColOfs + ValIdx + 1, (int)*pVal);
+		}
+	if(sqlite_error != SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
+		CloseDatabase(true);
+		return(eBSFerrInternal);
+		}
+	if(pStm == pBulkIns->pPrepInserts && RowIdx < cDERowsPerInsert - 1)
+		{
+		ColOfs += pBulkIns->NumVals;
+		continue;
+		}
+	if((sqlite_error = sqlite3_step(pStm))!=SQLITE_DONE)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - step prepared statement: %s", sqlite3_errmsg(m_pDB));   
+		CloseDatabase(true);
+		return(eBSFerrInternal);
+		}
+	sqlite3_reset(pStm);
+	}
+pBulkIns->NumRows = 0;
+return(eBSFSuccess);
+}
+
+int
+CSQLiteDE::FlushBulkInserts(void)
+{
+int Rslt;
+int BulkTbl;
+for(BulkTbl = 0; BulkTbl < eDEBTNumTbls; BulkTbl++)
+	{
+	if(m_BulkIns[BulkTbl].NumRows > 0 && (Rslt = FlushBulkRows(&m_BulkIns[BulkTbl])) < eBSFSuccess)
+		return(Rslt);
+	}
+return(eBSFSuccess);
+}
+
 int
 CSQLiteDE::CloseDatabase(bool bNoIndexes)
 {
@@ -290,6 +493,7 @@ tsDEStmSQL *pStms;
 pStms = m_StmSQL;
 if(m_pDB != NULL)
 	{
+	FinalizeBulkInserts();
 	if(!bNoIndexes)
 		{
 		for(TblIdx = 0; TblIdx < 4; TblIdx++,pStms++)
@@ -569,9 +773,43 @@ CSQLiteDE::AddExpres(int ExprID,		// experiment identifier
 tsDEStmSQL *pStm;
 int sqlite_error;
 int ExpresID;
+double BulkVals[26];
 char szQueryExpresID[200];
 
 pStm = &m_StmSQL[2];								// access sequence statements
+if(!m_bSafe)
+	{
+	BulkVals[0] = ExprID;
+	BulkVals[1] = TransID;
+	BulkVals[2] = Class;
+	BulkVals[3] = Score;
+	BulkVals[4] = DECntsScore;
+	BulkVals[5] = PearsonScore;
+	BulkVals[6] = CtrlUniqueLoci;
+	BulkVals[7] = ExprUniqueLoci;
+	BulkVals[8] = CtrlExprLociRatio;
+	BulkVals[9] = PValueMedian;
+	BulkVals[10] = PValueLow95;
+	BulkVals[11] = PValueHi95;
+	BulkVals[12] = TotCtrlCnts;
+	BulkVals[13] = TotExprCnts;
+	BulkVals[14] = TotCtrlExprCnts;
+	BulkVals[15] = ObsFoldChange;
+	BulkVals[16] = FoldMedian;
+	BulkVals[17] = FoldLow95;
+	BulkVals[18] = FoldHi95;
+	BulkVals[19] = ObsPearson;
+	BulkVals[20] = PearsonMedian;
+	BulkVals[21] = PearsonLow95;
+	BulkVals[22] = PearsonHi95;
+	BulkVals[23] = CtrlAndExprBins;
+	BulkVals[24] = CtrlOnlyBins;
+	BulkVals[25] = ExprOnlyBins;
+	if((ExpresID = BulkInsertRow(eDEBTExpres,BulkVals)) > 0)
+		m_NumExpres += 1;
+	return(ExpresID);
+	}
+
 if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 1, ExprID))!=SQLITE_OK)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
@@ -741,13 +979,8 @@ if((sqlite_error = sqlite3_step(pStm->pPrepInsert))!=SQLITE_DONE)
 	}
 sqlite3_reset(pStm->pPrepInsert);
 
-if(m_bSafe)
-	{
-	sprintf(szQueryExpresID,"select ExpresID from TblExpres where ExprID = %d AND TransID = %d",ExprID,TransID);
-	sqlite3_exec(m_pDB,szQueryExpresID,ExecCallbackID,&ExpresID,NULL);
-	}
-else
-	ExpresID = (int)sqlite3_last_insert_rowid(m_pDB);
+sprintf(szQueryExpresID,"select ExpresID from TblExpres where ExprID = %d AND TransID = %d",ExprID,TransID);
+sqlite3_exec(m_pDB,szQueryExpresID,ExecCallbackID,&ExpresID,NULL);
 m_NumExpres += 1;						// number of expressions added to TblExpres
 return(ExpresID);
 }
@@ -763,10 +996,21 @@ CSQLiteDE::AddBin(int ExprID,
 int sqlite_error;
 tsDEStmSQL *pStm;
 int BinID;
+double BulkVals[6];
 char szQueryBinID[200];
 pStm = &m_StmSQL[3];								// access sequence statements
 if(m_pDB == NULL)
 	return(eBSFerrInternal);
+if(!m_bSafe)
+	{
+	BulkVals[0] = ExprID;
+	BulkVals[1] = TransID;
+	BulkVals[2] = ExpresID;
+	BulkVals[3] = NthBin;
+	BulkVals[4] = CtrlCounts;
+	BulkVals[5] = ExprCounts;
+	return(BulkInsertRow(eDEBTBins,BulkVals));
+	}
 if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 1, ExprID))!=SQLITE_OK)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
@@ -797,7 +1041,7 @@ if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 5, CtrlCounts))!=SQLITE_O
 	CloseDatabase(true);
 	return(eBSFerrInternal);
 	}
-if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 6, CtrlCounts))!=SQLITE_OK)
+if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 6, ExprCounts))!=SQLITE_OK)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
 	CloseDatabase(true);
@@ -814,14 +1058,9 @@ if((sqlite_error = sqlite3_step(pStm->pPrepInsert))!=SQLITE_DONE)
 	}
 sqlite3_reset(pStm->pPrepInsert);
 
-if(m_bSafe)
-	{
-	BinID = -1;
-	sprintf(szQueryBinID,"select BinID from TblBins where ExprID = %d AND TransID = %d AND ExpresID = %d AND NthBin = %d",ExprID,TransID,ExpresID,NthBin);
-	sqlite3_exec(m_pDB,szQueryBinID,ExecCallbackID,&BinID,NULL);
-	}
-else
-	BinID = (int)sqlite3_last_insert_rowid(m_pDB);	
+BinID = -1;
+sprintf(szQueryBinID,"select BinID from TblBins where ExprID = %d AND TransID = %d AND ExpresID = %d AND NthBin = %d",ExprID,TransID,ExpresID,NthBin);
+sqlite3_exec(m_pDB,szQueryBinID,ExecCallbackID,&BinID,NULL);
 return(BinID);
 }
 
@@ -970,6 +1209,14 @@ if((sqlite_error = sqlite3_exec(m_pDB,pszPragmaSyncOff,NULL,NULL,NULL))!=SQLITE_
 	return(eBSFerrInternal);
 	}
 
+// DE database is always clean created and populated within one transaction, a failure leaves nothing worth recovering
+if((sqlite_error = sqlite3_exec(m_pDB,pszPragmaJournMem,NULL,NULL,NULL))!=SQLITE_OK)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't set rollback journal to memory: %s", sqlite3_errmsg(m_pDB)); 
+	CloseDatabase(true);
+	return(eBSFerrInternal);
+	}
+
 // bracket inserts as a single transaction
 if((sqlite_error = sqlite3_exec(m_pDB,pszBeginTransaction,NULL,NULL,NULL))!=SQLITE_OK)
 	{
@@ -1117,6 +1364,12 @@ while((Rslt=pCSV->NextLine()) > 0)			// onto next line containing fields
 	}
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Parsed %d CSV lines - transcripts: %d",NumElsRead, m_NumTrans);
 
+if((Rslt = FlushBulkInserts()) < eBSFSuccess)
+	{
+	delete pCSV;
+	return(Rslt);
+	}
+
 	// end transaction
 if((sqlite_error = sqlite3_exec(m_pDB,pszEndTransaction,NULL,NULL,NULL))!=SQLITE_OK)
 	{
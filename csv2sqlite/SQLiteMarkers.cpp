@@ -134,6 +134,41 @@ tsStmSQL CSQLiteMarkers::m_StmSQL[7] = {
 		(char *)"DROP INDEX IF EXISTS 'TblMarkerSnps_ExprIDMarkerIDSnpID';DROP INDEX IF EXISTS 'TblMarkerSnps_SnpID';DROP INDEX IF EXISTS 'TblMarkerSnps_MarkerID'"}
 	};
 
+// When not m_bSafe then loci, SNP, marker and marker SNP rows are bulk loaded, row identifiers are explicitly assigned as rows are buffered
+// so these can be returned to the caller and referenced by subsequent rows before the rows have actually been inserted
+tsMarkersBulkIns CSQLiteMarkers::m_BulkIns[eMBTNumTbls] = {
+	{ 3, (char *)"LociID", 5, 0x10, 0, 0, NULL, NULL },
+	{ 4, (char *)"SnpID", 11, 0x00, 0, 0, NULL, NULL },
+	{ 5, (char *)"MarkerID", 6, 0x10, 0, 0, NULL, NULL },
+	{ 6, (char *)"MarkerSnpsID", 4, 0x00, 0, 0, NULL, NULL }
+	};
+
+// GenBulkInsert
+// Generates an insert statement, for NumRows rows, with an explicitly assigned row identifier as the first column from a single row insert statement
+static char *
+GenBulkInsert(const char *pszInsert,	// single row insert statement, "INSERT INTO Tbl (Col,...) VALUES(?,...)"
+				const char *pszRowIDName,	// explicitly assigned row identifier column
+				int NumRows)				// generate for this many rows
+{
+const char *pszCols;
+const char *pszValues;
+char *pszBulkInsert;
+char *pDst;
+int RowIdx;
+
+if((pszCols = strchr(pszInsert,'(')) == NULL || (pszValues = strstr(pszCols,"VALUES(")) == NULL)
+	return(NULL);
+pszCols += 1;
+pszValues += 7;
+if((pszBulkInsert = new char [strlen(pszInsert) + strlen(pszRowIDName) + 2 + (NumRows * (strlen(pszValues) + 4)) + 1]) == NULL)
+	return(NULL);
+pDst = pszBulkInsert;
+pDst += sprintf(pDst,"%.*s%s,%.*s",(int)(pszCols - pszInsert),pszInsert,pszRowIDName,(int)(pszValues - 1 - pszCols),pszCols);
+for(RowIdx = 0; RowIdx < NumRows; RowIdx++)
+	pDst += sprintf(pDst,"%s(?,%s",RowIdx > 0 ? "," : "",pszValues);
+return(pszBulkInsert);
+}
+
 
 char *
 CSQLiteMarkers::RemoveQuotes(char *pszRawText)
@@ -294,9 +329,184 @@ for(TblIdx = 0; TblIdx < 7; TblIdx++,pStms++)
 		return(NULL);
 		}
 	}
+
+if(!bSafe && PrepBulkInserts() != eBSFSuccess)
+	{
+	FinalizeBulkInserts();
+	pStms = m_StmSQL;
+	for(TblIdx = 0; TblIdx < 7; TblIdx++,pStms++)
+		{
+		if(pStms->pPrepInsert != NULL)
+			{
+			sqlite3_finalize(pStms->pPrepInsert);
+			pStms->pPrepInsert = NULL;
+			}
+		}
+	sqlite3_close_v2(m_pDB);
+	sqlite3_shutdown();
+	m_pDB = NULL;
+	return(NULL);
+	}
 return(m_pDB);
 }
 
+// PrepBulkInserts
+// Prepare the single and multirow insert statements, with explicitly assigned row identifiers, used when bulk loading
+int
+CSQLiteMarkers::PrepBulkInserts(void)
+{
+int sqlite_error;
+int BulkTbl;
+int LastRowID;
+char *pszInsert;
+char szMaxRowID[100];
+tsMarkersBulkIns *pBulkIns;
+
+FinalizeBulkInserts();
+pBulkIns = m_BulkIns;
+for(BulkTbl = 0; BulkTbl < eMBTNumTbls; BulkTbl++,pBulkIns++)
+	{
+	pBulkIns->NumRows = 0;
+	if((pszInsert = GenBulkInsert(m_StmSQL[pBulkIns->TblIdx].pszInsert,pBulkIns->pszRowIDName,1)) == NULL)
+		return(eBSFerrMem);
+	sqlite_error = sqlite3_prepare_v2(m_pDB,pszInsert,-1,&pBulkIns->pPrepInsert,NULL);
+	delete []pszInsert;
+	if(sqlite_error != SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't prepare insert statement on table %s: %s", m_StmSQL[pBulkIns->TblIdx].pTblName, sqlite3_errmsg(m_pDB));
+		return(eBSFerrInternal);
+		}
+
+	if((pszInsert = GenBulkInsert(m_StmSQL[pBulkIns->TblIdx].pszInsert,pBulkIns->pszRowIDName,cMarkersRowsPerInsert)) == NULL)
+		return(eBSFerrMem);
+	sqlite_error = sqlite3_prepare_v2(m_pDB,pszInsert,-1,&pBulkIns->pPrepInserts,NULL);
+	delete []pszInsert;
+	if(sqlite_error != SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't prepare multirow insert statement on table %s: %s", m_StmSQL[pBulkIns->TblIdx].pTblName, sqlite3_errmsg(m_pDB));
+		return(eBSFerrInternal);
+		}
+
+	// row identifiers continue on from any rows already in the table
+	LastRowID = 0;
+	sprintf(szMaxRowID,"SELECT max(%s) FROM %s",pBulkIns->pszRowIDName,m_StmSQL[pBulkIns->TblIdx].pTblName);
+	sqlite3_exec(m_pDB,szMaxRowID,ExecCallbackID,&LastRowID,NULL);
+	pBulkIns->LastRowID = LastRowID;
+	}
+return(eBSFSuccess);
+}
+
+void
+CSQLiteMarkers::FinalizeBulkInserts(void)
+{
+int BulkTbl;
+tsMarkersBulkIns *pBulkIns;
+pBulkIns = m_BulkIns;
+for(BulkTbl = 0; BulkTbl < eMBTNumTbls; BulkTbl++,pBulkIns++)
+	{
+	if(pBulkIns->pPrepInserts != NULL)
+		{
+		sqlite3_finalize(pBulkIns->pPrepInserts);
+		pBulkIns->pPrepInserts = NULL;
+		}
+	if(pBulkIns->pPrepInsert != NULL)
+		{
+		sqlite3_finalize(pBulkIns->pPrepInsert);
+		pBulkIns->pPrepInsert = NULL;
+		}
+	pBulkIns->NumRows = 0;
+	}
+}
+
+// BulkInsertRow
+// Buffer row for bulk loading, buffered rows are inserted as a single multirow insert once cMarkersRowsPerInsert rows have been buffered
+int										// returned explicitly assigned row identifier
+CSQLiteMarkers::BulkInsertRow(etMarkersBulkTbl BulkTbl,	// buffer row for bulk loading into this table
+				int *pVals)				// row values, excluding the row identifier
+{
+int Rslt;
+tsMarkersBulkIns *pBulkIns;
+
+if(m_pDB == NULL)
+	return(eBSFerrInternal);
+pBulkIns = &m_BulkIns[BulkTbl];
+if(pBulkIns->NumRows == cMarkersRowsPerInsert && (Rslt = FlushBulkRows(pBulkIns)) < eBSFSuccess)
+	return(Rslt);
+memcpy(pBulkIns->Rows[pBulkIns->NumRows++],pVals,sizeof(int) * (pBulkIns->NumVals - 1));
+pBulkIns->LastRowID += 1;
+return(pBulkIns->LastRowID);
+}
+
+// FlushBulkRows
+// Insert rows currently buffered for a bulk loaded table, a full buffer is inserted with the multirow insert otherwise rows are individually inserted
+int
+CSQLiteMarkers::FlushBulkRows(tsMarkersBulkIns *pBulkIns)
+{
+int sqlite_error;
+int RowIdx;
+int ValIdx;
+int ColOfs;
+int RowID;
+int *pVal;
+char szText[2];
+sqlite3_stmt *pStm;
+
+if(m_pDB == NULL)
+	return(eBSFerrInternal);
+RowID = pBulkIns->LastRowID - pBulkIns->NumRows;
+pStm = pBulkIns->NumRows == cMarkersRowsPerInsert ? pBulkIns->pPrepInserts : pBulkIns->pPrepInsert;
+ColOfs = 0;
+for(RowIdx = 0; RowIdx < pBulkIns->NumRows; RowIdx++)
+	{
+	pVal = pBulkIns->Rows[RowIdx];
+	sqlite_error = sqlite3_bind_int(pStm, ColOfs + 1, ++RowID);
+	for(ValIdx = 1; ValIdx < pBulkIns->NumVals; ValIdx++,pVal++)
+		{
+		if(pBulkIns->TextVals & (0x01 << ValIdx))
+			{
+			szText[0] = (char)*pVal;		// bound as a VARCHAR(1) text string, including terminator, as when individually inserting
+			szText[1] = '\0';
+			sqlite_error |= sqlite3_bind_text(pStm, ColOfs + ValIdx + 1, szText,2,SQLITE_TRANSIENT);
+			}
+		else
+			sqlite_error |= sqlite3_bind_int(pStm, ColOfs + ValIdx + 1, *pVal);
+		}
+	if(sqlite_error != SQLITE_OK)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
+		CloseDatabase(true);
+		return(eBSFerrInternal);
+		}
+	if(pStm == pBulkIns->pPrepInserts && RowIdx < cMarkersRowsPerInsert - 1)
+		{
+		ColOfs += pBulkIns->NumVals;
+		continue;
+		}
+	if((sqlite_error = sqlite3_step(pStm))!=SQLITE_DONE)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - step prepared statement: %s", sqlite3_errmsg(m_pDB));   
+		CloseDatabase(true);
+		return(eBSFerrInternal);
+		}
+	sqlite3_reset(pStm);
+	}
+pBulkIns->NumRows = 0;
+return(eBSFSuccess);
+}
+
+int
+CSQLiteMarkers::FlushBulkInserts(void)
+{
+int Rslt;
+int BulkTbl;
+for(BulkTbl = 0; BulkTbl < eMBTNumTbls; BulkTbl++)
+	{
+	if(m_BulkIns[BulkTbl].NumRows > 0 && (Rslt = FlushBulkRows(&m_BulkIns[BulkTbl])) < eBSFSuccess)
+		return(Rslt);
+	}
+return(eBSFSuccess);
+}
+
 int
 CSQLiteMarkers::CloseDatabase(bool bNoIndexes)
 {
@@ -306,6 +516,7 @@ tsStmSQL *pStms;
 pStms = m_StmSQL;
 if(m_pDB != NULL)
 	{
+	FinalizeBulkInserts();
 	if(!bNoIndexes)
 		{
 		for(TblIdx = 0; TblIdx < 7; TblIdx++,pStms++)
@@ -597,6 +808,7 @@ CSQLiteMarkers::AddLoci(int ExprID,			// experiment identifier
 int sqlite_error;
 tsStmSQL *pStm;
 int LociID;
+int BulkVals[4];
 char szLoci[200];
 char szBase[2];
 
@@ -606,6 +818,17 @@ szBase[1] = '\0';			// so easiest to use a VARCHAR(1) text string
 if(m_pDB == NULL)
 	return(eBSFerrInternal);
 
+if(!m_bSafe)
+	{
+	BulkVals[0] = ExprID;
+	BulkVals[1] = SeqID;
+	BulkVals[2] = Offset;
+	BulkVals[3] = (int)Base;
+	if((LociID = BulkInsertRow(eMBTLoci,BulkVals)) > 0)
+		m_NumSNPLoci += 1;
+	return(LociID);
+	}
+
 pStm = &m_StmSQL[3];								// access sequence statements
 if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 1, ExprID))!=SQLITE_OK)
 	{
@@ -640,13 +863,8 @@ if((sqlite_error = sqlite3_step(pStm->pPrepInsert))!=SQLITE_DONE)
 	}
 sqlite3_reset(pStm->pPrepInsert);
 
-if(m_bSafe)
-	{
-	sprintf(szLoci,"select LociID from TblLoci where ExprID = %d AND SeqID = %d AND Offset = %d and Base = %d",ExprID,SeqID,Offset,(int)Base);
-	sqlite3_exec(m_pDB,szLoci,ExecCallbackID,&LociID,NULL);
-	}
-else
-	LociID = (int)sqlite3_last_insert_rowid(m_pDB);
+sprintf(szLoci,"select LociID from TblLoci where ExprID = %d AND SeqID = %d AND Offset = %d and Base = %d",ExprID,SeqID,Offset,(int)Base);
+sqlite3_exec(m_pDB,szLoci,ExecCallbackID,&LociID,NULL);
 m_NumSNPLoci += 1;					// number of SNP loci added to TblLoci
 return(LociID);
 }
@@ -667,12 +885,30 @@ CSQLiteMarkers::AddSNP(int ExprID,			// experiment identifier
 int sqlite_error;
 tsStmSQL *pStm;
 int SnpID;
+int BulkVals[10];
 char szSNP[200];
 pStm = &m_StmSQL[4];								// access sequence statements
 
 if(m_pDB == NULL)
 	return(eBSFerrInternal);
 
+if(!m_bSafe)
+	{
+	BulkVals[0] = ExprID;
+	BulkVals[1] = CultID;
+	BulkVals[2] = LociID;
+	BulkVals[3] = Acnt;
+	BulkVals[4] = Ccnt;
+	BulkVals[5] = Gcnt;
+	BulkVals[6] = Tcnt;
+	BulkVals[7] = Ncnt;
+	BulkVals[8] = TotCovCnt;
+	BulkVals[9] = TotMMCnt;
+	if((SnpID = BulkInsertRow(eMBTSnps,BulkVals)) > 0)
+		m_NumSNPs += 1;
+	return(SnpID);
+	}
+
 if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 1, ExprID))!=SQLITE_OK)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
@@ -743,14 +979,9 @@ if((sqlite_error = sqlite3_step(pStm->pPrepInsert))!=SQLITE_DONE)
 	}
 sqlite3_reset(pStm->pPrepInsert);
 
-if(m_bSafe)
-	{
-	SnpID = -1;
-	sprintf(szSNP,"select SnpID from TblSnps where ExprID = %d AND LociID = %d AND CultID = %d",ExprID,LociID,CultID);
-	sqlite3_exec(m_pDB,szSNP,ExecCallbackID,&SnpID,NULL);
-	}
-else
-	SnpID = (int)sqlite3_last_insert_rowid(m_pDB);
+SnpID = -1;
+sprintf(szSNP,"select SnpID from TblSnps where ExprID = %d AND LociID = %d AND CultID = %d",ExprID,LociID,CultID);
+sqlite3_exec(m_pDB,szSNP,ExecCallbackID,&SnpID,NULL);
 m_NumSNPs += 1;						// number of SNPs added to TblSnps
 return(SnpID);
 }
@@ -765,6 +996,7 @@ CSQLiteMarkers::AddMarker(int ExprID,		// experiment identifier
 int sqlite_error;
 tsStmSQL *pStm;
 int MarkerID;
+int BulkVals[5];
 char szMarker[200];
 char szBase[2];
 szBase[0] = MarkerBase;		// SQLite seems to treat chars as 1byte integers and the command line SQLite shell displays as a numeric
@@ -774,6 +1006,18 @@ pStm = &m_StmSQL[5];								// access sequence statements
 if(m_pDB == NULL)
 	return(eBSFerrInternal);
 
+if(!m_bSafe)
+	{
+	BulkVals[0] = ExprID;
+	BulkVals[1] = CultID;
+	BulkVals[2] = LociID;
+	BulkVals[3] = (int)MarkerBase;
+	BulkVals[4] = MarkerScore;
+	if((MarkerID = BulkInsertRow(eMBTMarkers,BulkVals)) > 0)
+		m_NumMarkers += 1;
+	return(MarkerID);
+	}
+
 if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 1, ExprID))!=SQLITE_OK)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
@@ -813,14 +1057,9 @@ if((sqlite_error = sqlite3_step(pStm->pPrepInsert))!=SQLITE_DONE)
 	return(eBSFerrInternal);
 	}
 sqlite3_reset(pStm->pPrepInsert);
-if(m_bSafe)
-	{
-	MarkerID = -1;
-	sprintf(szMarker,"select MarkerID from TblMarkers where ExprID = %d AND LociID = %d AND CultID = %d AND Base = %d",ExprID,LociID,CultID,MarkerBase);
-	sqlite3_exec(m_pDB,szMarker,ExecCallbackID,&MarkerID,NULL);
-	}
-else
-	MarkerID = (int)sqlite3_last_insert_rowid(m_pDB);	
+MarkerID = -1;
+sprintf(szMarker,"select MarkerID from TblMarkers where ExprID = %d AND LociID = %d AND CultID = %d AND Base = %d",ExprID,LociID,CultID,MarkerBase);
+sqlite3_exec(m_pDB,szMarker,ExecCallbackID,&MarkerID,NULL);
 m_NumMarkers += 1;					// number of markers add to TblMarkers
 return(MarkerID);
 }
@@ -833,10 +1072,18 @@ CSQLiteMarkers::AddMarkerSnp(int ExprID,
 int sqlite_error;
 tsStmSQL *pStm;
 int MarkerSnpID;
+int BulkVals[3];
 char szMarkerSnp[200];
 pStm = &m_StmSQL[6];								// access sequence statements
 if(m_pDB == NULL)
 	return(eBSFerrInternal);
+if(!m_bSafe)
+	{
+	BulkVals[0] = ExprID;
+	BulkVals[1] = MarkerID;
+	BulkVals[2] = SnpID;
+	return(BulkInsertRow(eMBTMarkerSnps,BulkVals));
+	}
 if((sqlite_error = sqlite3_bind_int(pStm->pPrepInsert, 1, ExprID))!=SQLITE_OK)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - bind prepared statement: %s", sqlite3_errmsg(m_pDB)); 
@@ -864,14 +1111,9 @@ if((sqlite_error = sqlite3_step(pStm->pPrepInsert))!=SQLITE_DONE)
 	}
 sqlite3_reset(pStm->pPrepInsert);
 
-if(m_bSafe)
-	{
-	MarkerSnpID = -1;
-	sprintf(szMarkerSnp,"select MarkerSnpsID from TblMarkerSnps where ExprID = %d AND MarkerID = %d AND SnpID = %d",ExprID,MarkerID,SnpID);
-	sqlite3_exec(m_pDB,szMarkerSnp,ExecCallbackID,&MarkerSnpID,NULL);
-	}
-else
-	MarkerSnpID = (int)sqlite3_last_insert_rowid(m_pDB);	
+MarkerSnpID = -1;
+sprintf(szMarkerSnp,"select MarkerSnpsID from TblMarkerSnps where ExprID = %d AND MarkerID = %d AND SnpID = %d",ExprID,MarkerID,SnpID);
+sqlite3_exec(m_pDB,szMarkerSnp,ExecCallbackID,&MarkerSnpID,NULL);
 return(MarkerSnpID);
 }
 
@@ -946,6 +1188,14 @@ if((sqlite_error = sqlite3_exec(m_pDB,pszPragmaSyncOff,NULL,NULL,NULL))!=SQLITE_
 	return(eBSFerrInternal);
 	}
 
+// markers database is always clean created, so if populating fails there is nothing to be rolled back to
+if((sqlite_error = sqlite3_exec(m_pDB,pszPragmaJournMem,NULL,NULL,NULL))!=SQLITE_OK)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"sqlite - can't set rollback journal to memory: %s", sqlite3_errmsg(m_pDB)); 
+	CloseDatabase(true);
+	return(eBSFerrInternal);
+	}
+
 // bracket inserts as a single transaction
 if((sqlite_error = sqlite3_exec(m_pDB,pszBeginTransaction,NULL,NULL,NULL))!=SQLITE_OK)
 	{
@@ -1212,6 +1462,12 @@ while((Rslt=pCSV->NextLine()) > 0)			// onto next line containing fields
 	}
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Parsed %d CSV lines - unique sequences: %d, SNP Loci: %d, SNPs: %d, Markers: %d",NumElsRead, m_NumSeqs,m_NumSNPLoci, m_NumSNPs, m_NumMarkers);
 
+if((Rslt = FlushBulkInserts()) < eBSFSuccess)
+	{
+	delete pCSV;
+	return(Rslt);
+	}
+
 	// end transaction
 if((sqlite_error = sqlite3_exec(m_pDB,pszEndTransaction,NULL,NULL,NULL))!=SQLITE_OK)
 	{
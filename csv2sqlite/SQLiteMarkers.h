@@ -7,6 +7,9 @@ const int cMaxExprCultivars = 20;	// can process markers from CSV file which wer
 
 const int cMaxMRASeqs = 100;		// cache the last 100 sequence identifiers
 
+const int cMarkersRowsPerInsert = 64;	// bulk loaded rows are inserted using multirow inserts of this many rows (SQLite defaults to limiting bound values to 999)
+const int cMarkersMaxBulkVals = 11;		// bulk loaded rows have at most this many values, including the explicitly assigned row identifier
+
 typedef struct TAG_sStmsSQL {
 	char *pTblName;					// table name
 	char *pszCreateTbl;				// SQL statement used to create the table
@@ -18,6 +21,26 @@ typedef struct TAG_sStmsSQL {
 	char *pszDropIndexes;			// SQL statement used to drop indexes on this table
 } tsStmSQL;
 
+typedef enum TAG_eMarkersBulkTbl {
+	eMBTLoci = 0,					// bulk loading TblLoci
+	eMBTSnps,						// bulk loading TblSnps
+	eMBTMarkers,					// bulk loading TblMarkers
+	eMBTMarkerSnps,					// bulk loading TblMarkerSnps
+	eMBTNumTbls						// placeholder for number of bulk loaded tables
+} etMarkersBulkTbl;
+
+typedef struct TAG_sMarkersBulkIns {
+	int TblIdx;						// rows are inserted into this m_StmSQL[] table
+	char *pszRowIDName;				// row identifier column, identifiers are explicitly assigned when bulk loading
+	int NumVals;					// number of values in each row, including the row identifier
+	int TextVals;					// bitmap of values, bit 0 being the row identifier, which are single char VARCHAR(1) text
+	int LastRowID;					// last row identifier assigned
+	int NumRows;					// number of rows currently buffered
+	sqlite3_stmt *pPrepInsert;		// prepared single row insert of an explicitly identified row
+	sqlite3_stmt *pPrepInserts;		// prepared multirow insert of cMarkersRowsPerInsert explicitly identified rows
+	int Rows[cMarkersRowsPerInsert][cMarkersMaxBulkVals];	// buffered row values
+} tsMarkersBulkIns;
+
 typedef struct TAG_sCultivar {
 	char szCultivarName[cMaxIdntNameLen+1];		// cultivar short name
 	int CultIdx;					// when parsing CSV markers, cultivar starts at this CSV field
@@ -38,6 +61,7 @@ class CSQLiteMarkers
 	sqlite3 *m_pDB;						// pts to instance of SQLite
 	int m_NumSeqMRA;					// number of entries in MRA sequence table
 	static tsStmSQL m_StmSQL[7];		// SQLite table and index statements
+	static tsMarkersBulkIns m_BulkIns[eMBTNumTbls];	// bulk loaded tables, only used when not m_bSafe
 	tsCultivar Cultivars[cMaxExprCultivars];	// can process upto this many cultivars in CSV marker file
 	tsMRASeq m_MRASeqs[cMaxMRASeqs];	// MRA sequences
 
@@ -54,6 +78,19 @@ class CSQLiteMarkers
 	int
 		CloseDatabase(bool bNoIndexes = false);
 
+	int PrepBulkInserts(void);			// prepare bulk load insert statements
+	void FinalizeBulkInserts(void);		// finalize bulk load insert statements
+
+	int									// returned explicitly assigned row identifier
+		BulkInsertRow(etMarkersBulkTbl BulkTbl,	// buffer row for bulk loading into this table
+				int *pVals);			// row values, excluding the row identifier
+
+	int
+		FlushBulkRows(tsMarkersBulkIns *pBulkIns);	// insert all rows currently buffered for this table
+
+	int
+		FlushBulkInserts(void);			// insert all rows currently buffered for all bulk loaded tables
+
 	int												// errors if < eBSFSuccess, if positive then the ExprID
 		CreateExperiment(int CSVtype,					// 0 if markers, 1 if SNPs
 				char *pszInFile,				// parse from this input CSV file
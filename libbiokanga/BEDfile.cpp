@@ -20,6 +20,7 @@ m_pChromNames = NULL;		// pts to array of tsBEDchromname's sorted by chromid
 m_pFeatures = NULL;			// pts to array of tsBEDfeature's sorted by name-->chromid-->start-->end
 m_ppFeatureNames = NULL; // sorted (by name->chrom->start->end) array of ptrs into m_pFeatures
 m_ppFeatureChromStarts = NULL; // sorted (by chrom->start->end) array of ptrs into m_pFeatures
+m_pFeatMaxEnds = NULL;
 m_pChromHashes = NULL;
 m_hFile = -1;
 Reset(false);
@@ -197,6 +198,12 @@ if(m_ppFeatureChromStarts != NULL)
 	m_ppFeatureChromStarts = NULL;
 	}
 
+if(m_pFeatMaxEnds != NULL)
+	{
+	delete m_pFeatMaxEnds;
+	m_pFeatMaxEnds = NULL;
+	}
+
 if(m_pChromHashes != NULL)
 	{
 	delete m_pChromHashes;
@@ -1094,6 +1101,7 @@ int NameInst;
 tsBEDfeature *pFeature;
 tsBEDfeature *pPrevFeature;
 int NumThreads;
+teBSFrsltCodes Rslt;
 
 tsBEDchromname *pChrom;
 
@@ -1231,10 +1239,89 @@ for(Idx = 0; Idx < m_FileHdr.NumFeatures; Idx++)
 	if(FeatLen > pChrom->MaxFeatLen)
 		pChrom->MaxFeatLen = FeatLen;
 	}
+if((Rslt = BuildOverlapIndex()) != eBSFSuccess)
+	return(Rslt);
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Sort optimisation completed");
 return(eBSFSuccess);
 }
 
+// BuildOverlapIndex
+// Builds an implicit augmented interval tree over each chromosome's features as sorted by chrom->start->end in m_ppFeatureChromStarts
+// Features are the tree nodes with leaves at even indexes, and a node at level k has subtrees of 2^k - 1 nodes either side.
+// Each node records the maximum End over all features in it's subtree so subtrees which end before a query range can be skipped
+// and all features overlapping a range are located in O(log n + k) instead of scanning back by the chromosome's MaxFeatLen
+teBSFrsltCodes
+CBEDfile::BuildOverlapIndex(void)
+{
+int ChromIdx;
+INT64 Idx;
+INT64 LastIdx;
+INT64 NodeOfs;
+INT64 NumFeats;
+int Level;
+INT32 LastMaxEnd;
+INT32 MaxEnd;
+INT32 *pMaxEnds;
+tsBEDfeature **ppFeats;
+tsBEDchromname *pChrom;
+
+if(m_pFeatMaxEnds != NULL)
+	{
+	delete m_pFeatMaxEnds;
+	m_pFeatMaxEnds = NULL;
+	}
+if(!m_FileHdr.NumFeatures)
+	return(eBSFSuccess);
+if((m_pFeatMaxEnds = new INT32 [m_FileHdr.NumFeatures])==NULL)
+	{
+	AddErrMsg("CBEDfile::BuildOverlapIndex","Unable to alloc memory to hold %d feature max ends - %s",m_FileHdr.NumFeatures,m_szFile);
+	return(eBSFerrMem);
+	}
+
+pChrom = m_pChromNames;
+for(ChromIdx = 0; ChromIdx < m_FileHdr.NumChroms; ChromIdx++,pChrom++)
+	{
+	if((NumFeats = pChrom->NumFeatures) < 1)
+		continue;
+	ppFeats = &m_ppFeatureChromStarts[pChrom->FirstStartID - 1];
+	pMaxEnds = &m_pFeatMaxEnds[pChrom->FirstStartID - 1];
+
+	// leaves
+	LastIdx = 0;
+	LastMaxEnd = 0;
+	for(Idx = 0; Idx < NumFeats; Idx += 2)
+		{
+		LastIdx = Idx;
+		LastMaxEnd = pMaxEnds[Idx] = ppFeats[Idx]->End;
+		}
+
+	// internal nodes, level by level, LastMaxEnd tracks the max End over the rightmost subtree so nodes with right subtrees extending past NumFeats are correct
+	for(Level = 1; ((INT64)1 << Level) <= NumFeats; Level++)
+		{
+		NodeOfs = (INT64)1 << (Level - 1);
+		for(Idx = (NodeOfs << 1) - 1; Idx < NumFeats; Idx += NodeOfs << 2)
+			{
+			MaxEnd = ppFeats[Idx]->End;
+			if(pMaxEnds[Idx - NodeOfs] > MaxEnd)
+				MaxEnd = pMaxEnds[Idx - NodeOfs];
+			if(Idx + NodeOfs < NumFeats)
+				{
+				if(pMaxEnds[Idx + NodeOfs] > MaxEnd)
+					MaxEnd = pMaxEnds[Idx + NodeOfs];
+				}
+			else
+				if(LastMaxEnd > MaxEnd)
+					MaxEnd = LastMaxEnd;
+			pMaxEnds[Idx] = MaxEnd;
+			}
+		LastIdx = (LastIdx >> Level) & 0x01 ? LastIdx - NodeOfs : LastIdx + NodeOfs;
+		if(LastIdx < NumFeats && pMaxEnds[LastIdx] > LastMaxEnd)
+			LastMaxEnd = pMaxEnds[LastIdx];
+		}
+	}
+return(eBSFSuccess);
+}
+
 bool 
 CBEDfile::SetStrand(char Strand)	// sets globally which strand features must be on in subsequent processing '+'/'-' or '*' for either
 {
@@ -2022,6 +2109,8 @@ if(Rslt == eBSFSuccess)
 	        }
 		}
 #pragma warning(pop)
+if(Rslt == eBSFSuccess)
+	Rslt = BuildOverlapIndex();
 if(bCloseFile)
 	{
 	close(m_hFile);
@@ -2702,11 +2791,9 @@ CBEDfile::LocateFeatureIDonChrom(int ChromID, // feature is on which chromosome
  							 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
   							 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
 {
-int StartIdx;
-int EndIdx;
-int StartID;
-tsBEDchromname *pChrom;
-tsBEDfeature *pProbe;
+int Rslt;
+int FeatID;
+tsBEDOverlapCursor Cursor;
 
 //sanity checks whilst debugging
 #ifdef _DEBUG
@@ -2719,49 +2806,19 @@ if(ChromID > m_FileHdr.NumChroms)
 #endif
 
 
-pChrom = LocateChromName(ChromID);
-if(pChrom == NULL)
-	return(eBSFerrChrom);
-if(!pChrom->NumFeatures)
-	return(0);
-
-// determine initial lower limit to start linear search from which is a feature ending before OverLapsOfs
-// search terminates when start > OverLapsOfs
-if(pChrom->NumFeatures > 50 && OverLapsOfs > pChrom->MaxFeatLen) 
-	{
-	StartID = LocateStart(ChromID,OverLapsOfs - pChrom->MaxFeatLen,FiltInFlags,FiltOutFlags);
-	if(StartID == 0)
-		StartIdx = pChrom->FirstStartID - 1;
-	else
-		StartIdx = StartID - 1;
-	}
-else
-	StartIdx = pChrom->FirstStartID - 1;
-EndIdx = pChrom->LastStartID - 1;
-while(StartIdx <= EndIdx)
-	{
-	pProbe = m_ppFeatureChromStarts[StartIdx];
-	if(pProbe->Start <= OverLapsOfs &&
-	   pProbe->End >= OverLapsOfs)
-		{
-		if(pProbe->Score < m_MinScore || pProbe->Score > m_MaxScore)
-			continue;
-		if((m_OnStrand != '*' && m_OnStrand != pProbe->Strand) || !(pProbe->FiltFlags & FiltInFlags) || pProbe->FiltFlags & FiltOutFlags)
-			continue;
-		if(--Ith)
-			{
-			return(pProbe->FeatureID);
-			}
-		continue;
-		}
-	if(pProbe->Start > OverLapsOfs)
+if((Rslt = InitOverlapCursor(&Cursor,ChromID,OverLapsOfs,OverLapsOfs,FiltInFlags,FiltOutFlags)) != eBSFSuccess)
+	return(Rslt);
+while((FeatID = NextOverlapFeatureID(&Cursor)) > 0)
+	if(--Ith == 0)
 		break;
-	}
-
-return(0);
+return(FeatID);
 }
 
 
+// LocateFeatureIDinRangeOnChrom
+// Returns the Ith feature, in chrom->start->end order, which overlaps the range StartOfs..EndOfs
+// Callers iterating over all overlapping features should use InitOverlapCursor() and NextOverlapFeatureID() as each call here
+// must skip over the preceding Ith-1 overlapping features
 int											  // returned feature identifier
 CBEDfile::LocateFeatureIDinRangeOnChrom(int ChromID, // feature is on which chromosome
 							 int StartOfs,       // feature must end on or after Start
@@ -2770,10 +2827,9 @@ CBEDfile::LocateFeatureIDinRangeOnChrom(int ChromID, // feature is on which chro
  							 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
   							 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
 {
-int StartIdx;
-int EndIdx;
-int StartID;
-tsBEDfeature *pProbe;
+int Rslt;
+int FeatID;
+tsBEDOverlapCursor Cursor;
 
 // sanity checks whilst debug
 #ifdef _DEBUG
@@ -2785,43 +2841,149 @@ if(ChromID < 1 || ChromID > m_FileHdr.NumChroms)
 	return(eBSFerrChrom);
 #endif
 
-tsBEDchromname *pChrom = LocateChromName(ChromID);
-if(pChrom == NULL)
+if((Rslt = InitOverlapCursor(&Cursor,ChromID,StartOfs,EndOfs,FiltInFlags,FiltOutFlags)) != eBSFSuccess)
+	return(Rslt);
+while((FeatID = NextOverlapFeatureID(&Cursor)) > 0)
+	if(--Ith == 0)
+		break;
+return(FeatID);
+}
+
+// InitOverlapCursor
+// Initialises cursor for iterating, with NextOverlapFeatureID(), all features on ChromID which overlap the range StartOfs..EndOfs
+// Cursors are owned by the caller so multiple cursors can be concurrently iterated
+int											  // eBSFSuccess or error
+CBEDfile::InitOverlapCursor(tsBEDOverlapCursor *pCursor, // cursor to initialise
+							 int ChromID,		// feature is on which chromosome
+							 int StartOfs,       // features must end on or after Start
+							 int EndOfs,		  // and start on or before End 
+ 							 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
+  							 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
+{
+int MaxLevel;
+tsBEDchromname *pChrom;
+
+if(pCursor == NULL)
+	return(eBSFerrParams);
+pCursor->Depth = 0;
+pCursor->ScanIdx = 0;
+pCursor->ScanEnd = 0;
+pCursor->NumFeatures = 0;
+
+if(!m_bFeaturesAvail || m_pFeatMaxEnds == NULL)
+	return(eBSFerrFeature);
+if(ChromID < 1 || ChromID > m_FileHdr.NumChroms)
 	return(eBSFerrChrom);
+if(StartOfs > EndOfs)
+	return(eBSFerrParams);
 
-// determine initial lower limit to start linear search from which is a feature ending before StartOfs
-// search terminates when start > StartOfs
-if(pChrom->NumFeatures > 20 && StartOfs > pChrom->MaxFeatLen) 
-	{
-	StartID = LocateStart(ChromID,StartOfs - pChrom->MaxFeatLen,FiltInFlags,FiltOutFlags);
-	if(StartID == 0)
-		StartIdx = pChrom->FirstStartID - 1;
-	else
-		StartIdx = StartID - 1;
-	}
-else
-	StartIdx = pChrom->FirstStartID - 1;
-EndIdx = pChrom->LastStartID - 1;
-while(StartIdx <= EndIdx)
-	{
-	pProbe = m_ppFeatureChromStarts[StartIdx++];
-	if(pProbe->Start <= EndOfs &&
-	   pProbe->End >= StartOfs)
+if((pChrom = LocateChromName(ChromID)) == NULL)
+	return(eBSFerrChrom);
+
+pCursor->ChromID = ChromID;
+pCursor->StartOfs = StartOfs;
+pCursor->EndOfs = EndOfs;
+pCursor->FiltInFlags = FiltInFlags;
+pCursor->FiltOutFlags = FiltOutFlags;
+if((pCursor->NumFeatures = pChrom->NumFeatures) < 1)
+	return(eBSFSuccess);
+pCursor->FirstIdx = pChrom->FirstStartID - 1;
+
+// root of implicit tree is at level floor(log2(NumFeatures))
+for(MaxLevel = 0; ((INT64)1 << (MaxLevel + 1)) <= pCursor->NumFeatures; MaxLevel++);
+pCursor->Stack[0].NodeIdx = (1 << MaxLevel) - 1;
+pCursor->Stack[0].Level = MaxLevel;
+pCursor->Stack[0].bLeftDone = 0;
+pCursor->Depth = 1;
+return(eBSFSuccess);
+}
+
+// NextOverlapFeatureID
+// Returns next feature overlapping the cursor range, features are returned in chrom->start->end order
+// Implicit interval tree is traversed in order, subtrees with maximum End before the range start are skipped, and traversal
+// terminates once features start after the range end
+int											  // returned feature identifier, 0 if no more overlapping features
+CBEDfile::NextOverlapFeatureID(tsBEDOverlapCursor *pCursor)
+{
+tsBEDOverlapNode Node;
+tsBEDOverlapNode *pPush;
+tsBEDfeature *pProbe;
+tsBEDfeature **ppFeats;
+INT32 *pMaxEnds;
+INT32 NodeIdx;
+INT32 Idx;
+
+if(pCursor == NULL || pCursor->NumFeatures < 1)
+	return(0);
+ppFeats = &m_ppFeatureChromStarts[pCursor->FirstIdx];
+pMaxEnds = &m_pFeatMaxEnds[pCursor->FirstIdx];
+
+while(1) {
+	// linearly scanning a small subtree?
+	while(pCursor->ScanIdx < pCursor->ScanEnd)
 		{
+		pProbe = ppFeats[pCursor->ScanIdx++];
+		if(pProbe->Start > pCursor->EndOfs)
+			{
+			pCursor->ScanIdx = pCursor->ScanEnd;
+			break;
+			}
+		if(pProbe->End < pCursor->StartOfs)
+			continue;
 		if(pProbe->Score < m_MinScore || pProbe->Score > m_MaxScore)
 			continue;
-		if((m_OnStrand != '*' && m_OnStrand != pProbe->Strand) || !(pProbe->FiltFlags & FiltInFlags) || pProbe->FiltFlags & FiltOutFlags)
+		if((m_OnStrand != '*' && m_OnStrand != pProbe->Strand) || !(pProbe->FiltFlags & pCursor->FiltInFlags) || pProbe->FiltFlags & pCursor->FiltOutFlags)
 			continue;
-		if(--Ith == 0)
+		return(pProbe->FeatureID);
+		}
+
+	if(pCursor->Depth == 0)
+		return(0);
+	Node = pCursor->Stack[--pCursor->Depth];
+
+	if(Node.Level <= cOverlapScanLevel)			// small subtrees are simply linearly scanned
+		{
+		Idx = (Node.NodeIdx >> Node.Level) << Node.Level;
+		pCursor->ScanIdx = Idx;
+		pCursor->ScanEnd = min(pCursor->NumFeatures,Idx + (1 << (Node.Level + 1)) - 1);
+		continue;
+		}
+
+	if(!Node.bLeftDone)			// revisit this node after the left subtree, which is only processed if it could contain overlaps
+		{
+		NodeIdx = Node.NodeIdx - (1 << (Node.Level - 1));
+		pPush = &pCursor->Stack[pCursor->Depth++];
+		pPush->NodeIdx = Node.NodeIdx;
+		pPush->Level = Node.Level;
+		pPush->bLeftDone = 1;
+		if(NodeIdx >= pCursor->NumFeatures || pMaxEnds[NodeIdx] >= pCursor->StartOfs)
 			{
-			return(pProbe->FeatureID);
+			pPush = &pCursor->Stack[pCursor->Depth++];
+			pPush->NodeIdx = NodeIdx;
+			pPush->Level = Node.Level - 1;
+			pPush->bLeftDone = 0;
 			}
 		continue;
 		}
-	if(pProbe->Start > EndOfs)
-		break;
+
+	// left subtree processed, check this node and then process the right subtree
+	if(Node.NodeIdx >= pCursor->NumFeatures)
+		continue;
+	pProbe = ppFeats[Node.NodeIdx];
+	if(pProbe->Start > pCursor->EndOfs)			// this node, and all in it's right subtree, start after the range
+		continue;
+	pPush = &pCursor->Stack[pCursor->Depth++];
+	pPush->NodeIdx = Node.NodeIdx + (1 << (Node.Level - 1));
+	pPush->Level = Node.Level - 1;
+	pPush->bLeftDone = 0;
+	if(pProbe->End < pCursor->StartOfs)
+		continue;
+	if(pProbe->Score < m_MinScore || pProbe->Score > m_MaxScore)
+		continue;
+	if((m_OnStrand != '*' && m_OnStrand != pProbe->Strand) || !(pProbe->FiltFlags & pCursor->FiltInFlags) || pProbe->FiltFlags & pCursor->FiltOutFlags)
+		continue;
+	return(pProbe->FeatureID);
 	}
-return(0);
 }
 
 
@@ -2880,11 +3042,9 @@ CBEDfile::GetNumFeatures(int ChromID,	  // features are on which chromosome
 					 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
 					 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
 {
+int Rslt;
 int NumFeatures;
-int StartIdx;
-int EndIdx;
-int StartID;
-tsBEDfeature *pProbe;
+tsBEDOverlapCursor Cursor;
 
 // sanity checks whilst debug
 #ifdef _DEBUG
@@ -2896,39 +3056,11 @@ if(ChromID < 1 || ChromID > m_FileHdr.NumChroms)
 	return(eBSFerrChrom);
 #endif
 
-tsBEDchromname *pChrom = LocateChromName(ChromID);
-if(pChrom == NULL)
-	return(eBSFerrChrom);
-
-// determine initial lower limit to start linear search from which is a feature ending before StartOfs
-// search terminates when start > StartOfs
-if(pChrom->NumFeatures > 20 && StartOfs > pChrom->MaxFeatLen) 
-	{
-	StartID = LocateStart(ChromID,StartOfs - pChrom->MaxFeatLen,FiltInFlags,FiltOutFlags);
-	if(StartID == 0)
-		StartIdx = pChrom->FirstStartID - 1;
-	else
-		StartIdx = StartID - 1;
-	}
-else
-	StartIdx = pChrom->FirstStartID - 1;
-EndIdx = pChrom->LastStartID - 1;
+if((Rslt = InitOverlapCursor(&Cursor,ChromID,StartOfs,EndOfs,FiltInFlags,FiltOutFlags)) != eBSFSuccess)
+	return(Rslt);
 NumFeatures = 0;
-while(StartIdx <= EndIdx)
-	{
-	pProbe = m_ppFeatureChromStarts[StartIdx];
-	if((m_OnStrand == '*' || m_OnStrand == pProbe->Strand) &&
-		pProbe->FiltFlags & FiltInFlags && !(pProbe->FiltFlags & FiltOutFlags) &&
-			pProbe->Start <= EndOfs &&
-			pProbe->End >= StartOfs)
-		{
-		if(pProbe->Score >= m_MinScore && pProbe->Score <= m_MaxScore)
-			NumFeatures++;
-		continue;
-		}
-	if(pProbe->Start > EndOfs)
-		break;
-	}
+while(NextOverlapFeatureID(&Cursor) > 0)
+	NumFeatures++;
 return(NumFeatures);
 }
 
@@ -3509,7 +3641,7 @@ return(pGene->ExonStartEnds[(IntronID) * 2] + pProbe->Start - 1);
 bool 
 CBEDfile::InAnyFeature(int ChromID,int StartOfs,int EndOfs)
 {
-int FeatID;
+tsBEDOverlapCursor Cursor;
 // sanity checks!
 #ifdef _DEBUG
 if(!m_bFeaturesAvail || !m_FileHdr.NumFeatures)
@@ -3520,9 +3652,9 @@ if(StartOfs < 0 || StartOfs > EndOfs)
 	return(false);
 #endif
 
-if((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,StartOfs,EndOfs,1,cFeatFiltIn,cFeatFiltOut))>0)
-	return(true);
-return(false);
+if(InitOverlapCursor(&Cursor,ChromID,StartOfs,EndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(false);
+return(NextOverlapFeatureID(&Cursor) > 0 ? true : false);
 }
 
 
@@ -3769,8 +3901,8 @@ bool
 CBEDfile::InInternFeat(int FeatBits,int ChromID,int StartOfs,int EndOfs)
 {
 int FeatID;
-int FeatNxt;
 int OverLaps;
+tsBEDOverlapCursor Cursor;
 
 // sanity checks only whilst debugging
 #ifdef _DEBUG
@@ -3784,8 +3916,9 @@ if(!(FeatBits & cAnyFeatBits))
 	return(false);
 #endif
 
-FeatNxt = 1;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,StartOfs,EndOfs,FeatNxt++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,StartOfs,EndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(false);
+while((FeatID = NextOverlapFeatureID(&Cursor))>0)
 	{
 	OverLaps = GetFeatureOverlaps(FeatBits,FeatID,StartOfs,EndOfs);
 	if(OverLaps & FeatBits)
@@ -3798,10 +3931,10 @@ int
 CBEDfile::GetFeatureBits(int ChromID,int StartOfs,int EndOfs,int FeatBits,int Updnstream)
 {
 int FeatID;
-int FeatNxt;
 int Overlaps;
 int OverlapStartOfs;
 int OverlapEndOfs;
+tsBEDOverlapCursor Cursor;
 
 // no point in determining if in up/dnstream when length of up/dnstream region in <= 0
 if(Updnstream <= 0)
@@ -3822,9 +3955,10 @@ else
 	OverlapEndOfs = EndOfs;
 	}
 
-FeatNxt = 1;
 Overlaps = 0;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,OverlapStartOfs,OverlapEndOfs,FeatNxt++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,OverlapStartOfs,OverlapEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(0);
+while((FeatID = NextOverlapFeatureID(&Cursor))>0)
 	Overlaps |= GetFeatureOverlaps(FeatBits,FeatID,StartOfs,EndOfs,Updnstream);
 return(Overlaps);
 }
@@ -3833,10 +3967,10 @@ int
 CBEDfile::GetSpliceSiteBits(int ChromID,int StartOfs,int EndOfs,int OverlapDistance)
 {
 int FeatID;
-int FeatNxt;
 int Overlaps;
 int OverlapStartOfs;
 int OverlapEndOfs;
+tsBEDOverlapCursor Cursor;
 
 // sanity checks only whilst debugging
 #ifdef _DEBUG
@@ -3851,9 +3985,10 @@ if(!ChromID || ChromID > m_FileHdr.NumChroms || OverlapDistance < 1 ||
 OverlapStartOfs = StartOfs;
 OverlapEndOfs = EndOfs;
 
-FeatNxt = 1;
 Overlaps = 0;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,OverlapStartOfs,OverlapEndOfs,FeatNxt++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,OverlapStartOfs,OverlapEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(0);
+while((FeatID = NextOverlapFeatureID(&Cursor))>0)
 	Overlaps |= GetFeatureBitsSpliceOverlaps(FeatID,StartOfs,EndOfs,OverlapDistance);
 return(Overlaps);
 }
@@ -3898,9 +4033,9 @@ return(InInternFeat(cFeatBit3UTR,ChromID,StartOfs,EndOfs));
 bool CBEDfile::InAny5Upstream(int ChromID,int StartOfs,int EndOfs,int Distance)
 {
 int FeatID;
-int CurIth;
 int RelStartOfs;
 int RelEndOfs;
+tsBEDOverlapCursor Cursor;
 if(!m_bFeaturesAvail || !m_FileHdr.NumFeatures)
 	return(false);
 // sanity checks!
@@ -3916,8 +4051,9 @@ if(StartOfs >= Distance)
 else
 	RelStartOfs = 0;
 RelEndOfs = EndOfs + Distance;
-CurIth = 1;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,RelStartOfs,RelEndOfs,CurIth++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,RelStartOfs,RelEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(false);
+while((FeatID = NextOverlapFeatureID(&Cursor))>0)
 	{
 	if(In5Upstream(FeatID,StartOfs,EndOfs,Distance)==true)
 		return(true);
@@ -3931,9 +4067,9 @@ return(false);
 bool CBEDfile::InAny3Dnstream(int ChromID,int StartOfs,int EndOfs,int Distance)
 {
 int FeatID;
-int CurIth;
 int RelStartOfs;
 int RelEndOfs;
+tsBEDOverlapCursor Cursor;
 if(!m_bFeaturesAvail || !m_FileHdr.NumFeatures)
 	return(false);
 
@@ -3951,16 +4087,9 @@ if(StartOfs >= Distance)
 else
 	RelStartOfs = 0;
 RelEndOfs = EndOfs + Distance;
-CurIth = 1;
-
-// try from gene starts
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,RelStartOfs,RelEndOfs,CurIth++,cFeatFiltIn,cFeatFiltOut))>0)
-	if(In3Dnstream(FeatID,StartOfs,EndOfs,Distance)==true)
-		return(true);
-
-// try from gene ends
-CurIth = 1;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,RelStartOfs,RelEndOfs,CurIth++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,RelStartOfs,RelEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(false);
+while((FeatID = NextOverlapFeatureID(&Cursor))>0)
 	if(In3Dnstream(FeatID,StartOfs,EndOfs,Distance)==true)
 		return(true);
 return(false);
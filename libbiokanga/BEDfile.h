@@ -17,6 +17,9 @@ const int cDfltRegLen = 2000;		// default regulatory region length
 const int cMaxRegLen  = 1000000;	// max regulatory region length
 const int cMinSpliceOverlap = 2;	 // overlaps of features between introns and exons must be at least this to count as a splice site overlap
 
+const int cMaxOverlapCursorDepth = 64;	// overlap cursor stack depth, implicit interval tree depth is at most log2(cMaxNumFeats) + 1
+const int cOverlapScanLevel = 3;		// overlap cursor linearly scans implicit interval subtrees of this level or lower
+
 const int cBFSessionSyncTimeout = 10000L;// 10 second timeout on synchronising access to session instance data
 const int cMinNumBFSessions = 50;		 // minimum number of sessions supported
 const int cMaxNumBFSessions = 5000;		 // maximum number of sessions supported
@@ -100,6 +103,29 @@ typedef struct TAG_sBEDfeature {
 #pragma pack()
 
 
+#pragma pack(4)
+typedef struct TAG_sBEDOverlapNode {
+	INT32 NodeIdx;						// implicit interval tree node, index relative to first feature on chromosome
+	INT32 Level;						// node level in implicit interval tree (0 if leaf)
+	INT32 bLeftDone;					// non-zero if left subtree of this node has been processed
+} tsBEDOverlapNode;
+
+// overlap cursor, initialised by InitOverlapCursor() and then used by NextOverlapFeatureID() to iterate all features overlapping a range
+typedef struct TAG_sBEDOverlapCursor {
+	INT32 ChromID;						// features are on this chromosome
+	INT32 StartOfs;						// features must end on or after StartOfs
+	INT32 EndOfs;						// and start on or before EndOfs
+	INT32 FiltInFlags;					// filter out any features which do not have at least one of these filter flags set
+	INT32 FiltOutFlags;					// filter out any features which have at least one of these filter flags set
+	INT32 FirstIdx;						// index into m_ppFeatureChromStarts[] of first feature on chromosome
+	INT32 NumFeatures;					// number of features on chromosome
+	INT32 ScanIdx;						// if < ScanEnd then linearly scanning features from this relative index
+	INT32 ScanEnd;						// until this relative index exclusive
+	INT32 Depth;						// number of nodes in Stack[] still to be processed
+	tsBEDOverlapNode Stack[cMaxOverlapCursorDepth];
+} tsBEDOverlapCursor;
+#pragma pack()
+
 #pragma pack(8)
 typedef struct TAG_sBEDFileHdr {
 	UINT8 Magic[4];						// magic chars to identify this file as a biosequence file
@@ -151,6 +177,7 @@ class CBEDfile  : protected CEndian, public CErrorCodes
 
 	tsBEDfeature **m_ppFeatureNames;        // sorted (by name->chrom->start->end) array of ptrs into m_pFeatures
 	tsBEDfeature **m_ppFeatureChromStarts;  // sorted (by chrom->start->end) array of ptrs into m_pFeatures
+	INT32 *m_pFeatMaxEnds;				// implicit interval tree over each chromosome's features in m_ppFeatureChromStarts, max End over each node's subtree
 
 	 int m_MinScore;					// current score cutoffs
 	 int m_MaxScore;					// scores on any feature must be between these scores
@@ -178,6 +205,7 @@ class CBEDfile  : protected CEndian, public CErrorCodes
 	teBSFrsltCodes ReadDisk(INT64 DiskOfs,int Len,void *pTo);
 	teBSFrsltCodes Flush2Disk(void);
 	teBSFrsltCodes SortFeatures(void);
+	teBSFrsltCodes BuildOverlapIndex(void);	// build implicit interval trees over features sorted by chrom->start->end
 	int	LocateStart(int ChromID, // feature is on which chromosome
 					int OverLapsOfs, // a point on the chromosome which returned feature starts above chrom.ofs
 					 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
@@ -312,6 +340,17 @@ public:
  							 int FiltInFlags=cFeatFiltIn, // filter out any features which do not have at least one of the specified filter flags set
   							 int FiltOutFlags=cFeatFiltOut); // filter out any features which have at least one of the specified filter flags set
 
+	int										  // eBSFSuccess or error
+		InitOverlapCursor(tsBEDOverlapCursor *pCursor, // cursor to initialise
+							 int ChromID,	  // features are on which chromosome
+							 int Start,       // features must end on or after Start
+							 int End,		  // and start on or before End 
+ 							 int FiltInFlags=cFeatFiltIn, // filter out any features which do not have at least one of the specified filter flags set
+  							 int FiltOutFlags=cFeatFiltOut); // filter out any features which have at least one of the specified filter flags set
+
+	int										  // returned next overlapping feature identifier, 0 if no more overlapping features
+		NextOverlapFeatureID(tsBEDOverlapCursor *pCursor); // cursor as initialised by InitOverlapCursor(), features returned in same order as Ith instances from LocateFeatureIDinRangeOnChrom()
+
 	int										  // returned number of features
 		GetNumFeatures(int ChromID,			  // features are on which chromosome
 					   int Start,			  // features must end on or after Start
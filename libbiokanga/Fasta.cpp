@@ -16,19 +16,61 @@ CFasta::CFasta(void)
 {
 m_hFile = -1;
 m_gzFile = NULL;
+m_hBGZFFile = -1;
+m_bReadahead = false;
+m_pBGZFStage = NULL;
+m_pInflateBlocks = NULL;
+m_pInflatePool = NULL;
 memset(m_FastaBlocks, 0, sizeof(m_FastaBlocks));
 m_pCurFastaBlock = NULL;
+#ifdef _WIN32
+InitializeCriticalSection(&m_hReadaheadMtx);
+InitializeConditionVariable(&m_hBlockFilled);
+InitializeConditionVariable(&m_hBlockEmptied);
+#else
+pthread_mutex_init(&m_hReadaheadMtx,NULL);
+pthread_cond_init(&m_hBlockFilled,NULL);
+pthread_cond_init(&m_hBlockEmptied,NULL);
+#endif
 Cleanup();
 }
 
 CFasta::~CFasta(void)
 {
 Cleanup();
+#ifdef _WIN32
+DeleteCriticalSection(&m_hReadaheadMtx);
+#else
+pthread_cond_destroy(&m_hBlockEmptied);
+pthread_cond_destroy(&m_hBlockFilled);
+pthread_mutex_destroy(&m_hReadaheadMtx);
+#endif
 }
 
 void
 CFasta::Cleanup(void)
 {
+StopReadahead();
+if(m_pInflatePool != NULL)
+	{
+	delete m_pInflatePool;
+	m_pInflatePool = NULL;
+	}
+if(m_hBGZFFile >= 0)
+	{
+	close(m_hBGZFFile);
+	m_hBGZFFile = -1;
+	}
+if(m_pBGZFStage != NULL)
+	{
+	delete m_pBGZFStage;
+	m_pBGZFStage = NULL;
+	}
+if(m_pInflateBlocks != NULL)
+	{
+	delete m_pInflateBlocks;
+	m_pInflateBlocks = NULL;
+	}
 if(m_hFile >= 0)
 	{
 	if(!m_bRead)
@@ -55,6 +97,18 @@ for (int Idx = 0; Idx < cNumFastaBlocks; Idx++)
 	}
 memset(m_FastaBlocks, 0, sizeof(m_FastaBlocks));
 m_pCurFastaBlock = NULL;
+m_CurBlockIdx = 0;
+m_NumDecodeThreads = 0;
+m_bReadaheadTerm = false;
+m_ReadaheadFileOfs = 0;
+m_bIsBGZF = false;
+m_BGZFSkip = 0;
+m_bBGZFInEOF = false;
+m_BGZFStageAlloc = 0;
+m_BGZFStageCnt = 0;
+m_BGZFStageIdx = 0;
+m_NumInflateBlocks = 0;
+m_pInflateDest = NULL;
 m_FileDescrOfs = 0;
 m_FileReadDescrOfs = 0;
 m_szDescriptor[0] = '\0';
@@ -70,6 +124,19 @@ m_FastqSeqLen = 0;
 m_CurFastQParseLine = 0;
 }
 
+// DecodeThreadsInBudget
+// BGZF inflate threads run alongside the callers processing threads so are limited to a quarter of that processing budget, and at most cDfltFastaDecodeThreads, shared over all concurrently read files
+int
+CFasta::DecodeThreadsInBudget(int NumThreads,	// inflating alongside processing which is using this many threads
+				int NumFiles)					// over this many concurrently read files, returns number of BGZF inflate threads to use for each file
+{
+int NumDecodeThreads;
+if(NumFiles < 1)
+	NumFiles = 1;
+NumDecodeThreads = min(cDfltFastaDecodeThreads,NumThreads/4) / NumFiles;
+return(max(1,NumDecodeThreads));
+}
+
 UINT64
 CFasta::InitialFileSize(void)				// file size when initially opened for reading
 {
@@ -79,7 +146,8 @@ return(m_StatFileSize);
 int
 CFasta::Open(char *pszFile,						// fasta or fastq file path+name to open
 			 bool Read,							// TRUE if opening for read, FALSE for write
-			 unsigned long BufferSize)			// use this size buffer for staging
+			 unsigned long BufferSize,			// use this size buffer for staging
+			 int NumDecodeThreads)				// if > 0 then read ahead on a background thread, inflating any BGZF compressed file on this many threads
 {
 int Rslt;
 if(pszFile == NULL || *pszFile == '\0')
@@ -94,6 +162,12 @@ else
 
 Cleanup();	
 
+if(!Read || NumDecodeThreads < 0)
+	NumDecodeThreads = 0;
+else
+	if(NumDecodeThreads > cMaxFastaDecodeThreads)
+		NumDecodeThreads = cMaxFastaDecodeThreads;
+
 #ifdef _WIN32
 struct _stat64 st;
 if(!_stat64(pszFile,&st))
@@ -133,6 +207,23 @@ if(Read)		// read
 			m_bIsGZ = true;
 		else
 			m_bIsGZ = false;
+
+		// BGZF files are a series of independently compressed blocks, when reading ahead these blocks are inflated in parallel
+		if(m_bIsGZ && NumDecodeThreads > 0 && bgzf_is_bgzf(pszFile))
+			{
+#ifdef _WIN32
+			m_hBGZFFile = open(pszFile, O_READSEQ );
+#else
+			m_hBGZFFile = open64(pszFile, O_READSEQ );
+#endif
+			if(m_hBGZFFile == -1)
+				{
+				AddErrMsg("CFasta::Open","Unable to open %s - %s",pszFile,strerror(errno));
+				Cleanup();
+				return(eBSFerrOpnFile);
+				}
+			m_bIsBGZF = true;
+			}
 		}
 	else
 		{
@@ -184,6 +275,8 @@ else			// write
 
 if((UINT64)BufferSize > (m_StatFileSize+100))			// a little additional never hurts!
 	BufferSize = (UINT32)(m_StatFileSize + 100);
+if(m_bIsBGZF && BufferSize < (2 * BGZF_MAX_BLOCK_SIZE))	// file size is compressed size, blocks must be able to hold at least one inflated BGZF block
+	BufferSize = 2 * BGZF_MAX_BLOCK_SIZE;
 
 memset(m_FastaBlocks, 0, sizeof(m_FastaBlocks));
 
@@ -196,7 +289,7 @@ if (m_pCurFastaBlock->pBlock == NULL)
 	return(eBSFerrMem);
 	}
 m_pCurFastaBlock->AllocSize = BufferSize;
-if (m_bRead && cNumFastaBlocks > 1)
+if (Read && NumDecodeThreads > 0)
 	{
 	for (int Idx = 1; Idx < cNumFastaBlocks; Idx++)
 		{
@@ -209,6 +302,22 @@ if (m_bRead && cNumFastaBlocks > 1)
 			}
 		m_FastaBlocks[Idx].AllocSize = BufferSize;
 		}
+
+	if(m_bIsBGZF)
+		{
+		m_BGZFStageAlloc = (INT32)max((UINT32)(4 * BGZF_MAX_BLOCK_SIZE),(UINT32)BufferSize/2);
+		m_pBGZFStage = new UINT8[m_BGZFStageAlloc];
+		m_pInflateBlocks = new tsBGZFInflateBlock[cMaxBGZFInflateBlocks];
+		m_pInflatePool = new CWorkPool;
+		if(m_pBGZFStage == NULL || m_pInflateBlocks == NULL || m_pInflatePool == NULL)
+			{
+			AddErrMsg("CFasta::Open", "Memory allocation of %d bytes for %s- %s", m_BGZFStageAlloc, pszFile, strerror(errno));
+			Cleanup();
+			return(eBSFerrMem);
+			}
+		m_pInflatePool->SetMaxWorkers(NumDecodeThreads);
+		}
+	m_NumDecodeThreads = NumDecodeThreads;
 	}
 
 if((Rslt=Reset())!=eBSFSuccess)
@@ -855,23 +964,13 @@ CFasta::Reset(INT64 FileOfs)
 {
 if(m_hFile == -1 && m_gzFile == NULL)
 	return(eBSFerrClosed);		
-INT64 SeekPsn;
-if(m_hFile != -1)
-	SeekPsn = _lseeki64(m_hFile,FileOfs,SEEK_SET);
-else
-	SeekPsn = gzseek(m_gzFile,(long)FileOfs,SEEK_SET);
-if(SeekPsn != FileOfs)
+if(SeekTo(FileOfs) != eBSFSuccess)
 	{
 	AddErrMsg("CFasta::Reset","Seek failed to offset %d on %s - %s",FileOfs,m_szFile,strerror(errno));
 	Cleanup();
 	return(eBSFerrFileAccess);
 	}
 
-m_pCurFastaBlock = &m_FastaBlocks[0];
-m_pCurFastaBlock->FileOfs = 0;
-m_pCurFastaBlock->BuffCnt = 0;
-m_pCurFastaBlock->BuffIdx = 0;
-
 m_FileReadDescrOfs = 0;
 m_FileDescrOfs = 0;
 m_CurLineLen = 0;
@@ -882,6 +981,393 @@ m_CurFastQParseLine = 0;
 return(eBSFSuccess);
 }
 
+// SeekTo
+// Stops any readahead, seeks to FileOfs and discards all buffered blocks, then restarts readahead from FileOfs
+// BGZF files being read ahead are inflated from the start of file with the first FileOfs inflated chars discarded, as is the case for gzseek()
+int
+CFasta::SeekTo(INT64 FileOfs)
+{
+INT64 SeekPsn;
+int Idx;
+StopReadahead();
+if(m_hFile != -1)
+	SeekPsn = _lseeki64(m_hFile,FileOfs,SEEK_SET);
+else
+	{
+	if(m_bIsBGZF)
+		{
+		if(_lseeki64(m_hBGZFFile,0,SEEK_SET) != 0)
+			return(eBSFerrFileAccess);
+		m_BGZFStageCnt = 0;
+		m_BGZFStageIdx = 0;
+		m_bBGZFInEOF = false;
+		m_BGZFSkip = FileOfs;
+		SeekPsn = FileOfs;
+		}
+	else
+		SeekPsn = gzseek(m_gzFile,(long)FileOfs,SEEK_SET);
+	}
+if(SeekPsn != FileOfs)
+	return(eBSFerrFileAccess);
+
+for(Idx = 0; Idx < cNumFastaBlocks; Idx++)
+	{
+	m_FastaBlocks[Idx].FileOfs = 0;
+	m_FastaBlocks[Idx].BuffCnt = 0;
+	m_FastaBlocks[Idx].BuffIdx = 0;
+	m_FastaBlocks[Idx].bFilled = 0;
+	}
+m_CurBlockIdx = 0;
+m_pCurFastaBlock = &m_FastaBlocks[0];
+m_ReadaheadFileOfs = FileOfs;
+if(m_NumDecodeThreads > 0)
+	return(StartReadahead());
+return(eBSFSuccess);
+}
+
+// FillBlock
+// Makes the next block of file content current, resetting BuffIdx to 0 and setting FileOfs to the file offset of the block
+// If not reading ahead then the block is read or inflated by the calling thread, otherwise the block just consumed is handed back
+// to the readahead thread and the calling thread waits for the next block to have been filled
+int								// returns number of chars in block, 0 if EOF, < 0 if errors
+CFasta::FillBlock(void)
+{
+INT64 FileOfs;
+tsFastaBlock *pBlock;
+
+if(m_NumDecodeThreads == 0)
+	{
+	if(m_gzFile != NULL)
+		{
+		FileOfs = gztell(m_gzFile);
+		m_pCurFastaBlock->BuffCnt = gzread(m_gzFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
+		}
+	else
+		{
+		FileOfs = _lseeki64(m_hFile,0,SEEK_CUR);
+		m_pCurFastaBlock->BuffCnt = read(m_hFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
+		}
+	if (m_pCurFastaBlock->BuffCnt > 0)
+		{
+		m_pCurFastaBlock->BuffIdx = 0;
+		m_pCurFastaBlock->FileOfs = FileOfs;
+		}
+	return(m_pCurFastaBlock->BuffCnt);
+	}
+
+pBlock = m_pCurFastaBlock;
+#ifdef _WIN32
+EnterCriticalSection(&m_hReadaheadMtx);
+#else
+pthread_mutex_lock(&m_hReadaheadMtx);
+#endif
+if(pBlock->bFilled && pBlock->BuffCnt <= 0)		// readahead thread has already terminated at EOF or because of errors
+	{
+#ifdef _WIN32
+	LeaveCriticalSection(&m_hReadaheadMtx);
+#else
+	pthread_mutex_unlock(&m_hReadaheadMtx);
+#endif
+	return(pBlock->BuffCnt);
+	}
+if(pBlock->bFilled)			// hand consumed block back to readahead thread
+	{
+	pBlock->bFilled = 0;
+#ifdef _WIN32
+	WakeAllConditionVariable(&m_hBlockEmptied);
+#else
+	pthread_cond_broadcast(&m_hBlockEmptied);
+#endif
+	m_CurBlockIdx = (m_CurBlockIdx + 1) % cNumFastaBlocks;
+	pBlock = &m_FastaBlocks[m_CurBlockIdx];
+	}
+while(!pBlock->bFilled)
+#ifdef _WIN32
+	SleepConditionVariableCS(&m_hBlockFilled,&m_hReadaheadMtx,INFINITE);
+LeaveCriticalSection(&m_hReadaheadMtx);
+#else
+	pthread_cond_wait(&m_hBlockFilled,&m_hReadaheadMtx);
+pthread_mutex_unlock(&m_hReadaheadMtx);
+#endif
+
+m_pCurFastaBlock = pBlock;
+m_pCurFastaBlock->BuffIdx = 0;
+if(m_pCurFastaBlock->BuffCnt < 0)
+	AddErrMsg("CFasta::FillBlock","Errors whilst reading ahead on file '%s'",m_szFile);
+return(m_pCurFastaBlock->BuffCnt);
+}
+
+#ifdef _WIN32
+unsigned int __stdcall CFasta::_readahead_start(void *args)
+{
+#else
+void * CFasta::_readahead_start(void *args)
+{
+#endif
+CFasta *pThis = (CFasta *)args;
+pThis->ReadaheadLoop();
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
+#else
+return(NULL);
+#endif
+}
+
+// StartReadahead
+// Starts readahead thread which will fill blocks, starting with m_FastaBlocks[m_CurBlockIdx], from m_ReadaheadFileOfs
+int
+CFasta::StartReadahead(void)
+{
+if(m_bReadahead)
+	return(eBSFSuccess);
+m_bReadaheadTerm = false;
+#ifdef _WIN32
+m_hReadaheadThread = (HANDLE)_beginthreadex(NULL,0x0fffff,_readahead_start,this,0,&m_ReadaheadThreadID);
+if(m_hReadaheadThread == 0)
+#else
+if(pthread_create(&m_ReadaheadThreadID,NULL,_readahead_start,this) != 0)
+#endif
+	{
+	AddErrMsg("CFasta::StartReadahead","Unable to start readahead thread for file '%s'",m_szFile);
+	return(eBSFerrInternal);
+	}
+m_bReadahead = true;
+return(eBSFSuccess);
+}
+
+// StopReadahead
+// Requests readahead thread to terminate and waits for it to do so, any block being filled is completed before the thread terminates
+void
+CFasta::StopReadahead(void)
+{
+if(!m_bReadahead)
+	return;
+#ifdef _WIN32
+EnterCriticalSection(&m_hReadaheadMtx);
+m_bReadaheadTerm = true;
+WakeAllConditionVariable(&m_hBlockEmptied);
+LeaveCriticalSection(&m_hReadaheadMtx);
+WaitForSingleObject(m_hReadaheadThread,INFINITE);
+CloseHandle(m_hReadaheadThread);
+m_hReadaheadThread = 0;
+#else
+pthread_mutex_lock(&m_hReadaheadMtx);
+m_bReadaheadTerm = true;
+pthread_cond_broadcast(&m_hBlockEmptied);
+pthread_mutex_unlock(&m_hReadaheadMtx);
+pthread_join(m_ReadaheadThreadID,NULL);
+#endif
+m_bReadahead = false;
+m_bReadaheadTerm = false;
+}
+
+// ReadaheadLoop
+// Fills blocks in turn, waiting for each block to be consumed by the parser before it is refilled, until EOF, errors or m_bReadaheadTerm
+void
+CFasta::ReadaheadLoop(void)
+{
+int BlockIdx;
+int BuffCnt;
+tsFastaBlock *pBlock;
+
+BlockIdx = m_CurBlockIdx;
+do {
+	pBlock = &m_FastaBlocks[BlockIdx];
+#ifdef _WIN32
+	EnterCriticalSection(&m_hReadaheadMtx);
+	while(!m_bReadaheadTerm && pBlock->bFilled)
+		SleepConditionVariableCS(&m_hBlockEmptied,&m_hReadaheadMtx,INFINITE);
+	LeaveCriticalSection(&m_hReadaheadMtx);
+#else
+	pthread_mutex_lock(&m_hReadaheadMtx);
+	while(!m_bReadaheadTerm && pBlock->bFilled)
+		pthread_cond_wait(&m_hBlockEmptied,&m_hReadaheadMtx);
+	pthread_mutex_unlock(&m_hReadaheadMtx);
+#endif
+	if(m_bReadaheadTerm)
+		break;
+
+	pBlock->FileOfs = m_ReadaheadFileOfs;
+	pBlock->BuffIdx = 0;
+	BuffCnt = ReadaheadBlock(pBlock);
+	pBlock->BuffCnt = BuffCnt;
+	if(BuffCnt > 0)
+		m_ReadaheadFileOfs += BuffCnt;
+
+#ifdef _WIN32
+	EnterCriticalSection(&m_hReadaheadMtx);
+	pBlock->bFilled = 1;
+	WakeAllConditionVariable(&m_hBlockFilled);
+	LeaveCriticalSection(&m_hReadaheadMtx);
+#else
+	pthread_mutex_lock(&m_hReadaheadMtx);
+	pBlock->bFilled = 1;
+	pthread_cond_broadcast(&m_hBlockFilled);
+	pthread_mutex_unlock(&m_hReadaheadMtx);
+#endif
+	BlockIdx = (BlockIdx + 1) % cNumFastaBlocks;
+	}
+while(BuffCnt > 0);
+}
+
+// ReadaheadBlock
+// Reads next file content into pBlock, BGZF compressed files are inflated in parallel, otherwise reads are with gzread() or read()
+int						// returns number of chars read into pBlock, 0 if EOF, < 0 if errors
+CFasta::ReadaheadBlock(tsFastaBlock *pBlock)
+{
+if(m_bIsBGZF)
+	return(InflateBGZFBlocks(pBlock));
+if(m_gzFile != NULL)
+	return(gzread(m_gzFile, pBlock->pBlock, pBlock->AllocSize));
+return(read(m_hFile, pBlock->pBlock, pBlock->AllocSize));
+}
+
+// InflateBGZFBlocksTask
+// Work pool function inflating BGZF blocks [From,Until) of the current batch into m_pInflateDest
+int
+CFasta::InflateBGZFBlocksTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until)
+{
+CFasta *pThis = (CFasta *)pCtx;
+tsBGZFInflateBlock *pInflate;
+z_stream zs;
+int zRslt;
+
+pInflate = &pThis->m_pInflateBlocks[From];
+for(; From < Until; From++, pInflate++)
+	{
+	memset(&zs,0,sizeof(zs));
+	zs.next_in = (Bytef *)&pThis->m_pBGZFStage[pInflate->SrcOfs + 18];		// skip over 18 byte BGZF header
+	zs.avail_in = pInflate->SrcLen - 18 - 8;								// and 8 byte CRC32 + ISIZE trailer
+	zs.next_out = (Bytef *)&pThis->m_pInflateDest[pInflate->DestOfs];
+	zs.avail_out = pInflate->DestLen;
+	if(inflateInit2(&zs,-15) != Z_OK)
+		return(eBSFerrMem);
+	zRslt = inflate(&zs,Z_FINISH);
+	inflateEnd(&zs);
+	if(zRslt != Z_STREAM_END || zs.total_out != (uLong)pInflate->DestLen)
+		return(eBSFerrFileAccess);
+	}
+return(eBSFSuccess);
+}
+
+// InflateBGZFBlocks
+// Fills pBlock with as many complete inflated BGZF blocks as will fit, BGZF block trailers specify their inflated lengths so
+// the destination of each block is known before inflating and batches of blocks are inflated in parallel directly into pBlock
+int						// returns number of chars inflated into pBlock, 0 if EOF, < 0 if errors
+CFasta::InflateBGZFBlocks(tsFastaBlock *pBlock)
+{
+int Rslt;
+int NumRead;
+INT32 BuffCnt;
+INT32 BatchCnt;
+INT32 Avail;
+INT32 BlockLen;
+INT32 InflatedLen;
+INT32 Discard;
+UINT8 *pHdr;
+bool bFull;
+tsBGZFInflateBlock *pInflate;
+
+BuffCnt = 0;
+bFull = false;
+while(!bFull)
+	{
+	// batch up all complete BGZF blocks in staging buffer which will fit into pBlock
+	m_NumInflateBlocks = 0;
+	BatchCnt = 0;
+	pInflate = m_pInflateBlocks;
+	while(m_NumInflateBlocks < cMaxBGZFInflateBlocks)
+		{
+		Avail = m_BGZFStageCnt - m_BGZFStageIdx;
+		if(Avail < 18)
+			break;
+		pHdr = &m_pBGZFStage[m_BGZFStageIdx];
+		if(pHdr[0] != 31 || pHdr[1] != 139 || pHdr[2] != 8 || !(pHdr[3] & 4) || pHdr[12] != 'B' || pHdr[13] != 'C')
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"CFasta: Invalid BGZF block header in '%s'",m_szFile);
+			return(eBSFerrFileAccess);
+			}
+		BlockLen = (INT32)(pHdr[16] | (pHdr[17] << 8)) + 1;
+		if(BlockLen < 18 + 8)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"CFasta: Invalid BGZF block length in '%s'",m_szFile);
+			return(eBSFerrFileAccess);
+			}
+		if(Avail < BlockLen)
+			break;
+		InflatedLen = (INT32)(pHdr[BlockLen-4] | (pHdr[BlockLen-3] << 8) | (pHdr[BlockLen-2] << 16) | ((UINT32)pHdr[BlockLen-1] << 24));
+		if(InflatedLen > BGZF_MAX_BLOCK_SIZE)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"CFasta: Invalid BGZF inflated block length in '%s'",m_szFile);
+			return(eBSFerrFileAccess);
+			}
+		if(BuffCnt + BatchCnt + InflatedLen > pBlock->AllocSize)
+			{
+			bFull = true;
+			break;
+			}
+		pInflate->SrcOfs = m_BGZFStageIdx;
+		pInflate->SrcLen = BlockLen;
+		pInflate->DestOfs = BuffCnt + BatchCnt;
+		pInflate->DestLen = InflatedLen;
+		BatchCnt += InflatedLen;
+		m_BGZFStageIdx += BlockLen;
+		m_NumInflateBlocks += 1;
+		pInflate += 1;
+		}
+
+	if(m_NumInflateBlocks > 0)
+		{
+		m_pInflateDest = pBlock->pBlock;
+		if((Rslt = m_pInflatePool->Run(InflateBGZFBlocksTask,this,m_NumInflateBlocks,8)) < eBSFSuccess)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"CFasta: Errors inflating BGZF blocks in '%s'",m_szFile);
+			return(Rslt);
+			}
+		if(m_BGZFSkip > 0)			// still seeking to requested offset?
+			{
+			Discard = (INT32)min(m_BGZFSkip,(INT64)BatchCnt);
+			if(Discard < BatchCnt)
+				memmove(&pBlock->pBlock[BuffCnt],&pBlock->pBlock[BuffCnt + Discard],BatchCnt - Discard);
+			BatchCnt -= Discard;
+			m_BGZFSkip -= Discard;
+			}
+		BuffCnt += BatchCnt;
+		continue;
+		}
+	if(bFull)
+		break;
+
+	// need more compressed content in the staging buffer
+	if(m_bBGZFInEOF)
+		{
+		if(m_BGZFStageIdx != m_BGZFStageCnt)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"CFasta: Truncated BGZF block at end of '%s'",m_szFile);
+			return(eBSFerrFileAccess);
+			}
+		break;
+		}
+	if(m_BGZFStageIdx > 0)
+		{
+		if(m_BGZFStageCnt > m_BGZFStageIdx)
+			memmove(m_pBGZFStage,&m_pBGZFStage[m_BGZFStageIdx],m_BGZFStageCnt - m_BGZFStageIdx);
+		m_BGZFStageCnt -= m_BGZFStageIdx;
+		m_BGZFStageIdx = 0;
+		}
+	NumRead = read(m_hBGZFFile,&m_pBGZFStage[m_BGZFStageCnt],m_BGZFStageAlloc - m_BGZFStageCnt);
+	if(NumRead < 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"CFasta: Errors whilst reading '%s' - %s",m_szFile,strerror(errno));
+		return(eBSFerrFileAccess);
+		}
+	if(NumRead == 0)
+		m_bBGZFInEOF = true;
+	m_BGZFStageCnt += NumRead;
+	}
+return(BuffCnt);
+}
 
 // ReadSequence
 // Returns upto Max2Read bases from fasta or fastq input file
@@ -912,7 +1398,6 @@ CFasta::ReadSequence(void *pRetSeq,		// where to return sequence, can be NULL if
 bool bInDescriptor;		// true whilst processing descriptor or fastq sequence identifier characters
 bool bMoreToDo;
 char Chr;
-INT64 FileOfs;			// will contain file offset corresponding to last buffer read from file
 int SeqLen = 0;
 char *pAscii = (char *)pRetSeq;
 int Rslt;
@@ -967,21 +1452,8 @@ PrevSOLiDbase = 0;
 while(bMoreToDo) {
 	if (m_pCurFastaBlock->BuffIdx >= m_pCurFastaBlock->BuffCnt)	// time to refill m_pBuffer with another (up to) m_BuffSize chars?
 		{
-		if(m_gzFile != NULL)
-			{
-			FileOfs = gztell(m_gzFile);
-			m_pCurFastaBlock->BuffCnt = gzread(m_gzFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-		else
-			{
-			FileOfs = _lseeki64(m_hFile,0,SEEK_CUR);
-			m_pCurFastaBlock->BuffCnt = read(m_hFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-
-		if (m_pCurFastaBlock->BuffCnt <= 0)
+		if (FillBlock() <= 0)
 			break;
-		m_pCurFastaBlock->BuffIdx = 0;
-		m_pCurFastaBlock->FileOfs = FileOfs;
 		}
 
 	while (m_pCurFastaBlock->BuffIdx < m_pCurFastaBlock->BuffCnt)
@@ -1149,7 +1621,6 @@ CFasta::LocateDescriptor(char *pszPrefixToMatch,	// prefix to match or NULL if m
 char Buffer[16000];
 int Cnt;
 int CmpLen;
-int FilePsn;
 
 if(m_gzFile == NULL && m_hFile == -1 )
 	return(eBSFerrClosed);
@@ -1158,18 +1629,12 @@ if(!m_bRead)
 
 if(bFromStart)
 	{
-	m_pCurFastaBlock->BuffCnt = 0;
-	m_pCurFastaBlock->BuffIdx = 0;
 	m_DescrAvail = false;
 	m_FastqSeqLen = 0;
 	m_FastqSeqIdx = 0;
 	m_FastqSeqQLen = 0;
 
-	if(m_gzFile != NULL)
-		FilePsn = gzseek(m_gzFile,0,SEEK_SET);
-	else
-		FilePsn = (int)_lseeki64(m_hFile,0,SEEK_SET);
-	if(FilePsn != 0)
+	if(SeekTo(0) != eBSFSuccess)
 		{
 		AddErrMsg("CFasta::LocateDescriptor","Seek failed to offset 0 on %s - %s",m_szFile,strerror(errno));
 		return(eBSFerrFileAccess);
@@ -1206,7 +1671,6 @@ int
 CFasta::ParseFastQblockQ(void)	
 {
 char Chr;
-INT64 FileOfs;			// will contain file offset corresponding to last buffer read from file
 int ParseState;
 int SeqLen = 0;
 bool bIsFastQSOLiD;	// some fastq files (from NCBA SRA SRP000191) have SOLiD sequences
@@ -1224,21 +1688,8 @@ ParseState = 0;
 while(ParseState < 6) {
 	if (m_pCurFastaBlock->BuffIdx >= m_pCurFastaBlock->BuffCnt)
 		{
-		if(m_gzFile != NULL)
-			{
-			FileOfs = gztell(m_gzFile);
-			m_pCurFastaBlock->BuffCnt = gzread(m_gzFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-		else
-			{
-			FileOfs = _lseeki64(m_hFile,0,SEEK_CUR);
-			m_pCurFastaBlock->BuffCnt = read(m_hFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-
-		if (m_pCurFastaBlock->BuffCnt <= 0)
+		if (FillBlock() <= 0)
 			break;
-		m_pCurFastaBlock->BuffIdx = 0;
-		m_pCurFastaBlock->FileOfs = FileOfs;
 		}
 	while (ParseState < 6 && m_pCurFastaBlock->BuffIdx < m_pCurFastaBlock->BuffCnt)
 		{
@@ -1463,16 +1914,8 @@ if(!m_bRead)
 
 if(bFromStart)
 	{
-	int FileOfs;
-	m_pCurFastaBlock->BuffCnt = 0;
-	m_pCurFastaBlock->BuffIdx = 0;
 	m_DescrAvail = false;
-	if(m_gzFile != NULL)
-		FileOfs = gzseek(m_gzFile,0,SEEK_SET);
-	else
-		FileOfs = (int)_lseeki64(m_hFile,0,SEEK_SET);
-
-	if(FileOfs!=0)
+	if(SeekTo(0) != eBSFSuccess)
 		{
 		AddErrMsg("CFasta::ReadSubsequence","Seek failed to offset 0 on %s - %s",m_szFile,strerror(errno));
 		return(eBSFerrFileAccess);
@@ -1520,48 +1963,7 @@ CFasta::Ascii2Sense(char *pAscii,		// expected to be '\0' terminated, or SeqLen
 					etSeqBase *pSeq,	// where to return translated bases
 					bool RptMskUpperCase) // true if bases are softmasked as uppercase instead of default lowercase
 {
-char Base;
-int SeqLen = 0;
-while(MaxSeqLen-- && (Base = *pAscii++)!='\0')
-	{
-	SeqLen++;
-	switch(Base) {
-		case 'a':
-			*pSeq++ = eBaseA | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'A':
-			*pSeq++ = eBaseA  | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-		case 'c':
-			*pSeq++ = eBaseC  | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'C':
-			*pSeq++ =  eBaseC | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-		case 'g':
-			*pSeq++ =  eBaseG  | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'G':
-			*pSeq++ =  eBaseG | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-		case 't': case 'u': 
-			*pSeq++ =  eBaseT  | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'T': case 'U':
-			*pSeq++ =  eBaseT | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-
-		case '-':
-			*pSeq++ =  eBaseInDel;
-			continue;
-
-		default: // 'N'
-			*pSeq++ = eBaseN;
-			continue;
-		}
-	}
-
-return(SeqLen);
+return(CSeqTrans::Ascii2Bases(pAscii,MaxSeqLen,pSeq,RptMskUpperCase));
 }
 
 // ReadDescriptor
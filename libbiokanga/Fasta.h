@@ -31,7 +31,10 @@ const unsigned long cDfltStageBuffSize = 0x03ffffff;  // 64M buffer as default
 const unsigned long cMaxStageBuffSize = 0x07ffffff;	 // 128M buffer as maximum
 const unsigned long cMinStageBuffSize = 0x0fffff;	 // 1M buffer as minimum
 
-const int cNumFastaBlocks = 1;						 // when readahead disk buffering implemented then set to be 2 or more
+const int cNumFastaBlocks = 2;						 // when reading ahead then one block is parsed whilst the other is being filled
+const int cMaxFastaDecodeThreads = 64;				 // BGZF compressed blocks are inflated on at most this many threads
+const int cDfltFastaDecodeThreads = 4;				 // when sharing a processing thread budget then BGZF blocks are inflated on at most this many threads
+const int cMaxBGZFInflateBlocks = 4096;				 // at most this many BGZF blocks are inflated as a single batch
 
 const unsigned int cMaxGenFastaLineLen = 79;		// limit generated Fasta lines to this length
 const unsigned int cMaxFastaDescrLen   = 8192;	    // Fasta descriptor lines can be concatenated..
@@ -48,7 +51,16 @@ typedef struct TAG_sFastaBlock
 	INT32 BuffCnt;				// block currently loaded with this many chars
 	INT32 AllocSize;			// block was allocated to buffer at most this many chars in Fasta[]
 	UINT8 *pBlock;				// allocated to hold a block of fasta file content
+	volatile INT32 bFilled;		// when reading ahead then set by the readahead thread when block has been filled, reset by parser when block consumed
 	} tsFastaBlock;
+
+typedef struct TAG_sBGZFInflateBlock
+	{
+	INT32 SrcOfs;				// BGZF block starts at this offset in the compressed staging buffer
+	INT32 SrcLen;				// BGZF block is this length including header and trailer
+	INT32 DestOfs;				// inflate into fasta block starting at this offset
+	INT32 DestLen;				// expected inflated length as specified by the BGZF block trailer
+	} tsBGZFInflateBlock;
 #pragma pack()
 
 class CFasta : public CErrorCodes
@@ -64,7 +76,40 @@ class CFasta : public CErrorCodes
 	bool m_bRead;				// TRUE if reading fasta file, FALSE if write to fasta file
 
 	tsFastaBlock *m_pCurFastaBlock;    // buffered fasta block currently being processed
-	tsFastaBlock m_FastaBlocks[cNumFastaBlocks];    // allow for at most cNumFastaBlocks buffered fasta file blocks; currently not implemented but in future will allow for readahead of blocks
+	tsFastaBlock m_FastaBlocks[cNumFastaBlocks];    // allow for at most cNumFastaBlocks buffered fasta file blocks, blocks are filled by a readahead thread if m_NumDecodeThreads > 0
+	int m_CurBlockIdx;			// m_pCurFastaBlock is m_FastaBlocks[m_CurBlockIdx]
+
+	int m_NumDecodeThreads;		// if > 0 then file is read ahead on a background thread, with BGZF blocks inflated on up to this many threads
+	bool m_bReadahead;			// true if readahead thread has been started
+	volatile bool m_bReadaheadTerm;	// set true to request readahead thread to terminate
+	INT64 m_ReadaheadFileOfs;	// readahead thread will read next block from this (uncompressed) file offset
+	bool m_bIsBGZF;				// true if reading ahead a BGZF compressed file, blocks are inflated in parallel from m_hBGZFFile
+	int m_hBGZFFile;			// BGZF compressed file opened for raw reads
+	INT64 m_BGZFSkip;			// after a seek this many inflated bytes are still to be discarded
+	bool m_bBGZFInEOF;			// all of m_hBGZFFile has been read into the staging buffer
+	INT32 m_BGZFStageAlloc;		// staging buffer allocated to hold at most this many compressed bytes
+	INT32 m_BGZFStageCnt;		// staging buffer currently holds this many compressed bytes
+	INT32 m_BGZFStageIdx;		// next BGZF block starts at this offset in staging buffer
+	UINT8 *m_pBGZFStage;		// staging buffer for compressed BGZF blocks
+	int m_NumInflateBlocks;		// number of BGZF blocks in current inflate batch
+	tsBGZFInflateBlock *m_pInflateBlocks;	// current inflate batch
+	UINT8 *m_pInflateDest;		// current inflate batch is being inflated into this fasta block
+	CWorkPool *m_pInflatePool;	// BGZF blocks are inflated by workers in this pool
+
+#ifdef _WIN32
+	HANDLE m_hReadaheadThread;	// handle as returned by _beginthreadex()
+	unsigned int m_ReadaheadThreadID; // identifier as set by _beginthreadex()
+	CRITICAL_SECTION m_hReadaheadMtx;	// serialises block state between parser and readahead thread
+	CONDITION_VARIABLE m_hBlockFilled;	// signalled when readahead thread has filled a block
+	CONDITION_VARIABLE m_hBlockEmptied;	// signalled when parser has consumed a block
+	static unsigned int __stdcall _readahead_start(void *args);
+#else
+	pthread_t m_ReadaheadThreadID;		// identifier as set by pthread_create ()
+	pthread_mutex_t m_hReadaheadMtx;	// serialises block state between parser and readahead thread
+	pthread_cond_t m_hBlockFilled;		// signalled when readahead thread has filled a block
+	pthread_cond_t m_hBlockEmptied;		// signalled when parser has consumed a block
+	static void * _readahead_start(void *args);
+#endif
 
 	bool m_DescrAvail;			// true if NEW descriptor available, reset by ReadDescriptor()
 	char m_szDescriptor[cMaxFastaDescrLen+1];	// to hold last descriptor parsed
@@ -83,12 +128,24 @@ class CFasta : public CErrorCodes
 	int CheckIsFasta(void);		// checks if file contents are likely to be fasta or fastq format
 	int	ParseFastQblockQ(void); // Parses a fastq block (seq identifier + sequence + quality scores)
 
+	int SeekTo(INT64 FileOfs);	// stops any readahead, seeks to FileOfs and restarts readahead from that offset
+	int FillBlock(void);		// makes the next block of file content current, returns number of chars in block, 0 if EOF, < 0 if errors
+	int StartReadahead(void);	// starts readahead thread filling blocks from m_ReadaheadFileOfs
+	void StopReadahead(void);	// terminates and joins readahead thread
+	void ReadaheadLoop(void);	// readahead thread fills blocks until EOF or m_bReadaheadTerm
+	int ReadaheadBlock(tsFastaBlock *pBlock);	// reads or inflates next file content into pBlock, returns number of chars read
+	int InflateBGZFBlocks(tsFastaBlock *pBlock);	// inflates next BGZF blocks into pBlock, returns number of chars inflated
+	static int InflateBGZFBlocksTask(void *pCtx,int WorkerIdx,INT64 From,INT64 Until); // work pool function inflating BGZF blocks [From,Until) of current batch
+
 public:
 	CFasta(void);
 	~CFasta(void);
 	void Cleanup(void);
 	int Reset(INT64 FileOfs = 0l);				// reset context to that following an Open() with option to start processing at FileOfs
-	int Open(char *pszFile,bool Read = true,unsigned long BufferSize = cDfltStageBuffSize);
+	int Open(char *pszFile,bool Read = true,unsigned long BufferSize = cDfltStageBuffSize,
+				int NumDecodeThreads = 0);		// if > 0 then read ahead on a background thread, inflating any BGZF compressed file on this many threads
+	static int DecodeThreadsInBudget(int NumThreads,	// inflating alongside processing which is using this many threads
+				int NumFiles = 1);				// over this many concurrently read files, returns number of BGZF inflate threads to use for each file
 	bool IsFastq(void);							// true if opened file is in fastq format
 	bool IsSOLiD(void);							// true if opened file is in SOLiD or colorspace format
 	UINT64 InitialFileSize(void);				// file size when initially opened for reading
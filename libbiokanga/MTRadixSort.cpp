@@ -0,0 +1,414 @@
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "../libbiokanga/commhdrs.h"
+#else
+#include <sys/mman.h>
+#include <pthread.h>
+#include "../libbiokanga/commhdrs.h"
+#endif
+
+// need for speed rather than space...
+#pragma optimize("t", on)
+
+// Multithreaded LSD radix sort of fixed width 128bit keys
+// Keys are sorted on 8bit digits, least significant first, with each pass being a stable scatter so elements with identical keys retain
+// their original relative ordering. Digits for which all keys have the same value are detected up front and those passes are skipped
+// so sort cost is proportional to the number of key bytes which actually vary.
+// Each pass is partitioned over threads by contiguous element ranges; thread digit counts are prefix summed in thread order so the
+// sorted result is independent of the number of threads used.
+
+// constructor
+CMTRadixSort::CMTRadixSort(void)
+{
+m_MaxThreads = cDfltRadixThreads;
+m_NumThreads = 0;
+m_CurDigit = 0;
+m_pSrcEls = NULL;
+m_pDstEls = NULL;
+memset(m_ThreadPars,0,sizeof(m_ThreadPars));
+}
+
+// destructor
+CMTRadixSort::~CMTRadixSort(void)
+{
+}
+
+// SetMaxThreads
+// Sets maximum number of threads to use, if 0 then resets to cMaxRadixThreads
+void
+CMTRadixSort::SetMaxThreads(int MaxThreads)
+{
+if(MaxThreads <= 0 || MaxThreads > cMaxRadixThreads)
+	MaxThreads = cMaxRadixThreads;
+m_MaxThreads = MaxThreads;
+}
+
+// _radix_start
+// Thread start - simply unpacks it's args into a call to ProcessPhase
+#ifdef _WIN32
+unsigned int __stdcall CMTRadixSort::_radix_start(void *args)
+{
+#else
+void * CMTRadixSort::_radix_start(void *args)
+{
+#endif
+tsRadixThreadPars *pPars = (tsRadixThreadPars *)args;
+pPars->pThis->ProcessPhase(pPars);
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
+#else
+return(NULL);
+#endif
+}
+
+void
+CMTRadixSort::ProcessPhase(tsRadixThreadPars *pPars)
+{
+INT64 Idx;
+tsRadixEl *pEl;
+UINT64 Key;
+int Shift;
+bool bHi;
+
+switch(pPars->Phase) {
+	case 0:						// determine which key bits differ between elements
+		pPars->AndKeyHi = pPars->AndKeyLo = 0xffffffffffffffff;
+		pPars->OrKeyHi = pPars->OrKeyLo = 0;
+		pEl = &m_pSrcEls[pPars->StartIdx];
+		for(Idx = pPars->StartIdx; Idx < pPars->EndIdx; Idx++,pEl++)
+			{
+			pPars->AndKeyHi &= pEl->KeyHi;
+			pPars->OrKeyHi |= pEl->KeyHi;
+			pPars->AndKeyLo &= pEl->KeyLo;
+			pPars->OrKeyLo |= pEl->KeyLo;
+			}
+		break;
+
+	case 1:						// count occurrences of each value of the current digit
+		bHi = m_CurDigit >= 8;
+		Shift = (m_CurDigit & 0x07) * 8;
+		memset(pPars->Counts,0,sizeof(pPars->Counts));
+		pEl = &m_pSrcEls[pPars->StartIdx];
+		for(Idx = pPars->StartIdx; Idx < pPars->EndIdx; Idx++,pEl++)
+			{
+			Key = bHi ? pEl->KeyHi : pEl->KeyLo;
+			pPars->Counts[(Key >> Shift) & 0x0ff] += 1;
+			}
+		break;
+
+	case 2:						// stable scatter on current digit into offsets previously determined
+		bHi = m_CurDigit >= 8;
+		Shift = (m_CurDigit & 0x07) * 8;
+		pEl = &m_pSrcEls[pPars->StartIdx];
+		for(Idx = pPars->StartIdx; Idx < pPars->EndIdx; Idx++,pEl++)
+			{
+			Key = bHi ? pEl->KeyHi : pEl->KeyLo;
+			m_pDstEls[pPars->Counts[(Key >> Shift) & 0x0ff]++] = *pEl;
+			}
+		break;
+	}
+}
+
+void
+CMTRadixSort::RunPhase(int Phase)
+{
+int ThreadIdx;
+tsRadixThreadPars *pPars;
+
+for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++)
+	m_ThreadPars[ThreadIdx].Phase = Phase;
+
+if(m_NumThreads == 1)
+	{
+	ProcessPhase(&m_ThreadPars[0]);
+	return;
+	}
+
+// first thread's elements are processed on the calling thread
+pPars = &m_ThreadPars[1];
+for(ThreadIdx = 1; ThreadIdx < m_NumThreads; ThreadIdx++,pPars++)
+	{
+#ifdef _WIN32
+	pPars->threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,_radix_start,pPars,0,&pPars->threadID);
+	if(pPars->threadHandle == 0)
+		ProcessPhase(pPars);
+#else
+	pPars->threadRslt = pthread_create(&pPars->threadID,NULL,_radix_start,pPars);
+	if(pPars->threadRslt != 0)
+		ProcessPhase(pPars);
+#endif
+	}
+ProcessPhase(&m_ThreadPars[0]);
+
+pPars = &m_ThreadPars[1];
+for(ThreadIdx = 1; ThreadIdx < m_NumThreads; ThreadIdx++,pPars++)
+	{
+#ifdef _WIN32
+	if(pPars->threadHandle != 0)
+		{
+		WaitForSingleObject(pPars->threadHandle,INFINITE);
+		CloseHandle(pPars->threadHandle);
+		pPars->threadHandle = 0;
+		}
+#else
+	if(pPars->threadRslt == 0)
+		pthread_join(pPars->threadID,NULL);
+#endif
+	}
+}
+
+tsRadixEl *								// returns ptr to whichever of pEls or pTmpEls now contains the sorted elements
+CMTRadixSort::Sort(INT64 NumEls,		// number of elements to be sorted
+			tsRadixEl *pEls,			// elements to be sorted
+			tsRadixEl *pTmpEls)			// caller allocated temp buffer for at least NumEls elements
+{
+int ThreadIdx;
+int Digit;
+int Val;
+INT64 ThreadEls;
+INT64 Ofs;
+INT64 Cnt;
+UINT64 AndKeyHi;
+UINT64 OrKeyHi;
+UINT64 AndKeyLo;
+UINT64 OrKeyLo;
+UINT64 DiffKeyHi;
+UINT64 DiffKeyLo;
+tsRadixEl *pTmp;
+tsRadixThreadPars *pPars;
+
+if(NumEls < 2 || pEls == NULL || pTmpEls == NULL)
+	return(pEls);
+
+m_NumThreads = (int)min((INT64)m_MaxThreads,(NumEls + cMinRadixThreadEls - 1) / cMinRadixThreadEls);
+if(m_NumThreads < 1)
+	m_NumThreads = 1;
+ThreadEls = NumEls / m_NumThreads;
+pPars = m_ThreadPars;
+for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++,pPars++)
+	{
+	memset(pPars,0,sizeof(tsRadixThreadPars));
+	pPars->pThis = this;
+	pPars->StartIdx = ThreadIdx * ThreadEls;
+	pPars->EndIdx = ThreadIdx == m_NumThreads - 1 ? NumEls : pPars->StartIdx + ThreadEls;
+	}
+
+m_pSrcEls = pEls;
+m_pDstEls = pTmpEls;
+m_CurDigit = 0;
+
+// determine which key bits are not constant over all elements
+RunPhase(0);
+AndKeyHi = AndKeyLo = 0xffffffffffffffff;
+OrKeyHi = OrKeyLo = 0;
+pPars = m_ThreadPars;
+for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++,pPars++)
+	{
+	AndKeyHi &= pPars->AndKeyHi;
+	OrKeyHi |= pPars->OrKeyHi;
+	AndKeyLo &= pPars->AndKeyLo;
+	OrKeyLo |= pPars->OrKeyLo;
+	}
+DiffKeyHi = OrKeyHi ^ AndKeyHi;		// bits set if differing between elements
+DiffKeyLo = OrKeyLo ^ AndKeyLo;
+
+for(Digit = 0; Digit < 16; Digit++)
+	{
+	if((((Digit < 8 ? DiffKeyLo : DiffKeyHi) >> ((Digit & 0x07) * 8)) & 0x0ff) == 0)
+		continue;					// all elements have same value for this digit so no need to sort on it
+	m_CurDigit = Digit;
+	RunPhase(1);
+
+	// prefix sum over digit values, and within each digit value over threads in thread order, to obtain the scatter offsets
+	Ofs = 0;
+	for(Val = 0; Val < 256; Val++)
+		{
+		pPars = m_ThreadPars;
+		for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++,pPars++)
+			{
+			Cnt = pPars->Counts[Val];
+			pPars->Counts[Val] = Ofs;
+			Ofs += Cnt;
+			}
+		}
+	RunPhase(2);
+
+	pTmp = m_pSrcEls;
+	m_pSrcEls = m_pDstEls;
+	m_pDstEls = pTmp;
+	}
+return(m_pSrcEls);
+}
+
+// BenchSortHits
+// Benchmarks the radix sort against the multithreaded qsort previously used when sorting read hits
+// Simulated keys are those generated by CAligner::RadixSortReadHits() for the eRSMHitMatch sort order: most reads are accepted with a unique hit
+// on one of 24 chromosomes, the remainder are not accepted or have no or multiple hits. Both sorts are over the same elements, the qsort
+// comparing keys inline so it is not penalised by dereferencing read hits, and both sorted key sequences are checked to be in order and identical
+// with the radix sort also checked to be stable
+const int cBenchSortChroms = 24;			// simulated hits are onto this many chromosomes
+const UINT32 cBenchSortChromLen = 250000000;	// each of this length
+
+// SimBenchSortHits
+// Simulates NumHits eRSMHitMatch keys, each element's value is its index so sort stability can be checked
+static void
+SimBenchSortHits(INT64 NumHits,tsRadixEl *pEls,int Seed)
+{
+INT64 Idx;
+int Rand;
+int NumHits4Read;
+TRandomCombined<CRandomMother,CRandomMersenne> RG(Seed);
+for(Idx = 0; Idx < NumHits; Idx++,pEls++)
+	{
+	pEls->pValue = (void *)(size_t)Idx;
+	Rand = RG.IRandom(0,99);
+	if(Rand < 85)				// accepted unique hit
+		{
+		pEls->KeyHi = ((UINT64)1 << 56) | (UINT32)RG.IRandom(1,cBenchSortChroms);
+		pEls->KeyLo = ((UINT64)RG.IRandom(0,cBenchSortChromLen - 1) << 32) | ((UINT64)RG.IRandom(100,150) << 16) |
+					((UINT64)RG.IRandom(0,1) << 8) | (UINT8)(RG.IRandom(0,4) ^ 0x80);
+		continue;
+		}
+	NumHits4Read = Rand < 95 ? 0 : RG.IRandom(2,20);		// no hits or multiple hits
+	pEls->KeyHi = ((UINT64)RG.IRandom(2,7) << 56) | (((UINT64)(UINT16)NumHits4Read + 1) << 32);
+	pEls->KeyLo = 0;
+	}
+}
+
+// CmpBenchSortHits
+// qsort comparator over the radix sort keys
+static int
+CmpBenchSortHits(const void *arg1, const void *arg2)
+{
+tsRadixEl *pEl1 = (tsRadixEl *)arg1;
+tsRadixEl *pEl2 = (tsRadixEl *)arg2;
+if(pEl1->KeyHi != pEl2->KeyHi)
+	return(pEl1->KeyHi < pEl2->KeyHi ? -1 : 1);
+if(pEl1->KeyLo != pEl2->KeyLo)
+	return(pEl1->KeyLo < pEl2->KeyLo ? -1 : 1);
+return(0);
+}
+
+// ChkBenchSortHits
+// Returns number of misordered elements, and a hash of the sorted key sequence so sorts can be compared
+static INT64
+ChkBenchSortHits(INT64 NumHits,tsRadixEl *pEls,bool bStable,UINT64 *pKeysHash)
+{
+INT64 Idx;
+INT64 NumMisordered;
+UINT64 KeysHash;
+NumMisordered = 0;
+KeysHash = 0;
+for(Idx = 0; Idx < NumHits; Idx++,pEls++)
+	{
+	KeysHash = ((KeysHash << 5) | (KeysHash >> 59)) ^ pEls->KeyHi ^ (pEls->KeyLo * 0x9e3779b97f4a7c15);
+	if(Idx == 0)
+		continue;
+	switch(CmpBenchSortHits(&pEls[-1],pEls)) {
+		case 1:
+			NumMisordered += 1;
+			break;
+		case 0:
+			if(bStable && (size_t)pEls[-1].pValue > (size_t)pEls->pValue)
+				NumMisordered += 1;
+			break;
+		}
+	}
+*pKeysHash = KeysHash;
+return(NumMisordered);
+}
+
+int												// eBSFSuccess, eBSFerrMem if unable to allocate elements, eBSFerrInternal if either sort misorders
+CMTRadixSort::BenchSortHits(INT64 NumHits,		// benchmark radix sort against multithreaded qsort on this many simulated read hit keys
+							int NumThreads,		// sorting with this many threads
+							int Seed)			// pseudo-random generator seed used when simulating read hits
+{
+int Rslt;
+size_t memreq;
+tsRadixEl *pEls;
+tsRadixEl *pSorted;
+INT64 RadixMisordered;
+INT64 QsortMisordered;
+UINT64 RadixKeysHash;
+UINT64 QsortKeysHash;
+double RadixSecs;
+double QsortSecs;
+unsigned long Secs;
+unsigned long USecs;
+CStopWatch BenchTimer;
+CMTRadixSort RadixSort;
+CMTqsort MTqsort;
+
+if(NumHits < 2 || NumThreads < 1)
+	return(eBSFerrParams);
+
+// elements to be sorted plus same number as the radix sort scatter target
+memreq = (size_t)NumHits * 2 * sizeof(tsRadixEl);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"BenchSortHits: sorting %lld simulated read hits with %d threads, requires %1.2f GB",NumHits,NumThreads,(double)memreq / 0x040000000);
+#ifdef _WIN32
+pEls = (tsRadixEl *) malloc(memreq);
+if(pEls == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchSortHits: Memory allocation of %lld bytes failed",(INT64)memreq);
+	return(eBSFerrMem);
+	}
+#else
+pEls = (tsRadixEl *)mmap(NULL,memreq, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+if(pEls == MAP_FAILED)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchSortHits: Memory allocation of %lld bytes through mmap() failed - %s",(INT64)memreq,strerror(errno));
+	return(eBSFerrMem);
+	}
+#endif
+
+SimBenchSortHits(NumHits,pEls,Seed);
+RadixSort.SetMaxThreads(NumThreads);
+BenchTimer.Start();
+pSorted = RadixSort.Sort(NumHits,pEls,&pEls[NumHits]);
+BenchTimer.Stop();
+Secs = BenchTimer.ReadUSecs(&USecs);
+RadixSecs = (double)Secs + (double)USecs / 1000000.0;
+RadixMisordered = ChkBenchSortHits(NumHits,pSorted,true,&RadixKeysHash);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"BenchSortHits: radix sort %1.3f secs, %1.2f M hits/sec, %lld misordered",RadixSecs,(double)NumHits / (RadixSecs * 1000000.0),RadixMisordered);
+
+// same elements for the qsort
+SimBenchSortHits(NumHits,pEls,Seed);
+MTqsort.SetMaxThreads(NumThreads);
+BenchTimer.Reset();
+BenchTimer.Start();
+MTqsort.qsort(pEls,NumHits,sizeof(tsRadixEl),CmpBenchSortHits);
+BenchTimer.Stop();
+Secs = BenchTimer.ReadUSecs(&USecs);
+QsortSecs = (double)Secs + (double)USecs / 1000000.0;
+QsortMisordered = ChkBenchSortHits(NumHits,pEls,false,&QsortKeysHash);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"BenchSortHits: qsort %1.3f secs, %1.2f M hits/sec, %lld misordered",QsortSecs,(double)NumHits / (QsortSecs * 1000000.0),QsortMisordered);
+
+Rslt = eBSFSuccess;
+if(RadixMisordered || QsortMisordered || RadixKeysHash != QsortKeysHash)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchSortHits: sorted read hits differ between radix sort and qsort");
+	Rslt = eBSFerrInternal;
+	}
+else
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"BenchSortHits: radix sort is %1.2fx faster than qsort over %lld read hits",QsortSecs / RadixSecs,NumHits);
+
+#ifdef _WIN32
+free(pEls);
+#else
+munmap(pEls,memreq);
+#endif
+return(Rslt);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+const int cMaxRadixThreads = 64;		// allow for a max of this many radix sort threads
+const int cDfltRadixThreads = 8;		// default is for this many radix sort threads
+const INT64 cMinRadixThreadEls = 250000; // each thread should be processing at least this many elements
+const INT64 cMinRadixSortEls = 50000;	// if less than this number of elements then callers should prefer a comparator based qsort
+const INT64 cDfltBenchSortHits = 100000000;	// default number of simulated read hits sorted when benchmarking
+
+#pragma pack(8)
+// elements to be radix sorted are compact fixed width 128bit keys with an associated value (usually a ptr to the record keyed)
+typedef struct TAG_sRadixEl {
+	UINT64 KeyHi;				// most significant 64bits of key
+	UINT64 KeyLo;				// least significant 64bits of key
+	void *pValue;				// value associated with key
+} tsRadixEl;
+
+typedef struct TAG_sRadixThreadPars {
+	class CMTRadixSort *pThis;
+#ifdef _WIN32
+	HANDLE threadHandle;		// handle as returned by _beginthreadex()
+	unsigned int threadID;		// identifier as set by _beginthreadex()
+#else
+	int threadRslt;				// result as returned by pthread_create ()
+	pthread_t threadID;			// identifier as set by pthread_create ()
+#endif
+	int Phase;					// 0: key bit differences, 1: current digit counts, 2: scatter on current digit
+	INT64 StartIdx;				// thread processes elements starting from this index inclusive
+	INT64 EndIdx;				// through to this index exclusive
+	UINT64 AndKeyHi;			// all KeyHi in this thread's elements AND'd
+	UINT64 OrKeyHi;				// all KeyHi in this thread's elements OR'd
+	UINT64 AndKeyLo;			// all KeyLo in this thread's elements AND'd
+	UINT64 OrKeyLo;				// all KeyLo in this thread's elements OR'd
+	INT64 Counts[256];			// counts of each digit value in this thread's elements, then offsets at which these elements are to be scattered
+} tsRadixThreadPars;
+#pragma pack()
+
+class CMTRadixSort
+{
+	int m_MaxThreads;						// limit number of threads to be no more than this
+	int m_NumThreads;						// number of threads used in current sort
+	int m_CurDigit;							// current 8bit digit being sorted on, 0..7 are KeyLo, 8..15 are KeyHi
+	tsRadixEl *m_pSrcEls;					// scatter elements from here
+	tsRadixEl *m_pDstEls;					// into here
+	tsRadixThreadPars m_ThreadPars[cMaxRadixThreads];	// per thread parameters
+
+	void ProcessPhase(tsRadixThreadPars *pPars);	// process current phase over this thread's elements
+	void RunPhase(int Phase);				// run a phase over all threads and wait for completion
+
+#ifdef _WIN32
+	static unsigned int __stdcall _radix_start(void *args);
+#else
+	static void * _radix_start(void *args);
+#endif
+
+public:
+	CMTRadixSort(void);
+	~CMTRadixSort(void);
+
+	void SetMaxThreads(int MaxThreads);	// sets max number of threads, if 0 then resets to cMaxRadixThreads
+
+	tsRadixEl *								// returns ptr to whichever of pEls or pTmpEls now contains the sorted elements
+		Sort(INT64 NumEls,					// number of elements to be sorted
+			tsRadixEl *pEls,				// elements to be sorted
+			tsRadixEl *pTmpEls);			// caller allocated temp buffer for at least NumEls elements
+
+	static int BenchSortHits(INT64 NumHits,	// benchmark radix sort against multithreaded qsort on this many simulated read hit keys, eBSFerrInternal if either sort misorders
+							int NumThreads,	// sorting with this many threads
+							int Seed = 1);	// pseudo-random generator seed used when simulating read hits
+};
+
@@ -1383,7 +1383,9 @@ int										// create and initiate processing for SAM or BAM - with optional in
 CSAMfile::Create(eSAMFileType SAMType,	// file type, expected to be either eSFTSAM or eSFTBAM_BAI or eSFTBAM_CSI 
 				char *pszSAMFile,		// SAM(gz) or BAM file name
 				int ComprLev,			// if BAM then BGZF compress at this requested level (0..9)
-				char *pszVer)			// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				char *pszVer,			// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				bool bCoordSorted,		// false if alignments will not be added in coordinate sorted order
+				int NumThreads)			// if BAM then BGZF compress using this many threads
 {
 if(SAMType < eSFTSAM || SAMType > eSFTBAM_CSI || pszSAMFile == NULL || pszSAMFile[0] == '\0')
 	return(eBSFerrParams);
@@ -1510,6 +1512,12 @@ if(SAMType >= eSFTBAM)
 		return(eBSFerrMem);
 		}
 	m_hOutSAMfile = -1;
+	if(NumThreads > 1 && bgzf_mt(m_pBGZF,NumThreads,cBGZFSubBlks) != 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Create: unable to initialise for multithreaded BGZF compression (%d threads) on file '%s'",NumThreads,m_szSAMfileName);
+		Reset();
+		return(eBSFerrMem);
+		}
 	m_pBAM[0] = (UINT8)'B';
 	m_pBAM[1] = (UINT8)'A';
 	m_pBAM[2] = (UINT8)'M';
@@ -1518,7 +1526,7 @@ if(SAMType >= eSFTBAM)
 	}
 
 
-m_CurBAMLen += sprintf((char *)&m_pBAM[m_CurBAMLen],"@HD\tVN:1.4\tSO:coordinate");
+m_CurBAMLen += sprintf((char *)&m_pBAM[m_CurBAMLen],"@HD\tVN:1.4\tSO:%s",bCoordSorted ? "coordinate" : "unsorted");
 
 // initialisation completed
 return(eBSFSuccess);
@@ -1869,7 +1877,7 @@ if(m_NumBinsWithChunks > 0)
 			pBAIChunks = &m_pBAIChunks[pBAIbin->FirstChunk];
 			if(m_SAMFileType == eSFTBAM_CSI)
 				{
-				*(UINT64 *)pSAI = pBAIbin->StartVA;
+				*(UINT64 *)pSAI = bgzf_mt_voffset(m_pBGZF,pBAIbin->StartVA);
 				pSAI += 2;
 				m_CurBAILen += 8;
 				}
@@ -1877,9 +1885,9 @@ if(m_NumBinsWithChunks > 0)
 			m_CurBAILen += 4;
 			for(ChunkIdx =0;ChunkIdx < (int)pBAIbin->NumChunks;ChunkIdx++)
 				{
-				*(UINT64 *)pSAI = pBAIChunks->StartVA;
+				*(UINT64 *)pSAI = bgzf_mt_voffset(m_pBGZF,pBAIChunks->StartVA);
 				pSAI += 2;
-				*(UINT64 *)pSAI = pBAIChunks->EndVA;
+				*(UINT64 *)pSAI = bgzf_mt_voffset(m_pBGZF,pBAIChunks->EndVA);
 				pSAI += 2;
 				m_CurBAILen += 16;
 				pBAIChunks = &m_pBAIChunks[pBAIChunks->NextChunk];
@@ -1906,6 +1914,13 @@ if(m_NumBinsWithChunks > 0)
 		{
 		*pSAI++ = m_NumOf16Kbps;
 		m_CurBAILen += 4;
+		if(m_pBGZF->mt != NULL)			// if multithreaded BGZF then virtual addresses are relative to block sequence numbers
+			{
+			UINT32 KOfs;
+			for(KOfs = 0; KOfs < m_NumOf16Kbps; KOfs++)
+				if(m_p16KOfsVirtAddrs[KOfs] != 0)
+					m_p16KOfsVirtAddrs[KOfs] = bgzf_mt_voffset(m_pBGZF,m_p16KOfsVirtAddrs[KOfs]);
+			}
 		memcpy(pSAI,m_p16KOfsVirtAddrs,m_NumOf16Kbps * sizeof(UINT64));
 		pSAI += m_NumOf16Kbps * 2;
 		m_CurBAILen += m_NumOf16Kbps * sizeof(UINT64);
@@ -2556,6 +2571,28 @@ else   // BAM processing
 return(eBSFSuccess);
 }
 
+int
+CSAMfile::Flush(void)
+{
+if(m_SAMFileType != eSFTSAM && m_SAMFileType != eSFTSAMgz)
+	return(eBSFSuccess);
+if(m_CurBAMLen)
+	{
+	if(m_SAMFileType == eSFTSAM)
+		{
+		if(m_hOutSAMfile != -1)
+			CUtility::SafeWrite(m_hOutSAMfile,m_pBAM,m_CurBAMLen);
+		}
+	else
+		{
+		if(m_gzOutSAMfile != NULL)
+			CUtility::SafeWrite_gz(m_gzOutSAMfile,m_pBAM,m_CurBAMLen);
+		}
+	m_CurBAMLen = 0;
+	}
+return(eBSFSuccess);
+}
+
 int
 CSAMfile::Close(void)
 {
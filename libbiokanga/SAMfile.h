@@ -31,6 +31,7 @@ const size_t cMaxCSIRefSeqLen = 0x7fffffff; // CSI indexes have no inherient lim
 
 const int cMaxRptSAMSeqsThres = 10000;	// default number of chroms to report if SAM output
 const int cDfltComprLev = 6;			// default compression level if BAM output
+const int cBGZFSubBlks = 16;			// if multithreaded BAM compression then each thread compresses batches of this many BGZF blocks
 
 const size_t cAllocBAMSize = (size_t)0x003ffffff;	// initial allocation for  to hold BAM header which includes the sequence names + sequence lengths
 const size_t cAllocSAMSize = (size_t)0x01fffffff;	// initial allocation for holding SAM header and subsequently the alignments 
@@ -282,7 +283,9 @@ public:
 		Create(eSAMFileType SAMType,		// file type, expected to be either eSFTSAM or eSFTBAM_BAI or eSFTBAM_CSI 
 				char *pszSAMFile,			// SAM(gz) or BAM file name
 				int ComprLev = cDfltComprLev,	// if BAM then BGZF compress at this requested level (0..9)
-				char *pszVer = NULL);		// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				char *pszVer = NULL,		// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				bool bCoordSorted = true,	// false if alignments will not be added in coordinate sorted order
+				int NumThreads = 1);		// if BAM then BGZF compress using this many threads
 
 		// reference sequence names are expected to be presorted in seqname ascending alpha order and then AddRefSeq'd in that ascending order
 	int AddRefSeq(char *pszSpecies,			// sequence from this species
@@ -295,6 +298,8 @@ public:
 		AddAlignment(tsBAMalign *pBAMalign,  // alignment to report
 						bool bLastAligned = false);  // true if this is the last read which was aligned, may be more reads but these are non-aligned reads
 
+	int Flush(void);						// write out any buffered SAM alignments, BAM alignments are written as each BGZF block is completed
+
 	int Close(void);
 
 };
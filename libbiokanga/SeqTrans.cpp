@@ -12,6 +12,27 @@
 #include "./commhdrs.h"
 #endif
 
+// SSSE3/AVX2 translation kernels are only available on x86 targets, elsewhere the scalar kernels are used
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SEQTRANS_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _WIN32
+#include <intrin.h>
+#define SEQTRANS_TARGET_SSSE3
+#define SEQTRANS_TARGET_AVX2
+#else
+#define SEQTRANS_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define SEQTRANS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static void InitSeqTransKernels(void);				// selects translation kernels appropriate to the CPU
+static int (*gpAscii2Bases)(char *pAscii,int MaxLen,etSeqBase *pSeq,bool RptMskUpperCase) = NULL;
+static void (*gpComplementBases)(unsigned int SeqLen,etSeqBase *pSeq) = NULL;
+static void (*gpReverseBases)(unsigned int SeqLen,etSeqBase *pSeq) = NULL;
+static int (*gpPhredDecode)(UINT8 *pQScores,int Len,UINT8 *pPhreds,int Offset,int MaxPhred,int *pMinPhred,int *pNumOutOfRange,char *pFirstOutOfRange) = NULL;
+static void (*gpPackPhredBands)(etSeqBase *pSeq,UINT8 *pPhreds,int Len) = NULL;
+
 
 char CSeqTrans::MapBase2Ascii(etSeqBase Base,		// base to map 
 							char BaseN ,			// what to map eBaseN onto
@@ -458,10 +479,20 @@ void
 CSeqTrans::ComplementStrand(unsigned int SeqLen,
 							etSeqBase *pSeq)
 {
-etSeqBase Base;
-etSeqBase RptMskFlg;
 if(SeqLen < 1 || pSeq == NULL)
 	return;
+InitSeqTransKernels();
+gpComplementBases(SeqLen,pSeq);
+}
+
+// ComplementBasesScalar
+// Inplace complement, complementing terminates at the first base which is not one of A,C,G,T,N,InDel or Undef
+static void
+ComplementBasesScalar(unsigned int SeqLen,
+							etSeqBase *pSeq)
+{
+etSeqBase Base;
+etSeqBase RptMskFlg;
 while(SeqLen--)
 	{
 	Base = *pSeq;
@@ -485,19 +516,10 @@ while(SeqLen--)
 void
 CSeqTrans::ReverseSeq(unsigned int SeqLen,etSeqBase *pSeq)
 {
-etSeqBase *pExch;
-etSeqBase Tmp;
 if(SeqLen < 2 || pSeq == NULL)
 	return;
-pExch = pSeq + SeqLen-1;
-SeqLen >>= 1;
-
-while(SeqLen--)
-	{
-	Tmp = *pExch;
-	*pExch-- = *pSeq;
-	*pSeq++ = Tmp;
-	}
+InitSeqTransKernels();
+gpReverseBases(SeqLen,pSeq);
 }
 
 // ReverseComplement
@@ -507,8 +529,10 @@ CSeqTrans::ReverseComplement(unsigned int SeqLen,etSeqBase *pSeq)
 {
 if(SeqLen < 1 || pSeq == NULL)
 	return;
-ComplementStrand(SeqLen,pSeq);
-ReverseSeq(SeqLen,pSeq);
+InitSeqTransKernels();
+gpComplementBases(SeqLen,pSeq);
+if(SeqLen > 1)
+	gpReverseBases(SeqLen,pSeq);
 }
 
 // RemoveMasking
@@ -522,3 +546,605 @@ while(SeqLen--)
 	*pBases++ &= ~(cRptMskFlg | cMarkMskFlg);
 }
 
+
+// ReverseBasesScalar
+// Inplace sequence reversal
+static void
+ReverseBasesScalar(unsigned int SeqLen,etSeqBase *pSeq)
+{
+etSeqBase *pExch;
+etSeqBase Tmp;
+if(SeqLen < 2)
+	return;
+pExch = pSeq + SeqLen-1;
+SeqLen >>= 1;
+
+while(SeqLen--)
+	{
+	Tmp = *pExch;
+	*pExch-- = *pSeq;
+	*pSeq++ = Tmp;
+	}
+}
+
+// Ascii2BasesScalar
+// Translates ascii bases into etSeqBase until '\0' or MaxLen bases, lowercase (or uppercase if RptMskUpperCase) a,c,g,t,u are
+// flagged as softmasked repeats, '-' is an InDel and all other chars are translated as eBaseN
+static int
+Ascii2BasesScalar(char *pAscii,int MaxLen,etSeqBase *pSeq,bool RptMskUpperCase)
+{
+char Base;
+int SeqLen = 0;
+while(MaxLen-- && (Base = *pAscii++)!='\0')
+	{
+	SeqLen++;
+	switch(Base) {
+		case 'a':
+			*pSeq++ = eBaseA | (RptMskUpperCase ? 0 : cRptMskFlg);
+			continue;
+		case 'A':
+			*pSeq++ = eBaseA  | (RptMskUpperCase ? cRptMskFlg : 0);
+			continue;
+		case 'c':
+			*pSeq++ = eBaseC  | (RptMskUpperCase ? 0 : cRptMskFlg);
+			continue;
+		case 'C':
+			*pSeq++ =  eBaseC | (RptMskUpperCase ? cRptMskFlg : 0);
+			continue;
+		case 'g':
+			*pSeq++ =  eBaseG  | (RptMskUpperCase ? 0 : cRptMskFlg);
+			continue;
+		case 'G':
+			*pSeq++ =  eBaseG | (RptMskUpperCase ? cRptMskFlg : 0);
+			continue;
+		case 't': case 'u': 
+			*pSeq++ =  eBaseT  | (RptMskUpperCase ? 0 : cRptMskFlg);
+			continue;
+		case 'T': case 'U':
+			*pSeq++ =  eBaseT | (RptMskUpperCase ? cRptMskFlg : 0);
+			continue;
+
+		case '-':
+			*pSeq++ =  eBaseInDel;
+			continue;
+
+		default: // 'N'
+			*pSeq++ = eBaseN;
+			continue;
+		}
+	}
+return(SeqLen);
+}
+
+// PhredDecodeScalar
+// Decodes ascii quality scores into Phred scores clamped to be in range 0..MaxPhred
+static int
+PhredDecodeScalar(UINT8 *pQScores,int Len,UINT8 *pPhreds,int Offset,int MaxPhred,int *pMinPhred,int *pNumOutOfRange,char *pFirstOutOfRange)
+{
+int Phred;
+int SumPhreds;
+int MinPhred;
+int NumOutOfRange;
+SumPhreds = 0;
+MinPhred = Len > 0 ? 255 : 0;
+NumOutOfRange = 0;
+for(; Len > 0; Len--, pQScores++)
+	{
+	if(*pQScores < Offset || *pQScores > '}')
+		{
+		if(!NumOutOfRange++ && pFirstOutOfRange != NULL)
+			*pFirstOutOfRange = (char)*pQScores;
+		}
+	Phred = *pQScores < Offset ? 0 : (int)*pQScores - Offset;
+	if(Phred > MaxPhred)
+		Phred = MaxPhred;
+	if(pPhreds != NULL)
+		*pPhreds++ = (UINT8)Phred;
+	SumPhreds += Phred;
+	if(Phred < MinPhred)
+		MinPhred = Phred;
+	}
+if(pMinPhred != NULL)
+	*pMinPhred = MinPhred;
+if(pNumOutOfRange != NULL)
+	*pNumOutOfRange = NumOutOfRange;
+return(SumPhreds);
+}
+
+// PackPhredBandsScalar
+// Scales Phred scores 0..40 into bands 0..15 and packs the bands into bits 4..7 of the corresponding bases
+static void
+PackPhredBandsScalar(etSeqBase *pSeq,UINT8 *pPhreds,int Len)
+{
+UINT32 Phred;
+for(; Len > 0; Len--, pSeq++, pPhreds++)
+	{
+	if((Phred = *pPhreds) > 40)
+		Phred = 40;
+	*pSeq |= (etSeqBase)(((Phred + 2) * 15) / 40) << 4;
+	}
+}
+
+#ifdef SEQTRANS_SIMD_X86
+// Ascii2BasesSSSE3
+// Ascii chars are translated 16 at a time with the low nibble indexing into one of two 16 entry tables, the table being selected by bit 4,
+// which together cover the 32 letters 0x40..0x5f and 0x60..0x7f; bit 5 identifies lowercase
+static inline __m128i SEQTRANS_TARGET_SSSE3
+Xlate2BasesSSSE3(__m128i Chrs,__m128i MskCase)
+{
+const __m128i LoTab = _mm_setr_epi8(eBaseN,eBaseA,eBaseN,eBaseC,eBaseN,eBaseN,eBaseN,eBaseG,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN);
+const __m128i HiTab = _mm_setr_epi8(eBaseN,eBaseN,eBaseN,eBaseN,eBaseT,eBaseT,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN);
+__m128i Idx;
+__m128i Sel;
+__m128i Bases;
+__m128i Msk;
+__m128i Dash;
+__m128i Other;
+
+Idx = _mm_and_si128(Chrs,_mm_set1_epi8(0x0f));
+Sel = _mm_cmpeq_epi8(_mm_and_si128(Chrs,_mm_set1_epi8(0x10)),_mm_set1_epi8(0x10));
+Bases = _mm_or_si128(_mm_and_si128(Sel,_mm_shuffle_epi8(HiTab,Idx)),_mm_andnot_si128(Sel,_mm_shuffle_epi8(LoTab,Idx)));
+
+// canonical bases in the softmasked case are flagged as repeats
+Msk = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(Chrs,_mm_set1_epi8(0x20)),MskCase),_mm_cmpgt_epi8(_mm_set1_epi8(eBaseN),Bases));
+Bases = _mm_or_si128(Bases,_mm_and_si128(Msk,_mm_set1_epi8(cRptMskFlg)));
+
+// only chars 0x40..0x7f can be bases, '-' is an InDel, all other chars are N
+Sel = _mm_cmpeq_epi8(_mm_and_si128(Chrs,_mm_set1_epi8((char)0xc0)),_mm_set1_epi8(0x40));
+Dash = _mm_cmpeq_epi8(Chrs,_mm_set1_epi8('-'));
+Other = _mm_or_si128(_mm_and_si128(Dash,_mm_set1_epi8(eBaseInDel)),_mm_andnot_si128(Dash,_mm_set1_epi8(eBaseN)));
+return(_mm_or_si128(_mm_and_si128(Sel,Bases),_mm_andnot_si128(Sel,Other)));
+}
+
+static int SEQTRANS_TARGET_SSSE3
+Ascii2BasesSSSE3(char *pAscii,int MaxLen,etSeqBase *pSeq,bool RptMskUpperCase)
+{
+int Psn;
+__m128i Chrs;
+__m128i MskCase = _mm_set1_epi8(RptMskUpperCase ? 0 : 0x20);
+for(Psn = 0; Psn + 16 <= MaxLen; Psn += 16)
+	{
+	Chrs = _mm_loadu_si128((__m128i *)&pAscii[Psn]);
+	if(_mm_movemask_epi8(_mm_cmpeq_epi8(Chrs,_mm_setzero_si128())))	// '\0' terminator in these chars, scalar completes the translation
+		break;
+	_mm_storeu_si128((__m128i *)&pSeq[Psn],Xlate2BasesSSSE3(Chrs,MskCase));
+	}
+return(Psn + Ascii2BasesScalar(&pAscii[Psn],MaxLen - Psn,&pSeq[Psn],RptMskUpperCase));
+}
+
+// ComplementBasesSSSE3
+// Complements 16 bases at a time, any chunk containing a base other than A,C,G,T,N,InDel or Undef is left to the scalar kernel which terminates at that base
+static void SEQTRANS_TARGET_SSSE3
+ComplementBasesSSSE3(unsigned int SeqLen,etSeqBase *pSeq)
+{
+unsigned int Psn;
+__m128i Bases;
+const __m128i CplTab = _mm_setr_epi8(eBaseT,eBaseG,eBaseC,eBaseA,eBaseN,eBaseUndef,eBaseInDel,eBaseEOS,0,0,0,0,0,0,0,0);
+for(Psn = 0; Psn + 16 <= SeqLen; Psn += 16)
+	{
+	Bases = _mm_loadu_si128((__m128i *)&pSeq[Psn]);
+	if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(_mm_and_si128(Bases,_mm_set1_epi8((char)~(cRptMskFlg | cMarkMskFlg))),_mm_set1_epi8(eBaseEOS)),_mm_set1_epi8(eBaseEOS))))
+		break;
+	Bases = _mm_or_si128(_mm_and_si128(Bases,_mm_set1_epi8((char)0xf8)),_mm_shuffle_epi8(CplTab,_mm_and_si128(Bases,_mm_set1_epi8(0x07))));
+	_mm_storeu_si128((__m128i *)&pSeq[Psn],Bases);
+	}
+ComplementBasesScalar(SeqLen - Psn,&pSeq[Psn]);
+}
+
+// ReverseBasesSSSE3
+// Exchanges reversed 16 base chunks from each end until less than 32 bases remain in the middle, these are then reversed by the scalar kernel
+static void SEQTRANS_TARGET_SSSE3
+ReverseBasesSSSE3(unsigned int SeqLen,etSeqBase *pSeq)
+{
+etSeqBase *pLo;
+etSeqBase *pHi;
+__m128i Lo;
+__m128i Hi;
+const __m128i RevTab = _mm_setr_epi8(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0);
+pLo = pSeq;
+pHi = pSeq + SeqLen;
+while(pHi - pLo >= 32)
+	{
+	Lo = _mm_loadu_si128((__m128i *)pLo);
+	Hi = _mm_loadu_si128((__m128i *)(pHi - 16));
+	_mm_storeu_si128((__m128i *)pLo,_mm_shuffle_epi8(Hi,RevTab));
+	_mm_storeu_si128((__m128i *)(pHi - 16),_mm_shuffle_epi8(Lo,RevTab));
+	pLo += 16;
+	pHi -= 16;
+	}
+ReverseBasesScalar((unsigned int)(pHi - pLo),pLo);
+}
+
+static int SEQTRANS_TARGET_SSSE3
+PhredDecodeSSSE3(UINT8 *pQScores,int Len,UINT8 *pPhreds,int Offset,int MaxPhred,int *pMinPhred,int *pNumOutOfRange,char *pFirstOutOfRange)
+{
+int Psn;
+int Idx;
+int SumPhreds;
+int MinPhred;
+int NumOutOfRange;
+int TailMinPhred;
+int TailNumOutOfRange;
+UINT32 OutOfRange;
+UINT8 Mins[16];
+__m128i QScores;
+__m128i Phreds;
+__m128i Sums = _mm_setzero_si128();
+__m128i MinPhreds = _mm_set1_epi8((char)0xff);
+__m128i Offsets = _mm_set1_epi8((char)Offset);
+__m128i MaxPhreds = _mm_set1_epi8((char)MaxPhred);
+__m128i MaxQScores = _mm_set1_epi8('}');
+
+NumOutOfRange = 0;
+for(Psn = 0; Psn + 16 <= Len; Psn += 16)
+	{
+	QScores = _mm_loadu_si128((__m128i *)&pQScores[Psn]);
+	if(pNumOutOfRange != NULL)
+		{
+		OutOfRange = ~(UINT32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(QScores,Offsets),QScores),_mm_cmpeq_epi8(_mm_min_epu8(QScores,MaxQScores),QScores))) & 0x0ffff;
+		if(OutOfRange)
+			{
+			if(!NumOutOfRange && pFirstOutOfRange != NULL)
+				{
+				for(Idx = 0; !(OutOfRange & (1 << Idx)); Idx++);
+				*pFirstOutOfRange = (char)pQScores[Psn + Idx];
+				}
+			for(; OutOfRange; OutOfRange &= OutOfRange - 1)
+				NumOutOfRange += 1;
+			}
+		}
+	Phreds = _mm_min_epu8(_mm_subs_epu8(QScores,Offsets),MaxPhreds);
+	if(pPhreds != NULL)
+		_mm_storeu_si128((__m128i *)&pPhreds[Psn],Phreds);
+	Sums = _mm_add_epi64(Sums,_mm_sad_epu8(Phreds,_mm_setzero_si128()));
+	MinPhreds = _mm_min_epu8(MinPhreds,Phreds);
+	}
+SumPhreds = _mm_cvtsi128_si32(Sums) + _mm_cvtsi128_si32(_mm_srli_si128(Sums,8));
+MinPhred = 255;
+if(Psn > 0)
+	{
+	_mm_storeu_si128((__m128i *)Mins,MinPhreds);
+	for(Idx = 0; Idx < 16; Idx++)
+		if(Mins[Idx] < MinPhred)
+			MinPhred = Mins[Idx];
+	}
+if(Psn < Len)
+	{
+	SumPhreds += PhredDecodeScalar(&pQScores[Psn],Len - Psn,pPhreds == NULL ? NULL : &pPhreds[Psn],Offset,MaxPhred,&TailMinPhred,&TailNumOutOfRange,NumOutOfRange ? NULL : pFirstOutOfRange);
+	if(TailMinPhred < MinPhred)
+		MinPhred = TailMinPhred;
+	NumOutOfRange += TailNumOutOfRange;
+	}
+if(pMinPhred != NULL)
+	*pMinPhred = Len > 0 ? MinPhred : 0;
+if(pNumOutOfRange != NULL)
+	*pNumOutOfRange = NumOutOfRange;
+return(SumPhreds);
+}
+
+// PackPhredBandsSSSE3
+// ((Phred + 2) * 15) / 40 is exactly ((Phred + 2) * 3) / 8, so band << 4 is ((Phred + 2) * 6) & 0xf0 which for Phred <= 40 fits within 8 bits
+static void SEQTRANS_TARGET_SSSE3
+PackPhredBandsSSSE3(etSeqBase *pSeq,UINT8 *pPhreds,int Len)
+{
+int Psn;
+__m128i Phreds;
+__m128i Phreds3;
+for(Psn = 0; Psn + 16 <= Len; Psn += 16)
+	{
+	Phreds = _mm_add_epi8(_mm_min_epu8(_mm_loadu_si128((__m128i *)&pPhreds[Psn]),_mm_set1_epi8(40)),_mm_set1_epi8(2));
+	Phreds3 = _mm_add_epi8(_mm_add_epi8(Phreds,Phreds),Phreds);
+	_mm_storeu_si128((__m128i *)&pSeq[Psn],_mm_or_si128(_mm_loadu_si128((__m128i *)&pSeq[Psn]),_mm_and_si128(_mm_add_epi8(Phreds3,Phreds3),_mm_set1_epi8((char)0xf0))));
+	}
+PackPhredBandsScalar(&pSeq[Psn],&pPhreds[Psn],Len - Psn);
+}
+
+// AVX2 kernels process 32 at a time using the same in-lane table lookups as the SSSE3 kernels, these then process any remainder
+static int SEQTRANS_TARGET_AVX2
+Ascii2BasesAVX2(char *pAscii,int MaxLen,etSeqBase *pSeq,bool RptMskUpperCase)
+{
+int Psn;
+__m256i Chrs;
+__m256i Idx;
+__m256i Sel;
+__m256i Bases;
+__m256i Msk;
+__m256i Dash;
+__m256i Other;
+const __m256i LoTab = _mm256_setr_epi8(eBaseN,eBaseA,eBaseN,eBaseC,eBaseN,eBaseN,eBaseN,eBaseG,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,
+									   eBaseN,eBaseA,eBaseN,eBaseC,eBaseN,eBaseN,eBaseN,eBaseG,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN);
+const __m256i HiTab = _mm256_setr_epi8(eBaseN,eBaseN,eBaseN,eBaseN,eBaseT,eBaseT,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,
+									   eBaseN,eBaseN,eBaseN,eBaseN,eBaseT,eBaseT,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN,eBaseN);
+__m256i MskCase = _mm256_set1_epi8(RptMskUpperCase ? 0 : 0x20);
+for(Psn = 0; Psn + 32 <= MaxLen; Psn += 32)
+	{
+	Chrs = _mm256_loadu_si256((__m256i *)&pAscii[Psn]);
+	if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(Chrs,_mm256_setzero_si256())))
+		break;
+	Idx = _mm256_and_si256(Chrs,_mm256_set1_epi8(0x0f));
+	Sel = _mm256_cmpeq_epi8(_mm256_and_si256(Chrs,_mm256_set1_epi8(0x10)),_mm256_set1_epi8(0x10));
+	Bases = _mm256_blendv_epi8(_mm256_shuffle_epi8(LoTab,Idx),_mm256_shuffle_epi8(HiTab,Idx),Sel);
+	Msk = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(Chrs,_mm256_set1_epi8(0x20)),MskCase),_mm256_cmpgt_epi8(_mm256_set1_epi8(eBaseN),Bases));
+	Bases = _mm256_or_si256(Bases,_mm256_and_si256(Msk,_mm256_set1_epi8(cRptMskFlg)));
+	Sel = _mm256_cmpeq_epi8(_mm256_and_si256(Chrs,_mm256_set1_epi8((char)0xc0)),_mm256_set1_epi8(0x40));
+	Dash = _mm256_cmpeq_epi8(Chrs,_mm256_set1_epi8('-'));
+	Other = _mm256_blendv_epi8(_mm256_set1_epi8(eBaseN),_mm256_set1_epi8(eBaseInDel),Dash);
+	_mm256_storeu_si256((__m256i *)&pSeq[Psn],_mm256_blendv_epi8(Other,Bases,Sel));
+	}
+return(Psn + Ascii2BasesSSSE3(&pAscii[Psn],MaxLen - Psn,&pSeq[Psn],RptMskUpperCase));
+}
+
+static void SEQTRANS_TARGET_AVX2
+ComplementBasesAVX2(unsigned int SeqLen,etSeqBase *pSeq)
+{
+unsigned int Psn;
+__m256i Bases;
+const __m256i CplTab = _mm256_setr_epi8(eBaseT,eBaseG,eBaseC,eBaseA,eBaseN,eBaseUndef,eBaseInDel,eBaseEOS,0,0,0,0,0,0,0,0,
+										eBaseT,eBaseG,eBaseC,eBaseA,eBaseN,eBaseUndef,eBaseInDel,eBaseEOS,0,0,0,0,0,0,0,0);
+for(Psn = 0; Psn + 32 <= SeqLen; Psn += 32)
+	{
+	Bases = _mm256_loadu_si256((__m256i *)&pSeq[Psn]);
+	if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_and_si256(Bases,_mm256_set1_epi8((char)~(cRptMskFlg | cMarkMskFlg))),_mm256_set1_epi8(eBaseEOS)),_mm256_set1_epi8(eBaseEOS))))
+		break;
+	Bases = _mm256_or_si256(_mm256_and_si256(Bases,_mm256_set1_epi8((char)0xf8)),_mm256_shuffle_epi8(CplTab,_mm256_and_si256(Bases,_mm256_set1_epi8(0x07))));
+	_mm256_storeu_si256((__m256i *)&pSeq[Psn],Bases);
+	}
+ComplementBasesSSSE3(SeqLen - Psn,&pSeq[Psn]);
+}
+
+static void SEQTRANS_TARGET_AVX2
+ReverseBasesAVX2(unsigned int SeqLen,etSeqBase *pSeq)
+{
+etSeqBase *pLo;
+etSeqBase *pHi;
+__m256i Lo;
+__m256i Hi;
+const __m256i RevTab = _mm256_setr_epi8(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0);
+pLo = pSeq;
+pHi = pSeq + SeqLen;
+while(pHi - pLo >= 64)
+	{
+	Lo = _mm256_loadu_si256((__m256i *)pLo);
+	Hi = _mm256_loadu_si256((__m256i *)(pHi - 32));
+	_mm256_storeu_si256((__m256i *)pLo,_mm256_permute4x64_epi64(_mm256_shuffle_epi8(Hi,RevTab),0x4e));
+	_mm256_storeu_si256((__m256i *)(pHi - 32),_mm256_permute4x64_epi64(_mm256_shuffle_epi8(Lo,RevTab),0x4e));
+	pLo += 32;
+	pHi -= 32;
+	}
+ReverseBasesSSSE3((unsigned int)(pHi - pLo),pLo);
+}
+
+static int SEQTRANS_TARGET_AVX2
+PhredDecodeAVX2(UINT8 *pQScores,int Len,UINT8 *pPhreds,int Offset,int MaxPhred,int *pMinPhred,int *pNumOutOfRange,char *pFirstOutOfRange)
+{
+int Psn;
+int Idx;
+int SumPhreds;
+int MinPhred;
+int NumOutOfRange;
+int TailMinPhred;
+int TailNumOutOfRange;
+UINT32 OutOfRange;
+UINT8 Mins[32];
+INT64 Sums4[4];
+__m256i QScores;
+__m256i Phreds;
+__m256i Sums = _mm256_setzero_si256();
+__m256i MinPhreds = _mm256_set1_epi8((char)0xff);
+__m256i Offsets = _mm256_set1_epi8((char)Offset);
+__m256i MaxPhreds = _mm256_set1_epi8((char)MaxPhred);
+__m256i MaxQScores = _mm256_set1_epi8('}');
+
+NumOutOfRange = 0;
+for(Psn = 0; Psn + 32 <= Len; Psn += 32)
+	{
+	QScores = _mm256_loadu_si256((__m256i *)&pQScores[Psn]);
+	if(pNumOutOfRange != NULL)
+		{
+		OutOfRange = ~(UINT32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(QScores,Offsets),QScores),_mm256_cmpeq_epi8(_mm256_min_epu8(QScores,MaxQScores),QScores)));
+		if(OutOfRange)
+			{
+			if(!NumOutOfRange && pFirstOutOfRange != NULL)
+				{
+				for(Idx = 0; !(OutOfRange & ((UINT32)1 << Idx)); Idx++);
+				*pFirstOutOfRange = (char)pQScores[Psn + Idx];
+				}
+			for(; OutOfRange; OutOfRange &= OutOfRange - 1)
+				NumOutOfRange += 1;
+			}
+		}
+	Phreds = _mm256_min_epu8(_mm256_subs_epu8(QScores,Offsets),MaxPhreds);
+	if(pPhreds != NULL)
+		_mm256_storeu_si256((__m256i *)&pPhreds[Psn],Phreds);
+	Sums = _mm256_add_epi64(Sums,_mm256_sad_epu8(Phreds,_mm256_setzero_si256()));
+	MinPhreds = _mm256_min_epu8(MinPhreds,Phreds);
+	}
+_mm256_storeu_si256((__m256i *)Sums4,Sums);
+SumPhreds = (int)(Sums4[0] + Sums4[1] + Sums4[2] + Sums4[3]);
+MinPhred = 255;
+if(Psn > 0)
+	{
+	_mm256_storeu_si256((__m256i *)Mins,MinPhreds);
+	for(Idx = 0; Idx < 32; Idx++)
+		if(Mins[Idx] < MinPhred)
+			MinPhred = Mins[Idx];
+	}
+if(Psn < Len)
+	{
+	SumPhreds += PhredDecodeSSSE3(&pQScores[Psn],Len - Psn,pPhreds == NULL ? NULL : &pPhreds[Psn],Offset,MaxPhred,&TailMinPhred,pNumOutOfRange == NULL ? NULL : &TailNumOutOfRange,NumOutOfRange ? NULL : pFirstOutOfRange);
+	if(TailMinPhred < MinPhred)
+		MinPhred = TailMinPhred;
+	if(pNumOutOfRange != NULL)
+		NumOutOfRange += TailNumOutOfRange;
+	}
+if(pMinPhred != NULL)
+	*pMinPhred = Len > 0 ? MinPhred : 0;
+if(pNumOutOfRange != NULL)
+	*pNumOutOfRange = NumOutOfRange;
+return(SumPhreds);
+}
+
+static void SEQTRANS_TARGET_AVX2
+PackPhredBandsAVX2(etSeqBase *pSeq,UINT8 *pPhreds,int Len)
+{
+int Psn;
+__m256i Phreds;
+__m256i Phreds3;
+for(Psn = 0; Psn + 32 <= Len; Psn += 32)
+	{
+	Phreds = _mm256_add_epi8(_mm256_min_epu8(_mm256_loadu_si256((__m256i *)&pPhreds[Psn]),_mm256_set1_epi8(40)),_mm256_set1_epi8(2));
+	Phreds3 = _mm256_add_epi8(_mm256_add_epi8(Phreds,Phreds),Phreds);
+	_mm256_storeu_si256((__m256i *)&pSeq[Psn],_mm256_or_si256(_mm256_loadu_si256((__m256i *)&pSeq[Psn]),_mm256_and_si256(_mm256_add_epi8(Phreds3,Phreds3),_mm256_set1_epi8((char)0xf0))));
+	}
+PackPhredBandsSSSE3(&pSeq[Psn],&pPhreds[Psn],Len - Psn);
+}
+
+// HasAVX2
+// Returns true if both CPU and OS support AVX2
+static bool
+HasAVX2(void)
+{
+#ifdef _WIN32
+int CPUInfo[4];
+__cpuid(CPUInfo,0);
+if(CPUInfo[0] < 7)
+	return(false);
+__cpuid(CPUInfo,1);
+if((CPUInfo[2] & (1 << 27)) == 0 || (CPUInfo[2] & (1 << 28)) == 0)	// OSXSAVE and AVX
+	return(false);
+if((_xgetbv(0) & 0x06) != 0x06)										// OS saves XMM and YMM state
+	return(false);
+__cpuidex(CPUInfo,7,0);
+return((CPUInfo[1] & (1 << 5)) != 0 ? true : false);
+#else
+__builtin_cpu_init();
+return(__builtin_cpu_supports("avx2") ? true : false);
+#endif
+}
+
+// HasSSSE3
+// Returns true if CPU supports SSSE3
+static bool
+HasSSSE3(void)
+{
+#ifdef _WIN32
+int CPUInfo[4];
+__cpuid(CPUInfo,1);
+return((CPUInfo[2] & (1 << 9)) != 0 ? true : false);
+#else
+__builtin_cpu_init();
+return(__builtin_cpu_supports("ssse3") ? true : false);
+#endif
+}
+#endif
+
+// SelectSeqTransKernels
+// Selects the translation kernels most appropriate for the executing CPU, only ever called through InitSeqTransKernels
+static void
+SelectSeqTransKernels(void)
+{
+#ifdef SEQTRANS_SIMD_X86
+if(HasAVX2())
+	{
+	gpComplementBases = ComplementBasesAVX2;
+	gpReverseBases = ReverseBasesAVX2;
+	gpPhredDecode = PhredDecodeAVX2;
+	gpPackPhredBands = PackPhredBandsAVX2;
+	gpAscii2Bases = Ascii2BasesAVX2;
+	return;
+	}
+if(HasSSSE3())
+	{
+	gpComplementBases = ComplementBasesSSSE3;
+	gpReverseBases = ReverseBasesSSSE3;
+	gpPhredDecode = PhredDecodeSSSE3;
+	gpPackPhredBands = PackPhredBandsSSSE3;
+	gpAscii2Bases = Ascii2BasesSSSE3;
+	return;
+	}
+#endif
+gpComplementBases = ComplementBasesScalar;
+gpReverseBases = ReverseBasesScalar;
+gpPhredDecode = PhredDecodeScalar;
+gpPackPhredBands = PackPhredBandsScalar;
+gpAscii2Bases = Ascii2BasesScalar;
+}
+
+#ifdef _WIN32
+static INIT_ONCE gSeqTransKernelsOnce = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK
+SelectSeqTransKernelsOnce(PINIT_ONCE pInitOnce,PVOID pParam,PVOID *ppContext)
+{
+SelectSeqTransKernels();
+return(TRUE);
+}
+#else
+static pthread_once_t gSeqTransKernelsOnce = PTHREAD_ONCE_INIT;
+#endif
+
+// InitSeqTransKernels
+// Selects, once only, the translation kernels; callers may be on multiple threads so selection is serialised and other callers wait until it has completed
+static void
+InitSeqTransKernels(void)
+{
+#ifdef _WIN32
+InitOnceExecuteOnce(&gSeqTransKernelsOnce,SelectSeqTransKernelsOnce,NULL,NULL);
+#else
+pthread_once(&gSeqTransKernelsOnce,SelectSeqTransKernels);
+#endif
+}
+
+const char *
+CSeqTrans::GetKernelName(void)		// returns name of the kernels selected for this CPU
+{
+InitSeqTransKernels();
+#ifdef SEQTRANS_SIMD_X86
+if(gpAscii2Bases == Ascii2BasesAVX2)
+	return("AVX2");
+if(gpAscii2Bases == Ascii2BasesSSSE3)
+	return("SSSE3");
+#endif
+return("scalar");
+}
+
+// Ascii2Bases
+// Translates ascii bases into etSeqBase until '\0' or MaxLen bases
+int
+CSeqTrans::Ascii2Bases(char *pAscii,int MaxLen,etSeqBase *pSeq,bool RptMskUpperCase)
+{
+if(pAscii == NULL || pSeq == NULL || MaxLen <= 0)
+	return(0);
+InitSeqTransKernels();
+return(gpAscii2Bases(pAscii,MaxLen,pSeq,RptMskUpperCase));
+}
+
+// PhredDecode
+// Decodes ascii quality scores into Phred scores, scores below Offset are decoded as 0 and scores are clamped to be no more than MaxPhred
+int
+CSeqTrans::PhredDecode(UINT8 *pQScores,int Len,UINT8 *pPhreds,int Offset,int MaxPhred,int *pMinPhred,int *pNumOutOfRange,char *pFirstOutOfRange)
+{
+if(pQScores == NULL || Len <= 0)
+	{
+	if(pMinPhred != NULL)
+		*pMinPhred = 0;
+	if(pNumOutOfRange != NULL)
+		*pNumOutOfRange = 0;
+	return(0);
+	}
+if(MaxPhred > 255)
+	MaxPhred = 255;
+InitSeqTransKernels();
+return(gpPhredDecode(pQScores,Len,pPhreds,Offset,MaxPhred,pMinPhred,pNumOutOfRange,pFirstOutOfRange));
+}
+
+// PackPhredBands
+// Scales Phred scores 0..40 into bands 0..15, ((Phred + 2) * 15) / 40, and packs these bands into bits 4..7 of the corresponding bases
+void
+CSeqTrans::PackPhredBands(etSeqBase *pSeq,UINT8 *pPhreds,int Len)
+{
+if(pSeq == NULL || pPhreds == NULL || Len <= 0)
+	return;
+InitSeqTransKernels();
+gpPackPhredBands(pSeq,pPhreds,Len);
+}
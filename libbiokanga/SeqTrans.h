@@ -47,4 +47,27 @@ public:
 	static void ReverseSeq(unsigned int SeqLen,etSeqBase *pSeq);
 	static	void ComplementStrand(unsigned int SeqLen,etSeqBase *pSeq);
 	static void RemoveMasking(etSeqBase *pBases,int SeqLen);
+
+	// following kernels are vectorised (SSSE3 or AVX2 as supported by the executing CPU) with scalar fallbacks
+	static const char *GetKernelName(void);			// returns name of the kernels selected for this CPU
+
+	static int										// returns number of bases translated
+		Ascii2Bases(char *pAscii,					// ascii bases, translation terminates at '\0' or after MaxLen bases
+					int MaxLen,						// translate at most this many bases
+					etSeqBase *pSeq,				// where to return translated bases, can be same as pAscii for inplace translation
+					bool RptMskUpperCase=false);	// true if bases are softmasked as uppercase instead of default lowercase
+
+	static int										// returns sum of decoded Phred scores
+		PhredDecode(UINT8 *pQScores,				// ascii quality scores
+					int Len,						// number of quality scores
+					UINT8 *pPhreds,					// where to return Phred scores, can be same as pQScores, or NULL if only the sum/min/out of range are of interest
+					int Offset,						// ascii offset of Phred 0, typically 33 (Sanger, Illumina 1.8+) or 64 (Illumina 1.3+); scores below Offset are decoded as 0
+					int MaxPhred,					// clamp decoded Phred scores to be no more than this
+					int *pMinPhred = NULL,			// optionally returned minimum decoded Phred score
+					int *pNumOutOfRange = NULL,		// optionally returned number of quality scores below Offset or above '}'
+					char *pFirstOutOfRange = NULL);	// optionally returned first ascii quality score which was out of range
+
+	static void PackPhredBands(etSeqBase *pSeq,		// bases into which quality bands are to be packed into bits 4..7
+					UINT8 *pPhreds,					// Phred scores, expected to be in range 0..40
+					int Len);						// number of bases
 };
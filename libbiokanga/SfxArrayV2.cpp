@@ -19,6 +19,22 @@
 
 #include "./SfxArrayV2.h"
 
+// SSE2/AVX2 probe vs target compare kernels are only available on x86 targets, elsewhere the scalar kernels are used
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SFX_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _WIN32
+#include <intrin.h>
+#define SFX_TARGET_AVX2
+#else
+#define SFX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static void InitCmpKernels(void);							// selects probe vs target compare kernels appropriate to the CPU
+static int (*gpCmpProbeTarg)(etSeqBase *pEl1,etSeqBase *pEl2,int Len) = NULL;	// selected CmpProbeTarg kernel
+static int (*gpProbeTargMMs)(etSeqBase *pProbe,etSeqBase *pTarg,int Len) = NULL;	// selected mismatch counting kernel
+
 static int gMaxBaseCmpLen = (5 * cMaxReadLen);   // used to limit the number of bases being compared for length in QSortSeqCmp32() and QSortSeqCmp40()
 static int QSortSeqCmp32(const void *p1,const void *p2);
 static int QSortSeqCmp40(const void *p1,const void *p2);
@@ -49,10 +65,13 @@ CSfxArrayV3::CSfxArrayV3(void)
 {
 m_pEntriesBlock = NULL;
 m_pSfxBlock = NULL;
+m_pMappedSfxFile = NULL;
+m_MappedSfxFileLen = 0;
 m_pBisulfateBases = NULL;
 m_pOccKMerClas = NULL;
 m_hFile = -1;
 m_bThreadActive = false;
+m_bSfxBlockResident = false;
 m_AllocSfxBlockMem = 0;
 m_AllocEntriesBlockMem = 0;
 m_AllocSfxBlockMem = 0;
@@ -62,9 +81,30 @@ m_MaxIter = cDfltMaxIter;
 m_bInMemSfx = false;
 m_MaxQSortThreads = cDfltSortThreads;
 m_MTqsort.SetMaxThreads(m_MaxQSortThreads);
+m_SfxSortMode = eSfxSortQSort;
+m_ReqKMerIdxLen = 0;
+m_KMerIdxLen = 0;
+m_AllocKMerIdxMem = 0;
+m_pKMerIdx = NULL;
+m_KMerIdxLookups = 0;
+m_KMerIdxHits = 0;
+m_bReqPackedSeq = false;
+m_ReqSfxSampleRate = 1;
+m_SfxSampleRate = 1;
+m_PackedSeqLen = 0;
+m_AllocPackedSeqMem = 0;
+m_pPackedSeq = NULL;
+m_AllocSeqRunsMem = 0;
+m_NumNRuns = 0;
+m_pNRuns = NULL;
+m_NumMaskRuns = 0;
+m_pMaskRuns = NULL;
+m_AllocPackedExceptMem = 0;
+m_pPackedExcept = NULL;
 m_MaxSfxBlockEls = cMaxAllowConcatSeqLen;
 m_CASSeqFlags = 0;
 gMaxBaseCmpLen = (5 * cMaxReadLen);
+InitCmpKernels();
 
 #ifdef _WIN32
 m_threadID = 0;
@@ -97,7 +137,12 @@ if(m_bThreadActive)	// if processing reads against sfx blocks then need to termi
 #endif
 	}
 
-if(m_pSfxBlock != NULL)
+DeleteKMerIdx();
+DeletePackedSeq();
+
+if(m_pMappedSfxFile != NULL)
+	UnmapSfxFile();
+else if(m_pSfxBlock != NULL)
 	{
 #ifdef _WIN32
 	free(m_pSfxBlock);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
@@ -182,7 +227,12 @@ if(m_hFile != -1)
 
 memset(&m_SfxHeader,0,sizeof(m_SfxHeader));
 
-if(m_pSfxBlock != NULL)
+DeleteKMerIdx();
+DeletePackedSeq();
+
+if(m_pMappedSfxFile != NULL)
+	UnmapSfxFile();
+else if(m_pSfxBlock != NULL)
 	{
 #ifdef _WIN32
 	free(m_pSfxBlock);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
@@ -225,11 +275,14 @@ if(m_pOccKMerClas != NULL)
 #endif
 	m_pOccKMerClas = NULL;
 	}
+m_KMerIdxLookups = 0;
+m_KMerIdxHits = 0;
 m_CASSeqFlags = 0;
 m_AllocEntriesBlockMem = 0;
 m_AllocSfxBlockMem = 0;
 m_AllocBisulfiteMem = 0;
 m_bTermThread = false;
+m_bSfxBlockResident = false;
 m_ReqBlockRslt = eBSFSuccess;
 m_ReqBlockID = 0;
 m_szFile[0] = '\0';
@@ -244,6 +297,7 @@ m_MaxMMExploreInDel = cMaxMMExploreInDel;
 m_MaxInDelLen = cMaxMicroInDelLen;
 m_MinInDelSeqLen = cMinInDelSeqLen;
 m_MaxSfxBlockEls = cMaxAllowConcatSeqLen;
+m_SfxSampleRate = 1;
 m_MaxKMerOccs = 0;
 m_AllocOccKMerClasMem = 0;
 m_OccKMerLen = 0;
@@ -257,6 +311,121 @@ CSfxArrayV3::SetMaxQSortThreads(int MaxThreads)			// sets maximum number of thre
 m_MTqsort.SetMaxThreads(MaxThreads);
 }
 
+void
+CSfxArrayV3::SetSfxSortMode(etSfxSortMode SortMode)		// sets method used to construct suffix array when finalising
+{
+m_SfxSortMode = SortMode;
+}
+
+int						// returns the k-mer prefix index length which will be generated, 0 if none
+CSfxArrayV3::SetKMerIdxLen(int KMerIdxLen)		// when finalising generate a k-mer prefix index over k-mers of this length (0 to disable, else cMinKMerIdxLen..cMaxKMerIdxLen)
+{
+if(KMerIdxLen <= 0)
+	KMerIdxLen = 0;
+else
+	{
+	if(KMerIdxLen < cMinKMerIdxLen)
+		KMerIdxLen = cMinKMerIdxLen;
+	else
+		if(KMerIdxLen > cMaxKMerIdxLen)
+			KMerIdxLen = cMaxKMerIdxLen;
+	}
+m_ReqKMerIdxLen = KMerIdxLen;
+return(m_ReqKMerIdxLen);
+}
+
+bool						// returns true if a 2bit packed sequence will be generated
+CSfxArrayV3::SetMMScanAccel(bool bMMScanAccel)	// when finalising generate the mismatch scan accelerator, an additional 2bit packed copy of the concatenated sequence
+{
+m_bReqPackedSeq = bMMScanAccel;
+return(m_bReqPackedSeq);
+}
+
+bool
+CSfxArrayV3::IsMMScanAccel(void)				// returns true if mismatch scan accelerator (2bit packed sequence) loaded
+{
+return(m_pPackedSeq != NULL && m_pPackedExcept != NULL && m_PackedSeqLen > 0);
+}
+
+int						// returns the suffix sampling rate which will be used
+CSfxArrayV3::SetSfxSampleRate(int SampleRate)	// when finalising retain only suffixes starting at loci which are multiples of SampleRate (1 retains all suffixes, max cMaxSfxSampleRate)
+{
+if(SampleRate < 1)
+	SampleRate = 1;
+else
+	if(SampleRate > cMaxSfxSampleRate)
+		SampleRate = cMaxSfxSampleRate;
+m_ReqSfxSampleRate = SampleRate;
+return(m_ReqSfxSampleRate);
+}
+
+int
+CSfxArrayV3::GetSfxSampleRate(void)				// returns suffix sampling rate of loaded suffix array, 1 if all suffixes retained
+{
+return((int)m_SfxSampleRate);
+}
+
+// GetNumSfxEls
+// Returns number of elements in the loaded suffix array, if sampled then only suffixes starting at loci which are multiples of the sample rate are present
+INT64
+CSfxArrayV3::GetNumSfxEls(void)
+{
+if(m_pSfxBlock == NULL)
+	return(0);
+return(((INT64)m_pSfxBlock->ConcatSeqLen + m_SfxSampleRate - 1) / m_SfxSampleRate);
+}
+
+// SampleSfxArray
+// Compacts the sorted suffix array in place retaining only those suffixes starting at loci which are multiples of SampleRate
+// Relative ordering is unchanged so the compacted suffix array remains sorted
+void
+CSfxArrayV3::SampleSfxArray(int SampleRate)
+{
+INT64 SfxIdx;
+INT64 NumRetained;
+INT64 Loci;
+int SfxElSize;
+UINT8 *pSfxArray;
+UINT8 *pEl;
+
+m_SfxSampleRate = 1;
+if(m_pSfxBlock == NULL || SampleRate <= 1)
+	return;
+SfxElSize = m_pSfxBlock->SfxElSize;
+pSfxArray = &m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
+NumRetained = 0;
+for(SfxIdx = 0; SfxIdx < (INT64)m_pSfxBlock->ConcatSeqLen; SfxIdx++)
+	{
+	Loci = SfxOfsToLoci(SfxElSize,pSfxArray,SfxIdx);
+	if(Loci % SampleRate)
+		continue;
+	pEl = &pSfxArray[NumRetained++ * SfxElSize];
+	*(UINT32 *)pEl = (UINT32)(Loci & 0x0ffffffff);
+	if(SfxElSize == 5)
+		pEl[4] = (UINT8)((Loci >> 32) & 0x00ff);
+	}
+m_SfxSampleRate = SampleRate;
+m_SfxHeader.SfxSampleRate = SampleRate;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"SampleSfxArray: retained %lld of %lld suffixes, sampling every %d loci",NumRetained,(INT64)m_pSfxBlock->ConcatSeqLen,SampleRate);
+}
+
+int
+CSfxArrayV3::GetKMerIdxLen(void)				// returns length of k-mers in loaded k-mer prefix index, 0 if no k-mer prefix index
+{
+return(m_pKMerIdx == NULL ? 0 : m_KMerIdxLen);
+}
+
+int										// returns length of k-mers in loaded k-mer prefix index, 0 if no k-mer prefix index
+CSfxArrayV3::GetKMerIdxStats(UINT64 *pLookups,	// returned number of exact match lookups which were candidates for the k-mer prefix index
+						UINT64 *pHits)		// returned number of these lookups narrowed through the k-mer prefix index
+{
+if(pLookups != NULL)
+	*pLookups = m_KMerIdxLookups;
+if(pHits != NULL)
+	*pHits = m_KMerIdxHits;
+return(GetKMerIdxLen());
+}
+
 int						// returns the previously utilised MaxBaseCmpLen
 CSfxArrayV3::SetMaxBaseCmpLen(int MaxBaseCmpLen)		// sets maximum number of bases which need to be compared for equality in multithreaded qsorts, will be clamped to be in range 10..(5*cMaxReadLen)
 {
@@ -286,7 +455,7 @@ memset(&m_SfxHeader,0,sizeof(tsSfxHeaderV3));
 m_SfxHeader.Magic[0] = 's';
 m_SfxHeader.Magic[1] = 'f';
 m_SfxHeader.Magic[2] = 'x';
-m_SfxHeader.Magic[3] = '5';
+m_SfxHeader.Magic[3] = '8';
 m_SfxHeader.Version = cSFXVersion;	        // file structure version
 m_SfxHeader.FileLen = sizeof(tsSfxHeaderV3);	// current file length (nxt write psn)
 m_SfxHeader.szDatasetName[0] = '\0';
@@ -455,23 +624,39 @@ if(m_bBisulfite)
 		TransformToColorspace(m_pSfxBlock->SeqSuffix,m_pSfxBlock->ConcatSeqLen,m_pSfxBlock->SeqSuffix);
 		}
 
-	QSortSeq((INT64)m_pSfxBlock->ConcatSeqLen,m_pBisulfateBases,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen]);
+	pBases = m_pBisulfateBases;
 	}
 else
 	{
 	if(m_bColorspace)
 		TransformToColorspace(m_pSfxBlock->SeqSuffix,m_pSfxBlock->ConcatSeqLen,m_pSfxBlock->SeqSuffix);
-	QSortSeq(m_pSfxBlock->ConcatSeqLen,m_pSfxBlock->SeqSuffix,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen]);
+	pBases = m_pSfxBlock->SeqSuffix;
 	}
 
+// if requested then try induced sorting, falling back to the multithreaded qsort if SA-IS was unable to allocate working memory
+if(m_SfxSortMode != eSfxSortSAIS || SAISSortSeq((INT64)m_pSfxBlock->ConcatSeqLen,pBases,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen]) < 0)
+	QSortSeq((INT64)m_pSfxBlock->ConcatSeqLen,pBases,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen]);
+
 if (m_bColorspace)	// set hi nibbles of sequence to be original sequence
 	TransformToBasespace(m_pSfxBlock->SeqSuffix, m_pSfxBlock->ConcatSeqLen, m_pSfxBlock->SeqSuffix, true);
 
+// sampling is only supported in basespace as colorspace and bisulfite processing compare against differently transformed sequences
+if(m_ReqSfxSampleRate > 1 && !m_bBisulfite && !m_bColorspace)
+	SampleSfxArray(m_ReqSfxSampleRate);
+
+// with suffixes now sorted the k-mer prefix index, if requested, can be generated
+if(m_ReqKMerIdxLen > 0 && !m_bBisulfite)
+	GenKMerIdx();
+
+// packed sequence is only used for basespace mismatch counting so not generated for bisulfite or colorspace
+if(m_bReqPackedSeq && !m_bBisulfite && !m_bColorspace)
+	GenPackedSeq();
+
 if (!m_bInMemSfx)
 	{
 	// set block size and file offset for suffix block into header
 	m_SfxHeader.NumSfxBlocks = 1;
-	m_SfxHeader.SfxBlockSize = sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen - 1 + ((size_t)m_pSfxBlock->ConcatSeqLen * m_pSfxBlock->SfxElSize);
+	m_SfxHeader.SfxBlockSize = sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen - 1 + ((size_t)GetNumSfxEls() * m_pSfxBlock->SfxElSize);
 	m_SfxHeader.SfxBlockOfs = m_SfxHeader.FileLen;
 
 	// now write...
@@ -485,7 +670,7 @@ if (!m_bInMemSfx)
 
 	m_SfxHeader.FileLen += WrtLen;
 
-	WrtLen = (INT64)m_pSfxBlock->SfxElSize * m_pSfxBlock->ConcatSeqLen;
+	WrtLen = (INT64)m_pSfxBlock->SfxElSize * GetNumSfxEls();
 	if((Rslt=ChunkedWrite(m_SfxHeader.FileLen,(UINT8 *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen],WrtLen))!=eBSFSuccess)
 		{
 		AddErrMsg("CSfxArrayV3::SfxBlock2Disk","Unable to write suffix block array to disk");
@@ -494,6 +679,12 @@ if (!m_bInMemSfx)
 		}
 	m_SfxHeader.FileLen += WrtLen;
 
+	if(m_pKMerIdx != NULL && (Rslt=KMerIdx2Disk())!=eBSFSuccess)
+		return(Rslt);
+
+	if(m_pPackedSeq != NULL && (Rslt=PackedSeq2Disk())!=eBSFSuccess)
+		return(Rslt);
+
 	m_pSfxBlock->BlockID = 0;
 	m_pSfxBlock->NumEntries = 0;
 	m_pSfxBlock->ConcatSeqLen = 0;
@@ -573,7 +764,7 @@ if(8 != read(m_hFile,&HdrVer,8))
 if(tolower(HdrVer[0]) != 's' ||
 	tolower(HdrVer[1]) != 'f' ||
 	tolower(HdrVer[2]) != 'x' ||
-	(tolower(HdrVer[3]) < '3' || tolower(HdrVer[3]) > '5'))
+	(tolower(HdrVer[3]) < '3' || tolower(HdrVer[3]) > '8'))
 	{
 	AddErrMsg("CSfxArrayV3::Disk2Hdr","%s opened but invalid magic signature - not a Biokanga generated suffix array file",pszFile);
 	Reset(false);			// closes opened file..
@@ -608,24 +799,44 @@ if(m_bV3File)
 		return(eBSFerrFileAccess);
 		}
 	memcpy(&m_SfxHeader,&SfxHeaderVv,sizeof(tsSfxHeaderVv));
-	m_SfxHeader.Magic[3] = '5';
+	m_SfxHeader.Magic[3] = '8';
 	m_SfxHeader.Version = cSFXVersion;
 	memcpy(&m_SfxHeader.szDescription,&SfxHeaderVv.szDescription,sizeof(SfxHeaderVv.szDescription));
 	memcpy(&m_SfxHeader.szTitle,&SfxHeaderVv.szTitle,sizeof(SfxHeaderVv.szTitle));
+	memset(&m_SfxHeader.KMerIdxLen,0,sizeof(tsSfxHeaderV3) - offsetof(tsSfxHeaderV3,KMerIdxLen));
 	}
 else
 	{
-	if(sizeof(tsSfxHeaderV3) != read(m_hFile,&m_SfxHeader,sizeof(tsSfxHeaderV3)))
+	int HdrLen;
+	// V4 and V5 file headers are identical to V8 except that V6 was extended with the k-mer prefix index fields, V7 with the packed sequence fields and V8 with the suffix sample rate
+	switch(Version) {
+		case 4: case 5:
+			HdrLen = (int)offsetof(tsSfxHeaderV3,KMerIdxLen);
+			break;
+		case 6:
+			HdrLen = (int)offsetof(tsSfxHeaderV3,PackedSeqLen);
+			break;
+		case 7:
+			HdrLen = (int)offsetof(tsSfxHeaderV3,SfxSampleRate);
+			break;
+		default:
+			HdrLen = (int)sizeof(tsSfxHeaderV3);
+			break;
+		}
+	if(HdrLen != read(m_hFile,&m_SfxHeader,HdrLen))
 		{
-		AddErrMsg("CSfxArrayV3::Disk2Hdr","Read of V4 file header failed on %s - %s",pszFile,strerror(errno));
+		AddErrMsg("CSfxArrayV3::Disk2Hdr","Read of V%d file header failed on %s - %s",Version,pszFile,strerror(errno));
 		Reset(false);			// closes opened file..
 		return(eBSFerrFileAccess);
 		}
+	if(HdrLen < (int)sizeof(tsSfxHeaderV3))
+		memset(&((UINT8 *)&m_SfxHeader)[HdrLen],0,sizeof(tsSfxHeaderV3) - HdrLen);
 	}
 
 
 m_bBisulfite = m_SfxHeader.Attributes & 0x01 ? true : false;
 m_bColorspace = m_SfxHeader.Attributes & 0x02 ? true : false;
+m_SfxSampleRate = m_SfxHeader.SfxSampleRate > 1 ? m_SfxHeader.SfxSampleRate : 1;	// files prior to V8 always retained all suffixes
 m_bHdrDirty = false;
 return(eBSFSuccess);
 }
@@ -887,11 +1098,13 @@ return(eBSFSuccess);
 // Option to create or truncate pszFile
 // Option to process for bisulfite indexing
 // Option to process for colorspace
+// Option, if opening existing file, to memory map the suffix block read only instead of loading a private copy
 int
 CSfxArrayV3::Open(char *pszFile,
 					  bool bCreate,
 					  bool bBisulfite,
-					  bool bColorspace)
+					  bool bColorspace,
+					  etSfxLoadMode LoadMode)
 {
 teBSFrsltCodes Rslt;
 if(pszFile == NULL || *pszFile == '\0') // validate parameters
@@ -976,6 +1189,41 @@ else // else opening existing file
 		return(eBSFerrFileAccess);
 		}
 
+	// if requested then memory map the suffix block so it can be shared through the page cache with other processes
+	if(LoadMode != eSfxLoadCopy && m_SfxHeader.NumSfxBlocks > 0)
+		{
+#ifdef _WIN32
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"CSfxArrayV3::Open: memory mapped loading not supported on this platform, loading a private copy of '%s'",pszFile);
+#else
+		if((Rslt=MapSfxFile(LoadMode)) < eBSFSuccess)
+			{
+			Reset(false);			// closes opened file..
+			return(Rslt);
+			}
+#endif
+		}
+
+	// load any k-mer prefix index
+	if((Rslt=Disk2KMerIdx()) < eBSFSuccess)
+		{
+		Reset(false);			// closes opened file..
+		return(Rslt);
+		}
+
+	// load any 2bit packed sequence
+	if((Rslt=Disk2PackedSeq()) < eBSFSuccess)
+		{
+		Reset(false);			// closes opened file..
+		return(Rslt);
+		}
+
+	// if memory mapped then no background loading thread is required
+	if(m_pMappedSfxFile != NULL)
+		{
+		m_CASSeqFlags = 0;
+		return(eBSFSuccess);
+		}
+
 	// allocate suffix block memory
 #ifdef _WIN32
 	m_pSfxBlock = (tsSfxBlock *) malloc((size_t)m_SfxHeader.SfxBlockSize);
@@ -1838,12 +2086,15 @@ CSfxArrayV3::Disk2SfxBlock(int BlockID)
 teBSFrsltCodes Rslt;
 
 
-if(m_pSfxBlock == NULL || !m_bThreadActive)
+if(m_pSfxBlock == NULL || (!m_bThreadActive && m_pMappedSfxFile == NULL && !m_bSfxBlockResident))
 	return(eBSFerrInternal);
 
 if(BlockID < 1 || m_SfxHeader.NumSfxBlocks == 0 || (UINT32)BlockID > m_SfxHeader.NumSfxBlocks)
 	return(eBSFerrParams);
 
+if(m_pMappedSfxFile != NULL || m_bSfxBlockResident)	// memory mapped or resident suffix block is always available
+	return(m_pSfxBlock->BlockID == BlockID ? eBSFSuccess : eBSFerrInternal);
+
 
 do {
 #ifdef _WIN32
@@ -1889,150 +2140,931 @@ pthread_mutex_unlock(&m_JobMutex);
 return(Rslt);
 }
 
-int
-CSfxArrayV3::Next(int PrevBlockID)
+// DeleteKMerIdx
+// Releases any k-mer prefix index
+void
+CSfxArrayV3::DeleteKMerIdx(void)
 {
-if(PrevBlockID < 0 || (UINT32)PrevBlockID >= m_SfxHeader.NumSfxBlocks)
-	return(0);
-return(PrevBlockID + 1);
+if(m_pKMerIdx != NULL && m_AllocKMerIdxMem > 0)	// if referenced within memory mapped suffix file then not separately allocated
+	{
+#ifdef _WIN32
+	free(m_pKMerIdx);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
+#else
+	if(m_pKMerIdx != MAP_FAILED)
+		munmap(m_pKMerIdx,m_AllocKMerIdxMem);
+#endif
+	}
+m_pKMerIdx = NULL;
+m_AllocKMerIdxMem = 0;
+m_KMerIdxLen = 0;
 }
 
-// SetTargBlock
-// specifies which block is to be loaded for subsequent sequence matches
-int
-CSfxArrayV3::SetTargBlock(int BlockID)
+// KMerPrefix
+// Returns the packed 2bit per base k-mer for the first KMerLen bases of pSeq, or -1 if any of these bases is not canonical (includes repeat masked) or an EOS
+static inline INT64
+KMerPrefix(int KMerLen,etSeqBase *pSeq)
 {
-return(Disk2SfxBlock(BlockID));
+INT64 KMer = 0;
+etSeqBase Base;
+while(KMerLen--)
+	{
+	if((Base = *pSeq++ & 0x0f) > eBaseT)
+		return(-1);
+	KMer = (KMer << 2) | Base;
+	}
+return(KMer);
 }
 
-int										// if non-zero then returned number of identifiers
-CSfxArrayV3::ChkDupEntries(int MaxIdents,		// maximum number of identifers to return in pIdents (caller allocates to hold returned identifiers)
-					  UINT32 *pIdents)		// checks if there are duplicate entry names and reports identifier
+// GenKMerIdx
+// Generates the k-mer prefix index from a sorted suffix block
+// For every k-mer the index holds the first and last suffix array index (+1) of those suffixes prefixed by that k-mer, or 0 if no suffixes
+// Suffixes sharing a canonical k-mer prefix are contiguous in the suffix array so bucket extents are located by galloping over the suffixes
+teBSFrsltCodes
+CSfxArrayV3::GenKMerIdx(void)
 {
-int NumDups;
-bool bInDup;
-tsSfxEntry **ppEntries;
-tsSfxEntry *pCurEntry;
-tsSfxEntry *pPrevEntry;
+int KMerIdxLen;
+int SfxElSize;
+INT64 NumKMers;
+INT64 SfxLen;
+INT64 SeqLen;
+INT64 SfxIdx;
+INT64 Lo;
+INT64 Hi;
+INT64 Mid;
+INT64 Step;
+INT64 KMer;
+INT64 NumBuckets;
+UINT8 *pEl;
+etSeqBase *pTarg;
+void *pSfxArray;
 
-UINT32 Idx;
+DeleteKMerIdx();
+if(m_pSfxBlock == NULL || m_ReqKMerIdxLen == 0 || m_bBisulfite)
+	return(eBSFSuccess);
 
-if(m_pEntriesBlock == NULL || MaxIdents > 0 && pIdents == NULL)
-	return(eBSFerrEntry);
-if(m_pEntriesBlock->NumEntries < 2)
-	return(0);
+SeqLen = (INT64)m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
+SfxElSize = m_pSfxBlock->SfxElSize;
+pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
+pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[SeqLen];
 
-if((ppEntries = new tsSfxEntry * [m_pEntriesBlock->NumEntries]) == NULL)
+// no point in having more k-mer buckets than there are suffixes
+for(KMerIdxLen = m_ReqKMerIdxLen; KMerIdxLen > cMinKMerIdxLen; KMerIdxLen--)
+	if(((INT64)1 << (2 * KMerIdxLen)) <= SfxLen)
+		break;
+if(((INT64)1 << (2 * KMerIdxLen)) > SfxLen)
 	{
-	AddErrMsg("CSfxArrayV3::ChkDupEntries","unable to allocate memory for sorting %d entry pointers",m_pEntriesBlock->NumEntries);
-	return(eBSFerrMem);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"GenKMerIdx: too few suffixes (%lld) to warrant a k-mer prefix index",SfxLen);
+	return(eBSFSuccess);
 	}
 
-for(Idx = 0; Idx < m_pEntriesBlock->NumEntries; Idx++)
-	ppEntries[Idx] = &m_pEntriesBlock->Entries[Idx];
-
-// now sort on entries names
-m_MTqsort.qsort(ppEntries,m_pEntriesBlock->NumEntries,sizeof(tsSfxEntry *),QSortEntryNames);
+NumKMers = (INT64)1 << (2 * KMerIdxLen);
+m_AllocKMerIdxMem = (UINT64)NumKMers * 2 * SfxElSize;
+#ifdef _WIN32
+m_pKMerIdx = (UINT8 *)malloc((size_t)m_AllocKMerIdxMem);
+if(m_pKMerIdx == NULL)
+#else
+m_pKMerIdx = (UINT8 *)mmap(NULL,(size_t)m_AllocKMerIdxMem, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+if(m_pKMerIdx == MAP_FAILED)
+#endif
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"GenKMerIdx: unable to allocate %lld bytes for k-mer prefix index, index will not be generated",(INT64)m_AllocKMerIdxMem);
+	m_pKMerIdx = NULL;
+	m_AllocKMerIdxMem = 0;
+	return(eBSFerrMem);
+	}
+memset(m_pKMerIdx,0,(size_t)m_AllocKMerIdxMem);
 
-// iterate looking for duplicates
-NumDups = 0;
-bInDup = false;
-pPrevEntry = ppEntries[0];
-for(Idx = 1; Idx < m_pEntriesBlock->NumEntries && NumDups < MaxIdents; Idx++)
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"GenKMerIdx: generating %d-mer prefix index over %lld suffixes...",KMerIdxLen,SfxLen);
+NumBuckets = 0;
+SfxIdx = 0;
+while(SfxIdx < SfxLen)
 	{
-	pCurEntry = ppEntries[Idx];
-	if(stricmp((char *)pCurEntry->szSeqName,(char *)pPrevEntry->szSeqName))
+	if((UINT64)SfxOfsToLoci(SfxElSize,pSfxArray,SfxIdx) + KMerIdxLen > (UINT64)SeqLen ||
+		(KMer = KMerPrefix(KMerIdxLen,&pTarg[SfxOfsToLoci(SfxElSize,pSfxArray,SfxIdx)])) < 0)
 		{
-		pPrevEntry = pCurEntry;
-		bInDup = false;
+		SfxIdx += 1;	// non-canonical prefixes are not contiguous so can't gallop over these
 		continue;
 		}
-	if(!bInDup && MaxIdents && NumDups < MaxIdents)
+
+	// gallop forward whilst same k-mer prefix, then bisect to locate the last suffix with that prefix
+	Lo = SfxIdx;
+	Step = 1;
+	while(Lo + Step < SfxLen && (UINT64)SfxOfsToLoci(SfxElSize,pSfxArray,Lo + Step) + KMerIdxLen <= (UINT64)SeqLen &&
+			KMerPrefix(KMerIdxLen,&pTarg[SfxOfsToLoci(SfxElSize,pSfxArray,Lo + Step)]) == KMer)
 		{
-		*pIdents++ = pPrevEntry->EntryID;
-		NumDups += 1;
-		bInDup = true;
+		Lo += Step;
+		Step <<= 1;
 		}
-	else
-		if(!MaxIdents)
-			{
-			NumDups = 1;
-			break;
-			}
-	}
-delete ppEntries;
-return(NumDups);
+	Hi = min(Lo + Step,SfxLen) - 1;
+	while(Lo < Hi)
+		{
+		Mid = (Lo + Hi + 1) / 2;
+		if((UINT64)SfxOfsToLoci(SfxElSize,pSfxArray,Mid) + KMerIdxLen <= (UINT64)SeqLen &&
+				KMerPrefix(KMerIdxLen,&pTarg[SfxOfsToLoci(SfxElSize,pSfxArray,Mid)]) == KMer)
+			Lo = Mid;
+		else
+			Hi = Mid - 1;
+		}
+
+	pEl = &m_pKMerIdx[KMer * 2 * SfxElSize];
+	*(UINT32 *)pEl = (UINT32)((SfxIdx + 1) & 0x0ffffffff);
+	if(SfxElSize == 5)
+		pEl[4] = (UINT8)(((SfxIdx + 1) >> 32) & 0x00ff);
+	pEl += SfxElSize;
+	*(UINT32 *)pEl = (UINT32)((Lo + 1) & 0x0ffffffff);
+	if(SfxElSize == 5)
+		pEl[4] = (UINT8)(((Lo + 1) >> 32) & 0x00ff);
+	NumBuckets += 1;
+	SfxIdx = Lo + 1;
+	}
+m_KMerIdxLen = KMerIdxLen;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"GenKMerIdx: %d-mer prefix index generated, %lld of %lld k-mers present",KMerIdxLen,NumBuckets,NumKMers);
+return(eBSFSuccess);
 }
 
-
-UINT16											// returned flags prior to this call
-CSfxArrayV3::SetResetIdentFlags(UINT32 EntryID,	// atomic set/reset flags for this entry
-					UINT16 SetFlags,			// set these flags then
-					UINT16 ResetFlags)			// reset these flags
+// KMerIdx2Disk
+// Writes k-mer prefix index to file immediately following the suffix block
+teBSFrsltCodes
+CSfxArrayV3::KMerIdx2Disk(void)
 {
-UINT32 fBlockID;
-UINT16 Flags;
-if(SetFlags == 0 && ResetFlags == 0)
-	return(GetIdentFlags(EntryID));
+teBSFrsltCodes Rslt;
+if(m_bInMemSfx || m_pKMerIdx == NULL || m_KMerIdxLen == 0)
+	return(eBSFSuccess);
 
-if(m_pEntriesBlock == NULL || EntryID < 1 || EntryID > m_pEntriesBlock->NumEntries)
-	return(eBSFerrEntry);
-SerialiseBaseFlags();
-fBlockID = m_pEntriesBlock->Entries[EntryID-1].fBlockID;
-Flags = (fBlockID >> 8) & 0x0ffff;
-Flags |= SetFlags;
-Flags &= ~ResetFlags;
-m_pEntriesBlock->Entries[EntryID-1].fBlockID = ((UINT32)Flags << 8) | fBlockID & 0x0ff;
-ReleaseBaseFlags();
-return((fBlockID >> 8) & 0x0ffff);
+m_SfxHeader.KMerIdxLen = m_KMerIdxLen;
+m_SfxHeader.KMerIdxOfs = m_SfxHeader.FileLen;
+m_SfxHeader.KMerIdxSize = m_AllocKMerIdxMem;
+if((Rslt=ChunkedWrite(m_SfxHeader.KMerIdxOfs,m_pKMerIdx,(INT64)m_SfxHeader.KMerIdxSize))!=eBSFSuccess)
+	{
+	AddErrMsg("CSfxArrayV3::KMerIdx2Disk","Unable to write k-mer prefix index to disk");
+	Reset(false);
+	return(Rslt);
+	}
+m_SfxHeader.FileLen += m_SfxHeader.KMerIdxSize;
+m_bHdrDirty = true;
+return(eBSFSuccess);
 }
 
-UINT16					// returned flags
-CSfxArrayV3::GetIdentFlags(UINT32 EntryID)
+// Disk2KMerIdx
+// Loads any k-mer prefix index from file
+teBSFrsltCodes
+CSfxArrayV3::Disk2KMerIdx(void)
 {
-UINT32 Flags;
-if(m_pEntriesBlock == NULL || EntryID < 1 || EntryID > m_pEntriesBlock->NumEntries)
-	return(eBSFerrEntry);
-SerialiseBaseFlags();
-Flags = m_pEntriesBlock->Entries[EntryID-1].fBlockID;
-ReleaseBaseFlags();
-return((Flags >> 8) & 0x0ffff);
-}
+teBSFrsltCodes Rslt;
+INT64 ExpSize;
 
+DeleteKMerIdx();
+if(m_SfxHeader.KMerIdxLen == 0 || m_SfxHeader.KMerIdxOfs == 0 || m_SfxHeader.KMerIdxSize == 0 || m_bBisulfite)
+	return(eBSFSuccess);
 
-void
-CSfxArrayV3::InitAllIdentFlags(UINT16 Flags)		// initialise all entries to have these flags
-{
-UINT32 EntryID;
-UINT32 fBlockID;
-UINT32 SetFlags;
-tsSfxEntry *pSfxEntry;
-if(m_pEntriesBlock == NULL || m_pEntriesBlock->NumEntries < 1)
-	return;
-SetFlags = (UINT32)Flags << 8;
-pSfxEntry = m_pEntriesBlock->Entries;
-SerialiseBaseFlags();
-for(EntryID = 0; EntryID < m_pEntriesBlock->NumEntries; EntryID++,pSfxEntry++)
+// index elements are sized the same as the suffix array elements, either 4 or 5 bytes
+ExpSize = ((INT64)1 << (2 * min(m_SfxHeader.KMerIdxLen,(UINT32)cMaxKMerIdxLen))) * 2;
+if(m_SfxHeader.KMerIdxLen < (UINT32)cMinKMerIdxLen || m_SfxHeader.KMerIdxLen > (UINT32)cMaxKMerIdxLen ||
+	((INT64)m_SfxHeader.KMerIdxSize != ExpSize * 4 && (INT64)m_SfxHeader.KMerIdxSize != ExpSize * 5))
 	{
-	fBlockID = pSfxEntry->fBlockID & 0x0ff;
-	fBlockID |= SetFlags;
-	pSfxEntry->fBlockID = fBlockID;
+	AddErrMsg("CSfxArrayV3::Disk2KMerIdx","k-mer prefix index in %s is inconsistent, length %d, size %lld",m_szFile,m_SfxHeader.KMerIdxLen,(INT64)m_SfxHeader.KMerIdxSize);
+	return(eBSFerrFileAccess);
 	}
-ReleaseBaseFlags();
-return;
-}
 
+// if suffix file memory mapped then index is referenced within the mapping
+if(m_pMappedSfxFile != NULL)
+	{
+	if(m_SfxHeader.KMerIdxOfs + m_SfxHeader.KMerIdxSize > m_MappedSfxFileLen)
+		{
+		AddErrMsg("CSfxArrayV3::Disk2KMerIdx","k-mer prefix index in %s extends past end of file",m_szFile);
+		return(eBSFerrFileAccess);
+		}
+	m_pKMerIdx = &m_pMappedSfxFile[m_SfxHeader.KMerIdxOfs];
+	m_AllocKMerIdxMem = 0;
+	m_KMerIdxLen = m_SfxHeader.KMerIdxLen;
+	return(eBSFSuccess);
+	}
+
+#ifdef _WIN32
+m_pKMerIdx = (UINT8 *)malloc((size_t)m_SfxHeader.KMerIdxSize);
+if(m_pKMerIdx == NULL)
+#else
+m_pKMerIdx = (UINT8 *)mmap(NULL,(size_t)m_SfxHeader.KMerIdxSize, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+if(m_pKMerIdx == MAP_FAILED)
+#endif
+	{
+	AddErrMsg("CSfxArrayV3::Disk2KMerIdx","unable to allocate %lld bytes for holding k-mer prefix index",(INT64)m_SfxHeader.KMerIdxSize);
+	m_pKMerIdx = NULL;
+	return(eBSFerrMem);
+	}
+m_AllocKMerIdxMem = m_SfxHeader.KMerIdxSize;
+
+if((Rslt=ChunkedRead(m_SfxHeader.KMerIdxOfs,m_pKMerIdx,(INT64)m_SfxHeader.KMerIdxSize))!=eBSFSuccess)
+	{
+	AddErrMsg("CSfxArrayV3::Disk2KMerIdx","unable to load k-mer prefix index of length %lld from offset %lld",(INT64)m_SfxHeader.KMerIdxSize,(INT64)m_SfxHeader.KMerIdxOfs);
+	DeleteKMerIdx();
+	return(eBSFerrFileAccess);
+	}
+m_KMerIdxLen = m_SfxHeader.KMerIdxLen;
+return(eBSFSuccess);
+}
+
+// DeletePackedSeq
+// Releases any 2bit packed sequence, N-run and mask interval tables, and the packed word exceptions bitmap
+void
+CSfxArrayV3::DeletePackedSeq(void)
+{
+if(m_pPackedSeq != NULL && m_AllocPackedSeqMem > 0)	// if referenced within memory mapped suffix file then not separately allocated
+	{
+#ifdef _WIN32
+	free(m_pPackedSeq);
+#else
+	if(m_pPackedSeq != MAP_FAILED)
+		munmap(m_pPackedSeq,m_AllocPackedSeqMem);
+#endif
+	}
+if(m_pNRuns != NULL && m_AllocSeqRunsMem > 0)		// mask intervals are in the same allocation following the N-runs
+	{
+#ifdef _WIN32
+	free(m_pNRuns);
+#else
+	if(m_pNRuns != MAP_FAILED)
+		munmap(m_pNRuns,m_AllocSeqRunsMem);
+#endif
+	}
+if(m_pPackedExcept != NULL)
+	{
+#ifdef _WIN32
+	free(m_pPackedExcept);
+#else
+	if(m_pPackedExcept != MAP_FAILED)
+		munmap(m_pPackedExcept,m_AllocPackedExceptMem);
+#endif
+	}
+m_pPackedSeq = NULL;
+m_AllocPackedSeqMem = 0;
+m_PackedSeqLen = 0;
+m_pNRuns = NULL;
+m_pMaskRuns = NULL;
+m_NumNRuns = 0;
+m_NumMaskRuns = 0;
+m_AllocSeqRunsMem = 0;
+m_pPackedExcept = NULL;
+m_AllocPackedExceptMem = 0;
+}
+
+// AllocPackedMem
+// Allocates, and zeros, memory for the packed sequence and associated tables
+static void *
+AllocPackedMem(UINT64 AllocSize)
+{
+void *pMem;
+#ifdef _WIN32
+if((pMem = malloc((size_t)AllocSize)) == NULL)
+	return(NULL);
+memset(pMem,0,(size_t)AllocSize);
+#else
+// anonymous mappings are zero filled
+if((pMem = mmap(NULL,(size_t)AllocSize, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0)) == MAP_FAILED)
+	return(NULL);
+#endif
+return(pMem);
+}
+
+// ScanSeqRuns
+// Scans the concatenated sequence for runs of identical non-canonical bases (N-runs), including EOS markers, and for intervals of repeat masked canonical bases
+// If pPacked is not NULL then the sequence is also packed 2bits per base into pPacked (which must have been zeroed), non-canonical bases are packed as eBaseA
+// If pNRuns or pMaskRuns are NULL then N-runs or mask intervals are only counted
+static void
+ScanSeqRuns(UINT64 SeqLen,				// concatenated sequence length
+			etSeqBase *pSeq,			// concatenated sequence
+			UINT64 *pPacked,			// optionally pack into this
+			UINT64 *pNumNRuns,			// returned number of N-runs
+			tsSfxSeqRun *pNRuns,		// optionally return N-runs into this
+			UINT64 *pNumMaskRuns,		// returned number of mask intervals
+			tsSfxSeqRun *pMaskRuns)		// optionally return mask intervals into this
+{
+UINT64 Ofs;
+UINT64 NumNRuns;
+UINT64 NumMaskRuns;
+UINT64 NStart;
+UINT32 NLen;
+UINT32 NBase;
+UINT64 MStart;
+UINT32 MLen;
+etSeqBase Base;
+
+NumNRuns = 0;
+NumMaskRuns = 0;
+NStart = 0;
+NLen = 0;
+NBase = 0;
+MStart = 0;
+MLen = 0;
+for(Ofs = 0; Ofs < SeqLen; Ofs++)
+	{
+	Base = pSeq[Ofs] & 0x0f;
+	if(NLen > 0 && (Base != NBase || NLen == 0xffffffff))		// current N-run terminated?
+		{
+		if(pNRuns != NULL)
+			{
+			pNRuns[NumNRuns].StartOfs = NStart;
+			pNRuns[NumNRuns].RunLen = NLen;
+			pNRuns[NumNRuns].Base = NBase;
+			}
+		NumNRuns += 1;
+		NLen = 0;
+		}
+	if(MLen > 0 && ((Base & 0x07) > eBaseT || !(Base & cRptMskFlg) || MLen == 0xffffffff))	// current mask interval terminated?
+		{
+		if(pMaskRuns != NULL)
+			{
+			pMaskRuns[NumMaskRuns].StartOfs = MStart;
+			pMaskRuns[NumMaskRuns].RunLen = MLen;
+			pMaskRuns[NumMaskRuns].Base = 0;
+			}
+		NumMaskRuns += 1;
+		MLen = 0;
+		}
+
+	if((Base & 0x07) > eBaseT)		// non-canonical, including any repeat mask flag, are in N-runs
+		{
+		if(NLen++ == 0)
+			{
+			NStart = Ofs;
+			NBase = Base;
+			}
+		continue;
+		}
+	if(Base & cRptMskFlg)
+		{
+		if(MLen++ == 0)
+			MStart = Ofs;
+		}
+	if(pPacked != NULL)
+		pPacked[Ofs >> 5] |= (UINT64)(Base & 0x03) << ((Ofs & 0x1f) * 2);
+	}
+
+if(NLen > 0)
+	{
+	if(pNRuns != NULL)
+		{
+		pNRuns[NumNRuns].StartOfs = NStart;
+		pNRuns[NumNRuns].RunLen = NLen;
+		pNRuns[NumNRuns].Base = NBase;
+		}
+	NumNRuns += 1;
+	}
+if(MLen > 0)
+	{
+	if(pMaskRuns != NULL)
+		{
+		pMaskRuns[NumMaskRuns].StartOfs = MStart;
+		pMaskRuns[NumMaskRuns].RunLen = MLen;
+		pMaskRuns[NumMaskRuns].Base = 0;
+		}
+	NumMaskRuns += 1;
+	}
+*pNumNRuns = NumNRuns;
+*pNumMaskRuns = NumMaskRuns;
+}
+
+// GenPackedSeq
+// Generates a 2bit packed copy of the suffix block concatenated sequence plus the N-run and repeat mask interval tables
+// required to losslessly represent those bases which can't be packed
+// The byte per base sequence is retained as it is referenced by the suffix array comparisons and all sequence retrieval
+teBSFrsltCodes
+CSfxArrayV3::GenPackedSeq(void)
+{
+UINT64 SeqLen;
+UINT64 NumNRuns;
+UINT64 NumMaskRuns;
+
+DeletePackedSeq();
+if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0 || m_bBisulfite || m_bColorspace)
+	return(eBSFSuccess);
+
+SeqLen = m_pSfxBlock->ConcatSeqLen;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"GenPackedSeq: generating 2bit packed sequence over %lld bases...",(INT64)SeqLen);
+
+// one additional word so that unaligned 32 base windows can always be extracted from two adjacent words
+m_AllocPackedSeqMem = (((SeqLen + 31) / 32) + 1) * sizeof(UINT64);
+if((m_pPackedSeq = (UINT64 *)AllocPackedMem(m_AllocPackedSeqMem)) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"GenPackedSeq: unable to allocate %lld bytes for packed sequence, packed sequence will not be generated",(INT64)m_AllocPackedSeqMem);
+	m_AllocPackedSeqMem = 0;
+	return(eBSFerrMem);
+	}
+ScanSeqRuns(SeqLen,m_pSfxBlock->SeqSuffix,m_pPackedSeq,&NumNRuns,NULL,&NumMaskRuns,NULL);
+
+m_AllocSeqRunsMem = (NumNRuns + NumMaskRuns + 1) * sizeof(tsSfxSeqRun);
+if((m_pNRuns = (tsSfxSeqRun *)AllocPackedMem(m_AllocSeqRunsMem)) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"GenPackedSeq: unable to allocate %lld bytes for N-run and mask interval tables, packed sequence will not be generated",(INT64)m_AllocSeqRunsMem);
+	m_AllocSeqRunsMem = 0;
+	DeletePackedSeq();
+	return(eBSFerrMem);
+	}
+m_pMaskRuns = &m_pNRuns[NumNRuns];
+ScanSeqRuns(SeqLen,m_pSfxBlock->SeqSuffix,NULL,&m_NumNRuns,m_pNRuns,&m_NumMaskRuns,m_pMaskRuns);
+m_PackedSeqLen = SeqLen;
+
+if(GenPackedExcept() != eBSFSuccess)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"GenPackedSeq: unable to allocate memory for packed word exceptions, packed sequence will not be generated");
+	DeletePackedSeq();
+	return(eBSFerrMem);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"GenPackedSeq: 2bit packed sequence generated with %lld N-runs and %lld repeat masked intervals",(INT64)m_NumNRuns,(INT64)m_NumMaskRuns);
+return(eBSFSuccess);
+}
+
+// GenPackedExcept
+// Generates bitmap, one bit per 32 base packed word, identifying those packed words which contain any bases within a N-run or mask interval
+// Packed comparisons are not attempted on windows overlapping any of these words
+teBSFrsltCodes
+CSfxArrayV3::GenPackedExcept(void)
+{
+UINT64 NumWords;
+UINT64 WordIdx;
+UINT64 LastWordIdx;
+UINT64 Idx;
+tsSfxSeqRun *pRun;
+
+if(m_pPackedExcept != NULL)
+	{
+#ifdef _WIN32
+	free(m_pPackedExcept);
+#else
+	if(m_pPackedExcept != MAP_FAILED)
+		munmap(m_pPackedExcept,m_AllocPackedExceptMem);
+#endif
+	m_pPackedExcept = NULL;
+	m_AllocPackedExceptMem = 0;
+	}
+
+NumWords = (m_PackedSeqLen + 31) / 32;
+m_AllocPackedExceptMem = (((NumWords + 63) / 64) + 1) * sizeof(UINT64);
+if((m_pPackedExcept = (UINT64 *)AllocPackedMem(m_AllocPackedExceptMem)) == NULL)
+	{
+	m_AllocPackedExceptMem = 0;
+	return(eBSFerrMem);
+	}
+
+pRun = m_pNRuns;
+for(Idx = 0; Idx < m_NumNRuns + m_NumMaskRuns; Idx++,pRun++)	// mask intervals immediately follow the N-runs
+	{
+	LastWordIdx = (pRun->StartOfs + pRun->RunLen - 1) >> 5;
+	for(WordIdx = pRun->StartOfs >> 5; WordIdx <= LastWordIdx; WordIdx++)
+		m_pPackedExcept[WordIdx >> 6] |= (UINT64)1 << (WordIdx & 0x3f);
+	}
+return(eBSFSuccess);
+}
+
+// PackedSeq2Disk
+// Writes 2bit packed sequence followed by the N-run and mask interval tables to file
+teBSFrsltCodes
+CSfxArrayV3::PackedSeq2Disk(void)
+{
+teBSFrsltCodes Rslt;
+INT64 WrtLen;
+if(m_bInMemSfx || m_pPackedSeq == NULL || m_PackedSeqLen == 0)
+	return(eBSFSuccess);
+
+m_SfxHeader.PackedSeqLen = m_PackedSeqLen;
+m_SfxHeader.PackedSeqOfs = m_SfxHeader.FileLen;
+WrtLen = (INT64)m_AllocPackedSeqMem;
+if((Rslt=ChunkedWrite(m_SfxHeader.PackedSeqOfs,(UINT8 *)m_pPackedSeq,WrtLen))!=eBSFSuccess)
+	{
+	AddErrMsg("CSfxArrayV3::PackedSeq2Disk","Unable to write packed sequence to disk");
+	Reset(false);
+	return(Rslt);
+	}
+m_SfxHeader.FileLen += WrtLen;
+
+m_SfxHeader.NumNRuns = m_NumNRuns;
+m_SfxHeader.NRunsOfs = m_SfxHeader.FileLen;
+m_SfxHeader.NumMaskRuns = m_NumMaskRuns;
+m_SfxHeader.MaskRunsOfs = m_SfxHeader.FileLen + (m_NumNRuns * sizeof(tsSfxSeqRun));
+WrtLen = (INT64)((m_NumNRuns + m_NumMaskRuns) * sizeof(tsSfxSeqRun));
+if(WrtLen > 0 && (Rslt=ChunkedWrite(m_SfxHeader.NRunsOfs,(UINT8 *)m_pNRuns,WrtLen))!=eBSFSuccess)
+	{
+	AddErrMsg("CSfxArrayV3::PackedSeq2Disk","Unable to write N-run and mask interval tables to disk");
+	Reset(false);
+	return(Rslt);
+	}
+m_SfxHeader.FileLen += WrtLen;
+m_bHdrDirty = true;
+return(eBSFSuccess);
+}
+
+// Disk2PackedSeq
+// Loads any 2bit packed sequence plus N-run and mask interval tables from file, and generates the packed word exceptions bitmap
+teBSFrsltCodes
+CSfxArrayV3::Disk2PackedSeq(void)
+{
+teBSFrsltCodes Rslt;
+UINT64 PackedSize;
+UINT64 RunsSize;
+
+DeletePackedSeq();
+if(m_SfxHeader.PackedSeqLen == 0 || m_SfxHeader.PackedSeqOfs == 0 || m_bBisulfite || m_bColorspace)
+	return(eBSFSuccess);
+
+PackedSize = (((m_SfxHeader.PackedSeqLen + 31) / 32) + 1) * sizeof(UINT64);
+RunsSize = (m_SfxHeader.NumNRuns + m_SfxHeader.NumMaskRuns) * sizeof(tsSfxSeqRun);
+if(m_SfxHeader.NRunsOfs != m_SfxHeader.PackedSeqOfs + PackedSize ||
+	m_SfxHeader.MaskRunsOfs != m_SfxHeader.NRunsOfs + (m_SfxHeader.NumNRuns * sizeof(tsSfxSeqRun)) ||
+	m_SfxHeader.NRunsOfs + RunsSize > m_SfxHeader.FileLen)
+	{
+	AddErrMsg("CSfxArrayV3::Disk2PackedSeq","packed sequence in %s is inconsistent with file header",m_szFile);
+	return(eBSFerrFileAccess);
+	}
+
+// if suffix file memory mapped then packed sequence and tables are referenced within the mapping
+if(m_pMappedSfxFile != NULL)
+	{
+	if(m_SfxHeader.NRunsOfs + RunsSize > m_MappedSfxFileLen)
+		{
+		AddErrMsg("CSfxArrayV3::Disk2PackedSeq","packed sequence in %s extends past end of file",m_szFile);
+		return(eBSFerrFileAccess);
+		}
+	m_pPackedSeq = (UINT64 *)&m_pMappedSfxFile[m_SfxHeader.PackedSeqOfs];
+	m_pNRuns = (tsSfxSeqRun *)&m_pMappedSfxFile[m_SfxHeader.NRunsOfs];
+	}
+else
+	{
+	m_AllocPackedSeqMem = PackedSize;
+	m_AllocSeqRunsMem = RunsSize + sizeof(tsSfxSeqRun);
+	if((m_pPackedSeq = (UINT64 *)AllocPackedMem(m_AllocPackedSeqMem)) == NULL ||
+		(m_pNRuns = (tsSfxSeqRun *)AllocPackedMem(m_AllocSeqRunsMem)) == NULL)
+		{
+		AddErrMsg("CSfxArrayV3::Disk2PackedSeq","unable to allocate %lld bytes for holding packed sequence",(INT64)(PackedSize + RunsSize));
+		DeletePackedSeq();
+		return(eBSFerrMem);
+		}
+	if((Rslt=ChunkedRead(m_SfxHeader.PackedSeqOfs,(UINT8 *)m_pPackedSeq,(INT64)PackedSize))!=eBSFSuccess ||
+		(RunsSize > 0 && (Rslt=ChunkedRead(m_SfxHeader.NRunsOfs,(UINT8 *)m_pNRuns,(INT64)RunsSize))!=eBSFSuccess))
+		{
+		AddErrMsg("CSfxArrayV3::Disk2PackedSeq","unable to load packed sequence of length %lld from offset %lld",(INT64)(PackedSize + RunsSize),(INT64)m_SfxHeader.PackedSeqOfs);
+		DeletePackedSeq();
+		return(eBSFerrFileAccess);
+		}
+	}
+m_NumNRuns = m_SfxHeader.NumNRuns;
+m_NumMaskRuns = m_SfxHeader.NumMaskRuns;
+m_pMaskRuns = &m_pNRuns[m_NumNRuns];
+m_PackedSeqLen = m_SfxHeader.PackedSeqLen;
+
+if(GenPackedExcept() != eBSFSuccess)
+	{
+	AddErrMsg("CSfxArrayV3::Disk2PackedSeq","unable to allocate memory for packed word exceptions");
+	DeletePackedSeq();
+	return(eBSFerrMem);
+	}
+return(eBSFSuccess);
+}
+
+// PopCount64
+// Returns number of set bits
+static inline int
+PopCount64(UINT64 Bits)
+{
+#ifdef _WIN32
+Bits = Bits - ((Bits >> 1) & 0x5555555555555555);
+Bits = (Bits & 0x3333333333333333) + ((Bits >> 2) & 0x3333333333333333);
+Bits = (Bits + (Bits >> 4)) & 0x0f0f0f0f0f0f0f0f;
+return((int)((Bits * 0x0101010101010101) >> 56));
+#else
+return(__builtin_popcountll(Bits));
+#endif
+}
+
+// PackProbe
+// Packs probe 2bits per base, in same layout as the packed concatenated sequence, into pProbeWords
+// Returns false if probe can't be packed because it is longer than cMaxPackedProbeLen or contains non-canonical bases
+static bool
+PackProbe(int ProbeLen,etSeqBase *pProbe,UINT64 *pProbeWords)
+{
+int Idx;
+etSeqBase Base;
+if(ProbeLen < 1 || ProbeLen > cMaxPackedProbeLen)
+	return(false);
+memset(pProbeWords,0,((ProbeLen + 31) / 32) * sizeof(UINT64));
+for(Idx = 0; Idx < ProbeLen; Idx++)
+	{
+	if((Base = *pProbe++ & 0x0f) > eBaseT)
+		return(false);
+	pProbeWords[Idx >> 5] |= (UINT64)Base << ((Idx & 0x1f) * 2);
+	}
+return(true);
+}
+
+// PackedMismatches
+// Counts mismatches between packed probe and target window 32 bases at a time by XORing the packed words, folding
+// each 2bit lane down to a single bit, and then counting set bits
+// Windows overlapping any packed words containing N-runs or masked intervals must be compared base by base by the caller
+int												// number of mismatches (> MaxMM if early terminated), or -1 if target window contains bases not representable in the packed sequence
+CSfxArrayV3::PackedMismatches(UINT64 TargOfs,	// target window starts at this offset in concatenated sequence
+				  int Len,						// window is this length
+				  UINT64 *pProbeWords,			// probe packed 2bit per base as returned by PackProbe()
+				  int MaxMM)					// can terminate early if more than this many mismatches
+{
+UINT64 WordIdx;
+UINT64 LastWordIdx;
+UINT64 TargWord;
+UINT64 Diffs;
+int Shift;
+int MMCnt;
+
+if(Len < 1 || TargOfs + Len > m_PackedSeqLen)
+	return(-1);
+
+LastWordIdx = (TargOfs + Len - 1) >> 5;
+for(WordIdx = TargOfs >> 5; WordIdx <= LastWordIdx; WordIdx++)
+	if(m_pPackedExcept[WordIdx >> 6] & ((UINT64)1 << (WordIdx & 0x3f)))
+		return(-1);
+
+MMCnt = 0;
+WordIdx = TargOfs >> 5;
+Shift = (int)(TargOfs & 0x1f) * 2;
+while(Len > 0)
+	{
+	if(Shift == 0)
+		TargWord = m_pPackedSeq[WordIdx];
+	else
+		TargWord = (m_pPackedSeq[WordIdx] >> Shift) | (m_pPackedSeq[WordIdx+1] << (64 - Shift));
+	Diffs = TargWord ^ *pProbeWords++;
+	Diffs = (Diffs | (Diffs >> 1)) & 0x5555555555555555;
+	if(Len < 32)
+		Diffs &= ((UINT64)1 << (Len * 2)) - 1;
+	if((MMCnt += PopCount64(Diffs)) > MaxMM)
+		break;
+	WordIdx += 1;
+	Len -= 32;
+	}
+return(MMCnt);
+}
+
+// MapSfxFile
+// Memory maps the opened suffix file read only (MAP_SHARED) so concurrent processes share the one page cache copy
+// If LoadMode is eSfxLoadMmapPopulate then all pages are prefaulted, otherwise pages are loaded on demand with random access advised
+teBSFrsltCodes
+CSfxArrayV3::MapSfxFile(etSfxLoadMode LoadMode)
+{
+#ifdef _WIN32
+return(eBSFerrInternal);
+#else
+struct stat64 FileStat;
+int MapFlags;
+UINT8 *pMapped;
+
+UnmapSfxFile();
+if(m_hFile == -1 || m_SfxHeader.NumSfxBlocks == 0 || m_SfxHeader.SfxBlockSize == 0)
+	return(eBSFerrInternal);
+
+if(fstat64(m_hFile,&FileStat) != 0)
+	{
+	AddErrMsg("CSfxArrayV3::MapSfxFile","Unable to stat %s - %s",m_szFile,strerror(errno));
+	return(eBSFerrFileAccess);
+	}
+if((UINT64)FileStat.st_size < m_SfxHeader.SfxBlockOfs + m_SfxHeader.SfxBlockSize)
+	{
+	AddErrMsg("CSfxArrayV3::MapSfxFile","%s is truncated, expected at least %lld bytes but file is %lld bytes",m_szFile,
+				(INT64)(m_SfxHeader.SfxBlockOfs + m_SfxHeader.SfxBlockSize),(INT64)FileStat.st_size);
+	return(eBSFerrFileAccess);
+	}
+
+MapFlags = MAP_SHARED;
+#ifdef MAP_POPULATE
+if(LoadMode == eSfxLoadMmapPopulate)
+	MapFlags |= MAP_POPULATE;
+#endif
+pMapped = (UINT8 *)mmap(NULL,(size_t)FileStat.st_size,PROT_READ,MapFlags,m_hFile,0);
+if(pMapped == MAP_FAILED)
+	{
+	AddErrMsg("CSfxArrayV3::MapSfxFile","Unable to memory map %lld bytes of %s - %s",(INT64)FileStat.st_size,m_szFile,strerror(errno));
+	return(eBSFerrMem);
+	}
+// suffix array accesses are essentially random so readahead is wasted unless the whole index is being prefaulted
+madvise(pMapped,(size_t)FileStat.st_size,LoadMode == eSfxLoadMmapPopulate ? MADV_WILLNEED : MADV_RANDOM);
+
+m_pMappedSfxFile = pMapped;
+m_MappedSfxFileLen = (UINT64)FileStat.st_size;
+m_pSfxBlock = (tsSfxBlock *)&pMapped[m_SfxHeader.SfxBlockOfs];
+m_AllocSfxBlockMem = 0;
+if(m_pSfxBlock->BlockID != 1 || (m_pSfxBlock->SfxElSize != 4 && m_pSfxBlock->SfxElSize != 5) ||
+	m_SfxHeader.SfxBlockSize != sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen - 1 + (GetNumSfxEls() * m_pSfxBlock->SfxElSize))
+	{
+	AddErrMsg("CSfxArrayV3::MapSfxFile","Memory mapped suffix block in %s is inconsistent with file header",m_szFile);
+	UnmapSfxFile();
+	return(eBSFerrFileAccess);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"CSfxArrayV3::MapSfxFile: memory mapped %lld bytes of '%s'%s",(INT64)FileStat.st_size,m_szFile,
+						LoadMode == eSfxLoadMmapPopulate ? ", prefaulted" : "");
+return(eBSFSuccess);
+#endif
+}
+
+// UnmapSfxFile
+// Unmaps any memory mapped suffix file, m_pSfxBlock will be NULL on return if it was pointing into the mapping
+void
+CSfxArrayV3::UnmapSfxFile(void)
+{
+if(m_pMappedSfxFile == NULL)
+	return;
+#ifndef _WIN32
+munmap(m_pMappedSfxFile,(size_t)m_MappedSfxFileLen);
+#endif
+m_pMappedSfxFile = NULL;
+m_MappedSfxFileLen = 0;
+m_pSfxBlock = NULL;
+}
+
+int
+CSfxArrayV3::Next(int PrevBlockID)
+{
+if(PrevBlockID < 0 || (UINT32)PrevBlockID >= m_SfxHeader.NumSfxBlocks)
+	return(0);
+return(PrevBlockID + 1);
+}
+
+// SetTargBlock
+// specifies which block is to be loaded for subsequent sequence matches
+int
+CSfxArrayV3::SetTargBlock(int BlockID)
+{
+return(Disk2SfxBlock(BlockID));
+}
+
+// HoldSfxBlockResident
+// Loads the suffix block and then terminates the background readahead thread, the loaded block remains resident for all subsequent matches
+// Mutexes and conditions are not usable in processes forked whilst another thread may be holding them, so this must be called before
+// forking processes which will be inheriting this instance
+int
+CSfxArrayV3::HoldSfxBlockResident(void)
+{
+teBSFrsltCodes Rslt;
+if(m_pMappedSfxFile != NULL || m_bSfxBlockResident)	// memory mapped suffix files have no readahead thread
+	return(eBSFSuccess);
+if(!m_bThreadActive)
+	return(eBSFerrInternal);
+if((Rslt = Disk2SfxBlock(1)) != eBSFSuccess)
+	return(Rslt);
+
+m_bTermThread = true;
+#ifdef _WIN32
+SetEvent(m_JobReqEvent);
+WaitForSingleObject(m_threadHandle,cSigTermWaitSecs * 1000);
+CloseHandle(m_threadHandle);
+m_threadHandle = NULL;
+CloseHandle(m_JobMutex);
+m_JobMutex = NULL;
+CloseHandle(m_JobReqEvent);
+m_JobReqEvent = NULL;
+CloseHandle(m_JobAckEvent);
+m_JobAckEvent = NULL;
+#else
+pthread_mutex_lock(&m_JobMutex);
+pthread_cond_signal(&m_JobReqEvent);
+pthread_mutex_unlock(&m_JobMutex);
+pthread_join(m_threadID,NULL);
+pthread_mutex_destroy(&m_JobMutex);
+pthread_cond_destroy(&m_JobReqEvent);
+pthread_cond_destroy(&m_JobAckEvent);
+#endif
+m_bThreadActive = false;
+m_bTermThread = false;
+m_ReqBlockID = 0;
+m_ReqBlockRslt = eBSFSuccess;
+m_bSfxBlockResident = true;
+return(eBSFSuccess);
+}
+
+int										// if non-zero then returned number of identifiers
+CSfxArrayV3::ChkDupEntries(int MaxIdents,		// maximum number of identifers to return in pIdents (caller allocates to hold returned identifiers)
+					  UINT32 *pIdents)		// checks if there are duplicate entry names and reports identifier
+{
+int NumDups;
+bool bInDup;
+tsSfxEntry **ppEntries;
+tsSfxEntry *pCurEntry;
+tsSfxEntry *pPrevEntry;
+
+UINT32 Idx;
+
+if(m_pEntriesBlock == NULL || MaxIdents > 0 && pIdents == NULL)
+	return(eBSFerrEntry);
+if(m_pEntriesBlock->NumEntries < 2)
+	return(0);
+
+if((ppEntries = new tsSfxEntry * [m_pEntriesBlock->NumEntries]) == NULL)
+	{
+	AddErrMsg("CSfxArrayV3::ChkDupEntries","unable to allocate memory for sorting %d entry pointers",m_pEntriesBlock->NumEntries);
+	return(eBSFerrMem);
+	}
+
+for(Idx = 0; Idx < m_pEntriesBlock->NumEntries; Idx++)
+	ppEntries[Idx] = &m_pEntriesBlock->Entries[Idx];
+
+// now sort on entries names
+m_MTqsort.qsort(ppEntries,m_pEntriesBlock->NumEntries,sizeof(tsSfxEntry *),QSortEntryNames);
+
+// iterate looking for duplicates
+NumDups = 0;
+bInDup = false;
+pPrevEntry = ppEntries[0];
+for(Idx = 1; Idx < m_pEntriesBlock->NumEntries && NumDups < MaxIdents; Idx++)
+	{
+	pCurEntry = ppEntries[Idx];
+	if(stricmp((char *)pCurEntry->szSeqName,(char *)pPrevEntry->szSeqName))
+		{
+		pPrevEntry = pCurEntry;
+		bInDup = false;
+		continue;
+		}
+	if(!bInDup && MaxIdents && NumDups < MaxIdents)
+		{
+		*pIdents++ = pPrevEntry->EntryID;
+		NumDups += 1;
+		bInDup = true;
+		}
+	else
+		if(!MaxIdents)
+			{
+			NumDups = 1;
+			break;
+			}
+	}
+delete ppEntries;
+return(NumDups);
+}
+
+
+UINT16											// returned flags prior to this call
+CSfxArrayV3::SetResetIdentFlags(UINT32 EntryID,	// atomic set/reset flags for this entry
+					UINT16 SetFlags,			// set these flags then
+					UINT16 ResetFlags)			// reset these flags
+{
+UINT32 fBlockID;
+UINT16 Flags;
+if(SetFlags == 0 && ResetFlags == 0)
+	return(GetIdentFlags(EntryID));
+
+if(m_pEntriesBlock == NULL || EntryID < 1 || EntryID > m_pEntriesBlock->NumEntries)
+	return(eBSFerrEntry);
+SerialiseBaseFlags();
+fBlockID = m_pEntriesBlock->Entries[EntryID-1].fBlockID;
+Flags = (fBlockID >> 8) & 0x0ffff;
+Flags |= SetFlags;
+Flags &= ~ResetFlags;
+m_pEntriesBlock->Entries[EntryID-1].fBlockID = ((UINT32)Flags << 8) | fBlockID & 0x0ff;
+ReleaseBaseFlags();
+return((fBlockID >> 8) & 0x0ffff);
+}
+
+UINT16					// returned flags
+CSfxArrayV3::GetIdentFlags(UINT32 EntryID)
+{
+UINT32 Flags;
+if(m_pEntriesBlock == NULL || EntryID < 1 || EntryID > m_pEntriesBlock->NumEntries)
+	return(eBSFerrEntry);
+SerialiseBaseFlags();
+Flags = m_pEntriesBlock->Entries[EntryID-1].fBlockID;
+ReleaseBaseFlags();
+return((Flags >> 8) & 0x0ffff);
+}
+
+
+void
+CSfxArrayV3::InitAllIdentFlags(UINT16 Flags)		// initialise all entries to have these flags
+{
+UINT32 EntryID;
+UINT32 fBlockID;
+UINT32 SetFlags;
+tsSfxEntry *pSfxEntry;
+if(m_pEntriesBlock == NULL || m_pEntriesBlock->NumEntries < 1)
+	return;
+SetFlags = (UINT32)Flags << 8;
+pSfxEntry = m_pEntriesBlock->Entries;
+SerialiseBaseFlags();
+for(EntryID = 0; EntryID < m_pEntriesBlock->NumEntries; EntryID++,pSfxEntry++)
+	{
+	fBlockID = pSfxEntry->fBlockID & 0x0ff;
+	fBlockID |= SetFlags;
+	pSfxEntry->fBlockID = fBlockID;
+	}
+ReleaseBaseFlags();
+return;
+}
+
+
+int
+CSfxArrayV3::GetIdentName(UINT32 EntryID,int MaxLen,char *pszSeqIdent)
+{
+if(m_pEntriesBlock == NULL || EntryID < 1 || (UINT32)EntryID > m_pEntriesBlock->NumEntries)
+	return(eBSFerrEntry);
+strncpy(pszSeqIdent,(const char *)m_pEntriesBlock->Entries[EntryID-1].szSeqName,MaxLen);
+pszSeqIdent[MaxLen-1] = '\0';
+return(eBSFSuccess);
+}
 
-int
-CSfxArrayV3::GetIdentName(UINT32 EntryID,int MaxLen,char *pszSeqIdent)
-{
-if(m_pEntriesBlock == NULL || EntryID < 1 || (UINT32)EntryID > m_pEntriesBlock->NumEntries)
-	return(eBSFerrEntry);
-strncpy(pszSeqIdent,(const char *)m_pEntriesBlock->Entries[EntryID-1].szSeqName,MaxLen);
-pszSeqIdent[MaxLen-1] = '\0';
-return(eBSFSuccess);
-}
-
 int		// returns identifer for specified sequence name
 CSfxArrayV3::GetIdent(char *pszSeqIdent)
 {
@@ -2194,6 +3226,8 @@ tsSfxEntry *pEntry;
 etSeqBase *pSeq;
 if(m_pEntriesBlock == NULL || EntryID < 1 || (UINT32)EntryID > m_pEntriesBlock->NumEntries || m_bColorspace)
 	return(eBSFerrEntry);
+if(m_pMappedSfxFile != NULL)	// read only memory mapped sequences can't be flagged
+	return(eBSFerrWrite);
 pEntry = &m_pEntriesBlock->Entries[EntryID-1];
 
 if(Loci >= pEntry->SeqLen)	// requested start offset must be less or equal than the end of sequence
@@ -2240,6 +3274,8 @@ etSeqBase *pSeq2;
 
 if(m_pEntriesBlock == NULL || EntryID1 < 1 || (UINT32)EntryID1 > m_pEntriesBlock->NumEntries || EntryID2 < 1 || (UINT32)EntryID2 > m_pEntriesBlock->NumEntries|| m_bColorspace)
 	return(eBSFerrEntry);
+if(m_pMappedSfxFile != NULL)	// read only memory mapped sequences can't be flagged
+	return(eBSFerrWrite);
 
 
 pEntry1 = &m_pEntriesBlock->Entries[EntryID1-1];
@@ -2344,105 +3380,505 @@ else
 return(RetLen);
 }
 
-// GetPtrSeq
-// Returns a ptr to the sequence at EntryID starting at offset Loci
-etSeqBase *
-CSfxArrayV3::GetPtrSeq(int EntryID,UINT32 Loci)
+// GetPtrSeq
+// Returns a ptr to the sequence at EntryID starting at offset Loci
+etSeqBase *
+CSfxArrayV3::GetPtrSeq(int EntryID,UINT32 Loci)
+{
+int Rslt;
+tsSfxEntry *pEntry;
+etSeqBase *pSeq;
+if(m_pEntriesBlock == NULL || EntryID < 1 || (UINT32)EntryID > m_pEntriesBlock->NumEntries)
+	return(NULL);
+pEntry = &m_pEntriesBlock->Entries[EntryID-1];
+if(Loci >= pEntry->SeqLen)	// requested start offset must be less or equal than the end of sequence
+	return(NULL);
+
+// ensure SfxBlock containing entry sequence is loaded into memory
+if(m_pSfxBlock == NULL || m_pSfxBlock->BlockID != (pEntry->fBlockID & 0x0ff))
+	if((Rslt=Disk2SfxBlock(pEntry->fBlockID & 0x0ff))!=eBSFSuccess)
+		return(NULL);
+pSeq = &m_pSfxBlock->SeqSuffix[pEntry->StartOfs];
+return(&pSeq[Loci]);
+}
+
+
+// GetColorspaceSeq
+// Returns a copy of the requested subsequence in color space into pRetSeq from the
+// sequence at EntryID starting at offset Loci and of length Len
+UINT32			// returned sequence length (may be shorter than that requested) or 0 if errors
+CSfxArrayV3::GetColorspaceSeq(int EntryID,UINT32 Loci,etSeqBase *pRetSeq,UINT32 Len)
+{
+UINT32 Rslt;
+UINT32 RetLen;
+tsSfxEntry *pEntry;
+etSeqBase *pSeq;
+if(m_pEntriesBlock == NULL || EntryID < 1 || (UINT32)EntryID > m_pEntriesBlock->NumEntries || !m_bColorspace)
+	return(0);
+pEntry = &m_pEntriesBlock->Entries[EntryID-1];
+if(Loci >= pEntry->SeqLen)	// requested start offset must be less or equal than the end of sequence
+	return(0);
+
+// ensure SfxBlock containing entry sequence is loaded into memory
+if(m_pSfxBlock == NULL || m_pSfxBlock->BlockID != (pEntry->fBlockID & 0xff))
+	if((Rslt=Disk2SfxBlock(pEntry->fBlockID & 0x0ff))!=eBSFSuccess)
+		return(0);
+pSeq = &m_pSfxBlock->SeqSuffix[pEntry->StartOfs];
+RetLen = Len = min(Len,pEntry->SeqLen - Loci);
+pSeq = &pSeq[Loci];
+while(Len--)
+	*pRetSeq++ = *pSeq++ & 0x0f;
+return(RetLen);
+}
+
+// ExactMatchLen
+// Returns the exact match length, up to MaxMatchLen, 3' to pProbe and pTarg
+// Extends  probe against target taking into account the eBaseEOS terminator
+int													// length of exact match
+CSfxArrayV3::ExactMatchLen(etSeqBase *pProbe,		// determine exactly matching length between probe
+							etSeqBase *pTarg,		// and target sequences
+							int MaxMatchLen)		// for up to this length
+{
+int MatchLen;
+UINT8 El1;
+UINT8 El2;
+if(pProbe == NULL || pTarg == NULL || MaxMatchLen == 0)
+	return(0);
+for(MatchLen=0; MatchLen < MaxMatchLen; MatchLen++)
+	{
+	El2 = *pTarg++ & 0x0f;
+	if(El2 > eBaseT)
+		break;
+	El1 = *pProbe++ & 0x0f;
+	if(El1 > eBaseT)
+		break;
+	if(El1 != El2)
+		break;
+	}
+return(MatchLen);
+}
+
+
+// CmpProbeTargScalar
+// Scalar kernel for CmpProbeTarg
+static int
+CmpProbeTargScalar(etSeqBase *pEl1,etSeqBase *pEl2,int Len)
+{
+int Psn;
+UINT8 El1;
+UINT8 El2;
+for(Psn=0; Psn < Len; Psn++)
+	{
+	El2 = *pEl2++ & 0x0f;
+	if(El2 == eBaseEOS)
+		return(-1);
+	El1 = *pEl1++ & 0x0f;
+	if(El1 > El2)
+		return(1);
+	if(El1 < El2)
+		return(-1);
+	}
+return(0);
+}
+
+// ProbeTargMMsScalar
+// Scalar kernel counting the number of probe bases which mismatch the target, ignoring any flags in bits 4..7
+// Returns -1 if target contains an eBaseEOS
+static int
+ProbeTargMMsScalar(etSeqBase *pProbe,etSeqBase *pTarg,int Len)
+{
+int Psn;
+int MMCnt;
+UINT8 TargBase;
+MMCnt = 0;
+for(Psn=0; Psn < Len; Psn++)
+	{
+	if((TargBase = *pTarg++ & 0x0f) == eBaseEOS)
+		return(-1);
+	if((*pProbe++ & 0x0f) != TargBase)
+		MMCnt += 1;
+	}
+return(MMCnt);
+}
+
+#ifdef SFX_SIMD_X86
+
+// LowBitIdx
+// Returns index of lowest set bit in a non-zero mask
+static inline int
+LowBitIdx(UINT32 Bits)
+{
+#ifdef _WIN32
+unsigned long Idx;
+_BitScanForward(&Idx,Bits);
+return((int)Idx);
+#else
+return(__builtin_ctz(Bits));
+#endif
+}
+
+// CmpProbeTargSSE2
+// SSE2 kernel for CmpProbeTarg, 16 bases per iteration, the first differing or target eBaseEOS base determines result
+static int
+CmpProbeTargSSE2(etSeqBase *pEl1,etSeqBase *pEl2,int Len)
+{
+int Psn;
+int Idx;
+UINT32 Bits;
+__m128i LoNibbles = _mm_set1_epi8(0x0f);
+__m128i EOSs = _mm_set1_epi8(eBaseEOS);
+__m128i Probe;
+__m128i Targ;
+for(Psn = 0; Psn + 16 <= Len; Psn += 16)
+	{
+	Probe = _mm_and_si128(_mm_loadu_si128((__m128i *)&pEl1[Psn]),LoNibbles);
+	Targ = _mm_and_si128(_mm_loadu_si128((__m128i *)&pEl2[Psn]),LoNibbles);
+	Bits = ~(UINT32)_mm_movemask_epi8(_mm_cmpeq_epi8(Probe,Targ)) & 0x0ffff;
+	Bits |= (UINT32)_mm_movemask_epi8(_mm_cmpeq_epi8(Targ,EOSs));
+	if(Bits)
+		{
+		Idx = Psn + LowBitIdx(Bits);
+		return(CmpProbeTargScalar(&pEl1[Idx],&pEl2[Idx],1));
+		}
+	}
+return(CmpProbeTargScalar(&pEl1[Psn],&pEl2[Psn],Len - Psn));
+}
+
+// ProbeTargMMsSSE2
+// SSE2 kernel for counting probe vs target mismatches, 16 bases per iteration
+static int
+ProbeTargMMsSSE2(etSeqBase *pProbe,etSeqBase *pTarg,int Len)
+{
+int Psn;
+int MMCnt;
+int Rslt;
+__m128i LoNibbles = _mm_set1_epi8(0x0f);
+__m128i EOSs = _mm_set1_epi8(eBaseEOS);
+__m128i Probe;
+__m128i Targ;
+MMCnt = 0;
+for(Psn = 0; Psn + 16 <= Len; Psn += 16)
+	{
+	Probe = _mm_and_si128(_mm_loadu_si128((__m128i *)&pProbe[Psn]),LoNibbles);
+	Targ = _mm_and_si128(_mm_loadu_si128((__m128i *)&pTarg[Psn]),LoNibbles);
+	if(_mm_movemask_epi8(_mm_cmpeq_epi8(Targ,EOSs)))
+		return(-1);
+	MMCnt += 16 - PopCount64((UINT64)_mm_movemask_epi8(_mm_cmpeq_epi8(Probe,Targ)));
+	}
+if((Rslt = ProbeTargMMsScalar(&pProbe[Psn],&pTarg[Psn],Len - Psn)) < 0)
+	return(-1);
+return(MMCnt + Rslt);
+}
+
+// CmpProbeTargAVX2
+// AVX2 kernel for CmpProbeTarg, 32 bases per iteration
+SFX_TARGET_AVX2 static int
+CmpProbeTargAVX2(etSeqBase *pEl1,etSeqBase *pEl2,int Len)
+{
+int Psn;
+int Idx;
+UINT32 Bits;
+__m256i LoNibbles = _mm256_set1_epi8(0x0f);
+__m256i EOSs = _mm256_set1_epi8(eBaseEOS);
+__m256i Probe;
+__m256i Targ;
+for(Psn = 0; Psn + 32 <= Len; Psn += 32)
+	{
+	Probe = _mm256_and_si256(_mm256_loadu_si256((__m256i *)&pEl1[Psn]),LoNibbles);
+	Targ = _mm256_and_si256(_mm256_loadu_si256((__m256i *)&pEl2[Psn]),LoNibbles);
+	Bits = ~(UINT32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Probe,Targ));
+	Bits |= (UINT32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Targ,EOSs));
+	if(Bits)
+		{
+		Idx = Psn + LowBitIdx(Bits);
+		return(CmpProbeTargScalar(&pEl1[Idx],&pEl2[Idx],1));
+		}
+	}
+_mm256_zeroupper();		// avoiding AVX to SSE transition penalties in the SSE2 kernel processing the remaining bases
+return(CmpProbeTargSSE2(&pEl1[Psn],&pEl2[Psn],Len - Psn));
+}
+
+// ProbeTargMMsAVX2
+// AVX2 kernel for counting probe vs target mismatches, 32 bases per iteration
+SFX_TARGET_AVX2 static int
+ProbeTargMMsAVX2(etSeqBase *pProbe,etSeqBase *pTarg,int Len)
+{
+int Psn;
+int MMCnt;
+int Rslt;
+__m256i LoNibbles = _mm256_set1_epi8(0x0f);
+__m256i EOSs = _mm256_set1_epi8(eBaseEOS);
+__m256i Probe;
+__m256i Targ;
+MMCnt = 0;
+for(Psn = 0; Psn + 32 <= Len; Psn += 32)
+	{
+	Probe = _mm256_and_si256(_mm256_loadu_si256((__m256i *)&pProbe[Psn]),LoNibbles);
+	Targ = _mm256_and_si256(_mm256_loadu_si256((__m256i *)&pTarg[Psn]),LoNibbles);
+	if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(Targ,EOSs)))
+		return(-1);
+	MMCnt += 32 - PopCount64((UINT64)(UINT32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Probe,Targ)));
+	}
+_mm256_zeroupper();
+if((Rslt = ProbeTargMMsSSE2(&pProbe[Psn],&pTarg[Psn],Len - Psn)) < 0)
+	return(-1);
+return(MMCnt + Rslt);
+}
+
+// HasAVX2
+// Returns true if both CPU and OS support AVX2
+static bool
+HasAVX2(void)
+{
+#ifdef _WIN32
+int CPUInfo[4];
+__cpuid(CPUInfo,0);
+if(CPUInfo[0] < 7)
+	return(false);
+__cpuid(CPUInfo,1);
+if((CPUInfo[2] & (1 << 27)) == 0 || (CPUInfo[2] & (1 << 28)) == 0)	// OSXSAVE and AVX
+	return(false);
+if((_xgetbv(0) & 0x06) != 0x06)										// OS saves XMM and YMM state
+	return(false);
+__cpuidex(CPUInfo,7,0);
+return((CPUInfo[1] & (1 << 5)) != 0 ? true : false);
+#else
+__builtin_cpu_init();
+return(__builtin_cpu_supports("avx2") ? true : false);
+#endif
+}
+#endif
+
+// InitCmpKernels
+// Selects, once only, the probe vs target compare kernels most appropriate for the executing CPU
+static void
+InitCmpKernels(void)
+{
+if(gpCmpProbeTarg != NULL)
+	return;
+#ifdef SFX_SIMD_X86
+if(HasAVX2())
+	{
+	gpProbeTargMMs = ProbeTargMMsAVX2;
+	gpCmpProbeTarg = CmpProbeTargAVX2;
+	}
+else
+	{
+	gpProbeTargMMs = ProbeTargMMsSSE2;
+	gpCmpProbeTarg = CmpProbeTargSSE2;
+	}
+#else
+gpProbeTargMMs = ProbeTargMMsScalar;
+gpCmpProbeTarg = CmpProbeTargScalar;
+#endif
+}
+
+const char *
+CSfxArrayV3::GetCmpKernelName(void)	// returns name of the probe vs target compare kernels selected for this CPU
 {
-int Rslt;
-tsSfxEntry *pEntry;
-etSeqBase *pSeq;
-if(m_pEntriesBlock == NULL || EntryID < 1 || (UINT32)EntryID > m_pEntriesBlock->NumEntries)
-	return(NULL);
-pEntry = &m_pEntriesBlock->Entries[EntryID-1];
-if(Loci >= pEntry->SeqLen)	// requested start offset must be less or equal than the end of sequence
-	return(NULL);
-
-// ensure SfxBlock containing entry sequence is loaded into memory
-if(m_pSfxBlock == NULL || m_pSfxBlock->BlockID != (pEntry->fBlockID & 0x0ff))
-	if((Rslt=Disk2SfxBlock(pEntry->fBlockID & 0x0ff))!=eBSFSuccess)
-		return(NULL);
-pSeq = &m_pSfxBlock->SeqSuffix[pEntry->StartOfs];
-return(&pSeq[Loci]);
+InitCmpKernels();
+#ifdef SFX_SIMD_X86
+if(gpCmpProbeTarg == CmpProbeTargAVX2)
+	return("AVX2");
+if(gpCmpProbeTarg == CmpProbeTargSSE2)
+	return("SSE2");
+#endif
+return("scalar");
 }
 
-
-// GetColorspaceSeq
-// Returns a copy of the requested subsequence in color space into pRetSeq from the
-// sequence at EntryID starting at offset Loci and of length Len
-UINT32			// returned sequence length (may be shorter than that requested) or 0 if errors
-CSfxArrayV3::GetColorspaceSeq(int EntryID,UINT32 Loci,etSeqBase *pRetSeq,UINT32 Len)
+// BenchCmpKernels
+// Microbenchmark of the probe vs target compare and mismatch counting kernels over simulated 100..300bp reads
+// Reads are drawn from a pool of probe and target pairs which are identical, have 1% or 5% mismatches, or are unrelated; bases
+// are randomly flagged in bits 4..7 and every 16th target contains an eBaseEOS. Every kernel available on this CPU is first
+// checked against the scalar kernels over the whole pool and then timed against the scalar kernels
+const int cBenchCmpPoolReads = 4096;			// number of simulated probe and target pairs in pool
+const int cBenchCmpReadStride = 320;			// pairs in pool start at multiples of this offset, must be more than the longest benchmarked read
+const INT64 cBenchCmpBases = 200000000;			// each kernel is timed over this many bases at each read length
+const int cBenchCmpTimings = 3;					// reporting the fastest of this many timings so other processes have less impact
+
+typedef int (*tpCmpKernel)(etSeqBase *pProbe,etSeqBase *pTarg,int Len);
+
+typedef struct TAG_sBenchCmpKernel {
+	const char *pszName;						// kernel name
+	tpCmpKernel pCmpProbeTarg;					// CmpProbeTarg kernel
+	tpCmpKernel pProbeTargMMs;					// mismatch counting kernel
+	double CmpSecs;								// time taken by CmpProbeTarg kernel at current read length
+	double MMsSecs;								// time taken by mismatch counting kernel at current read length
+	} tsBenchCmpKernel;
+
+// TimeCmpKernel
+// Returns fastest elapsed seconds, over cBenchCmpTimings timings, for NumReads calls of Kernel over reads drawn sequentially from the pool
+static double
+TimeCmpKernel(tpCmpKernel Kernel,etSeqBase *pProbes,etSeqBase *pTargs,int ReadLen,int NumReads,INT64 *pChkSum)
 {
-UINT32 Rslt;
-UINT32 RetLen;
-tsSfxEntry *pEntry;
-etSeqBase *pSeq;
-if(m_pEntriesBlock == NULL || EntryID < 1 || (UINT32)EntryID > m_pEntriesBlock->NumEntries || !m_bColorspace)
-	return(0);
-pEntry = &m_pEntriesBlock->Entries[EntryID-1];
-if(Loci >= pEntry->SeqLen)	// requested start offset must be less or equal than the end of sequence
-	return(0);
-
-// ensure SfxBlock containing entry sequence is loaded into memory
-if(m_pSfxBlock == NULL || m_pSfxBlock->BlockID != (pEntry->fBlockID & 0xff))
-	if((Rslt=Disk2SfxBlock(pEntry->fBlockID & 0x0ff))!=eBSFSuccess)
-		return(0);
-pSeq = &m_pSfxBlock->SeqSuffix[pEntry->StartOfs];
-RetLen = Len = min(Len,pEntry->SeqLen - Loci);
-pSeq = &pSeq[Loci];
-while(Len--)
-	*pRetSeq++ = *pSeq++ & 0x0f;
-return(RetLen);
+int TimingIdx;
+int ReadIdx;
+int PoolIdx;
+INT64 ChkSum;
+double ElapsedSecs;
+double MinSecs;
+unsigned long Secs;
+unsigned long USecs;
+CStopWatch BenchTimer;
+MinSecs = 0.0;
+for(TimingIdx = 0; TimingIdx < cBenchCmpTimings; TimingIdx++)
+	{
+	ChkSum = 0;
+	BenchTimer.Reset();
+	BenchTimer.Start();
+	for(ReadIdx = PoolIdx = 0; ReadIdx < NumReads; ReadIdx++)
+		{
+		ChkSum += Kernel(&pProbes[PoolIdx * cBenchCmpReadStride],&pTargs[PoolIdx * cBenchCmpReadStride],ReadLen);
+		if(++PoolIdx == cBenchCmpPoolReads)
+			PoolIdx = 0;
+		}
+	BenchTimer.Stop();
+	Secs = BenchTimer.ReadUSecs(&USecs);
+	ElapsedSecs = (double)Secs + (double)USecs / 1000000.0;
+	if(TimingIdx == 0 || ElapsedSecs < MinSecs)
+		MinSecs = ElapsedSecs;
+	*pChkSum += ChkSum;
+	}
+return(MinSecs);
 }
 
-// ExactMatchLen
-// Returns the exact match length, up to MaxMatchLen, 3' to pProbe and pTarg
-// Extends  probe against target taking into account the eBaseEOS terminator
-int													// length of exact match
-CSfxArrayV3::ExactMatchLen(etSeqBase *pProbe,		// determine exactly matching length between probe
-							etSeqBase *pTarg,		// and target sequences
-							int MaxMatchLen)		// for up to this length
+int												// eBSFSuccess, eBSFerrMem if unable to allocate pool, eBSFerrInternal if any kernel disagrees with the scalar kernels
+CSfxArrayV3::BenchCmpKernels(int Seed)			// pseudo-random generator seed used when simulating reads
 {
-int MatchLen;
-UINT8 El1;
-UINT8 El2;
-if(pProbe == NULL || pTarg == NULL || MaxMatchLen == 0)
-	return(0);
-for(MatchLen=0; MatchLen < MaxMatchLen; MatchLen++)
+static const int ReadLens[] = {100,150,200,250,300};
+tsBenchCmpKernel Kernels[3];
+int NumKernels;
+int KernelIdx;
+int LenIdx;
+int ReadLen;
+int NumReads;
+int PoolIdx;
+int Psn;
+int MMRate;
+int Rslt;
+UINT8 Flags;
+etSeqBase *pProbe;
+etSeqBase *pTarg;
+etSeqBase *pProbes;
+etSeqBase *pTargs;
+INT64 ChkSum;
+
+InitCmpKernels();
+memset(Kernels,0,sizeof(Kernels));
+Kernels[0].pszName = "scalar";
+Kernels[0].pCmpProbeTarg = CmpProbeTargScalar;
+Kernels[0].pProbeTargMMs = ProbeTargMMsScalar;
+NumKernels = 1;
+#ifdef SFX_SIMD_X86
+Kernels[1].pszName = "SSE2";
+Kernels[1].pCmpProbeTarg = CmpProbeTargSSE2;
+Kernels[1].pProbeTargMMs = ProbeTargMMsSSE2;
+NumKernels = 2;
+if(HasAVX2())
+	{
+	Kernels[2].pszName = "AVX2";
+	Kernels[2].pCmpProbeTarg = CmpProbeTargAVX2;
+	Kernels[2].pProbeTargMMs = ProbeTargMMsAVX2;
+	NumKernels = 3;
+	}
+#endif
+
+// pool is over allocated so the SIMD kernels can never load past the end of the last pair
+if((pProbes = new etSeqBase [(cBenchCmpPoolReads + 1) * cBenchCmpReadStride]) == NULL)
+	return(eBSFerrMem);
+if((pTargs = new etSeqBase [(cBenchCmpPoolReads + 1) * cBenchCmpReadStride]) == NULL)
 	{
-	El2 = *pTarg++ & 0x0f;
-	if(El2 > eBaseT)
-		break;
-	El1 = *pProbe++ & 0x0f;
-	if(El1 > eBaseT)
-		break;
-	if(El1 != El2)
+	delete[] pProbes;
+	return(eBSFerrMem);
+	}
+
+TRandomCombined<CRandomMother,CRandomMersenne> RG(Seed);
+for(PoolIdx = 0; PoolIdx < cBenchCmpPoolReads; PoolIdx++)
+	{
+	pProbe = &pProbes[PoolIdx * cBenchCmpReadStride];
+	pTarg = &pTargs[PoolIdx * cBenchCmpReadStride];
+	switch(PoolIdx % 4) {
+		case 0:					// identical
+			MMRate = 0;
+			break;
+		case 1:					// 1% mismatches
+			MMRate = 10;
+			break;
+		case 2:					// 5% mismatches
+			MMRate = 50;
+			break;
+		default:				// unrelated
+			MMRate = 750;
+			break;
+		}
+	for(Psn = 0; Psn < cBenchCmpReadStride; Psn++)
+		{
+		Flags = RG.IRandom(0,7) == 0 ? cMarkMskFlg : 0;
+		pProbe[Psn] = (etSeqBase)(RG.IRandom(0,3) | Flags);
+		if(MMRate && RG.IRandom(0,999) < MMRate)
+			pTarg[Psn] = (etSeqBase)((((pProbe[Psn] & 0x0f) + RG.IRandom(1,3)) & 0x03) | Flags);
+		else
+			pTarg[Psn] = pProbe[Psn];
+		}
+	if((PoolIdx % 16) == 15)
+		pTarg[RG.IRandom(0,ReadLens[(sizeof(ReadLens)/sizeof(ReadLens[0])) - 1] - 1)] = eBaseEOS;
+	}
+memset(&pProbes[cBenchCmpPoolReads * cBenchCmpReadStride],eBaseA,cBenchCmpReadStride);
+memset(&pTargs[cBenchCmpPoolReads * cBenchCmpReadStride],eBaseA,cBenchCmpReadStride);
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"BenchCmpKernels: selected kernels are '%s', benchmarking %d kernel(s) over %d simulated reads at each read length",GetCmpKernelName(),NumKernels,cBenchCmpPoolReads);
+
+Rslt = eBSFSuccess;
+ChkSum = 0;
+for(LenIdx = 0; Rslt == eBSFSuccess && LenIdx < (int)(sizeof(ReadLens)/sizeof(ReadLens[0])); LenIdx++)
+	{
+	ReadLen = ReadLens[LenIdx];
+
+	// check every SIMD kernel returns exactly what the scalar kernels return for every read
+	for(PoolIdx = 0; Rslt == eBSFSuccess && PoolIdx < cBenchCmpPoolReads; PoolIdx++)
+		{
+		pProbe = &pProbes[PoolIdx * cBenchCmpReadStride];
+		pTarg = &pTargs[PoolIdx * cBenchCmpReadStride];
+		for(KernelIdx = 1; KernelIdx < NumKernels; KernelIdx++)
+			{
+			if(Kernels[KernelIdx].pCmpProbeTarg(pProbe,pTarg,ReadLen) != CmpProbeTargScalar(pProbe,pTarg,ReadLen) ||
+				Kernels[KernelIdx].pProbeTargMMs(pProbe,pTarg,ReadLen) != ProbeTargMMsScalar(pProbe,pTarg,ReadLen))
+				{
+				gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchCmpKernels: %s kernel disagrees with scalar kernel on %dbp read %d",Kernels[KernelIdx].pszName,ReadLen,PoolIdx);
+				Rslt = eBSFerrInternal;
+				break;
+				}
+			}
+		}
+	if(Rslt != eBSFSuccess)
 		break;
+
+	NumReads = (int)(cBenchCmpBases / ReadLen);
+	for(KernelIdx = 0; KernelIdx < NumKernels; KernelIdx++)
+		{
+		Kernels[KernelIdx].CmpSecs = TimeCmpKernel(Kernels[KernelIdx].pCmpProbeTarg,pProbes,pTargs,ReadLen,NumReads,&ChkSum);
+		Kernels[KernelIdx].MMsSecs = TimeCmpKernel(Kernels[KernelIdx].pProbeTargMMs,pProbes,pTargs,ReadLen,NumReads,&ChkSum);
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"BenchCmpKernels: %dbp reads, %s kernels: compare %1.1f ns/read (%1.2fx scalar), mismatches %1.1f ns/read (%1.2fx scalar)",
+						ReadLen,Kernels[KernelIdx].pszName,
+						(Kernels[KernelIdx].CmpSecs * 1000000000.0) / NumReads,
+						Kernels[KernelIdx].CmpSecs > 0.0 ? Kernels[0].CmpSecs / Kernels[KernelIdx].CmpSecs : 0.0,
+						(Kernels[KernelIdx].MMsSecs * 1000000000.0) / NumReads,
+						Kernels[KernelIdx].MMsSecs > 0.0 ? Kernels[0].MMsSecs / Kernels[KernelIdx].MMsSecs : 0.0);
+		}
 	}
-return(MatchLen);
-}
+gDiagnostics.DiagOut(eDLDiag,gszProcName,"BenchCmpKernels: checksum %lld",(long long)ChkSum);
 
+delete[] pProbes;
+delete[] pTargs;
+return(Rslt);
+}
 
 // CmpProbeTarg
 // Compares probe against target taking into account the eBaseEOS terminator
 int
 CSfxArrayV3::CmpProbeTarg(etSeqBase *pEl1,etSeqBase *pEl2,int Len)
 {
-int Psn;
-UINT8 El1;
-UINT8 El2;
-for(Psn=0; Psn < Len; Psn++)
-	{
-	El2 = *pEl2++ & 0x0f;
-	if(El2 == eBaseEOS)
-		return(-1);
-	El1 = *pEl1++ & 0x0f;
-	if(El1 > El2)
-		return(1);
-	if(El1 < El2)
-		return(-1);
-	}
-return(0);
+return(gpCmpProbeTarg(pEl1,pEl2,Len));
 }
 
 
@@ -2677,7 +4113,7 @@ if(NumThreads < 1 || NumThreads > 64 ||
 *pEndSfxIdx = 0;
 if(m_pSfxBlock == NULL)
 	return(-1);
-NumSfxEls = m_pSfxBlock->ConcatSeqLen;
+NumSfxEls = GetNumSfxEls();
 if(StartSfxIdx >= NumSfxEls)
 	return(-1);
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
@@ -2701,7 +4137,7 @@ PutativeEndSfxEl += 1;
 for(;PutativeEndSfxEl < NumSfxEls; PutativeEndSfxEl++)
 	{
 	TargPsn2 = SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,PutativeEndSfxEl);
-	if((TargPsn2 + KMerLen) >= NumSfxEls)
+	if((TargPsn2 + KMerLen) >= (INT64)m_pSfxBlock->ConcatSeqLen)
 		{
 		*pEndSfxIdx = PutativeEndSfxEl;
 		return(1);
@@ -2786,17 +4222,17 @@ if((UINT32)MinCultivars > m_pSfxBlock->NumEntries)
 if(MinCultivars == 0)
 	MinCultivars = m_pSfxBlock->NumEntries;
 
-if(StartSfxIdx > (INT64)m_pSfxBlock->ConcatSeqLen)
+if(StartSfxIdx > GetNumSfxEls())
 	return(-1);
 
-if(EndSfxIdx == 0 || EndSfxIdx >= (INT64)m_pSfxBlock->ConcatSeqLen)
-	EndSfxIdx = m_pSfxBlock->ConcatSeqLen - 1;
+if(EndSfxIdx == 0 || EndSfxIdx >= GetNumSfxEls())
+	EndSfxIdx = GetNumSfxEls() - 1;
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
 ConcatSeqLen = m_pSfxBlock->ConcatSeqLen;
 NumSfxEntries = m_pSfxBlock->NumEntries;
-NumSfxEls = m_pSfxBlock->ConcatSeqLen;
+NumSfxEls = GetNumSfxEls();
 
 Rslt = 0;
 NumKMersLocated = 0;
@@ -3103,7 +4539,7 @@ pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
 ConcatSeqLen = m_pSfxBlock->ConcatSeqLen;
 NumSfxEntries = m_pSfxBlock->NumEntries;
-NumSfxEls = m_pSfxBlock->ConcatSeqLen;
+NumSfxEls = GetNumSfxEls();
 
  // start processing
 // first identify the prefixes which are common to the cultivars
@@ -3253,12 +4689,12 @@ if(MaxExtdLen == 0 || pHitExtdLen == NULL)
 *pHitExtdLen = 0;
 
 // ensure suffix loaded for iteration and prev hit was not the last!
-if(m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= m_pSfxBlock->ConcatSeqLen)
+if(m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= (UINT64)GetNumSfxEls())
 	return(0);
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 if(!PrevHitIdx)
 	{
@@ -3328,12 +4764,12 @@ if(ppTargSeq != NULL)
 	*ppTargSeq = NULL;
 
 // ensure suffix loaded for iteration and prev hit was not the last!
-if(m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= m_pSfxBlock->ConcatSeqLen)
+if(m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= (UINT64)GetNumSfxEls())
 	return(0);
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 if(!PrevHitIdx)
 	{
@@ -3411,12 +4847,12 @@ CSfxArrayV3::IterateExactsRange(etSeqBase *pProbeSeq,	// probe sequence
 		return(0);
 
 	// ensure suffix loaded for iteration and prev hit was not the last!
-	if (m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= m_pSfxBlock->ConcatSeqLen)
+	if (m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= (UINT64)GetNumSfxEls())
 		return(0);
 
 	pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 	pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-	SfxLen = m_pSfxBlock->ConcatSeqLen;
+	SfxLen = GetNumSfxEls();
 
 	if (!PrevHitIdx)
 		{
@@ -3823,7 +5259,7 @@ etSeqBase *pEl2;
 
 // ensure suffix loaded for iteration and prev hit was not the last!
 // also require that the probe length must be at least 100 + SeedCoreLen so matching subseqs can be explored
-if(SeedCoreLen < cMinPacBioSeedCoreLen || SeedCoreLen > cMaxPacBioSeedCoreLen || ProbeLen < SeedCoreLen || m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= m_pSfxBlock->ConcatSeqLen)
+if(SeedCoreLen < cMinPacBioSeedCoreLen || SeedCoreLen > cMaxPacBioSeedCoreLen || ProbeLen < SeedCoreLen || m_pSfxBlock == NULL || (UINT64)PrevHitIdx >= (UINT64)GetNumSfxEls())
 	return(0);
 
 if(SeedCoreLen >= AcceptExactExtdCoreLen)	// if looking with seed cores of at least 50bp (cMaxPacBioSeedCoreLen currently is 100bp)  then will not bother to seed extend. Alignments should be reasonably high confidence.
@@ -3872,7 +5308,7 @@ if(ProbeLen < cPacBioSeedCoreExtn)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 bFirst = false;
 
 if(!PrevHitIdx)	// if locate first exact match using SeedCoreLen
@@ -4279,6 +5715,10 @@ int CurProbeSegOfs;
 int CurProbeSegLen;
 int CoreLen;
 int SegIdx;
+int SamplePhase;
+int NumSamplePhases;
+int KeyOfs;
+int KeyLen;
 UINT32 IterCnt;
 int CurHamming;
 int MaxSegIdx;
@@ -4315,8 +5755,8 @@ if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 	return(-1);
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
-pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[SfxLen];
+pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
+SfxLen = GetNumSfxEls();
 if(bSAHammings)
 	{
 	if(ProbeLen >= sizeof(RevCplSeq1Kbp))
@@ -4382,6 +5822,18 @@ if(RHammMax == 0)		// if caller was only interested in hammings of 0 then any ot
 // expected Hamming is at least 1
 CoreLen = ProbeLen/(RHammMax + 1);
 CurHamming = ProbeLen/CoreLen;
+
+// if suffix array has been sampled then a segment exactly matching at target loci T will only be indexed at T+Phase, where T+Phase is a multiple of the sample rate,
+// so each segment is searched as keys starting at Phase 0..SampleRate-1 into that segment; segments shorter than the sample rate can't guarantee all hammings will be located
+NumSamplePhases = (int)m_SfxSampleRate;
+if(NumSamplePhases > CoreLen)
+	{
+	if(pRevCplSeq != NULL && (ProbeLen >= sizeof(RevCplSeq1Kbp)))
+		free(pRevCplSeq);
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"LocateHamming: K-mer length %d with hamming %d needs suffix array sampling rate of no more than %d, index sampled at %d",ProbeLen,RHammMax,CoreLen,NumSamplePhases);
+	return(eBSFerrParams);
+	}
+
 bDoAntisense = false;
 do
 	{
@@ -4389,9 +5841,11 @@ do
 	CurProbeSegLen = CoreLen;
 	MaxSegIdx = ProbeLen/CoreLen;
 
-	for(SegIdx = 0; SegIdx < MaxSegIdx; SegIdx++, CurProbeSegOfs += CoreLen)
+	for(SegIdx = 0, SamplePhase = 0; SegIdx < MaxSegIdx; SamplePhase = (SamplePhase + 1) % NumSamplePhases, SegIdx += SamplePhase ? 0 : 1, CurProbeSegOfs += SamplePhase ? 0 : CoreLen)
 		{
-		TargIdx = LocateFirstExact(&pProbeSeq[CurProbeSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
+		KeyOfs = CurProbeSegOfs + SamplePhase;
+		KeyLen = CoreLen - SamplePhase;
+		TargIdx = LocateFirstExact(&pProbeSeq[KeyOfs],KeyLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 
 		if(TargIdx == 0) // if no segment match then onto next segment
 			continue;
@@ -4402,20 +5856,20 @@ do
 			{
 			if(IterCnt++) {				// if iterating subsequent (to LocateFirstExact) targets
 				// ensure not about to iterate past end of suffix array!
-				if((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci((INT32)m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) > (INT64)m_pSfxBlock->ConcatSeqLen)
+				if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci((INT32)m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + KeyLen) > (INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				if(IterCnt == MinCoreDepth  && !NumCopies)
 					{
 					// check how many more exact copies there are of the current probe subsequence, if too many then don't bother exploring these
-					LastTargIdx = LocateLastExact(&pProbeSeq[CurProbeSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,TargIdx-1,SfxLen-1);
+					LastTargIdx = LocateLastExact(&pProbeSeq[KeyOfs],KeyLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,TargIdx-1,SfxLen-1);
 					NumCopies = LastTargIdx > 0 ? (UINT32)(1 + LastTargIdx - TargIdx) : 0;
 					if(MaxCoreDepth && NumCopies > MaxCoreDepth)		// only checking at the MinCoreDepth iteration allows a little slack
 						break;										// try next core segment
 					}
 
 				pTargBase = &pTarg[SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1)]; // then check that target core is still matching
-				pProbeBase = &pProbeSeq[CurProbeSegOfs];
+				pProbeBase = &pProbeSeq[KeyOfs];
 					{
 					int Ofs;
 					UINT8 El1;
@@ -4423,7 +5877,7 @@ do
 					etSeqBase *pEl1= pProbeBase;
 					etSeqBase *pEl2 = pTargBase;
 					Cmp = 0;
-					for(Ofs=0; Ofs < CoreLen; Ofs++)
+					for(Ofs=0; Ofs < KeyLen; Ofs++)
 						{
 						El2 = *pEl2++ & 0x0f;
 						if(El2 == eBaseEOS || El2 == eBaseN)
@@ -4451,11 +5905,11 @@ do
 				}
 
 
-			if(SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx) < (UINT32)CurProbeSegOfs)
+			if(SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx) < (UINT32)KeyOfs)
 				continue;
 
 			TargMatchLen = ProbeLen;
-			TargSeqLeftIdx = SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx) - CurProbeSegOfs;
+			TargSeqLeftIdx = SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx) - KeyOfs;
 			ProbeSeqLeftIdx = 0;
 			PutativeTargLoci = TargSeqLeftIdx;
 
@@ -4603,7 +6057,7 @@ if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 CurProbeSegOfs = 0;
 CurInstances = AccumReadHits;
@@ -4622,7 +6076,7 @@ for(SegIdx = 0; SegIdx <= ExpMismatches; SegIdx++,CurProbeSegOfs += CurProbeSegL
 		{
 		if(IterCnt++) {				// if iterating subsequent (to LocateFirstExact) targets
 			// ensure not about to iterate past end of suffix array!
-			if((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CurProbeSegLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
+			if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CurProbeSegLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
 				break;
 
 			if(IterCnt == 100 && !NumCopies)
@@ -4790,6 +6244,8 @@ UINT8 TargBase;
 
 int Cmp;
 int CurNumCoreSlides;
+int CurCoreBaseOfs;				// core segment relative start before any offset for sampled suffix phase
+int CoreSamplePhase;				// when suffix array is sampled then cores are located at each offset from CurCoreBaseOfs up to the sample rate
 int CurCoreDelta;
 tsHitLoci *pCurHit;
 
@@ -4805,7 +6261,7 @@ if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 pCurHit = NULL;
 CurStrand = '+';			// initially treat probe as not reverse complemented, e.g. '+' matches
@@ -4824,18 +6280,20 @@ do
 	CurNumCoreSlides = 0;
 	memset(pHashArray,0,sizeof(pHashArray));
 	CurNumIdentNodes = 0;
-	for(CurCoreSegOfs = 0;
+	for(CurCoreSegOfs = 0, CurCoreBaseOfs = 0, CoreSamplePhase = 0;
 		CurNumCoreSlides < MaxNumCoreSlides &&
 		CurCoreSegOfs <= (ProbeLen - CoreLen) &&
 		CurCoreDelta > CoreLen/3 &&
 		CurNumIdentNodes < NumAllocdIdentNodes;	// can only allow up to cMaxNumIdentNodes to be saved
-	    CurNumCoreSlides += 1,
-	    CurCoreSegOfs += CurCoreDelta)
+	    CoreSamplePhase = (CoreSamplePhase + 1) % m_SfxSampleRate,
+	    CurNumCoreSlides += CoreSamplePhase ? 0 : 1,
+	    CurCoreBaseOfs += CoreSamplePhase ? 0 : CurCoreDelta,
+	    CurCoreSegOfs = CurCoreBaseOfs + CoreSamplePhase)
 		{
 		if(CurNumCoreSlides >= MaxNumCoreSlides)
 			break;
-		if((CurCoreSegOfs + CoreLen + CurCoreDelta) > ProbeLen)
-			CurCoreDelta = ProbeLen - (CurCoreSegOfs + CoreLen);
+		if((CurCoreBaseOfs + CoreLen + CurCoreDelta) > ProbeLen)
+			CurCoreDelta = ProbeLen - (CurCoreBaseOfs + CoreLen);
 
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
@@ -4853,7 +6311,7 @@ do
 			if(!bFirstIter) {
 
 				// ensure not about to iterate past end of suffix array!
-				if((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
+				if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				if(IterCnt == 100 && !NumCopies)
@@ -5034,7 +6492,7 @@ tsSfxEntry *pEntry;
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 CoreLen = ProbeLen / (1+MaxTotMM);
 
 if(CoreLen < 8)				// have to have a minimum core otherwise may as well do a linear search!
@@ -5106,7 +6564,7 @@ tsSfxEntry *pEntry;
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 CoreLen = ProbeLen / (1+MaxTotMM);
 
 if(CoreLen < 8)				// have to have a minimum core otherwise may as well do a linear search!
@@ -5210,6 +6668,8 @@ UINT8 TargBase;
 
 int Cmp;
 int CurNumCoreSlides;
+int CurCoreBaseOfs;				// core segment relative start before any offset for sampled suffix phase
+int CoreSamplePhase;				// when suffix array is sampled then cores are located at each offset from CurCoreBaseOfs up to the sample rate
 int CurCoreDelta;
 tsHitLoci *pCurHit;
 
@@ -5224,7 +6684,7 @@ if (m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 
 LowHitInstances = 0;
@@ -5255,18 +6715,20 @@ do
 	CurNumCoreSlides = 0;
 	memset(pHashArray, 0, sizeof(pHashArray));
 	CurNumIdentNodes = 0;
-	for (CurCoreSegOfs = 0;
+	for (CurCoreSegOfs = 0, CurCoreBaseOfs = 0, CoreSamplePhase = 0;
 			CurNumCoreSlides < MaxNumCoreSlides &&
 			CurCoreSegOfs <= (ProbeLen - CoreLen) &&
 			CurCoreDelta > CoreLen / 3 &&
 			CurNumIdentNodes < NumAllocdIdentNodes;	// can only allow upto cMaxNumIdentNodes to be saved
-	CurNumCoreSlides += 1,
-	CurCoreSegOfs += CurCoreDelta)
+	CoreSamplePhase = (CoreSamplePhase + 1) % m_SfxSampleRate,
+	CurNumCoreSlides += CoreSamplePhase ? 0 : 1,
+	CurCoreBaseOfs += CoreSamplePhase ? 0 : CurCoreDelta,
+	CurCoreSegOfs = CurCoreBaseOfs + CoreSamplePhase)
 		{
 		if (CurNumCoreSlides >= MaxNumCoreSlides)
 			break;
-		if ((CurCoreSegOfs + CoreLen + CurCoreDelta) > ProbeLen)
-			CurCoreDelta = ProbeLen - (CurCoreSegOfs + CoreLen);
+		if ((CurCoreBaseOfs + CoreLen + CurCoreDelta) > ProbeLen)
+			CurCoreDelta = ProbeLen - (CurCoreBaseOfs + CoreLen);
 
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs], CoreLen, pTarg, m_pSfxBlock->SfxElSize, pSfxArray, 0, 0, SfxLen - 1);
 		if (TargIdx == 0)        // 0 if no core segment matches
@@ -5285,7 +6747,7 @@ do
 				{
 
 					// ensure not about to iterate past end of suffix array!
-				if ((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize, pSfxArray, TargIdx + 1) + CoreLen) >(INT64)m_pSfxBlock->ConcatSeqLen)
+				if ((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize, pSfxArray, TargIdx + 1) + CoreLen) >(INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				if (IterCnt == 100 && !NumCopies)
@@ -5755,6 +7217,8 @@ UINT8 TargBase;
 
 int Cmp;
 int CurNumCoreSlides;
+int CurCoreBaseOfs;				// core segment relative start before any offset for sampled suffix phase
+int CoreSamplePhase;				// when suffix array is sampled then cores are located at each offset from CurCoreBaseOfs up to the sample rate
 int CurCoreDelta;
 tsHitLoci *pCurHit;
 
@@ -5762,6 +7226,9 @@ etSeqBase *pTarg;			// target sequence
 void *pSfxArray;			// target sequence suffix array
 INT64 SfxLen;				// number of suffixs in pSfxArray
 tsSfxEntry *pEntry;
+bool bPackedProbe;			// true if probe packed into ProbeWords for packed mismatch counting
+bool bPackedTarg;			// true if target has a 2bit packed sequence
+UINT64 ProbeWords[(cMaxPackedProbeLen + 31) / 32];	// probe packed 2bits per base
 BisBase=eBaseN;
 
 // force MinChimericLen to be either 0, or in the range 50..99. if MinChimericLen is < 50 or > 99 then treat as if a normal full length match required
@@ -5784,8 +7251,8 @@ if(*pLowHitInstances >= 1 && *pLowMMCnt == 0 && (*pNxtLowMMCnt - *pLowMMCnt) < M
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
-
+SfxLen = GetNumSfxEls();
+bPackedTarg = MinProbeChimericLen == 0 && IsMMScanAccel() && m_PackedSeqLen == m_pSfxBlock->ConcatSeqLen;
 
 if(*pLowHitInstances <= 0 || *pLowMMCnt < 0 || *pNxtLowMMCnt < 0)	// if never seen any previous matches then ensure substitution counts are initialised
 	{
@@ -5829,22 +7296,25 @@ BestMaxChimericMMs = 0;
 
 do
 	{
+	bPackedProbe = bPackedTarg && PackProbe(ProbeLen,pProbeSeq,ProbeWords);
 	CurCoreDelta = CoreDelta;
 	CurNumCoreSlides = 0;
 	memset(pHashArray,0,sizeof(pHashArray));
 	CurNumIdentNodes = 0;
-	for(CurCoreSegOfs = 0;
+	for(CurCoreSegOfs = 0, CurCoreBaseOfs = 0, CoreSamplePhase = 0;
 		CurNumCoreSlides < MaxNumCoreSlides &&
 		CurCoreSegOfs <= (ProbeLen - CoreLen) &&
 		CurCoreDelta > CoreLen/3 &&
 		CurNumIdentNodes < NumAllocdIdentNodes;	// can only allow upto cMaxNumIdentNodes to be saved
-	    CurNumCoreSlides += 1,
-	    CurCoreSegOfs += CurCoreDelta)
+	    CoreSamplePhase = (CoreSamplePhase + 1) % m_SfxSampleRate,
+	    CurNumCoreSlides += CoreSamplePhase ? 0 : 1,
+	    CurCoreBaseOfs += CoreSamplePhase ? 0 : CurCoreDelta,
+	    CurCoreSegOfs = CurCoreBaseOfs + CoreSamplePhase)
 		{
 		if(CurNumCoreSlides >= MaxNumCoreSlides)
 			break;
-		if((CurCoreSegOfs + CoreLen + CurCoreDelta) > ProbeLen)
-			CurCoreDelta = ProbeLen - (CurCoreSegOfs + CoreLen);
+		if((CurCoreBaseOfs + CoreLen + CurCoreDelta) > ProbeLen)
+			CurCoreDelta = ProbeLen - (CurCoreBaseOfs + CoreLen);
 
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
@@ -5862,7 +7332,7 @@ do
 			if(!bFirstIter) {
 
 				// ensure not about to iterate past end of suffix array!
-				if((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
+				if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				if(IterCnt == 100 && !NumCopies)
@@ -5880,34 +7350,7 @@ do
 				if(m_bBisulfite)
 					Cmp = BSCmpProbeTarg(pProbeBase,pTargBase,CoreLen);
 				else
-					{
-					int Ofs;
-					UINT8 El1;
-					UINT8 El2;
-					etSeqBase *pEl1= pProbeBase;
-					etSeqBase *pEl2 = pTargBase;
-					Cmp = 0;
-					for(Ofs=0; Ofs < CoreLen; Ofs++)
-						{
-						El2 = *pEl2++ & 0x0f;
-						if(El2 == eBaseEOS)
-							{
-							Cmp = -1;
-							break;
-							}
-						El1 = *pEl1++ & 0x0f;
-						if(El1 > El2)
-							{
-							Cmp = 1;
-							break;
-							}
-						if(El1 < El2)
-							{
-							Cmp = -1;
-							break;
-							}
-						}
-					}
+					Cmp = CmpProbeTarg(pProbeBase,pTargBase,CoreLen);
 
 				if(Cmp != 0)				// will be non-zero if target no longer matches
 					break;					// try next core segment
@@ -6090,7 +7533,20 @@ do
 				if(m_bBisulfite)
 					BisBase = GetBisBase(TargMatchLen,pTargBase,pProbeBase);
 
-				for(PatIdx = 0; PatIdx < (UINT32)TargMatchLen; PatIdx++,pTargBase++,pProbeBase++)
+				// in basespace, if both probe and target window are packable then count mismatches a word at a time, else using the
+				// vectorised kernel; colorspace and bisulfite mismatches are counted base by base
+				PatIdx = 0;
+				CurMMCnt = 0;
+				if(!m_bColorspace && !m_bBisulfite)
+					{
+					if(!bPackedProbe || (CurMMCnt = PackedMismatches(TargSeqLeftIdx,TargMatchLen,ProbeWords,max(0,min(MaxTotMM,NxtLowMMCnt - 1)))) < 0)
+						CurMMCnt = gpProbeTargMMs(pProbeBase,pTargBase,TargMatchLen);	// -1 if target window contains eBaseEOS
+					if(CurMMCnt < 0 || (CurMMCnt > 0 && (CurMMCnt > MaxTotMM || CurMMCnt >= NxtLowMMCnt)))	// same acceptance as base by base which only tests limits on mismatches
+						continue;
+					PatIdx = TargMatchLen;
+					}
+
+				for(; PatIdx < (UINT32)TargMatchLen; PatIdx++,pTargBase++,pProbeBase++)
 					{
 					TargBase = *pTargBase & 0x0f;
 					ProbeBase = *pProbeBase & 0x0f;
@@ -6432,7 +7888,7 @@ if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 NumMatches = 0;
 
@@ -6477,7 +7933,7 @@ do
 			if(!bFirstIter) {
 
 				// ensure not about to iterate past end of suffix array!
-				if((TargIdx + 1) >= (UINT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
+				if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				// check that this new putative core is still matching
@@ -6702,6 +8158,8 @@ UINT8 TargBase;
 
 int Cmp;
 int CurNumCoreSlides;
+int CurCoreBaseOfs;				// core segment relative start before any offset for sampled suffix phase
+int CoreSamplePhase;				// when suffix array is sampled then cores are located at each offset from CurCoreBaseOfs up to the sample rate
 int CurCoreDelta;
 tsHitLoci *pCurHit;
 
@@ -6719,7 +8177,7 @@ if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 
 LowHitInstances = 0;
@@ -6748,18 +8206,20 @@ do
 	CurNumCoreSlides = 0;
 	memset(pHashArray,0,sizeof(pHashArray));
 	CurNumIdentNodes = 0;
-	for(CurCoreSegOfs = 0;
+	for(CurCoreSegOfs = 0, CurCoreBaseOfs = 0, CoreSamplePhase = 0;
 		CurNumCoreSlides < MaxNumCoreSlides &&
 		CurCoreSegOfs <= (ProbeLen - CoreLen) &&
 		CurCoreDelta > CoreLen/3 &&
 		CurNumIdentNodes < NumAllocdIdentNodes;	// can only allow upto cMaxNumIdentNodes to be saved
-	    CurNumCoreSlides += 1,
-	    CurCoreSegOfs += CurCoreDelta)
+	    CoreSamplePhase = (CoreSamplePhase + 1) % m_SfxSampleRate,
+	    CurNumCoreSlides += CoreSamplePhase ? 0 : 1,
+	    CurCoreBaseOfs += CoreSamplePhase ? 0 : CurCoreDelta,
+	    CurCoreSegOfs = CurCoreBaseOfs + CoreSamplePhase)
 		{
 		if(CurNumCoreSlides >= MaxNumCoreSlides)
 			break;
-		if((CurCoreSegOfs + CoreLen + CurCoreDelta) > ProbeLen)
-			CurCoreDelta = ProbeLen - (CurCoreSegOfs + CoreLen);
+		if((CurCoreBaseOfs + CoreLen + CurCoreDelta) > ProbeLen)
+			CurCoreDelta = ProbeLen - (CurCoreBaseOfs + CoreLen);
 
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
@@ -6777,7 +8237,7 @@ do
 			if(!bFirstIter) {
 
 				// ensure not about to iterate past end of suffix array!
-				if((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
+				if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				if(IterCnt == 100 && !NumCopies)
@@ -7081,7 +8541,7 @@ if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 if(MaxTotMM > cMaxJunctAlignMM)		// silently clamp
 	MaxTotMM = cMaxJunctAlignMM;
@@ -7131,7 +8591,7 @@ do
 			if(!bFirstIter) {
 
 				// ensure not about to iterate past end of suffix array!
-				if((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + (Phase == 0 ? ProbeLen : CoreLen)) >=  (INT64)m_pSfxBlock->ConcatSeqLen)
+				if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + (Phase == 0 ? ProbeLen : CoreLen)) >=  (INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				if(IterCnt == 100 && !NumCopies)
@@ -7403,7 +8863,7 @@ if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
 
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 
 
 pCurHit = NULL;
@@ -7451,7 +8911,7 @@ do
 			if(!bFirstIter) {
 
 				// ensure not about to iterate past end of suffix array!
-				if((TargIdx + 1) >= (INT64)m_pSfxBlock->ConcatSeqLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
+				if((TargIdx + 1) >= SfxLen || (SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,TargIdx+1) + CoreLen) >  (INT64)m_pSfxBlock->ConcatSeqLen)
 					break;
 
 				if(IterCnt == 100 && !NumCopies)
@@ -7761,6 +9221,57 @@ return(0);
 
 
 
+// KMerIdxRange
+// If a k-mer prefix index is loaded and the probe is prefixed by a canonical k-mer then narrows the suffix array range to that of the k-mer bucket
+// Narrowed range is the intersection with the callers range, if no suffixes could match then *pSfxHi is returned as less than *pSfxLo
+bool											// true if k-mer prefix index was used to narrow the search range
+CSfxArrayV3::KMerIdxRange(etSeqBase *pProbe,	// probe sequence
+				  int ProbeLen,					// probe length to exactly match over
+				  etSeqBase *pTarg,				// target sequence
+				  INT64 TargStart,				// position in pTarg (0..n) corresponding to start of suffix array
+				  INT64 *pSfxLo,				// low index in suffix array, narrowed on return
+				  INT64 *pSfxHi)				// high index in suffix array, narrowed on return, if no suffixes can match then returned as less than *pSfxLo
+{
+INT64 KMer;
+INT64 BucketLo;
+INT64 BucketHi;
+int SfxElSize;
+
+if(m_pKMerIdx == NULL || m_pSfxBlock == NULL || pTarg != m_pSfxBlock->SeqSuffix || TargStart != 0)
+	return(false);
+#ifdef _DEBUG			// lookup counts are shared by all threads so are only maintained in debug builds
+#ifdef _WIN32
+InterlockedIncrement64((volatile LONGLONG *)&m_KMerIdxLookups);
+#else
+__sync_fetch_and_add(&m_KMerIdxLookups,1);
+#endif
+#endif
+if(ProbeLen < m_KMerIdxLen || (KMer = KMerPrefix(m_KMerIdxLen,pProbe)) < 0)
+	return(false);
+#ifdef _DEBUG
+#ifdef _WIN32
+InterlockedIncrement64((volatile LONGLONG *)&m_KMerIdxHits);
+#else
+__sync_fetch_and_add(&m_KMerIdxHits,1);
+#endif
+#endif
+
+SfxElSize = m_pSfxBlock->SfxElSize;
+BucketLo = SfxOfsToLoci(SfxElSize,m_pKMerIdx,KMer * 2);
+if(BucketLo == 0)				// no suffixes with this k-mer prefix
+	{
+	*pSfxHi = *pSfxLo - 1;
+	return(true);
+	}
+BucketHi = SfxOfsToLoci(SfxElSize,m_pKMerIdx,(KMer * 2) + 1) - 1;
+BucketLo -= 1;
+if(BucketLo > *pSfxLo)
+	*pSfxLo = BucketLo;
+if(BucketHi < *pSfxHi)
+	*pSfxHi = BucketHi;
+return(true);
+}
+
 INT64			// index+1 in pSfxArray of first exactly matching probe or 0 if no match
 CSfxArrayV3::LocateFirstExact(etSeqBase *pProbe,  // pts to probe sequence
 				  int ProbeLen,					// probe length to exactly match over
@@ -7780,6 +9291,11 @@ int CmpRslt;
 int Ofs;
 INT64 Mark;
 INT64 TargPsn;
+
+// if k-mer prefix indexed then the search can start from within the k-mer bucket
+if(KMerIdxRange(pProbe,ProbeLen,pTarg,TargStart,&SfxLo,&SfxHi) && SfxHi < SfxLo)
+	return(0);
+
 do {
 	pEl1 = pProbe;
 	TargPsn = ((INT64)SfxLo + SfxHi) / 2L;
@@ -7893,7 +9409,7 @@ INT64 LimitTargIdx;
 SfxElSize = m_pSfxBlock->SfxElSize;
 pTarg = (etSeqBase *)&m_pSfxBlock->SeqSuffix[0];
 pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
-SfxLen = m_pSfxBlock->ConcatSeqLen;
+SfxLen = GetNumSfxEls();
 FirstTargIdx = LocateFirstExact(pKMerSeq,KMerLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 if(FirstTargIdx < 1)		// not even one match?
 	return(0);
@@ -7929,8 +9445,12 @@ int CmpRslt;
 int Ofs;
 INT64 Mark;
 INT64 TargPsn;
-INT64 SfxHiMax = SfxHi;
-INT64 SfxLoMax = SfxLo;
+INT64 SfxHiMax;
+
+// if k-mer prefix indexed then the search can start from within the k-mer bucket
+if(KMerIdxRange(pProbe,ProbeLen,pTarg,TargStart,&SfxLo,&SfxHi) && SfxHi < SfxLo)
+	return(0);
+SfxHiMax = SfxHi;
 do {
 	pEl1 = pProbe;
 	TargPsn = ((INT64)SfxLo + SfxHi) / 2L;
@@ -9486,6 +11006,106 @@ switch(SfxElSize) {
 return(0);
 }
 
+// SAISSortSeq
+// Linear time suffix array construction using induced sorting (SA-IS)
+// Suffixes are ordered on the same low nibble symbols as compared by QSortSeqCmp32() and QSortSeqCmp40() but without any
+// limit on the number of bases compared, so the resulting ordering is a refinement of that generated by QSortSeq()
+// If the concatenated sequence length is within the 32bit signed range and 4 byte suffix elements are in use then
+// sorting is directly into pArray, otherwise a 64bit suffix array is generated and then packed into the 4 or 5 byte elements
+int
+CSfxArrayV3::SAISSortSeq(INT64 SeqLen,		// total concatenated sequence length
+						etSeqBase *pSeq,	// pts to start of concatenated sequences
+						int SfxElSize,		// suffix element size (will be either 4 or 5)
+						void *pArray)		// allocated to hold suffix elements
+{
+CSAIS SAIS;
+int Rslt;
+INT64 Idx;
+UINT8 *pSymbols;
+INT64 *pSA64;
+UINT8 *pEl;
+size_t AllocSymbols;
+size_t AllocSA64;
+
+if(SeqLen < 1 || pSeq == NULL || pArray == NULL || (SfxElSize != 4 && SfxElSize != 5))
+	return(-1);
+
+// SA-IS requires that the full symbol is used for comparisons so strip any flags in the hi nibble
+AllocSymbols = (size_t)SeqLen;
+#ifdef _WIN32
+pSymbols = (UINT8 *)malloc(AllocSymbols);
+if(pSymbols == NULL)
+#else
+pSymbols = (UINT8 *)mmap(NULL,AllocSymbols, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+if(pSymbols == MAP_FAILED)
+#endif
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"SAISSortSeq: unable to allocate %lld bytes for symbols, reverting to qsort",(INT64)AllocSymbols);
+	return(-1);
+	}
+for(Idx = 0; Idx < SeqLen; Idx++)
+	pSymbols[Idx] = pSeq[Idx] & 0x0f;
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"SAISSortSeq: induced sorting of %lld suffixes...",SeqLen);
+if(SfxElSize == 4 && SeqLen <= (INT64)INT_MAX)
+	{
+	pSA64 = NULL;
+	AllocSA64 = 0;
+	Rslt = SAIS.sais(pSymbols,(int *)pArray,(int)SeqLen);
+	}
+else
+	{
+	AllocSA64 = (size_t)SeqLen * sizeof(INT64);
+#ifdef _WIN32
+	pSA64 = (INT64 *)malloc(AllocSA64);
+	if(pSA64 == NULL)
+#else
+	pSA64 = (INT64 *)mmap(NULL,AllocSA64, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+	if(pSA64 == MAP_FAILED)
+#endif
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"SAISSortSeq: unable to allocate %lld bytes for 64bit suffix array, reverting to qsort",(INT64)AllocSA64);
+#ifdef _WIN32
+		free(pSymbols);
+#else
+		munmap(pSymbols,AllocSymbols);
+#endif
+		return(-1);
+		}
+	Rslt = SAIS.sais64(pSymbols,pSA64,SeqLen,16);
+	if(Rslt == 0)
+		{
+		pEl = (UINT8 *)pArray;
+		for(Idx = 0; Idx < SeqLen; Idx++)
+			{
+			*(UINT32 *)pEl = (UINT32)(pSA64[Idx] & 0x0ffffffff);
+			if(SfxElSize == 5)
+				pEl[4] = (UINT8)((pSA64[Idx] >> 32) & 0x00ff);
+			pEl += SfxElSize;
+			}
+		}
+#ifdef _WIN32
+	free(pSA64);
+#else
+	munmap(pSA64,AllocSA64);
+#endif
+	}
+
+#ifdef _WIN32
+free(pSymbols);
+#else
+munmap(pSymbols,AllocSymbols);
+#endif
+
+if(Rslt != 0)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"SAISSortSeq: induced sorting failed (%d), reverting to qsort",Rslt);
+	return(-1);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"SAISSortSeq: induced sorting completed");
+return(0);
+}
+
 // QSortSeqCmp32
 // qsorts suffix elements whereby each element occupies 32bits, 4 bytes, and is an offset into gpSeq[]
 static int QSortSeqCmp32(const void *p1,const void *p2)
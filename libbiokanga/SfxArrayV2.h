@@ -2,7 +2,7 @@
 #include "./commdefs.h"
 
 // new release
-const int cSFXVersion = 5;				// current file structure version
+const int cSFXVersion = 8;				// current file structure version, V6 adds optional k-mer prefix index, V7 adds optional 2bit packed sequence, V8 adds suffix sampling
 const int cSFXVersionBack = 3;			// can handle previous file structures back to this version
 
 const int cSigWaitSecs = 5;				// background readahead thread wakes every cSigWaitSecs sec just in case a signalling event missed
@@ -65,6 +65,17 @@ typedef enum etALStrand {
 	eALSnone							// align to neither strand
 } eALStrand;
 
+typedef enum TAG_eSfxSortMode {
+	eSfxSortQSort = 0,					// multithreaded qsort over suffixes, suffix comparisons limited to MaxBaseCmpLen bases
+	eSfxSortSAIS						// linear time induced sorting (SA-IS) over suffixes
+} etSfxSortMode;
+
+typedef enum TAG_eSfxLoadMode {
+	eSfxLoadCopy = 0,					// suffix block is read from file into private memory
+	eSfxLoadMmap,						// suffix block is memory mapped read only and shared with other processes through the page cache, pages loaded on demand
+	eSfxLoadMmapPopulate				// as eSfxLoadMmap but all pages are prefaulted when opened
+} etSfxLoadMode;
+
 typedef enum etHRslt {
 	eHRnone = 0,						// no change to that of previous search or no hits
 	eHRhits,							// hits, MMDelta criteria met and within the max allowed number of hits
@@ -168,6 +179,13 @@ const int cMinCultivarPreSufLen = 5;	// prefix or suffix length must be at least
 const int cMaxCultivarPreSufLen = 200;  // prefix or suffix length must be no longer than this many bases
 const int cTotCultivarKMerLen   = 300;	// prefix + suffix length combined no longer than this many bases
 
+const int cMinKMerIdxLen = 8;			// k-mer prefix index, if generated, must be over k-mers of at least this length
+const int cDfltKMerIdxLen = 12;			// default k-mer prefix index length
+const int cMaxKMerIdxLen = 14;			// k-mer prefix index can be over k-mers of at most this length
+const int cMaxSfxSampleRate = 8;		// suffix array, if sampled, retains suffixes starting at loci which are multiples of at most this rate
+
+const int cMaxPackedProbeLen = 2048;	// probes longer than this are not compared against any 2bit packed sequence
+
 #pragma pack(4)
 
 // fixed size V3 file header with cMaxDatasetSpeciesChrom increased to 81
@@ -184,8 +202,25 @@ typedef struct TAG_sSfxHeaderV3 {
 	UINT8 szDatasetName[cMaxDatasetSpeciesChrom]; // dataset name - usually the genome species name
 	UINT8 szDescription[cMBSFFileDescrLen];	// describes contents of file
 	UINT8 szTitle[cMBSFShortFileDescrLen];	// short title by which this file can be distingished from other files in dropdown lists etc
+	UINT32 KMerIdxLen;						// V6: k-mer prefix index is over k-mers of this length, 0 if no k-mer prefix index
+	UINT64 KMerIdxOfs;						// V6: file offset at which k-mer prefix index starts
+	UINT64 KMerIdxSize;						// V6: size of k-mer prefix index in file
+	UINT64 PackedSeqLen;					// V7: number of bases in 2bit packed concatenated sequence, 0 if no packed sequence
+	UINT64 PackedSeqOfs;					// V7: file offset at which 2bit packed concatenated sequence starts
+	UINT64 NRunsOfs;						// V7: file offset at which N-run table starts
+	UINT64 NumNRuns;						// V7: number of tsSfxSeqRun in N-run table
+	UINT64 MaskRunsOfs;						// V7: file offset at which repeat mask interval table starts
+	UINT64 NumMaskRuns;						// V7: number of tsSfxSeqRun in repeat mask interval table
+	UINT32 SfxSampleRate;					// V8: suffix array retains only suffixes starting at loci which are multiples of this rate, 0 or 1 if all suffixes retained
 } tsSfxHeaderV3;
 
+// runs of non-canonical bases (N-runs), or intervals of repeat masked canonical bases, which are not representable in the 2bit packed sequence
+typedef struct TAG_sSfxSeqRun {
+	UINT64 StartOfs;						// run starts at this offset in concatenated sequence
+	UINT32 RunLen;							// run is of this many bases
+	UINT32 Base;							// N-runs: all bases in run are this non-canonical base including any cRptMskFlg; mask intervals: unused, 0
+} tsSfxSeqRun;
+
 // original fixed size V3 file header with cMaxDatasetSpeciesChrom set to 36
 typedef struct TAG_sSfxHeaderVv {
 	unsigned char Magic[4];			 		// magic chars to identify this file as a SfxArrayV2 file
@@ -320,10 +355,37 @@ class CSfxArrayV3 : public CErrorCodes, protected CEndian
 	teBSFrsltCodes m_ReqBlockRslt;				// set by background processing thread with block loading result
 	bool m_bTermThread;							// set true if background processing threads are to terminate
 	bool m_bThreadActive;						// set true if any background processing threads have been started
+	bool m_bSfxBlockResident;					// set true if suffix block was loaded and background thread then terminated, block remains resident
 
 	int m_MaxQSortThreads;						// max number of threads to use when sorting
+	etSfxSortMode m_SfxSortMode;				// suffix array construction method
 	CMTqsort m_MTqsort;							// multithreaded qsort
 
+	int m_ReqKMerIdxLen;						// when finalising generate a k-mer prefix index over k-mers of this length, 0 if no index to be generated
+	int m_KMerIdxLen;							// loaded k-mer prefix index is over k-mers of this length, 0 if no k-mer prefix index loaded
+	UINT64 m_AllocKMerIdxMem;					// memory allocation size for m_pKMerIdx
+	UINT8 *m_pKMerIdx;							// k-mer prefix index, for each k-mer the (first index + 1) followed by (last index + 1) in suffix array, 0 if no suffixes with that k-mer prefix
+	volatile UINT64 m_KMerIdxLookups;			// number of exact match lookups which were candidates for narrowing through the k-mer prefix index (only counted in _DEBUG builds)
+	volatile UINT64 m_KMerIdxHits;				// number of exact match lookups which were narrowed through the k-mer prefix index (only counted in _DEBUG builds)
+
+	int m_ReqSfxSampleRate;						// when finalising retain only suffixes starting at loci which are multiples of this rate, 1 if all suffixes to be retained
+	int m_SfxSampleRate;						// loaded suffix array retains only suffixes starting at loci which are multiples of this rate, 1 if all suffixes retained
+
+	bool m_bReqPackedSeq;						// when finalising generate a 2bit packed copy of the concatenated sequence
+	UINT64 m_PackedSeqLen;						// loaded 2bit packed sequence contains this many bases, 0 if no packed sequence loaded
+	UINT64 m_AllocPackedSeqMem;					// memory allocation size for m_pPackedSeq
+	// NOTE: the 2bit packed sequence is only used as a mismatch scan accelerator, suffix comparisons and sequence retrievals all reference
+	// the byte per base concatenated sequence so it remains resident and index memory grows by ~N/4 bytes when the packed sequence is loaded;
+	// reducing index memory by serving these from the packed sequence and dropping the byte per base sequence is yet to be done
+	UINT64 *m_pPackedSeq;						// concatenated sequence packed 32 bases per word, base at offset N in bits ((N % 32) * 2) of word (N / 32), non-canonical bases packed as eBaseA
+	UINT64 m_AllocSeqRunsMem;					// memory allocation size for m_pNRuns and m_pMaskRuns
+	UINT64 m_NumNRuns;							// number of N-runs in m_pNRuns
+	tsSfxSeqRun *m_pNRuns;						// runs of non-canonical bases
+	UINT64 m_NumMaskRuns;						// number of repeat masked intervals in m_pMaskRuns
+	tsSfxSeqRun *m_pMaskRuns;					// intervals of repeat masked canonical bases
+	UINT64 m_AllocPackedExceptMem;				// memory allocation size for m_pPackedExcept
+	UINT64 *m_pPackedExcept;					// bitmap, bit set for each 32 base packed word containing any base in a N-run or mask interval
+
 	UINT32 m_MaxKMerOccs;						// if there are more than MaxKMerOccs instances of a Kmer then these will be classified as an over-occurance
 	size_t m_AllocOccKMerClasMem;				// allocation memory size for m_pOccKMerClas 
 	UINT8 *m_pOccKMerClas;						// to hold Kmer instance classifications packed 4 per byte
@@ -358,6 +420,8 @@ static	void *ThreadedPrereadBlocks(void * pThreadPars);
 	tsSfxHeaderV3 m_SfxHeader;					// loaded suffix file header
 	tsSfxEntriesBlock *m_pEntriesBlock;			// loaded entries block
 	tsSfxBlock *m_pSfxBlock;					// loaded suffix block
+	UINT8 *m_pMappedSfxFile;					// if not NULL then suffix file has been memory mapped read only and m_pSfxBlock points into this mapping
+	UINT64 m_MappedSfxFileLen;					// length of memory mapped suffix file
 	UINT64 m_AllocSfxBlockMem;					// memory allocation size for loaded suffix blocks
 	UINT64 m_AllocEntriesBlockMem;				// memory allocation size for loaded entry block
 	UINT64 m_AllocBisulfiteMem;					// memory allocation size for loaded bisulfite
@@ -373,6 +437,33 @@ static	void *ThreadedPrereadBlocks(void * pThreadPars);
 	teBSFrsltCodes Entries2Disk(void);			// writes entries to file
 	teBSFrsltCodes SfxBlock2Disk(void);			// writes sfx block to file
 	teBSFrsltCodes Disk2SfxBlock(int BlockID);	// loads specified sfx block from file
+	teBSFrsltCodes MapSfxFile(etSfxLoadMode LoadMode);	// memory maps suffix file read only, m_pSfxBlock will point into mapping
+	void UnmapSfxFile(void);					// unmaps any memory mapped suffix file
+	teBSFrsltCodes GenKMerIdx(void);			// generates k-mer prefix index from sorted suffix block
+	teBSFrsltCodes KMerIdx2Disk(void);			// writes k-mer prefix index to file
+	teBSFrsltCodes Disk2KMerIdx(void);			// loads k-mer prefix index from file
+	void DeleteKMerIdx(void);					// releases any k-mer prefix index memory
+	teBSFrsltCodes GenPackedSeq(void);			// generates 2bit packed sequence plus N-run and mask interval tables from suffix block sequence
+	teBSFrsltCodes GenPackedExcept(void);		// generates packed word exceptions bitmap from N-run and mask interval tables
+	teBSFrsltCodes PackedSeq2Disk(void);		// writes 2bit packed sequence plus N-run and mask interval tables to file
+	teBSFrsltCodes Disk2PackedSeq(void);		// loads 2bit packed sequence plus N-run and mask interval tables from file
+	void DeletePackedSeq(void);					// releases any 2bit packed sequence memory
+	INT64 GetNumSfxEls(void);					// returns number of elements in loaded suffix array, less than the concatenated sequence length if sampled
+	void SampleSfxArray(int SampleRate);		// compacts sorted suffix array retaining only suffixes starting at loci which are multiples of SampleRate
+
+	int												// number of mismatches (> MaxMM if early terminated), or -1 if target window contains bases not representable in the packed sequence
+		PackedMismatches(UINT64 TargOfs,		// target window starts at this offset in concatenated sequence
+				  int Len,						// window is this length
+				  UINT64 *pProbeWords,			// probe packed 2bit per base as returned by PackProbe()
+				  int MaxMM);					// can terminate early if more than this many mismatches
+
+	bool											// true if k-mer prefix index was used to narrow the search range
+		KMerIdxRange(etSeqBase *pProbe,			// probe sequence
+				  int ProbeLen,					// probe length to exactly match over
+				  etSeqBase *pTarg,				// target sequence
+				  INT64 TargStart,				// position in pTarg (0..n) corresponding to start of suffix array
+				  INT64 *pSfxLo,				// low index in suffix array, narrowed on return
+				  INT64 *pSfxHi);				// high index in suffix array, narrowed on return, if no suffixes can match then returned as less than *pSfxLo
 
 	teBSFrsltCodes Flush2Disk(void);			// flush and commit to disk
 
@@ -492,7 +583,8 @@ public:
 	int Open(char *pszSeqFile,				// specifies file to open or create
 			   bool bCreate = false,		// create file if it doesn't already exist, truncate if it does
 			   bool bBisulfite = false,		// if true then bisulfite processing
-               bool bColorspace = false);	// if true then colorspace (SOLiD) processing
+               bool bColorspace = false,	// if true then colorspace (SOLiD) processing
+			   etSfxLoadMode LoadMode = eSfxLoadCopy);	// if opening existing file then how the suffix block is to be loaded
 
 	// Memory resident suffix array
 	// User creates the suffix array in memory and can immediately access for alignments etc without needing to write to file
@@ -527,6 +619,18 @@ public:
 
 	void SetInitalSfxAllocEls(INT64 NumEls);	// estimated number of elements to allocate when creating suffix array - hint only!
 
+	int SetKMerIdxLen(int KMerIdxLen);		// when finalising generate a k-mer prefix index over k-mers of this length (0 to disable, else cMinKMerIdxLen..cMaxKMerIdxLen)
+	int GetKMerIdxLen(void);				// returns length of k-mers in loaded k-mer prefix index, 0 if no k-mer prefix index
+	bool SetMMScanAccel(bool bMMScanAccel);	// when finalising generate the mismatch scan accelerator, an additional 2bit packed copy of the concatenated sequence
+	bool IsMMScanAccel(void);				// returns true if mismatch scan accelerator (2bit packed sequence) loaded
+	int SetSfxSampleRate(int SampleRate);	// when finalising retain only suffixes starting at loci which are multiples of SampleRate (1 retains all suffixes, max cMaxSfxSampleRate)
+	int GetSfxSampleRate(void);				// returns suffix sampling rate of loaded suffix array, 1 if all suffixes retained
+	static const char *GetCmpKernelName(void);	// returns name of the probe vs target compare kernels (AVX2, SSE2 or scalar) selected for this CPU
+	static int BenchCmpKernels(int Seed = 1);	// microbenchmark of the probe vs target compare kernels over simulated 100..300bp reads, eBSFerrInternal if any kernel disagrees with the scalar kernels
+	int										// returns length of k-mers in loaded k-mer prefix index, 0 if no k-mer prefix index
+		GetKMerIdxStats(UINT64 *pLookups,	// returned number of exact match lookups which were candidates for the k-mer prefix index
+						UINT64 *pHits);		// returned number of these lookups narrowed through the k-mer prefix index
+
 	bool IsSOLiD(void);						// returns true if index created in colorspace (SOLiD)
 	teBSFrsltCodes SetDatasetName(char *pszDataset);	// sets file dataset name
 	char *GetDatasetName(void);						// returns file dataset name
@@ -926,6 +1030,7 @@ public:
 
 	int Next(int PrevBlockID = 0);						// iterates over block identifiers 
 	int SetTargBlock(int BlockID);						// specifies which block is to be loaded for subsequent sequence matches
+	int HoldSfxBlockResident(void);						// loads suffix block then terminates background readahead thread so instance can be inherited by forked processes
 	int GetNumEntries(void);							// returns number of entries
 
 	void InitAllIdentFlags(UINT16 Flags = 0);			// initialise all entries to have Flags value
@@ -973,7 +1078,12 @@ public:
 						etSeqBase *pSeq,	// pts to start of concatenated sequences
 						int SfxElSize,		// suffix element size (will be either 4 or 8)
 						void *pArray);		// allocated to hold suffix elements
+	int	SAISSortSeq(INT64 SeqLen,		// total concatenated sequence length
+							etSeqBase *pSeq,	// pts to start of concatenated sequences
+							int SfxElSize,		// suffix element size (will be either 4 or 5)
+							void *pArray);		// allocated to hold suffix elements
 	void SetMaxQSortThreads(int MaxThreads);			// sets maximum number of threads to use in multithreaded qsorts
+	void SetSfxSortMode(etSfxSortMode SortMode);		// sets method used to construct suffix array when finalising
 
 	int						// returns the previously utilised MaxBaseCmpLen
 		SetMaxBaseCmpLen(int MaxBaseCmpLen);		// sets maximum number of bases which need to be compared for equality in multithreaded qsorts, will be clamped to be in range 10..(5*cMaxReadLen)
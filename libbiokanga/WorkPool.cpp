@@ -0,0 +1,430 @@
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "../libbiokanga/commhdrs.h"
+#else
+#include <sys/mman.h>
+#include <pthread.h>
+#include "../libbiokanga/commhdrs.h"
+#endif
+
+// constructor
+CWorkPool::CWorkPool(void)
+{
+int WorkerIdx;
+m_MaxWorkers = cDfltWorkPoolWorkers;
+m_NumWorkers = 0;
+m_bTerm = false;
+m_JobGen = 0;
+m_NumActive = 0;
+m_pFunc = NULL;
+m_pCtx = NULL;
+m_Grain = 1;
+m_JobRslt = eBSFSuccess;
+memset(m_Workers,0,sizeof(m_Workers));
+for(WorkerIdx = 0; WorkerIdx < cMaxWorkPoolWorkers; WorkerIdx++)
+	{
+	m_Workers[WorkerIdx].pThis = this;
+	m_Workers[WorkerIdx].WorkerIdx = WorkerIdx;
+#ifdef _WIN32
+	InitializeCriticalSectionAndSpinCount(&m_Workers[WorkerIdx].hRangeLock,1000);
+#else
+	pthread_spin_init(&m_Workers[WorkerIdx].hRangeLock,PTHREAD_PROCESS_PRIVATE);
+#endif
+	}
+#ifdef _WIN32
+InitializeCriticalSection(&m_hMtx);
+InitializeConditionVariable(&m_hJobCond);
+InitializeConditionVariable(&m_hDoneCond);
+#else
+pthread_mutex_init(&m_hMtx,NULL);
+pthread_cond_init(&m_hJobCond,NULL);
+pthread_cond_init(&m_hDoneCond,NULL);
+#endif
+}
+
+// destructor
+CWorkPool::~CWorkPool(void)
+{
+int WorkerIdx;
+Stop();
+for(WorkerIdx = 0; WorkerIdx < cMaxWorkPoolWorkers; WorkerIdx++)
+	{
+#ifdef _WIN32
+	DeleteCriticalSection(&m_Workers[WorkerIdx].hRangeLock);
+#else
+	pthread_spin_destroy(&m_Workers[WorkerIdx].hRangeLock);
+#endif
+	}
+#ifdef _WIN32
+DeleteCriticalSection(&m_hMtx);
+#else
+pthread_cond_destroy(&m_hDoneCond);
+pthread_cond_destroy(&m_hJobCond);
+pthread_mutex_destroy(&m_hMtx);
+#endif
+}
+
+// SetMaxWorkers
+// Sets number of worker threads to use, if 0 then resets to cDfltWorkPoolWorkers
+// If workers have already been started then the new number of workers is only used after Stop()
+void
+CWorkPool::SetMaxWorkers(int MaxWorkers)
+{
+if(MaxWorkers <= 0)
+	MaxWorkers = cDfltWorkPoolWorkers;
+if(MaxWorkers > cMaxWorkPoolWorkers)
+	MaxWorkers = cMaxWorkPoolWorkers;
+m_MaxWorkers = MaxWorkers;
+}
+
+int
+CWorkPool::GetNumWorkers(void)
+{
+return(m_NumWorkers > 0 ? m_NumWorkers : m_MaxWorkers);
+}
+
+#ifdef _WIN32
+unsigned int __stdcall CWorkPool::_worker_start(void *args)
+{
+#else
+void * CWorkPool::_worker_start(void *args)
+{
+#endif
+tsWorkPoolWorker *pWorker = (tsWorkPoolWorker *)args;
+pWorker->pThis->WorkerLoop(pWorker);
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
+#else
+return(NULL);
+#endif
+}
+
+// Start
+// Start worker threads, these will wait on m_hJobCond for jobs to process
+int
+CWorkPool::Start(void)
+{
+int WorkerIdx;
+tsWorkPoolWorker *pWorker;
+if(m_NumWorkers > 0)
+	return(eBSFSuccess);
+m_bTerm = false;
+pWorker = m_Workers;
+for(WorkerIdx = 0; WorkerIdx < m_MaxWorkers; WorkerIdx++,pWorker++)
+	{
+	pWorker->JobGen = m_JobGen;
+	pWorker->NxtItem = 0;
+	pWorker->EndItem = 0;
+#ifdef _WIN32
+	pWorker->threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,_worker_start,pWorker,0,&pWorker->threadID);
+	if(pWorker->threadHandle == 0)
+		break;
+#else
+	pWorker->threadRslt = pthread_create(&pWorker->threadID,NULL,_worker_start,pWorker);
+	if(pWorker->threadRslt != 0)
+		break;
+#endif
+	m_NumWorkers += 1;
+	}
+if(m_NumWorkers == 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"CWorkPool: unable to start any worker threads");
+	return(eBSFerrInternal);
+	}
+return(eBSFSuccess);
+}
+
+// Stop
+// Request all workers to terminate and wait for them to do so
+void
+CWorkPool::Stop(void)
+{
+int WorkerIdx;
+if(m_NumWorkers == 0)
+	return;
+#ifdef _WIN32
+EnterCriticalSection(&m_hMtx);
+m_bTerm = true;
+WakeAllConditionVariable(&m_hJobCond);
+LeaveCriticalSection(&m_hMtx);
+#else
+pthread_mutex_lock(&m_hMtx);
+m_bTerm = true;
+pthread_cond_broadcast(&m_hJobCond);
+pthread_mutex_unlock(&m_hMtx);
+#endif
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	{
+#ifdef _WIN32
+	WaitForSingleObject(m_Workers[WorkerIdx].threadHandle,INFINITE);
+	CloseHandle(m_Workers[WorkerIdx].threadHandle);
+	m_Workers[WorkerIdx].threadHandle = 0;
+#else
+	pthread_join(m_Workers[WorkerIdx].threadID,NULL);
+#endif
+	}
+m_NumWorkers = 0;
+m_bTerm = false;
+}
+
+void
+CWorkPool::WorkerLoop(tsWorkPoolWorker *pWorker)
+{
+int Rslt;
+INT64 From;
+INT64 Until;
+
+while(1)
+	{
+	// wait for a new job
+#ifdef _WIN32
+	EnterCriticalSection(&m_hMtx);
+	while(!m_bTerm && pWorker->JobGen == m_JobGen)
+		SleepConditionVariableCS(&m_hJobCond,&m_hMtx,INFINITE);
+#else
+	pthread_mutex_lock(&m_hMtx);
+	while(!m_bTerm && pWorker->JobGen == m_JobGen)
+		pthread_cond_wait(&m_hJobCond,&m_hMtx);
+#endif
+	if(m_bTerm)
+		{
+#ifdef _WIN32
+		LeaveCriticalSection(&m_hMtx);
+#else
+		pthread_mutex_unlock(&m_hMtx);
+#endif
+		return;
+		}
+	pWorker->JobGen = m_JobGen;
+#ifdef _WIN32
+	LeaveCriticalSection(&m_hMtx);
+#else
+	pthread_mutex_unlock(&m_hMtx);
+#endif
+
+	while(m_JobRslt >= eBSFSuccess && TakeItems(pWorker,&From,&Until))
+		{
+		if((Rslt = (*m_pFunc)(m_pCtx,pWorker->WorkerIdx,From,Until)) < eBSFSuccess)
+			{
+#ifdef _WIN32
+			EnterCriticalSection(&m_hMtx);
+#else
+			pthread_mutex_lock(&m_hMtx);
+#endif
+			if(m_JobRslt >= eBSFSuccess)
+				m_JobRslt = Rslt;
+#ifdef _WIN32
+			LeaveCriticalSection(&m_hMtx);
+#else
+			pthread_mutex_unlock(&m_hMtx);
+#endif
+			}
+		pWorker->NumItemsDone += Until - From;
+		}
+
+	// job completed by this worker, last worker to complete signals the waiting Run()
+#ifdef _WIN32
+	EnterCriticalSection(&m_hMtx);
+	if(--m_NumActive == 0)
+		WakeAllConditionVariable(&m_hDoneCond);
+	LeaveCriticalSection(&m_hMtx);
+#else
+	pthread_mutex_lock(&m_hMtx);
+	if(--m_NumActive == 0)
+		pthread_cond_broadcast(&m_hDoneCond);
+	pthread_mutex_unlock(&m_hMtx);
+#endif
+	}
+}
+
+// TakeItems
+// Take up to m_Grain items from the front of this worker's range, if range exhausted then steal the back half of the
+// largest range remaining to any other worker
+bool
+CWorkPool::TakeItems(tsWorkPoolWorker *pWorker,	// take next items to process for this worker
+					INT64 *pFrom,				// returned items from inclusive
+					INT64 *pUntil)				// until exclusive
+{
+int WorkerIdx;
+INT64 Remaining;
+INT64 MaxRemaining;
+INT64 StealFrom;
+INT64 StealUntil;
+tsWorkPoolWorker *pVictim;
+tsWorkPoolWorker *pMaxVictim;
+
+while(1)
+	{
+#ifdef _WIN32
+	EnterCriticalSection(&pWorker->hRangeLock);
+#else
+	pthread_spin_lock(&pWorker->hRangeLock);
+#endif
+	if(pWorker->NxtItem < pWorker->EndItem)
+		{
+		*pFrom = pWorker->NxtItem;
+		*pUntil = min(pWorker->EndItem,pWorker->NxtItem + m_Grain);
+		pWorker->NxtItem = *pUntil;
+#ifdef _WIN32
+		LeaveCriticalSection(&pWorker->hRangeLock);
+#else
+		pthread_spin_unlock(&pWorker->hRangeLock);
+#endif
+		return(true);
+		}
+#ifdef _WIN32
+	LeaveCriticalSection(&pWorker->hRangeLock);
+#else
+	pthread_spin_unlock(&pWorker->hRangeLock);
+#endif
+
+	// own range exhausted, locate the worker with the most items remaining; no locking as only a hint
+	pMaxVictim = NULL;
+	MaxRemaining = 0;
+	pVictim = m_Workers;
+	for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++,pVictim++)
+		{
+		if(pVictim == pWorker)
+			continue;
+		Remaining = pVictim->EndItem - pVictim->NxtItem;
+		if(Remaining > MaxRemaining)
+			{
+			MaxRemaining = Remaining;
+			pMaxVictim = pVictim;
+			}
+		}
+	if(pMaxVictim == NULL)
+		return(false);						// nothing left to steal, all items have been taken
+
+#ifdef _WIN32
+	EnterCriticalSection(&pMaxVictim->hRangeLock);
+#else
+	pthread_spin_lock(&pMaxVictim->hRangeLock);
+#endif
+	Remaining = pMaxVictim->EndItem - pMaxVictim->NxtItem;
+	if(Remaining <= 0)						// victim took its remaining items since the hint, try again
+		{
+#ifdef _WIN32
+		LeaveCriticalSection(&pMaxVictim->hRangeLock);
+#else
+		pthread_spin_unlock(&pMaxVictim->hRangeLock);
+#endif
+		continue;
+		}
+	StealUntil = pMaxVictim->EndItem;
+	StealFrom = pMaxVictim->NxtItem + (Remaining / 2);
+	pMaxVictim->EndItem = StealFrom;
+#ifdef _WIN32
+	LeaveCriticalSection(&pMaxVictim->hRangeLock);
+	EnterCriticalSection(&pWorker->hRangeLock);
+#else
+	pthread_spin_unlock(&pMaxVictim->hRangeLock);
+	pthread_spin_lock(&pWorker->hRangeLock);
+#endif
+	pWorker->NxtItem = StealFrom;
+	pWorker->EndItem = StealUntil;
+#ifdef _WIN32
+	LeaveCriticalSection(&pWorker->hRangeLock);
+#else
+	pthread_spin_unlock(&pWorker->hRangeLock);
+#endif
+	}
+}
+
+int										// returns eBSFSuccess or the first < 0 result returned by the work function
+CWorkPool::Run(tpWorkPoolFunc pFunc,	// work function
+			void *pCtx,					// job context passed into work and progress functions
+			INT64 NumItems,				// number of items [0,NumItems) to be processed
+			INT64 Grain,				// workers take at most this many items at a time
+			int ProgressSecs,			// if > 0 then call pProgress at this interval in seconds until job completed
+			tpWorkPoolProgress pProgress)	// progress function
+{
+int Rslt;
+int WorkerIdx;
+INT64 ItemsPerWorker;
+INT64 NumItemsDone;
+tsWorkPoolWorker *pWorker;
+
+if(pFunc == NULL || NumItems < 0)
+	return(eBSFerrParams);
+if(NumItems == 0)
+	return(eBSFSuccess);
+if((Rslt = Start()) < eBSFSuccess)
+	return(Rslt);
+
+m_pFunc = pFunc;
+m_pCtx = pCtx;
+m_Grain = Grain < 1 ? 1 : Grain;
+m_JobRslt = eBSFSuccess;
+
+// initially partition items evenly over the workers
+ItemsPerWorker = NumItems / m_NumWorkers;
+pWorker = m_Workers;
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++,pWorker++)
+	{
+	pWorker->NumItemsDone = 0;
+	pWorker->NxtItem = WorkerIdx * ItemsPerWorker;
+	pWorker->EndItem = WorkerIdx == m_NumWorkers - 1 ? NumItems : pWorker->NxtItem + ItemsPerWorker;
+	}
+
+#ifdef _WIN32
+EnterCriticalSection(&m_hMtx);
+m_NumActive = m_NumWorkers;
+m_JobGen += 1;
+WakeAllConditionVariable(&m_hJobCond);
+while(m_NumActive > 0)
+	{
+	if(!SleepConditionVariableCS(&m_hDoneCond,&m_hMtx,ProgressSecs > 0 ? (DWORD)ProgressSecs * 1000 : INFINITE) && m_NumActive > 0 && pProgress != NULL)
+		{
+		LeaveCriticalSection(&m_hMtx);
+		NumItemsDone = 0;
+		for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+			NumItemsDone += m_Workers[WorkerIdx].NumItemsDone;
+		(*pProgress)(pCtx,NumItemsDone,NumItems);
+		EnterCriticalSection(&m_hMtx);
+		}
+	}
+Rslt = m_JobRslt;
+LeaveCriticalSection(&m_hMtx);
+#else
+struct timespec ts;
+pthread_mutex_lock(&m_hMtx);
+m_NumActive = m_NumWorkers;
+m_JobGen += 1;
+pthread_cond_broadcast(&m_hJobCond);
+clock_gettime(CLOCK_REALTIME,&ts);
+ts.tv_sec += ProgressSecs;
+while(m_NumActive > 0)
+	{
+	if(ProgressSecs <= 0 || pProgress == NULL)
+		pthread_cond_wait(&m_hDoneCond,&m_hMtx);
+	else
+		if(pthread_cond_timedwait(&m_hDoneCond,&m_hMtx,&ts) == ETIMEDOUT && m_NumActive > 0)
+			{
+			pthread_mutex_unlock(&m_hMtx);
+			NumItemsDone = 0;
+			for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+				NumItemsDone += m_Workers[WorkerIdx].NumItemsDone;
+			(*pProgress)(pCtx,NumItemsDone,NumItems);
+			ts.tv_sec += ProgressSecs;
+			pthread_mutex_lock(&m_hMtx);
+			}
+	}
+Rslt = m_JobRslt;
+pthread_mutex_unlock(&m_hMtx);
+#endif
+return(Rslt);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+const int cMaxWorkPoolWorkers = 128;	// allow for a max of this many worker threads in any work pool
+const int cDfltWorkPoolWorkers = 8;		// default is for this many worker threads
+
+// work function called by worker threads to process items [From,Until) of the current job
+// returns < 0 if errors, in which case no further items will be handed out for processing for the current job
+typedef int (*tpWorkPoolFunc)(void *pCtx,		// job context as passed into Run()
+							int WorkerIdx,		// worker (0..NumWorkers-1) processing these items, can be used to index per worker resources
+							INT64 From,			// process items starting from this item inclusive
+							INT64 Until);		// until this item exclusive
+
+// progress function called by the thread which called Run() at requested intervals while the job is still being processed
+typedef void (*tpWorkPoolProgress)(void *pCtx,	// job context as passed into Run()
+							INT64 NumItemsDone,	// number of items thus far processed
+							INT64 NumItems);	// total number of items in job
+
+#pragma pack(8)
+typedef struct TAG_sWorkPoolWorker {
+	class CWorkPool *pThis;
+	int WorkerIdx;					// index of this worker (0..m_NumWorkers-1)
+#ifdef _WIN32
+	HANDLE threadHandle;			// handle as returned by _beginthreadex()
+	unsigned int threadID;			// identifier as set by _beginthreadex()
+	CRITICAL_SECTION hRangeLock;	// serialises access to this worker's item range
+#else
+	int threadRslt;					// result as returned by pthread_create ()
+	pthread_t threadID;				// identifier as set by pthread_create ()
+	pthread_spinlock_t hRangeLock;	// serialises access to this worker's item range
+#endif
+	volatile INT64 NxtItem;			// next item in this worker's range to be processed
+	volatile INT64 EndItem;			// range ends at this item exclusive, other workers steal by reducing EndItem
+	volatile INT64 NumItemsDone;	// number of items processed by this worker in the current job
+	UINT32 JobGen;					// generation of last job processed by this worker
+} tsWorkPoolWorker;
+#pragma pack()
+
+// Work stealing pool of persistent worker threads
+// Worker threads are started on first use and then reused for all subsequent jobs until Stop() so there is no thread startup/teardown
+// churn between processing phases. Each job is a range of items which is initially evenly partitioned over the workers, workers
+// take items in chunks of at most Grain items from the front of their own range, and once their own range is exhausted steal
+// the back half of the largest range remaining to any other worker, so skewed item processing costs are balanced over all workers.
+class CWorkPool
+{
+	int m_MaxWorkers;						// number of workers to start
+	int m_NumWorkers;						// number of workers currently started
+	bool m_bTerm;							// set true to request workers to terminate
+	UINT32 m_JobGen;						// incremented for each job
+	int m_NumActive;						// number of workers still processing current job
+	tpWorkPoolFunc m_pFunc;					// current job work function
+	void *m_pCtx;							// current job context
+	INT64 m_Grain;							// current job, workers take at most this many items at a time
+	volatile int m_JobRslt;					// current job result, set < 0 if any work function returned errors
+
+	tsWorkPoolWorker m_Workers[cMaxWorkPoolWorkers];
+
+#ifdef _WIN32
+	CRITICAL_SECTION m_hMtx;				// serialises job state
+	CONDITION_VARIABLE m_hJobCond;			// signalled when new job available or workers are to terminate
+	CONDITION_VARIABLE m_hDoneCond;			// signalled when last worker completes current job
+	static unsigned int __stdcall _worker_start(void *args);
+#else
+	pthread_mutex_t m_hMtx;					// serialises job state
+	pthread_cond_t m_hJobCond;				// signalled when new job available or workers are to terminate
+	pthread_cond_t m_hDoneCond;				// signalled when last worker completes current job
+	static void * _worker_start(void *args);
+#endif
+
+	void WorkerLoop(tsWorkPoolWorker *pWorker);	// workers wait for jobs and process these until m_bTerm
+	bool TakeItems(tsWorkPoolWorker *pWorker,	// take next items to process for this worker, stealing from other workers if own range exhausted
+					INT64 *pFrom,				// returned items from inclusive
+					INT64 *pUntil);				// until exclusive
+	int Start(void);						// start worker threads
+
+public:
+	CWorkPool(void);
+	~CWorkPool(void);
+
+	void SetMaxWorkers(int MaxWorkers);		// sets number of worker threads, if 0 then resets to cDfltWorkPoolWorkers; takes effect after Stop()
+	int GetNumWorkers(void);				// returns number of worker threads which will process jobs
+
+	int										// returns eBSFSuccess or the first < 0 result returned by the work function
+		Run(tpWorkPoolFunc pFunc,			// work function
+			void *pCtx,						// job context passed into work and progress functions
+			INT64 NumItems,					// number of items [0,NumItems) to be processed
+			INT64 Grain,					// workers take at most this many items at a time
+			int ProgressSecs = 0,			// if > 0 then call pProgress at this interval in seconds until job completed
+			tpWorkPoolProgress pProgress = NULL);	// progress function
+
+	void Stop(void);						// terminate and join all worker threads
+};
+
@@ -93,6 +93,33 @@ typedef struct {
 KHASH_MAP_INIT_INT64(cache, cache_t)
 #endif
 
+// multithreaded writer state, only allocated on writing after bgzf_mt() has been called
+// Full blocks are queued (by sequence number) into a batch of n_blks slots; when the batch is full the slots are
+// compressed in parallel by n_threads and then written to file in block sequence order, so the compressed output is
+// byte identical to that from a single threaded writer
+typedef struct {
+	int n_threads;		// number of threads (including the calling thread) compressing each batch
+	int n_blks;			// number of block slots in each batch
+	int curr;			// number of blocks currently queued in this batch
+	int level;			// compression level
+	int *len;			// per slot, uncompressed length on queuing, then compressed length after compression
+	void **blk;			// per slot, uncompressed block
+	void **cblk;		// per slot, compressed block
+	INT64 n_queued;		// number of blocks queued since multithreading was enabled, also the sequence number of the next block to be queued
+	INT64 n_written;	// number of blocks which have been written to file
+	INT64 file_addr;	// file offset at which the next block will be written
+	INT64 n_alloc_addrs; // number of block addresses allocated in blk_addrs
+	INT64 *blk_addrs;	// file offset at which each written block, indexed by block sequence number, was written
+} bgzf_mtaux_t;
+
+typedef struct {
+	bgzf_mtaux_t *mt;	// writer state
+	int tid;			// compresses slots tid, tid + n_threads, tid + 2 * n_threads, ...
+	int errcode;		// set non-zero if any slot could not be compressed
+} bgzf_mtworker_t;
+
+static int bgzf_compress(void *_dst, int *dlen, void *src, int slen, int level);
+
 static inline void packInt16(UINT8 *buffer, UINT16 value)
 {
 buffer[0] = (UINT8)(value & 0x0ff);
@@ -221,6 +248,189 @@ packInt32((UINT8*)&dst[*dlen - 4], slen);
 return 0;
 }
 
+#ifdef _WIN32
+static unsigned __stdcall mt_worker(void *data)
+#else
+static void *mt_worker(void *data)
+#endif
+{
+int i;
+bgzf_mtworker_t *w = (bgzf_mtworker_t *)data;
+bgzf_mtaux_t *mt = w->mt;
+for (i = w->tid; i < mt->curr; i += mt->n_threads)
+	{
+	int clen = BGZF_MAX_BLOCK_SIZE;
+	if (bgzf_compress(mt->cblk[i], &clen, mt->blk[i], mt->len[i], mt->level) != 0)
+		w->errcode = BGZF_ERR_ZLIB;
+	mt->len[i] = clen;
+	}
+#ifdef _WIN32
+return 0;
+#else
+return NULL;
+#endif
+}
+
+// compress all queued blocks in parallel and then write them out in block sequence order
+static int mt_flush(BGZF *fp)
+{
+int i, n_workers, errcode = 0;
+bgzf_mtaux_t *mt = (bgzf_mtaux_t *)fp->mt;
+bgzf_mtworker_t w[256];
+#ifdef _WIN32
+HANDLE threads[256];
+#else
+pthread_t threads[256];
+#endif
+if (mt->curr == 0)
+	return 0;
+n_workers = mt->n_threads < mt->curr ? mt->n_threads : mt->curr;
+for (i = 0; i < n_workers; i++)
+	{
+	w[i].mt = mt;
+	w[i].tid = i;
+	w[i].errcode = 0;
+	}
+// calling thread compresses the slots for worker 0, if a thread can't be started then its slots are compressed by the calling thread
+for (i = 1; i < n_workers; i++)
+	{
+#ifdef _WIN32
+	threads[i] = (HANDLE)_beginthreadex(NULL, 0, mt_worker, &w[i], 0, NULL);
+	if (threads[i] == 0)
+		mt_worker(&w[i]);
+#else
+	if (pthread_create(&threads[i], NULL, mt_worker, &w[i]) != 0)
+		{
+		threads[i] = 0;
+		mt_worker(&w[i]);
+		}
+#endif
+	}
+mt_worker(&w[0]);
+for (i = 1; i < n_workers; i++)
+	{
+#ifdef _WIN32
+	if (threads[i] != 0)
+		{
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+		}
+#else
+	if (threads[i] != 0)
+		pthread_join(threads[i], NULL);
+#endif
+	}
+for (i = 0; i < n_workers; i++)
+	errcode |= w[i].errcode;
+if (errcode)
+	{
+	fp->errcode |= errcode;
+	return -1;
+	}
+
+if (mt->n_written + mt->curr > mt->n_alloc_addrs)
+	{
+	INT64 *pRealloc;
+	INT64 n_alloc = mt->n_alloc_addrs + mt->n_alloc_addrs / 2 + mt->n_blks;
+	if ((pRealloc = (INT64 *)realloc(mt->blk_addrs, (size_t)n_alloc * sizeof(INT64))) == NULL)
+		{
+		fp->errcode |= BGZF_ERR_MISUSE;
+		return -1;
+		}
+	mt->blk_addrs = pRealloc;
+	mt->n_alloc_addrs = n_alloc;
+	}
+for (i = 0; i < mt->curr; i++)
+	{
+	if (fwrite(mt->cblk[i], 1, mt->len[i], (FILE *)fp->fp) != (size_t)mt->len[i])
+		{
+		fp->errcode |= BGZF_ERR_IO; // possibly truncated file
+		return -1;
+		}
+	mt->blk_addrs[mt->n_written++] = mt->file_addr;
+	mt->file_addr += mt->len[i];
+	}
+mt->curr = 0;
+return 0;
+}
+
+static void mt_destroy(bgzf_mtaux_t *mt)
+{
+int i;
+if (mt == NULL)
+	return;
+for (i = 0; i < mt->n_blks; i++)
+	{
+	if (mt->blk != NULL && mt->blk[i] != NULL)
+		free(mt->blk[i]);
+	if (mt->cblk != NULL && mt->cblk[i] != NULL)
+		free(mt->cblk[i]);
+	}
+if (mt->blk != NULL)
+	free(mt->blk);
+if (mt->cblk != NULL)
+	free(mt->cblk);
+if (mt->len != NULL)
+	free(mt->len);
+if (mt->blk_addrs != NULL)
+	free(mt->blk_addrs);
+free(mt);
+}
+
+int bgzf_mt(BGZF *fp, int n_threads, int n_sub_blks)
+{
+int i;
+bgzf_mtaux_t *mt;
+if (!fp->is_write || fp->mt != NULL || fp->block_address != 0 || fp->block_offset != 0)
+	{
+	fp->errcode |= BGZF_ERR_MISUSE;	// must be enabled on a newly opened file for writing and only once
+	return -1;
+	}
+if (n_threads <= 1)
+	return 0;
+if (n_threads > 256)
+	n_threads = 256;
+if (n_sub_blks < 1)
+	n_sub_blks = 1;
+if ((mt = (bgzf_mtaux_t *)calloc(1, sizeof(bgzf_mtaux_t))) == NULL)
+	return -1;
+mt->n_threads = n_threads;
+mt->n_blks = n_threads * n_sub_blks;
+mt->level = fp->compress_level;
+mt->len = (int *)calloc(mt->n_blks, sizeof(int));
+mt->blk = (void **)calloc(mt->n_blks, sizeof(void *));
+mt->cblk = (void **)calloc(mt->n_blks, sizeof(void *));
+if (mt->len == NULL || mt->blk == NULL || mt->cblk == NULL)
+	{
+	mt_destroy(mt);
+	return -1;
+	}
+for (i = 0; i < mt->n_blks; i++)
+	{
+	if ((mt->blk[i] = malloc(BGZF_MAX_BLOCK_SIZE)) == NULL || (mt->cblk[i] = malloc(BGZF_MAX_BLOCK_SIZE)) == NULL)
+		{
+		mt_destroy(mt);
+		return -1;
+		}
+	}
+fp->mt = mt;
+return 0;
+}
+
+INT64 bgzf_mt_voffset(BGZF *fp, INT64 voffset)
+{
+INT64 seq;
+bgzf_mtaux_t *mt = (bgzf_mtaux_t *)fp->mt;
+if (mt == NULL)
+	return voffset;
+seq = voffset >> 16;
+if (seq >= mt->n_written && mt_flush(fp) != 0)
+	return -1;
+if (seq < mt->n_written)
+	return (mt->blk_addrs[seq] << 16) | (voffset & 0xFFFF);
+return (mt->file_addr << 16) | (voffset & 0xFFFF); // block currently being filled will be the next written
+}
+
 // Deflate the block in fp->uncompressed_block into fp->compressed_block. Also adds an extra field that stores the compressed block length.
 static int deflate_block(BGZF *fp, int block_length)
 {
@@ -417,6 +627,24 @@ int bgzf_flush(BGZF *fp)
 {
 if (!fp->is_write) 
 	return 0;
+if (fp->mt != NULL)
+	{
+	bgzf_mtaux_t *mt = (bgzf_mtaux_t *)fp->mt;
+	void *tmp;
+	if (fp->block_offset == 0)
+		return 0;
+	// queue the block by exchanging buffers with the next free slot, block address is now the block sequence number
+	tmp = mt->blk[mt->curr];
+	mt->blk[mt->curr] = fp->uncompressed_block;
+	fp->uncompressed_block = tmp;
+	mt->len[mt->curr++] = fp->block_offset;
+	mt->n_queued += 1;
+	fp->block_address = mt->n_queued;
+	fp->block_offset = 0;
+	if (mt->curr == mt->n_blks)
+		return mt_flush(fp);
+	return 0;
+	}
 while (fp->block_offset > 0) 
 	{
 	int block_length;
@@ -471,6 +699,13 @@ if (fp->is_write)
 	{
 	if (bgzf_flush(fp) != 0) 
 		return -1;
+	if (fp->mt != NULL)
+		{
+		if (mt_flush(fp) != 0)
+			return -1;
+		mt_destroy((bgzf_mtaux_t *)fp->mt);
+		fp->mt = NULL;
+		}
 	fp->compress_level = -1;
 	block_length = deflate_block(fp, 0); // write an empty block
 	count = fwrite(fp->compressed_block, 1, block_length, (FILE *)fp->fp);
@@ -133,6 +133,8 @@ extern "C" {
 	 * No interpetation of the value should be made, other than a subsequent
 	 * call to bgzf_seek can be used to position the file at the same point.
 	 * Return value is non-negative on success.
+	 * When writing with multi-threading enabled the returned value is relative
+	 * to the block sequence number and must be converted with bgzf_mt_voffset()
 	 */
 	#define bgzf_tell(fp) ((fp->block_address << 16) | (fp->block_offset & 0xFFFF))
 
@@ -210,6 +212,16 @@ extern "C" {
 	 */
 	int bgzf_mt(BGZF *fp, int n_threads, int n_sub_blks);
 
+	/**
+	 * Convert a virtual file offset returned by bgzf_tell() into the actual virtual file offset
+	 * Blocks still queued for compression are written to file if required to resolve the offset
+	 *
+	 * @param fp       BGZF file handler opened for writing
+	 * @param voffset  virtual file offset returned by bgzf_tell()
+	 * @return         actual virtual file offset, unchanged if multi-threading not enabled; -1 on error
+	 */
+	INT64 bgzf_mt_voffset(BGZF *fp, INT64 voffset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -339,3 +339,157 @@ CSAIS::sais_int_bwt(const int *T, int *U, int *A, int n, int k) {
   pidx += 1;
   return pidx;
 }
+
+// 64bit index variants
+// These mirror getCounts(), getBuckets(), induceSA() and sais_main() above but use INT64 indexes throughout
+// so that texts (concatenated sequences) of more than 2^31-1 symbols can be sorted; BWT generation is not supported
+#define chr64(i) (cs == sizeof(INT64) ? ((const INT64 *)T)[i]:(INT64)((const unsigned char *)T)[i])
+
+void
+CSAIS::getCounts64(const unsigned char *T, INT64 *C, INT64 n, INT64 k, int cs) {
+  INT64 i;
+  for(i = 0; i < k; ++i) { C[i] = 0; }
+  for(i = 0; i < n; ++i) { ++C[chr64(i)]; }
+}
+
+void
+CSAIS::getBuckets64(const INT64 *C, INT64 *B, INT64 k, int end) {
+  INT64 i, sum = 0;
+  if(end) { for(i = 0; i < k; ++i) { sum += C[i]; B[i] = sum; } }
+  else { for(i = 0; i < k; ++i) { sum += C[i]; B[i] = sum - C[i]; } }
+}
+
+void
+CSAIS::induceSA64(const unsigned char *T, INT64 *SA, INT64 *C, INT64 *B, INT64 n, INT64 k, int cs) {
+  INT64 *b, i, j;
+  INT64 c0, c1;
+  /* compute SAl */
+  if(C == B) { getCounts64(T, C, n, k, cs); }
+  getBuckets64(C, B, k, 0); /* find starts of buckets */
+  j = n - 1;
+  b = SA + B[c1 = chr64(j)];
+  *b++ = ((0 < j) && (chr64(j - 1) < c1)) ? ~j : j;
+  for(i = 0; i < n; ++i) {
+    j = SA[i], SA[i] = ~j;
+    if(0 < j) {
+      --j;
+      if((c0 = chr64(j)) != c1)
+		{
+		B[c1] = (INT64)(b - SA);
+		b = SA + B[c1 = c0];
+	    }
+      *b++ = ((0 < j) && (chr64(j - 1) < c1)) ? ~j : j;
+    }
+  }
+  /* compute SAs */
+  if(C == B) { getCounts64(T, C, n, k, cs); }
+  getBuckets64(C, B, k, 1); /* find ends of buckets */
+  for(i = n - 1, b = SA + B[c1 = 0]; 0 <= i; --i) {
+    if(0 < (j = SA[i])) {
+      --j;
+      if((c0 = chr64(j)) != c1)
+		{
+		B[c1] = (INT64)(b - SA);
+		b = SA + B[c1 = c0];
+		}
+      *--b = ((j == 0) || (chr64(j - 1) > c1)) ? ~j : j;
+    } else {
+      SA[i] = ~j;
+    }
+  }
+}
+
+int
+CSAIS::sais_main64(const unsigned char *T, INT64 *SA, INT64 fs, INT64 n, INT64 k, int cs) {
+  INT64 *C, *B, *RA;
+  INT64 i, j, c, m, p, q, plen, qlen, name;
+  INT64 c0, c1;
+  int diff;
+
+  /* stage 1: reduce the problem by at least 1/2
+     sort all the S-substrings */
+  if(k <= fs) {
+    C = SA + n;
+    B = (k <= (fs - k)) ? C + k : C;
+  } else {
+    if((C = (INT64 *)malloc((size_t)k * sizeof(INT64))) == NULL) { return -2; }
+    B = C;
+  }
+  getCounts64(T, C, n, k, cs); getBuckets64(C, B, k, 1); /* find ends of buckets */
+  for(i = 0; i < n; ++i) { SA[i] = 0; }
+  for(i = n - 2, c = 0, c1 = chr64(n - 1); 0 <= i; --i, c1 = c0) {
+    if((c0 = chr64(i)) < (c1 + c)) { c = 1; }
+    else if(c != 0) { SA[--B[c1]] = i + 1, c = 0; }
+  }
+  induceSA64(T, SA, C, B, n, k, cs);
+  if(fs < k) { free(C); }
+
+  /* compact all the sorted substrings into the first m items of SA
+     2*m must be not larger than n (proveable) */
+  for(i = 0, m = 0; i < n; ++i) {
+    p = SA[i];
+    if((0 < p) && (chr64(p - 1) > (c0 = chr64(p)))) {
+      for(j = p + 1; (j < n) && (c0 == (c1 = chr64(j))); ++j) { }
+      if((j < n) && (c0 < c1)) { SA[m++] = p; }
+    }
+  }
+  j = m + (n >> 1);
+  for(i = m; i < j; ++i) { SA[i] = 0; } /* init the name array buffer */
+  /* store the length of all substrings */
+  for(i = n - 2, j = n, c = 0, c1 = chr64(n - 1); 0 <= i; --i, c1 = c0) {
+    if((c0 = chr64(i)) < (c1 + c)) { c = 1; }
+    else if(c != 0) { SA[m + ((i + 1) >> 1)] = j - i - 1; j = i + 1; c = 0; }
+  }
+  /* find the lexicographic names of all substrings */
+  for(i = 0, name = 0, q = n, qlen = 0; i < m; ++i) {
+    p = SA[i], plen = SA[m + (p >> 1)], diff = 1;
+    if(plen == qlen) {
+      for(j = 0; (j < plen) && (chr64(p + j) == chr64(q + j)); ++j) { }
+      if(j == plen) { diff = 0; }
+    }
+    if(diff != 0) { ++name, q = p, qlen = plen; }
+    SA[m + (p >> 1)] = name;
+  }
+
+  /* stage 2: solve the reduced problem
+     recurse if names are not yet unique */
+  if(name < m) {
+    RA = SA + n + fs - m;
+    for(i = m + (n >> 1) - 1, j = m - 1; m <= i; --i) {
+      if(SA[i] != 0) { RA[j--] = SA[i] - 1; }
+    }
+    if(sais_main64((unsigned char *)RA, SA, fs + n - m * 2, m, name, sizeof(INT64)) != 0) { return -2; }
+    for(i = n - 2, j = m - 1, c = 0, c1 = chr64(n - 1); 0 <= i; --i, c1 = c0) {
+      if((c0 = chr64(i)) < (c1 + c)) { c = 1; }
+      else if(c != 0) { RA[j--] = i + 1, c = 0; } /* get p1 */
+    }
+    for(i = 0; i < m; ++i) { SA[i] = RA[SA[i]]; } /* get index */
+  }
+
+  /* stage 3: induce the result for the original problem */
+  if(k <= fs) {
+    C = SA + n;
+    B = (k <= (fs - k)) ? C + k : C;
+  } else {
+    if((C = (INT64 *)malloc((size_t)k * sizeof(INT64))) == NULL) { return -2; }
+    B = C;
+  }
+  /* put all left-most S characters into their buckets */
+  getCounts64(T, C, n, k, cs); getBuckets64(C, B, k, 1); /* find ends of buckets */
+  for(i = m; i < n; ++i) { SA[i] = 0; } /* init SA[m..n-1] */
+  for(i = m - 1; 0 <= i; --i) {
+    j = SA[i], SA[i] = 0;
+    SA[--B[chr64(j)]] = j;
+  }
+  induceSA64(T, SA, C, B, n, k, cs);
+  if(fs < k) { free(C); }
+
+  return 0;
+}
+
+int
+CSAIS::sais64(const unsigned char *T, INT64 *SA, INT64 n, int k) {
+  if((T == NULL) || (SA == NULL) || (n < 0) || (k <= 0) || (k > 256)) { return -1; }
+  if(n <= 1) { if(n == 1) { SA[0] = 0; } return 0; }
+  return sais_main64(T, SA, 0, n, k, sizeof(unsigned char));
+}
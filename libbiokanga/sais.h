@@ -11,6 +11,12 @@ class CSAIS
 		use a working space (excluding T and SA) of at most 2n+O(1) for a constant alphabet */
 	int sais_main(const unsigned char *T, int *SA, int fs, int n, int k, int cs, int isbwt);
 
+	// 64bit index variants of the above, used when the text length is too long to be indexed with 32bit signed ints
+	void getCounts64(const unsigned char *T, INT64 *C, INT64 n, INT64 k, int cs);
+	void getBuckets64(const INT64 *C, INT64 *B, INT64 k, int end);
+	void induceSA64(const unsigned char *T, INT64 *SA, INT64 *C, INT64 *B, INT64 n, INT64 k, int cs);
+	int sais_main64(const unsigned char *T, INT64 *SA, INT64 fs, INT64 n, INT64 k, int cs);
+
 public:
 	CSAIS(void){};
 	~CSAIS(void){};
@@ -20,4 +26,6 @@ public:
 	int sais_bwt(const unsigned char *T, unsigned char *U, int *A, int n);
 	int sais_int_bwt(const int *T, int *U, int *A, int n, int k);
 
+	int sais64(const unsigned char *T, INT64 *SA, INT64 n, int k = 256); // T must only contain symbols in range 0..k-1
+
 };
@@ -559,6 +559,7 @@ int Len;
 int Features;
 int AccumFeatures;
 int NumFeatsOverlap;
+tsBEDOverlapCursor OverlapCursor;
 int FeatMsk;
 int FeatIdx;
 UINT32 ElID;
@@ -804,12 +805,12 @@ for(ElID = 1; ElID <= m_NumEls; ElID++)
 			// see if overlapping any features
 			AccumFeatures = 0;
 			NumFeatsOverlap = 0;
+			m_pBiobed->InitOverlapCursor(&OverlapCursor,ChromID,	// feature is on which chromsome
+										 CoreStartLoci,						// feature must end on or after Start
+										 CoreEndLoci);						// and start on or before End 
 			do
 				{
-				FeatID=m_pBiobed->LocateFeatureIDinRangeOnChrom(ChromID,	// feature is on which chromsome
-										 CoreStartLoci,						// feature must end on or after Start
-										 CoreEndLoci,						// and start on or before End 
-										 NumFeatsOverlap+1);				// Ith instance to return (1..n)
+				FeatID=m_pBiobed->NextOverlapFeatureID(&OverlapCursor);
 
 				if(FeatID > 0 && m_pFeatCntDists != NULL)
 					{
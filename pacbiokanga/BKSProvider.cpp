@@ -21,6 +21,9 @@
 #include <pthread.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <netdb.h>
 typedef struct sockaddr_storage SOCKADDR_STORAGE;
 #include "../libbiokanga/commhdrs.h"
@@ -36,6 +39,7 @@ CBKSProvider::CBKSProvider()
 m_bCreatedMutexes = false;
 m_bTermConnectionReq = false;
 m_bNotifiedReqs = false;
+m_szLocalSockPath[0] = '\0';
 m_NumInitTypes = 0;
 m_MaxServInsts = 0;
 m_MaxServMemGB = 0;
@@ -43,6 +47,12 @@ m_CASSerialise = 0;
 m_NumPendCpltd = 0;
 m_NumWorkerInsts = 0;
 m_NumSWAlignReqs = 0;
+m_LoadCells = 0;
+m_LoadBusyUSecs = 0;
+m_LoadRptCells = 0;
+m_LoadRptBusyUSecs = 0;
+m_LoadRptAtSecs = 0;
+m_LoadKCellsPerSec = 0;
 m_NumClassInsts = 0;
 m_MaxClassInsts = 0;
 m_HiClassInstanceID = 0;							
@@ -202,7 +212,11 @@ CBKSProvider::GetJobToProcess(UINT32 *pInstanceID,		// MANDATORY:  service insta
 {
 teBKSPProvState BKSPState;
 UINT32 InstanceID;
+UINT32 ClassIdx;
 tsReqResp *pInstance;
+tsReqResp *pOldest;
+tsClassInstance *pClassInstance;
+UINT8 *pReqData;
 if(pInstanceID == NULL || pMaxParamsSize == NULL || pParams == NULL || pMaxRequestData == NULL || pRequestData == NULL)
 	return(eBSFerrParams);
 	// check if all threads requested to terminate
@@ -224,38 +238,64 @@ if((BKSPState = (teBKSPProvState)m_BKSConnection.BKSPState) != eBKSPSAcceptedSer
 	return(0);
 	}
 
+// multiple requests may be outstanding on the same class instance (e.g. pipelined batches) and these must be processed serially in the order received
+// so only accept requests on class instances not currently being processed, and choose the oldest of these requests
+pOldest = NULL;
 pInstance = (tsReqResp *)m_BKSConnection.pReqResp;
-for(InstanceID = 1; InstanceID <= m_BKSConnection.NumInstances; InstanceID+=1)
+for(InstanceID = 1; InstanceID <= m_BKSConnection.NumInstances; InstanceID+=1, pInstance = (tsReqResp *)((UINT8 *)pInstance + m_BKSConnection.ReqRespInstSize))
 	{
-	if(pInstance->InstanceID == InstanceID && pInstance->flgReqAvail)
+	if(pInstance->InstanceID != InstanceID || !pInstance->flgReqAvail)
+		continue;
+	if(pInstance->ClassInstanceID != 0)
 		{
-		if(*pMaxParamsSize < pInstance->ParamSize)
-			{
-			ReleaseLock(true);
-			return(-1);
-			}
+		ClassIdx = ((UINT32)(pInstance->ClassInstanceID >> 40) & 0x0fff)-1;
+		if(ClassIdx < m_MaxClassInsts && m_ClassInstances[ClassIdx].ClassInstanceID == pInstance->ClassInstanceID && m_ClassInstances[ClassIdx].BusyInstanceIDEx != 0)
+			continue;
+		}
+	if(pOldest == NULL || (INT32)(pInstance->ReqSeqNum - pOldest->ReqSeqNum) < 0)
+		pOldest = pInstance;
+	}
 
-		if (*pMaxRequestData < pInstance->InDataSize)
-			{
-			ReleaseLock(true);
-			return(-2);
-			}
+if(pOldest != NULL)
+	{
+	pInstance = pOldest;
+	if(*pMaxParamsSize < pInstance->ParamSize)
+		{
+		ReleaseLock(true);
+		return(-1);
+		}
 
-		if(pInstance->ParamSize > 0)
-			memcpy(pParams,pInstance->Data,pInstance->ParamSize);
-		if (pInstance->InDataSize > 0)
-			memcpy(pRequestData, &pInstance->Data[pInstance->ParamSize], pInstance->InDataSize);
-		*pClassInstanceID = pInstance->ClassInstanceID;
-		*pClassMethodID = pInstance->ClassMethodID;
-		pInstance->flgReqAvail = 0;
-		pInstance->flgProc = 1;
-		m_BKSConnection.InstancesProc += 1;
-		m_BKSConnection.InstancesReqAvail -= 1;
-		*pInstanceID = pInstance->InstanceIDEx;
+	if (*pMaxRequestData < pInstance->InDataSize)
+		{
 		ReleaseLock(true);
-		return(1);
+		return(-2);
+		}
+
+	if(pInstance->ShmSlot != 0)
+		pReqData = m_BKSConnection.TxdRxd.pShmPayloads + cBKSShmHdrSize + ((size_t)(pInstance->ShmSlot - 1) * m_BKSConnection.TxdRxd.ShmSlotSize);
+	else
+		pReqData = pInstance->Data;
+	if(pInstance->ParamSize > 0)
+		memcpy(pParams,pReqData,pInstance->ParamSize);
+	if (pInstance->InDataSize > 0)
+		memcpy(pRequestData, &pReqData[pInstance->ParamSize], pInstance->InDataSize);
+	*pClassInstanceID = pInstance->ClassInstanceID;
+	*pClassMethodID = pInstance->ClassMethodID;
+	*pMaxParamsSize = pInstance->ParamSize;
+	*pMaxRequestData = pInstance->InDataSize;
+	if(pInstance->ClassInstanceID != 0)
+		{
+		ClassIdx = ((UINT32)(pInstance->ClassInstanceID >> 40) & 0x0fff)-1;
+		if(ClassIdx < m_MaxClassInsts && (pClassInstance = &m_ClassInstances[ClassIdx])->ClassInstanceID == pInstance->ClassInstanceID)
+			pClassInstance->BusyInstanceIDEx = pInstance->InstanceIDEx;
 		}
-	pInstance = (tsReqResp *)((UINT8 *)pInstance + m_BKSConnection.ReqRespInstSize);
+	pInstance->flgReqAvail = 0;
+	pInstance->flgProc = 1;
+	m_BKSConnection.InstancesProc += 1;
+	m_BKSConnection.InstancesReqAvail -= 1;
+	*pInstanceID = pInstance->InstanceIDEx;
+	ReleaseLock(true);
+	return(1);
 	}
 
 ReleaseLock(true);
@@ -309,9 +349,24 @@ if(pInstance->InstanceID != InstanceID || pInstance->InstanceIDEx != InstanceIDE
 	return(-1);
 	}
 
+// class instance is no longer being processed, other requests on that class instance can now be started
+if(pInstance->ClassInstanceID != 0)
+	{
+	UINT32 ClassIdx;
+	ClassIdx = ((UINT32)(pInstance->ClassInstanceID >> 40) & 0x0fff)-1;
+	if(ClassIdx < m_MaxClassInsts && m_ClassInstances[ClassIdx].BusyInstanceIDEx == (UINT32)InstanceIDEx)
+		m_ClassInstances[ClassIdx].BusyInstanceIDEx = 0;
+	}
 pInstance->ClassInstanceID = ClassInstanceID;
+if(pInstance->ShmSlot != 0 && (ResponseSize < cBKSMinShmPayload || ResponseSize > m_BKSConnection.TxdRxd.ShmSlotSize))
+	pInstance->ShmSlot = 0;			// response to be returned inline
 if(ResponseSize > 0)
-	memcpy(pInstance->Data, pResponseData, ResponseSize);
+	{
+	if(pInstance->ShmSlot != 0)
+		memcpy(m_BKSConnection.TxdRxd.pShmPayloads + cBKSShmHdrSize + ((size_t)(pInstance->ShmSlot - 1) * m_BKSConnection.TxdRxd.ShmSlotSize), pResponseData, ResponseSize);
+	else
+		memcpy(pInstance->Data, pResponseData, ResponseSize);
+	}
 pInstance->OutDataSize = ResponseSize;
 pInstance->JobRslt = ProcRslt;
 pInstance->flgCpltd = 1;
@@ -339,6 +394,7 @@ tsTxdRxd *pTxdRxd;
 
 m_bTermConnectionReq = true;		// flags that current Session connection is being terminated
 
+DeleteShmPayloads();
 #ifdef _WIN32
 if(m_BKSConnection.TxdRxd.Socket != INVALID_SOCKET)
 	{
@@ -907,6 +963,8 @@ if (!bCpltdWrite)				// if a request frame has been received then ensure it is f
 		// server has accepted offered service, ready to process service requests
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessSessEstab: server has accepted offered %d service instances",m_BKSConnection.NumInstances);
 		m_BKSConnection.BKSPState = eBKSPSAcceptedServiceActv;
+		if(m_szLocalSockPath[0] != '\0' && CreateShmPayloads())
+			m_BKSConnection.TxdRxd.flgKeepAliveReq = 1;		// let requester know promptly that the shared memory payload segment is available
 		return(eBSFSuccess);
 		}
 	}
@@ -941,14 +999,24 @@ sBKSServResp *pServResp;
 tsReqResp *pInstance;
 UINT32 TxFrameSize;
 UINT32 Diff;
+UINT32 ShmSlot;
 
 pServReq = (sBKSServReq *)m_BKSConnection.TxdRxd.pRxdBuff;
 
 if(m_BKSConnection.TxdRxd.flgRxCplt == 0 || pServReq->Hdr.FrameType != eBKSHdrReq)
 	return(0);
 
-	// can't handle if all service instances are already committed to processing previous requests
-if (m_BKSConnection.InstancesBusy >= m_BKSConnection.NumInstances)
+ShmSlot = 0;
+if(pServReq->Hdr.FrameFlags & cBKSFrmFlgShmPayload)		// request parameters+data are in a shared memory payload slot
+	{
+	ShmSlot = *(UINT32 *)pServReq->ParamData + 1;
+	if(m_BKSConnection.TxdRxd.pShmPayloads == NULL || ShmSlot > m_BKSConnection.TxdRxd.ShmSlots ||
+		(pServReq->ParamSize + pServReq->DataSize) > m_BKSConnection.TxdRxd.ShmSlotSize)
+		ShmSlot = (UINT32)-1;
+	}
+
+	// can't handle if all service instances are already committed to processing previous requests, or if request payload is inconsistent
+if (m_BKSConnection.InstancesBusy >= m_BKSConnection.NumInstances || ShmSlot == (UINT32)-1)
 	{
 		// let requester know all service instances are committed - no room at the Inn 
 	TxFrameSize = sizeof(sBKSServResp);
@@ -956,7 +1024,7 @@ if (m_BKSConnection.InstancesBusy >= m_BKSConnection.NumInstances)
 		return(-1);
 	pServResp = (sBKSServResp *)&m_BKSConnection.TxdRxd.pTxdBuff[m_BKSConnection.TxdRxd.TotTxd];
 	pServResp->Hdr.SessionID = m_BKSConnection.TxdRxd.SessionID;
-	pServResp->Hdr.FrameFlags = 0;
+	pServResp->Hdr.FrameFlags = m_BKSConnection.TxdRxd.pShmPayloads != NULL ? cBKSFrmFlgShmAttached : 0;
 	pServResp->Hdr.FrameType = eBKSHdrResp;
 	pServResp->Hdr.RxFrameID = m_BKSConnection.TxdRxd.RxdTxFrameID;
 	pServResp->Hdr.TxFrameID = m_BKSConnection.TxdRxd.TxFrameID++;
@@ -983,15 +1051,20 @@ else  // not all service instances are committed so can accept this request
 			if(m_BKSConnection.TotNumRequests == 0)
 				m_BKSConnection.TotNumRequests = 1;
 			pInstance->InstanceIDEx = (InstanceID & 0x0fff) | (m_BKSConnection.TotNumRequests << 12);
+			pInstance->ReqSeqNum = m_BKSConnection.TotNumRequests;
 			pInstance->JobIDEx = pServReq->JobIDEx;
 			pInstance->ClassInstanceID = pServReq->ClassInstanceID;
 			pInstance->ClassMethodID = pServReq->ClassMethodID;
 			pInstance->ParamSize = pServReq->ParamSize;
 			pInstance->InDataSize = pServReq->DataSize;
-			if ((pServReq->DataSize + pServReq->ParamSize) > 0)
-				memcpy(pInstance->Data, pServReq->ParamData, pServReq->DataSize + pServReq->ParamSize);
-			else
-				pInstance->Data[0] = 0;
+			pInstance->ShmSlot = ShmSlot;
+			if(ShmSlot == 0)			// if in shared memory then copied directly from the slot by the worker thread in GetJobToProcess()
+				{
+				if ((pServReq->DataSize + pServReq->ParamSize) > 0)
+					memcpy(pInstance->Data, pServReq->ParamData, pServReq->DataSize + pServReq->ParamSize);
+				else
+					pInstance->Data[0] = 0;
+				}
 			pInstance->flgReqAvail = 1;
 			m_BKSConnection.InstancesReqAvail += 1;
 			m_BKSConnection.InstancesBusy += 1;
@@ -1046,7 +1119,10 @@ if(m_BKSConnection.InstancesCpltd > 0)
 			if((TxFrameID - m_BKSConnection.TxdRxd.RxdRxFrameID) > 4)
 				break;
 
-			TxFrameSize = sizeof(sBKSServResp) - 1 + pInstance->OutDataSize;
+			if(pInstance->ShmSlot != 0)		// response data already in shared memory payload slot, only the slot index is sent
+				TxFrameSize = sizeof(sBKSServResp) - 1 + sizeof(UINT32);
+			else
+				TxFrameSize = sizeof(sBKSServResp) - 1 + pInstance->OutDataSize;
 			if((m_BKSConnection.TxdRxd.AllocdTxdBuff - m_BKSConnection.TxdRxd.TotTxd) < TxFrameSize)
 				break;
 			pServResp = (sBKSServResp *)&m_BKSConnection.TxdRxd.pTxdBuff[m_BKSConnection.TxdRxd.TotTxd];
@@ -1055,10 +1131,16 @@ if(m_BKSConnection.InstancesCpltd > 0)
 			pServResp->ClassMethodID = pInstance->ClassMethodID;
 			pServResp->JobRslt = pInstance->JobRslt;
 			pServResp->DataSize = pInstance->OutDataSize;
-			if (pInstance->OutDataSize > 0)
-				memcpy(pServResp->Data, pInstance->Data, pInstance->OutDataSize);
+			pServResp->Hdr.FrameFlags = m_BKSConnection.TxdRxd.pShmPayloads != NULL ? cBKSFrmFlgShmAttached : 0;
+			if(pInstance->ShmSlot != 0)
+				{
+				*(UINT32 *)pServResp->Data = pInstance->ShmSlot - 1;
+				pServResp->Hdr.FrameFlags |= cBKSFrmFlgShmPayload;
+				}
+			else
+				if (pInstance->OutDataSize > 0)
+					memcpy(pServResp->Data, pInstance->Data, pInstance->OutDataSize);
 			pServResp->Hdr.FrameLen = TxFrameSize;
-			pServResp->Hdr.FrameFlags = 0;
 			pServResp->Hdr.SessionID = m_BKSConnection.TxdRxd.SessionID;
 			pServResp->Hdr.FrameType = eBKSHdrResp;
 			pServResp->Hdr.RxFrameID = m_BKSConnection.TxdRxd.RxdTxFrameID;
@@ -1256,6 +1338,108 @@ CBKSProvider::ShutdownConnection(socket_t *pSocket)
 	return(bRslt);
 }
 
+// local sessions, connected over a Unix domain socket, exchange request and response payloads through a shared memory segment
+// instead of copying these payloads through the socket; one payload slot for each of the requesters service instances
+// the segment is created by the provider after the requester has accepted the offered service and frames sent thereafter are flagged with cBKSFrmFlgShmAttached
+// the requester, on receiving the first flagged frame, maps the segment and removes its name; until then all payloads are inline within frames
+bool
+CBKSProvider::CreateShmPayloads(void)
+{
+#ifdef _WIN32
+return(false);
+#else
+int Fd;
+size_t SlotSize;
+size_t ShmSize;
+UINT8 *pShm;
+tsBKSShmHdr *pShmHdr;
+char szShmName[100];
+
+DeleteShmPayloads();
+if(m_szLocalSockPath[0] == '\0')
+	return(false);
+
+// only request payloads are sized to fit within slots, larger responses (e.g. multialignments) are returned inline
+SlotSize = ((size_t)m_BKSConnection.MaxReqPayloadSize + 0x0fff) & ~(size_t)0x0fff;
+ShmSize = cBKSShmHdrSize + (SlotSize * m_BKSConnection.NumInstances);
+BKSShmPayloadsName(m_szLocalSockPath,m_BKSConnection.TxdRxd.SessionID,szShmName,sizeof(szShmName));
+shm_unlink(szShmName);			// may be left over from a previous session which was abnormally terminated
+if((Fd = shm_open(szShmName,O_CREAT | O_EXCL | O_RDWR,S_IRUSR | S_IWUSR)) == -1)
+	{
+	gDiagnostics.DiagOut(eDLWarn, gszProcName, "CreateShmPayloads: Unable to create shared memory '%s', payloads will be inline", szShmName);
+	return(false);
+	}
+if(posix_fallocate(Fd,0,ShmSize) != 0 ||		// reserving now, rather than at first write, as writes to unbacked pages would otherwise raise SIGBUS
+	(pShm = (UINT8 *)mmap(NULL,ShmSize,PROT_READ | PROT_WRITE,MAP_SHARED,Fd,0)) == MAP_FAILED)
+	{
+	close(Fd);
+	shm_unlink(szShmName);
+	gDiagnostics.DiagOut(eDLWarn, gszProcName, "CreateShmPayloads: Unable to allocate %llu bytes of shared memory, payloads will be inline", (UINT64)ShmSize);
+	return(false);
+	}
+close(Fd);
+pShmHdr = (tsBKSShmHdr *)pShm;
+pShmHdr->SessionID = m_BKSConnection.TxdRxd.SessionID;
+pShmHdr->NumSlots = m_BKSConnection.NumInstances;
+pShmHdr->SlotSize = (UINT32)SlotSize;
+pShmHdr->Magic = cBKSShmMagic;
+m_BKSConnection.TxdRxd.pShmPayloads = pShm;
+m_BKSConnection.TxdRxd.ShmSize = ShmSize;
+m_BKSConnection.TxdRxd.ShmSlots = m_BKSConnection.NumInstances;
+m_BKSConnection.TxdRxd.ShmSlotSize = (UINT32)SlotSize;
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "CreateShmPayloads: Created shared memory '%s' with %u payload slots", szShmName, m_BKSConnection.NumInstances);
+return(true);
+#endif
+}
+
+void
+CBKSProvider::DeleteShmPayloads(void)
+{
+#ifndef _WIN32
+char szShmName[100];
+if(m_BKSConnection.TxdRxd.pShmPayloads != NULL)
+	{
+	munmap(m_BKSConnection.TxdRxd.pShmPayloads,m_BKSConnection.TxdRxd.ShmSize);
+	BKSShmPayloadsName(m_szLocalSockPath,m_BKSConnection.TxdRxd.SessionID,szShmName,sizeof(szShmName));
+	shm_unlink(szShmName);		// normally already removed by requester after mapping
+	}
+#endif
+m_BKSConnection.TxdRxd.pShmPayloads = NULL;
+m_BKSConnection.TxdRxd.ShmSize = 0;
+m_BKSConnection.TxdRxd.ShmSlots = 0;
+m_BKSConnection.TxdRxd.ShmSlotSize = 0;
+}
+
+// throughput is estimated as the DP cells processed per busy instance second, scaled by the number of worker instances, so is independent of the current request rate
+// estimates are smoothed with an exponentially weighted moving average to reduce the noise from variable length alignments
+void
+CBKSProvider::UpdateLoadRpt(void)
+{
+INT64 Cells;
+INT64 BusyUSecs;
+double KCellsPerSec;
+#ifdef WIN32
+Cells = InterlockedCompareExchange64(&m_LoadCells,0,0);
+BusyUSecs = InterlockedCompareExchange64(&m_LoadBusyUSecs,0,0);
+#else
+Cells = __sync_val_compare_and_swap(&m_LoadCells,0,0);
+BusyUSecs = __sync_val_compare_and_swap(&m_LoadBusyUSecs,0,0);
+#endif
+if(Cells <= m_LoadRptCells || (UINT64)(BusyUSecs - m_LoadRptBusyUSecs) < cMinLoadRptBusyUSecs)
+	return;
+KCellsPerSec = (((double)(Cells - m_LoadRptCells) * 1000.0) / (double)(BusyUSecs - m_LoadRptBusyUSecs)) * m_NumWorkerInsts;
+if(m_LoadKCellsPerSec != 0)
+	KCellsPerSec = (0.75 * m_LoadKCellsPerSec) + (0.25 * KCellsPerSec);
+if(KCellsPerSec < 1.0)
+	KCellsPerSec = 1.0;
+else
+	if(KCellsPerSec > (double)0x7fffffff)
+		KCellsPerSec = (double)0x7fffffff;
+m_LoadKCellsPerSec = (UINT32)KCellsPerSec;
+m_LoadRptCells = Cells;
+m_LoadRptBusyUSecs = BusyUSecs;
+}
+
 int		// -2 unable to initialise, -3 unable to register the service type, -1 if socket level errors, 0  if requested to terminate, 1 if connection timeout
 CBKSProvider::Process(int MaxConnWait,			// wait for at most this many minutes for connection
 					   int MaxServInsts,		// max number of service instances supported
@@ -1498,75 +1682,118 @@ if (pszService == NULL || pszService[0] == '\0')	// use default port if not spec
 Then = (UINT32)time(NULL);
 MaxConnWait *= 60;			// time() returns secs
 
-memset(&AddrInfoHints, 0, sizeof(struct addrinfo));
-AddrInfoHints.ai_family = AF_INET; 		// Return IPv4 and IPv6 choices
-AddrInfoHints.ai_socktype = SOCK_STREAM;
-AddrInfoHints.ai_protocol = IPPROTO_TCP;
-
-Rslt = getaddrinfo(pszHost == NULL || pszHost[0] == '\0' ? NULL : pszHost, pszService == NULL || pszService[0] == '\0' ? cDfltServerPort : pszService, &AddrInfoHints, &pAddrInfoRes);
-if (Rslt != 0)		// errors if != 0
+m_szLocalSockPath[0] = '\0';
+if(BKSIsLocalSockPath(pszHost))		// connecting to a co-located server over a Unix domain socket
 	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseListener: getaddrinfo() failed to resolve host '%s' and service '%s'", pszHost, pszService);
+#ifdef WIN32
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseConnect: local socket '%s' connections are not supported on Windows", pszHost);
 	return(false);
-	}
+#else
+	struct sockaddr_un LocalAddr;
+	if(strlen(pszHost) >= sizeof(LocalAddr.sun_path) || strlen(pszHost) >= sizeof(m_szLocalSockPath))
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseConnect: local socket path '%s' is too long", pszHost);
+		return(false);
+		}
+	memset(&LocalAddr, 0, sizeof(LocalAddr));
+	LocalAddr.sun_family = AF_UNIX;
+	strcpy(LocalAddr.sun_path, pszHost);
+	do {
+		if((ConnectSocket = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+			{
+			gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseConnect: Unable to create local socket");
+			return(false);
+			}
+		if((Rslt = connect(ConnectSocket, (struct sockaddr *)&LocalAddr, sizeof(LocalAddr))) == 0)  // 0 if connected successfully
+			break;
+		close(ConnectSocket);
+		ConnectSocket = -1;
+		sleep(30);
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: Retrying connection ...");
+		}
+	while(((Now = (UINT32)time(NULL)) - Then) <= (UINT32)MaxConnWait);
 
+	if (ConnectSocket == -1)
+		{
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: Unable to connect to local socket '%s'", pszHost);
+		return(false);
+		}
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: connected to local socket '%s'", pszHost);
+	strcpy(m_szLocalSockPath, pszHost);
+#endif
+	}
+else
+	{
+	memset(&AddrInfoHints, 0, sizeof(struct addrinfo));
+	AddrInfoHints.ai_family = AF_INET; 		// Return IPv4 and IPv6 choices
+	AddrInfoHints.ai_socktype = SOCK_STREAM;
+	AddrInfoHints.ai_protocol = IPPROTO_TCP;
 
-do {
-	Rslt = -1;
-	for (pNxtAddrInfoRes = pAddrInfoRes; pNxtAddrInfoRes != NULL; pNxtAddrInfoRes = pNxtAddrInfoRes->ai_next)
+	Rslt = getaddrinfo(pszHost == NULL || pszHost[0] == '\0' ? NULL : pszHost, pszService == NULL || pszService[0] == '\0' ? cDfltServerPort : pszService, &AddrInfoHints, &pAddrInfoRes);
+	if (Rslt != 0)		// errors if != 0
 		{
-		ConnectSocket = socket(pNxtAddrInfoRes->ai_family, pNxtAddrInfoRes->ai_socktype, pNxtAddrInfoRes->ai_protocol);
-	#ifdef WIN32
-		if (ConnectSocket == INVALID_SOCKET)
-	#else
-		if (ConnectSocket == -1)
-	#endif
-			continue;		// try next address
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseListener: getaddrinfo() failed to resolve host '%s' and service '%s'", pszHost, pszService);
+		return(false);
+		}
 
-		if ((Rslt = connect(ConnectSocket, pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen)) == 0)  // 0 if connected successfully
+
+	do {
+		Rslt = -1;
+		for (pNxtAddrInfoRes = pAddrInfoRes; pNxtAddrInfoRes != NULL; pNxtAddrInfoRes = pNxtAddrInfoRes->ai_next)
+			{
+			ConnectSocket = socket(pNxtAddrInfoRes->ai_family, pNxtAddrInfoRes->ai_socktype, pNxtAddrInfoRes->ai_protocol);
+		#ifdef WIN32
+			if (ConnectSocket == INVALID_SOCKET)
+		#else
+			if (ConnectSocket == -1)
+		#endif
+				continue;		// try next address
+
+			if ((Rslt = connect(ConnectSocket, pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen)) == 0)  // 0 if connected successfully
+				break;
+
+		#ifdef WIN32
+			closesocket(ConnectSocket);
+			ConnectSocket = INVALID_SOCKET;
+		#else
+			close(ConnectSocket);
+			ConnectSocket = -1;
+		#endif
+			}
+		if(Rslt == 0)
 			break;
 
 	#ifdef WIN32
-		closesocket(ConnectSocket);
-		ConnectSocket = INVALID_SOCKET;
+		Sleep(30000);
 	#else
-		close(ConnectSocket);
-		ConnectSocket = -1;
+		sleep(30);
 	#endif
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: Retrying connection ...");
 		}
-	if(Rslt == 0)
-		break;
+	while(Rslt != 0 && (((Now = (UINT32)time(NULL)) - Then) <= (UINT32)MaxConnWait));
 
-#ifdef WIN32
-	Sleep(30000);
-#else
-	sleep(30);
-#endif
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: Retrying connection ...");
-	}
-while(Rslt != 0 && (((Now = (UINT32)time(NULL)) - Then) <= (UINT32)MaxConnWait));
-
-	// report the connection address
-#ifdef WIN32
-if (ConnectSocket != INVALID_SOCKET)
-#else
-if (ConnectSocket != -1)
-#endif
-	{
-	getnameinfo(pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen, szHost, sizeof(szHost), szService, sizeof(szService), 0);
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: connected to host '%s' and service '%s' with protocol %d", szHost, szService, pNxtAddrInfoRes->ai_protocol);
-	}
+		// report the connection address
+	#ifdef WIN32
+	if (ConnectSocket != INVALID_SOCKET)
+	#else
+	if (ConnectSocket != -1)
+	#endif
+		{
+		getnameinfo(pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen, szHost, sizeof(szHost), szService, sizeof(szService), 0);
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: connected to host '%s' and service '%s' with protocol %d", szHost, szService, pNxtAddrInfoRes->ai_protocol);
+		}
 
-freeaddrinfo(pAddrInfoRes);
+	freeaddrinfo(pAddrInfoRes);
 
-#ifdef WIN32
-if (ConnectSocket == INVALID_SOCKET)
-#else
-if (ConnectSocket == -1)
-#endif
-	{
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: Unable to bind socket to host '%s' and service '%s'", pszHost, pszService);
-	return(false);
+	#ifdef WIN32
+	if (ConnectSocket == INVALID_SOCKET)
+	#else
+	if (ConnectSocket == -1)
+	#endif
+		{
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseConnect: Unable to bind socket to host '%s' and service '%s'", pszHost, pszService);
+		return(false);
+		}
 	}
 
 // need socket to be non-blocking
@@ -1660,6 +1887,7 @@ CBKSProvider::RxData(tsTxdRxd *pRxd)					// receiving session data
 {
 int RxdLen;
 UINT32 ExpRxdLen;
+UINT32 FrameLen;
 tsBKSPacHdr *pRxdHdr;
 
 // ensure socket is valid
@@ -1711,6 +1939,13 @@ if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame type, FrameType = %u", pRxd->SessionID, pRxdHdr->FrameType);
 		return(false);
 		}
+	if (pRxdHdr->FrameLen < sizeof(tsBKSPacHdr) || pRxdHdr->FrameLen > pRxd->AllocdRxdBuff)
+		{
+		pRxd->flgErr = 1;
+		pRxd->flgErrReason = 4;      // inconsistency in frame sizing
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame sizing, FrameLen = %u", pRxd->SessionID, pRxdHdr->FrameLen);
+		return(false);
+		}
 	if (pRxdHdr->FrameLen <= pRxd->TotRxd)	// accepting this frame for further processing
 		{
 		pRxd->RxdTxFrameID = pRxdHdr->TxFrameID;
@@ -1719,9 +1954,10 @@ if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 			{
 			pRxd->PacRxdAtSecs = time(NULL);
 			pRxd->CurPacRxd = 0;
-			if(pRxd->TotRxd > sizeof(tsBKSPacHdr))
-				memmove(pRxd->pRxdBuff,&pRxd->pRxdBuff[sizeof(tsBKSPacHdr)], pRxd->TotRxd - sizeof(tsBKSPacHdr));
-			pRxd->TotRxd -= sizeof(tsBKSPacHdr);
+			FrameLen = pRxdHdr->FrameLen;		// keepalives may be extended beyond the frame header
+			if(pRxd->TotRxd > FrameLen)
+				memmove(pRxd->pRxdBuff,&pRxd->pRxdBuff[FrameLen], pRxd->TotRxd - FrameLen);
+			pRxd->TotRxd -= FrameLen;
 			}
 		else
 			{
@@ -1810,6 +2046,13 @@ if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame type, FrameType = %u", pRxd->SessionID, pRxdHdr->FrameType);
 		return(false);
 		}
+	if (pRxdHdr->FrameLen < sizeof(tsBKSPacHdr) || pRxdHdr->FrameLen > pRxd->AllocdRxdBuff)
+		{
+		pRxd->flgErr = 1;
+		pRxd->flgErrReason = 4;      // inconsistency in frame sizing
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame sizing, FrameLen = %u", pRxd->SessionID, pRxdHdr->FrameLen);
+		return(false);
+		}
 	if (pRxdHdr->FrameLen <= pRxd->TotRxd)	// accepting this frame for further processing
 		{
 		pRxd->PacRxdAtSecs = time(NULL);
@@ -1817,10 +2060,10 @@ if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 		pRxd->RxdRxFrameID = pRxdHdr->RxFrameID;
 		if (pRxdHdr->FrameType == eBKSHdrKeepalive) // if was a keep alive then already noted when received, slough the frame
 			{
-			pRxd->CurPacRxd = 0;
-			if (pRxd->TotRxd > sizeof(tsBKSPacHdr))
-				memmove(pRxd->pRxdBuff, &pRxd->pRxdBuff[sizeof(tsBKSPacHdr)], pRxd->TotRxd - sizeof(tsBKSPacHdr));
-			pRxd->TotRxd -= sizeof(tsBKSPacHdr);
+			FrameLen = pRxdHdr->FrameLen;		// keepalives may be extended beyond the frame header
+			if (pRxd->TotRxd > FrameLen)
+				memmove(pRxd->pRxdBuff, &pRxd->pRxdBuff[FrameLen], pRxd->TotRxd - FrameLen);
+			pRxd->TotRxd -= FrameLen;
 			pRxd->CurPacRxd = 0;
 			}
 		else
@@ -2233,20 +2476,27 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 
 	if ((m_BKSConnection.BKSPState == eBKSPSAcceptedServiceActv) &&	m_BKSConnection.TxdRxd.TotTxd == 0)
 		{
-		if (m_BKSConnection.TxdRxd.flgKeepAliveReq == 1 || (CurTimeSecs - m_BKSConnection.TxdRxd.PacTxdAtSecs) > m_BKSConnection.KeepaliveSecs / 2)
+		if (m_BKSConnection.TxdRxd.flgKeepAliveReq == 1 || (CurTimeSecs - m_BKSConnection.TxdRxd.PacTxdAtSecs) > m_BKSConnection.KeepaliveSecs / 2 ||
+			(CurTimeSecs - m_LoadRptAtSecs) >= cLoadRptSecs)
 			{
 			m_BKSConnection.TxdRxd.flgKeepAliveReq = 0;
-			// construct a keep alive packet and send
-			tsBKSPacHdr *pHdr = (tsBKSPacHdr *)m_BKSConnection.TxdRxd.pTxdBuff;
-			pHdr->FrameFlags = 0;
-			pHdr->FrameLen = sizeof(tsBKSPacHdr);
+			// construct a keep alive packet, reporting current load, and send
+			UpdateLoadRpt();
+			m_LoadRptAtSecs = CurTimeSecs;
+			tsBKSKeepalive *pKeepalive = (tsBKSKeepalive *)m_BKSConnection.TxdRxd.pTxdBuff;
+			pKeepalive->KCellsPerSec = m_LoadKCellsPerSec;
+			pKeepalive->QueueDepth = m_BKSConnection.InstancesReqAvail;
+			pKeepalive->NumBusy = m_BKSConnection.InstancesProc;
+			tsBKSPacHdr *pHdr = &pKeepalive->Hdr;
+			pHdr->FrameFlags = cBKSFrmFlgLoadRpt | (m_BKSConnection.TxdRxd.pShmPayloads != NULL ? cBKSFrmFlgShmAttached : 0);
+			pHdr->FrameLen = sizeof(tsBKSKeepalive);
 			pHdr->FrameType = eBKSHdrKeepalive;
 			pHdr->RxFrameID = m_BKSConnection.TxdRxd.RxdTxFrameID;
 			if(m_BKSConnection.TxdRxd.TxFrameID == 1)		// note: keep alives do not have incrementing TxFrameIDs, instead using previously sent TxFrameID
 				pHdr->TxFrameID = 0x07f;
 			else
 				pHdr->TxFrameID = m_BKSConnection.TxdRxd.TxFrameID - 1;
-			m_BKSConnection.TxdRxd.TotTxd = sizeof(tsBKSPacHdr);
+			m_BKSConnection.TxdRxd.TotTxd = sizeof(tsBKSKeepalive);
 			TxData(&m_BKSConnection.TxdRxd);
 			}
 		}
@@ -2522,6 +2772,11 @@ if(ThreadIdx != NumInstances)
 m_ReqNumWorkerInsts = NumInstances;
 m_NumWorkerInsts = 0;
 m_NumSWAlignReqs = 0;
+m_LoadCells = 0;
+m_LoadBusyUSecs = 0;
+m_LoadRptCells = 0;
+m_LoadRptBusyUSecs = 0;
+m_LoadKCellsPerSec = 0;
 pThreadPar = m_WorkerInstances;
 for (ThreadIdx = 1; ThreadIdx <= NumInstances; ThreadIdx++, pThreadPar++)
 	{
@@ -2686,6 +2941,7 @@ for(Idx = 0; Idx < m_MaxClassInsts; Idx++, pInstance++)
 			m_HiClassInstanceID = 1;
 		pInstance->ClassInstanceID = ((UINT64)m_BKSConnection.TxdRxd.SessionID << 53) | ((UINT64)(Idx+1) << 40) | m_HiClassInstanceID;
 		m_NumClassInsts += 1;
+		pInstance->BusyInstanceIDEx = 0;
 		ReleaseCASSerialise();
 		pInstance->LastAccessed = time(NULL);
 		if(pInstance->pClass != NULL)		// shouldn't be required but best to be sure!
@@ -2854,13 +3110,473 @@ switch(*pFrom++) {
 return(0);
 }
 
-int 
-CBKSProvider::ProcWorkerThread(tsWorkerInstance *pThreadPar)
+bool										// false if ClassMethodID not supported
+CBKSProvider::ProcClassMethod(tsWorkerInstance *pThreadPar,	// worker thread processing the method
+					UINT64 *pClassInstanceID,	// method applies to this class instance, updated if method constructs or destructs a class instance
+					UINT32 ClassMethodID,		// class method to apply
+					UINT8 *pReqData,			// marshalled method request data
+					UINT32 MaxRespSize,			// response data can be at most this size
+					UINT8 *pRespData,			// marshal method response data into this buffer
+					UINT32 *pRespSize,			// returned marshalled response data size
+					UINT32 *pProcRslt)			// returned method processing result
 {
 bool bRslt;
 int iRslt;
 int ReqDataOfs;
 int RespDataOfs;
+UINT64 ClassInstanceID;
+tsClassInstance *pClassInstance;
+
+ClassInstanceID = *pClassInstanceID;
+*pRespSize = 0;
+*pProcRslt = 0;
+
+switch((teSWMethod)ClassMethodID) {
+	case eSWMConstruct:				// instantiate new class instance
+		if((pClassInstance = AllocClassInstance()) != NULL)
+			ClassInstanceID = pClassInstance->ClassInstanceID;
+		else
+			ClassInstanceID = 0;
+		*pProcRslt = 1;
+		*pRespSize = 0;
+		break;
+
+	case eSWMDestruct:				// destroy class instance
+		FreeClassInstance(ClassInstanceID);
+		ClassInstanceID = 0;
+		*pProcRslt = 1;
+		*pRespSize = 0;
+		break;
+
+	case eSWMSetScores:				// SetScores()
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int MatchScore;			// score for match
+			int MismatchPenalty;	// penalty for mismatch
+			int GapOpenPenalty;		// penalty for opening a gap
+			int GapExtnPenalty;		// penalty if extending already opened gap
+			int DlyGapExtn;			// delayed gap penalties, only apply gap extension penalty if gap at least this length
+			int ProgPenaliseGapExtn;	// if non-zero then progressively increment gap extension penalty for gaps of at least this length, 0 to disable, used for PacBio style error profiles
+			int AnchorLen;			// identified first and last anchors in alignment to be of at least this length
+			ReqDataOfs = UnmarshalReq(sizeof(int),&pReqData[0],&MatchScore);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&MismatchPenalty);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&GapOpenPenalty);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&GapExtnPenalty);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&DlyGapExtn);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&ProgPenaliseGapExtn);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&AnchorLen);
+			bRslt = pClassInstance->pClass->SetScores(MatchScore,MismatchPenalty,GapOpenPenalty,GapExtnPenalty,DlyGapExtn,ProgPenaliseGapExtn,AnchorLen);
+			}
+		else
+			bRslt = false;
+		*pProcRslt = bRslt == true ? 1 : 0;
+		*pRespSize = 0;
+		break;
+
+	case eSWMSetCPScores:			// SetCPScores()
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int MatchScore;			// ClassifyPath() score for match
+			int MismatchPenalty;	// ClassifyPath() penalty for mismatch
+			int GapOpenPenalty;		// ClassifyPath() penalty for opening a gap
+			int GapExtnPenalty;		// ClassifyPath() penalty if extending already opened gap
+			ReqDataOfs = UnmarshalReq(sizeof(int),&pReqData[0],&MatchScore);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&MismatchPenalty);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&GapOpenPenalty);
+			ReqDataOfs += UnmarshalReq(sizeof(int),&pReqData[ReqDataOfs],&GapExtnPenalty);
+			bRslt = pClassInstance->pClass->SetCPScores(MatchScore,MismatchPenalty,GapOpenPenalty,GapExtnPenalty);
+			}
+		else
+			bRslt = false;
+		*pProcRslt = bRslt == true ? 1 : 0;
+		*pRespSize = 0;
+	break;
+
+
+	case eSWMSetMaxInitiatePathOfs:	// SetMaxInitiatePathOfs
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int MaxInitiatePathOfs;	// require SW paths to have started within this many bp (0 to disable) on either the probe or target - effectively anchoring the SW 
+			ReqDataOfs = UnmarshalReq(sizeof(int),&pReqData[0],&MaxInitiatePathOfs);
+			bRslt = pClassInstance->pClass->SetMaxInitiatePathOfs(MaxInitiatePathOfs);
+			}
+		else
+			bRslt = false;
+		*pProcRslt = bRslt == true ? 1 : 0;
+		*pRespSize = 0;
+		break;
+
+	case eSWMPreAllocMaxTargLen:		// PreAllocMaxTargLen
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			UINT32 MaxTargLen;					// preallocate to process targets of this maximal length
+			UINT32 MaxOverlapLen;			// allocating tracebacks for this maximal expected overlap, 0 if no tracebacks required
+			ReqDataOfs = UnmarshalReq(sizeof(UINT32),&pReqData[0],&MaxTargLen);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&MaxOverlapLen);
+			bRslt = pClassInstance->pClass->PreAllocMaxTargLen(MaxTargLen,MaxOverlapLen);
+			}
+		else
+			bRslt = false;
+		*pProcRslt = bRslt == true ? 1 : 0;
+		*pRespSize = 0;
+		break;
+
+	case eSWMStartMultiAlignments:	// StartMultiAlignments
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int SeqLen;						// probe sequence is this length
+			etSeqBase *pProbeSeq;			// probe sequence 
+			int Alignments;					// number of pairwise alignments to allocate for
+			UINT8 Flags;					// flags
+			ReqDataOfs = UnmarshalReq(sizeof(INT32),&pReqData[0],&SeqLen);
+			ReqDataOfs += UnmarshalReq(SeqLen,&pReqData[ReqDataOfs],&pProbeSeq);
+			ReqDataOfs += UnmarshalReq(sizeof(INT32),&pReqData[ReqDataOfs],&Alignments);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT8),&pReqData[ReqDataOfs],&Flags);
+
+			iRslt = pClassInstance->pClass->StartMultiAlignments(SeqLen,pProbeSeq,Alignments,Flags);
+			}
+		else
+			iRslt = -1;
+		*pProcRslt = (UINT32)iRslt;
+		*pRespSize = 0;
+		break;
+
+	case eSWMSetProbe:				// SetProbe
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int SeqLen;						// probe sequence is this length
+			etSeqBase *pProbeSeq;			// probe sequence 
+			ReqDataOfs = UnmarshalReq(sizeof(INT32),&pReqData[0],&SeqLen);
+			ReqDataOfs += UnmarshalReq(SeqLen,&pReqData[ReqDataOfs],&pProbeSeq);
+			bRslt = pClassInstance->pClass->SetProbe(SeqLen,pProbeSeq);
+			}
+		else
+			bRslt = false;
+		*pProcRslt = bRslt == true ? 1 : 0;
+		*pRespSize = 0;
+		break;
+
+	case eSWMSetTarg:				// SetTarg
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int SeqLen;						// target sequence is this length
+			etSeqBase *pTargSeq;			// target sequence 
+			ReqDataOfs = UnmarshalReq(sizeof(INT32),&pReqData[0],&SeqLen);
+			ReqDataOfs += UnmarshalReq(SeqLen,&pReqData[ReqDataOfs],&pTargSeq);
+			bRslt = pClassInstance->pClass->SetTarg(SeqLen,pTargSeq);
+			}
+		else
+			bRslt = false;
+		*pProcRslt = bRslt == true ? 1 : 0;
+		*pRespSize = 0;
+		break;
+
+	case eSWMSetAlignRange:			// SetAlignRange
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			UINT32 m_ProbeStartRelOfs;	// when aligning then start SW from this probe sequence relative offset
+			UINT32 m_TargStartRelOfs; 	// and SW starting from this target sequence relative offset
+			UINT32 m_ProbeRelLen;	// and SW with this probe relative length starting from m_ProbeStartRelOfs - if 0 then until end of probe sequence
+			UINT32 m_TargRelLen;	// and SW with this target relative length starting from m_TargStartRelOfs - if 0 then until end of target sequence
+
+			ReqDataOfs = UnmarshalReq(sizeof(UINT32),pReqData,&m_ProbeStartRelOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&m_TargStartRelOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&m_ProbeRelLen);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&m_TargRelLen);
+			iRslt = pClassInstance->pClass->SetAlignRange(m_ProbeStartRelOfs,m_TargStartRelOfs,m_ProbeRelLen,m_TargRelLen);
+			}
+		else
+			iRslt = -1;
+		*pProcRslt = (UINT32)iRslt;
+		*pRespSize = 0;
+		break;
+
+	case eSWMAlign:					// Align
+		tsSSWCell PeakScoreCell;
+		tsSSWCell *pPeakMatchesCell;
+		bool bPeakScoreCell; 
+#ifdef WIN32
+		InterlockedIncrement(&m_NumSWAlignReqs);		// users are likely to be interested in the number of SW alignments requested
+#else
+		__sync_fetch_and_add(&m_NumSWAlignReqs,1);
+#endif
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int ReqDataOfs;
+			UINT32 MaxOverlapLen;			// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
+			ReqDataOfs = UnmarshalReq(sizeof(bool),pReqData,&bPeakScoreCell);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&MaxOverlapLen);
+			pPeakMatchesCell = pClassInstance->pClass->Align(bPeakScoreCell ? &PeakScoreCell : NULL,MaxOverlapLen);
+			iRslt = 0;
+			}
+		else
+			{
+			bPeakScoreCell = false;
+			pPeakMatchesCell = NULL;
+			iRslt = -1;
+			}
+		if(pPeakMatchesCell != NULL)
+			{
+			RespDataOfs = MarshalResp(pRespData,eRMIPTVarUint8,pPeakMatchesCell,sizeof(tsSSWCell));
+			if(bPeakScoreCell)
+				RespDataOfs += MarshalResp(&pRespData[RespDataOfs],eRMIPTVarUint8,&PeakScoreCell,sizeof(tsSSWCell));
+			}
+		else
+			RespDataOfs = 0;	
+
+		*pProcRslt = (UINT32)iRslt;
+
+		*pRespSize = RespDataOfs;
+		break;
+
+	case eSWMCombinedTargAlign:					// // method which combines the functionality of eSWMSetTarg, eSWMSetAlignRange, eSWMAlign, eSWMClassifyPath, eSWMTracebacksToAlignOps, eSWMAddMultiAlignment into a single method to reduce RMI overheads 
+		tsCombinedTargAlignPars *pCombinedTargAlignPars;
+		tsCombinedTargAlignRet CombinedTargAlignRet;
+		etSeqBase *pTargSeq;			// target sequence 
+#ifdef WIN32
+		InterlockedIncrement(&m_NumSWAlignReqs);		// users are likely to be interested in the number of SW alignments requested
+#else
+		__sync_fetch_and_add(&m_NumSWAlignReqs,1);
+#endif
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int ReqDataOfs;
+			ReqDataOfs = UnmarshalReq(sizeof(tsCombinedTargAlignPars),pReqData,&pCombinedTargAlignPars);
+			ReqDataOfs += UnmarshalReq(pCombinedTargAlignPars->TargSeqLen,&pReqData[ReqDataOfs],&pTargSeq);
+			pCombinedTargAlignPars->pTargSeq = pTargSeq;
+			iRslt = pClassInstance->pClass->CombinedTargAlign(pCombinedTargAlignPars,&CombinedTargAlignRet);
+#ifdef WIN32
+			InterlockedExchangeAdd64(&m_LoadCells,(INT64)pCombinedTargAlignPars->ProbeSeqLen * pCombinedTargAlignPars->TargSeqLen);
+#else
+			__sync_fetch_and_add(&m_LoadCells,(INT64)pCombinedTargAlignPars->ProbeSeqLen * pCombinedTargAlignPars->TargSeqLen);
+#endif
+			}
+		else
+			iRslt = -1;
+		if(iRslt >= 0)
+			RespDataOfs = MarshalResp(pRespData,eRMIPTVarUint8,&CombinedTargAlignRet,sizeof(tsCombinedTargAlignRet));
+		else
+			RespDataOfs = 0;	
+
+		*pProcRslt = (UINT32)iRslt;
+
+		*pRespSize = RespDataOfs;
+		break;
+
+
+	case eSWMClassifyPath:			// ClassifyPath
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			int MaxArtefactDev;				// classify path as artefactual if sliding window of 500bp over any overlap deviates by more than this percentage from the overlap mean
+			UINT32 ProbeStartOfs;			// alignment starts at this probe sequence offset (1..n)
+			UINT32 ProbeEndOfs;				// alignment ends at this probe sequence offset
+			UINT32 TargStartOfs;			// alignment starts at this target sequence offset (1..n)
+			UINT32 TargEndOfs;				// alignment ends at this target sequence offset
+			ReqDataOfs = UnmarshalReq(sizeof(INT32),pReqData,&MaxArtefactDev);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&ProbeStartOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&ProbeEndOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&TargStartOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&TargEndOfs);
+			iRslt = pClassInstance->pClass->ClassifyPath(MaxArtefactDev,ProbeStartOfs,ProbeEndOfs,TargStartOfs,TargEndOfs);
+			}
+		else
+			iRslt = -1;
+		*pProcRslt = (UINT32)iRslt;
+		*pRespSize = 0;
+		break;
+
+	case eSWMTracebacksToAlignOps:	// TracebacksToAlignOps
+		tMAOp *pAlignOps;
+		bool bAlignOps;
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			UINT32 ProbeStartOfs;			// alignment starts at this probe sequence offset (1..n)
+			UINT32 ProbeEndOfs;				// alignment ends at this probe sequence offset
+			UINT32 TargStartOfs;			// alignment starts at this target sequence offset (1..n)
+			UINT32 TargEndOfs;				// alignment ends at this target sequence offset
+			ReqDataOfs = UnmarshalReq(sizeof(UINT32),pReqData,&ProbeStartOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&ProbeEndOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&TargStartOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&TargEndOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(bool),&pReqData[ReqDataOfs],&bAlignOps);
+			iRslt = pClassInstance->pClass->TracebacksToAlignOps(ProbeStartOfs,ProbeEndOfs,TargStartOfs,TargEndOfs,bAlignOps ? &pAlignOps : NULL);
+			}
+		else
+			{
+			iRslt = -1;
+			pAlignOps = NULL;
+			bAlignOps = false;
+			}
+
+		if(bAlignOps && iRslt > 0 && (iRslt * sizeof(tMAOp)) + 16 > MaxRespSize)	// insufficient response buffer remaining
+			iRslt = -1;
+		if(bAlignOps && iRslt > 0)
+			RespDataOfs = MarshalResp(pRespData,eRMIPTVarUint8,pAlignOps,iRslt * sizeof(tMAOp));
+		else
+			RespDataOfs = 0;	
+
+		*pProcRslt = (UINT32)iRslt;
+
+		*pRespSize = RespDataOfs;
+		break;
+
+	case eSWMAddMultiAlignment:		// AddMultiAlignment
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			UINT32 ProbeStartOfs;			// alignment starts at this probe sequence offset (1..n)
+			  UINT32 ProbeEndOfs;			// alignment ends at this probe sequence offset inclusive
+			  UINT32 TargStartOfs;			// alignment starts at this target sequence offset (1..n)
+			  UINT32 TargEndOfs;			// alignment ends at this target sequence offset inclusive
+			  UINT32 TargSeqLen;			// target sequence length
+			  etSeqBase *pTargSeq;			// alignment target sequence
+			  UINT8 Flags;					// bit 7 set if target loaded as a high confidence sequence, bits 0..3 is weighting factor to apply when generating consensus bases
+
+			ReqDataOfs = UnmarshalReq(sizeof(UINT32),pReqData,&ProbeStartOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&ProbeEndOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&TargStartOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&TargEndOfs);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&TargSeqLen);
+			ReqDataOfs += UnmarshalReq(sizeof(etSeqBase **),&pReqData[ReqDataOfs],&pTargSeq);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT8),&pReqData[ReqDataOfs],&Flags);
+			iRslt = pClassInstance->pClass->AddMultiAlignment(ProbeStartOfs,ProbeEndOfs,TargStartOfs,TargEndOfs,TargSeqLen,pTargSeq,Flags);
+			}
+		else
+			iRslt = -1;
+		*pProcRslt = (UINT32)iRslt;
+		*pRespSize = 0;
+		break;
+
+	case eSWMGenMultialignConcensus:	// GenMultialignConcensus
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			iRslt = pClassInstance->pClass->GenMultialignConcensus();
+		else
+			iRslt = -1;
+		*pProcRslt = (UINT32)iRslt;
+		*pRespSize = 0;
+		break;
+
+	case eSWMMAlignCols2fasta:		// MAlignCols2fasta
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			UINT32 ProbeID;				// identifies sequence which was used as the probe when determining the multialignments
+			INT32 MinConf;				// sequence bases averaged over 100bp must be of at least this confidence (0..9)
+			INT32 MinLen;				// and sequence lengths must be of at least this length 
+			UINT32 BuffSize;			// buffer allocated to hold at most this many chars
+			ReqDataOfs = UnmarshalReq(sizeof(INT32),pReqData,&ProbeID);
+			ReqDataOfs += UnmarshalReq(sizeof(INT32),&pReqData[ReqDataOfs],&MinConf);
+			ReqDataOfs += UnmarshalReq(sizeof(INT32),&pReqData[ReqDataOfs],&MinLen);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&BuffSize);
+			if(BuffSize > cMaxMFABuffSize)
+				BuffSize = cMaxMFABuffSize;				
+			if(BuffSize + 16 > MaxRespSize)		// response must fit within remaining response buffer
+				BuffSize = MaxRespSize - 16;
+			iRslt = pClassInstance->pClass->MAlignCols2fasta(ProbeID,MinConf,MinLen,BuffSize,pThreadPar->pszBuffer);
+			}
+		else
+			iRslt = -1;
+		if(iRslt > 0)
+			RespDataOfs = MarshalResp(pRespData,eRMIPTVarUint8,pThreadPar->pszBuffer,iRslt);
+		else
+			RespDataOfs = 0;
+		*pProcRslt = (UINT32)iRslt;
+		*pRespSize = RespDataOfs;
+		break;
+
+	case eSWMMAlignCols2MFA:			// MAlignCols2MFA
+		if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+			{
+			UINT32 ProbeID;		// identifies sequence which was used as the probe when determining the multialignments
+			UINT32 BuffSize;	// buffer allocated to hold at most this many chars
+
+			ReqDataOfs = UnmarshalReq(sizeof(UINT32),pReqData,&ProbeID);
+			ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pReqData[ReqDataOfs],&BuffSize);
+			if(BuffSize > cMaxMFABuffSize)
+				BuffSize = cMaxMFABuffSize;	
+			if(BuffSize + 16 > MaxRespSize)		// response must fit within remaining response buffer
+				BuffSize = MaxRespSize - 16;
+			iRslt = pClassInstance->pClass->MAlignCols2MFA(ProbeID,BuffSize,pThreadPar->pszBuffer);
+			}
+		else
+			iRslt = -1;
+		if(iRslt > 0)
+			RespDataOfs = MarshalResp(pRespData,eRMIPTVarUint8,pThreadPar->pszBuffer,iRslt);
+		else
+			RespDataOfs = 0;
+		*pProcRslt = (UINT32)iRslt;
+		*pRespSize = RespDataOfs;
+		break;
+
+	default:			// currently any other method is not implemented
+		*pProcRslt = (UINT32)-1;
+		*pRespSize = 0;
+		return(false);
+	}
+
+*pClassInstanceID = ClassInstanceID;
+return(true);
+}
+
+UINT32										// returned number of invocations processed with results of at least their MinRslt
+CBKSProvider::ProcBatch(tsWorkerInstance *pThreadPar,	// worker thread processing the batch
+					UINT64 ClassInstanceID,		// all batched methods apply to this class instance
+					UINT32 ReqDataSize,			// batch request data is of this size
+					UINT8 *pReqData,			// batch request data
+					UINT32 *pRespSize)			// returned batch response data size, response is marshalled into pThreadPar->pRespData
+{
+UINT32 NumInvocs;
+UINT32 InvocIdx;
+UINT32 NumAccepted;
+UINT32 ReqDataOfs;
+UINT32 RespDataOfs;
+UINT32 RespSize;
+UINT32 ProcRslt;
+tsSWBatchInvoc *pInvoc;
+tsSWBatchRslt *pRslt;
+
+*(UINT32 *)pThreadPar->pRespData = 0;
+*pRespSize = sizeof(UINT32);
+if(ReqDataSize < sizeof(UINT32))
+	return(0);
+NumInvocs = *(UINT32 *)pReqData;
+if(NumInvocs > cMaxSWBatchInvocs)
+	NumInvocs = cMaxSWBatchInvocs;
+ReqDataOfs = sizeof(UINT32);
+RespDataOfs = sizeof(UINT32);
+NumAccepted = 0;
+for(InvocIdx = 0; InvocIdx < NumInvocs; InvocIdx++)
+	{
+	pInvoc = (tsSWBatchInvoc *)&pReqData[ReqDataOfs];
+	if(ReqDataOfs + sizeof(tsSWBatchInvoc) > ReqDataSize || ReqDataOfs + sizeof(tsSWBatchInvoc) + pInvoc->ReqDataLen > ReqDataSize)
+		break;
+	if(pInvoc->ClassMethodID == eSWMConstruct || pInvoc->ClassMethodID == eSWMDestruct || pInvoc->ClassMethodID == eSWMBatch)	// batches can't change class instance or be nested
+		break;
+	if(RespDataOfs + sizeof(tsSWBatchRslt) + 0x0fff > cMaxRespDataSize)	// always require room for fixed sized responses
+		break;
+	ReqDataOfs += sizeof(tsSWBatchInvoc);
+	pRslt = (tsSWBatchRslt *)&pThreadPar->pRespData[RespDataOfs];
+	RespDataOfs += sizeof(tsSWBatchRslt);
+	if(!ProcClassMethod(pThreadPar,&ClassInstanceID,pInvoc->ClassMethodID,&pReqData[ReqDataOfs],cMaxRespDataSize - RespDataOfs,&pThreadPar->pRespData[RespDataOfs],&RespSize,&ProcRslt))
+		{
+		RespDataOfs -= sizeof(tsSWBatchRslt);
+		break;
+		}
+	pRslt->ClassMethodID = pInvoc->ClassMethodID;
+	pRslt->Rslt = (INT32)ProcRslt;
+	pRslt->RespDataLen = RespSize;
+	RespDataOfs += RespSize;
+	ReqDataOfs += pInvoc->ReqDataLen;
+	*(UINT32 *)pThreadPar->pRespData = InvocIdx + 1;	// number of invocations processed, results are indexed by their handle (invocation index)
+	if(pRslt->Rslt < pInvoc->MinRslt)
+		break;
+	NumAccepted += 1;
+	}
+*pRespSize = RespDataOfs;
+return(NumAccepted);
+}
+
+int 
+CBKSProvider::ProcWorkerThread(tsWorkerInstance *pThreadPar)
+{
 int JobRslt;
 int NumJobsProc;
 UINT32	MaxParamSize;
@@ -2869,7 +3585,9 @@ UINT32 InstanceID;
 
 UINT64 ClassInstanceID;
 UINT32 ClassMethodID;
-tsClassInstance *pClassInstance;
+CStopWatch ProcTimer;
+unsigned long ProcSecs;
+unsigned long ProcUSecs;
 
 NumJobsProc = 0;
 #ifdef WIN32
@@ -2900,356 +3618,22 @@ while(JobRslt >= 0)
 	MaxRequestData = cMaxReqDataSize;
 	if((JobRslt = GetJobToProcess(&InstanceID,&ClassInstanceID,&ClassMethodID, &MaxParamSize,pThreadPar->pParamData,&MaxRequestData,pThreadPar->pReqData)) > 0)
 		{
-		switch((teSWMethod)ClassMethodID) {
-			case eSWMConstruct:				// instantiate new class instance
-				if((pClassInstance = AllocClassInstance()) != NULL)
-					ClassInstanceID = pClassInstance->ClassInstanceID;
-				else
-					ClassInstanceID = 0;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, 1,0, NULL);
-				break;
-
-			case eSWMDestruct:				// destroy class instance
-				FreeClassInstance(ClassInstanceID);
-				ClassInstanceID = 0;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, 1,0, NULL);
-				break;
-
-			case eSWMSetScores:				// SetScores()
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int MatchScore;			// score for match
-					int MismatchPenalty;	// penalty for mismatch
-					int GapOpenPenalty;		// penalty for opening a gap
-					int GapExtnPenalty;		// penalty if extending already opened gap
-					int DlyGapExtn;			// delayed gap penalties, only apply gap extension penalty if gap at least this length
-					int ProgPenaliseGapExtn;	// if non-zero then progressively increment gap extension penalty for gaps of at least this length, 0 to disable, used for PacBio style error profiles
-					int AnchorLen;			// identified first and last anchors in alignment to be of at least this length
-					ReqDataOfs = UnmarshalReq(sizeof(int),&pThreadPar->pReqData[0],&MatchScore);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&MismatchPenalty);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&GapOpenPenalty);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&GapExtnPenalty);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&DlyGapExtn);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&ProgPenaliseGapExtn);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&AnchorLen);
-					bRslt = pClassInstance->pClass->SetScores(MatchScore,MismatchPenalty,GapOpenPenalty,GapExtnPenalty,DlyGapExtn,ProgPenaliseGapExtn,AnchorLen);
-					}
-				else
-					bRslt = false;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, bRslt == true ? 1 : 0,0, NULL);
-				break;
-
-			case eSWMSetCPScores:			// SetCPScores()
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int MatchScore;			// ClassifyPath() score for match
-					int MismatchPenalty;	// ClassifyPath() penalty for mismatch
-					int GapOpenPenalty;		// ClassifyPath() penalty for opening a gap
-					int GapExtnPenalty;		// ClassifyPath() penalty if extending already opened gap
-					ReqDataOfs = UnmarshalReq(sizeof(int),&pThreadPar->pReqData[0],&MatchScore);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&MismatchPenalty);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&GapOpenPenalty);
-					ReqDataOfs += UnmarshalReq(sizeof(int),&pThreadPar->pReqData[ReqDataOfs],&GapExtnPenalty);
-					bRslt = pClassInstance->pClass->SetCPScores(MatchScore,MismatchPenalty,GapOpenPenalty,GapExtnPenalty);
-					}
-				else
-					bRslt = false;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, bRslt == true ? 1 : 0,0, NULL);	
-			break;
-
-
-			case eSWMSetMaxInitiatePathOfs:	// SetMaxInitiatePathOfs
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int MaxInitiatePathOfs;	// require SW paths to have started within this many bp (0 to disable) on either the probe or target - effectively anchoring the SW 
-					ReqDataOfs = UnmarshalReq(sizeof(int),&pThreadPar->pReqData[0],&MaxInitiatePathOfs);
-					bRslt = pClassInstance->pClass->SetMaxInitiatePathOfs(MaxInitiatePathOfs);
-					}
-				else
-					bRslt = false;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, bRslt == true ? 1 : 0,0, NULL);
-				break;
-
-			case eSWMPreAllocMaxTargLen:		// PreAllocMaxTargLen
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					UINT32 MaxTargLen;					// preallocate to process targets of this maximal length
-					UINT32 MaxOverlapLen;			// allocating tracebacks for this maximal expected overlap, 0 if no tracebacks required
-					ReqDataOfs = UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[0],&MaxTargLen);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&MaxOverlapLen);
-					bRslt = pClassInstance->pClass->PreAllocMaxTargLen(MaxTargLen,MaxOverlapLen);
-					}
-				else
-					bRslt = false;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, bRslt == true ? 1 : 0,0, NULL);
-				break;
-
-			case eSWMStartMultiAlignments:	// StartMultiAlignments
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int SeqLen;						// probe sequence is this length
-					etSeqBase *pProbeSeq;			// probe sequence 
-					int Alignments;					// number of pairwise alignments to allocate for
-					UINT8 Flags;					// flags
-					ReqDataOfs = UnmarshalReq(sizeof(INT32),&pThreadPar->pReqData[0],&SeqLen);
-					ReqDataOfs += UnmarshalReq(SeqLen,&pThreadPar->pReqData[ReqDataOfs],&pProbeSeq);
-					ReqDataOfs += UnmarshalReq(sizeof(INT32),&pThreadPar->pReqData[ReqDataOfs],&Alignments);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT8),&pThreadPar->pReqData[ReqDataOfs],&Flags);
-
-					iRslt = pClassInstance->pClass->StartMultiAlignments(SeqLen,pProbeSeq,Alignments,Flags);
-					}
-				else
-					iRslt = -1;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,0, NULL);
-				break;
-
-			case eSWMSetProbe:				// SetProbe
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int SeqLen;						// probe sequence is this length
-					etSeqBase *pProbeSeq;			// probe sequence 
-					ReqDataOfs = UnmarshalReq(sizeof(INT32),&pThreadPar->pReqData[0],&SeqLen);
-					ReqDataOfs += UnmarshalReq(SeqLen,&pThreadPar->pReqData[ReqDataOfs],&pProbeSeq);
-					bRslt = pClassInstance->pClass->SetProbe(SeqLen,pProbeSeq);
-					}
-				else
-					bRslt = false;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, bRslt == true ? 1 : 0,0, NULL);
-				break;
-
-			case eSWMSetTarg:				// SetTarg
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int SeqLen;						// target sequence is this length
-					etSeqBase *pTargSeq;			// target sequence 
-					ReqDataOfs = UnmarshalReq(sizeof(INT32),&pThreadPar->pReqData[0],&SeqLen);
-					ReqDataOfs += UnmarshalReq(SeqLen,&pThreadPar->pReqData[ReqDataOfs],&pTargSeq);
-					bRslt = pClassInstance->pClass->SetTarg(SeqLen,pTargSeq);
-					}
-				else
-					bRslt = false;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, bRslt == true ? 1 : 0,0, NULL);
-				break;
-
-			case eSWMSetAlignRange:			// SetAlignRange
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					UINT32 m_ProbeStartRelOfs;	// when aligning then start SW from this probe sequence relative offset
-					UINT32 m_TargStartRelOfs; 	// and SW starting from this target sequence relative offset
-					UINT32 m_ProbeRelLen;	// and SW with this probe relative length starting from m_ProbeStartRelOfs - if 0 then until end of probe sequence
-					UINT32 m_TargRelLen;	// and SW with this target relative length starting from m_TargStartRelOfs - if 0 then until end of target sequence
-
-					ReqDataOfs = UnmarshalReq(sizeof(UINT32),pThreadPar->pReqData,&m_ProbeStartRelOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&m_TargStartRelOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&m_ProbeRelLen);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&m_TargRelLen);
-					iRslt = pClassInstance->pClass->SetAlignRange(m_ProbeStartRelOfs,m_TargStartRelOfs,m_ProbeRelLen,m_TargRelLen);
-					}
-				else
-					iRslt = -1;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,0, NULL);
-				break;
-
-			case eSWMAlign:					// Align
-				tsSSWCell PeakScoreCell;
-				tsSSWCell *pPeakMatchesCell;
-				bool bPeakScoreCell; 
-#ifdef WIN32
-				InterlockedIncrement(&m_NumSWAlignReqs);		// users are likely to be interested in the number of SW alignments requested
-#else
-				__sync_fetch_and_add(&m_NumSWAlignReqs,1);
-#endif
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int ReqDataOfs;
-					UINT32 MaxOverlapLen;			// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
-					ReqDataOfs = UnmarshalReq(sizeof(bool),pThreadPar->pReqData,&bPeakScoreCell);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&MaxOverlapLen);
-					pPeakMatchesCell = pClassInstance->pClass->Align(bPeakScoreCell ? &PeakScoreCell : NULL,MaxOverlapLen);
-					iRslt = 0;
-					}
-				else
-					{
-					bPeakScoreCell = false;
-					pPeakMatchesCell = NULL;
-					iRslt = -1;
-					}
-				if(pPeakMatchesCell != NULL)
-					{
-					RespDataOfs = MarshalResp(pThreadPar->pRespData,eRMIPTVarUint8,pPeakMatchesCell,sizeof(tsSSWCell));
-					if(bPeakScoreCell)
-						RespDataOfs += MarshalResp(&pThreadPar->pRespData[RespDataOfs],eRMIPTVarUint8,&PeakScoreCell,sizeof(tsSSWCell));
-					}
-				else
-					RespDataOfs = 0;	
-
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,RespDataOfs, pThreadPar->pRespData);
-				break;
-
-			case eSWMCombinedTargAlign:					// // method which combines the functionality of eSWMSetTarg, eSWMSetAlignRange, eSWMAlign, eSWMClassifyPath, eSWMTracebacksToAlignOps, eSWMAddMultiAlignment into a single method to reduce RMI overheads 
-				tsCombinedTargAlignPars *pCombinedTargAlignPars;
-				tsCombinedTargAlignRet CombinedTargAlignRet;
-				etSeqBase *pTargSeq;			// target sequence 
+		UINT32 RespSize;
+		UINT32 ProcRslt;
+		ProcTimer.Reset();
+		ProcTimer.Start();
+		if(ClassMethodID == eSWMBatch)
+			ProcRslt = ProcBatch(pThreadPar,ClassInstanceID,MaxRequestData,pThreadPar->pReqData,&RespSize);
+		else
+			ProcClassMethod(pThreadPar,&ClassInstanceID,ClassMethodID,pThreadPar->pReqData,cMaxRespDataSize,pThreadPar->pRespData,&RespSize,&ProcRslt);
+		ProcTimer.Stop();
+		ProcSecs = ProcTimer.ReadUSecs(&ProcUSecs);
 #ifdef WIN32
-				InterlockedIncrement(&m_NumSWAlignReqs);		// users are likely to be interested in the number of SW alignments requested
+		InterlockedExchangeAdd64(&m_LoadBusyUSecs,((INT64)ProcSecs * 1000000) + ProcUSecs);
 #else
-				__sync_fetch_and_add(&m_NumSWAlignReqs,1);
+		__sync_fetch_and_add(&m_LoadBusyUSecs,((INT64)ProcSecs * 1000000) + ProcUSecs);
 #endif
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int ReqDataOfs;
-					ReqDataOfs = UnmarshalReq(sizeof(tsCombinedTargAlignPars),pThreadPar->pReqData,&pCombinedTargAlignPars);
-					ReqDataOfs += UnmarshalReq(pCombinedTargAlignPars->TargSeqLen,&pThreadPar->pReqData[ReqDataOfs],&pTargSeq);
-					pCombinedTargAlignPars->pTargSeq = pTargSeq;
-					iRslt = pClassInstance->pClass->CombinedTargAlign(pCombinedTargAlignPars,&CombinedTargAlignRet);
-					}
-				else
-					iRslt = -1;
-				if(iRslt >= 0)
-					RespDataOfs = MarshalResp(pThreadPar->pRespData,eRMIPTVarUint8,&CombinedTargAlignRet,sizeof(tsCombinedTargAlignRet));
-				else
-					RespDataOfs = 0;	
-
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,RespDataOfs, pThreadPar->pRespData);
-				break;
-
-
-			case eSWMClassifyPath:			// ClassifyPath
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					int MaxArtefactDev;				// classify path as artefactual if sliding window of 500bp over any overlap deviates by more than this percentage from the overlap mean
-					UINT32 ProbeStartOfs;			// alignment starts at this probe sequence offset (1..n)
-					UINT32 ProbeEndOfs;				// alignment ends at this probe sequence offset
-					UINT32 TargStartOfs;			// alignment starts at this target sequence offset (1..n)
-					UINT32 TargEndOfs;				// alignment ends at this target sequence offset
-					ReqDataOfs = UnmarshalReq(sizeof(INT32),pThreadPar->pReqData,&MaxArtefactDev);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&ProbeStartOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&ProbeEndOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&TargStartOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&TargEndOfs);
-					iRslt = pClassInstance->pClass->ClassifyPath(MaxArtefactDev,ProbeStartOfs,ProbeEndOfs,TargStartOfs,TargEndOfs);
-					}
-				else
-					iRslt = -1;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,0, NULL);
-				break;
-
-			case eSWMTracebacksToAlignOps:	// TracebacksToAlignOps
-				tMAOp *pAlignOps;
-				bool bAlignOps;
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					UINT32 ProbeStartOfs;			// alignment starts at this probe sequence offset (1..n)
-					UINT32 ProbeEndOfs;				// alignment ends at this probe sequence offset
-					UINT32 TargStartOfs;			// alignment starts at this target sequence offset (1..n)
-					UINT32 TargEndOfs;				// alignment ends at this target sequence offset
-					ReqDataOfs = UnmarshalReq(sizeof(UINT32),pThreadPar->pReqData,&ProbeStartOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&ProbeEndOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&TargStartOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&TargEndOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(bool),&pThreadPar->pReqData[ReqDataOfs],&bAlignOps);
-					iRslt = pClassInstance->pClass->TracebacksToAlignOps(ProbeStartOfs,ProbeEndOfs,TargStartOfs,TargEndOfs,bAlignOps ? &pAlignOps : NULL);
-					}
-				else
-					{
-					iRslt = -1;
-					pAlignOps = NULL;
-					bAlignOps = false;
-					}
-
-				if(bAlignOps && iRslt > 0)
-					RespDataOfs = MarshalResp(pThreadPar->pRespData,eRMIPTVarUint8,pAlignOps,iRslt * sizeof(tMAOp));
-				else
-					RespDataOfs = 0;	
-
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,RespDataOfs, pThreadPar->pRespData);
-				break;
-
-			case eSWMAddMultiAlignment:		// AddMultiAlignment
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					UINT32 ProbeStartOfs;			// alignment starts at this probe sequence offset (1..n)
-					  UINT32 ProbeEndOfs;			// alignment ends at this probe sequence offset inclusive
-					  UINT32 TargStartOfs;			// alignment starts at this target sequence offset (1..n)
-					  UINT32 TargEndOfs;			// alignment ends at this target sequence offset inclusive
-					  UINT32 TargSeqLen;			// target sequence length
-					  etSeqBase *pTargSeq;			// alignment target sequence
-					  UINT8 Flags;					// bit 7 set if target loaded as a high confidence sequence, bits 0..3 is weighting factor to apply when generating consensus bases
-
-					ReqDataOfs = UnmarshalReq(sizeof(UINT32),pThreadPar->pReqData,&ProbeStartOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&ProbeEndOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&TargStartOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&TargEndOfs);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&TargSeqLen);
-					ReqDataOfs += UnmarshalReq(sizeof(etSeqBase **),&pThreadPar->pReqData[ReqDataOfs],&pTargSeq);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT8),&pThreadPar->pReqData[ReqDataOfs],&Flags);
-					iRslt = pClassInstance->pClass->AddMultiAlignment(ProbeStartOfs,ProbeEndOfs,TargStartOfs,TargEndOfs,TargSeqLen,pTargSeq,Flags);
-					}
-				else
-					iRslt = -1;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,0, NULL);
-				break;
-
-			case eSWMGenMultialignConcensus:	// GenMultialignConcensus
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					iRslt = pClassInstance->pClass->GenMultialignConcensus();
-				else
-					iRslt = -1;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,0, NULL);
-				break;
-
-			case eSWMMAlignCols2fasta:		// MAlignCols2fasta
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					UINT32 ProbeID;				// identifies sequence which was used as the probe when determining the multialignments
-					INT32 MinConf;				// sequence bases averaged over 100bp must be of at least this confidence (0..9)
-					INT32 MinLen;				// and sequence lengths must be of at least this length 
-					UINT32 BuffSize;			// buffer allocated to hold at most this many chars
-					ReqDataOfs = UnmarshalReq(sizeof(INT32),pThreadPar->pReqData,&ProbeID);
-					ReqDataOfs += UnmarshalReq(sizeof(INT32),&pThreadPar->pReqData[ReqDataOfs],&MinConf);
-					ReqDataOfs += UnmarshalReq(sizeof(INT32),&pThreadPar->pReqData[ReqDataOfs],&MinLen);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&BuffSize);
-					if(BuffSize > cMaxMFABuffSize)
-						BuffSize = cMaxMFABuffSize;				
-					iRslt = pClassInstance->pClass->MAlignCols2fasta(ProbeID,MinConf,MinLen,BuffSize,pThreadPar->pszBuffer);
-					}
-				else
-					iRslt = -1;
-				if(iRslt > 0)
-					RespDataOfs = MarshalResp(pThreadPar->pRespData,eRMIPTVarUint8,pThreadPar->pszBuffer,iRslt);
-				else
-					RespDataOfs = 0;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,RespDataOfs, pThreadPar->pRespData);
-				break;
-
-			case eSWMMAlignCols2MFA:			// MAlignCols2MFA
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					{
-					UINT32 ProbeID;		// identifies sequence which was used as the probe when determining the multialignments
-					UINT32 BuffSize;	// buffer allocated to hold at most this many chars
-
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&ProbeID);
-					ReqDataOfs += UnmarshalReq(sizeof(UINT32),&pThreadPar->pReqData[ReqDataOfs],&BuffSize);
-					if(BuffSize > cMaxMFABuffSize)
-						BuffSize = cMaxMFABuffSize;	
-					iRslt = pClassInstance->pClass->MAlignCols2MFA(ProbeID,BuffSize,pThreadPar->pszBuffer);
-					}
-				else
-					iRslt = -1;
-				if(iRslt > 0)
-					RespDataOfs = MarshalResp(pThreadPar->pRespData,eRMIPTVarUint8,pThreadPar->pszBuffer,iRslt);
-				else
-					RespDataOfs = 0;
-				JobRslt = JobResponse(InstanceID,ClassInstanceID, (UINT32)iRslt,RespDataOfs, pThreadPar->pRespData);
-				break;
-
-			default:			// currently any other method is not implemented
-				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
-					CUtility::SleepMillisecs(100);	// simulated some work in processing!	
-				else
-					ClassInstanceID = 0;
-				break;
-			}
+		JobRslt = JobResponse(InstanceID,ClassInstanceID,ProcRslt,RespSize,pThreadPar->pRespData);
 
 		NumJobsProc += 1;
 		}
@@ -11,6 +11,8 @@ const int cMaxReqDataSize =  cMaxSWReqPayloadSize;		// each worker thread alloca
 const int cMaxReqParamSize = cMaxSWParamLen;			// each worker thread allocates to process up to this much parameterisation data
 const int cMaxRespDataSize = cMaxSWRespPayloadSize;		// each worker thread allocates to return up to this much response data
 const int cMaxMFABuffSize =  cMaxSWMAFBuffSize;			// each worker thread allocates to hold at most this sized MAlignCols2fasta/MAlignCols2MFA alignments plus row descriptor prefixes
+const UINT32 cLoadRptSecs = 5;							// send requester a load report keepalive at least this often (secs) even if frames are otherwise being actively exchanged
+const UINT64 cMinLoadRptBusyUSecs = 250000;			// throughput estimate only updated after at least this many instance microseconds of processing since previous estimate
 
 // service providers will be in one of these exclusive states
 typedef enum TAG_eBKSPProvState
@@ -51,6 +53,10 @@ typedef struct TAG_sTxdRxd
 	UINT32 AllocdTxdBuff;	// pTxdBuff allocated to hold at most this many bytes
 	UINT8 *pRxdBuff;		// receiving data into this buffer
 	UINT8 *pTxdBuff;		// sending data from this buffer
+	UINT32 ShmSlots;		// number of payload slots in pShmPayloads
+	UINT32 ShmSlotSize;		// each payload slot can hold at most this many bytes
+	size_t ShmSize;			// pShmPayloads mapping is of this size
+	UINT8 *pShmPayloads;	// if non-NULL then mapped shared memory payload segment (tsBKSShmHdr followed by payload slots) for a local session
     SOCKADDR_STORAGE  IPaddress;	// remote IP address + port of endpoint service provider (IPv4 or IPv6)
 } tsTxdRxd;
 
@@ -60,6 +66,8 @@ typedef struct TAG_sReqResp {
 	UINT32 ClassMethodID;				// identifies class method
 	UINT32 InstanceID;					// service instance specific identifier
 	UINT32 InstanceIDEx;				// combination of both the InstanceID (in bits 0..9) and ......
+	UINT32 ReqSeqNum;					// requests were received in this order, requests on the same class instance are processed in this order
+	UINT32 ShmSlot;						// if non-zero then request parameters+data, and subsequently any response data, are in shared memory payload slot ShmSlot-1 instead of Data
 	UINT32 flgReqAvail : 1;				// this service instance is available for processing 
 	UINT32 flgProc: 1;					// this service instance is currently being processed
 	UINT32 flgCpltd: 1;					// service processing has completed and resultset can be sent back to service requester
@@ -139,6 +147,7 @@ typedef struct TAG_sClassInstance {
 	UINT64 ClassInstanceID;				// monotonically incremented 
 	time_t LastAccessed;				// when this class instance was last accessed, used to expire unused class instances
 	CSSW *pClass;						// if non-null then pts to instantiated class instance	
+	UINT32 BusyInstanceIDEx;			// if non-zero then class instance is currently being processed by this service instance (InstanceIDEx) and no other requests on this class instance can be started
 	} tsClassInstance;
 
 #pragma pack()
@@ -153,6 +162,7 @@ class CBKSProvider
 	bool m_bCreatedMutexes;								// set true after serialisation locks/mutexes initialised
 	bool m_bTermConnectionReq;							// connection termination has been requested and is either being progressed or termination has completed
 	bool m_bNotifiedReqs;								// set TRUE if control message has been sent to control socket 2
+	char m_szLocalSockPath[cMaxHostNameLen+1];			// if connected to server over a Unix domain socket then the socket path, else empty string
 	UINT32 m_NumInitTypes;								// number of service types initialised in m_BKSTypes[]
 	tsBKSType m_BKSTypes[eBKSPTPlaceHolder - 1];		// entry for each potentially supported service type indexed by Type-1
 
@@ -170,6 +180,17 @@ class CBKSProvider
 	__attribute__((aligned(4)))  volatile UINT32  m_NumSWAlignReqs;				// number of SW alignments requested
 	__attribute__((aligned(4))) volatile UINT32 m_TermAllThreads;                  // will be set to 1 if all worker threads are to terminate
 #endif
+#ifdef WIN32
+	alignas(8) volatile INT64 m_LoadCells;				// total nominal DP cells (probe length * target length) of SW alignments processed by all worker instances
+	alignas(8) volatile INT64 m_LoadBusyUSecs;			// total microseconds worker instances have been busy processing requests
+#else
+	__attribute__((aligned(8))) volatile INT64 m_LoadCells;		// total nominal DP cells (probe length * target length) of SW alignments processed by all worker instances
+	__attribute__((aligned(8))) volatile INT64 m_LoadBusyUSecs;	// total microseconds worker instances have been busy processing requests
+#endif
+	INT64 m_LoadRptCells;									// m_LoadCells when throughput was last estimated
+	INT64 m_LoadRptBusyUSecs;								// m_LoadBusyUSecs when throughput was last estimated
+	time_t m_LoadRptAtSecs;									// time at which last load report keepalive was sent
+	UINT32 m_LoadKCellsPerSec;								// rolling estimate of throughput over all worker instances, 1000's of DP cells/sec, 0 if yet to be estimated
 	tsWorkerInstance m_WorkerInstances[cMaxServiceInsts];	// to hold all worker instance thread parameters
 
 	UINT32 m_MaxClassInsts;									// at most this many class instances can be instantiated
@@ -237,6 +258,11 @@ class CBKSProvider
 
 	bool ShutdownConnection(socket_t *pSocket);
 
+	bool CreateShmPayloads(void);			// local session only: create the shared memory payload segment through which request and response payloads are exchanged
+	void DeleteShmPayloads(void);			// unmap any shared memory payload segment
+
+	void UpdateLoadRpt(void);				// update rolling throughput estimate from worker instance processing accumulated since previous estimate
+
 
 	int			// returns 0 if no sockets to be monitored with select(), on windows the total number of monitored sockets, on linux the highest socket file descriptor plus 1
 		SetupFDSets(fd_set& ReadFDs,			// select() read available socket descriptor set  
@@ -268,6 +294,23 @@ class CBKSProvider
 					UINT8 *pFrom,		// unmarshal from this marshalled parameter list
 					void *pValue);
 
+	bool										// false if ClassMethodID not supported
+		ProcClassMethod(tsWorkerInstance *pThreadPar,	// worker thread processing the method
+					UINT64 *pClassInstanceID,	// method applies to this class instance, updated if method constructs or destructs a class instance
+					UINT32 ClassMethodID,		// class method to apply
+					UINT8 *pReqData,			// marshalled method request data
+					UINT32 MaxRespSize,			// response data can be at most this size
+					UINT8 *pRespData,			// marshal method response data into this buffer
+					UINT32 *pRespSize,			// returned marshalled response data size
+					UINT32 *pProcRslt);			// returned method processing result
+
+	UINT32										// returned number of invocations processed with results of at least their MinRslt
+		ProcBatch(tsWorkerInstance *pThreadPar,	// worker thread processing the batch
+					UINT64 ClassInstanceID,		// all batched methods apply to this class instance
+					UINT32 ReqDataSize,			// batch request data is of this size
+					UINT8 *pReqData,			// batch request data
+					UINT32 *pRespSize);			// returned batch response data size, response is marshalled into pThreadPar->pRespData
+
 public:
 	CBKSProvider();
 	~CBKSProvider();
@@ -38,6 +38,9 @@
 #include <pthread.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <netdb.h>
 typedef struct sockaddr_storage SOCKADDR_STORAGE;
 #include "../libbiokanga/commhdrs.h"
@@ -51,6 +54,7 @@ CBKSRequester::CBKSRequester()
 {
 m_szHostName[0] = '\0';
 m_szServiceName[0] = '\0';
+m_bLocalListener = false;
 memset(&m_RequesterThread,0,sizeof(m_RequesterThread));
 m_CreatedMutexes = 0;
 m_ThreadActive = 0;
@@ -66,6 +70,7 @@ m_NumPendingReqs = 0;
 m_NumPendingResps = 0;
 m_TotRespsAvail = 0;
 m_bNotifiedReqs = false;
+m_NxtSubmitSeq = 0;
 m_bSessionTermReq = false;
 
 m_pBKSSessEstabs = NULL;
@@ -682,7 +687,8 @@ CBKSRequester::AddJobRequest(tJobIDEx *pJobID,	// returned unique job identifier
 						void *pParams,			// service processing parameters
 						UINT32 InDataSize,		// service processing input data is this total size in bytes
 						void *pInData,			// service processing input data
-						UINT32 SessionID)		// if 0 then use session as specified by ClassInstanceID, otherwise use session corresponding to specific session identifier
+						UINT32 SessionID,		// if 0 then use session as specified by ClassInstanceID, otherwise use session corresponding to specific session identifier
+						UINT64 EstCells)		// estimated DP cells required to process this job, used for balancing load over sessions
 {
 tsBKSType *pType;
 UINT32 ReqRespInstIdx;
@@ -691,12 +697,14 @@ tsBKSRegSessionEx *pSession;
 tsBKSRegSessionEx *pLeastBusy;
 double LeastBusy;
 double CurBusy;
+double Rate;
 UINT32 Idx;
 UINT32 ReqID;
 UINT32 JobSessionID;
 UINT32 InstanceID;
 UINT64 *pClassIdentifier;
 UINT32 TypeSessionID;
+UINT8 *pReqData;
 
 // validate parameters
 if(pJobID == NULL || TypeID <= eBKSPTUndefined || TypeID >= eBKSPTPlaceHolder)
@@ -732,6 +740,7 @@ pLeastBusy = NULL;
 if(ClassInstanceID == 0)		// no pre-existing class instance if 0
 	{
 	// find and note provider with highest capacity to process this job request as a proportion of that providers capacity
+	// capacity is the providers estimated throughput, so faster providers are allocated proportionally more class instances
 	pSession = pType->pFirstSession;
 	LeastBusy = 0.0;
 	do {
@@ -745,11 +754,13 @@ if(ClassInstanceID == 0)		// no pre-existing class instance if 0
 		if(pSession->NumClassInstances > 0 && pSession->NumClassInstances >= pSession->Session.MaxClassInstances)
 			continue;
 
-		if(pLeastBusy == NULL || ((CurBusy = (pSession->Session.NumBusy/pSession->Session.MaxInstances)) <= LeastBusy))
+		Rate = EstSessionRate(pType,pSession);
+		CurBusy = (double)(max(pSession->NumClassInstances,pSession->Session.NumBusy) + 1) / Rate;
+		if(pLeastBusy == NULL || CurBusy <= LeastBusy)
 			{
 			if(pLeastBusy == NULL || CurBusy < LeastBusy || pSession->Session.MaxInstances > pLeastBusy->Session.MaxInstances)
 				{
-				LeastBusy = pSession->Session.NumBusy/pSession->Session.MaxInstances;
+				LeastBusy = CurBusy;
 				pLeastBusy = pSession;
 				}
 			}
@@ -785,11 +796,16 @@ else   // method is on an already instantiated class
 			}
 		}
 	while(pLeastBusy == NULL && (pSession = pSession->pNext) != NULL);
-	if(pLeastBusy == NULL || pLeastBusy->Session.NumBusy >= pLeastBusy->Session.MaxInstances)
+	if(pLeastBusy == NULL)
 		{
 		ReleaseLock(true);
 		return(-1);				// class no longer exists - original session may have been terminated
 		}
+	if(pLeastBusy->Session.NumBusy >= pLeastBusy->Session.MaxInstances)
+		{
+		ReleaseLock(true);
+		return(0);				// class instance may have other requests outstanding (e.g. pipelined batch) so session currently has no capacity to accept this request
+		}
 	pSession = pLeastBusy;
 	}
 
@@ -809,12 +825,24 @@ for(InstanceID = 1; InstanceID <= pSession->Session.MaxInstances; InstanceID++)
 		pReqRespInst->ClassMethodID = ClassMethodID;
 		pReqRespInst->ParamSize = ParamsSize;
 		pReqRespInst->InDataSize = InDataSize;
+		pReqRespInst->EstCells = EstCells;
+		pSession->PendingCells += EstCells;
+		// local sessions with a mapped shared memory payload segment have larger payloads copied directly into this instances slot
+		if(pSession->TxdRxd.pShmPayloads != NULL && InstanceID <= pSession->TxdRxd.ShmSlots &&
+			(ParamsSize + InDataSize) >= cBKSMinShmPayload && (ParamsSize + InDataSize) <= pSession->TxdRxd.ShmSlotSize)
+			{
+			pReqData = pSession->TxdRxd.pShmPayloads + cBKSShmHdrSize + ((size_t)(InstanceID - 1) * pSession->TxdRxd.ShmSlotSize);
+			pReqRespInst->FlgShm = 1;
+			}
+		else
+			pReqData = pReqRespInst->Data;
 		if(ParamsSize > 0)
-			memcpy(pReqRespInst->Data, pParams, ParamsSize);
+			memcpy(pReqData, pParams, ParamsSize);
 		if(InDataSize > 0)
-			memcpy(&pReqRespInst->Data[ParamsSize], pInData, InDataSize);
+			memcpy(&pReqData[ParamsSize], pInData, InDataSize);
 		pReqRespInst->FlgReq = 1;
 		pReqRespInst->SubmitAt = (UINT32)time(NULL);
+		pReqRespInst->SubmitSeq = m_NxtSubmitSeq++;
 		pSession->Session.NumReqs += 1;
 		pSession->Session.NumBusy += 1;
 		pType->FlgReq = 1;
@@ -833,6 +861,98 @@ ReleaseLock(true);
 return(0);		// currently no service provider capacity to accept request
 }
 
+// sessions yet to report their throughput are assumed to have the same per instance throughput as the mean over those sessions which have reported
+double											// estimated throughput in DP cells/sec, or if no provider has yet reported then relative to number of service instances
+CBKSRequester::EstSessionRate(tsBKSType *pType,			// session is providing this service type
+						tsBKSRegSessionEx *pSession)	// estimate for this session
+{
+tsBKSRegSessionEx *pRptSession;
+double RptRate;
+UINT32 RptInstances;
+
+if(pSession->TxdRxd.RptKCellsPerSec > 0)
+	return((double)pSession->TxdRxd.RptKCellsPerSec * 1000.0);
+RptRate = 0.0;
+RptInstances = 0;
+for(pRptSession = pType->pFirstSession; pRptSession != NULL; pRptSession = pRptSession->pNext)
+	{
+	if(pRptSession->Session.BKSPState != eBKSPSRegisteredActv || pRptSession->TxdRxd.RptKCellsPerSec == 0)
+		continue;
+	RptRate += (double)pRptSession->TxdRxd.RptKCellsPerSec * 1000.0;
+	RptInstances += pRptSession->Session.MaxInstances;
+	}
+if(RptInstances == 0)
+	return((double)max(1u,pSession->Session.MaxInstances));
+return((RptRate * max(1u,pSession->Session.MaxInstances)) / RptInstances);
+}
+
+// jobs on a class instance can only be processed by the session on which that class was instantiated, so long tail imbalances are corrected by
+// migrating class instances between jobs to the session with the earliest estimated completion time (ECT) for the next jobs
+// a sessions ECT is the time to complete all its pending jobs plus the next jobs, but no less than the time for a single instance to process the next jobs
+UINT32			// 0 if class instance best remaining on current session, otherwise identifier of session to which the class instance should be migrated
+CBKSRequester::PreferredSession(teBKSPType TypeID,				// service type
+						 UINT64 ClassInstanceID,		// class instance currently on this session
+						 UINT64 EstCells)				// next jobs on class instance are estimated to require this many DP cells
+{
+tsBKSType *pType;
+tsBKSRegSessionEx *pSession;
+tsBKSRegSessionEx *pCurSession;
+tsBKSRegSessionEx *pBestSession;
+UINT32 CurSessionID;
+double Rate;
+double ECT;
+double CurECT;
+double BestECT;
+
+if(EstCells == 0 || ClassInstanceID == 0 || TypeID <= eBKSPTUndefined || TypeID >= eBKSPTPlaceHolder)
+	return(0);
+pType = &m_pBKSTypes[TypeID - 1];
+CurSessionID = (UINT32)((UINT64)ClassInstanceID >> 53);
+AcquireLock(false);
+if(pType->Detail.BKSPType != TypeID || pType->NumSessions < 2)
+	{
+	ReleaseLock(false);
+	return(0);
+	}
+
+pCurSession = NULL;
+for(pSession = pType->pFirstSession; pSession != NULL; pSession = pSession->pNext)
+	if(pSession->Session.SessionID == CurSessionID)
+		{
+		pCurSession = pSession;
+		break;
+		}
+if(pCurSession == NULL || pCurSession->Session.BKSPState != eBKSPSRegisteredActv || pCurSession->TxdRxd.RptKCellsPerSec == 0)
+	{
+	ReleaseLock(false);
+	return(0);
+	}
+
+Rate = EstSessionRate(pType,pCurSession);
+CurECT = max((double)(pCurSession->PendingCells + EstCells) / Rate, ((double)EstCells * pCurSession->Session.MaxInstances) / Rate);
+pBestSession = NULL;
+BestECT = 0.0;
+for(pSession = pType->pFirstSession; pSession != NULL; pSession = pSession->pNext)
+	{
+	if(pSession == pCurSession || pSession->Session.BKSPState != eBKSPSRegisteredActv ||
+		pSession->TxdRxd.RptKCellsPerSec == 0 || pSession->TxdRxd.RptQueueDepth >= pSession->Session.MaxInstances ||	// only sessions with measured throughput and not backlogged with queued requests are candidates
+		pSession->Session.NumBusy >= pSession->Session.MaxInstances ||
+		pSession->NumClassInstances >= pSession->Session.MaxClassInstances)
+		continue;
+	Rate = EstSessionRate(pType,pSession);
+	ECT = max((double)(pSession->PendingCells + EstCells) / Rate, ((double)EstCells * pSession->Session.MaxInstances) / Rate);
+	if(pBestSession == NULL || ECT < BestECT)
+		{
+		BestECT = ECT;
+		pBestSession = pSession;
+		}
+	}
+ReleaseLock(false);
+if(pBestSession == NULL || (BestECT * cMigrateGain) >= CurECT)
+	return(0);
+return(pBestSession->Session.SessionID);
+}
+
 int
 CBKSRequester::SendRequestFrames(void)			// iterate all sessions and if any frames ready to send and room to accept the frame in TxdBuff then initiate the sending
 {
@@ -875,13 +995,16 @@ for (Idx = 0; Idx < eBKSPTPlaceHolder-1; Idx++, pType += 1)
 				break;
 				}
 
-			if(pReqRespInst->FlgReq)		// requested to be sent?
+			if(pReqRespInst->FlgReq && !PriorClassReqPending(pSession,pType,pReqRespInst))		// requested to be sent, and no earlier job on same class instance still to be sent?
 				{
-				FrameLen = sizeof(sBKSServReq) - 1 + pReqRespInst->ParamSize + pReqRespInst->InDataSize;
+				if(pReqRespInst->FlgShm)		// parameters+data already in shared memory payload slot, only the slot index is sent
+					FrameLen = sizeof(sBKSServReq) - 1 + sizeof(UINT32);
+				else
+					FrameLen = sizeof(sBKSServReq) - 1 + pReqRespInst->ParamSize + pReqRespInst->InDataSize;
 				if((pTxdRxd->AllocdTxdBuff - pSession->TxdRxd.TotTxd) > (FrameLen + (sizeof(tsBKSPacHdr) * 5))) // always allow spare room for some session control frames
 					{
 					pFrame = (sBKSServReq *)&pTxdRxd->pTxdBuff[pSession->TxdRxd.TotTxd];
-					pFrame->Hdr.FrameFlags = 0;
+					pFrame->Hdr.FrameFlags = pReqRespInst->FlgShm ? cBKSFrmFlgShmPayload : 0;
 					pFrame->Hdr.FrameLen = FrameLen;
 					pFrame->Hdr.FrameType = eBKSHdrReq;
 					pFrame->Hdr.RxFrameID = pTxdRxd->RxdTxFrameID;
@@ -894,8 +1017,12 @@ for (Idx = 0; Idx < eBKSPTPlaceHolder-1; Idx++, pType += 1)
 					pFrame->ClassMethodID = pReqRespInst->ClassMethodID;
 					pFrame->ParamSize = pReqRespInst->ParamSize;
 					pFrame->DataSize = pReqRespInst->InDataSize;
-					if(pReqRespInst->ParamSize > 0 || pReqRespInst->InDataSize > 0)
-						memcpy(pFrame->ParamData,pReqRespInst->Data,pReqRespInst->ParamSize + pReqRespInst->InDataSize);
+					if(pReqRespInst->FlgShm)
+						*(UINT32 *)pFrame->ParamData = ReqRespInstIdx;
+					else
+						if(pReqRespInst->ParamSize > 0 || pReqRespInst->InDataSize > 0)
+							memcpy(pFrame->ParamData,pReqRespInst->Data,pReqRespInst->ParamSize + pReqRespInst->InDataSize);
+					pReqRespInst->FlgShm = 0;
 					pReqRespInst->FlgReq = 0;
 					pReqRespInst->FlgProc = 1;
 					pSession->Session.NumReqs -= 1;
@@ -908,6 +1035,7 @@ for (Idx = 0; Idx < eBKSPTPlaceHolder-1; Idx++, pType += 1)
 							{
 							ShutdownConnection(&pSession->TxdRxd.Socket);
 							pSession->Session.BKSPState = eBKSPSRegisteredTerm;
+							pSession->PendingCells = 0;			// outstanding requests on a terminated session will never be processed
 							}
 						}
 					}
@@ -926,6 +1054,28 @@ for (Idx = 0; Idx < eBKSPTPlaceHolder-1; Idx++, pType += 1)
 return(0);
 }
 
+// multiple job requests can be outstanding on a class instance, e.g. pipelined batched requests, and service providers process these in the order received
+// so job requests on a class instance must be sent in the order in which they were accepted for submission
+bool
+CBKSRequester::PriorClassReqPending(tsBKSRegSessionEx *pSession,	// session containing job request
+							  tsBKSType *pType,				// job request is for this service type
+							  tsReqRespInst *pReqRespInst)	// returns true if there is an earlier submitted job request on the same class instance still to be sent
+{
+UINT32 ReqRespInstIdx;
+tsReqRespInst *pPrior;
+if(pReqRespInst->ClassInstanceID == 0 || pSession->Session.NumReqs < 2)
+	return(false);
+pPrior = (tsReqRespInst *)pSession->pReqResp;
+for(ReqRespInstIdx = 0; ReqRespInstIdx < pSession->Session.MaxInstances; ReqRespInstIdx++, pPrior = (tsReqRespInst *)((UINT8 *)pPrior + pType->ReqRespInstSize))
+	{
+	if(pPrior == pReqRespInst || !pPrior->FlgReq || pPrior->ClassInstanceID != pReqRespInst->ClassInstanceID)
+		continue;
+	if((INT32)(pPrior->SubmitSeq - pReqRespInst->SubmitSeq) < 0)
+		return(true);
+	}
+return(false);
+}
+
 int   // 0: accepted frame, -1: JobIDEx errors, -2 Session or type errors, -3 mismatch between instance JobIDEx's, ClassInstanceID mismatch
 CBKSRequester::ProcessResponseFrame(tsBKSRegSessionEx *pSession)	// process a received response frame
 {
@@ -1000,9 +1150,17 @@ else // class instance identifier was 0, if request specified a class identifier
 		
 pInstance->ClassMethodID = pResponse->ClassMethodID;
 pInstance->OutDataSize = pResponse->DataSize;
-if(pResponse->DataSize > 0)
-	memcpy(pInstance->Data,pResponse->Data,pResponse->DataSize);
+if(pResponse->Hdr.FrameFlags & cBKSFrmFlgShmPayload)	// response data is in this instances shared memory payload slot, copied from there by GetJobResponse()
+	{
+	if(pTxdRxd->pShmPayloads == NULL || *(UINT32 *)pResponse->Data != InstanceID - 1 || pResponse->DataSize > pTxdRxd->ShmSlotSize)
+		return(-3);
+	pInstance->FlgShm = 1;
+	}
+else
+	if(pResponse->DataSize > 0)
+		memcpy(pInstance->Data,pResponse->Data,pResponse->DataSize);
 pInstance->FlgCpltd = 1;
+pSession->PendingCells -= min(pInstance->EstCells,pSession->PendingCells);
 pSession->Session.NumProcs -= 1;
 pSession->Session.NumCpltd += 1;
 
@@ -1114,7 +1272,12 @@ if(pReqRespInst->FlgCpltd)		// set if job has completed
 	else
 		CpySize = 0;
 	if(CpySize)
-		memcpy(pOutData,pReqRespInst->Data, CpySize);
+		{
+		if(pReqRespInst->FlgShm)
+			memcpy(pOutData,pSession->TxdRxd.pShmPayloads + cBKSShmHdrSize + ((size_t)(InstanceID - 1) * pSession->TxdRxd.ShmSlotSize), CpySize);
+		else
+			memcpy(pOutData,pReqRespInst->Data, CpySize);
+		}
 	if(pOutDataSize != NULL)
 		*pOutDataSize = CpySize;
 	if(pJobRslt != NULL)
@@ -1144,6 +1307,63 @@ ReleaseLock(true);
 return(0);
 }
 
+// job requests which the requester has given up waiting on (timed out or aborted) are no longer counted in their session's pending DP cells
+// a response may still later be received for that job, this response will not again reduce the session's pending DP cells
+int				// < 0 if job no longer exists, 0 if job already completed, 1 if job pending DP cells were removed from its session
+CBKSRequester::AbandonJobRequest(tJobIDEx JobID)	// unique job identifier returned when job was originally submitted
+{
+tsBKSType *pType;
+UINT32 TypeID;
+UINT32 ReqID;
+UINT32 SessionID;
+UINT32 InstanceID;
+UINT32 TypeSessionID;
+tsBKSRegSessionEx *pSession;
+tsReqRespInst *pReqRespInst;
+UINT32 ReqRespInstOfs;
+
+if(JobID < 1)
+	return(-1);
+
+AcquireLock(true);
+if(!UnpackFromJobIDEx(JobID,&ReqID,&SessionID,&InstanceID,&TypeID,&TypeSessionID) ||
+	TypeID == eBKSPTUndefined || TypeID >= eBKSPTPlaceHolder)
+	{
+	ReleaseLock(true);
+	return(-1);
+	}
+
+pType = &m_pBKSTypes[TypeID - 1];
+if(pType->Detail.BKSPType != TypeID || TypeSessionID == 0 || TypeSessionID > pType->MaxSessions)
+	{
+	ReleaseLock(true);
+	return(-1);
+	}
+pSession = pType->pSessions[TypeSessionID-1];
+if(pSession == NULL || pSession->Session.SessionID != SessionID || pSession->Session.MaxInstances < InstanceID)
+	{
+	ReleaseLock(true);
+	return(-1);
+	}
+
+ReqRespInstOfs = pType->ReqRespInstSize;
+ReqRespInstOfs *= (InstanceID-1);
+pReqRespInst = (tsReqRespInst *)&pSession->pReqResp[ReqRespInstOfs];
+if(pReqRespInst->JobIDEx != JobID)
+	{
+	ReleaseLock(true);
+	return(-1);
+	}
+if(pReqRespInst->FlgCpltd)
+	{
+	ReleaseLock(true);
+	return(0);
+	}
+pSession->PendingCells -= min(pReqRespInst->EstCells,pSession->PendingCells);
+pReqRespInst->EstCells = 0;
+ReleaseLock(true);
+return(1);
+}
 
 int
 CBKSRequester::TerminateAllSessions(void)
@@ -1170,6 +1390,7 @@ if(m_pBKSSessEstabs != NULL)
 			free(pSessEstab->TxdRxd.pRxdBuff);
 		if (pSessEstab->TxdRxd.pTxdBuff != NULL)
 			free(pSessEstab->TxdRxd.pTxdBuff);
+		DetachShmPayloads(&pSessEstab->TxdRxd);
 		memset(pSessEstab,0,sizeof(tsBKSSessEstab));
 		pSessEstab->TxdRxd.Socket = INVALID_SOCKET;
 	#else
@@ -1179,6 +1400,7 @@ if(m_pBKSSessEstabs != NULL)
 			free(pSessEstab->TxdRxd.pRxdBuff);
 		if (pSessEstab->TxdRxd.pTxdBuff != NULL)
 			free(pSessEstab->TxdRxd.pTxdBuff);
+		DetachShmPayloads(&pSessEstab->TxdRxd);
 		memset(pSessEstab, 0, sizeof(tsBKSSessEstab));
 		pSessEstab->TxdRxd.Socket = -1;
 	#endif
@@ -1226,6 +1448,7 @@ if(m_pBKSTypes != NULL)
 							free(pSession->TxdRxd.pRxdBuff);
 						if (pSession->TxdRxd.pTxdBuff != NULL)
 							free(pSession->TxdRxd.pTxdBuff);
+						DetachShmPayloads(&pSession->TxdRxd);
 						if(pSession->pReqResp != NULL)
 							free(pSession->pReqResp);
 						pNext = pSession->pNext;
@@ -1279,6 +1502,11 @@ if(m_ListenerSock != -1)
 	close(m_ListenerSock);
 	m_ListenerSock = -1;
 	}
+if(m_bLocalListener)
+	{
+	unlink(m_szHostName);
+	m_bLocalListener = false;
+	}
 #endif
 
 if(m_ppChkPtReqs != NULL)
@@ -1377,7 +1605,7 @@ if (m_NumSessions)
 							free(pSession->TxdRxd.pRxdBuff);
 						if (pSession->TxdRxd.pTxdBuff != NULL)
 							free(pSession->TxdRxd.pTxdBuff);
-
+						DetachShmPayloads(&pSession->TxdRxd);
 
 						if(pSession->Session.NumCpltd != 0)
 #ifdef WIN32
@@ -1695,6 +1923,7 @@ pSessEstab->TxdRxd.Socket = INVALID_SOCKET;
 #else
 pSessEstab->TxdRxd.Socket = -1;
 #endif
+pSessEstab->TxdRxd.pShmPayloads = NULL;		// any shared memory payload mapping now owned by the session
 
 pType = &m_pBKSTypes[pSessEstab->BKSPType - 1];
 
@@ -1813,6 +2042,7 @@ if (pSessEstab->TxdRxd.Socket != INVALID_SOCKET)
 if (pSessEstab->TxdRxd.Socket != -1)
 	close(pSessEstab->TxdRxd.Socket);
 #endif
+DetachShmPayloads(&pSessEstab->TxdRxd);
 memset(pSessEstab,0,sizeof(tsBKSSessEstab));
 pSessEstab->TxdRxd.pRxdBuff = pRxdBuff;
 pSessEstab->TxdRxd.AllocdRxdBuff = AllocdRxdBuff;
@@ -2336,6 +2566,72 @@ bRslt = close(*pSocket) == -1 ? false : true;
 return(bRslt);
 }
 
+// local sessions, connected over a Unix domain socket, exchange request and response payloads through a shared memory segment created by the service provider
+// provider flags all frames sent after creating the segment; on the first flagged frame the segment is mapped and its name removed so it will not outlive the session
+bool
+CBKSRequester::AttachShmPayloads(tsTxdRxd *pTxdRxd)
+{
+#ifdef WIN32
+pTxdRxd->flgShmFailed = 1;
+return(false);
+#else
+int Fd;
+struct stat ShmStat;
+UINT8 *pShm;
+tsBKSShmHdr *pShmHdr;
+char szShmName[100];
+
+if(!m_bLocalListener)
+	{
+	pTxdRxd->flgShmFailed = 1;
+	return(false);
+	}
+BKSShmPayloadsName(m_szHostName,pTxdRxd->SessionID,szShmName,sizeof(szShmName));
+pShm = (UINT8 *)MAP_FAILED;
+if((Fd = shm_open(szShmName,O_RDWR,0)) != -1)
+	{
+	if(fstat(Fd,&ShmStat) == 0 && ShmStat.st_size >= (off_t)cBKSShmHdrSize)
+		pShm = (UINT8 *)mmap(NULL,(size_t)ShmStat.st_size,PROT_READ | PROT_WRITE,MAP_SHARED,Fd,0);
+	close(Fd);
+	shm_unlink(szShmName);
+	}
+if(pShm == (UINT8 *)MAP_FAILED)
+	{
+	gDiagnostics.DiagOut(eDLWarn, gszProcName, "AttachShmPayloads: session %u unable to map shared memory '%s', payloads will be inline", pTxdRxd->SessionID, szShmName);
+	pTxdRxd->flgShmFailed = 1;
+	return(false);
+	}
+pShmHdr = (tsBKSShmHdr *)pShm;
+if(pShmHdr->Magic != cBKSShmMagic || pShmHdr->SessionID != pTxdRxd->SessionID ||
+	((size_t)pShmHdr->NumSlots * pShmHdr->SlotSize) + cBKSShmHdrSize > (size_t)ShmStat.st_size)
+	{
+	munmap(pShm,(size_t)ShmStat.st_size);
+	gDiagnostics.DiagOut(eDLWarn, gszProcName, "AttachShmPayloads: session %u inconsistent shared memory '%s', payloads will be inline", pTxdRxd->SessionID, szShmName);
+	pTxdRxd->flgShmFailed = 1;
+	return(false);
+	}
+pTxdRxd->pShmPayloads = pShm;
+pTxdRxd->ShmSize = (size_t)ShmStat.st_size;
+pTxdRxd->ShmSlots = pShmHdr->NumSlots;
+pTxdRxd->ShmSlotSize = pShmHdr->SlotSize;
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "AttachShmPayloads: session %u mapped shared memory with %u payload slots", pTxdRxd->SessionID, pShmHdr->NumSlots);
+return(true);
+#endif
+}
+
+void
+CBKSRequester::DetachShmPayloads(tsTxdRxd *pTxdRxd)
+{
+#ifndef WIN32
+if(pTxdRxd->pShmPayloads != NULL)
+	munmap(pTxdRxd->pShmPayloads,pTxdRxd->ShmSize);
+#endif
+pTxdRxd->pShmPayloads = NULL;
+pTxdRxd->ShmSize = 0;
+pTxdRxd->ShmSlots = 0;
+pTxdRxd->ShmSlotSize = 0;
+}
+
 int				// returns < 0 if errors, eBSFSuccess if initialisation success
 CBKSRequester::Initialise(char* pszHost,				// listening on this host/IP address; NULL to use first INET IP local to this machine
 						char *pszService,				// listening on this service/port; NULL to use default port 
@@ -2669,66 +2965,102 @@ if (pszService == NULL || pszService[0] == '\0')	// use default port if not spec
 	pszService = (char *)cDfltListenerPort;
 strncpy(m_szServiceName,pszService,sizeof(m_szServiceName));
 m_szServiceName[sizeof(m_szServiceName)-1] = '\0';
-memset(&AddrInfoHints, 0, sizeof(struct addrinfo));
-AddrInfoHints.ai_family = AF_INET; 		// Return IPv4 and IPv6 choices
-AddrInfoHints.ai_socktype = SOCK_STREAM;			 
-AddrInfoHints.ai_protocol = IPPROTO_TCP;		
-
-Rslt = getaddrinfo(pszHost == NULL || pszHost[0] == '\0' ? NULL : pszHost, m_szServiceName, &AddrInfoHints, &pAddrInfoRes);
-if(Rslt != 0)		// errors if != 0
+m_bLocalListener = false;
+if(BKSIsLocalSockPath(pszHost))		// listening for co-located service providers on a Unix domain socket
 	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseListener: getaddrinfo() failed to resolve host '%s' and service '%s'", pszHost, pszService);
+#ifdef WIN32
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseListener: local socket '%s' is not supported on Windows", pszHost);
 	return(false);
+#else
+	struct sockaddr_un LocalAddr;
+	if(strlen(pszHost) >= sizeof(LocalAddr.sun_path) || strlen(pszHost) >= sizeof(m_szHostName))
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseListener: local socket path '%s' is too long", pszHost);
+		return(false);
+		}
+	memset(&LocalAddr, 0, sizeof(LocalAddr));
+	LocalAddr.sun_family = AF_UNIX;
+	strcpy(LocalAddr.sun_path, pszHost);
+	if((ListenerSocket = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseListener: Unable to create local socket");
+		return(false);
+		}
+	unlink(pszHost);			// remove any socket left over from a previous abnormally terminated process
+	if(bind(ListenerSocket, (struct sockaddr *)&LocalAddr, sizeof(LocalAddr)) != 0)
+		{
+		close(ListenerSocket);
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseListener: Unable to bind local socket '%s'", pszHost);
+		return(false);
+		}
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseListener: listening for connections on local socket '%s'", pszHost);
+	strcpy(m_szHostName, pszHost);
+	m_bLocalListener = true;
+#endif
 	}
+else
+	{
+	memset(&AddrInfoHints, 0, sizeof(struct addrinfo));
+	AddrInfoHints.ai_family = AF_INET; 		// Return IPv4 and IPv6 choices
+	AddrInfoHints.ai_socktype = SOCK_STREAM;			 
+	AddrInfoHints.ai_protocol = IPPROTO_TCP;		
 
+	Rslt = getaddrinfo(pszHost == NULL || pszHost[0] == '\0' ? NULL : pszHost, m_szServiceName, &AddrInfoHints, &pAddrInfoRes);
+	if(Rslt != 0)		// errors if != 0
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "InitialiseListener: getaddrinfo() failed to resolve host '%s' and service '%s'", pszHost, pszService);
+		return(false);
+		}
 
-for (pNxtAddrInfoRes = pAddrInfoRes; pNxtAddrInfoRes != NULL; pNxtAddrInfoRes = pNxtAddrInfoRes->ai_next)
-	{
-	ListenerSocket = socket(pNxtAddrInfoRes->ai_family, pNxtAddrInfoRes->ai_socktype, pNxtAddrInfoRes->ai_protocol);
-#ifdef WIN32
-	if (ListenerSocket == INVALID_SOCKET)
-#else
-	if (ListenerSocket == -1)
-#endif
-		continue;		// try next address
 
-	int SockOptEnable = 1;
-	Rslt = setsockopt(ListenerSocket, SOL_SOCKET, SO_REUSEADDR , (char *)&SockOptEnable, sizeof(SockOptEnable));
+	for (pNxtAddrInfoRes = pAddrInfoRes; pNxtAddrInfoRes != NULL; pNxtAddrInfoRes = pNxtAddrInfoRes->ai_next)
+		{
+		ListenerSocket = socket(pNxtAddrInfoRes->ai_family, pNxtAddrInfoRes->ai_socktype, pNxtAddrInfoRes->ai_protocol);
+	#ifdef WIN32
+		if (ListenerSocket == INVALID_SOCKET)
+	#else
+		if (ListenerSocket == -1)
+	#endif
+			continue;		// try next address
 
-	if ((Rslt = bind(ListenerSocket, pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen)) == 0)  // 0 if bound successfully
-		break;
+		int SockOptEnable = 1;
+		Rslt = setsockopt(ListenerSocket, SOL_SOCKET, SO_REUSEADDR , (char *)&SockOptEnable, sizeof(SockOptEnable));
 
-#ifdef WIN32
-	closesocket(ListenerSocket);
-	ListenerSocket = INVALID_SOCKET;
-#else
-	close(ListenerSocket);
-	ListenerSocket = -1;
-#endif
-	}
+		if ((Rslt = bind(ListenerSocket, pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen)) == 0)  // 0 if bound successfully
+			break;
 
-#ifdef WIN32
-if(ListenerSocket == INVALID_SOCKET)
-#else
-if (ListenerSocket == -1)
-#endif
-	{
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseListener: Unable to bind socket to host '%s' and service '%s'", m_szHostName, m_szServiceName);
-	freeaddrinfo(pAddrInfoRes);
-	return(false);
-	}
+	#ifdef WIN32
+		closesocket(ListenerSocket);
+		ListenerSocket = INVALID_SOCKET;
+	#else
+		close(ListenerSocket);
+		ListenerSocket = -1;
+	#endif
+		}
 
+	#ifdef WIN32
+	if(ListenerSocket == INVALID_SOCKET)
+	#else
+	if (ListenerSocket == -1)
+	#endif
+		{
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseListener: Unable to bind socket to host '%s' and service '%s'", m_szHostName, m_szServiceName);
+		freeaddrinfo(pAddrInfoRes);
+		return(false);
+		}
 
-// report the listening address
-getnameinfo(pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen, szHost, sizeof(szHost), szService, sizeof(szService), 0);
-gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseListener: listening for connections to host '%s' and service '%s' with protocol %d", szHost, szService, pNxtAddrInfoRes->ai_protocol);
 
-strncpy(m_szHostName,szHost,sizeof(m_szHostName));
-m_szHostName[sizeof(m_szHostName)-1] = '\0';
-strncpy(m_szServiceName,szService,sizeof(m_szServiceName));
-m_szServiceName[sizeof(m_szServiceName)-1] = '\0';
+	// report the listening address
+	getnameinfo(pNxtAddrInfoRes->ai_addr, (int)pNxtAddrInfoRes->ai_addrlen, szHost, sizeof(szHost), szService, sizeof(szService), 0);
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "InitialiseListener: listening for connections to host '%s' and service '%s' with protocol %d", szHost, szService, pNxtAddrInfoRes->ai_protocol);
 
-freeaddrinfo(pAddrInfoRes);
+	strncpy(m_szHostName,szHost,sizeof(m_szHostName));
+	m_szHostName[sizeof(m_szHostName)-1] = '\0';
+	strncpy(m_szServiceName,szService,sizeof(m_szServiceName));
+	m_szServiceName[sizeof(m_szServiceName)-1] = '\0';
+
+	freeaddrinfo(pAddrInfoRes);
+	}
 
 
 					// need socket to be non-blocking
@@ -2935,17 +3267,23 @@ if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame type, FrameType = %u", pRxd->SessionID, pRxdHdr->FrameType);
 		return(false);
 		}
+	if (pRxdHdr->FrameLen < sizeof(tsBKSPacHdr) || pRxdHdr->FrameLen > pRxd->AllocdRxdBuff)
+		{
+		pRxd->flgErr = 1;
+		pRxd->flgErrReason = 4;      // inconsistency in frame sizing
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame sizing, FrameLen = %u", pRxd->SessionID, pRxdHdr->FrameLen);
+		return(false);
+		}
 	if (pRxdHdr->FrameLen <= pRxd->TotRxd)	// accepting this frame for further processing
 		{
 		pRxd->RxdTxFrameID = pRxdHdr->TxFrameID;
 		pRxd->RxdRxFrameID = pRxdHdr->RxFrameID;
+		if((pRxdHdr->FrameFlags & cBKSFrmFlgShmAttached) && pRxd->pShmPayloads == NULL && !pRxd->flgShmFailed)
+			AttachShmPayloads(pRxd);
 		if(pRxdHdr->FrameType == eBKSHdrKeepalive) // if was a keep alive then note when received and slough the frame
 			{
 			pRxd->PacRxdAtSecs = time(NULL);
-			pRxd->CurPacRxd = 0;
-			if(pRxd->TotRxd > sizeof(tsBKSPacHdr))
-				memmove(pRxd->pRxdBuff,&pRxd->pRxdBuff[sizeof(tsBKSPacHdr)], pRxd->TotRxd - sizeof(tsBKSPacHdr));
-			pRxd->TotRxd -= sizeof(tsBKSPacHdr);
+			RxdKeepalive(pRxd);
 			}
 		else
 			{
@@ -3033,19 +3371,22 @@ if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame type, FrameType = %u", pRxd->SessionID, pRxdHdr->FrameType);
 		return(false);
 		}
+	if (pRxdHdr->FrameLen < sizeof(tsBKSPacHdr) || pRxdHdr->FrameLen > pRxd->AllocdRxdBuff)
+		{
+		pRxd->flgErr = 1;
+		pRxd->flgErrReason = 4;      // inconsistency in frame sizing
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u inconsistency in received frame sizing, FrameLen = %u", pRxd->SessionID, pRxdHdr->FrameLen);
+		return(false);
+		}
 	if (pRxdHdr->FrameLen <= pRxd->TotRxd)	// accepting this frame for further processing
 		{
 		pRxd->PacRxdAtSecs = time(NULL);
 		pRxd->RxdTxFrameID = pRxdHdr->TxFrameID;
 		pRxd->RxdRxFrameID = pRxdHdr->RxFrameID;
+		if((pRxdHdr->FrameFlags & cBKSFrmFlgShmAttached) && pRxd->pShmPayloads == NULL && !pRxd->flgShmFailed)
+			AttachShmPayloads(pRxd);
 		if (pRxdHdr->FrameType == eBKSHdrKeepalive) // if was a keep alive then already noted when received, slough the frame
-			{
-			pRxd->CurPacRxd = 0;
-			if (pRxd->TotRxd > sizeof(tsBKSPacHdr))
-				memmove(pRxd->pRxdBuff, &pRxd->pRxdBuff[sizeof(tsBKSPacHdr)], pRxd->TotRxd - sizeof(tsBKSPacHdr));
-			pRxd->TotRxd -= sizeof(tsBKSPacHdr);
-			pRxd->CurPacRxd = 0;
-			}
+			RxdKeepalive(pRxd);
 		else
 			{
 			pRxd->CurPacRxd = pRxdHdr->FrameLen;
@@ -3057,6 +3398,28 @@ if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 return(true);
 }
 
+// keepalives from service providers may be extended to carry a load report, so keepalive frames are sloughed by their actual frame length
+void
+CBKSRequester::RxdKeepalive(tsTxdRxd *pRxd)
+{
+tsBKSKeepalive *pKeepalive;
+UINT32 FrameLen;
+
+pKeepalive = (tsBKSKeepalive *)pRxd->pRxdBuff;
+FrameLen = pKeepalive->Hdr.FrameLen;		// RxData has already checked FrameLen is at least sizeof(tsBKSPacHdr) and no more than TotRxd
+if((pKeepalive->Hdr.FrameFlags & cBKSFrmFlgLoadRpt) && FrameLen >= sizeof(tsBKSKeepalive))
+	{
+	if(pRxd->RptKCellsPerSec == 0 && pKeepalive->KCellsPerSec != 0)
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "RxData: SessionID: %u service provider initially reported throughput of %u KCells/sec", pRxd->SessionID, pKeepalive->KCellsPerSec);
+	pRxd->RptKCellsPerSec = pKeepalive->KCellsPerSec;
+	pRxd->RptQueueDepth = pKeepalive->QueueDepth;
+	}
+pRxd->CurPacRxd = 0;
+if(pRxd->TotRxd > FrameLen)
+	memmove(pRxd->pRxdBuff,&pRxd->pRxdBuff[FrameLen], pRxd->TotRxd - FrameLen);
+pRxd->TotRxd -= FrameLen;
+}
+
 bool
 CBKSRequester::TxData(tsTxdRxd *pTxd)
 {
@@ -3477,6 +3840,7 @@ while (1)
 							{
 							ShutdownConnection(&pSessionEx->TxdRxd.Socket);
 							pSessionEx->Session.BKSPState = eBKSPSRegisteredTerm;
+							pSessionEx->PendingCells = 0;
 							if(pSessionEx->Session.SessionID != 0)
 								{
 								UnallocSessionID(pSessionEx->Session.SessionID);
@@ -3540,7 +3904,15 @@ while (1)
 #endif
 				{
 									// report the connections peer address
-				getnameinfo((sockaddr*)&SockPeerAddr, SockPeerAddrSize, szPeerHost,sizeof(szPeerHost), szPeerService,sizeof(szPeerService), 0);
+#ifndef WIN32
+				if(SockPeerAddr.ss_family == AF_UNIX)		// local socket peers are unnamed
+					{
+					strcpy(szPeerHost,"local");
+					strcpy(szPeerService,"local");
+					}
+				else
+#endif
+					getnameinfo((sockaddr*)&SockPeerAddr, SockPeerAddrSize, szPeerHost,sizeof(szPeerHost), szPeerService,sizeof(szPeerService), 0);
 
 				UINT32 LastSessionID;
 				if((LastSessionID = AllocSessionID())==0)
@@ -3746,6 +4118,7 @@ while (1)
 							gDiagnostics.DiagOut(eDLInfo, gszProcName, "AcceptConnections: socket error %d, terminating established session: %u", err, pSessionEx->TxdRxd.SessionID);
 							ShutdownConnection(&pSessionEx->TxdRxd.Socket);
 							pSessionEx->Session.BKSPState = eBKSPSRegisteredTerm;
+							pSessionEx->PendingCells = 0;
 							UnallocSessionID(pSessionEx->TxdRxd.SessionID);
 							pSessionEx->TxdRxd.SessionID = 0;
 							pSessionEx->Session.SessionID = 0;
@@ -6,6 +6,7 @@ const int cListenBacklog = 5;					// maximum length of the queue of pending conn
 
 const int cMaxConcurrentRequests = min(4095,cMaxServiceInsts * cMaxNumSessions);	// can process at most this many concurrent service requests over all session instances independent of service type
 const int cMaxReqID = cMaxConcurrentRequests;	// request identifiers will range from 1..cMaxConcurrentRequests
+const double cMigrateGain = 2.0;				// class instances only migrated to another session if that sessions estimated completion time is at least this many times better
 
 // when negotiating with potential service providers then minimal buffer tx/rx buffer sizes are allocated
 const int cMinTxRxBuffSize = (cMaxServiceTypes * sizeof(tsServiceDetail)) + sizeof(tsBKSReqServices) * 3;	// always allocate at least this sized TxdBuff/RxdBuffs - ensures negotiation frames fit!
@@ -46,6 +47,7 @@ typedef struct TAG_sTxdRxd
 	UINT16 flgTxCplt : 1;	// set when complete frame sent
 	UINT16 flgErr : 1;       // set on any unrecoverable error
 	UINT16 flgErrReason : 4;	// holds reason for socket level error flag set
+	UINT16 flgShmFailed : 1;	// set if unable to map the service providers shared memory payload segment, payloads remain inline
 	socket_t  Socket;		// assumed connected socket
 	time_t PacRxdAtSecs;	// the time at which a frame was last received, used for determining if session still active
 	time_t PacTxdAtSecs;	// the time at which a frame was last sent, used for keep alive generation
@@ -61,6 +63,12 @@ typedef struct TAG_sTxdRxd
 	UINT32 AllocdTxdBuff;	// pTxdBuff allocated to hold at most this many bytes
 	UINT8 *pRxdBuff;		// receiving data into this buffer
 	UINT8 *pTxdBuff;		// sending data from this buffer
+	UINT32 ShmSlots;		// number of payload slots in pShmPayloads
+	UINT32 ShmSlotSize;		// each payload slot can hold at most this many bytes
+	size_t ShmSize;			// pShmPayloads mapping is of this size
+	UINT8 *pShmPayloads;	// if non-NULL then mapped shared memory payload segment (tsBKSShmHdr followed by payload slots) for a local session
+	UINT32 RptKCellsPerSec;	// service provider last reported throughput, 1000's of DP cells/sec, 0 if yet to report
+	UINT32 RptQueueDepth;	// service provider last reported number of accepted requests yet to be started
     SOCKADDR_STORAGE  IPaddress;	// remote IP address + port of endpoint service provider (IPv4 or IPv6)
 } tsTxdRxd;
 
@@ -96,16 +104,19 @@ typedef struct TAG_sReqRespInst
 	INT64 JobIDEx;		// unique job identifier as was generated when job was accepted for submission
 	UINT32 SubmitAt;	// when job was accepted for submission
 	UINT32 CpltdAt;		// when job was returned as completed
+	UINT32 SubmitSeq;	// jobs were accepted for submission in this order, jobs on the same class instance are sent to the service provider in this order
 	UINT16 ReqID;		// instance specific identifier
 	UINT16 FlgReq:1;	// this job instance has been initialised and is ready to be sent for processing
 	UINT16 FlgProc:1;   // this job instance is currently being processed by service provider
 	UINT16 FlgCpltd:1;  // service provider has completed processing and returned results are available
+	UINT16 FlgShm:1;	// parameters+input data, or if FlgCpltd the response data, are in this instances shared memory payload slot instead of Data
 	UINT32 JobRslt;			// service provider completion result
 	UINT64 ClassInstanceID;	// class instance referenced
 	UINT32 ClassMethodID;	// identifies class method
 	UINT32 ParamSize;		// instance specific parameter size
 	UINT32 InDataSize;		// instance specific input data size
 	UINT32 OutDataSize;		// instance specific result data size
+	UINT64 EstCells;		// estimated DP cells required to process this job, 0 if not estimated
 	UINT8 Data[1];		// when service requested then parameters followed by input data, if service response then response result data
 } tsReqRespInst;
 
@@ -117,6 +128,7 @@ typedef struct TAG_sBKSRegSessionEx
 	UINT32 LastChkdReqIdx;				// start checking for service requests to send from this instance index
 	UINT32 NumClassInstances;			// number of class instance identifiers currently in ClassInstanceIDs
 	UINT64 ClassInstanceIDs[cMaxClassInsts];	// holds all instantiated class instance identifiers for this session
+	UINT64 PendingCells;				// total estimated DP cells of jobs submitted to this session and yet to be completed by the service provider
 	UINT32 AllocdReqResp;				// allocation size for pReqResp
 	UINT8 *pReqResp;					// allocation for NumInstances of requests and associated responses
 	tsTxdRxd TxdRxd;					// holding low level send/receive buffers + connected socket
@@ -177,6 +189,7 @@ class CBKSRequester
 {
 	char m_szHostName[cMaxHostNameLen+1];				// host on which to listen for connections
 	char m_szServiceName[cMaxServiceNameLen+1];			// listening on this port
+	bool m_bLocalListener;								// true if listening on a Unix domain socket (m_szHostName is the socket path) for co-located service providers
 
 	tsRequesterThread m_RequesterThread;				// requester thread parameters
 
@@ -210,6 +223,7 @@ class CBKSRequester
 #endif
 
 	bool m_bNotifiedReqs;								// set TRUE if control message has been sent to control socket 2
+	UINT32 m_NxtSubmitSeq;								// next job accepted for submission will be assigned this submission sequence number
 
 	bool m_bSessionTermReq;								// true whilst a Session  is being deleted
 
@@ -292,6 +306,9 @@ class CBKSRequester
 	bool InitialiseCtrlSocks(void); // initialise the control sockets in m_Ctrl[]
 	int	AcceptConnections(void);	 // start accepting connections
 	int	SendRequestFrames(void);			// iterate all sessions and if any frames ready to send and room to accept the frame in TxdBuff then initiate the sending
+	bool PriorClassReqPending(tsBKSRegSessionEx *pSession,	// session containing job request
+							  tsBKSType *pType,				// job request is for this service type
+							  tsReqRespInst *pReqRespInst);	// returns true if there is an earlier submitted job request on the same class instance still to be sent
 	int  // 0: accepted frame, -1: JobIDEx errors, -2 Session or type errors, -3 mismatch between instance JobIDEx's, ClassInstanceID mismatch
 			ProcessResponseFrame(tsBKSRegSessionEx *pSession);			// process a received response frame on this session
 	bool RxData(tsTxdRxd *pRxd);
@@ -336,6 +353,15 @@ class CBKSRequester
 
 	bool ShutdownConnection(socket_t *pSocket);
 
+	bool AttachShmPayloads(tsTxdRxd *pTxdRxd);		// local sessions only: map the shared memory payload segment created by the service provider
+	void DetachShmPayloads(tsTxdRxd *pTxdRxd);		// unmap any shared memory payload segment
+
+	void RxdKeepalive(tsTxdRxd *pRxd);				// note any load report in received keepalive frame and slough the frame
+
+	double											// estimated throughput in DP cells/sec, or if no provider has yet reported then relative to number of service instances
+		EstSessionRate(tsBKSType *pType,			// session is providing this service type
+						tsBKSRegSessionEx *pSession);	// estimate for this session
+
 	int			// returns 0 if no sockets to be monitored with select(), on windows the total number of monitored sockets, on linux the highest socket file descriptor plus 1
 		SetupFDSets(fd_set& ReadFDs,			// select() read available socket descriptor set  
 					fd_set& WriteFDs,			// select() write accepted socket descriptor set
@@ -437,7 +463,13 @@ public:
 									 void *pParams = NULL,		// service processing parameters
 									 UINT32 InDataSize = 0,		// service processing input data is this total size in bytes
 									 void *pInData = NULL,		// service processing input data
-									 UINT32 SessionID = 0);     // if 0 then use session as specified by ClassInstanceID, otherwise use session corresponding to specific session identifier
+									 UINT32 SessionID = 0,      // if 0 then use session as specified by ClassInstanceID, otherwise use session corresponding to specific session identifier
+									 UINT64 EstCells = 0);		// estimated DP cells required to process this job, used for balancing load over sessions
+
+	UINT32			// 0 if class instance best remaining on current session, otherwise identifier of session to which the class instance should be migrated
+		PreferredSession(teBKSPType TypeID,				// service type
+						 UINT64 ClassInstanceID,		// class instance currently on this session
+						 UINT64 EstCells);				// next jobs on class instance are estimated to require this many DP cells
 
 	int				// < 0 if job no longer exists, 0 if job still being processed, > 0 if job completed
 		GetJobResponse(tJobIDEx	JobID,			// unique job identifier returned when job was submitted
@@ -448,6 +480,9 @@ public:
 						void *pOutData,			// service processing output results data
 						bool bRetain=false);		// true if job response is to be retained and not deleted; subsequent call with bRetain==false will delete this response
 
+	int				// < 0 if job no longer exists, 0 if job already completed, 1 if job pending DP cells were removed from its session
+		AbandonJobRequest(tJobIDEx JobID);		// requester is no longer waiting on this job, e.g. timed out, so it no longer contributes to session load
+
 
 };
 
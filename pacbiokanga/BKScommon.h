@@ -94,9 +94,27 @@ typedef struct TAG_sBKSPacHdr {
 	UINT32 SessionID;				// server assigned and is uniquely identifying this session between service requester and provider, will be in the range 1..131071
 	UINT8 TxFrameID;				// senders frame header identifier, monotonically incremented starting from 1 to 127 with wraparound back to 1
 	UINT8 RxFrameID;				// senders last received and processed frame header identifier from current session peer, 0 if yet to receive any
-	UINT8 FrameFlags;				// frame header flags, currently unused
+	UINT8 FrameFlags;				// frame header flags, combination of cBKSFrmFlg's
 	UINT8 FrameType;				// one of teBKSHdrType header types, specifies the payload type
 } tsBKSPacHdr;
+
+// frame header flags
+const UINT8 cBKSFrmFlgShmAttached = 0x01;		// set by service provider on all frames sent after it has created the shared memory payload segment for a local session
+const UINT8 cBKSFrmFlgShmPayload = 0x02;		// request parameters+data, or response data, are in a shared memory payload slot; frame payload is only the UINT32 slot index
+const UINT8 cBKSFrmFlgLoadRpt = 0x04;			// keepalive frame is a tsBKSKeepalive carrying the service providers current load report
+
+// local sessions, connected over a Unix domain socket, can exchange request and response payloads through a shared memory segment created by the service provider
+// segment starts with a tsBKSShmHdr followed, at cBKSShmHdrSize, by NumSlots payload slots each of SlotSize bytes; slots are indexed by the requester service instance (0..MaxInstances-1)
+const UINT32 cBKSShmMagic = 0x6d68534b;			// shared memory payload segment header signature
+const UINT32 cBKSShmHdrSize = 0x01000;			// payload slots start at this offset into the segment
+const UINT32 cBKSMinShmPayload = 0x0400;		// payloads smaller than this are always inline within frames
+
+typedef struct TAG_sBKSShmHdr {
+	UINT32 Magic;					// cBKSShmMagic
+	UINT32 SessionID;				// segment is for this session
+	UINT32 NumSlots;				// number of payload slots
+	UINT32 SlotSize;				// each payload slot can hold at most this many bytes
+} tsBKSShmHdr;
  
 
 typedef struct TAG_sServiceDetail {
@@ -168,4 +186,34 @@ typedef struct TAG_sBKSServResp
 	UINT8 Data[1];					// response data 
 } sBKSServResp;
 
+// keepalive (eBKSHdrKeepalive) sent by service provider, with cBKSFrmFlgLoadRpt set, reporting its measured throughput and current load so the requester can balance jobs across providers
+typedef struct TAG_sBKSKeepalive
+{
+	tsBKSPacHdr Hdr;				// frame header (eBKSHdrKeepalive)
+	UINT32 KCellsPerSec;			// rolling estimate of SW alignment throughput over all service instances, in 1000's of DP cells/sec; 0 if yet to be measured
+	UINT32 QueueDepth;				// number of accepted requests yet to be started by a service instance
+	UINT32 NumBusy;					// number of service instances currently processing requests
+} tsBKSKeepalive;
+
 #pragma pack()
+
+inline bool						// true if pszHost is a Unix domain socket path rather than a host name or IP address
+BKSIsLocalSockPath(const char *pszHost)
+{
+return(pszHost != NULL && pszHost[0] == '/');
+}
+
+#ifndef _WIN32
+
+inline void
+BKSShmPayloadsName(const char *pszSockPath,	// local session is over this Unix domain socket
+				   UINT32 SessionID,			// session identifier
+				   char *pszName,				// returned shared memory payload segment name
+				   int MaxNameLen)				// pszName can hold at most this many chars including terminating '\0'
+{
+UINT32 Hash = 2166136261u;
+while(*pszSockPath != '\0')
+	Hash = (Hash ^ (UINT8)*pszSockPath++) * 16777619u;
+snprintf(pszName,MaxNameLen,"/bkspl.%08x.%u",Hash,SessionID);
+}
+#endif
@@ -47,6 +47,7 @@ ProcPacBioECContigs(etPBPMode PMode,	// processing mode
 		char *pszContigFile,		// input multifasta contig file
 		char *pszHiConfFile,		// input hiconfidence file
 	    char *pszErrCorFile,		// name of file into which write error corrected contigs
+		char *pszChkPtsFile,        // name of file used for checkpointing in case resume processing is required
 		int NumThreads);			// maximum number of worker threads to use
 
 
@@ -89,6 +90,7 @@ char szContigFile[_MAX_PATH];			// input multifasta contig file
 char szHiConfFile[_MAX_PATH];			// input hiconfidence file
 
 char szOutFile[_MAX_PATH];				// where to write error corrected contg sequences
+char szChkPtsFile[_MAX_PATH+1];			// used for checkpointing error correction
 
 int NumberOfProcessors;		// number of installed CPUs
 int NumThreads;				// number of threads (0 defaults to number of CPUs)
@@ -422,6 +424,9 @@ if (!argerrors)
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: After removal of whitespace, no output file specified with '-o<filespec>' option)\n");
 		exit(1);
 		}
+	strncpy(szChkPtsFile,szOutFile,sizeof(szChkPtsFile)-5);
+	szChkPtsFile[sizeof(szChkPtsFile)-5] = '\0';
+	strcat(szChkPtsFile,".chk");
 	
 // show user current resource limits
 #ifndef _WIN32
@@ -467,6 +472,7 @@ if (!argerrors)
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Input assembled contig sequences file: '%s'",szContigFile);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Input high confidence sequences file: '%s'",szHiConfFile);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Output error corrected sequences file: '%s'",szOutFile);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Checkpoint error correction file: '%s'",szChkPtsFile);
 
 	if(szExperimentName[0] != '\0')
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"This processing reference: %s",szExperimentName);
@@ -507,7 +513,7 @@ if (!argerrors)
 #endif
 	gStopWatch.Start();
 	Rslt = ProcPacBioECContigs((etPBPMode)PMode,DeltaCoreOfs,MaxSeedCoreDepth,MinSeedCoreLen,MinNumSeedCores,SWMatchScore,-1 * SWMismatchPenalty,-1 * SWGapOpenPenalty,-1 * SWGapExtnPenalty,SWProgExtnPenaltyLen,
-								MaxArtefactDev,MinContigLen,MinHCSeqLen,szContigFile,szHiConfFile,szOutFile,NumThreads);
+								MaxArtefactDev,MinContigLen,MinHCSeqLen,szContigFile,szHiConfFile,szOutFile,szChkPtsFile,NumThreads);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -548,6 +554,7 @@ ProcPacBioECContigs(etPBPMode PMode,	// processing mode
 		char *pszContigFile,			// input multifasta contig file
 		char *pszHiConfFile,			// input hiconfidence file
 	    char *pszErrCorFile,		// name of file into which write error corrected contigs
+		char *pszChkPtsFile,        // name of file used for checkpointing in case resume processing is required
 		int NumThreads)			// maximum number of worker threads to use
 {
 int Rslt;
@@ -560,7 +567,7 @@ if((pPBContigs = new CPBECContigs)==NULL)
 	}
 
 Rslt = pPBContigs->Process(PMode,DeltaCoreOfs,MaxSeedCoreDepth,MinSeedCoreLen,MinNumSeedCores,SWMatchScore,SWMismatchPenalty,SWGapOpenPenalty,SWGapExtnPenalty,SWProgExtnPenaltyLen,
-								MaxArtefactDev,MinContigLen,MinHCSeqLen,pszContigFile,pszHiConfFile,pszErrCorFile,NumThreads);
+								MaxArtefactDev,MinContigLen,MinHCSeqLen,pszContigFile,pszHiConfFile,pszErrCorFile,pszChkPtsFile,NumThreads);
 delete pPBContigs;
 return(Rslt);
 }
@@ -574,6 +581,7 @@ m_pMapEntryID2NodeIDs = NULL;
 m_pMAConsensus = NULL;
 m_bMutexesCreated = false;
 m_hErrCorFile = -1;
+m_hChkPtsFile = -1;
 Init();
 }
 
@@ -627,6 +635,17 @@ if(m_hErrCorFile != -1)
 	m_hErrCorFile = -1;
 	}
 
+if(m_hChkPtsFile != -1)
+	{
+#ifdef _WIN32
+	_commit(m_hChkPtsFile);
+#else
+	fsync(m_hChkPtsFile);
+#endif
+	close(m_hChkPtsFile);
+	m_hChkPtsFile = -1;
+	}
+
 m_NumPBScaffNodes = 0;
 m_AllocdPBScaffNodes = 0;
 m_NumHiConfSeqs = 0;
@@ -658,6 +677,8 @@ m_MaxArtefactDev = cDfltScaffMaxArtefactDev;
 
 memset(m_szContigFile,0,sizeof(m_szContigFile));
 memset(m_szHiConfFile,0,sizeof(m_szHiConfFile));
+m_szErrCorFile[0] = '\0';
+m_szChkPtsFile[0] = '\0';
 
 m_NumThreads = 0;
 if(m_bMutexesCreated)
@@ -1107,6 +1128,7 @@ CPBECContigs::Process(etPBPMode PMode,	// processing mode
 		char *pszContigFile,		// input multifasta contig file
 		char *pszHiConfFile,		// input hiconfidence file
 	    char *pszErrCorFile,		// name of file into which write error corrected contigs
+		char *pszChkPtsFile,        // name of file used for checkpointing in case resume processing is required
 		int NumThreads)				// maximum number of worker threads to use
 {
 int Rslt = eBSFSuccess;
@@ -1145,6 +1167,13 @@ strncpy(m_szHiConfFile,pszHiConfFile,sizeof(m_szHiConfFile));
 m_szHiConfFile[sizeof(m_szHiConfFile)-1] = '\0';
 strncpy(m_szErrCorFile,pszErrCorFile,sizeof(m_szErrCorFile));
 m_szErrCorFile[sizeof(m_szErrCorFile)-1] = '\0';
+if(pszChkPtsFile != NULL && pszChkPtsFile[0] != '\0')
+	{
+	strncpy(m_szChkPtsFile,pszChkPtsFile,sizeof(m_szChkPtsFile));
+	m_szChkPtsFile[sizeof(m_szChkPtsFile)-1] = '\0';
+	}
+else
+	m_szChkPtsFile[0] = '\0';
 
 INT64 SumContigsSizes;
 
@@ -1370,6 +1399,16 @@ for(CurNodeID = 1; CurNodeID <= NumTargSeqs; CurNodeID++,pCurPBScaffNode++)
 	m_pMapEntryID2NodeIDs[pCurPBScaffNode->EntryID-1] = CurNodeID;
 	}
 
+// if an existing checkpoint file then the already completed high confidence sequence alignments are replayed and error correction resumes
+// with the remaining sequences, checkpoint file is otherwise created/truncated
+if((Rslt = InitChkPts(TotTargSeqLen)) != 0)
+	{
+	if(Rslt > 0)				// previously completed?
+		Rslt = eBSFSuccess;
+	Reset(false);
+	return(Rslt);
+	}
+
 if(m_szErrCorFile[0] != '\0')
 	{
 #ifdef _WIN32
@@ -1453,6 +1492,8 @@ if(m_hErrCorFile != -1)
 
 	if(m_hErrCorFile != -1)
 		{
+		INT64 ECFileLen;
+		ECFileLen = (INT64)_lseeki64(m_hErrCorFile,0,SEEK_END);
 #ifdef _WIN32
 		_commit(m_hErrCorFile);
 #else
@@ -1460,6 +1501,16 @@ if(m_hErrCorFile != -1)
 #endif
 		close(m_hErrCorFile);
 		m_hErrCorFile = -1;
+
+		// checkpoint that error corrected contigs file has been completed so a subsequent restart has nothing to do
+		if(m_hChkPtsFile != -1 && ECFileLen >= 0 && Rslt >= eBSFSuccess)
+			{
+			tsECCChkPt CpltdChkPt;
+			memset(&CpltdChkPt,0,sizeof(CpltdChkPt));
+			CpltdChkPt.ChkPtLen = sizeof(tsECCChkPt);
+			CpltdChkPt.ECFileOfs = ECFileLen;
+			WriteChkPt(&CpltdChkPt);
+			}
 		}
 	}
 
@@ -1468,6 +1519,324 @@ Reset(false);
 return(Rslt);
 }
 
+int										// < 0 if errors, 0 if error correction to be (re)started or resumed, 1 if already completed
+CPBECContigs::InitChkPts(UINT64 TotContigsLen)	// open and validate any existing checkpoint file, replaying checkpointed alignments, else create new checkpoint file
+{
+tsECCChkPtHdr ChkPtHdr;
+tsECCChkPtHdr ExistChkPtHdr;
+tsECCChkPt CurChkPt;
+tsECCChkPtAlign *pAlign;
+tsPBECCScaffNode *pTargNode;
+UINT8 *pAligns;
+UINT32 AllocdAligns;
+UINT32 AlignsLen;
+UINT32 AlignOfs;
+UINT32 AlignIdx;
+etSeqBase *pProbeSeq;
+UINT32 HiConfSeqID;
+UINT32 NumChkPtsAccepted;
+INT64 ChkPtFileOfs;
+INT64 ChkPtFileSize;
+INT64 ECFileSize;
+int ChkPtsStatRslt;
+int ECStatRslt;
+bool bCpltd;
+bool bRevCpl;
+
+m_hChkPtsFile = -1;
+if(m_szChkPtsFile[0] == '\0')
+	return(0);
+
+// checkpoints are only valid if generated from the same contigs and high confidence sequences
+memset(&ChkPtHdr,0,sizeof(ChkPtHdr));
+ChkPtHdr.NumContigs = m_NumPBScaffNodes;
+ChkPtHdr.TotContigsLen = TotContigsLen;
+ChkPtHdr.NumHiConfSeqs = m_NumHiConfSeqs;
+for(HiConfSeqID = 1; HiConfSeqID <= m_NumHiConfSeqs; HiConfSeqID++)
+	ChkPtHdr.TotHiConfSeqsLen += m_pSeqStore->GetLen(HiConfSeqID);
+
+ChkPtFileSize = 0;
+ECFileSize = -1;
+#ifdef _WIN32
+struct _stat64 ChkPtsStat;
+ChkPtsStatRslt = _stat64(m_szChkPtsFile, &ChkPtsStat);
+struct _stat64 ECStat;
+ECStatRslt = _stat64(m_szErrCorFile, &ECStat);
+#else
+struct stat64 ChkPtsStat;
+ChkPtsStatRslt = stat64(m_szChkPtsFile, &ChkPtsStat);
+struct stat64 ECStat;
+ECStatRslt = stat64(m_szErrCorFile, &ECStat);
+#endif
+if(ChkPtsStatRslt >= 0)
+	{
+	if(!(ChkPtsStat.st_mode & S_IFREG))
+		{
+		ChkPtsStatRslt = -1;
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Checkpoint exists but not a regular file, restart error correction and checkpointing from 1st sequence");
+		}
+	else
+		{
+		ChkPtFileSize = (INT64)ChkPtsStat.st_size;
+		if(ChkPtFileSize < (INT64)(sizeof(tsECCChkPtHdr) + sizeof(tsECCChkPt)))	// nothing was checkpointed
+			ChkPtsStatRslt = -1;
+		}
+	}
+if(ECStatRslt >= 0 && (ECStat.st_mode & S_IFREG))
+	ECFileSize = (INT64)ECStat.st_size;
+
+if(ChkPtsStatRslt >= 0)
+	{
+#ifdef _WIN32
+	m_hChkPtsFile = open(m_szChkPtsFile, _O_BINARY | _O_RDWR | _O_SEQUENTIAL, _S_IREAD | _S_IWRITE);
+#else
+	m_hChkPtsFile = open64(m_szChkPtsFile,O_RDWR,S_IREAD | S_IWRITE);
+#endif
+	if(m_hChkPtsFile < 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to open existing checkpoint file '%s'",m_szChkPtsFile);
+		m_hChkPtsFile = -1;
+		return(eBSFerrOpnFile);
+		}
+	if(read(m_hChkPtsFile,&ExistChkPtHdr,sizeof(tsECCChkPtHdr)) != sizeof(tsECCChkPtHdr) || memcmp(&ExistChkPtHdr,&ChkPtHdr,sizeof(tsECCChkPtHdr)))
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Checkpoint file was not generated from the current contigs and high confidence sequences, restart error correction and checkpointing from 1st sequence");
+		close(m_hChkPtsFile);
+		m_hChkPtsFile = -1;
+		ChkPtsStatRslt = -1;
+		}
+	}
+
+if(ChkPtsStatRslt >= 0)
+	{
+	AllocdAligns = cChkPtBuffAlloc;
+	pAligns = new UINT8 [AllocdAligns];
+	pProbeSeq = new etSeqBase [m_MaxHiConfSeqLen + 10];
+	if(pAligns == NULL || pProbeSeq == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to allocate memory for checkpoint processing");
+		if(pAligns != NULL)
+			delete pAligns;
+		if(pProbeSeq != NULL)
+			delete pProbeSeq;
+		return(eBSFerrMem);
+		}
+
+	// iterate over all checkpoint entries, replaying the contained alignments for each checkpointed sequence
+	// stop iterating at the first partially written or inconsistent entry, entries from that entry onwards are truncated and will be recomputed
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Checkpoint file contains %lld bytes, now processing and validating checkpointed entries",ChkPtFileSize);
+	ChkPtFileOfs = sizeof(tsECCChkPtHdr);
+	NumChkPtsAccepted = 0;
+	bCpltd = false;
+	while(read(m_hChkPtsFile,&CurChkPt,sizeof(tsECCChkPt)) == sizeof(tsECCChkPt))
+		{
+		if(CurChkPt.HiConfSeqID == 0)		// error corrected contigs file was completed, accept only if that file is still of the checkpointed length
+			{
+			if(CurChkPt.ChkPtLen == sizeof(tsECCChkPt) && CurChkPt.ECFileOfs > 0 && CurChkPt.ECFileOfs == ECFileSize && NumChkPtsAccepted == m_NumHiConfSeqs)
+				bCpltd = true;
+			break;
+			}
+
+		if(CurChkPt.HiConfSeqID > m_NumHiConfSeqs ||
+			CurChkPt.HiConfSeqLen != m_pSeqStore->GetLen(CurChkPt.HiConfSeqID) ||
+			(m_pSeqStore->GetFlags(CurChkPt.HiConfSeqID) & cflgAlgnd) ||
+			(UINT64)CurChkPt.ChkPtLen < (UINT64)sizeof(tsECCChkPt) + ((UINT64)CurChkPt.NumAligns * sizeof(tsECCChkPtAlign)) ||
+			ChkPtFileOfs + CurChkPt.ChkPtLen > ChkPtFileSize)
+			break;
+
+		AlignsLen = CurChkPt.ChkPtLen - sizeof(tsECCChkPt);
+		if(AlignsLen > AllocdAligns)
+			{
+			delete pAligns;
+			AllocdAligns = AlignsLen + cChkPtBuffAlloc;
+			if((pAligns = new UINT8 [AllocdAligns]) == NULL)
+				{
+				gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to allocate memory for checkpoint processing");
+				delete pProbeSeq;
+				return(eBSFerrMem);
+				}
+			}
+		if(AlignsLen > 0 && read(m_hChkPtsFile,pAligns,AlignsLen) != (int)AlignsLen)
+			break;
+
+		// all alignments must be consistent with current contigs before any are replayed
+		AlignOfs = 0;
+		for(AlignIdx = 0; AlignIdx < CurChkPt.NumAligns; AlignIdx++)
+			{
+			if(AlignOfs + sizeof(tsECCChkPtAlign) > AlignsLen)
+				break;
+			pAlign = (tsECCChkPtAlign *)&pAligns[AlignOfs];
+			if(MapEntryID2NodeID(pAlign->TargEntryID) == 0)
+				break;
+			pTargNode = &m_pPBScaffNodes[MapEntryID2NodeID(pAlign->TargEntryID) - 1];
+			if(pTargNode->SeqLen != pAlign->TargSeqLen ||
+				pAlign->RefStartOfs > pAlign->RefEndOfs || pAlign->RefEndOfs > pAlign->TargSeqLen ||
+				pAlign->ProbeStartOfs > pAlign->ProbeEndOfs || pAlign->ProbeEndOfs > CurChkPt.HiConfSeqLen)
+				break;
+			AlignOfs += sizeof(tsECCChkPtAlign) + pAlign->NumAlignOps;
+			}
+		if(AlignIdx != CurChkPt.NumAligns || AlignOfs != AlignsLen)
+			break;
+
+		if(CurChkPt.NumAligns)
+			{
+			m_pSeqStore->GetSeq(CurChkPt.HiConfSeqID,0,CurChkPt.HiConfSeqLen,pProbeSeq);
+			pProbeSeq[CurChkPt.HiConfSeqLen] = eBaseEOS;
+			bRevCpl = false;
+			AlignOfs = 0;
+			for(AlignIdx = 0; AlignIdx < CurChkPt.NumAligns; AlignIdx++)
+				{
+				pAlign = (tsECCChkPtAlign *)&pAligns[AlignOfs];
+				if((pAlign->flgRevCpl ? true : false) != bRevCpl)
+					{
+					CSeqTrans::ReverseComplement(CurChkPt.HiConfSeqLen,pProbeSeq);
+					bRevCpl = !bRevCpl;
+					}
+				pTargNode = &m_pPBScaffNodes[MapEntryID2NodeID(pAlign->TargEntryID) - 1];
+				pTargNode->flgContains = 1;
+				m_pMAConsensus->AddMultiAlignment(pTargNode->RefSeqID,pAlign->RefStartOfs,pAlign->RefEndOfs,pAlign->ProbeStartOfs,pAlign->ProbeEndOfs,
+														pProbeSeq,pAlign->NumAlignOps,(tMAOp *)&pAligns[AlignOfs + sizeof(tsECCChkPtAlign)]);
+				AlignOfs += sizeof(tsECCChkPtAlign) + pAlign->NumAlignOps;
+				}
+			}
+
+		m_pSeqStore->SetFlags(CurChkPt.HiConfSeqID,cflgAlgnd);
+		if(CurChkPt.ProvOverlapping > 0)
+			m_ProvOverlapping += 1;
+		m_ProvContained += CurChkPt.ProvContained;
+		m_ProvArtefact += CurChkPt.ProvArtefact;
+		m_ProvSWchecked += CurChkPt.ProvSWchecked;
+		m_NumOverlapProcessed += 1;
+		NumChkPtsAccepted += 1;
+		ChkPtFileOfs += CurChkPt.ChkPtLen;
+		}
+	delete pAligns;
+	delete pProbeSeq;
+
+	if(bCpltd)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Completed checkpoint file processing, nothing to do; already completed error correction of %u contigs using %u high confidence sequences",m_NumPBScaffNodes,NumChkPtsAccepted);
+		close(m_hChkPtsFile);
+		m_hChkPtsFile = -1;
+		return(1);
+		}
+
+	// any entries following those accepted are truncated, including any completion entry, with new entries appended
+#ifdef _WIN32
+	if(_chsize_s(m_hChkPtsFile,ChkPtFileOfs) != 0 || _lseeki64(m_hChkPtsFile,ChkPtFileOfs,SEEK_SET) != ChkPtFileOfs)
+#else
+	if(ftruncate(m_hChkPtsFile,(off_t)ChkPtFileOfs) != 0 || _lseeki64(m_hChkPtsFile,(off_t)ChkPtFileOfs,SEEK_SET) != ChkPtFileOfs)
+#endif
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to truncate %s - %s",m_szChkPtsFile,strerror(errno));
+		return(eBSFerrFileAccess);
+		}
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"Completed checkpoint file processing, resuming error correction with %u of %u high confidence sequences already aligned",NumChkPtsAccepted,m_NumHiConfSeqs);
+	return(0);
+	}
+
+#ifdef _WIN32
+m_hChkPtsFile = open(m_szChkPtsFile,( O_WRONLY | _O_BINARY | _O_SEQUENTIAL | _O_CREAT | _O_TRUNC),(_S_IREAD | _S_IWRITE));
+#else
+if((m_hChkPtsFile = open(m_szChkPtsFile,O_WRONLY | O_CREAT,S_IREAD | S_IWRITE))!=-1)
+	if(ftruncate(m_hChkPtsFile,0)!=0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to truncate %s - %s",m_szChkPtsFile,strerror(errno));
+		return(eBSFerrCreateFile);
+		}
+#endif
+if(m_hChkPtsFile < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to create/truncate checkpoints file '%s'",m_szChkPtsFile);
+	m_hChkPtsFile = -1;
+	return(eBSFerrCreateFile);
+	}
+if(!CUtility::SafeWrite(m_hChkPtsFile,&ChkPtHdr,sizeof(tsECCChkPtHdr)))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to write checkpoints file '%s'",m_szChkPtsFile);
+	return(eBSFerrWrite);
+	}
+#ifdef _WIN32
+_commit(m_hChkPtsFile);
+#else
+fsync(m_hChkPtsFile);
+#endif
+return(0);
+}
+
+int
+CPBECContigs::AddChkPtAlign(UINT32 TargEntryID,		// contained alignment was onto this contig
+				UINT32 TargSeqLen,				// contig length
+				UINT32 RefStartOfs,				// alignment starts at this contig offset
+				UINT32 RefEndOfs,				// alignment ends at this contig offset inclusive
+				UINT32 ProbeStartOfs,			// alignment starts at this high confidence sequence offset
+				UINT32 ProbeEndOfs,				// alignment ends at this high confidence sequence offset inclusive
+				bool bRevCpl,					// true if high confidence sequence was revcpl'd
+				UINT32 NumAlignOps,				// number of alignment operators
+				tMAOp *pAlignOps,				// alignment operators
+				tsThreadPBECContigs *pPars)		// thread specific
+{
+UINT32 ReqBuffLen;
+UINT8 *pTmp;
+tsECCChkPtAlign *pAlign;
+
+if(pPars->pChkPtBuff == NULL)
+	return(eBSFerrInternal);
+
+ReqBuffLen = pPars->ChkPtBuffLen + sizeof(tsECCChkPtAlign) + NumAlignOps;
+if(ReqBuffLen > pPars->AllocdChkPtBuff)
+	{
+	if((pTmp = new UINT8 [ReqBuffLen + cChkPtBuffAlloc]) == NULL)
+		return(eBSFerrMem);
+	memcpy(pTmp,pPars->pChkPtBuff,pPars->ChkPtBuffLen);
+	delete pPars->pChkPtBuff;
+	pPars->pChkPtBuff = pTmp;
+	pPars->AllocdChkPtBuff = ReqBuffLen + cChkPtBuffAlloc;
+	}
+pAlign = (tsECCChkPtAlign *)&pPars->pChkPtBuff[pPars->ChkPtBuffLen];
+memset(pAlign,0,sizeof(tsECCChkPtAlign));
+pAlign->TargEntryID = TargEntryID;
+pAlign->TargSeqLen = TargSeqLen;
+pAlign->RefStartOfs = RefStartOfs;
+pAlign->RefEndOfs = RefEndOfs;
+pAlign->ProbeStartOfs = ProbeStartOfs;
+pAlign->ProbeEndOfs = ProbeEndOfs;
+pAlign->NumAlignOps = NumAlignOps;
+pAlign->flgRevCpl = bRevCpl ? 1 : 0;
+if(NumAlignOps)
+	memcpy(&pAlign[1],pAlignOps,NumAlignOps);
+pPars->ChkPtBuffLen = ReqBuffLen;
+((tsECCChkPt *)pPars->pChkPtBuff)->NumAligns += 1;
+return(eBSFSuccess);
+}
+
+int
+CPBECContigs::WriteChkPt(tsECCChkPt *pChkPt)		// append and fsync checkpoint record, ChkPtLen is the total record length including any immediately following alignments
+{
+int Rslt;
+if(m_hChkPtsFile == -1)
+	return(eBSFSuccess);
+AcquireCASSerialise();
+if(!CUtility::SafeWrite(m_hChkPtsFile,pChkPt,pChkPt->ChkPtLen))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"WriteChkPt: unable to write checkpoints file '%s', checkpointing has been discontinued",m_szChkPtsFile);
+	close(m_hChkPtsFile);
+	m_hChkPtsFile = -1;
+	Rslt = eBSFerrWrite;
+	}
+else
+	{
+#ifdef _WIN32
+	_commit(m_hChkPtsFile);
+#else
+	fsync(m_hChkPtsFile);
+#endif
+	Rslt = eBSFSuccess;
+	}
+ReleaseCASSerialise();
+return(Rslt);
+}
+
 #ifdef _WIN32
 unsigned __stdcall PBECContigsThread(void * pThreadPars)
 #else
@@ -1532,6 +1901,16 @@ for(ThreadIdx = 0; ThreadIdx < NumECThreads; ThreadIdx++,pThreadPar++)
 		break;
 		}
 
+	if(m_hChkPtsFile != -1)
+		{
+		pThreadPar->AllocdChkPtBuff = cChkPtBuffAlloc;
+		if((pThreadPar->pChkPtBuff = new UINT8 [pThreadPar->AllocdChkPtBuff])==NULL)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"IdentifySequenceOverlaps: Checkpoint buffer memory allocation of %u bytes - %s",pThreadPar->AllocdChkPtBuff,strerror(errno));
+			break;
+			}
+		}
+
 	if((pThreadPar->pmtqsort = new CMTqsort) == NULL)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"IdentifySequenceOverlaps: Core hits instantiation of CMTqsort failed");
@@ -1564,6 +1943,8 @@ if(ThreadIdx != NumECThreads)	// any errors whilst allocating memory for core hi
 			}
 		if(pThreadPar->pProbeSeq != NULL)
 			delete pThreadPar->pProbeSeq;
+		if(pThreadPar->pChkPtBuff != NULL)
+			delete pThreadPar->pChkPtBuff;
 		if(pThreadPar->pSW != NULL)
 			delete pThreadPar->pSW;
 		pThreadPar -= 1;
@@ -1641,6 +2022,8 @@ for(ThreadIdx = 0; ThreadIdx < NumECThreads; ThreadIdx++,pThreadPar++)
 		delete pThreadPar->pProbeSeq;
 	if(pThreadPar->pTargSeq != NULL)
 		delete pThreadPar->pTargSeq;
+	if(pThreadPar->pChkPtBuff != NULL)
+		delete pThreadPar->pChkPtBuff;
 	}
 
 delete pThreadPutOvlps;
@@ -1718,6 +2101,11 @@ for(HiConfSeqID = 1; HiConfSeqID <= m_NumHiConfSeqs; HiConfSeqID++)
 	m_pSeqStore->SetFlags(HiConfSeqID,cflgAlgnd);
 	ReleaseCASLock();
 	HiConfSeqLen = m_pSeqStore->GetLen(HiConfSeqID);
+	if(pThreadPar->pChkPtBuff != NULL)		// contained alignments will be appended to the checkpoint record for this sequence
+		{
+		memset(pThreadPar->pChkPtBuff,0,sizeof(tsECCChkPt));
+		pThreadPar->ChkPtBuffLen = sizeof(tsECCChkPt);
+		}
 
 	pThreadPar->bRevCpl = false;
 	IdentifyCoreHits(HiConfSeqID,pThreadPar->MinPBSeqLen,0,pThreadPar);
@@ -2143,6 +2531,11 @@ for(HiConfSeqID = 1; HiConfSeqID <= m_NumHiConfSeqs; HiConfSeqID++)
 															PeakMatchesCell.PFirstAnchorStartOfs,PeakMatchesCell.PLastAnchorEndOfs,
 															pThreadPar->pProbeSeq,NumAlignOps,pAlignOps);	
 					ReleaseCASLock();								
+					if(pThreadPar->pChkPtBuff != NULL)
+						AddChkPtAlign(pTargNode->EntryID,TargSeqLen,
+									PeakMatchesCell.TFirstAnchorStartOfs,PeakMatchesCell.TLastAnchorEndOfs,
+									PeakMatchesCell.PFirstAnchorStartOfs,PeakMatchesCell.PLastAnchorEndOfs,
+									!bProbeSense,NumAlignOps,pAlignOps,pThreadPar);
 					NumInMultiAlignment += 1;
 					}
 
@@ -2167,6 +2560,19 @@ for(HiConfSeqID = 1; HiConfSeqID <= m_NumHiConfSeqs; HiConfSeqID++)
 		m_ProvSWchecked += ProvSWchecked;
 	m_NumOverlapProcessed += 1;
 	ReleaseCASSerialise();
+	if(pThreadPar->pChkPtBuff != NULL)
+		{
+		tsECCChkPt *pChkPt = (tsECCChkPt *)pThreadPar->pChkPtBuff;
+		pChkPt->ChkPtLen = pThreadPar->ChkPtBuffLen;
+		pChkPt->HiConfSeqID = HiConfSeqID;
+		pChkPt->HiConfSeqLen = HiConfSeqLen;
+		pChkPt->ProvOverlapping = ProvOverlapping;
+		pChkPt->ProvContained = ProvContained;
+		pChkPt->ProvArtefact = ProvArtefact;
+		pChkPt->ProvSWchecked = ProvSWchecked;
+		pChkPt->ECFileOfs = 0;
+		WriteChkPt(pChkPt);
+		}
 	ProvOverlapping = 0;
 	ProvOverlapped = 0;
 	ProvContained = 0;
@@ -26,6 +26,8 @@ const int cDfltScaffMaxArtefactDev = 10;		// but when scaffolding with error cor
 const int cMaxMaxArtefactDev = 25;			// user can specify up to this maximum 
 
 
+const int cChkPtBuffAlloc = 0x040000;		// per thread checkpoint record buffering is allocated (and if required, realloc'd) in this sized chunks
+
 const int cMaxPacBioErrCorLen = 250000;		// allowing for error corrected read sequences of up to this length
 const int cMaxPacBioMAFLen = (cMaxPacBioErrCorLen * 100);	// allowing for multialignment format buffering of up to this length
 
@@ -38,6 +40,38 @@ typedef enum TAG_ePBPMode {								// processing mode
 
 #pragma pack(1)
 
+// checkpoint file starts with this header which must match the currently loaded contigs and high confidence sequences if resuming
+typedef struct TAG_sECCChkPtHdr {
+	UINT32 NumContigs;				// number of contigs being error corrected
+	UINT64 TotContigsLen;			// total length of all contigs
+	UINT32 NumHiConfSeqs;			// number of high confidence sequences used for error correction
+	UINT64 TotHiConfSeqsLen;		// total length of all high confidence sequences
+	} tsECCChkPtHdr;
+
+// each high confidence sequence, when processing completed, is checkpointed with this record followed by NumAligns contained alignments
+typedef struct TAG_sECCChkPt {
+	UINT32 ChkPtLen;				// total length of this checkpoint record including all following alignments and their alignment operators
+	UINT32 HiConfSeqID;				// processing completed for this high confidence sequence, 0 if the record marks completion of the error corrected contigs file
+	UINT32 HiConfSeqLen;			// high confidence sequence length
+	UINT32 NumAligns;				// number of contained alignments, each as a tsECCChkPtAlign, following this record
+	UINT32 ProvOverlapping;			// number of contigs overlapped
+	UINT32 ProvContained;			// number of contigs containing high confidence sequence
+	UINT32 ProvArtefact;			// number of overlaps classified as artefactual
+	UINT32 ProvSWchecked;			// number of SW alignments
+	INT64  ECFileOfs;				// if HiConfSeqID is 0 then length of the error corrected contigs file when it was completed
+	} tsECCChkPt;
+
+typedef struct TAG_sECCChkPtAlign {
+	UINT32 TargEntryID;				// alignment was onto this contig suffix array entry
+	UINT32 TargSeqLen;				// contig length
+	UINT32 RefStartOfs;				// alignment starts at this contig offset
+	UINT32 RefEndOfs;				// alignment ends at this contig offset inclusive
+	UINT32 ProbeStartOfs;			// alignment starts at this high confidence sequence offset
+	UINT32 ProbeEndOfs;				// alignment ends at this high confidence sequence offset inclusive
+	UINT32 NumAlignOps;				// number of alignment operators (tMAOp) immediately following this alignment
+	UINT8 flgRevCpl:1;				// 1 if high confidence sequence was revcpl'd before aligning
+	} tsECCChkPtAlign;
+
 typedef struct TAG_sPBECCKMerOfs {					// no KMer in antisense strand if both MinOfs and MaxOfs are 0
 	UINT32 MinOfs;										// at least one antisense KMer is located between this minimum and
 	UINT32 MaxOfs;                                      // and this maximum offset (sub 1) in the antisense sequence
@@ -122,6 +156,10 @@ typedef struct TAG_sThreadPBECContigs {
 	UINT32 AllocdTargSeqSize;		// current allocation size for buffered target sequence in pTargSeq 	
 	etSeqBase *pTargSeq;			// allocated to hold the current target sequence
 
+	UINT32 ChkPtBuffLen;			// current checkpoint record length in pChkPtBuff
+	UINT32 AllocdChkPtBuff;			// pChkPtBuff allocated to hold at most this many bytes
+	UINT8 *pChkPtBuff;				// if checkpointing then allocated to buffer the checkpoint record for the current high confidence sequence
+
 	UINT32 AlignErrMem;				// number of times alignments failed because of memory allocation errors
 	UINT32 AlignExcessLen;			// number of times alignments failed because length of probe * target was excessive
 } tsThreadPBECContigs;
@@ -171,6 +209,9 @@ class CPBECContigs
 	char m_szErrCorFile[_MAX_PATH];			// name of file into which write error corrected and scored sequences
 	int m_hErrCorFile;						// file handle for writing error corrected and scored sequences
 
+	char m_szChkPtsFile[_MAX_PATH];			// name of file used for checkpointing in case resume processing is required
+	int m_hChkPtsFile;						// file handle for checkpointing
+
 	int ErrCorBuffIdx;						// index into m_szErrCorLineBuff at which to next copy a corrected sequence
 	int AllocdErrCorLineBuff;				// allocation size for m_pszErrCorLineBuff
 	char *pszErrCorLineBuff;				// allocated buffering for error corrected and scored sequences
@@ -211,6 +252,22 @@ class CPBECContigs
 
 	int InitiateECContigs(int NumECThreads);	// initiate contig error correction using this many threads
 
+	int											// < 0 if errors, 0 if error correction to be (re)started or resumed, 1 if already completed
+		InitChkPts(UINT64 TotContigsLen);		// open and validate any existing checkpoint file, replaying checkpointed alignments, else create new checkpoint file
+
+	int AddChkPtAlign(UINT32 TargEntryID,		// contained alignment was onto this contig
+				UINT32 TargSeqLen,				// contig length
+				UINT32 RefStartOfs,				// alignment starts at this contig offset
+				UINT32 RefEndOfs,				// alignment ends at this contig offset inclusive
+				UINT32 ProbeStartOfs,			// alignment starts at this high confidence sequence offset
+				UINT32 ProbeEndOfs,				// alignment ends at this high confidence sequence offset inclusive
+				bool bRevCpl,					// true if high confidence sequence was revcpl'd
+				UINT32 NumAlignOps,				// number of alignment operators
+				tMAOp *pAlignOps,				// alignment operators
+				tsThreadPBECContigs *pPars);	// thread specific
+
+	int WriteChkPt(tsECCChkPt *pChkPt);		// append and fsync checkpoint record, ChkPtLen is the total record length including any immediately following alignments
+
 	int IdentifyCoreHits(UINT32 HiConfSeqID,	// identify all overlaps of this probe sequence HiConfSeqID onto target sequences
 				UINT32 MinTargLen,				// accepted target hit sequences must be at least this length
 				UINT32 MaxTargLen,				// and if > 0 then accepted targets no longer than this length
@@ -275,6 +332,7 @@ public:
 		char *pszContigFile,			// input multifasta contig file
 		char *pszHiConfFile,			// input hiconfidence file
 	    char *pszErrCorFile,		// name of file into which write error corrected contigs
+		char *pszChkPtsFile,        // name of file used for checkpointing in case resume processing is required
 		int NumThreads);			// maximum number of worker threads to use
 
 };
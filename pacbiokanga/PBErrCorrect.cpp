@@ -225,7 +225,7 @@ struct arg_int *threads = arg_int0("T","threads","<int>",						"number of proces
 
 struct arg_int *maxnonrmi = arg_int0("N","maxnonrmi","<int>",					"if RMI SW processing then limit non-RMI to this maximum number of SW threads (defaults to threads, range 0 ... threads)");
 struct arg_int *maxrmi = arg_int0("n","maxrmi","<int>",							"maximum number of RMI SW instances supported (defaults to 0 which sets max RMI instances to 4 x number of threads, range 16 to 500)");
-struct arg_str  *rmihost = arg_str0("u", "rmihost", "<string>",					"listening on this host name or IPv4/IPv5 address for connections by SW service providers (default 127.0.0.1)");
+struct arg_str  *rmihost = arg_str0("u", "rmihost", "<string>",					"listening on this host name or IPv4/IPv5 address for connections by SW service providers (default 127.0.0.1), or a local socket path (e.g. /tmp/bks.sock) for co-located providers");
 struct arg_str  *rmiservice = arg_str0("U", "rmiservice", "<string>",			"Listen on this service name or port for connections by SW service providers (default 43123)");
 
 struct arg_file *summrslts = arg_file0("q","sumrslts","<file>",				"Output results summary to this SQLite3 database file");
@@ -3556,6 +3556,11 @@ for(ThreadIdx = 0; ThreadIdx < NumOvlpThreads; ThreadIdx++,pThreadPar++)
 			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate %d memory for RMIBuffer buffering",RMIBufferSize);
 			break;
 			}
+		if((pThreadPar->pRMIBatchData = (UINT8 *)malloc(cRMIBatchDataSize))==NULL)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate %d memory for RMIBatchData buffering",cRMIBatchDataSize);
+			break;
+			}
 		}
 	}
 
@@ -3591,6 +3596,8 @@ if(ThreadIdx != NumOvlpThreads)	// any errors whilst allocating memory for core
 			free(pThreadPar->pRMIRespData);
 		if(pThreadPar->pRMIBuffer != NULL)
 			free(pThreadPar->pRMIBuffer);
+		if(pThreadPar->pRMIBatchData != NULL)
+			free(pThreadPar->pRMIBatchData);
 
 		pThreadPar -= 1;
 		ThreadIdx -= 1;
@@ -3699,6 +3706,8 @@ for(ThreadIdx = 0; ThreadIdx < NumOvlpThreads; ThreadIdx++,pThreadPar++)
 		free(pThreadPar->pRMIRespData);
 	if(pThreadPar->pRMIBuffer != NULL)
 		free(pThreadPar->pRMIBuffer);
+	if(pThreadPar->pRMIBatchData != NULL)
+		free(pThreadPar->pRMIBatchData);
 	}
 
 delete pThreadPutOvlps;
@@ -3769,6 +3778,12 @@ UINT32	CurSProbeStartOfs;
 UINT32	CurSProbeEndOfs;
 UINT32	CurAProbeStartOfs;
 UINT32	CurAProbeEndOfs;
+INT32 CurHitDiag;
+INT32 CurSMinDiag;
+INT32 CurSMaxDiag;
+INT32 CurAMinDiag;
+INT32 CurAMaxDiag;
+INT32 BandMargin;
 UINT32 ProvOverlapping;
 UINT32 ProvOverlapped;
 UINT32 ProvContained;
@@ -3806,6 +3821,8 @@ RMIRestartThread:							// RMI threads with errors detected are restarted from h
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 if(ClassInstanceID != 0)   // non-zero if must have been a RMI SW thread which is restarting 
 	{
+	RMI_BatchWait(pThreadPar);		// ensure any outstanding batch response is retrieved, result is of no interest
+	pThreadPar->bRMIBatch = false;
 	RMI_delete(pThreadPar,cRMI_SecsTimeout,ClassInstanceID);
 	if(pCurPBScaffNode != NULL)
 		{
@@ -4097,6 +4114,10 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 		CurSProbeEndOfs = 0;
 		CurAProbeStartOfs = 0;
 		CurAProbeEndOfs = 0;
+		CurSMinDiag = INT_MAX;
+		CurSMaxDiag = INT_MIN;
+		CurAMinDiag = INT_MAX;
+		CurAMaxDiag = INT_MIN;
 
 		bFirstHitNewTargSeq = false;
 		pCoreHit = pThreadPar->pCoreHits;
@@ -4116,14 +4137,23 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 				CurSProbeEndOfs = 0;
 				CurAProbeStartOfs = 0;
 				CurAProbeEndOfs = 0;
+				CurSMinDiag = INT_MAX;
+				CurSMaxDiag = INT_MIN;
+				CurAMinDiag = INT_MAX;
+				CurAMaxDiag = INT_MIN;
 				}
 
 			if(pCoreHit->flgClustered && pCoreHit->TargNodeID == CurTargSeqID) // same target sequence so check for starting/ending offsets and accumulate hit counts 
 				{
 				CurTargHitOfs = pCoreHit->TargOfs;
 				CurProbeHitOfs = pCoreHit->ProbeOfs;
+				CurHitDiag = (INT32)CurTargHitOfs - (INT32)CurProbeHitOfs;
 				if(pCoreHit->flgRevCpl == 0)
 					{
+					if(CurHitDiag < CurSMinDiag)
+						CurSMinDiag = CurHitDiag;
+					if(CurHitDiag > CurSMaxDiag)
+						CurSMaxDiag = CurHitDiag;
 					if(bFirstHitNewTargSeq == true || CurTargHitOfs < CurSTargStartOfs)
 						CurSTargStartOfs = CurTargHitOfs;
 					if(CurTargHitOfs > CurSTargEndOfs)
@@ -4135,6 +4165,10 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 					}
 				else
 					{
+					if(CurHitDiag < CurAMinDiag)
+						CurAMinDiag = CurHitDiag;
+					if(CurHitDiag > CurAMaxDiag)
+						CurAMaxDiag = CurHitDiag;
 					if(bFirstHitNewTargSeq == true || CurTargHitOfs < CurATargStartOfs)
 						CurATargStartOfs = CurTargHitOfs;
 					if(CurTargHitOfs > CurATargEndOfs)
@@ -4212,6 +4246,10 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 					pSummaryCnts->SProbeEndOfs = CurSProbeEndOfs;
 					pSummaryCnts->AProbeStartOfs = CurAProbeStartOfs;
 					pSummaryCnts->AProbeEndOfs = CurAProbeEndOfs;
+					pSummaryCnts->SMinDiag = CurSMinDiag;
+					pSummaryCnts->SMaxDiag = CurSMaxDiag;
+					pSummaryCnts->AMinDiag = CurAMinDiag;
+					pSummaryCnts->AMaxDiag = CurAMaxDiag;
 					pSummaryCnts->NumSHits = CurSEntryIDHits;
 					pSummaryCnts->NumAHits = CurAEntryIDHits;
 					pSummaryCnts->flgProbeHCseq = m_pPBScaffNodes[pCoreHit->ProbeNodeID-1].flgHCseq;
@@ -4261,6 +4299,30 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 			if(bNonRMIRslt == false)
 				goto RMIRestartThread;
 			}
+		// class instances can't be moved while holding per probe state so work is rebalanced between probes; if another session has spare capacity and
+		// a substantially earlier estimated completion time for this probes alignments then the class instance is migrated onto that session
+		if(pThreadPar->bRMI && pThreadPar->RMIBatchJobID == 0)
+			{
+			UINT32 HitIdx;
+			UINT64 EstCells;
+			UINT32 MigrateSessionID;
+			UINT64 MigrateClassInstanceID;
+			EstCells = 0;
+			for(HitIdx = 0; HitIdx < pThreadPar->NumTargCoreHitCnts; HitIdx++)
+				EstCells += (UINT64)pCurPBScaffNode->SeqLen * m_pPBScaffNodes[pThreadPar->TargCoreHitCnts[HitIdx].TargNodeID-1].SeqLen;
+			if((MigrateSessionID = pThreadPar->pRequester->PreferredSession(pThreadPar->ServiceType,ClassInstanceID,EstCells)) != 0 &&
+				(MigrateClassInstanceID = RMI_new(pThreadPar,cRMI_MigrateSecsTimeout,MigrateSessionID)) != 0)
+				{
+				RMI_delete(pThreadPar,cRMI_SecsTimeout,ClassInstanceID);
+				ClassInstanceID = MigrateClassInstanceID;
+				bRMIInitialised = false;
+				}
+			}
+
+		// class initialisation and per probe setup methods are accumulated into a single batch which is pipelined ahead of the first alignment on this probe
+		if(pThreadPar->bRMI && !RMI_BatchStart(pThreadPar,cRMI_SecsTimeout,ClassInstanceID))
+			goto RMIRestartThread;
+
 		if(pThreadPar->bRMI && !bRMIInitialised)
 			{
 			bRMIRslt = RMI_SetScores(pThreadPar,cRMI_SecsTimeout,ClassInstanceID,m_SWMatchScore,m_SWMismatchPenalty,m_SWGapOpenPenalty,m_SWGapExtnPenalty,m_SWProgExtnPenaltyLen,min(63,m_SWProgExtnPenaltyLen+3),cAnchorLen);
@@ -4304,7 +4366,7 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 		else
 			{
 			bRMIRslt = RMI_SetProbe(pThreadPar,cRMI_SecsTimeout,ClassInstanceID,pCurPBScaffNode->SeqLen,pThreadPar->pProbeSeq);
-			if(bRMIRslt == false)
+			if(bRMIRslt == false || RMI_BatchSubmit(pThreadPar) < 1)
 				goto RMIRestartThread;
 			}
 
@@ -4403,6 +4465,10 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 				CombinedTargAlignPars.TargStartRelOfs = pSummaryCnts->STargStartOfs;
 				CombinedTargAlignPars.ProbeRelLen = pSummaryCnts->SProbeEndOfs + 1 - pSummaryCnts->SProbeStartOfs;
 				CombinedTargAlignPars.TargRelLen = pSummaryCnts->STargEndOfs + 1 - pSummaryCnts->STargStartOfs;
+
+				// band SW to the diagonals of the core hits, relative to the alignment range
+				CombinedTargAlignPars.BandMinDiag = pSummaryCnts->SMinDiag - (INT32)pSummaryCnts->STargStartOfs + (INT32)pSummaryCnts->SProbeStartOfs;
+				CombinedTargAlignPars.BandMaxDiag = pSummaryCnts->SMaxDiag - (INT32)pSummaryCnts->STargStartOfs + (INT32)pSummaryCnts->SProbeStartOfs;
 				}
 			else
 				{
@@ -4435,8 +4501,18 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 				CombinedTargAlignPars.TargStartRelOfs = pSummaryCnts->ATargStartOfs;
 				CombinedTargAlignPars.ProbeRelLen = pSummaryCnts->AProbeEndOfs + 1 - pSummaryCnts->AProbeStartOfs;
 				CombinedTargAlignPars.TargRelLen = pSummaryCnts->ATargEndOfs + 1 - pSummaryCnts->ATargStartOfs;
+
+				// antisense core hit diagonals were onto the reverse complemented probe so need to be transformed onto the reverse complemented target
+				CombinedTargAlignPars.BandMinDiag = ((INT32)TargSeqLen - (INT32)pCurPBScaffNode->SeqLen - pSummaryCnts->AMaxDiag) - (INT32)pSummaryCnts->ATargStartOfs + (INT32)pSummaryCnts->AProbeStartOfs;
+				CombinedTargAlignPars.BandMaxDiag = ((INT32)TargSeqLen - (INT32)pCurPBScaffNode->SeqLen - pSummaryCnts->AMinDiag) - (INT32)pSummaryCnts->ATargStartOfs + (INT32)pSummaryCnts->AProbeStartOfs;
 				}
 
+			// allowing for InDel drift along the overlap flanks beyond the first and last core hits
+			BandMargin = cCoreHitsBandMargin + (INT32)(min(CombinedTargAlignPars.ProbeRelLen,CombinedTargAlignPars.TargRelLen) / 50);
+			CombinedTargAlignPars.BandMinDiag -= BandMargin;
+			CombinedTargAlignPars.BandMaxDiag += BandMargin;
+			CombinedTargAlignPars.XDropScore = cDfltSWXDropScore;
+
 			if(CombinedTargAlignPars.ProbeRelLen < MinOverlapLen || CombinedTargAlignPars.TargRelLen < MinOverlapLen)
 				continue;
 
@@ -4450,7 +4526,10 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 				}
 			else
 				{
-				if(!RMI_CombinedTargAlign(pThreadPar,cRMI_AlignSecsTimeout,ClassInstanceID,&CombinedTargAlignPars, &TargAlignRet))
+				iRMIRslt = RMI_CombinedTargAlign(pThreadPar,cRMI_AlignSecsTimeout,ClassInstanceID,&CombinedTargAlignPars, &TargAlignRet);
+				if(pThreadPar->RMIBatchJobID != 0 && RMI_BatchWait(pThreadPar) < 0)	// batched probe setup was pipelined ahead of this alignment so its response will now be available
+					goto RMIRestartThread;
+				if(!iRMIRslt)
 					goto RMIRestartThread;
 				if(TargAlignRet.ErrRslt != eBSFSuccess || TargAlignRet.ProcPhase < 2 || TargAlignRet.ProcPhase == 3)
 					goto RMIRestartThread;
@@ -4519,6 +4598,9 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 			}
 		}
 
+	if(pThreadPar->bRMI && pThreadPar->RMIBatchJobID != 0 && RMI_BatchWait(pThreadPar) < 0)	// no alignments were requested on this probe so batched probe setup response still to be processed
+		goto RMIRestartThread;
+
 	if((m_PMode == ePBPMErrCorrect || m_PMode == ePBMConsolidate))
 		{
 		if((pThreadPar->pSW != NULL || pThreadPar->bRMI) && NumInMultiAlignment >= 1 &&  (m_hMultiAlignFile != -1 || m_hErrCorFile != -1))
@@ -4788,6 +4870,7 @@ ReleaseCASSerialise();
 
 if(pThreadPar->bRMI && ClassInstanceID != 0)
 	{
+	RMI_BatchWait(pThreadPar);
 	RMI_delete(pThreadPar,cRMI_SecsTimeout,ClassInstanceID);
 	ClassInstanceID = 0;
 	}
@@ -5237,6 +5320,166 @@ if(Rslt < 1)
 return;
 }
 
+// batching of RMI_ methods: the per class and per probe setup methods each required a full request/response round trip
+// these are instead accumulated into a single eSWMBatch request which can be submitted without waiting for its response,
+// service providers process requests on a class instance in submission order so subsequent requests can be pipelined behind the batch
+bool
+CPBErrCorrect::RMI_BatchStart(tsThreadPBErrCorrect *pThreadPar, UINT32 Timeout,  UINT64 ClassInstanceID)	// following batchable RMI_ methods are accumulated into a single batched request
+{
+bool bRslt;
+bRslt = true;
+if(pThreadPar->RMIBatchJobID != 0)		// any previously submitted batch must have been completed
+	bRslt = RMI_BatchWait(pThreadPar) >= 0 ? true : false;
+pThreadPar->RMIBatchTimeout = Timeout;
+pThreadPar->RMIBatchClassInstanceID = ClassInstanceID;
+pThreadPar->RMIBatchNumInvocs = 0;
+pThreadPar->RMIBatchDataLen = sizeof(UINT32);
+pThreadPar->bRMIBatch = bRslt;
+return(bRslt);
+}
+
+int 
+CPBErrCorrect::RMI_BatchAdd(tsThreadPBErrCorrect *pThreadPar,		// returns handle by which invocation result can be referenced, -1 if errors
+					UINT32 ClassMethodID,					// method to invoke
+					INT32 MinRslt,							// remaining invocations not processed if result of this invocation is less than MinRslt
+					UINT32 ReqDataLen,						// method request data is this length
+					UINT8 *pReqData)						// marshalled method request data
+{
+tsSWBatchInvoc *pInvoc;
+if(!pThreadPar->bRMIBatch || (sizeof(UINT32) + sizeof(tsSWBatchInvoc) + ReqDataLen) > cRMIBatchDataSize)
+	return(-1);
+
+// if no room for this invocation then the batch accumulated so far must be completed before starting a new batch
+if(pThreadPar->RMIBatchNumInvocs == cMaxSWBatchInvocs || (pThreadPar->RMIBatchDataLen + sizeof(tsSWBatchInvoc) + ReqDataLen) > cRMIBatchDataSize)
+	{
+	if(RMI_BatchSubmit(pThreadPar) < 1 || RMI_BatchWait(pThreadPar) < 0)
+		return(-1);
+	pThreadPar->bRMIBatch = true;
+	pThreadPar->RMIBatchNumInvocs = 0;
+	pThreadPar->RMIBatchDataLen = sizeof(UINT32);
+	}
+
+pInvoc = (tsSWBatchInvoc *)&pThreadPar->pRMIBatchData[pThreadPar->RMIBatchDataLen];
+pInvoc->ClassMethodID = ClassMethodID;
+pInvoc->MinRslt = MinRslt;
+pInvoc->ReqDataLen = ReqDataLen;
+pThreadPar->RMIBatchDataLen += sizeof(tsSWBatchInvoc);
+if(ReqDataLen > 0)
+	{
+	memcpy(&pThreadPar->pRMIBatchData[pThreadPar->RMIBatchDataLen],pReqData,ReqDataLen);
+	pThreadPar->RMIBatchDataLen += ReqDataLen;
+	}
+pThreadPar->RMIBatchNumInvocs += 1;
+*(UINT32 *)pThreadPar->pRMIBatchData = pThreadPar->RMIBatchNumInvocs;
+return(pThreadPar->RMIBatchNumInvocs - 1);
+}
+
+int 
+CPBErrCorrect::RMI_BatchSubmit(tsThreadPBErrCorrect *pThreadPar)	// submit accumulated batch without waiting for response, returns 1 if submitted
+{
+int Rslt;
+tJobIDEx JobID;
+time_t Then;
+time_t Now;
+UINT32 SleepTime;
+
+pThreadPar->bRMIBatch = false;
+if(pThreadPar->RMIBatchJobID != 0)		// at most one batch can be outstanding
+	return(-2);
+if(pThreadPar->RMIBatchNumInvocs == 0)
+	return(1);
+
+SleepTime = 50;
+Then = time(NULL);
+while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,pThreadPar->RMIBatchClassInstanceID,eSWMBatch,0,NULL,pThreadPar->RMIBatchDataLen,pThreadPar->pRMIBatchData))==0)
+	{
+	Now = time(NULL);
+	if((Now - Then) > pThreadPar->RMIBatchTimeout)
+		return(-3);
+	CUtility::SleepMillisecs(SleepTime);
+	if(SleepTime < 1000)
+		SleepTime += 50;
+	}
+if(Rslt < 1)		// JobID not accepted, service provider session terminated??
+	return(Rslt);
+pThreadPar->RMIBatchJobID = JobID;
+pThreadPar->RMIBatchJobInvocs = pThreadPar->RMIBatchNumInvocs;
+pThreadPar->RMIBatchNumInvocs = 0;
+return(1);
+}
+
+int 
+CPBErrCorrect::RMI_BatchWait(tsThreadPBErrCorrect *pThreadPar)	// wait for outstanding batch response, returns number of invocations processed if all were accepted otherwise -1
+{
+int Rslt;
+int Handle;
+INT32 InvocRslt;
+UINT32 JobRslt;
+UINT64 ClassInstanceID;
+UINT32 ClassMethodID;
+UINT32	MaxResponseSize;
+time_t Then;
+time_t Now;
+UINT32 SleepTime;
+
+if(pThreadPar->RMIBatchJobID == 0)
+	return(0);
+SleepTime = 50;
+Then = time(NULL);
+MaxResponseSize = pThreadPar->RMIRespDataSize;
+while((Rslt = pThreadPar->pRequester->GetJobResponse(pThreadPar->RMIBatchJobID,&ClassInstanceID,&ClassMethodID,&JobRslt,&MaxResponseSize,pThreadPar->pRMIRespData))==0)
+	{
+	Now = time(NULL);
+	if((Now - Then) > pThreadPar->RMIBatchTimeout)
+		break;
+	CUtility::SleepMillisecs(SleepTime);
+	if(SleepTime < 1000)
+		SleepTime += 50;
+	}
+pThreadPar->RMIBatchJobID = 0;
+if(Rslt < 1 || MaxResponseSize < sizeof(UINT32))
+	return(-1);
+if(JobRslt != pThreadPar->RMIBatchJobInvocs)		// JobRslt is number of invocations accepted so handle of first invocation not accepted is JobRslt
+	{
+	Handle = (int)JobRslt;
+	RMI_BatchRslt(pThreadPar,Handle,&InvocRslt);
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"RMI_BatchWait: only %u of %u batched invocations accepted, invocation %d result was %d",JobRslt,pThreadPar->RMIBatchJobInvocs,Handle,InvocRslt);
+	return(-1);
+	}
+return((int)JobRslt);
+}
+
+int 
+CPBErrCorrect::RMI_BatchRslt(tsThreadPBErrCorrect *pThreadPar,	// returns 1 if result available for invocation referenced by Handle, 0 if invocation was not processed, -1 if errors
+					int Handle,								// handle as returned by RMI_BatchAdd
+					INT32 *pRslt,							// returned invocation result
+					UINT32 *pRespDataLen,					// returned invocation response data length
+					UINT8 **ppRespData)						// returned ptr to invocation response data in pRMIRespData
+{
+int Idx;
+UINT32 RespDataOfs;
+tsSWBatchRslt *pBatchRslt;
+if(Handle < 0 || pRslt == NULL)
+	return(-1);
+*pRslt = -1;
+if((UINT32)Handle >= *(UINT32 *)pThreadPar->pRMIRespData)
+	return(0);
+RespDataOfs = sizeof(UINT32);
+for(Idx = 0; Idx <= Handle; Idx++)
+	{
+	pBatchRslt = (tsSWBatchRslt *)&pThreadPar->pRMIRespData[RespDataOfs];
+	RespDataOfs += sizeof(tsSWBatchRslt);
+	if(Idx < Handle)
+		RespDataOfs += pBatchRslt->RespDataLen;
+	}
+*pRslt = pBatchRslt->Rslt;
+if(pRespDataLen != NULL)
+	*pRespDataLen = pBatchRslt->RespDataLen;
+if(ppRespData != NULL)
+	*ppRespData = pBatchRslt->RespDataLen ? &pThreadPar->pRMIRespData[RespDataOfs] : NULL;
+return(1);
+}
+
 bool 
 CPBErrCorrect::RMI_SetScores(tsThreadPBErrCorrect *pThreadPar, UINT32 Timeout,  UINT64 ClassInstanceID,
 				int MatchScore,									// score for match
@@ -5267,6 +5510,8 @@ RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&Gap
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&DlyGapExtn,sizeof(DlyGapExtn));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&ProgPenaliseGapExtn,sizeof(ProgPenaliseGapExtn));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&AnchorLen,sizeof(AnchorLen));
+if(pThreadPar->bRMIBatch)		// accumulating into batch, invocation result is checked when batch response is processed
+	return(RMI_BatchAdd(pThreadPar,eSWMSetScores,1,RespDataOfs,pThreadPar->pRMIReqData) >= 0 ? true : false);
 while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMSetScores,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
 	{
 	Now = time(NULL);
@@ -5316,6 +5561,8 @@ RespDataOfs = MarshalReq(pThreadPar->pRMIReqData,eRMIPTInt32,&MatchScore,sizeof(
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&MismatchPenalty,sizeof(MismatchPenalty));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&GapOpenPenalty,sizeof(GapOpenPenalty));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&GapExtnPenalty,sizeof(GapExtnPenalty));
+if(pThreadPar->bRMIBatch)		// accumulating into batch, invocation result is checked when batch response is processed
+	return(RMI_BatchAdd(pThreadPar,eSWMSetCPScores,1,RespDataOfs,pThreadPar->pRMIReqData) >= 0 ? true : false);
 while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMSetCPScores,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
 	{
 	Now = time(NULL);
@@ -5360,6 +5607,8 @@ SleepTime = 50;
 Then = time(NULL);
 
 RespDataOfs = MarshalReq(pThreadPar->pRMIReqData,eRMIPTInt32,&MaxInitiatePathOfs,sizeof(MaxInitiatePathOfs));
+if(pThreadPar->bRMIBatch)		// accumulating into batch, invocation result is checked when batch response is processed
+	return(RMI_BatchAdd(pThreadPar,eSWMSetMaxInitiatePathOfs,1,RespDataOfs,pThreadPar->pRMIReqData) >= 0 ? true : false);
 while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMSetMaxInitiatePathOfs,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
 	{
 	Now = time(NULL);
@@ -5405,6 +5654,8 @@ Then = time(NULL);
 
 RespDataOfs = MarshalReq(pThreadPar->pRMIReqData,eRMIPTUint32,&MaxTargLen,sizeof(MaxTargLen));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTUint32,&MaxOverlapLen,sizeof(MaxOverlapLen));
+if(pThreadPar->bRMIBatch)		// accumulating into batch, invocation result is checked when batch response is processed
+	return(RMI_BatchAdd(pThreadPar,eSWMPreAllocMaxTargLen,1,RespDataOfs,pThreadPar->pRMIReqData) >= 0 ? true : false);
 while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMPreAllocMaxTargLen,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
 	{
 	Now = time(NULL);
@@ -5454,6 +5705,8 @@ RespDataOfs = MarshalReq(pThreadPar->pRMIReqData,eRMIPTInt32,&SeqLen,sizeof(SeqL
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTVarUint8,pProbeSeq,SeqLen);
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&Alignments,sizeof(Alignments));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTUint8,&Flags,sizeof(Flags));
+if(pThreadPar->bRMIBatch)		// accumulating into batch, invocation result is checked when batch response is processed
+	return(RMI_BatchAdd(pThreadPar,eSWMStartMultiAlignments,0,RespDataOfs,pThreadPar->pRMIReqData) >= 0 ? 0 : -1);
 while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMStartMultiAlignments,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
 	{
 	Now = time(NULL);
@@ -5497,6 +5750,8 @@ SleepTime = 50;
 Then = time(NULL);
 RespDataOfs = MarshalReq(pThreadPar->pRMIReqData,eRMIPTInt32,&Len,sizeof(Len));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTVarUint8,pSeq,Len);
+if(pThreadPar->bRMIBatch)		// accumulating into batch, invocation result is checked when batch response is processed
+	return(RMI_BatchAdd(pThreadPar,eSWMSetProbe,1,RespDataOfs,pThreadPar->pRMIReqData) >= 0 ? true : false);
 while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMSetProbe,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
 	{
 	Now = time(NULL);
@@ -5700,8 +5955,14 @@ memset(pAlignRet,0,sizeof(tsCombinedTargAlignRet));
 Then = time(NULL);
 RespDataOfs = MarshalReq(pThreadPar->pRMIReqData,eRMIPTVarUint8,pAlignPars,sizeof(tsCombinedTargAlignPars));
 RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTVarUint8,pAlignPars->pTargSeq,pAlignPars->TargSeqLen);
-while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMCombinedTargAlign,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
+while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMCombinedTargAlign,0,NULL,RespDataOfs,pThreadPar->pRMIReqData,0,(UINT64)pAlignPars->ProbeSeqLen * pAlignPars->TargSeqLen))==0)
 	{
+	if(pThreadPar->RMIBatchJobID != 0)	// no session capacity to pipeline this request behind the outstanding batch so must wait for batch completion
+		{
+		if(RMI_BatchWait(pThreadPar) < 0)
+			return(0);
+		continue;
+		}
 	Now = time(NULL);
 	if((Now - Then) > Timeout)
 		return(-3);
@@ -5717,7 +5978,10 @@ while((Rslt = pThreadPar->pRequester->GetJobResponse(JobID,&ClassInstanceID,&Cla
 	{
 	Now = time(NULL);
 	if((Now - Then) > Timeout)
+		{
+		pThreadPar->pRequester->AbandonJobRequest(JobID);	// no longer waiting on this job so its DP cells no longer count against the session's load
 		return(-3);
+		}
 	CUtility::SleepMillisecs(SleepTime);
 	if(SleepTime < 1000)
 		SleepTime += 50;
@@ -5762,6 +6026,7 @@ CPBErrCorrect::RMI_CombinedTargAlign(tsThreadPBErrCorrect *pThreadPar, UINT32 Ti
 int Rslt;
 tsCombinedTargAlignPars AlignPars;
 tsCombinedTargAlignRet AlignRet;
+memset(&AlignPars,0,sizeof(AlignPars));		// no alignment band unless explicitly set
 memset(&AlignRet,0,sizeof(tsCombinedTargAlignRet));
 *pRetClass = 0;
 memset(pRetPeakMatchesCell,0,sizeof(tsSSWCell));
@@ -29,6 +29,9 @@ const int cDfltMaxConsolidateArtefactDev = 30;	// default percentage deviation f
 const int cDfltScaffMaxArtefactDev = 30;		// but when scaffolding with error corrected reads there should a much smaller percentage deviation from the mean
 const int cMaxMaxArtefactDev = 80;			// user can specify up to this maximum 
 
+const int cCoreHitsBandMargin = 250;		// SW alignments are banded to the diagonals of the clustered core hits extended by this margin to allow for InDel drift over overlap flanks
+const int cDfltSWXDropScore = 500;			// banded SW alignment paths are terminated if their score drops by more than this below the peak path score
+
 const int cReqConsensusCoverage = 10;   // targeting this mean probe sequence coverage to have confidence in consensus error correction
 
 const int cMaxPacBioErrCorLen = cMaxSWQuerySeqLen;			// allowing for error corrected read sequences of up to this length
@@ -37,9 +40,11 @@ const int cMaxPacBioMAFLen    = cMaxSWMAFBuffSize;			// allowing for multialignm
 const int cDfltRMIReqDataSize = cMaxSWReqPayloadSize;		// RMI: each worker thread default allocates to process up to this much request data
 const int cDfltRMIReqParamSize = cMaxSWParamLen;			// RMI: each worker thread default allocates to process up to this much parameterisation data
 const int cDfltRMIRespDataSize = cMaxSWRespPayloadSize;		// RMI: each worker thread default allocates to return up to this much response data
+const int cRMIBatchDataSize = cMaxSWQuerySeqLen;			// RMI: batched method invocations are limited to this much request data
 const int cDfltRMIBufferSize =   cMaxSWMAFBuffSize;			// each worker thread default allocates to hold at most this sized MAlignCols2fasta/MAlignCols2MFA alignments
 
 const UINT32 cRMI_SecsTimeout = 180;				// allowing for most RMI SW requests to take at most this many seconds to complete (request plus response)
+const UINT32 cRMI_MigrateSecsTimeout = 10;			// allowing at most this many seconds to instantiate a class instance on a less loaded session when migrating between probes
 const UINT32 cRMI_AlignSecsTimeout = 600;			// allowing for a RMI SW alignment request to take at most this many seconds to complete (request plus response)
 const UINT32 cRMIThreadsPerCore = 8;				// current guesstimate is that 1 server core can support this many RMI SW threads ( 1 core per Non-RMI SW thread)
                                                     // predicated on assuming that the qualifying of read pairs for SW requires around 20% of per core time, the other 80% is spent on SW
@@ -123,6 +128,10 @@ typedef struct TAG_sPBECoreHitCnts {
 	UINT32	SProbeEndOfs;			// highest probe offset for any sense hit onto target
 	UINT32	AProbeStartOfs;			// lowest probe offset for any antisense hit onto target
 	UINT32	AProbeEndOfs;			// highest probe offset for any antisense hit onto target
+	INT32	SMinDiag;				// lowest diagonal (target offset - probe offset) for any sense hit onto target
+	INT32	SMaxDiag;				// highest diagonal for any sense hit onto target
+	INT32	AMinDiag;				// lowest diagonal for any antisense hit onto target
+	INT32	AMaxDiag;				// highest diagonal for any antisense hit onto target
 	UINT32 NumSHits;				// number of hits onto target sequence from sense probe
 	UINT32 NumAHits;				// number of hits onto target sequence from antisense probe
 	UINT8 flgProbeHCseq:1;          // set if probe was loaded as a high confidence (non-PacBio) sequence
@@ -194,6 +203,14 @@ typedef struct TAG_sThreadPBErrCorrect {
 	UINT8 *pRMIRespData;			// allocated to hold response data
 	UINT32 RMIBufferSize;			// RMIBuffer allocation size
 	UINT8 *pRMIBuffer;				// allocated to hold buffered data needing a life time extending past the RMI_ function
+	bool bRMIBatch;					// set true whilst batchable RMI_ methods are being accumulated into pRMIBatchData instead of being individually submitted
+	UINT32 RMIBatchTimeout;			// batched method invocations allowed at most this many seconds to complete
+	UINT64 RMIBatchClassInstanceID;	// batched method invocations are on this class instance
+	UINT32 RMIBatchNumInvocs;		// number of method invocations accumulated into pRMIBatchData
+	UINT32 RMIBatchDataLen;			// pRMIBatchData currently holds this many bytes
+	UINT8 *pRMIBatchData;			// allocated (cRMIBatchDataSize) to hold accumulated batch of method invocations
+	tJobIDEx RMIBatchJobID;			// if non-zero then a submitted batch is outstanding and its response has yet to be processed
+	UINT32 RMIBatchJobInvocs;		// number of method invocations in the outstanding batch
 
 } tsThreadPBErrCorrect;
 
@@ -460,6 +477,20 @@ static int SortCoreHitsDescending(const void *arg1, const void *arg2);
 	
 	void RMI_delete(tsThreadPBErrCorrect *pThreadPar, UINT32 Timeout,UINT64 ClassInstanceID);	// delete the class instance
 
+	bool RMI_BatchStart(tsThreadPBErrCorrect *pThreadPar, UINT32 Timeout,  UINT64 ClassInstanceID);	// following batchable RMI_ methods are accumulated into a single batched request
+	int RMI_BatchAdd(tsThreadPBErrCorrect *pThreadPar,		// returns handle by which invocation result can be referenced, -1 if errors
+					UINT32 ClassMethodID,					// method to invoke
+					INT32 MinRslt,							// remaining invocations not processed if result of this invocation is less than MinRslt
+					UINT32 ReqDataLen,						// method request data is this length
+					UINT8 *pReqData);						// marshalled method request data
+	int RMI_BatchSubmit(tsThreadPBErrCorrect *pThreadPar);	// submit accumulated batch without waiting for response, returns 1 if submitted
+	int RMI_BatchWait(tsThreadPBErrCorrect *pThreadPar);	// wait for outstanding batch response, returns number of invocations processed if all were accepted otherwise -1
+	int RMI_BatchRslt(tsThreadPBErrCorrect *pThreadPar,	// returns 1 if result available for invocation referenced by Handle, 0 if invocation was not processed, -1 if errors
+					int Handle,								// handle as returned by RMI_BatchAdd
+					INT32 *pRslt,							// returned invocation result
+					UINT32 *pRespDataLen = NULL,			// returned invocation response data length
+					UINT8 **ppRespData = NULL);				// returned ptr to invocation response data in pRMIRespData
+
 	bool RMI_SetScores(tsThreadPBErrCorrect *pThreadPar, UINT32 Timeout,  UINT64 ClassInstanceID,
 				int MatchScore= cSSWDfltMatchScore,			// score for match
 				int MismatchPenalty  = cSSWDfltMismatchPenalty,	// penalty for mismatch
@@ -0,0 +1,494 @@
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+
+// PBSWBench.cpp : benchmarks CSSW::Align() throughput, in cells per second, on simulated PacBio like probe and target pairs
+// Each pair is aligned with and without the striped score only pass narrowing the alignment so the two can be compared,
+// the peak matches cells are checked to be identical as the striped pass must not change any alignment, and the striped pass peak score
+// is checked to bound the peak score of the alignment. Alignments can optionally be banded as when error correcting reads.
+
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "../libbiokanga/commhdrs.h"
+#else
+#include <sys/mman.h>
+#include <pthread.h>
+#include "../libbiokanga/commhdrs.h"
+#endif
+
+#include "pacbiokanga.h"
+#include "pacbiocommon.h"
+#include "SSW.h"
+#include "PBSWBench.h"
+
+int
+BenchSW(etSWBenchMode PMode,			// benchmarking mode
+		int NumPairs,					// align this many simulated pairs
+		int MinLen,						// simulated sequences are at least this length
+		int MaxLen,						// and at most this length
+		int ErrRate,					// simulated error rate (percentage)
+		int MaxInitiatePathOfs,			// require SW paths to have started within this many bp, 0 to disable
+		bool bBanded,					// band alignments to the simulated diagonal as when error correcting reads
+		int Seed);						// pseudo-random generator seed so benchmarks are reproducible
+
+#ifdef _WIN32
+int ProcSWBench(int argc, char* argv[])
+{
+// determine my process name
+_splitpath(argv[0],NULL,NULL,gszProcName,NULL);
+#else
+int
+ProcSWBench(int argc, char** argv)
+{
+// determine my process name
+CUtility::splitpath((char *)argv[0],NULL,gszProcName);
+#endif
+
+int iFileLogLevel;			// level of file diagnostics
+int iScreenLogLevel;		// level of file diagnostics
+char szLogFile[_MAX_PATH];	// write diagnostics to this file
+int Rslt = 0;   			// function result code >= 0 represents success, < 0 on failure
+
+int PMode;					// benchmarking mode
+int NumPairs;				// align this many simulated pairs
+int MinLen;					// simulated sequences are at least this length
+int MaxLen;					// and at most this length
+int ErrRate;				// simulated error rate (percentage)
+int MaxInitiatePathOfs;		// require SW paths to have started within this many bp, 0 to disable
+bool bBanded;				// band alignments to the simulated diagonal
+int Seed;					// pseudo-random generator seed
+
+struct arg_lit  *help    = arg_lit0("h","help",                 "print this help and exit");
+struct arg_lit  *version = arg_lit0("v","version,ver",			"print version information and exit");
+struct arg_int *FileLogLevel=arg_int0("f", "FileLogLevel",		"<int>","Level of diagnostics written to screen and logfile 0=fatal,1=errors,2=info,3=diagnostics,4=debug");
+struct arg_file *LogFile = arg_file0("F","log","<file>",		"diagnostics log file");
+
+struct arg_int *pmode = arg_int0("m","pmode","<int>",			"benchmarking mode - 0 compare with and without striped score only pass (default), 1 with striped pass only, 2 without striped pass only");
+struct arg_int *numpairs = arg_int0("n","pairs","<int>",		"number of simulated probe and target pairs to align (default 16, range 1..10000)");
+struct arg_int *minlen = arg_int0("l","minlen","<int>",			"simulated sequences are at least this length (default 4000, range 500..50000)");
+struct arg_int *maxlen = arg_int0("L","maxlen","<int>",			"simulated sequences are at most this length (default 8000, range minlen..50000)");
+struct arg_int *errrate = arg_int0("e","errrate","<int>",		"simulated error rate percentage, 60% of errors are InDels (default 12, range 0..30)");
+struct arg_int *maxinitiate = arg_int0("M","maxinitiate","<int>",	"require SW paths to have started within this many bp, 0 to disable (default 1500, range 0..10000)");
+struct arg_lit  *banded = arg_lit0("b","banded",					"band alignments to the simulated diagonal with X-drop path termination, as when error correcting reads, with the striped pass also used for banded alignments");
+struct arg_int *seed = arg_int0("s","seed","<int>",				"pseudo-random generator seed (default 1)");
+struct arg_end *end = arg_end(200);
+
+void *argtable[] = {help,version,FileLogLevel,LogFile,
+					pmode,numpairs,minlen,maxlen,errrate,maxinitiate,banded,seed,
+					end};
+
+char **pAllArgs;
+int argerrors;
+argerrors = CUtility::arg_parsefromfile(argc,(char **)argv,&pAllArgs);
+if(argerrors >= 0)
+	argerrors = arg_parse(argerrors,pAllArgs,argtable);
+
+/* special case: '--help' takes precedence over error reporting */
+if (help->count > 0)
+        {
+		printf("\n%s %s %s, Version %s\nOptions ---\n", gszProcName,gpszSubProcess->pszName,gpszSubProcess->pszFullDescr,cpszProgVer);
+        arg_print_syntax(stdout,argtable,"\n");
+        arg_print_glossary(stdout,argtable,"  %-25s %s\n");
+		printf("\nNote: Parameters can be entered into a parameter file, one parameter per line.");
+		printf("\n      To invoke this parameter file then precede its name with '@'");
+		printf("\n      e.g. %s %s @myparams.txt\n",gszProcName,gpszSubProcess->pszName);
+		printf("\nPlease report any issues regarding usage of %s at https://github.com/csiro-crop-informatics/biokanga/issues\n\n",gszProcName);
+		return(1);
+        }
+
+    /* special case: '--version' takes precedence error reporting */
+if (version->count > 0)
+        {
+		printf("\n%s %s Version %s\n",gszProcName,gpszSubProcess->pszName,cpszProgVer);
+		return(1);
+        }
+
+if (!argerrors)
+	{
+	if(FileLogLevel->count && !LogFile->count)
+		{
+		printf("\nError: FileLogLevel '-f%d' specified but no logfile '-F<logfile>\n'",FileLogLevel->ival[0]);
+		exit(1);
+		}
+
+	iScreenLogLevel = iFileLogLevel = FileLogLevel->count ? FileLogLevel->ival[0] : eDLInfo;
+	if(iFileLogLevel < eDLNone || iFileLogLevel > eDLDebug)
+		{
+		printf("\nError: FileLogLevel '-l%d' specified outside of range %d..%d\n",iFileLogLevel,eDLNone,eDLDebug);
+		exit(1);
+		}
+
+	if(LogFile->count)
+		{
+		strncpy(szLogFile,LogFile->filename[0],_MAX_PATH);
+		szLogFile[_MAX_PATH-1] = '\0';
+		}
+	else
+		{
+		iFileLogLevel = eDLNone;
+		szLogFile[0] = '\0';
+		}
+
+	// now that log parameters have been parsed then initialise diagnostics log system
+	if(!gDiagnostics.Open(szLogFile,(etDiagLevel)iScreenLogLevel,(etDiagLevel)iFileLogLevel,true))
+		{
+		printf("\nError: Unable to start diagnostics subsystem\n");
+		if(szLogFile[0] != '\0')
+			printf(" Most likely cause is that logfile '%s' can't be opened/created\n",szLogFile);
+		exit(1);
+		}
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Subprocess %s Version %s starting",gpszSubProcess->pszName,cpszProgVer);
+	gExperimentID = 0;
+	gProcessID = 0;
+	gProcessingID = 0;
+
+	PMode = pmode->count ? pmode->ival[0] : (int)eSWBenchCompare;
+	if(PMode < eSWBenchCompare || PMode > eSWBenchFullDP)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Processing mode '-m%d' must be in range 0..%d",PMode,eSWBenchFullDP);
+		return(1);
+		}
+
+	NumPairs = numpairs->count ? numpairs->ival[0] : cDfltSWBenchPairs;
+	if(NumPairs < 1 || NumPairs > cMaxSWBenchPairs)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Number of pairs '-n%d' must be in range 1..%d",NumPairs,cMaxSWBenchPairs);
+		return(1);
+		}
+
+	MinLen = minlen->count ? minlen->ival[0] : cDfltSWBenchMinLen;
+	if(MinLen < cMinSWBenchLen || MinLen > cMaxSWBenchLen)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Minimum sequence length '-l%d' must be in range %d..%d",MinLen,cMinSWBenchLen,cMaxSWBenchLen);
+		return(1);
+		}
+
+	MaxLen = maxlen->count ? maxlen->ival[0] : max(MinLen,cDfltSWBenchMaxLen);
+	if(MaxLen < MinLen || MaxLen > cMaxSWBenchLen)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Maximum sequence length '-L%d' must be in range %d..%d",MaxLen,MinLen,cMaxSWBenchLen);
+		return(1);
+		}
+
+	ErrRate = errrate->count ? errrate->ival[0] : cDfltSWBenchErrRate;
+	if(ErrRate < 0 || ErrRate > cMaxSWBenchErrRate)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Error rate '-e%d' must be in range 0..%d",ErrRate,cMaxSWBenchErrRate);
+		return(1);
+		}
+
+	MaxInitiatePathOfs = maxinitiate->count ? maxinitiate->ival[0] : cDfltMaxOverlapFloat;
+	if(MaxInitiatePathOfs < 0 || MaxInitiatePathOfs > cMaxSWBenchInitiatePathOfs)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Max initiate path offset '-M%d' must be in range 0..%d",MaxInitiatePathOfs,cMaxSWBenchInitiatePathOfs);
+		return(1);
+		}
+
+	bBanded = banded->count ? true : false;
+	Seed = seed->count ? seed->ival[0] : 1;
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing parameters:");
+	char *pszMode;
+	switch(PMode) {
+		case eSWBenchStriped:
+			pszMode = (char *)"with striped score only pass";
+			break;
+		case eSWBenchFullDP:
+			pszMode = (char *)"without striped score only pass";
+			break;
+		default:
+			pszMode = (char *)"compare with and without striped score only pass";
+			break;
+		}
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"benchmarking mode: '%s'",pszMode);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"simulated probe and target pairs: %d",NumPairs);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"simulated sequence lengths: %d..%d",MinLen,MaxLen);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"simulated error rate: %d%%",ErrRate);
+	if(MaxInitiatePathOfs)
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"require SW paths to have started within: %dbp",MaxInitiatePathOfs);
+	else
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"require SW paths to have started within: no limit");
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"banded alignments: %s",bBanded ? "Yes" : "No");
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"pseudo-random seed: %d",Seed);
+
+	gStopWatch.Start();
+	Rslt = BenchSW((etSWBenchMode)PMode,NumPairs,MinLen,MaxLen,ErrRate,MaxInitiatePathOfs,bBanded,Seed);
+	Rslt = Rslt >=0 ? 0 : 1;
+	gStopWatch.Stop();
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Exit code: %d Total processing time: %s",Rslt,gStopWatch.Read());
+	exit(Rslt);
+	}
+else
+	{
+    printf("\n%s %s %s, Version %s\n", gszProcName,gpszSubProcess->pszName,gpszSubProcess->pszFullDescr,cpszProgVer);
+	arg_print_errors(stdout,end,gszProcName);
+	arg_print_syntax(stdout,argtable,"\nUse '-h' to view option and parameter usage\n");
+	exit(1);
+	}
+return 0;
+}
+
+// SimPacBioSeq
+// Copies source sequence into pDst with PacBio like errors; 60% of errors are InDels (equally insertions and deletions), remainder are substitutions
+static UINT32									// returned simulated sequence length, pDst must be allocated to hold at least 2 * SrcLen bases
+SimPacBioSeq(TRandomCombined<CRandomMother,CRandomMersenne> *pRG,
+			 etSeqBase *pSrc,					// source sequence
+			 UINT32 SrcLen,						// source sequence length
+			 int ErrRate,						// error rate (percentage)
+			 etSeqBase *pDst)					// simulated sequence
+{
+UINT32 DstLen;
+int Rand;
+DstLen = 0;
+while(SrcLen--)
+	{
+	Rand = pRG->IRandom(0,999);
+	if(Rand < ErrRate * 6)					// InDel
+		{
+		if(Rand & 0x01)						// deletion
+			{
+			pSrc++;
+			continue;
+			}
+		pDst[DstLen++] = (etSeqBase)pRG->IRandom(0,3);	// insertion
+		}
+	else
+		if(Rand < ErrRate * 10)				// substitution
+			{
+			pDst[DstLen++] = (etSeqBase)((*pSrc++ + pRG->IRandom(1,3)) & 0x03);
+			continue;
+			}
+	pDst[DstLen++] = *pSrc++;
+	}
+return(DstLen);
+}
+
+// SameSWCell
+// Returns true if the two peak cells describe the same alignment path
+static bool
+SameSWCell(tsSSWCell *pCell1,tsSSWCell *pCell2)
+{
+if(pCell1 == NULL || pCell2 == NULL)
+	return(pCell1 == pCell2);
+return(pCell1->StartPOfs == pCell2->StartPOfs && pCell1->StartTOfs == pCell2->StartTOfs &&
+		pCell1->EndPOfs == pCell2->EndPOfs && pCell1->EndTOfs == pCell2->EndTOfs &&
+		pCell1->PFirstAnchorStartOfs == pCell2->PFirstAnchorStartOfs && pCell1->TFirstAnchorStartOfs == pCell2->TFirstAnchorStartOfs &&
+		pCell1->PLastAnchorEndOfs == pCell2->PLastAnchorEndOfs && pCell1->TLastAnchorEndOfs == pCell2->TLastAnchorEndOfs &&
+		pCell1->NumMatches == pCell2->NumMatches && pCell1->NumExacts == pCell2->NumExacts &&
+		pCell1->NumGapsIns == pCell2->NumGapsIns && pCell1->NumGapsDel == pCell2->NumGapsDel &&
+		pCell1->NumBasesIns == pCell2->NumBasesIns && pCell1->NumBasesDel == pCell2->NumBasesDel &&
+		pCell1->PeakScore == pCell2->PeakScore);
+}
+
+int
+BenchSW(etSWBenchMode PMode,			// benchmarking mode
+		int NumPairs,					// align this many simulated pairs
+		int MinLen,						// simulated sequences are at least this length
+		int MaxLen,						// and at most this length
+		int ErrRate,					// simulated error rate (percentage)
+		int MaxInitiatePathOfs,			// require SW paths to have started within this many bp, 0 to disable
+		bool bBanded,					// band alignments to the simulated diagonal as when error correcting reads
+		int Seed)						// pseudo-random generator seed so benchmarks are reproducible
+{
+static const char *pszPairClasses[] = {"contained","overlap","unrelated","high error"};
+int Rslt;
+int PairIdx;
+int PassIdx;
+int PairClass;
+int ProbeSrcLen;
+int TargSrcLen;
+int OverlapLen;
+int PairErrRate;
+int Diag;
+int BandMargin;
+INT32 StripedPeakScore;
+UINT32 ProbeLen;
+UINT32 TargLen;
+UINT32 MaxTargLen;
+UINT32 GenomeLen;
+UINT32 Idx;
+UINT64 Cells;
+UINT64 TotCells;
+unsigned long Secs;
+unsigned long USecs;
+double PassSecs[2];
+double TotSecs[2];
+int NumDiffs;
+int NumUnbounded;
+etSeqBase *pGenome;
+etSeqBase *pProbe;
+etSeqBase *pTarg;
+tsSSWCell *pPeakCell;
+tsSSWCell PeakCells[2];
+bool bPeakCells[2];
+CSSW *pSW;
+CStopWatch PassTimer;
+
+// contained targets are simulated from up to MaxLen + 200 source bases, simulated sequences can be at most double their source length
+MaxTargLen = ((UINT32)MaxLen + 200) * 2;
+GenomeLen = (UINT32)MaxLen * 3;
+pGenome = new etSeqBase [GenomeLen];
+pProbe = new etSeqBase [MaxTargLen];
+pTarg = new etSeqBase [MaxTargLen];
+if(pGenome == NULL || pProbe == NULL || pTarg == NULL || (pSW = new CSSW) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchSW: unable to allocate memory for simulated sequences");
+	if(pGenome != NULL)
+		delete[] pGenome;
+	if(pProbe != NULL)
+		delete[] pProbe;
+	if(pTarg != NULL)
+		delete[] pTarg;
+	return(eBSFerrMem);
+	}
+
+// same scoring and anchoring as used when error correcting reads
+if(!pSW->SetScores(cDfltSWMatchScore,cDfltSWMismatchPenalty,cDfltSWGapOpenPenalty,cDfltSWGapExtnPenalty,cDfltSWProgExtnLen,min(63,cDfltSWProgExtnLen+3),cAnchorLen) ||
+	!pSW->SetCPScores(cDfltSWMatchScore,cDfltSWMismatchPenalty,cDfltSWGapOpenPenalty,cDfltSWGapExtnPenalty) ||
+	!pSW->SetMaxInitiatePathOfs(MaxInitiatePathOfs) ||
+	!pSW->PreAllocMaxTargLen(MaxTargLen + 100,MaxTargLen + 100))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchSW: unable to initialise SW instance");
+	delete pSW;
+	delete[] pGenome;
+	delete[] pProbe;
+	delete[] pTarg;
+	return(eBSFerrInternal);
+	}
+
+TRandomCombined<CRandomMother,CRandomMersenne> RG(Seed);
+for(Idx = 0; Idx < GenomeLen; Idx++)
+	pGenome[Idx] = (etSeqBase)RG.IRandom(0,3);
+
+Rslt = eBSFSuccess;
+NumDiffs = 0;
+NumUnbounded = 0;
+TotCells = 0;
+TotSecs[0] = TotSecs[1] = 0.0;
+for(PairIdx = 0; PairIdx < NumPairs; PairIdx++)
+	{
+	// probe is simulated from the genome starting at MaxLen, target relative to the probe according to the pair class
+	PairClass = PairIdx % eSWBPNumClasses;
+	PairErrRate = PairClass == eSWBPHighErr ? min(cMaxSWBenchErrRate,ErrRate * 2) : ErrRate;
+	ProbeSrcLen = RG.IRandom(MinLen,MaxLen);
+	ProbeLen = SimPacBioSeq(&RG,&pGenome[MaxLen],ProbeSrcLen,PairErrRate,pProbe);
+	switch(PairClass) {		// Diag is the simulated diagonal (target offset - probe offset) along which the pair aligns
+		case eSWBPContained:
+			TargSrcLen = ProbeSrcLen + 200;
+			TargLen = SimPacBioSeq(&RG,&pGenome[MaxLen - 100],TargSrcLen,PairErrRate,pTarg);
+			Diag = 100;
+			break;
+		case eSWBPOverlap:
+		case eSWBPHighErr:
+			OverlapLen = (ProbeSrcLen * RG.IRandom(30,90)) / 100;
+			TargSrcLen = RG.IRandom(MinLen,MaxLen);
+			TargLen = SimPacBioSeq(&RG,&pGenome[MaxLen + ProbeSrcLen - OverlapLen],TargSrcLen,PairErrRate,pTarg);
+			Diag = OverlapLen - ProbeSrcLen;
+			break;
+		default:				// unrelated
+			TargLen = RG.IRandom(MinLen,MaxLen);
+			for(Idx = 0; Idx < TargLen; Idx++)
+				pTarg[Idx] = (etSeqBase)RG.IRandom(0,3);
+			Diag = 0;
+			break;
+		}
+
+	if(!pSW->SetProbe(ProbeLen,pProbe) || !pSW->SetTarg(TargLen,pTarg) || pSW->SetAlignRange(0,0,0,0) < eBSFSuccess)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchSW: unable to set probe and target for pair %d",PairIdx+1);
+		Rslt = eBSFerrInternal;
+		break;
+		}
+	if(bBanded)
+		{
+		BandMargin = cSWBenchBandMargin + (int)(min(ProbeLen,TargLen) / 50);
+		if(pSW->SetAlignBand(Diag - BandMargin,Diag + BandMargin,cSWBenchXDropScore) < eBSFSuccess)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"BenchSW: unable to set alignment band for pair %d",PairIdx+1);
+			Rslt = eBSFerrInternal;
+			break;
+			}
+		}
+	Cells = pSW->AlignCells();
+	TotCells += Cells;
+	PassSecs[0] = PassSecs[1] = 0.0;
+	bPeakCells[0] = bPeakCells[1] = false;
+	StripedPeakScore = -1;
+	for(PassIdx = 0; PassIdx < 2; PassIdx++)	// pass 0 is with the striped score only pass, pass 1 without
+		{
+		if((PassIdx == 0 && PMode == eSWBenchFullDP) || (PassIdx == 1 && PMode == eSWBenchStriped))
+			continue;
+		pSW->SetStripedScore(PassIdx == 0 ? true : false,bBanded);
+		PassTimer.Reset();
+		PassTimer.Start();
+		pPeakCell = pSW->Align(NULL,MaxTargLen + 100);
+		PassTimer.Stop();
+		Secs = PassTimer.ReadUSecs(&USecs);
+		PassSecs[PassIdx] = (double)Secs + (double)USecs / 1000000.0;
+		TotSecs[PassIdx] += PassSecs[PassIdx];
+		if(pPeakCell != NULL)
+			{
+			PeakCells[PassIdx] = *pPeakCell;
+			bPeakCells[PassIdx] = true;
+			}
+		if(PassIdx == 0 && !pSW->GetStripedPeak(&StripedPeakScore))		// striped pass may not have been used, e.g. too few cells
+			StripedPeakScore = -1;
+		if(PassIdx == 0 && StripedPeakScore >= 0 && pPeakCell != NULL && pPeakCell->PeakScore > StripedPeakScore)
+			{
+			NumUnbounded += 1;
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"BenchSW: pair %d (%s) alignment peak score %d is above striped score only pass peak score %d",
+								PairIdx+1,pszPairClasses[PairClass],pPeakCell->PeakScore,StripedPeakScore);
+			}
+		}
+
+	if(PMode == eSWBenchCompare && (bPeakCells[0] != bPeakCells[1] || (bPeakCells[0] && !SameSWCell(&PeakCells[0],&PeakCells[1]))))
+		{
+		NumDiffs += 1;
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"BenchSW: pair %d (%s) alignments differ with and without striped score only pass",PairIdx+1,pszPairClasses[PairClass]);
+		}
+
+	pPeakCell = bPeakCells[0] ? &PeakCells[0] : (bPeakCells[1] ? &PeakCells[1] : NULL);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Pair %d (%s) probe %u target %u: peak %u..%u score %d exacts %u, striped peak score %d, striped %1.3f secs, full %1.3f secs",
+					PairIdx+1,pszPairClasses[PairClass],ProbeLen,TargLen,
+					pPeakCell == NULL ? 0 : pPeakCell->StartPOfs,pPeakCell == NULL ? 0 : pPeakCell->EndPOfs,
+					pPeakCell == NULL ? 0 : pPeakCell->PeakScore,pPeakCell == NULL ? 0 : pPeakCell->NumExacts,
+					StripedPeakScore,PassSecs[0],PassSecs[1]);
+	}
+
+if(Rslt == eBSFSuccess)
+	{
+	if(PMode != eSWBenchFullDP)
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"With striped score only pass: %1.3f secs, %1.2f Mcells/sec",TotSecs[0],TotSecs[0] > 0.0 ? (double)TotCells / (TotSecs[0] * 1000000.0) : 0.0);
+	if(PMode != eSWBenchStriped)
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Without striped score only pass: %1.3f secs, %1.2f Mcells/sec",TotSecs[1],TotSecs[1] > 0.0 ? (double)TotCells / (TotSecs[1] * 1000000.0) : 0.0);
+	if(PMode == eSWBenchCompare)
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Alignments differing with and without striped score only pass: %d of %d",NumDiffs,NumPairs);
+		if(NumDiffs)
+			Rslt = eBSFerrInternal;
+		}
+	if(PMode != eSWBenchFullDP)
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Alignments scoring above the striped score only pass peak score: %d of %d",NumUnbounded,NumPairs);
+		if(NumUnbounded)
+			Rslt = eBSFerrInternal;
+		}
+	}
+
+delete pSW;
+delete[] pGenome;
+delete[] pProbe;
+delete[] pTarg;
+return(Rslt);
+}
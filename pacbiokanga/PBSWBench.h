@@ -0,0 +1,27 @@
+#pragma once
+
+const int cDfltSWBenchPairs = 16;			// default number of simulated probe and target pairs to align
+const int cMaxSWBenchPairs = 10000;			// can align at most this many simulated pairs
+const int cDfltSWBenchMinLen = 4000;		// default minimum simulated sequence length
+const int cDfltSWBenchMaxLen = 8000;		// default maximum simulated sequence length
+const int cMinSWBenchLen = 500;				// simulated sequences must be at least this length
+const int cMaxSWBenchLen = 50000;			// simulated sequences can be at most this length
+const int cDfltSWBenchErrRate = 12;			// default simulated PacBio error rate (percentage), 60% of errors are InDels
+const int cMaxSWBenchErrRate = 30;			// error rate can be at most this percentage
+const int cMaxSWBenchInitiatePathOfs = 10000;	// SW paths can be required to start within at most this many bp
+const int cSWBenchBandMargin = 250;			// banded alignments are to the simulated diagonal extended by this margin plus 1/50th of the shorter sequence length, as when error correcting reads
+const int cSWBenchXDropScore = 500;			// banded alignment paths are terminated if their score drops by more than this below the peak path score
+
+typedef enum TAG_eSWBenchMode {
+	eSWBenchCompare = 0,					// align each pair with and without the striped score only pass, checking alignments are identical
+	eSWBenchStriped,						// align only with the striped score only pass
+	eSWBenchFullDP							// align only without the striped score only pass
+	} etSWBenchMode;
+
+typedef enum TAG_eSWBenchPairClass {
+	eSWBPContained = 0,						// probe is contained within the target
+	eSWBPOverlap,							// probe 3' end overlaps target 5' end
+	eSWBPUnrelated,							// target is unrelated to probe
+	eSWBPHighErr,							// probe 3' end overlaps target 5' end, both with double the error rate
+	eSWBPNumClasses							// placeholder for number of pair classes
+	} etSWBenchPairClass;
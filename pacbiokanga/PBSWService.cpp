@@ -65,7 +65,7 @@ ProcSWService(int argc, char** argv)
 	struct arg_int *maxservmemgb = arg_int0("M", "mem", "<int>", "max allocatable physical memory (GB) available for all service instances at 6GB per service instance (0 - defaults to 75% host memory, max of 1000)");
 	struct arg_int *maxconnwait = arg_int0("w", "wait", "<int>", "wait for at most this many minutes for service requester connection (0 - defaults to 15min, max of 240)");
 
-	struct arg_str  *host = arg_str0("u", "rmihost", "<string>", "Connect to this service requester host name or IPv4/IPv5 address (default 127.0.0.1)");
+	struct arg_str  *host = arg_str0("u", "rmihost", "<string>", "Connect to this service requester host name or IPv4/IPv5 address (default 127.0.0.1), or a local socket path (e.g. /tmp/bks.sock) if co-located");
 	struct arg_str  *service = arg_str0("U", "rmiservice", "<string>", "Connect to service requester on this service name or port (default 43123)");
 
 	struct arg_end *end = arg_end(100);
@@ -15,9 +15,16 @@
 
 #include "SSW.h"
 
+// striped score only pass uses SSE2 16bit lanes, always available on x64
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define SSW_STRIPED_SSE2 1
+#include <emmintrin.h>
+#endif
+
 CSSW::CSSW()
 {
 m_pAllocdCells = NULL;
+m_pStripedBuff = NULL;
 m_pProbe = NULL;
 m_pTarg = NULL;
 m_pAllocdTracebacks = NULL;
@@ -107,6 +114,9 @@ if(m_pszConsensusBuff != NULL)
 
 if(m_pConsConfSeq != NULL)
 	delete m_pConsConfSeq;
+
+if(m_pStripedBuff != NULL)
+	delete []m_pStripedBuff;
 }
 
 void 
@@ -179,6 +189,13 @@ if(m_pAllWinScores != NULL)
 	m_pAllWinScores = NULL;
 	}
 
+if(m_pStripedBuff != NULL)
+	{
+	delete []m_pStripedBuff;
+	m_pStripedBuff = NULL;
+	}
+m_AllocdStripedSize = 0;
+
 if(m_pProbe != NULL)
 	{
 	delete m_pProbe;
@@ -260,6 +277,15 @@ m_DlyGapExtn = cSSWDfltGapOpenPenalty;
 m_ProgPenaliseGapExtn = cSSWDfltProgPenaliseGapExtn;
 m_AnchorLen = cSSWDfltAnchorLen;
 m_MaxInitiatePathOfs = cMaxInitiatePathOfs;
+m_bAlignBanded = false;
+m_BandMinDiag = 0;
+m_BandMaxDiag = 0;
+m_XDropScore = 0;
+m_bStripedScore = true;
+m_bStripedScoreBanded = false;
+m_StripedPeakScore = -1;
+m_StripedPeakPOfs = 0;
+m_StripedPeakTOfs = 0;
 m_MinNumExactMatches = cMinNumExactMatches;
 m_MaxTopNPeakMatches = 0;
 m_NumTopNPeakMatches = 0;
@@ -286,6 +312,31 @@ m_MinNumExactMatches = MinNumExactMatches;
 return(true);
 }
 
+bool 
+CSSW::SetStripedScore(bool bStripedScore,		// narrow alignments with a striped score only pass, false to disable (used when benchmarking)
+					bool bBanded)			// also narrow banded alignments, these are usually already narrowed by X-drop path termination
+{
+m_bStripedScore = bStripedScore;
+m_bStripedScoreBanded = bStripedScore && bBanded;
+return(true);
+}
+
+bool											// false if striped score only pass was not used by the last Align()
+CSSW::GetStripedPeak(INT32 *pPeakScore,			// returned striped pass peak score, bounds the peak score of any path in the last Align()
+				UINT32 *pPeakPOfs,				// peak scoring cell is at this probe offset (1..n), 0 if no cell could score
+				UINT32 *pPeakTOfs)				// peak scoring cell is at this target offset (1..n), 0 if no cell could score
+{
+if(m_StripedPeakScore < 0)
+	return(false);
+if(pPeakScore != NULL)
+	*pPeakScore = m_StripedPeakScore;
+if(pPeakPOfs != NULL)
+	*pPeakPOfs = m_StripedPeakPOfs;
+if(pPeakTOfs != NULL)
+	*pPeakTOfs = m_StripedPeakTOfs;
+return(true);
+}
+
 bool 
 CSSW::SetTopNPeakMatches(int MaxTopNPeakMatches)		// can process for at most this many peak matches in any probe vs target SW alignment
 {
@@ -406,6 +457,7 @@ bRslt = CombinedTargAlign(pAlignPars->PMode,pAlignPars->NumTargSeqs,pAlignPars->
 								pAlignPars->TargSeqLen,pAlignPars->pTargSeq,
 								pAlignPars->ProbeStartRelOfs,pAlignPars->TargStartRelOfs,pAlignPars->ProbeRelLen,pAlignPars->TargRelLen,
 								pAlignPars->OverlapFloat,pAlignPars->MaxArtefactDev,pAlignPars->MinOverlapLen,pAlignPars->MaxOverlapLen,
+								pAlignPars->BandMinDiag,pAlignPars->BandMaxDiag,pAlignPars->XDropScore,
 								&RetProcPhase,&ErrRslt,
 								&Class,&PeakMatchesCell,&ProbeAlignLength,&TargAlignLength,&bProvOverlapping,&bProvArtefact,&bProvContained,&bAddedMultiAlignment);
 pAlignRet->ErrRslt = ErrRslt;
@@ -441,6 +493,9 @@ CSSW::CombinedTargAlign(UINT8 PMode,              // processing mode: 0 error co
 						UINT32 MaxArtefactDev,		// classify overlaps as artefactual if sliding window of 500bp over any overlap deviates by more than this percentage from the overlap mean
 						UINT32 MinOverlapLen,       // minimum accepted overlap length
 						UINT32 MaxOverlapLen,      // max expected overlap length
+						INT32 BandMinDiag,			// if BandMinDiag < BandMaxDiag then only aligning within band of diagonals (relative target offset - relative probe offset) from BandMinDiag
+						INT32 BandMaxDiag,			// through to BandMaxDiag
+						INT32 XDropScore,			// and banded alignment paths are terminated if their score drops by more than this below the peak path score
 						UINT8 *pRetProcPhase,			// processing phase completed
 						INT32 *pErrRslt,				// result returned by that processing phase
 						UINT8 *pRetClass,			// returned overlap classification
@@ -498,6 +553,9 @@ if((Rslt = SetAlignRange(ProbeStartRelOfs,TargStartRelOfs,ProbeRelLen,TargRelLen
 	return(false);
 	}
 
+if(BandMinDiag < BandMaxDiag)		// band is only an optimisation, if band is outside of the alignment range then alignment is unbanded
+	SetAlignBand(BandMinDiag,BandMaxDiag,XDropScore);
+
 pPeakMatchesCell = Align(NULL,MaxOverlapLen);
 
 if(pPeakMatchesCell != NULL && pPeakMatchesCell->NumMatches >= (MinOverlapLen/2) &&
@@ -985,9 +1043,416 @@ m_ProbeStartRelOfs = ProbeStartRelOfs;
 m_TargStartRelOfs = TargStartRelOfs;
 m_ProbeRelLen = ProbeRelLen;
 m_TargRelLen = TargRelLen;
+m_bAlignBanded = false;			// any band was relative to the previous alignment range
+return(eBSFSuccess);
+}
+
+// SetAlignBand
+// Restrict Align() to cells within a band of diagonals, relative to the current alignment range as set by SetAlignRange(), and terminate
+// paths whose score has dropped by more than XDropScore below the peak score of any path (X-drop); the band is cleared by SetAlignRange()
+int
+CSSW::SetAlignBand(INT32 BandMinDiag,			// only align cells within band of diagonals (relative target offset - relative probe offset) starting from this diagonal
+					 INT32 BandMaxDiag,			// through to this diagonal inclusive
+					 int XDropScore)			// terminating paths if their score drops by more than this below the peak path score
+{
+INT32 ProbeRelLen;
+INT32 TargRelLen;
+if(m_ProbeLen < cSSWMinProbeOrTargLen || m_TargLen < cSSWMinProbeOrTargLen)
+	return(eBSFerrParams);
+ProbeRelLen = (INT32)(m_ProbeRelLen == 0 ? m_ProbeLen - m_ProbeStartRelOfs : m_ProbeRelLen);
+TargRelLen = (INT32)(m_TargRelLen == 0 ? m_TargLen - m_TargStartRelOfs : m_TargRelLen);
+if(BandMinDiag > BandMaxDiag || BandMaxDiag <= -ProbeRelLen || BandMinDiag >= TargRelLen || XDropScore < 1 || XDropScore > cMaxXDropScore)
+	return(eBSFerrParams);
+m_BandMinDiag = BandMinDiag;
+m_BandMaxDiag = BandMaxDiag;
+m_XDropScore = XDropScore;
+m_bAlignBanded = true;
 return(eBSFSuccess);
 }
 
+// AlignCells
+// Returns the number of cells which Align() would process over the current alignment range, if banded then only those cells within the band
+UINT64
+CSSW::AlignCells(void)
+{
+UINT64 ProbeRelLen;
+UINT64 TargRelLen;
+ProbeRelLen = m_ProbeRelLen == 0 ? m_ProbeLen - m_ProbeStartRelOfs : m_ProbeRelLen;
+TargRelLen = m_TargRelLen == 0 ? m_TargLen - m_TargStartRelOfs : m_TargRelLen;
+if(m_bAlignBanded)
+	TargRelLen = min(TargRelLen,(UINT64)((INT64)m_BandMaxDiag - m_BandMinDiag + 1));
+return(ProbeRelLen * TargRelLen);
+}
+
+#ifdef SSW_STRIPED_SSE2
+const INT16 cStripedDead = -32768;			// striped cells which are unable to score are set to this value
+const UINT32 cStripedLanes = 8;				// striped score only pass processes this many 16bit lanes in each vector
+const UINT32 cStripedSegLen = 32;			// and target is processed in blocks of cStripedLanes * cStripedSegLen columns
+const UINT32 cStripedMaxWorkMult = 2;		// striped score only pass is abandoned after processing more than this multiple of the cells which Align() would process
+
+// StripedProfile
+// Generate striped profile of scores for ProbeBase against each target base in a block, target bases at offsets past MaxTOfs are scored as cStripedDead 
+static void
+StripedProfile(INT16 *pProfile,			// striped profile to generate
+				etSeqBase ProbeBase,	// profiling for this probe base
+				etSeqBase *pTarg,		// against these target bases
+				UINT32 TargLen,			// target length
+				UINT32 BlockTOfs,		// block starts at this target offset
+				UINT32 MaxTOfs,			// target bases after this offset are scored as cStripedDead
+				INT16 MatchScore,		// score if probe and target bases match
+				INT16 MismatchScore)	// score if probe and target bases mismatch
+{
+UINT32 Seg;
+UINT32 Lane;
+UINT32 TOfs;
+for(Seg = 0; Seg < cStripedSegLen; Seg++)
+	for(Lane = 0; Lane < cStripedLanes; Lane++)
+		{
+		TOfs = BlockTOfs + (Lane * cStripedSegLen) + Seg;
+		if(TOfs >= TargLen || TOfs > MaxTOfs)
+			*pProfile++ = cStripedDead;
+		else
+			*pProfile++ = (pTarg[TOfs] & ~cRptMskFlg) == ProbeBase ? MatchScore : MismatchScore;
+		}
+}
+
+// StripedLive
+// Cells with scores of 0 or less can't be extended by Align() so these are set as being dead
+static inline __m128i
+StripedLive(__m128i Scores)
+{
+__m128i Live = _mm_cmpgt_epi16(Scores,_mm_setzero_si128());
+return(_mm_or_si128(_mm_and_si128(Live,Scores),_mm_andnot_si128(Live,_mm_set1_epi16(cStripedDead))));
+}
+
+// StripedMax
+// Returns maximum score over all lanes
+static inline int
+StripedMax(__m128i Scores)
+{
+Scores = _mm_max_epi16(Scores,_mm_srli_si128(Scores,8));
+Scores = _mm_max_epi16(Scores,_mm_srli_si128(Scores,4));
+Scores = _mm_max_epi16(Scores,_mm_srli_si128(Scores,2));
+return((INT16)_mm_extract_epi16(Scores,0));
+}
+#endif
+
+// StripedScore
+// Farrar style striped score only pass over the current probe and target alignment range using 16bit lanes
+// Scores are an upper bound on the scores of the corresponding cells in Align() - paths can only be started within m_MaxInitiatePathOfs,
+// mismatches are scored as the lesser of mismatch or gap open penalties, and delayed or progressive gap extension penalties
+// are scored as the gap extension penalty; cells which can't score above 0 here can't be extended by Align() so Align() only needs
+// to process cells up to the last probe and target offsets at which cells are still able to score
+// The target is processed in blocks of 256 columns, with the scores in the last column of each block bounding the next block, so that
+// rows of a block in which no cells are able to score are skipped
+// If Align() is banded then rows of a block not intersecting the band are skipped, the remaining block rows are processed in full so bounding a superset of the banded cells
+// Pass is abandoned with eBSFerrMaxEntries if more than cStripedMaxWorkMult times the cells which Align() would process have been processed,
+// only expected with narrow bands where the 256 column blocks are mostly outside of the band
+int
+CSSW::StripedScore(INT32 *pPeakScore,			// returned peak score, 0 if no cell could score
+				 UINT32 *pPeakPOfs,				// peak scoring cell is at this probe relative offset
+				 UINT32 *pPeakTOfs,				// peak scoring cell is at this target relative offset
+				 UINT32 *pLastLivePOfs,			// no cell past this probe relative offset is able to score
+				 UINT32 *pLastLiveTOfs)			// no cell past this target relative offset is able to score
+{
+#ifdef SSW_STRIPED_SSE2
+UINT32 ProbeRelLen;
+UINT32 TargRelLen;
+UINT32 BlockTOfs;
+UINT32 TOfs;
+UINT32 Seg;
+UINT32 Lane;
+UINT32 IdxP;
+UINT32 MaxStartOfs;
+INT32 InLastLivePOfs;
+INT32 OutLastLivePOfs;
+INT64 BandLo;
+INT64 BandHi;
+UINT64 WorkBlockRows;
+UINT64 MaxWorkBlockRows;
+int LazyIter;
+int RowMax;
+int Mask;
+INT16 LeftH;
+INT16 LeftF;
+INT16 PrevLeftH;
+INT16 LastH;
+INT16 LastF;
+INT32 PeakScore;
+UINT32 PeakPOfs;
+UINT32 PeakTOfs;
+UINT32 LastLivePOfs;
+UINT32 LastLiveTOfs;
+size_t memreq;
+bool bStartRow;
+bool bPrevRowDead;
+bool bProfiled[16];
+bool bStartProfiled[16];
+etSeqBase ProbeBase;
+etSeqBase *pProbe;
+etSeqBase *pTarg;
+INT16 *pBoundH;
+INT16 *pBoundF;
+__m128i *pVects;
+__m128i *pProfiles;
+__m128i *pStartProfiles;
+__m128i *pProfile;
+__m128i *pStartProfile;
+__m128i *pHStore;
+__m128i *pHLoad;
+__m128i *pHSwap;
+__m128i *pE;
+__m128i *pLive;
+__m128i vH;
+__m128i vE;
+__m128i vF;
+__m128i vT;
+__m128i vFLast;
+__m128i vRowMax;
+__m128i vDead;
+__m128i vGapOpen;
+__m128i vGapExtn;
+
+if(m_ProbeRelLen == 0)
+	ProbeRelLen = m_ProbeLen - m_ProbeStartRelOfs;	
+else
+	ProbeRelLen = m_ProbeRelLen;
+if(m_TargRelLen == 0)
+	TargRelLen = m_TargLen - m_TargStartRelOfs;
+else
+	TargRelLen = m_TargRelLen;
+if(ProbeRelLen == 0 || TargRelLen == 0 || ProbeRelLen >= 0x7fffffff || (m_ProbeStartRelOfs + ProbeRelLen) > m_ProbeLen || (m_TargStartRelOfs + TargRelLen) > m_TargLen)
+	return(eBSFerrParams);
+
+// scores could overflow 16bit lanes if the whole alignment was matching
+if(((INT64)min(ProbeRelLen,TargRelLen) * m_MatchScore) >= 32000)
+	return(eBSFerrNumRange);
+
+// 16 profiles, 16 start profiles, H store and load, E, and live vectors for a block plus the H and F bounding scores for each probe base
+memreq = (cStripedSegLen * (32 + 4) * sizeof(__m128i)) + sizeof(__m128i) + ((size_t)ProbeRelLen * 2 * sizeof(INT16));
+if(m_pStripedBuff == NULL || m_AllocdStripedSize < memreq)
+	{
+	if(m_pStripedBuff != NULL)
+		delete []m_pStripedBuff;
+	m_AllocdStripedSize = max(memreq,(size_t)(cStripedSegLen * (32 + 4) * sizeof(__m128i)) + sizeof(__m128i) + (250000 * 2 * sizeof(INT16)));	// always alloc for at least 250Kbp, reduces the potential for any subsequent reallocs
+	if((m_pStripedBuff = new UINT8 [m_AllocdStripedSize]) == NULL)
+		{
+		m_AllocdStripedSize = 0;
+		return(eBSFerrMem);
+		}
+	}
+pVects = (__m128i *)(((size_t)m_pStripedBuff + sizeof(__m128i) - 1) & ~(sizeof(__m128i) - 1));
+pProfiles = pVects;
+pStartProfiles = &pVects[cStripedSegLen * 16];
+pHStore = &pVects[cStripedSegLen * 32];
+pHLoad = &pVects[cStripedSegLen * 33];
+pE = &pVects[cStripedSegLen * 34];
+pLive = &pVects[cStripedSegLen * 35];
+pBoundH = (INT16 *)&pVects[cStripedSegLen * 36];
+pBoundF = &pBoundH[ProbeRelLen];
+
+vDead = _mm_set1_epi16(cStripedDead);
+vGapOpen = _mm_set1_epi16((INT16)m_GapOpenPenalty);
+// gap extension penalties are delayed or progressively increased by Align(), and gap extensions are never scored lower than gap openings
+vGapExtn = _mm_set1_epi16((INT16)max((m_DlyGapExtn <= 2 ? m_GapExtnPenalty : 0),m_GapOpenPenalty));
+
+MaxStartOfs = (UINT32)m_MaxInitiatePathOfs;
+PeakScore = 0;
+PeakPOfs = 0;
+PeakTOfs = 0;
+LastLivePOfs = 0;
+LastLiveTOfs = 0;
+InLastLivePOfs = -1;			// no cells are bounding the 1st block
+WorkBlockRows = 0;
+MaxWorkBlockRows = (AlignCells() * cStripedMaxWorkMult) / (cStripedLanes * cStripedSegLen);
+pTarg = &m_pTarg[m_TargStartRelOfs];
+for(BlockTOfs = 0; BlockTOfs < TargRelLen; BlockTOfs += cStripedLanes * cStripedSegLen)
+	{
+	if(BlockTOfs > MaxStartOfs && InLastLivePOfs < 0)	// no paths can be started in this or any subsequent block, nor are any paths extending into this block
+		break;
+
+	for(Seg = 0; Seg < cStripedSegLen; Seg++)
+		{
+		pHStore[Seg] = vDead;
+		pE[Seg] = vDead;
+		pLive[Seg] = _mm_setzero_si128();
+		}
+	memset(bProfiled,0,sizeof(bProfiled));
+	memset(bStartProfiled,0,sizeof(bStartProfiled));
+	bPrevRowDead = true;
+	PrevLeftH = cStripedDead;
+	OutLastLivePOfs = -1;
+	pProbe = &m_pProbe[m_ProbeStartRelOfs];
+	for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
+		{
+		if((ProbeBase = *pProbe++ & ~cRptMskFlg) > 15)
+			return(eBSFErrBase);
+		if((INT32)IdxP <= InLastLivePOfs)
+			{
+			LeftH = pBoundH[IdxP];
+			LeftF = pBoundF[IdxP];
+			}
+		else
+			{
+			LeftH = cStripedDead;
+			LeftF = cStripedDead;
+			}
+		if(m_bAlignBanded)		// band cells in this row are from BandLo through to BandHi inclusive
+			{
+			BandLo = (INT64)IdxP + m_BandMinDiag;
+			BandHi = (INT64)IdxP + m_BandMaxDiag;
+			if(BandLo >= (INT64)min(TargRelLen,BlockTOfs + (cStripedLanes * cStripedSegLen)))	// band has moved past this block in this and all subsequent rows
+				break;
+			if(BandHi < (INT64)BlockTOfs)		// band yet to reach this block, Align() won't be processing any cells in this block row
+				{
+				PrevLeftH = LeftH;
+				pBoundH[IdxP] = cStripedDead;
+				pBoundF[IdxP] = cStripedDead;
+				continue;
+				}
+			}
+
+		bStartRow = IdxP <= MaxStartOfs && BlockTOfs <= MaxStartOfs;	// paths can only be started within MaxStartOfs on both probe and target
+
+		// if no cells in previous row were able to score, and none can be started or extended from previous block, then no cells in this row can score
+		if(bPrevRowDead && !bStartRow && LeftF == cStripedDead && PrevLeftH == cStripedDead)
+			{
+			if((INT32)IdxP > InLastLivePOfs && (IdxP >= MaxStartOfs || BlockTOfs > MaxStartOfs))	// nor in any subsequent row
+				break;
+			PrevLeftH = LeftH;
+			pBoundH[IdxP] = cStripedDead;
+			pBoundF[IdxP] = cStripedDead;
+			continue;
+			}
+		if(++WorkBlockRows > MaxWorkBlockRows)
+			return(eBSFerrMaxEntries);
+
+		pProfile = &pProfiles[ProbeBase * cStripedSegLen];
+		if(!bProfiled[ProbeBase])
+			{
+			StripedProfile((INT16 *)pProfile,ProbeBase,pTarg,TargRelLen,BlockTOfs,TargRelLen,(INT16)m_MatchScore,(INT16)max(m_MismatchPenalty,m_GapOpenPenalty));
+			bProfiled[ProbeBase] = true;
+			}
+		pStartProfile = NULL;
+		if(bStartRow)
+			{
+			pStartProfile = &pStartProfiles[ProbeBase * cStripedSegLen];
+			if(!bStartProfiled[ProbeBase])
+				{
+				StripedProfile((INT16 *)pStartProfile,ProbeBase,pTarg,TargRelLen,BlockTOfs,MaxStartOfs,(INT16)m_MatchScore,cStripedDead);
+				bStartProfiled[ProbeBase] = true;
+				}
+			}
+
+		// diagonal into 1st segment is from last segment in previous lane, or from the previous block for the 1st lane 
+		vH = _mm_insert_epi16(_mm_slli_si128(pHStore[cStripedSegLen - 1],2),PrevLeftH,0);
+		vF = _mm_insert_epi16(vDead,LeftF,0);
+		vRowMax = vDead;
+		vFLast = vDead;
+		pHSwap = pHLoad;
+		pHLoad = pHStore;
+		pHStore = pHSwap;
+		for(Seg = 0; Seg < cStripedSegLen; Seg++)
+			{
+			if(Seg == cStripedSegLen - 1)
+				vFLast = vF;
+			vH = _mm_adds_epi16(vH,pProfile[Seg]);
+			if(pStartProfile != NULL)
+				vH = _mm_max_epi16(vH,pStartProfile[Seg]);
+			vE = pE[Seg];
+			vH = _mm_max_epi16(vH,vE);
+			vH = StripedLive(_mm_max_epi16(vH,vF));
+			pHStore[Seg] = vH;
+			vRowMax = _mm_max_epi16(vRowMax,vH);
+			vT = StripedLive(_mm_adds_epi16(vH,vGapOpen));
+			pE[Seg] = StripedLive(_mm_max_epi16(_mm_adds_epi16(vE,vGapExtn),vT));
+			vF = StripedLive(_mm_max_epi16(_mm_adds_epi16(vF,vGapExtn),vT));
+			vH = pHLoad[Seg];
+			}
+
+		// lazy F, gaps may be extending across lanes
+		for(LazyIter = 0; LazyIter < (int)cStripedLanes; LazyIter++)
+			{
+			vF = _mm_insert_epi16(_mm_slli_si128(vF,2),cStripedDead,0);
+			for(Seg = 0; Seg < cStripedSegLen; Seg++)
+				{
+				if(Seg == cStripedSegLen - 1)
+					vFLast = _mm_max_epi16(vFLast,vF);
+				vH = _mm_max_epi16(pHStore[Seg],vF);
+				pHStore[Seg] = vH;
+				vRowMax = _mm_max_epi16(vRowMax,vH);
+				vT = StripedLive(_mm_adds_epi16(vH,vGapOpen));
+				pE[Seg] = _mm_max_epi16(pE[Seg],vT);
+				vF = StripedLive(_mm_adds_epi16(vF,vGapExtn));
+				if(!_mm_movemask_epi8(_mm_cmpgt_epi16(vF,vT)))
+					break;
+				}
+			if(Seg < cStripedSegLen)
+				break;
+			}
+
+		// scores in the last column of this block bound the next block
+		LastH = (INT16)_mm_extract_epi16(pHStore[cStripedSegLen - 1],cStripedLanes - 1);
+		LastF = (INT16)_mm_extract_epi16(vFLast,cStripedLanes - 1);
+		LastF = (INT16)max(max((int)LastH + m_GapOpenPenalty,(int)LastF + (INT16)_mm_extract_epi16(vGapExtn,0)),0);
+		pBoundH[IdxP] = LastH;
+		pBoundF[IdxP] = LastF > 0 ? LastF : cStripedDead;
+		if(LastH > 0 || LastF > 0)
+			OutLastLivePOfs = IdxP;
+		PrevLeftH = LeftH;
+
+		if((RowMax = StripedMax(vRowMax)) <= 0)		// no cell in this row is able to score
+			{
+			bPrevRowDead = true;
+			continue;
+			}
+		bPrevRowDead = false;
+		for(Seg = 0; Seg < cStripedSegLen; Seg++)
+			pLive[Seg] = _mm_or_si128(pLive[Seg],_mm_cmpgt_epi16(pHStore[Seg],_mm_setzero_si128()));
+		if(IdxP > LastLivePOfs)
+			LastLivePOfs = IdxP;
+		if(RowMax > PeakScore)
+			{
+			PeakScore = RowMax;
+			PeakPOfs = IdxP;
+			PeakTOfs = TargRelLen;
+			vT = _mm_set1_epi16((INT16)RowMax);
+			for(Seg = 0; Seg < cStripedSegLen; Seg++)
+				{
+				if((Mask = _mm_movemask_epi8(_mm_cmpeq_epi16(pHStore[Seg],vT))) != 0)
+					for(Lane = 0; Lane < cStripedLanes; Lane++)
+						if((Mask & (3 << (Lane * 2))) && (TOfs = BlockTOfs + (Lane * cStripedSegLen) + Seg) < PeakTOfs)
+							PeakTOfs = TOfs;
+				}
+			}
+		}
+
+	for(Seg = 0; Seg < cStripedSegLen; Seg++)
+		{
+		if((Mask = _mm_movemask_epi8(pLive[Seg])) != 0)
+			for(Lane = 0; Lane < cStripedLanes; Lane++)
+				if((Mask & (3 << (Lane * 2))) && (TOfs = BlockTOfs + (Lane * cStripedSegLen) + Seg) < TargRelLen && TOfs > LastLiveTOfs)
+					LastLiveTOfs = TOfs;
+		}
+	InLastLivePOfs = OutLastLivePOfs;
+	}
+
+if(pPeakScore != NULL)
+	*pPeakScore = PeakScore;
+if(pPeakPOfs != NULL)
+	*pPeakPOfs = PeakPOfs;
+if(pPeakTOfs != NULL)
+	*pPeakTOfs = PeakTOfs;
+if(pLastLivePOfs != NULL)
+	*pLastLivePOfs = LastLivePOfs;
+if(pLastLiveTOfs != NULL)
+	*pLastLiveTOfs = LastLiveTOfs;
+return(eBSFSuccess);
+#else
+return(eBSFerrInternal);
+#endif
+}
+
 tsSSWCell *								// smith-waterman style local alignment, returns highest accumulated exact matches cell
 CSSW::Align(tsSSWCell *pPeakScoreCell,	// optionally also return conventional peak scoring cell
 				UINT32 MaxOverlapLen)	// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
@@ -1040,6 +1505,17 @@ tsSSWCell DiagCell;
 bool bNoTracebacks;
 tsSSWTraceback *pTraceback;
 
+INT32 BoundPeakScore;
+UINT32 BoundPeakPOfs;
+UINT32 BoundPeakTOfs;
+UINT32 BoundLastLivePOfs;
+UINT32 BoundLastLiveTOfs;
+
+INT64 BandLo;
+INT64 BandHi;
+int XDropPeakScore;
+bool bRowLive;
+
 if(m_ProbeLen < cSSWMinProbeOrTargLen || m_ProbeLen > cSSWMaxProbeOrTargLen ||  m_TargLen < cSSWMinProbeOrTargLen || m_TargLen > cSSWMaxProbeOrTargLen || MaxOverlapLen > cSSWMaxProbeOrTargLen)
 	return(NULL);	
 
@@ -1061,6 +1537,28 @@ if(m_TargRelLen > m_TargLen || m_ProbeRelLen > m_ProbeLen)
 	return(NULL);
 	}
 
+// striped score only pass bounds the cells which are able to score, no cells past the last of these can be extended so only need to process cells
+// up to these last probe and target offsets; allowing an additional 4 bases so the look ahead for exact matches is unchanged
+// no cell can score above the bounding peak score, if 0 then there are no paths and no cells need be processed
+// banded alignments only if requested, X-drop path termination already ends paths which have stopped scoring so the pass seldom narrows these
+m_StripedPeakScore = -1;
+m_StripedPeakPOfs = 0;
+m_StripedPeakTOfs = 0;
+if(m_bStripedScore && (!m_bAlignBanded || m_bStripedScoreBanded) && AlignCells() >= cMinStripedScoreCells &&
+	StripedScore(&BoundPeakScore,&BoundPeakPOfs,&BoundPeakTOfs,&BoundLastLivePOfs,&BoundLastLiveTOfs) == eBSFSuccess)
+	{
+	m_StripedPeakScore = BoundPeakScore;
+	if(BoundPeakScore > 0)
+		{
+		m_StripedPeakPOfs = m_ProbeStartRelOfs + BoundPeakPOfs + 1;
+		m_StripedPeakTOfs = m_TargStartRelOfs + BoundPeakTOfs + 1;
+		ProbeRelLen = min(ProbeRelLen,BoundLastLivePOfs + 5);
+		TargRelLen = min(TargRelLen,BoundLastLiveTOfs + 5);
+		}
+	else
+		ProbeRelLen = 0;
+	}
+
 memset(&m_PeakMatchesCell,0,sizeof(m_PeakMatchesCell));
 memset(&m_PeakScoreCell,0,sizeof(m_PeakScoreCell));
 
@@ -1095,6 +1593,7 @@ NumCellsChecked = 0;
 LastCheckedIdxT = m_MaxInitiatePathOfs + 10;
 m_UsedTracebacks = 0;
 NxtMinIdxT = 0;
+XDropPeakScore = 0;
 pTraceback = m_pAllocdTracebacks;						// NOTE: NULL if tracebacks not required
 pProbe = &m_pProbe[m_ProbeStartRelOfs];
 for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
@@ -1150,6 +1649,28 @@ for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
 	NxtMinIdxT = 0;
 	memset(&LeftCell, 0, sizeof(tsSSWCell));
 	memset(&DiagCell, 0, sizeof(tsSSWCell));
+	bRowLive = false;
+	if(m_bAlignBanded)		// only processing cells within the band of diagonals
+		{
+		BandLo = (INT64)IdxP + m_BandMinDiag;
+		BandHi = (INT64)IdxP + m_BandMaxDiag + 1;
+		if(BandLo >= (INT64)TargRelLen)	// band has moved past the end of the target
+			break;
+		if(BandHi < (INT64)CurMaxIdxT)
+			CurMaxIdxT = BandHi <= (INT64)CurMinIdxT ? CurMinIdxT : (UINT32)BandHi;
+		if(BandLo > 0)
+			{
+			// cell immediately preceding band is outside of the band in this row, but is the diagonal into the first cell within the band
+			if(BandLo >= (INT64)CurMinIdxT)
+				{
+				LeftCell = m_pAllocdCells[BandLo - 1];
+				CurMinIdxT = (UINT32)BandLo;
+				if(CurMaxIdxT < CurMinIdxT)
+					CurMaxIdxT = CurMinIdxT;
+				}
+			memset(&m_pAllocdCells[BandLo - 1],0,sizeof(tsSSWCell));
+			}
+		}
 	if(CurMinIdxT >= m_AllocdCells || CurMaxIdxT >= m_AllocdCells)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Align: Allocated for %u Cells but CurMinIdxT is %u and CurMaxIdxT is %u",m_AllocdCells,CurMinIdxT,CurMaxIdxT);
@@ -1250,6 +1771,7 @@ for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
 					pTraceback += 1;
 					m_UsedTracebacks += 1;
 					}
+				bRowLive = true;
 				}
 			continue;
 			}
@@ -1436,6 +1958,19 @@ for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
 				}
 			}
 
+		if(m_bAlignBanded)		// X-drop, terminating paths with scores which have dropped too far below the peak score over all paths
+			{
+			if(pCell->CurScore > XDropPeakScore)
+				XDropPeakScore = pCell->CurScore;
+			else
+				if((pCell->CurScore + m_XDropScore) < XDropPeakScore)
+					{
+					memset(pCell,0,sizeof(tsSSWCell));
+					continue;
+					}
+			bRowLive = true;
+			}
+
 
 		if(pCell->NumExacts >= (UINT32)m_MinNumExactMatches && pCell->CurExactLen >= 4) // only interested in putative paths which are terminating with at least 4 exact matches at terminal end - paths needed at least 4 exacts to start
 			{
@@ -1513,6 +2048,9 @@ for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
 			}
 #endif
 		}
+	// if banded and no paths are still being extended, nor can any new paths be started, then alignment has been completed
+	if(m_bAlignBanded && !bRowLive && IdxP >= (UINT32)m_MaxInitiatePathOfs)
+		break;
 	}
 #ifdef _PEAKSCOREACCEPT
 if(pPeakScoreCell != NULL)
@@ -25,6 +25,8 @@ const int cSSWDfltAnchorLen = 4;		// default exactly matching anchors of at leas
 const int cSSWMaxAnchorLen = 100;      // can specify exactly matching anchors of at most this length  
 
 const int cMaxInitiatePathOfs = 250;    // default is to require SW paths to have started within this many bp on either the probe or target - effectively anchoring the SW
+const UINT64 cMinStripedScoreCells = 1000000;	// only narrowing alignments with a striped score only pass if processing at least this many cells
+const int cMaxXDropScore = 10000;		// banded alignments can terminate paths with scores dropped by at most this much below the peak path score
 const int cMinNumExactMatches = 100;     // default is only consider a path as being a peak path once that putative path contains at least this many exactly matching bases
 
 const int cMaxTopNPeakMatches = 100;     // can process for at most this many peak matches in any probe vs target SW alignment
@@ -37,6 +39,7 @@ const UINT32 cMaxMAFBlockLen = (cMaxMAFBlockErrCorLen * 100);	// allowing for mu
 
 const int cMaxProbeSWs = 200;							// explore with SW at most this many probe alignments against target sequences
 const int cMaxConsolidateProbeSWs = 10000;				// when processing for transcripts then allow for many more probe alignments
+const int cMaxSWBatchInvocs = 32;						// a eSWMBatch request can contain at most this many method invocations
 
 // following are the method enumerations used when service providers are utilised
 typedef enum TAG_eSWMethod {
@@ -59,6 +62,7 @@ typedef enum TAG_eSWMethod {
 	eSWMGenMultialignConcensus,	// GenMultialignConcensus
 	eSWMMAlignCols2fasta,		// MAlignCols2fasta
 	eSWMMAlignCols2MFA,			// MAlignCols2MFA
+	eSWMBatch,					// batch of method invocations on the same class instance, processed in order within a single request/response to reduce RMI round trips
 	eSWMPlaceHolder,			// used to mark range of methods
 	} teSWMethod;
 
@@ -198,6 +202,9 @@ typedef struct TAG_sCombinedTargAlignPars {
 	UINT8 TargFlags;		    // bit 7 set if target loaded as a high confidence sequence, bits 0..3 is weighting factor to apply when generating consensus bases
 	UINT32 TargSeqLen;			// target sequence length
 	etSeqBase *pTargSeq;		// target sequence
+	INT32 BandMinDiag;			// if BandMinDiag < BandMaxDiag then only aligning within band of diagonals (relative target offset - relative probe offset) from BandMinDiag
+	INT32 BandMaxDiag;			// through to BandMaxDiag
+	INT32 XDropScore;			// and banded alignment paths are terminated if their score drops by more than this below the peak path score
 } tsCombinedTargAlignPars;
 
 typedef struct TAG_sCombinedTargAlignRet {
@@ -210,6 +217,21 @@ typedef struct TAG_sCombinedTargAlignRet {
 	UINT8 Flags;				// bit 0: set if probe overlapping target, bit 1:set if overlap classified as artefact, bit 2: set if probe contained, bit 3: set if added as a multialignment
 } tsCombinedTargAlignRet;
 
+// eSWMBatch request data is a UINT32 count of invocations followed by that many tsSWBatchInvoc headers, each immediately followed by that invocation's marshalled request data
+typedef struct TAG_sSWBatchInvoc {
+	UINT32 ClassMethodID;		// method to invoke, any teSWMethod except eSWMConstruct, eSWMDestruct and eSWMBatch
+	INT32 MinRslt;				// remaining invocations in batch are not processed if this invocation's result is less than MinRslt
+	UINT32 ReqDataLen;			// marshalled request data following this header is of this length
+} tsSWBatchInvoc;
+
+// eSWMBatch response data is a UINT32 count of invocations processed followed by a tsSWBatchRslt for each of those invocations, in batch order, each immediately followed by that invocation's marshalled response data
+// the index (handle) of an invocation in the batch is used to reference its result
+typedef struct TAG_sSWBatchRslt {
+	UINT32 ClassMethodID;		// method which was invoked
+	INT32 Rslt;					// invocation result
+	UINT32 RespDataLen;			// marshalled response data following this header is of this length
+} tsSWBatchRslt;
+
 #pragma pack()
 
 class CSSW
@@ -247,6 +269,16 @@ class CSSW
 
 	int m_MaxInitiatePathOfs;			// if non-zero then only allow new paths to start if within that offset (0 to disable) on either probe or target - effectively an anchored SW
 
+	bool m_bAlignBanded;				// true if Align() only processing cells within band of diagonals
+	INT32 m_BandMinDiag;				// band of diagonals (relative target offset - relative probe offset) starts from this diagonal
+	INT32 m_BandMaxDiag;				// and ends at this diagonal inclusive
+	int m_XDropScore;					// banded alignment paths terminated if their score drops by more than this below the peak path score
+	bool m_bStripedScore;				// true if Align() is narrowed by a striped score only pass (default), false to always process the full range
+	bool m_bStripedScoreBanded;			// true if banded Align() is also narrowed by the striped score only pass, default is false
+	INT32 m_StripedPeakScore;			// striped score only pass peak score in last Align(), -1 if no striped pass
+	UINT32 m_StripedPeakPOfs;			// striped score only pass peak scoring cell probe offset (1..n)
+	UINT32 m_StripedPeakTOfs;			// striped score only pass peak scoring cell target offset (1..n)
+
 	UINT32 m_AnchorLen;				// identified anchors between aligned probe and target must be at least this length
 
 	UINT32 m_UsedCells;				// number of currently allocated cells used
@@ -317,6 +349,9 @@ class CSSW
 	UINT64	NSBBitMsk(int Nth,UINT64 BitsSet);	// get bit mask of Nth (1 if MSB) significant bit set in BitsSet
 	int	NumBitsSet(UINT64 BitsSet);				// get total number of bits set in BitsSet
 
+	size_t m_AllocdStripedSize;		// total current allocation size for m_pStripedBuff
+	UINT8 *m_pStripedBuff;			// allocated to hold the striped score only pass profiles and row vectors
+
 	tsMAlignCol *								// inserted column or NULL if errors inserting
 		InsertCol(UINT32 PrevCol);				// allocate and insert new column after PrevCol
 
@@ -342,6 +377,11 @@ public:
 
 	bool SetMinNumExactMatches(int MinNumExactMatches = cMinNumExactMatches);		// require at least this many exactly matching in path to further process that path
 	bool SetTopNPeakMatches(int MaxTopNPeakMatches = cMaxTopNPeakMatches/2);		// can process for at most this many peak matches in any probe vs target SW alignment
+	bool SetStripedScore(bool bStripedScore = true,		// narrow alignments with a striped score only pass, false to disable (used when benchmarking)
+						 bool bBanded = false);			// also narrow banded alignments, these are usually already narrowed by X-drop path termination
+	bool GetStripedPeak(INT32 *pPeakScore,					// returned striped pass peak score, bounds the peak score of any path in the last Align()
+						UINT32 *pPeakPOfs = NULL,			// peak scoring cell is at this probe offset (1..n), 0 if no cell could score
+						UINT32 *pPeakTOfs = NULL);			// peak scoring cell is at this target offset (1..n), 0 if no cell could score
 
 	int GetTopNPeakMatches(tsSSWCell **pPeakMatches = NULL);		// returns number of peak matches in any probe vs target SW alignment
 
@@ -378,6 +418,19 @@ public:
 						UINT32 m_ProbeRelLen = 0,	// and SW with this probe relative length starting from m_ProbeStartRelOfs - if 0 then until end of probe sequence
 						UINT32 m_TargRelLen = 0);	// and SW with this target relative length starting from m_TargStartRelOfs - if 0 then until end of target sequence
 
+	int SetAlignBand(INT32 BandMinDiag,			// only align cells within band of diagonals (relative target offset - relative probe offset) starting from this diagonal
+					 INT32 BandMaxDiag,			// through to this diagonal inclusive
+					 int XDropScore);			// terminating paths if their score drops by more than this below the peak path score
+
+	UINT64 AlignCells(void);						// number of cells Align() would process over the current alignment range and band
+
+	int												// eBSFSuccess, eBSFerrNumRange if scores would overflow 16bit lanes, eBSFErrBase if unexpected probe base, eBSFerrMaxEntries if abandoned, eBSFerrInternal if no SIMD support 
+		StripedScore(INT32 *pPeakScore,				// returned peak score, 0 if no cell could score
+					 UINT32 *pPeakPOfs,				// peak scoring cell is at this probe relative offset
+					 UINT32 *pPeakTOfs,				// peak scoring cell is at this target relative offset
+					 UINT32 *pLastLivePOfs,			// no cell past this probe relative offset is able to score
+					 UINT32 *pLastLiveTOfs);		// no cell past this target relative offset is able to score
+
 	tsSSWCell *										// smith-waterman style local alignment, returns highest accumulated exact matches scoring cell
 				Align(tsSSWCell *pPeakScoreCell = NULL,	// optionally also return conventional peak scoring cell
 						UINT32 MaxOverlapLen = 0);		// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
@@ -457,6 +510,9 @@ public:
 						UINT32 MaxArtefactDev,		// classify overlaps as artefactual if sliding window of 500bp over any overlap deviates by more than this percentage from the overlap mean
 						UINT32 MinOverlapLen,       // minimum accepted overlap length
 						UINT32 MaxOverlapLen,      // max expected overlap length
+						INT32 BandMinDiag,			// if BandMinDiag < BandMaxDiag then only aligning within band of diagonals (relative target offset - relative probe offset) from BandMinDiag
+						INT32 BandMaxDiag,			// through to BandMaxDiag
+						INT32 XDropScore,			// and banded alignment paths are terminated if their score drops by more than this below the peak path score
 						UINT8 *pRetProcPhase,			// processing phase completed
 						INT32 *pErrRslt,				// result returned by that processing phase
 						UINT8 *pRetClass,			// returned overlap classification
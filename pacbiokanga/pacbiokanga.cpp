@@ -36,6 +36,7 @@ extern int ProcAssemb(int argc, char* argv[]);
 extern int ProcECContigs(int argc, char* argv[]);
 extern int ProcSWService(int argc, char* argv[]);
 extern int ProcKMerDist(int argc, char* argv[]);
+extern int ProcSWBench(int argc, char* argv[]);
 
 // inplace text cleaning; any leading/trailing or internal quote characters are removed; excessive whitespace is reduced to single
 char *
@@ -75,7 +76,8 @@ tsSubProcess SubProcesses[] = {
 	{"contigs","Assemb Contigs","Assemble error corrected PacBio reads into contigs",ProcAssemb},
 	{"eccontigs","Error Correct Contigs","Error correct assembled PacBio contigs",ProcECContigs},
 	{"swservice","SW Service","Distributed computing SW service provider",ProcSWService},
-	{"kmerdist","MAF K-mers","Generate exact matching K-mer distributions from MAF",ProcKMerDist}
+	{"kmerdist","MAF K-mers","Generate exact matching K-mer distributions from MAF",ProcKMerDist},
+	{"swbench","SW Benchmark","Benchmark SW alignment throughput on simulated PacBio reads",ProcSWBench}
 	};
 const int cNumSubProcesses = (sizeof(SubProcesses) / sizeof(tsSubProcess));
 
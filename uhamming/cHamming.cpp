@@ -13,6 +13,7 @@
 #include "../libbiokanga/commhdrs.h"
 #endif
 
+#include "cHamming.h"
 
 
 // lookup table for quick base complementation
@@ -333,3 +334,277 @@ while((SE1B = *pSE1++) < eBaseEOG)
 		PPEOScnt -= 1;
 	}
 }
+
+// Bit-parallel engine
+// Instead of sliding a single pair of subsequences per sweep, as GHamDistWatson/GHamDistCrick do, up to 64 sweeps are
+// processed together with each sweep in it's own bit lane. For each base in subsequence 1 a column word is generated
+// holding, in each lane, whether that base differs from the corresponding base in the lane's subsequence 2. Column words are
+// generated with a few XORs over the bit planes and the per lane Hammings are held as bit sliced counters so that sliding
+// the window along is a column word add and subtract. The minimum over all lanes is then extracted from the bit slices.
+
+int
+PackSeq(tsPackedSeq *pPacked,	// initialise this packed sequence
+		UINT8 *pSeq,			// from this sequence
+		UINT32 SeqLen,			// containing this many bases
+		bool bRevCpl)			// true if sequence is to be reverse complemented as it is packed
+{
+UINT32 Idx;
+UINT32 NumEOS;
+UINT8 Base;
+UINT64 *pPlane0;
+UINT64 *pPlane1;
+UINT64 *pPlane2;
+UINT64 Bit;
+
+memset(pPacked,0,sizeof(tsPackedSeq));
+pPacked->Len = SeqLen;
+pPacked->NumWords = (SeqLen + 63) / 64;
+pPacked->AllocPlanes = (size_t)pPacked->NumWords * 3 * sizeof(UINT64);
+#ifdef _WIN32
+pPacked->pPlanes[0] = (UINT64 *)malloc(pPacked->AllocPlanes);
+if(pPacked->pPlanes[0] == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"PackSeq: Memory allocation of %lld bytes failed",(INT64)pPacked->AllocPlanes);
+	return(eBSFerrMem);
+	}
+#else
+// gnu malloc is still in the 32bit world and can't handle more than 2GB allocations
+pPacked->pPlanes[0] = (UINT64 *)mmap(NULL,pPacked->AllocPlanes, PROT_READ |  PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS, -1,0);
+if(pPacked->pPlanes[0] == MAP_FAILED)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"PackSeq: Memory allocation of %lld bytes through mmap()  failed - %s",(INT64)pPacked->AllocPlanes,strerror(errno));
+	pPacked->pPlanes[0] = NULL;
+	return(eBSFerrMem);
+	}
+#endif
+memset(pPacked->pPlanes[0],0,pPacked->AllocPlanes);
+pPacked->pPlanes[1] = &pPacked->pPlanes[0][pPacked->NumWords];
+pPacked->pPlanes[2] = &pPacked->pPlanes[1][pPacked->NumWords];
+
+NumEOS = 0;
+for(Idx = 0; Idx < SeqLen; Idx++)
+	if(pSeq[Idx] == eBaseEOS)
+		NumEOS += 1;
+if(NumEOS > 0 && (pPacked->pEOSLoci = new UINT32 [NumEOS]) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"PackSeq: Memory allocation for %u EOS loci failed",NumEOS);
+	FreePackedSeq(pPacked);
+	return(eBSFerrMem);
+	}
+
+pPlane0 = pPacked->pPlanes[0];
+pPlane1 = pPacked->pPlanes[1];
+pPlane2 = pPacked->pPlanes[2];
+for(Idx = 0; Idx < SeqLen; Idx++)
+	{
+	Base = bRevCpl ? MapCpl[pSeq[SeqLen - 1 - Idx] & 0x07] : pSeq[Idx] & 0x07;
+	Bit = (UINT64)1 << (Idx & 63);
+	if(Base & 0x01)
+		pPlane0[Idx >> 6] |= Bit;
+	if(Base & 0x02)
+		pPlane1[Idx >> 6] |= Bit;
+	if(Base & 0x04)
+		pPlane2[Idx >> 6] |= Bit;
+	if(Base == eBaseEOS)
+		pPacked->pEOSLoci[pPacked->NumEOS++] = Idx;
+	}
+return(eBSFSuccess);
+}
+
+void
+FreePackedSeq(tsPackedSeq *pPacked)
+{
+if(pPacked->pPlanes[0] != NULL)
+	{
+#ifdef _WIN32
+	free(pPacked->pPlanes[0]);
+#else
+	munmap(pPacked->pPlanes[0],pPacked->AllocPlanes);
+#endif
+	}
+if(pPacked->pEOSLoci != NULL)
+	delete[] pPacked->pEOSLoci;
+memset(pPacked,0,sizeof(tsPackedSeq));
+}
+
+UINT64
+ReverseLanes(UINT64 Lanes)	// returns lane mask with lane N moved to lane 63-N
+{
+Lanes = ((Lanes >> 1) & 0x5555555555555555ULL) | ((Lanes & 0x5555555555555555ULL) << 1);
+Lanes = ((Lanes >> 2) & 0x3333333333333333ULL) | ((Lanes & 0x3333333333333333ULL) << 2);
+Lanes = ((Lanes >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((Lanes & 0x0f0f0f0f0f0f0f0fULL) << 4);
+Lanes = ((Lanes >> 8) & 0x00ff00ff00ff00ffULL) | ((Lanes & 0x00ff00ff00ff00ffULL) << 8);
+Lanes = ((Lanes >> 16) & 0x0000ffff0000ffffULL) | ((Lanes & 0x0000ffff0000ffffULL) << 16);
+return((Lanes >> 32) | (Lanes << 32));
+}
+
+// returns the 64 bits starting at BitOfs, bits outside of the plane are returned as 0
+static inline UINT64
+PackedBits(UINT64 *pPlane,		// bit plane
+		   INT64 NumWords,		// number of words in plane
+		   INT64 BitOfs)		// starting at this bit, can be negative
+{
+INT64 WordIdx;
+int Shift;
+UINT64 Lo;
+UINT64 Hi;
+WordIdx = BitOfs >= 0 ? BitOfs / 64 : -((63 - BitOfs) / 64);
+Shift = (int)(BitOfs - (WordIdx * 64));
+Lo = (WordIdx >= 0 && WordIdx < NumWords) ? pPlane[WordIdx] : 0;
+if(Shift == 0)
+	return(Lo);
+WordIdx += 1;
+Hi = (WordIdx >= 0 && WordIdx < NumWords) ? pPlane[WordIdx] : 0;
+return((Lo >> Shift) | (Hi << (64 - Shift)));
+}
+
+// column word for base at Loci in pSeq1, lane N set if that base differs from base at Loci + Seq2Ofs + N in pSeq2
+static inline UINT64
+PackedColumn(tsPackedSeq *pSeq1,tsPackedSeq *pSeq2,INT64 Loci,INT64 Seq2Ofs)
+{
+UINT64 Col;
+UINT64 Seq1Bit;
+int Plane;
+Col = 0;
+for(Plane = 0; Plane < 3; Plane++)
+	{
+	Seq1Bit = (pSeq1->pPlanes[Plane][Loci >> 6] >> (Loci & 63)) & 0x01;
+	Col |= PackedBits(pSeq2->pPlanes[Plane],pSeq2->NumWords,Loci + Seq2Ofs) ^ ((UINT64)0 - Seq1Bit);
+	}
+return(Col);
+}
+
+// lane mask with lanes Lo..Hi inclusive set
+static inline UINT64
+LaneRange(int Lo,int Hi)
+{
+return(((~(UINT64)0) << Lo) & ((~(UINT64)0) >> (63 - Hi)));
+}
+
+// As with GHamDistWatson/GHamDistCrick only subsequences not containing any eBaseEOS have their minimum Hammings updated
+void
+GHamDistLanes(UINT16 *pHDs,		// where to return minimum Hamming differentials for each subsequence 1
+			int SubSeqLen,			// generate Hammings edit distances for subsequences of this length
+			tsPackedSeq *pSeq1,		// subsequences 1 from this packed sequence
+			tsPackedSeq *pSeq2,		// subsequences 2 from this packed sequence, must be same length as pSeq1
+			INT64 Seq2Ofs,			// lane N compares subsequence 1 starting at Loci with subsequence 2 starting at Loci + Seq2Ofs + N
+			UINT64 LaneMask,		// only process lanes with corresponding bit set
+			bool bRevHDs,			// false if minimum for subsequence 1 at Loci is at pHDs[Loci], true if at pHDs[NumSubSeqs - 1 - Loci]
+			UINT64 *pColumns)		// working buffer of SubSeqLen words
+{
+INT64 NumSubSeqs;
+INT64 FirstLoci;
+INT64 LastLoci;
+INT64 Loci;
+INT64 Seq2Loci;
+INT64 EOSLo;
+INT64 EOSHi;
+UINT32 EOS1Idx;
+UINT32 EOS2Idx;
+UINT32 Idx;
+int ColIdx;
+int NumSlices;
+int Slice;
+UINT64 Slices[16];	// bit sliced per lane Hamming counters, Slices[0] holds the least significant bit
+UINT64 Col;
+UINT64 Carry;
+UINT64 Valid;
+UINT64 Cand;
+UINT64 Zeros;
+UINT16 MinHD;
+UINT16 *pHD;
+
+NumSubSeqs = (INT64)pSeq1->Len - SubSeqLen + 1;
+if(NumSubSeqs < 1 || LaneMask == 0)
+	return;
+
+// only iterate over subsequence 1 loci at which at least one lane has subsequence 2 within the sequence
+FirstLoci = -Seq2Ofs - (cPackedLanes - 1);
+if(FirstLoci < 0)
+	FirstLoci = 0;
+LastLoci = NumSubSeqs - 1 - Seq2Ofs;
+if(LastLoci > NumSubSeqs - 1)
+	LastLoci = NumSubSeqs - 1;
+if(FirstLoci > LastLoci)
+	return;
+
+for(NumSlices = 1; (1 << NumSlices) <= SubSeqLen; NumSlices++);
+memset(Slices,0,sizeof(Slices));
+
+// initial Hammings for first subsequences
+for(Loci = FirstLoci; Loci < FirstLoci + SubSeqLen; Loci++)
+	{
+	Carry = pColumns[Loci - FirstLoci] = PackedColumn(pSeq1,pSeq2,Loci,Seq2Ofs);
+	for(Slice = 0; Carry && Slice < NumSlices; Slice++)
+		{
+		Col = Slices[Slice] & Carry;
+		Slices[Slice] ^= Carry;
+		Carry = Col;
+		}
+	}
+
+EOS1Idx = 0;
+EOS2Idx = 0;
+ColIdx = 0;
+for(Loci = FirstLoci; ; Loci++)
+	{
+	// skip if subsequence 1 contains an eBaseEOS
+	while(EOS1Idx < pSeq1->NumEOS && pSeq1->pEOSLoci[EOS1Idx] < Loci)
+		EOS1Idx += 1;
+	if(EOS1Idx == pSeq1->NumEOS || pSeq1->pEOSLoci[EOS1Idx] >= Loci + SubSeqLen)
+		{
+		// lanes with subsequence 2 within the sequence
+		Seq2Loci = Loci + Seq2Ofs;
+		Valid = LaneMask & LaneRange(Seq2Loci < 0 ? (int)-Seq2Loci : 0,
+									 NumSubSeqs - 1 - Seq2Loci > 63 ? 63 : (int)(NumSubSeqs - 1 - Seq2Loci));
+
+		// less lanes with subsequence 2 containing an eBaseEOS
+		while(EOS2Idx < pSeq2->NumEOS && pSeq2->pEOSLoci[EOS2Idx] < Seq2Loci)
+			EOS2Idx += 1;
+		for(Idx = EOS2Idx; Valid && Idx < pSeq2->NumEOS && pSeq2->pEOSLoci[Idx] < Seq2Loci + cPackedLanes - 1 + SubSeqLen; Idx++)
+			{
+			EOSLo = pSeq2->pEOSLoci[Idx] - SubSeqLen + 1 - Seq2Loci;
+			EOSHi = pSeq2->pEOSLoci[Idx] - Seq2Loci;
+			Valid &= ~LaneRange(EOSLo < 0 ? 0 : (int)EOSLo,EOSHi > 63 ? 63 : (int)EOSHi);
+			}
+
+		if(Valid)
+			{
+			// minimum over valid lanes, from most significant slice down keep lanes with a 0 bit if there are any
+			Cand = Valid;
+			MinHD = 0;
+			for(Slice = NumSlices - 1; Slice >= 0; Slice--)
+				{
+				if((Zeros = Cand & ~Slices[Slice]) != 0)
+					Cand = Zeros;
+				else
+					MinHD |= (UINT16)(1 << Slice);
+				}
+			pHD = bRevHDs ? &pHDs[NumSubSeqs - 1 - Loci] : &pHDs[Loci];
+			if(*pHD > MinHD)
+				*pHD = MinHD;
+			}
+		}
+
+	if(Loci == LastLoci)
+		break;
+
+	// slide window, subtract column leaving at 5' and add column entering at 3'
+	Carry = pColumns[ColIdx];
+	for(Slice = 0; Carry && Slice < NumSlices; Slice++)
+		{
+		Col = ~Slices[Slice] & Carry;
+		Slices[Slice] ^= Carry;
+		Carry = Col;
+		}
+	Carry = pColumns[ColIdx] = PackedColumn(pSeq1,pSeq2,Loci + SubSeqLen,Seq2Ofs);
+	for(Slice = 0; Carry && Slice < NumSlices; Slice++)
+		{
+		Col = Slices[Slice] & Carry;
+		Slices[Slice] ^= Carry;
+		Carry = Col;
+		}
+	if(++ColIdx == SubSeqLen)
+		ColIdx = 0;
+	}
+}
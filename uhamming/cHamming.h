@@ -0,0 +1,36 @@
+// cHamming.h : exhaustive Hamming edit distance kernels
+
+#pragma once
+
+// Bit-parallel engine sequence representation
+// Base codes (eBaseA..eBaseEOS) fit into 3 bits so sequences are packed as 3 bit planes of 64 bases per UINT64,
+// plane 0 holding bit 0 of each base code. Planes 0 and 1 alone are the 2-bit packed canonical bases, plane 2 is only set
+// for the non-canonical codes such as eBaseN and eBaseEOS so these compare exactly as in the byte per base kernels
+typedef struct TAG_sPackedSeq {
+	UINT32 Len;				// number of bases packed
+	UINT32 NumWords;		// number of UINT64 words in each bit plane
+	UINT64 *pPlanes[3];		// bit planes, pPlanes[1] and pPlanes[2] follow pPlanes[0] in the same allocation
+	size_t AllocPlanes;		// allocation size of bit planes
+	UINT32 NumEOS;			// number of eBaseEOS chromosome separators in sequence
+	UINT32 *pEOSLoci;		// ascending loci of each eBaseEOS
+} tsPackedSeq;
+
+const int cPackedLanes = 64;	// bit-parallel engine processes up to this many sweeps, one per bit lane, in each pass
+
+extern int PackSeq(tsPackedSeq *pPacked,	// initialise this packed sequence
+			UINT8 *pSeq,			// from this sequence
+			UINT32 SeqLen,			// containing this many bases
+			bool bRevCpl);			// true if sequence is to be reverse complemented as it is packed
+
+extern void FreePackedSeq(tsPackedSeq *pPacked);
+
+extern UINT64 ReverseLanes(UINT64 Lanes);	// returns lane mask with lane N moved to lane 63-N
+
+extern void GHamDistLanes(UINT16 *pHDs,	// where to return minimum Hamming differentials for each subsequence 1
+			int SubSeqLen,			// generate Hammings edit distances for subsequences of this length
+			tsPackedSeq *pSeq1,		// subsequences 1 from this packed sequence
+			tsPackedSeq *pSeq2,		// subsequences 2 from this packed sequence, must be same length as pSeq1
+			INT64 Seq2Ofs,			// lane N compares subsequence 1 starting at Loci with subsequence 2 starting at Loci + Seq2Ofs + N
+			UINT64 LaneMask,		// only process lanes with corresponding bit set
+			bool bRevHDs,			// false if minimum for subsequence 1 at Loci is at pHDs[Loci], true if at pHDs[NumSubSeqs - 1 - Loci]
+			UINT64 *pColumns);		// working buffer of SubSeqLen words
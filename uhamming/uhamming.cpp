@@ -16,6 +16,8 @@
 #include "../libbiokanga/commhdrs.h"
 #endif
 
+#include "cHamming.h"
+
 const char *cpszProgVer = "1.5.3";		// increment with each release
 
 const int cMinSeqLen = 10;				// minimum sequence length for Hamming distances
@@ -109,10 +111,18 @@ typedef enum TAG_eSensitivity {
 	eSensPlaceholder					// used to set the enumeration range
 } etSensitivity;
 
+// exhaustive Hamming processing engine
+typedef enum TAG_eHamEngine {
+	eHEPacked = 0,						// default is bit-parallel over packed sequences, up to cPackedLanes sweeps per pass
+	eHEBytes,							// original byte per base, single sweep per pass
+	eHEPlaceholder						// used to set the enumeration range
+} etHamEngine;
+
 
 int
 Process(etPMode PMode,			// processing mode
 		bool bWatsonOnly,		// true if watson strand only processing
+		etHamEngine HamEngine,	// exhaustive Hamming processing engine
 		etSensitivity Sensitivity, // restricted hamming processing sensitivity
 		etResFormat ResFormat,	// restricted Hamming output file format
 		int RHamm,			    // if > 0 then restricted hammings limit
@@ -204,6 +214,7 @@ int NumNodes;				// total number of nodes (N) if processing over multiple nodes
 int SampleN;				// sample every N sweep instances
 
 bool bWatsonOnly;			// true if watson only strand processing - Crick is rather slow...
+etHamEngine HamEngine;		// exhaustive Hamming processing engine
 int IntraInterBoth;	    // 0: hammings over both intra (same sequence as probe K-mer drawn from) and inter (different sequences to that from which probe K-mer drawn), 1: Intra only, 2: Inter only
 int CoreLen;				// core length to use when processing restricted maximal Hammings
 int RHamm;					// restricted hamming upper limit
@@ -225,6 +236,7 @@ struct arg_int *resformat = arg_int0("S","resformat","<int>",	"restricted Hamnin
 
 
 struct arg_lit  *crick = arg_lit0("c","strandcrick",            "process Crick in addition to Watson strand - Caution: very slow processing");
+struct arg_int *engine = arg_int0("e","engine","<int>",		    "exhaustive Hamming engine: 0 - bit-parallel packed sequences, 1 - original byte per base (default = 0)");
 
 struct arg_int  *intrainterboth = arg_int0("z","intrainterboth","<int>", "0: hammings over both intra (same sequence as probe K-mer drawn from) and inter (different sequences to that from which probe K-mer drawn), 1: Intra only, 2: Inter only (default 0)");
 
@@ -247,7 +259,7 @@ struct arg_int *threads = arg_int0("T","threads","<int>",		"number of processing
 struct arg_end *end = arg_end(20);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
-					pmode,sensitivity,rhamm,resformat,crick,intrainterboth,numnodes,node,sweepstart,sweepend,seqlen,sample,infile,inseqfile,outfile,threads,
+					pmode,sensitivity,rhamm,resformat,crick,engine,intrainterboth,numnodes,node,sweepstart,sweepend,seqlen,sample,infile,inseqfile,outfile,threads,
 					end};
 
 char **pAllArgs;
@@ -335,6 +347,7 @@ if (!argerrors)
 	Sensitivity = eSensDefault;
 	szInSeqFile[0] = '\0';
 	bWatsonOnly = true;
+	HamEngine = eHEPacked;
 
 	if(PMode <= ePMdist)
 		{
@@ -479,6 +492,13 @@ if (!argerrors)
 
 		if(crick->count > 0)
 			bWatsonOnly = false;
+
+		HamEngine = (etHamEngine)(engine->count ? engine->ival[0] : eHEPacked);
+		if(HamEngine < eHEPacked || HamEngine >= eHEPlaceholder)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Hamming engine '-e%d' specified outside of range %d..%d",HamEngine,eHEPacked,eHEPlaceholder-1);
+			exit(1);
+			}
 		}
 
 	szOutFile[0] = '\0';
@@ -560,6 +580,7 @@ if (!argerrors)
 		case ePMnode:
 		case ePMdist:
 			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Process %s",bWatsonOnly ? "Watson only strand" : "both Watson and Crick strands - Caution: very slow -");
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Hamming engine: %s",HamEngine == eHEPacked ? "bit-parallel packed sequences" : "original byte per base");
 			if(SampleN > 1)
 				gDiagnostics.DiagOutMsgOnly(eDLInfo,"Only sample (process) every %d sweep",SampleN);
 			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Process k-mer subsequences of this length: %d",SeqLen);
@@ -637,7 +658,7 @@ if (!argerrors)
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
-	Rslt = Process(PMode,bWatsonOnly,Sensitivity,ResFormat,RHamm,(UINT32)SweepStart,(UINT32)SweepEnd,SeqLen,SampleN,IntraInterBoth,NumThreads,szInFile,szInSeqFile,szOutFile);
+	Rslt = Process(PMode,bWatsonOnly,HamEngine,Sensitivity,ResFormat,RHamm,(UINT32)SweepStart,(UINT32)SweepEnd,SeqLen,SampleN,IntraInterBoth,NumThreads,szInFile,szInSeqFile,szOutFile);
 	gStopWatch.Stop();
 	Rslt = Rslt >=0 ? 0 : 1;
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Exit code: %d Total processing time: %s",Rslt,gStopWatch.Read());
@@ -708,6 +729,9 @@ int m_RHamm;						// if > 0 then restricted hammings limit
 int m_SampleN;						// sample (process) every N sweep instance (or if restricted Hammings then every Nth K-mer) 
 int m_KMerLen;						// Hammings for these K-mer length sequences
 bool m_bWatsonOnly;					// true if watson strand only processing
+etHamEngine m_HamEngine;			// exhaustive Hamming processing engine
+tsPackedSeq m_PackedGenome;			// if bit-parallel engine then genome as packed sequence
+tsPackedSeq m_PackedRevCplGenome;	// if bit-parallel engine then reverse complement of genome as packed sequence
 UINT8 *m_pRHammings;				// to hold restricted hammings
 size_t m_TotAllocHammings;			// memory allocation size for holding restricted hammings
 
@@ -816,6 +840,9 @@ if(m_pAllocsIdentNodes != NULL)
 	m_pAllocsIdentNodes = NULL;
 	}
 
+FreePackedSeq(&m_PackedGenome);
+FreePackedSeq(&m_PackedRevCplGenome);
+
 m_TotAllocHammings = 0;
 m_AllocGenomeSeq = 0;
 m_AllocHamDist = 0;
@@ -848,11 +875,97 @@ m_pGenomeSeq = NULL;
 m_pHamDist = NULL;
 m_pThreadParams = NULL;
 m_pAllocsIdentNodes = NULL;
+memset(&m_PackedGenome,0,sizeof(m_PackedGenome));
+memset(&m_PackedRevCplGenome,0,sizeof(m_PackedRevCplGenome));
 m_TotAllocdIdentNodes = 0;
 m_PerThreadAllocdIdentNodes = 0;
 Reset(false);
 }
 
+// bit-parallel engine processing of a thread parameter set
+// sweeps are processed in blocks of cPackedLanes, sweep Seq0 + N in lane N, so each block is the same set of comparisons
+// as GHamDistWatson/GHamDistCrick would make over those sweeps with the minimum Hammings written to the same thread slice
+// Note: expects pParams->SeqDelta to be 1
+UINT32											// returns next sweep after last processed
+GHamDistPacked(tsThreadParams *pParams,			// thread processing parameters
+			   UINT64 *pColumns)				// working buffer of m_SubSeqLen words
+{
+UINT16 *pHDs;
+UINT32 Seq;
+UINT32 Seq0;
+UINT32 Idx;
+UINT32 Lane;
+UINT64 WLanes;
+UINT64 CLanes;
+INT64 Crick0;
+INT64 NumSubSeqs;
+bool bGenomeEnd;
+double PercentComplete;
+
+pHDs = &m_pHamDist[pParams->HamDistOfs];
+NumSubSeqs = (INT64)m_GenomeLen - 2 - m_SubSeqLen + 1;
+Seq = pParams->SSofs;
+bGenomeEnd = false;
+for(Idx = 0; !bGenomeEnd && Idx < pParams->NumSeqs; Idx += cPackedLanes)
+	{
+	// lanes for which the sweep would have been processed by GHamDistWatson and GHamDistCrick respectively
+	Seq0 = pParams->SSofs + Idx;
+	WLanes = 0;
+	CLanes = 0;
+	for(Lane = 0; Lane < cPackedLanes && (Idx + Lane) < pParams->NumSeqs; Lane++)
+		{
+		Seq = Seq0 + Lane;
+		if((Seq + m_SubSeqLen) >= m_GenomeLen)
+			{
+			bGenomeEnd = true;
+			break;
+			}
+		if(pParams->SampleN > 1 && (Idx + Lane) > 0 && ((Idx + Lane) % pParams->SampleN))
+			continue;
+		if((Seq + m_SubSeqLen) < m_GenomeLen-1)
+			WLanes |= (UINT64)1 << Lane;
+		if(!pParams->bWatsonOnly)
+			CLanes |= (UINT64)1 << Lane;
+		}
+	Seq = Seq0 + Lane;
+	if(WLanes == 0 && CLanes == 0)
+		continue;
+
+	PercentComplete = (double)((UINT64)Idx*100)/pParams->NumSeqs;
+#ifdef _WIN32
+	WaitForSingleObject(m_hMtxThreadParams,INFINITE);
+#else
+	pthread_mutex_lock(&m_hMtxThreadParams);
+#endif
+	if(PercentComplete > m_PercentComplete)
+		m_PercentComplete = PercentComplete;
+#ifdef _WIN32
+	ReleaseMutex(m_hMtxThreadParams);
+#else
+	pthread_mutex_unlock(&m_hMtxThreadParams);
+#endif
+
+	if(WLanes)
+		{
+		// minimums for subsequence 1, then for subsequence 2 by swapping roles with lanes in reverse order
+		GHamDistLanes(pHDs,m_SubSeqLen,&m_PackedGenome,&m_PackedGenome,Seq0,WLanes,false,pColumns);
+		GHamDistLanes(pHDs,m_SubSeqLen,&m_PackedGenome,&m_PackedGenome,-((INT64)Seq0 + cPackedLanes - 1),ReverseLanes(WLanes),false,pColumns);
+		}
+
+	if(CLanes)
+		{
+		// GHamDistCrick compares plus strand subsequences with minus strand subsequences at offset Seq-1, then in a second
+		// phase wraps around to the end of the minus strand
+		Crick0 = (INT64)Seq0 - 1;
+		GHamDistLanes(pHDs,m_SubSeqLen,&m_PackedGenome,&m_PackedRevCplGenome,Crick0,CLanes,false,pColumns);
+		GHamDistLanes(pHDs,m_SubSeqLen,&m_PackedGenome,&m_PackedRevCplGenome,Crick0 - NumSubSeqs,CLanes,false,pColumns);
+		GHamDistLanes(pHDs,m_SubSeqLen,&m_PackedRevCplGenome,&m_PackedGenome,-(Crick0 + cPackedLanes - 1),ReverseLanes(CLanes),true,pColumns);
+		GHamDistLanes(pHDs,m_SubSeqLen,&m_PackedRevCplGenome,&m_PackedGenome,NumSubSeqs - Crick0 - (cPackedLanes - 1),ReverseLanes(CLanes),true,pColumns);
+		}
+	}
+return(Seq);
+}
+
 #ifdef _WIN32
 unsigned __stdcall ThreadedGHamDist(void * pThreadPars)
 #else
@@ -866,8 +979,29 @@ tsThreadParams *pParams;
 UINT32 Seq;
 UINT32 Idx;
 double PercentComplete;
+UINT64 *pColumns = NULL;
+if(m_HamEngine == eHEPacked)
+	{
+	if((pColumns = new UINT64 [m_SubSeqLen]) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ThreadedGHamDist: Memory allocation of %lld bytes for packed columns failed",(INT64)m_SubSeqLen * sizeof(UINT64));
+		pPars->Rslt = eBSFerrMem;
+#ifdef _WIN32
+		_endthreadex(0);
+		return(eBSFerrMem);
+#else
+		pthread_exit(NULL);
+#endif
+		}
+	}
 while((pParams = ThreadedIterParams())!=NULL)
 	{
+	if(pColumns != NULL)
+		{
+		Seq = GHamDistPacked(pParams,pColumns);
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Thread %d processing subsequence %d completed",pParams->ThreadID,Seq-1);
+		continue;
+		}
 	for(Seq = pParams->SSofs, Idx = 0; Idx < pParams->NumSeqs; Idx++, Seq+=pParams->SeqDelta)
 		{
 		if((Seq + m_SubSeqLen) >= m_GenomeLen)
@@ -903,6 +1037,8 @@ while((pParams = ThreadedIterParams())!=NULL)
 		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Thread %d processing subsequence %d completed",pParams->ThreadID,Seq-1);
 	}
+if(pColumns != NULL)
+	delete[] pColumns;
 
 #ifdef _WIN32
 _endthreadex(0);
@@ -2094,6 +2230,15 @@ if((Rslt=m_pSfxArray->SetTargBlock(CurBlockID))<0)
 
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Genome assembly suffix array loaded");
 
+// sampled suffix arrays only index every Nth loci, hammings are located from exactly matching k-mer segments so these segments must be at least that long
+if(m_pSfxArray->GetSfxSampleRate() > 1 && (KMerLen / (RHamm + 1)) < m_pSfxArray->GetSfxSampleRate())
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Fatal: suffix array retains only every %d loci, k-mer length %d with hamming limit %d needs an index sampled at no more than every %d loci",
+						m_pSfxArray->GetSfxSampleRate(),KMerLen,RHamm,KMerLen / (RHamm + 1));
+	Reset(false);
+	return(eBSFerrParams);
+	}
+
 if(pszInSeqFile != NULL && pszInSeqFile[0] != '\0')
 	bProcSepKMers = true;
 else
@@ -2497,6 +2642,7 @@ return(0);
 int
 Process(etPMode PMode,			// processing mode
 		bool bWatsonOnly,		// true if watson strand only processing
+		etHamEngine HamEngine,	// exhaustive Hamming processing engine
 		etSensitivity Sensitivity, // restricted hamming processing sensitivity
 		etResFormat ResFormat,	// restricted Hamming output file format
 		int RHamm,			    // if > 0 then restricted hammings limit
@@ -2533,6 +2679,7 @@ m_SubSeqLen = SeqLen;
 m_NumProcThreads = NumThreads;
 m_KMerLen = SeqLen;
 m_bWatsonOnly = bWatsonOnly;
+m_HamEngine = HamEngine;
 m_RHamm = RHamm;
 m_Sensitivity = Sensitivity;
 m_SampleN = SampleN;
@@ -2634,6 +2781,18 @@ if(pszHammingFile != NULL && pszHammingFile[0] != '\0')
 	m_hOutFile = -1;
 	}
 
+if(HamEngine == eHEPacked)
+	{
+	// no packed sequence for initial/final eBaseEOG markers
+	if((Rslt = PackSeq(&m_PackedGenome,&m_pGenomeSeq[1],m_GenomeLen-2,false)) != eBSFSuccess ||
+		(!bWatsonOnly && (Rslt = PackSeq(&m_PackedRevCplGenome,&m_pGenomeSeq[1],m_GenomeLen-2,true)) != eBSFSuccess))
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to pack genome for bit-parallel Hamming engine");
+		Reset(false);
+		return(Rslt);
+		}
+	}
+
 m_PercentComplete = 0.0;
 tsThreadParams *pThreadParam;
 UINT32 BeginSeq;
@@ -2741,6 +2900,14 @@ pthread_mutex_destroy(&m_hMtxThreadParams);
 #endif
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: %1.2f%% completed",m_PercentComplete);
 
+for(ThreadIdx = 0; ThreadIdx < m_NumProcThreads; ThreadIdx++)
+	if(WorkerThreads[ThreadIdx].Rslt < 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Hamming edit distance processing thread %d failed",ThreadIdx+1);
+		Reset(false);
+		return(WorkerThreads[ThreadIdx].Rslt);
+		}
+
 // now merge the Hammings
 
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Merging Hamming edit distances...");